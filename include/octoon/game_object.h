@@ -88,6 +88,7 @@ namespace octoon
 
 	private:
 		friend class GameObjectManager;
+		friend class GameSceneFile;
 		friend class TransformComponent;
 
 		void onActivate() except;
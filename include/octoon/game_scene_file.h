@@ -0,0 +1,118 @@
+#ifndef OCTOON_GAME_SCENE_FILE_H_
+#define OCTOON_GAME_SCENE_FILE_H_
+
+#include <octoon/game_types.h>
+#include <octoon/io/istream.h>
+#include <octoon/io/ostream.h>
+#include <octoon/model/modtypes.h>
+
+#include <functional>
+#include <unordered_map>
+
+namespace octoon
+{
+	class OCTOON_EXPORT GameSceneWriter final
+	{
+	public:
+		using Encoder = std::function<void(GameSceneWriter& writer)>;
+
+	public:
+		GameSceneWriter() noexcept;
+		~GameSceneWriter() noexcept;
+
+		void write(const void* data, std::size_t size) noexcept;
+		void writeString(const std::string& str) noexcept;
+
+		template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
+		void write(const T& value) noexcept { this->write(&value, sizeof(T)); }
+
+		template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
+		void writeArray(const std::vector<T>& array) noexcept { this->write((std::uint32_t)array.size()); this->write(array.data(), array.size() * sizeof(T)); }
+
+		// Objects referenced by several components are encoded once, the key is usually their address.
+		void writeShared(const void* key, const Encoder& encoder) except;
+		void writeMesh(const model::MeshPtr& mesh) except;
+
+	private:
+		friend class GameSceneFile;
+
+		std::vector<std::uint8_t>* out_;
+		std::vector<std::vector<std::uint8_t>> blobs_;
+		std::unordered_map<const void*, std::uint32_t> shared_;
+	};
+
+	class OCTOON_EXPORT GameSceneReader final
+	{
+	public:
+		using Decoder = std::function<std::shared_ptr<void>(GameSceneReader& reader)>;
+
+		struct Blobs;
+
+	public:
+		GameSceneReader(const char* data, std::size_t size, std::uint32_t version, Blobs* blobs) noexcept;
+		~GameSceneReader() noexcept;
+
+		// The version the component writer had when the record was saved.
+		std::uint32_t version() const noexcept;
+
+		void read(void* data, std::size_t size) except;
+		std::string readString() except;
+
+		template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
+		T read() except { T value; this->read(&value, sizeof(T)); return value; }
+
+		template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
+		void readArray(std::vector<T>& array) except { array.resize(this->readCount(sizeof(T))); this->read(array.data(), array.size() * sizeof(T)); }
+
+		// Every record referencing the same shared object gets the same instance back.
+		std::shared_ptr<void> readShared(const Decoder& decoder) except;
+		model::MeshPtr readMesh() except;
+
+		template<typename T, typename Function>
+		std::shared_ptr<T> readShared(Function&& decoder) except { return std::static_pointer_cast<T>(this->readShared(Decoder([&](GameSceneReader& reader) -> std::shared_ptr<void> { return decoder(reader); }))); }
+
+	private:
+		// Checked against the bytes left before anything gets allocated for them.
+		std::size_t readCount(std::size_t elementSize) except;
+
+	private:
+		const char* data_;
+		const char* end_;
+
+		std::uint32_t version_;
+
+		Blobs* blobs_;
+	};
+
+	/*
+	* Binary scene format. Objects are stored flat in depth first order with the index of
+	* their parent, followed by their component records and the blobs shared between them.
+	* Loading builds the whole hierarchy while the objects are still inactive and activates
+	* them in one pass at the end, so nothing is moved or rendered before the scene is complete.
+	*
+	* Components are recorded by their RTTI name. Types without a registered writer and
+	* reader round-trip as default constructed instances, unknown names are skipped.
+	*/
+	class OCTOON_EXPORT GameSceneFile final
+	{
+	public:
+		using Writer = std::function<void(const GameComponent& component, GameSceneWriter& writer)>;
+		using Reader = std::function<void(GameComponent& component, GameSceneReader& reader)>;
+
+		static constexpr std::uint32_t Version = 1;
+
+	public:
+		static void registerComponent(const runtime::Rtti& type, std::uint32_t version, Writer&& writer, Reader&& reader) noexcept;
+		static void unregisterComponent(const runtime::Rtti& type) noexcept;
+
+		static void save(const GameScene& scene, io::ostream& stream) except;
+
+		static GameScenePtr load(io::istream& stream) except;
+		static GameScenePtr load(const char* data, std::size_t size) except;
+
+	private:
+		GameSceneFile() = delete;
+	};
+}
+
+#endif
@@ -100,6 +100,15 @@ namespace octoon
 			virtual bool map(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel, void** data) noexcept = 0;
 			virtual void unmap() noexcept = 0;
 
+			// Writes a region of a level from rows pitch bytes apart, the first row lands at y.
+			virtual bool update(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel, const void* data, std::uint32_t pitch) noexcept = 0;
+
+			// Copies a region into read buffer `slot` and returns without waiting for the GPU, mapping the
+			// slot waits for that copy only. Rows of the mapped region are pitch bytes apart, bottom row first.
+			virtual bool readBack(std::uint32_t slot, std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel) noexcept = 0;
+			virtual bool mapReadBack(std::uint32_t slot, void** data, std::uint32_t* pitch) noexcept = 0;
+			virtual void unmapReadBack(std::uint32_t slot) noexcept = 0;
+
 			virtual const GraphicsTextureDesc& getGraphicsTextureDesc() const noexcept = 0;
 
 		private:
@@ -0,0 +1,158 @@
+#ifndef OCTOON_IMAGE_ATLAS_H_
+#define OCTOON_IMAGE_ATLAS_H_
+
+#include <octoon/image/image.h>
+#include <octoon/math/vector4.h>
+
+#include <vector>
+#include <unordered_map>
+
+namespace octoon
+{
+	namespace image
+	{
+		enum class AtlasPacking : std::uint8_t
+		{
+			Skyline,
+			MaxRects,
+		};
+
+		struct AtlasRect
+		{
+			std::uint32_t x;
+			std::uint32_t y;
+			std::uint32_t width;
+			std::uint32_t height;
+		};
+
+		/*
+		* Places rectangles in a fixed area without overlaps. Skyline keeps the top edge of the packed
+		* area and puts every rectangle as low as it fits, which is fast and packs glyphs of similar
+		* heights well. Space it frees is only reused once the packer is reset. MaxRects keeps every
+		* maximal free rectangle and picks the one the new rectangle fits best, which packs mixed
+		* sizes tighter and reuses freed space at once, at a cost that grows with the free list.
+		*/
+		class OCTOON_EXPORT AtlasPacker final
+		{
+		public:
+			AtlasPacker(std::uint32_t width, std::uint32_t height, AtlasPacking packing = AtlasPacking::MaxRects) noexcept;
+			~AtlasPacker() noexcept;
+
+			void reset() noexcept;
+
+			bool insert(std::uint32_t width, std::uint32_t height, AtlasRect& rect) noexcept;
+			void remove(const AtlasRect& rect) noexcept;
+
+			std::uint32_t getWidth() const noexcept;
+			std::uint32_t getHeight() const noexcept;
+			AtlasPacking getPacking() const noexcept;
+
+			// Area of the rectangles placed and not removed.
+			std::uint64_t getUsedArea() const noexcept;
+
+		private:
+			struct Node
+			{
+				std::uint32_t x;
+				std::uint32_t y;
+				std::uint32_t width;
+			};
+
+			bool insertSkyline(std::uint32_t width, std::uint32_t height, AtlasRect& rect) noexcept;
+			bool insertMaxRects(std::uint32_t width, std::uint32_t height, AtlasRect& rect) noexcept;
+
+		private:
+			std::uint32_t width_;
+			std::uint32_t height_;
+			std::uint64_t used_;
+			AtlasPacking packing_;
+
+			std::vector<Node> skyline_;
+			std::vector<AtlasRect> free_;
+		};
+
+		/*
+		* Packs many small images into one, so that draws using any of them can share a texture.
+		* Entries are added and removed at any time and are known by an id that stays the same
+		* while they move. Every entry is surrounded by a gutter repeating its edge texels and is
+		* followed by padding texels that stay empty.
+		*
+		* Entries start on multiples of the largest power of two not above the gutter, so mips
+		* down to that level average texels of one entry only and filter into its gutter rather
+		* than into a neighbour. A gutter of 4 keeps levels 0 to 2 clean.
+		*
+		* Changes are collected as dirty rectangles for uploads of only the texels that changed.
+		* Defragmenting repacks every entry and moves their texels, the generation counts those
+		* moves so that texture coordinates taken earlier can be remapped.
+		*/
+		class OCTOON_EXPORT ImageAtlas final
+		{
+		public:
+			ImageAtlas(const Format& format, std::uint32_t width, std::uint32_t height, std::uint32_t padding = 1, std::uint32_t gutter = 1, AtlasPacking packing = AtlasPacking::MaxRects) except;
+			~ImageAtlas() noexcept;
+
+			// Returns the id of the new entry, 0 when there is no room for it.
+			std::uint32_t insert(const Image& image) except;
+			std::uint32_t insert(std::uint32_t width, std::uint32_t height, const void* pixels, std::size_t pitch) noexcept;
+
+			// With Skyline packing the texels of a removed entry are cleared but their space is
+			// not packed again until defragment().
+			bool remove(std::uint32_t id) noexcept;
+			bool contains(std::uint32_t id) const noexcept;
+
+			// Repacks the entries from the largest down, false and nothing moved when they no longer fit.
+			bool defragment() noexcept;
+
+			// Texels of an entry without its gutter, and its texture coordinates as u0, v0, u1, v1.
+			AtlasRect getRect(std::uint32_t id) const noexcept;
+			math::float4 getTexcoords(std::uint32_t id) const noexcept;
+
+			const std::vector<AtlasRect>& getDirtyRects() const noexcept;
+			void clearDirtyRects() noexcept;
+
+			const Image& getImage() const noexcept;
+			const Format& format() const noexcept;
+
+			std::uint32_t getPadding() const noexcept;
+			std::uint32_t getGutter() const noexcept;
+			std::uint32_t getGeneration() const noexcept;
+			std::size_t getCount() const noexcept;
+
+			// Texels covered by entries without their gutters and padding, against the whole image.
+			float getOccupancy() const noexcept;
+
+		private:
+			struct Entry
+			{
+				AtlasRect cell;
+				AtlasRect rect;
+			};
+
+			AtlasRect place(const AtlasRect& cell, std::uint32_t width, std::uint32_t height) const noexcept;
+			void write(const AtlasRect& rect, const void* pixels, std::size_t pitch) noexcept;
+			void clear(const AtlasRect& cell) noexcept;
+			void markDirty(AtlasRect rect) noexcept;
+
+		private:
+			ImageAtlas(const ImageAtlas&) = delete;
+			ImageAtlas& operator=(const ImageAtlas&) = delete;
+
+		private:
+			Image image_;
+
+			std::uint32_t padding_;
+			std::uint32_t gutter_;
+			std::uint32_t align_;
+			std::uint32_t generation_;
+			std::uint32_t nextId_;
+			std::uint64_t area_;
+
+			AtlasPacker packer_;
+
+			std::unordered_map<std::uint32_t, Entry> entries_;
+			std::vector<AtlasRect> dirty_;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef OCTOON_IMAGE_BATCH_H_
+#define OCTOON_IMAGE_BATCH_H_
+
+#include <octoon/image/image.h>
+#include <octoon/io/ori.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace octoon
+{
+	namespace runtime
+	{
+		class ThreadPool;
+	}
+
+	namespace image
+	{
+		/*
+		* Loads many images at once, reading, detecting and decoding every file on its own thread.
+		* Each worker takes the next file once it is done with one, so a few large files do not
+		* hold the small ones back, and keeps its mapping and stream from file to file. Files are
+		* mapped when they can be and read otherwise, the handler is picked by the extension and
+		* by the contents when that fails.
+		*
+		* The images come back in the order of the list, null for the ones that did not load.
+		*/
+		class OCTOON_EXPORT BatchLoader final
+		{
+		public:
+			// Threads taking part including the caller, 0 for the shared thread pool.
+			BatchLoader(std::size_t threads = 0) noexcept;
+			~BatchLoader() noexcept;
+
+			std::size_t getThreads() const noexcept;
+
+			std::vector<ImagePtr> load(const std::vector<std::string>& paths) const noexcept;
+			std::vector<ImagePtr> load(const std::vector<io::Orl>& orls) const noexcept;
+
+		private:
+			BatchLoader(const BatchLoader&) = delete;
+			BatchLoader& operator=(const BatchLoader&) = delete;
+
+		private:
+			std::unique_ptr<runtime::ThreadPool> pool_;
+		};
+	}
+}
+
+#endif
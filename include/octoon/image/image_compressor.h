@@ -0,0 +1,81 @@
+#ifndef OCTOON_IMAGE_COMPRESSOR_H_
+#define OCTOON_IMAGE_COMPRESSOR_H_
+
+#include <octoon/image/image.h>
+#include <octoon/image/image_mipmap.h>
+
+namespace octoon
+{
+	namespace image
+	{
+		enum class CompressQuality : std::uint8_t
+		{
+			Fast,
+			High,
+		};
+
+		/*
+		* Encodes images into the BC1 to BC7 block formats on the CPU. Sources of any uncompressed
+		* format are converted first, to 8 bit RGBA for BC1, BC2, BC3 and BC7 and to floats for BC4,
+		* BC5 and BC6H. Levels the source lacks are filtered from its top level, then the rows of
+		* blocks of every level and layer are spread over the thread pool. Edge blocks of sizes that
+		* are no multiple of 4 repeat the last row and column.
+		*
+		* Fast fits one line through the colors of a block and refines it once. High iterates the
+		* fit and searches the neighbouring endpoints, and on BC7 also tries the two subset mode
+		* on opaque blocks. BC6H is written in its single region mode only.
+		*/
+		class OCTOON_EXPORT BlockCompressor final
+		{
+		public:
+			BlockCompressor(CompressQuality quality = CompressQuality::Fast) noexcept;
+			~BlockCompressor() noexcept;
+
+			void setQuality(CompressQuality quality) noexcept;
+			CompressQuality getQuality() const noexcept;
+
+			void setMipmapFilter(MipmapFilter filter) noexcept;
+			MipmapFilter getMipmapFilter() const noexcept;
+
+			// Creates dst in a block format with the given number of levels, 0 for a full chain.
+			void compress(const Image& src, Image& dst, const Format& format, std::uint32_t levels = 0) const except;
+
+			static bool isSupported(const Format& format) noexcept;
+
+		private:
+			CompressQuality quality_;
+			MipmapFilter filter_;
+		};
+
+		/*
+		* Expands BC1 to BC7 images into any uncompressed format. Blocks decode to R8G8B8A8 for the
+		* color formats with sRGB kept, R16G16B16A16SFloat for BC6H and R32G32B32A32SFloat for BC4 and
+		* BC5, which hold every decoded value exactly. Other formats are converted from those a row of
+		* blocks at a time, while the rows of every level and layer are spread over the thread pool.
+		*
+		* BC1 to BC3 expand their palettes with SSSE3 shuffles and BC7 blends its endpoints with SSE2
+		* where the build allows, BC6H and the bit parsing of BC7 are scalar.
+		*/
+		class OCTOON_EXPORT BlockDecompressor final
+		{
+		public:
+			BlockDecompressor() noexcept;
+			~BlockDecompressor() noexcept;
+
+			// Disables the SIMD kernels, the results stay the same.
+			void setAccelerated(bool enable) noexcept;
+			bool getAccelerated() const noexcept;
+
+			static Format getDestFormat(const Format& format) noexcept;
+
+			// Creates dst with the size, mips and layers of src, in getDestFormat or the given format.
+			void decompress(const Image& src, Image& dst) const except;
+			void decompress(const Image& src, Image& dst, const Format& format) const except;
+
+		private:
+			bool accelerated_;
+		};
+	}
+}
+
+#endif
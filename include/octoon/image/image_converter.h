@@ -0,0 +1,77 @@
+#ifndef OCTOON_IMAGE_CONVERTER_H_
+#define OCTOON_IMAGE_CONVERTER_H_
+
+#include <octoon/image/image.h>
+
+namespace octoon
+{
+	namespace image
+	{
+		enum class AlphaMode : std::uint8_t
+		{
+			Straight,
+			Premultiply,
+			Unpremultiply,
+		};
+
+		/*
+		* Converts pixels between any two uncompressed formats, packed ones included. Values keep
+		* their meaning: normalized formats map to [0, 1] or [-1, 1], integer formats keep their
+		* numbers and sRGB colors are linearized on the way in and encoded on the way out. Missing
+		* colors read as 0 and missing alpha as 1, color goes to luminance formats as linear luma.
+		*
+		* Formats whose channels share a storage type are shuffled bytewise, everything else goes
+		* through floats in blocks that stay in the cache. Integers wider than 24 bits lose precision
+		* on that path. Images are split into chunks of pixels that run on the thread pool.
+		*/
+		class OCTOON_EXPORT FormatConverter final
+		{
+		public:
+			FormatConverter(const Format& src, const Format& dst, AlphaMode alpha = AlphaMode::Straight) except;
+			~FormatConverter() noexcept;
+
+			const Format& getSourceFormat() const noexcept;
+			const Format& getDestFormat() const noexcept;
+
+			AlphaMode getAlphaMode() const noexcept;
+
+			// Disables the SIMD kernels and the bytewise shuffles, the results stay the same.
+			void setAccelerated(bool enable) noexcept;
+			bool getAccelerated() const noexcept;
+
+			void convert(const void* src, void* dst, std::size_t pixels) const noexcept;
+
+			// Creates dst in the destination format with the size, mips and layers of src.
+			void convert(const Image& src, Image& dst) const except;
+
+			static bool isSupported(const Format& format) noexcept;
+
+		private:
+			void shuffle(const std::uint8_t* src, std::uint8_t* dst, std::size_t pixels) const noexcept;
+			void transform(const std::uint8_t* src, std::uint8_t* dst, std::size_t pixels) const noexcept;
+
+		private:
+			FormatConverter(const FormatConverter&) = delete;
+			FormatConverter& operator=(const FormatConverter&) = delete;
+
+		private:
+			Format src_;
+			Format dst_;
+			AlphaMode alpha_;
+
+			bool accelerated_;
+			bool compatible_;
+
+			std::unique_ptr<class PixelCodec> decoder_;
+			std::unique_ptr<class PixelCodec> encoder_;
+
+			// Source channel of every destination channel, or one of the constants below.
+			std::int8_t select_[4];
+
+			// Destination pixel with the constant channels filled in.
+			std::uint8_t constant_[32];
+		};
+	}
+}
+
+#endif
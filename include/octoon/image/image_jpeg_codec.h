@@ -0,0 +1,71 @@
+#ifndef OCTOON_IMAGE_JPEG_CODEC_H_
+#define OCTOON_IMAGE_JPEG_CODEC_H_
+
+#include <octoon/image/image.h>
+
+namespace octoon
+{
+	namespace image
+	{
+		/*
+		* Decodes JPEG files with the choices the loader leaves at their defaults. Scales of 2, 4 and
+		* 8 have the inverse DCT produce a half, quarter or eighth of the size directly, which costs
+		* a fraction of a full decode and suits thumbnails and small mips. The fast DCT trades a
+		* little accuracy for speed.
+		*
+		* Images come out as R8G8B8SRGB, or R8G8B8A8SRGB with opaque alpha when alpha is enabled. The
+		* alpha is added while the scanlines are read, so textures need no conversion afterwards.
+		*/
+		class OCTOON_EXPORT JPEGDecoder final
+		{
+		public:
+			JPEGDecoder() noexcept;
+			~JPEGDecoder() noexcept;
+
+			// 1, 2, 4 or 8, other values round down to one of them. Sizes round up.
+			void setScale(std::uint32_t denom) noexcept;
+			std::uint32_t getScale() const noexcept;
+
+			void setFastDCT(bool enable) noexcept;
+			bool getFastDCT() const noexcept;
+
+			void setAlpha(bool enable) noexcept;
+			bool getAlpha() const noexcept;
+
+			ImageReaderPtr open(istream& stream) const except;
+			void decode(istream& stream, Image& image) const except;
+
+		private:
+			std::uint32_t scale_;
+			bool fastDCT_;
+			bool alpha_;
+		};
+
+		/*
+		* Writes baseline JPEG files. Quality runs from 1 to 100, optimized coding builds the Huffman
+		* tables of each image in an extra pass, which makes files a few percent smaller.
+		*/
+		class OCTOON_EXPORT JPEGEncoder final
+		{
+		public:
+			JPEGEncoder(int quality = 90) noexcept;
+			~JPEGEncoder() noexcept;
+
+			void setQuality(int quality) noexcept;
+			int getQuality() const noexcept;
+
+			void setOptimizeCoding(bool enable) noexcept;
+			bool getOptimizeCoding() const noexcept;
+
+			// Gray, RGB or RGBA rows, alpha is dropped. Row i starts at pixels + i * stride.
+			void encode(ostream& stream, const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint8_t channels, std::ptrdiff_t stride) const except;
+			void encode(ostream& stream, const Image& image) const except;
+
+		private:
+			int quality_;
+			bool optimize_;
+		};
+	}
+}
+
+#endif
@@ -19,6 +19,9 @@ namespace octoon
 			virtual bool doLoad(istream& stream, Image& image) except = 0;
 			virtual bool doSave(ostream& stream, const Image& image) except = 0;
 
+			// Starts a decode that hands out bands of rows, null for types that can only load whole.
+			virtual ImageReaderPtr doOpen(istream&) except { return nullptr; }
+
 		private:
 			ImageLoader(const ImageLoader&) noexcept = delete;
 			const ImageLoader& operator=(const ImageLoader&) noexcept = delete;
@@ -0,0 +1,57 @@
+#ifndef OCTOON_IMAGE_MIPMAP_H_
+#define OCTOON_IMAGE_MIPMAP_H_
+
+#include <octoon/image/image.h>
+
+namespace octoon
+{
+	namespace image
+	{
+		enum class MipmapFilter : std::uint8_t
+		{
+			Box,
+			Kaiser,
+			Lanczos,
+		};
+
+		/*
+		* Builds mip chains on the CPU for every uncompressed, unpacked format. Each level is
+		* filtered from the one above it with a separable kernel, rows are spread over the thread
+		* pool. sRGB colors are filtered in linear space and alpha stays linear.
+		*
+		* With an alpha cutoff set, the alpha of every level is scaled so that the share of texels
+		* passing the cutoff matches the top level, which keeps alpha tested foliage from thinning
+		* out in the distance. Normal maps are renormalized after filtering, unsigned normalized
+		* formats are taken to store xyz * 0.5 + 0.5.
+		*/
+		class OCTOON_EXPORT MipmapGenerator final
+		{
+		public:
+			MipmapGenerator(MipmapFilter filter = MipmapFilter::Box) noexcept;
+			~MipmapGenerator() noexcept;
+
+			void setFilter(MipmapFilter filter) noexcept;
+			MipmapFilter getFilter() const noexcept;
+
+			// 0 disables coverage preservation.
+			void setAlphaCutoff(float cutoff) noexcept;
+			float getAlphaCutoff() const noexcept;
+
+			void setNormalMap(bool enable) noexcept;
+			bool getNormalMap() const noexcept;
+
+			// Overwrites levels 1 and up of every layer with the filtered level 0.
+			void generate(Image& image) const except;
+
+			// Creates dst with the top level of src and the given number of levels, 0 for a full chain.
+			void generate(const Image& src, Image& dst, std::uint32_t levels = 0) const except;
+
+		private:
+			MipmapFilter filter_;
+			float alphaCutoff_;
+			bool normalMap_;
+		};
+	}
+}
+
+#endif
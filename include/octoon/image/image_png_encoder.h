@@ -0,0 +1,43 @@
+#ifndef OCTOON_IMAGE_PNG_ENCODER_H_
+#define OCTOON_IMAGE_PNG_ENCODER_H_
+
+#include <octoon/image/image.h>
+
+namespace octoon
+{
+	namespace image
+	{
+		/*
+		* Writes 8 bit PNG files on several threads. The image is cut into horizontal strips
+		* that are filtered and deflated independently, the strips are flushed to byte
+		* boundaries so they join into one zlib stream, and their checksums are combined.
+		*
+		* Levels 1 to 3 use the up filter on every row, higher levels pick the filter of each
+		* row like libpng does. Level 0 stores the rows uncompressed.
+		*/
+		class OCTOON_EXPORT PNGEncoder final
+		{
+		public:
+			PNGEncoder(int level = 3) noexcept;
+			~PNGEncoder() noexcept;
+
+			void setLevel(int level) noexcept;
+			int getLevel() const noexcept;
+
+			// Smaller strips spread over more threads but compress a little worse, 0 picks about 256KB each.
+			void setStripHeight(std::uint32_t rows) noexcept;
+			std::uint32_t getStripHeight() const noexcept;
+
+			// Gray, gray alpha, RGB or RGBA rows. Row i starts at pixels + i * stride, so an image stored
+			// bottom-up is written upright by passing its last row and a negative stride.
+			void encode(ostream& stream, const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint8_t channels, std::ptrdiff_t stride) const except;
+			void encode(ostream& stream, const Image& image) const except;
+
+		private:
+			int level_;
+			std::uint32_t stripHeight_;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef OCTOON_IMAGE_READER_H_
+#define OCTOON_IMAGE_READER_H_
+
+#include <octoon/image/image_format.h>
+#include <octoon/image/image_types.h>
+
+namespace octoon
+{
+	namespace image
+	{
+		/*
+		* Decodes an image from top to bottom a band of rows at a time, into memory owned by the
+		* caller. Only the band and the state of the decoder are resident, so files too large to
+		* hold decoded can be filtered, converted or uploaded piece by piece, and the first rows are
+		* available long before the last ones are read.
+		*
+		* PNG, JPEG and HDR files stream. Interlaced PNGs need every pass before the first row is
+		* complete and are decoded whole on the first read. The stream has to stay open until the
+		* reader is destroyed.
+		*/
+		class OCTOON_EXPORT ImageReader
+		{
+		public:
+			ImageReader() noexcept = default;
+			virtual ~ImageReader() = default;
+
+			virtual const Format& format() const noexcept = 0;
+
+			virtual std::uint32_t width() const noexcept = 0;
+			virtual std::uint32_t height() const noexcept = 0;
+
+			// Index of the row the next read starts at.
+			virtual std::uint32_t row() const noexcept = 0;
+
+			// Decodes up to count rows, row i at data + i * pitch, and returns how many were decoded,
+			// 0 once the image is complete.
+			virtual std::uint32_t read(void* data, std::size_t pitch, std::uint32_t count) except = 0;
+
+			// Finds the handler by type or by the contents of the stream, null when it cannot stream.
+			static ImageReaderPtr open(istream& stream, const char* type = nullptr) noexcept;
+
+		private:
+			ImageReader(const ImageReader&) = delete;
+			ImageReader& operator=(const ImageReader&) = delete;
+		};
+	}
+}
+
+#endif
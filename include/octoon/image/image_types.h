@@ -54,6 +54,7 @@ namespace octoon
 
 		typedef std::shared_ptr<class Image> ImagePtr;
 		typedef std::shared_ptr<class ImageLoader> ImageLoaderPtr;
+		typedef std::shared_ptr<class ImageReader> ImageReaderPtr;
 
 		using istream = io::istream;
 		using ostream = io::ostream;
@@ -4,6 +4,7 @@
 #define OCTOON_IO_ARCHIVE_H_
 
 #include <memory>
+#include <vector>
 
 #include <octoon/io/ori.h>
 #include <octoon/io/istream.h>
@@ -62,6 +63,12 @@ namespace octoon
 			*   Type of file found via `orl`. `Unknown` if the item doesn't exist.
 			*/
 			virtual ItemType exists(const Orl& orl) = 0;
+
+			/*
+			* Test a batch of items at once, `types[i]` receives the type of `orls[i]`.
+			* Archives that cache lookups answer the whole batch under one lock.
+			*/
+			virtual void exists(const std::vector<Orl>& orls, std::vector<ItemType>& types);
 		};
 
 		using archive_pointer = std::shared_ptr<archive>;
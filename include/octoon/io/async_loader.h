@@ -0,0 +1,110 @@
+#ifndef OCTOON_IO_ASYNC_LOADER_H_
+#define OCTOON_IO_ASYNC_LOADER_H_
+
+#include <future>
+#include <thread>
+#include <vector>
+#include <functional>
+
+#include <octoon/io/ori.h>
+#include <octoon/io/istream.h>
+
+namespace octoon
+{
+	namespace io
+	{
+		enum class LoadPriority
+		{
+			High,
+			Normal,
+			Low
+		};
+
+		enum class LoadStatus
+		{
+			Pending,
+			Done,
+			Failed,
+			Cancelled
+		};
+
+		/*
+		* Loads resources of the `IoServer` in the background. Requests are read on a small
+		* pool of I/O threads, handed to a pool of decode threads and completed on the thread
+		* calling `dispatch()`, which is the game loop (`IOFeature::onFrameBegin`).
+		*
+		* Requests for the same ORL and decoder that are still in flight are coalesced into
+		* one job, each caller keeps its own ticket and callback. A job is dropped once every
+		* ticket attached to it has been cancelled.
+		*/
+		class OCTOON_EXPORT AsyncLoader final
+		{
+		public:
+			using Bytes = std::vector<std::uint8_t>;
+			using Decoder = std::function<std::shared_ptr<void>(istream& stream)>;
+			using Callback = std::function<void(const std::shared_ptr<void>& result)>;
+
+			struct Job;
+			struct Waiter;
+			struct Context;
+
+			class OCTOON_EXPORT Ticket final
+			{
+			public:
+				Ticket() noexcept;
+				Ticket(std::shared_ptr<Waiter>&& waiter) noexcept;
+
+				bool valid() const noexcept;
+
+				LoadStatus status() const noexcept;
+
+				// Detaches this ticket, its callback won't be called anymore.
+				void cancel() noexcept;
+
+				// Resolves to nullptr if the job failed or was cancelled.
+				std::shared_future<std::shared_ptr<void>> future() const noexcept;
+
+				template<typename T>
+				std::shared_ptr<T> get() const { return std::static_pointer_cast<T>(this->future().get()); }
+
+			private:
+				std::shared_ptr<Waiter> waiter_;
+			};
+
+		public:
+			// Zero decode threads uses one per core but the calling one.
+			AsyncLoader(std::size_t io_threads = 2, std::size_t decode_threads = 0) noexcept;
+			~AsyncLoader() noexcept;
+
+			// The tag tells decoders apart when coalescing, requests with the same ORL and tag share a job.
+			Ticket load(const Orl& orl, const char* tag, Decoder&& decoder, Callback&& callback = nullptr, LoadPriority priority = LoadPriority::Normal) noexcept;
+
+			// The result is a Bytes object holding the whole file.
+			Ticket load_bytes(const Orl& orl, Callback&& callback = nullptr, LoadPriority priority = LoadPriority::Normal) noexcept;
+
+			// A ticket that is already done, for results found elsewhere. The callback still runs on dispatch.
+			Ticket resolve(std::shared_ptr<void>&& result, Callback&& callback = nullptr) noexcept;
+
+			// Runs the callbacks of the jobs finished since the last call on the calling thread.
+			std::size_t dispatch() noexcept;
+
+			std::size_t pending() const noexcept;
+
+		private:
+			void io_run() noexcept;
+			void decode_run() noexcept;
+
+		private:
+			AsyncLoader(const AsyncLoader&) = delete;
+			AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+		private:
+			std::shared_ptr<Context> context_;
+
+			std::vector<std::thread> io_threads_;
+			std::vector<std::thread> decode_threads_;
+		};
+	}
+}
+
+#endif
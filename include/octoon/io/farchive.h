@@ -6,12 +6,21 @@
 #include <octoon/io/istream.h>
 #include <octoon/io/ioserver.h>
 
+#if defined(__linux)
+#	include <mutex>
+#	include <unordered_map>
+#endif
+
 namespace octoon
 {
 	namespace io
 	{
 		/*
 		* Local directory mapped directly to a virtual directory.
+		*
+		* On Linux the archive keeps a descriptor of its base directory and resolves every
+		* item relative to it with the *at() family, lookups are cached and the cache is
+		* kept coherent through inotify watches on the directories it has seen.
 		*/
 		class OCTOON_EXPORT farchive final : public archive
 		{
@@ -19,16 +28,42 @@ namespace octoon
 			farchive(const char* base_dir) noexcept;
 			farchive(std::string&& base_dir) noexcept;
 			farchive(const std::string& base_dir) noexcept;
-			~farchive() noexcept = default;
+			~farchive() noexcept;
 
 			std::unique_ptr<stream_buf> open(const Orl& orl, const ios_base::open_mode mode) override;
 
 			bool remove(const Orl& orl, ItemType type = ItemType::File) override;
 			ItemType exists(const Orl& orl) override;
+			void exists(const std::vector<Orl>& orls, std::vector<ItemType>& types) override;
 
 		private:
 			std::string make_path(const Orl& orl) const;
+
+#if defined(__linux)
+			void on_open() noexcept;
+
+			ItemType lookup(const std::string& path);
+			bool watch(const std::string& dir) noexcept;
+			void invalidate(const std::string& path, bool recursive = false) noexcept;
+			void drain() noexcept;
+#endif
+
+		private:
+			farchive(const farchive&) = delete;
+			farchive& operator=(const farchive&) = delete;
+
+		private:
 			std::string base_dir_;
+
+#if defined(__linux)
+			int dir_fd_;
+			int notify_fd_;
+
+			std::mutex mutex_;
+			std::unordered_map<std::string, ItemType> cache_;
+			std::unordered_map<int, std::string> watches_;
+			std::unordered_map<std::string, int> watched_;
+#endif
 		};
 
 		using LocalDirPtr = std::shared_ptr<farchive>;
@@ -35,6 +35,9 @@ namespace octoon
 			streamsize read(void* buf, streamsize size) noexcept;
 			streamsize write(const void* buf, streamsize size) noexcept;
 
+			// Reads at an absolute offset, leaving the file position untouched.
+			streamsize read_at(streamoff pos, void* buf, streamsize size) noexcept;
+
 			int flag() noexcept;
 			char* ptr() noexcept;
 			char* base() noexcept;
@@ -4,12 +4,22 @@
 #include <octoon/io/stream_buf.h>
 #include <octoon/io/file.h>
 
+#include <vector>
+
 namespace octoon
 {
 	namespace io
 	{
+		/*
+		* File stream with a block buffer in front of the descriptor. Small reads are served
+		* from a block read ahead, small writes are coalesced until the block is full, and seeks
+		* that stay inside the buffered window don't touch the file at all.
+		*/
 		class filebuf final : public stream_buf
 		{
+		public:
+			static const std::size_t default_block_size = 65536;
+
 		public:
 			filebuf() noexcept;
 			~filebuf() noexcept;
@@ -23,6 +33,10 @@ namespace octoon
 
 			bool close() noexcept;
 
+			// A block size of zero disables buffering.
+			void set_block_size(std::size_t size) noexcept;
+			std::size_t get_block_size() const noexcept;
+
 			streamsize read(char* str, std::streamsize cnt) noexcept;
 			streamsize write(const char* str, std::streamsize cnt) noexcept;
 
@@ -31,10 +45,40 @@ namespace octoon
 
 			streamsize size() const noexcept;
 
+			const char* peek(std::streamsize cnt) noexcept;
+			const char* view(std::streamsize cnt) noexcept;
+
+			streamsize read_at(streamoff pos, char* str, std::streamsize cnt) noexcept;
+
 			int flush() noexcept;
 
+		private:
+			enum class state
+			{
+				none,
+				reading,
+				writing
+			};
+
+			void on_open(bool success, ios_base::openmode mode) noexcept;
+
+			bool flush_write() noexcept;
+			void discard_read() noexcept;
+
 		private:
 			File _file;
+
+			state _state;
+			bool _readonly;
+
+			std::size_t _block_size;
+			std::vector<char> _buffer;
+
+			streamoff _base; // file offset of _buffer[0]
+			std::size_t _length; // bytes read into or written to the buffer
+			std::size_t _cursor; // read position inside the buffer
+
+			mutable streamsize _size;
 		};
 	}
 }
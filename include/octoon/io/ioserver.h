@@ -4,8 +4,10 @@
 #define OCTOON_IO_SERVER_H_
 
 #include <map>
+#include <mutex>
 #include <memory>
 #include <string>
+#include <functional>
 
 #include <octoon/io/ori.h>
 #include <octoon/io/fstream.h>
@@ -19,11 +21,17 @@ namespace octoon
 		/*
 		* A `IoServer` is a namespace for Octoon instance to seek for resources in
 		* local storage, at remote host, or in compressed archive.
+		*
+		* The mount table may be changed on one thread while others resolve ORLs.
+		* Listeners are told about every virtual directory that is mounted or
+		* unmounted, so that whatever was loaded from it can be dropped.
 		*/
 		class OCTOON_EXPORT IoServer final
 		{
 			OctoonDeclareSingleton(IoServer)
 		public:
+			using listener = std::function<void(const std::string& vpath)>;
+
 			/*
 			* Register an entry to the IoServer, so that the file contained in that
 			* entry an be found.
@@ -36,8 +44,23 @@ namespace octoon
 
 			archive_pointer get_archive(const Orl& orl) const;
 
+			/*
+			* Listeners are called on the thread changing the mount table, after
+			* the change took effect.
+			*/
+			std::size_t add_listener(listener&& callback);
+			void remove_listener(std::size_t id);
+
 		private:
+			void notify(const std::string& vpath);
+
+		private:
+			mutable std::mutex mutex_;
 			std::map<std::string, std::shared_ptr<archive>> registry_;
+
+			std::mutex listener_mutex_;
+			std::size_t listener_id_ = 0;
+			std::map<std::size_t, listener> listeners_;
 		};
 
 		using IoServerPtr = std::shared_ptr<IoServer>;
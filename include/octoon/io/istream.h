@@ -16,6 +16,9 @@ namespace octoon
 			istream& read(char* str, std::streamsize cnt) noexcept;
 			istream& read(char* str, streamsize size, streamsize cnt) noexcept;
 
+			const char* peek(std::streamsize cnt) noexcept;
+			const char* view(std::streamsize cnt) noexcept;
+
 			istream& seekg(ios_base::off_type pos) noexcept;
 			istream& seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept;
 
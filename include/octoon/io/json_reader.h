@@ -6,12 +6,40 @@
 #include <octoon/io/text_reader.h>
 #include <octoon/io/stream_reader.h>
 #include <octoon/io/istream.h>
+#include <octoon/math/math.h>
 #include <octoon/runtime/json/json.hpp>
 
 namespace octoon
 {
     namespace io
     {
+		// Receives the events of JsonReader::parse, returning false from any of them stops parsing.
+		class OCTOON_EXPORT JsonHandler
+		{
+		public:
+			virtual ~JsonHandler() = default;
+
+			virtual bool onNull() { return true; }
+			virtual bool onBoolean(bool value) { return true; }
+			virtual bool onNumber(double value) { return true; }
+
+			// Characters are only valid during the call and aren't null terminated.
+			virtual bool onString(const char* value, std::size_t length) { return true; }
+			virtual bool onKey(const char* key, std::size_t length) { return true; }
+
+			virtual bool onStartObject() { return true; }
+			virtual bool onEndObject() { return true; }
+
+			virtual bool onStartArray() { return true; }
+			virtual bool onEndArray() { return true; }
+
+			// Asked after every onStartArray. If true, the array must hold arrays of two or three
+			// numbers, which are handed over in batches as float3 (a missing z is zero) instead of
+			// single events, followed by onEndArray.
+			virtual bool wantFloat3Array() { return false; }
+			virtual bool onFloat3Array(const math::float3* values, std::size_t count) { return true; }
+		};
+
         class OCTOON_EXPORT JsonReader : public StreamReader
         {
 		public:
@@ -20,6 +48,12 @@ namespace octoon
             JsonReader(istream &stream) noexcept;
 
             JsonObject readJson() except;
+
+			// Parses the stream in fixed size chunks without building a document. Returns false
+			// if the handler stopped it and throws on malformed input.
+			bool parse(JsonHandler& handler) except;
+
+			static bool parse(const char* data, std::size_t length, JsonHandler& handler) except;
         private:
 	        JsonReader(const JsonReader&) noexcept = delete;
 	        JsonReader& operator=(const JsonReader&) noexcept = delete;
@@ -27,4 +61,4 @@ namespace octoon
     }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,83 @@
+#ifndef OCTOON_IO_MAPBUF_H_
+#define OCTOON_IO_MAPBUF_H_
+
+#include <octoon/io/stream_buf.h>
+
+#include <string>
+
+namespace octoon
+{
+	namespace io
+	{
+		/*
+		* Read-only stream over a memory mapped file. The whole file is visible through data()
+		* and view(), so loaders can decode in place without an intermediate copy. Only regular
+		* files can be mapped, open() fails for anything else so callers can fall back to filebuf.
+		*/
+		class OCTOON_EXPORT mapbuf final : public stream_buf
+		{
+		public:
+			enum class advice
+			{
+				normal,
+				sequential,
+				random,
+				willneed
+			};
+
+		public:
+			mapbuf() noexcept;
+			~mapbuf() noexcept;
+
+			bool is_open() const noexcept;
+
+			bool open(const char* filename, advice hint = advice::normal) noexcept;
+			bool open(const wchar_t* filename, advice hint = advice::normal) noexcept;
+			bool open(const std::string& filename, advice hint = advice::normal) noexcept;
+			bool open(const std::wstring& filename, advice hint = advice::normal) noexcept;
+#if !defined(__WINDOWS__)
+			// Opens filename relative to the directory descriptor dirfd, see openat(2).
+			bool open(int dirfd, const char* filename, advice hint = advice::normal) noexcept;
+#endif
+
+			bool close() noexcept;
+
+			void advise(advice hint) noexcept;
+
+			const char* data() const noexcept;
+
+			streamsize read(char* str, std::streamsize cnt) noexcept;
+			streamsize write(const char* str, std::streamsize cnt) noexcept;
+
+			streamoff seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept;
+			streamoff tellg() noexcept;
+
+			streamsize size() const noexcept;
+
+			const char* peek(std::streamsize cnt) noexcept;
+			const char* view(std::streamsize cnt) noexcept;
+
+			streamsize read_at(streamoff pos, char* str, std::streamsize cnt) noexcept;
+
+			int flush() noexcept;
+
+		private:
+			bool map(void* handle, advice hint) noexcept;
+
+		private:
+			mapbuf(const mapbuf&) = delete;
+			mapbuf& operator=(const mapbuf&) = delete;
+
+		private:
+			const char* data_;
+			std::size_t size_;
+			std::size_t pos_;
+
+#if defined(__WINDOWS__)
+			void* mapping_;
+#endif
+		};
+	}
+}
+
+#endif
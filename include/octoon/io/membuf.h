@@ -1,7 +1,6 @@
 #ifndef OCTOON_IO_MEMBUF_H_
 #define OCTOON_IO_MEMBUF_H_
 
-#include <mutex>
 #include <vector>
 #include <octoon/io/stream_buf.h>
 
@@ -9,6 +8,11 @@ namespace octoon
 {
 	namespace io
 	{
+		/*
+		* Growable in-memory stream. The cursor functions are not synchronized, a buffer read by
+		* several threads at once should go through read_at(), which neither uses nor moves the
+		* cursor and takes no lock.
+		*/
 		class membuf final : public stream_buf
 		{
 		public:
@@ -34,11 +38,15 @@ namespace octoon
 
 			streamsize size() const noexcept;
 
+			const char* peek(std::streamsize cnt) noexcept;
+			const char* view(std::streamsize cnt) noexcept;
+
+			streamsize read_at(streamoff pos, char* str, std::streamsize cnt) noexcept;
+
 			int flush() noexcept;
 
 		private:
 			std::size_t pos_;
-			std::mutex lock_;
 			std::vector<std::uint8_t> buffer_;
 		};
 	}
@@ -0,0 +1,141 @@
+#ifndef OCTOON_IO_RESOURCE_CACHE_H_
+#define OCTOON_IO_RESOURCE_CACHE_H_
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <typeindex>
+#include <functional>
+#include <unordered_map>
+
+#include <octoon/io/ori.h>
+
+namespace octoon
+{
+	namespace io
+	{
+		/*
+		* Remembers decoded resources by type, ORL and load parameters, so that opening the
+		* same image or model twice hands out the same object. Handles are plain shared
+		* pointers, an entry is in use for as long as one of them is alive.
+		*
+		* Entries nobody holds anymore stay cached until the memory of all entries exceeds
+		* the budget, then the least recently used of them are dropped first. Entries of a
+		* virtual directory are forgotten when it is mounted or unmounted in `IoServer`.
+		*/
+		class OCTOON_EXPORT ResourceCache final
+		{
+		public:
+			using Loader = std::function<std::shared_ptr<void>(const Orl& orl, std::size_t& bytes)>;
+
+			struct Stats
+			{
+				std::size_t hits;
+				std::size_t misses;
+				std::size_t evictions;
+				std::size_t invalidations;
+
+				std::size_t count;
+				std::size_t bytes;
+			};
+
+		public:
+			ResourceCache(std::size_t budget = 256 << 20) noexcept;
+			~ResourceCache() noexcept;
+
+			void set_budget(std::size_t bytes) noexcept;
+			std::size_t get_budget() const noexcept;
+
+			// Params tell apart the results of different load options for the same file.
+			std::shared_ptr<void> get(const std::type_info& type, const Orl& orl, const char* params = nullptr) noexcept;
+
+			// The memory of an entry is whatever the loader reports, nothing is cached for nullptr.
+			std::shared_ptr<void> load(const std::type_info& type, const Orl& orl, const char* params, const Loader& loader);
+
+			void insert(const std::type_info& type, const Orl& orl, const char* params, const std::shared_ptr<void>& value, std::size_t bytes) noexcept;
+
+			void erase(const std::type_info& type, const Orl& orl, const char* params = nullptr) noexcept;
+
+			// Forgets every entry loaded from the virtual directory, handles out there stay valid.
+			void invalidate(const std::string& vpath) noexcept;
+			void clear() noexcept;
+
+			// Drops unused entries until the budget is met, called on every insertion.
+			void trim() noexcept;
+
+			std::size_t memory(const std::type_info& type) const noexcept;
+
+			Stats stats() const noexcept;
+			void reset_stats() noexcept;
+
+			template<typename T>
+			std::shared_ptr<T> get(const Orl& orl, const char* params = nullptr) noexcept
+			{
+				return std::static_pointer_cast<T>(this->get(typeid(T), orl, params));
+			}
+
+			// The loader is called as loader(orl, bytes) and returns a std::shared_ptr<T>.
+			template<typename T, typename Function>
+			std::shared_ptr<T> load(const Orl& orl, const char* params, Function&& loader)
+			{
+				return std::static_pointer_cast<T>(this->load(typeid(T), orl, params, [&](const Orl& it, std::size_t& bytes) -> std::shared_ptr<void> { return loader(it, bytes); }));
+			}
+
+			template<typename T>
+			void insert(const Orl& orl, const char* params, const std::shared_ptr<T>& value, std::size_t bytes) noexcept
+			{
+				this->insert(typeid(T), orl, params, std::static_pointer_cast<void>(value), bytes);
+			}
+
+			template<typename T>
+			void erase(const Orl& orl, const char* params = nullptr) noexcept
+			{
+				this->erase(typeid(T), orl, params);
+			}
+
+			template<typename T>
+			std::size_t memory() const noexcept
+			{
+				return this->memory(typeid(T));
+			}
+
+		private:
+			struct Entry
+			{
+				std::string key;
+				std::string vdir;
+				std::type_index type;
+
+				std::shared_ptr<void> value;
+				std::size_t bytes;
+			};
+
+			using Entries = std::list<Entry>;
+
+			static std::string make_key(const std::type_info& type, const Orl& orl, const char* params) noexcept;
+
+			void unlink(Entries::iterator it) noexcept;
+			void trim_unlocked() noexcept;
+
+		private:
+			ResourceCache(const ResourceCache&) = delete;
+			ResourceCache& operator=(const ResourceCache&) = delete;
+
+		private:
+			mutable std::mutex mutex_;
+
+			std::size_t budget_;
+			std::size_t bytes_;
+			std::size_t listener_;
+
+			// Most recently used first.
+			Entries lru_;
+			std::unordered_map<std::string, Entries::iterator> entries_;
+			std::unordered_map<std::type_index, std::size_t> memory_;
+
+			Stats stats_;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef OCTOON_IO_RINGBUF_H_
+#define OCTOON_IO_RINGBUF_H_
+
+#include <octoon/io/stream_buf.h>
+
+#include <atomic>
+#include <memory>
+
+namespace octoon
+{
+	namespace io
+	{
+		/*
+		* Lock-free single producer, single consumer pipe for streaming pipelines. One thread
+		* writes while another one reads, neither blocks: write() stores what fits and read()
+		* returns what is available. The producer calls finish() after its last write, the
+		* consumer sees eof() once everything before it has been read.
+		*/
+		class OCTOON_EXPORT ringbuf final : public stream_buf
+		{
+		public:
+			ringbuf() noexcept;
+			ringbuf(std::size_t capacity) noexcept;
+			~ringbuf() noexcept;
+
+			bool is_open() const noexcept;
+
+			// Capacity is rounded up to a power of two, neither side may be running.
+			void open(std::size_t capacity) noexcept;
+			bool close() noexcept;
+
+			std::size_t capacity() const noexcept;
+
+			void finish() noexcept;
+			bool eof() const noexcept;
+
+			streamsize read(char* str, std::streamsize cnt) noexcept;
+			streamsize write(const char* str, std::streamsize cnt) noexcept;
+
+			// The pipe can't be repositioned, tellg() counts the bytes consumed so far.
+			streamoff seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept;
+			streamoff tellg() noexcept;
+
+			// Bytes ready to be read.
+			streamsize size() const noexcept;
+
+			const char* peek(std::streamsize cnt) noexcept;
+			const char* view(std::streamsize cnt) noexcept;
+
+			int flush() noexcept;
+
+		private:
+			void release() noexcept;
+
+		private:
+			ringbuf(const ringbuf&) = delete;
+			ringbuf& operator=(const ringbuf&) = delete;
+
+		private:
+			std::unique_ptr<char[]> buffer_;
+			std::size_t mask_;
+
+			std::atomic<bool> finished_;
+
+			// Each side owns one counter and keeps a stale copy of the other one, so the shared
+			// cache line is only touched when the stale copy says the pipe is full or empty.
+			// C++14 operator new only guarantees alignof(std::max_align_t), so the sides are kept
+			// on separate cache lines by a full line of padding rather than by alignas(64).
+			char pad0_[64];
+			std::atomic<std::uint64_t> head_;
+			std::uint64_t tail_cache_;
+			std::size_t viewed_;
+
+			char pad1_[64];
+			std::atomic<std::uint64_t> tail_;
+			std::uint64_t head_cache_;
+
+			char pad2_[64];
+		};
+	}
+}
+
+#endif
@@ -7,12 +7,129 @@
 #include <map>
 #include <list>
 #include <memory>
-#include <variant>
+#include <vector>
+#include <string>
+#include <cstring>
 
 namespace octoon
 {
 	namespace io
 	{
+		class serialization_object;
+
+		// A non-owning view of a member key, compared by content.
+		class serialization_key final
+		{
+		public:
+			struct hash
+			{
+				std::size_t operator()(const serialization_key& key) const noexcept
+				{
+					std::size_t hash = 14695981039346656037ull;
+					for (std::size_t i = 0; i < key.size_; i++)
+						hash = (hash ^ static_cast<unsigned char>(key.data_[i])) * 1099511628211ull;
+					return hash;
+				}
+			};
+
+			serialization_key() noexcept : data_(nullptr), size_(0) {}
+			serialization_key(const char* data, std::size_t size) noexcept : data_(data), size_(size) {}
+			serialization_key(const char* str) noexcept : data_(str), size_(std::strlen(str)) {}
+			serialization_key(const std::string& str) noexcept : data_(str.data()), size_(str.size()) {}
+
+			const char* data() const noexcept { return data_; }
+			std::size_t size() const noexcept { return size_; }
+
+			std::string str() const { return std::string(data_, size_); }
+
+			friend bool operator==(const serialization_key& a, const serialization_key& b) noexcept
+			{
+				return a.size_ == b.size_ && (a.data_ == b.data_ || std::memcmp(a.data_, b.data_, a.size_) == 0);
+			}
+
+			friend bool operator!=(const serialization_key& a, const serialization_key& b) noexcept
+			{
+				return !(a == b);
+			}
+
+		private:
+			const char* data_;
+			std::size_t size_;
+		};
+
+		/*
+		* Owns the memory of a whole document: member storage of every object in it is
+		* carved out of a few large blocks, and all member keys are interned once, so a
+		* lookup compares pointers. Nothing is freed before the document goes away.
+		*/
+		class OCTOON_EXPORT serialization_document final : public std::enable_shared_from_this<serialization_document>
+		{
+		public:
+			serialization_document() noexcept;
+			~serialization_document() noexcept;
+
+			void* allocate(std::size_t size, std::size_t align);
+
+			serialization_key intern(const serialization_key& key);
+
+			// Returns a key without data if no object of this document has such a key.
+			serialization_key find(const serialization_key& key) const noexcept;
+
+			std::size_t memory_usage() const noexcept;
+
+		private:
+			serialization_document(const serialization_document&) = delete;
+			serialization_document& operator=(const serialization_document&) = delete;
+
+		private:
+			char* head_;
+			std::size_t left_;
+			std::size_t usage_;
+			std::size_t next_block_;
+
+			std::vector<std::unique_ptr<char[]>> blocks_;
+
+			// Open addressing over the interned keys, a power of two at most half full.
+			std::size_t count_;
+			std::vector<serialization_key> keys_;
+		};
+
+		template<typename T>
+		class serialization_allocator
+		{
+		public:
+			using value_type = T;
+
+			serialization_allocator(serialization_document* document) noexcept : document_(document) {}
+
+			template<typename U>
+			serialization_allocator(const serialization_allocator<U>& other) noexcept : document_(other.document()) {}
+
+			T* allocate(std::size_t n) { return static_cast<T*>(document_->allocate(n * sizeof(T), alignof(T))); }
+			void deallocate(T*, std::size_t) noexcept {}
+
+			serialization_document* document() const noexcept { return document_; }
+
+			template<typename U>
+			bool operator==(const serialization_allocator<U>& other) const noexcept { return document_ == other.document(); }
+
+			template<typename U>
+			bool operator!=(const serialization_allocator<U>& other) const noexcept { return document_ != other.document(); }
+
+		private:
+			serialization_document* document_;
+		};
+
+		class serialization_buf;
+
+		// Elements of an array, which keeps the document of the object it is a member of so
+		// that elements added through serialization_buf::operator[] join it as well.
+		class serialization_array final : public std::vector<serialization_buf>
+		{
+		public:
+			std::shared_ptr<serialization_document> document;
+		};
+
 		class OCTOON_EXPORT serialization_buf final
 		{
 		public:
@@ -25,24 +142,15 @@ namespace octoon
 			using number_float4_t = math::detail::Vector4<number_float_t>;
 			using number_quaternion_t = math::detail::Quaternion<number_float_t>;
 			using string_t = std::string;
-			using object_t = serialization_buf;;
-			using array_t = std::vector<serialization_buf>;
-			using map_t = std::list<std::pair<std::string, object_t>>;
-			using iterator = map_t::iterator;
-			using reverse_iterator = map_t::reverse_iterator;
-			using const_iterator = map_t::const_iterator;
-			using const_reverse_iterator = map_t::const_reverse_iterator;
-
-			using variant_t = std::variant<
-				void*,
-				boolean_t,
-				number_integer_t,
-				number_unsigned_t,
-				number_float_t,
-				std::unique_ptr<string_t>,
-				std::unique_ptr<array_t>,
-				std::unique_ptr<map_t>
-			>;
+			using object_t = serialization_buf;
+			using array_t = serialization_array;
+			using map_t = serialization_object;
+			using key_t = serialization_key;
+			using member_t = std::pair<key_t, object_t>;
+			using iterator = member_t*;
+			using reverse_iterator = std::reverse_iterator<iterator>;
+			using const_iterator = const member_t*;
+			using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
 			static const serialization_buf& nil;
 			static const serialization_buf& nilRef;
@@ -68,7 +176,7 @@ namespace octoon
 			serialization_buf(string_t&& value);
 			serialization_buf(const string_t& value);
 			serialization_buf(const string_t::value_type* value);
-			serialization_buf(serialization_buf&& value);
+			serialization_buf(serialization_buf&& value) noexcept;
 			~serialization_buf() noexcept;
 
 			serialization_buf& at(const string_t& key);
@@ -172,7 +280,7 @@ namespace octoon
 			serialization_buf& operator=(number_float_t value);
 			serialization_buf& operator=(string_t&& value);
 			serialization_buf& operator=(const string_t& value);
-			serialization_buf& operator=(serialization_buf&& value);
+			serialization_buf& operator=(serialization_buf&& value) noexcept;
 
 			serialization_buf& operator[](const char* key);
 			serialization_buf& operator[](const string_t& key);
@@ -397,44 +505,131 @@ namespace octoon
 			template<typename T, type_t type>
 			constexpr T get() const
 			{
-				switch (_data.index())
+				switch (_type)
 				{
 				case type_t::boolean:
-					return static_cast<T>(std::get<type_t::boolean>(_data));
+					return static_cast<T>(_value.boolean_value);
 				case type_t::number_integer:
-					return static_cast<T>(std::get<type_t::number_integer>(_data));
+					return static_cast<T>(_value.integer_value);
 				case type_t::number_unsigned:
-					return static_cast<T>(std::get<type_t::number_unsigned>(_data));
+					return static_cast<T>(_value.unsigned_value);
 				case type_t::number_float:
-					return static_cast<T>(std::get<type_t::number_float>(_data));
+					return static_cast<T>(_value.float_value);
 				default:
-					throw failure(string_t("type must be number, but is ") + this->type_name());
+					throw runtime::type_error::create(string_t("type must be number, but is ") + this->type_name());
 				}
 			}
 
+			template<type_t type>
+			using type_tag = std::integral_constant<type_t, type>;
+
+			boolean_t _value_of(type_tag<boolean>) const noexcept { return _value.boolean_value; }
+			number_integer_t _value_of(type_tag<number_integer>) const noexcept { return _value.integer_value; }
+			number_unsigned_t _value_of(type_tag<number_unsigned>) const noexcept { return _value.unsigned_value; }
+			string_t* _value_of(type_tag<string>) const noexcept { return _value.string_value; }
+			array_t* _value_of(type_tag<array>) const noexcept { return _value.array_value; }
+
 			template<type_t type, std::enable_if_t<type != object, int> = 0>
 			constexpr decltype(auto) _get() const
 			{
 				if (this->type() != type)
-					throw failure(string_t("type must be ") + type_name(type) + " but is " + this->type_name());
+					throw runtime::type_error::create(string_t("type must be ") + type_name(type) + " but is " + this->type_name());
 
-				return std::get<type>(_data);
+				return this->_value_of(type_tag<type>());
 			}
 
 			template<type_t type, std::enable_if_t<type == object, int> = 0>
 			constexpr object_t& _get() const
 			{
 				if (this->type() != type)
-					throw failure(string_t("type must be ") + type_name(type) + " but is " + this->type_name());
-				return std::get<type>(_data)->front().second;
+					throw runtime::type_error::create(string_t("type must be ") + type_name(type) + " but is " + this->type_name());
+				return this->_front();
 			}
 
+			object_t& _front() const;
+			serialization_object& _object();
+			void _adopt(serialization_document* document) noexcept;
+			void _destroy() noexcept;
+
 		private:
+			friend class serialization_object;
+
 			serialization_buf(const serialization_buf& value);
 			serialization_buf& operator=(const serialization_buf& value);
 
 		private:
-			variant_t _data;
+			type_t _type;
+
+			// A null member of an object keeps the document of that object, so it joins
+			// the same document if it becomes an object itself.
+			union
+			{
+				void* document;
+				boolean_t boolean_value;
+				number_integer_t integer_value;
+				number_unsigned_t unsigned_value;
+				number_float_t float_value;
+				string_t* string_value;
+				array_t* array_value;
+				map_t* object_value;
+			} _value;
+		};
+
+		/*
+		* Members of an object in insertion order. Small objects are searched linearly,
+		* larger ones get an open addressing index over the member keys once they are
+		* looked up.
+		*/
+		class OCTOON_EXPORT serialization_object final
+		{
+		public:
+			using member_t = serialization_buf::member_t;
+
+			// Objects with fewer members than this are searched linearly.
+			static constexpr std::size_t index_threshold = 8;
+
+			serialization_object(std::shared_ptr<serialization_document>&& document);
+			~serialization_object() noexcept;
+
+			member_t* find(const serialization_key& key) noexcept;
+			const member_t* find(const serialization_key& key) const noexcept;
+
+			// Appends without looking for the key first, the earlier member keeps winning.
+			member_t& append(const serialization_key& key, serialization_buf&& value);
+
+			serialization_buf& operator[](const serialization_key& key);
+
+			member_t* begin() noexcept { return members_.data(); }
+			member_t* end() noexcept { return members_.data() + members_.size(); }
+			const member_t* begin() const noexcept { return members_.data(); }
+			const member_t* end() const noexcept { return members_.data() + members_.size(); }
+
+			member_t& front() noexcept { return members_.front(); }
+			member_t& back() noexcept { return members_.back(); }
+			const member_t& front() const noexcept { return members_.front(); }
+			const member_t& back() const noexcept { return members_.back(); }
+
+			std::size_t size() const noexcept { return members_.size(); }
+
+			serialization_document* document() const noexcept { return document_.get(); }
+
+		private:
+			void reindex() const;
+			void insert_index(std::uint32_t n) const noexcept;
+
+		private:
+			serialization_object(const serialization_object&) = delete;
+			serialization_object& operator=(const serialization_object&) = delete;
+
+		private:
+			// Declared first so that it outlives the storage it hands out.
+			std::shared_ptr<serialization_document> document_;
+
+			std::vector<member_t, serialization_allocator<member_t>> members_;
+
+			// Member index + 1 per slot, zero when empty.
+			mutable std::size_t indexed_;
+			mutable std::vector<std::uint32_t, serialization_allocator<std::uint32_t>> index_;
 		};
 	}
 }
@@ -28,6 +28,18 @@ namespace octoon
 
 			virtual int flush() noexcept = 0;
 
+			// Returns a pointer to the next cnt bytes without copying them, or nullptr when the
+			// buffer cannot provide them contiguously. peek keeps the position, view advances it.
+			virtual const char* peek(std::streamsize cnt) noexcept;
+			virtual const char* view(std::streamsize cnt) noexcept;
+
+			// Reads up to cnt bytes starting at pos without using or moving the cursor, like pread().
+			// Buffers backed by memory or by a file override it so that any number of threads can read
+			// at once. The default seeks and restores the cursor between lock() and unlock(), which
+			// does nothing in the base class, so it is only safe from one thread at a time unless the
+			// buffer overrides lock() and unlock() to serialise.
+			virtual streamsize read_at(streamoff pos, char* str, std::streamsize cnt) noexcept;
+
 			virtual void lock() noexcept;
 			virtual void unlock() noexcept;
 		};
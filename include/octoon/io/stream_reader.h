@@ -20,7 +20,7 @@ namespace octoon
             virtual void read(char *str, std::int32_t begin, std::int32_t count) except override;
             virtual std::string readLine() except override;
             virtual std::string readToEnd() except override;
-        private:
+        protected:
             istream& base_stream;
         };
     }
@@ -29,6 +29,11 @@ namespace octoon
 
 			streamsize size() const noexcept;
 
+			const char* peek(std::streamsize cnt) noexcept;
+			const char* view(std::streamsize cnt) noexcept;
+
+			streamsize read_at(streamoff pos, char* str, std::streamsize cnt) noexcept;
+
 			int flush() noexcept;
 
 		private:
@@ -5,15 +5,25 @@
 
 #include <octoon/io/ioserver.h>
 
+#include <unordered_map>
+#include <unordered_set>
+
 namespace octoon
 {
 	namespace io
 	{
+		class mapbuf;
+
 		/*
 		* Zip archive as a virtual directory.
 		*
 		* **NOTE** Zip archives are always read-only. Any non-read options set true
 		* will lead to rejection.
+		*
+		* The archive is memory mapped and its central directory is indexed once on
+		* construction. Stored entries are served as views into the mapping, deflated
+		* entries are inflated incrementally while being read. Streams opened from the
+		* same archive are independent and can be read from different threads.
 		*/
 		class OCTOON_EXPORT zarchive : public archive
 		{
@@ -26,16 +36,32 @@ namespace octoon
 			std::unique_ptr<stream_buf> open(const Orl& orl, const ios_base::open_mode options) override;
 			bool remove(const Orl& orl, ItemType type = ItemType::File) override;
 			ItemType exists(const Orl& orl) override;
+			using archive::exists;
 
 		private:
+			struct entry
+			{
+				std::uint16_t method;
+				std::uint16_t flags;
+				std::uint64_t offset;
+				std::uint64_t compressed_size;
+				std::uint64_t size;
+			};
+
+			void load(const std::string& zip_file) except;
 
-			// Hide unzipper.
-			void* unzipper_;
-			void* entries_;
+		private:
+			zarchive(const zarchive&) = delete;
+			zarchive& operator=(const zarchive&) = delete;
+
+		private:
+			std::shared_ptr<mapbuf> file_;
+			std::unordered_map<std::string, entry> entries_;
+			std::unordered_set<std::string> dirs_;
 		};
 
 		using ZipArchivePtr = std::shared_ptr<zarchive>;
 	}
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,16 +2,41 @@
 #define OCTOON_IO_FEATURE_H_
 
 #include <octoon/game_feature.h>
+#include <octoon/io/async_loader.h>
+#include <octoon/io/resource_cache.h>
 
 namespace octoon
 {
+	namespace image
+	{
+		class Image;
+	}
+
+	namespace model
+	{
+		class Model;
+	}
+
 	class OCTOON_EXPORT IOFeature final : public GameFeature
 	{
 		OctoonDeclareSubClass(IOFeature, GameFeature)
 	public:
+		using Bytes = io::AsyncLoader::Bytes;
+		using Ticket = io::AsyncLoader::Ticket;
+
 		IOFeature() noexcept;
 		~IOFeature() noexcept;
 
+		// Loads in the background, callbacks run at the beginning of the next frames. A result
+		// of nullptr means the ORL is invalid, the file couldn't be read or it failed to decode.
+		// Images and models already in the cache are handed out again without loading them.
+		Ticket loadBytes(const std::string& orl, std::function<void(const std::shared_ptr<Bytes>&)>&& callback = nullptr, io::LoadPriority priority = io::LoadPriority::Normal) noexcept;
+		Ticket loadImage(const std::string& orl, std::function<void(const std::shared_ptr<image::Image>&)>&& callback = nullptr, io::LoadPriority priority = io::LoadPriority::Normal) noexcept;
+		Ticket loadModel(const std::string& orl, std::function<void(const std::shared_ptr<model::Model>&)>&& callback = nullptr, io::LoadPriority priority = io::LoadPriority::Normal) noexcept;
+
+		io::AsyncLoader* getLoader() const noexcept;
+		io::ResourceCache* getCache() const noexcept;
+
 	private:
 		void onActivate() except override;
 		void onDeactivate() noexcept override;
@@ -22,7 +47,9 @@ namespace octoon
 
 	private:
 		std::string system_path_;
+		std::unique_ptr<io::ResourceCache> cache_;
+		std::unique_ptr<io::AsyncLoader> loader_;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
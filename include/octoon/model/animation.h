@@ -2,6 +2,8 @@
 #define OCTOON_ANIMATION_H_
 
 #include <octoon/model/bone.h>
+#include <octoon/model/pose.h>
+#include <octoon/model/ik_solver.h>
 
 #include <octoon/math/mathfwd.h>
 #include <octoon/math/vector3.h>
@@ -9,6 +11,7 @@
 
 #include <string>
 #include <cstdint>
+#include <unordered_map>
 
 namespace octoon
 {
@@ -65,6 +68,24 @@ namespace octoon
 
 		class MorphAnimation
 		{
+		public:
+			MorphAnimation() noexcept;
+			~MorphAnimation() noexcept;
+
+			void setName(const std::string& name) noexcept;
+			const std::string& getName() const noexcept;
+
+			void setFrameNo(std::int32_t frame) noexcept;
+			std::int32_t getFrameNo() const noexcept;
+
+			void setWeight(float weight) noexcept;
+			float getWeight() const noexcept;
+
+		private:
+			std::string _name;
+
+			std::int32_t _frame;
+			float _weight;
 		};
 
 		class AnimationProperty final
@@ -88,11 +109,13 @@ namespace octoon
 			const InverseKinematics& getIKArray() const noexcept;
 
 			void addBoneAnimation(const BoneAnimation& anim) noexcept;
+			void setBoneAnimationArray(std::vector<BoneAnimation>&& anims) noexcept;
 			BoneAnimation& getBoneAnimation(std::size_t index) noexcept;
 			const BoneAnimation& getBoneAnimation(std::size_t index) const noexcept;
 			std::size_t getNumBoneAnimation() const noexcept;
 
 			void addMorphAnimation(const MorphAnimation& anim) noexcept;
+			void setMorphAnimationArray(std::vector<MorphAnimation>&& anims) noexcept;
 			MorphAnimation& getMorphAnimation(std::size_t index) noexcept;
 			const MorphAnimation& getMorphAnimation(std::size_t index) const noexcept;
 			std::size_t getNumMorphAnimation() const noexcept;
@@ -107,6 +130,13 @@ namespace octoon
 			void updateBoneMatrix(Bone& bone) noexcept;
 			void updateIK() noexcept;
 
+			void samplePose(Pose& pose) noexcept;
+			void samplePose(Pose& pose, std::size_t frame) noexcept;
+			void applyPose(const Pose& pose) noexcept;
+
+			IKSolver& getIKSolver() noexcept;
+			const IKSolver& getIKSolver() const noexcept;
+
 			MotionSegment findMotionSegment(int frame, const std::vector<std::size_t>& motions) noexcept;
 			void interpolateMotion(math::Quaternion& rotation, math::Vector3& position, const std::vector<std::size_t>& motions, std::size_t frame) noexcept;
 
@@ -115,8 +145,9 @@ namespace octoon
 			AnimationProperty& operator=(const AnimationProperty&) = delete;
 
 		private:
-			void updateIK(Bones& _bones, const IKAttr& ik) noexcept;
 			void updateBones(const Bones& _bones) noexcept;
+			void bindAnimation() noexcept;
+			bool sampleBoneMotion(std::size_t index, std::size_t frame, math::float3& translate, math::Quaternion& rotate) noexcept;
 			void updateTransform(Bone& bone, const math::float3& translate, const math::Quaternion& rotate) noexcept;
 
 		private:
@@ -130,6 +161,10 @@ namespace octoon
 
 			Bones _bones;
 			InverseKinematics _iks;
+			std::unordered_map<std::string, std::size_t> _boneIndices;
+
+			Pose _pose;
+			IKSolver _solver;
 
 			std::vector<BoneAnimation> _boneAnimation;
 			std::vector<MorphAnimation> _morphAnimation;
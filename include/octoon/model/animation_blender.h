@@ -0,0 +1,80 @@
+#ifndef OCTOON_MODEL_ANIMATION_BLENDER_H_
+#define OCTOON_MODEL_ANIMATION_BLENDER_H_
+
+#include <octoon/model/animation.h>
+#include <octoon/model/pose.h>
+
+namespace octoon
+{
+	namespace model
+	{
+		enum class AnimationBlendMode
+		{
+			Override,
+			Additive
+		};
+
+		class AnimationLayer
+		{
+		public:
+			AnimationPropertyPtr clip;
+			AnimationBlendMode mode;
+
+			float weight;
+
+			std::vector<float> mask;
+
+			Pose* reference;
+		};
+
+		// Samples every layer into a pooled pose and blends them in layer order,
+		// only the final pose is pushed into the target skeleton.
+		//   Override layers lerp the accumulated pose towards the layer pose.
+		//   Additive layers apply the difference between the layer pose and the
+		//   first frame of its clip on top of the accumulated pose.
+		class OCTOON_EXPORT AnimationBlender final
+		{
+		public:
+			AnimationBlender() noexcept;
+			~AnimationBlender() noexcept;
+
+			void setBoneArray(const Bones& bones) noexcept;
+			const Bones& getBoneArray() const noexcept;
+
+			std::size_t addLayer(const AnimationPropertyPtr& clip, AnimationBlendMode mode = AnimationBlendMode::Override, float weight = 1.0f) noexcept;
+			void removeLayer(std::size_t index) noexcept;
+			void clearLayers() noexcept;
+
+			AnimationLayer& getLayer(std::size_t index) noexcept;
+			const AnimationLayer& getLayer(std::size_t index) const noexcept;
+			std::size_t getNumLayers() const noexcept;
+
+			void setLayerWeight(std::size_t index, float weight) noexcept;
+			float getLayerWeight(std::size_t index) const noexcept;
+
+			void setLayerMask(std::size_t index, const std::vector<float>& mask) noexcept;
+			void setLayerMask(std::size_t index, const std::vector<std::size_t>& bones, float weight) noexcept;
+			void clearLayerMask(std::size_t index) noexcept;
+
+			void updateFrame(float delta) noexcept;
+
+			const Pose& evaluate() noexcept;
+			void apply(AnimationProperty& target) noexcept;
+
+		private:
+			AnimationBlender(const AnimationBlender&) = delete;
+			AnimationBlender& operator=(const AnimationBlender&) = delete;
+
+		private:
+			Bones _bones;
+
+			Pose _restPose;
+			Pose _finalPose;
+			PosePool _pool;
+
+			std::vector<AnimationLayer> _layers;
+		};
+	}
+}
+
+#endif
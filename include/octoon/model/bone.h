@@ -21,10 +21,11 @@ namespace octoon
 			float weight3;
 			float weight4;
 
-			std::uint8_t bone1;
-			std::uint8_t bone2;
-			std::uint8_t bone3;
-			std::uint8_t bone4;
+			// Full PMX bone index width, models with more than 255 bones are common.
+			std::int32_t bone1;
+			std::int32_t bone2;
+			std::int32_t bone3;
+			std::int32_t bone4;
 		};
 
 		class IKChild
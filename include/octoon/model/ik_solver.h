@@ -0,0 +1,83 @@
+#ifndef OCTOON_MODEL_IK_SOLVER_H_
+#define OCTOON_MODEL_IK_SOLVER_H_
+
+#include <octoon/model/bone.h>
+#include <octoon/model/pose.h>
+
+namespace octoon
+{
+	namespace model
+	{
+		class IKChainStats
+		{
+		public:
+			std::uint32_t iterations;
+			float time; // milliseconds
+			bool converged;
+		};
+
+		// Cyclic coordinate descent solver working directly on the local rotations of a Pose.
+		// World transforms are computed once per stage and then updated incrementally for
+		// the bones between the rotated link and the end effector only. Chains that neither
+		// write nor read bones of each other are grouped into the same stage and can be
+		// solved in parallel.
+		class OCTOON_EXPORT IKSolver final
+		{
+		public:
+			IKSolver() noexcept;
+			~IKSolver() noexcept;
+
+			void setBoneArray(const Bones& bones) noexcept;
+			void setIKArray(const InverseKinematics& iks) noexcept;
+
+			void setTolerance(float tolerance) noexcept;
+			float getTolerance() const noexcept;
+
+			void setParallelEnable(bool enable) noexcept;
+			bool getParallelEnable() const noexcept;
+
+			void solve(Pose& pose) noexcept;
+
+			std::size_t getNumStages() const noexcept;
+			const std::vector<IKChainStats>& getChainStats() const noexcept;
+
+		private:
+			struct Chain
+			{
+				IKAttr attr;
+
+				std::size_t stage;
+				std::size_t first;
+
+				std::vector<std::size_t> path;
+				std::vector<std::size_t> links;
+			};
+
+			void build() noexcept;
+			void updateWorld(const Pose& pose, std::size_t first) noexcept;
+			void solveChain(Pose& pose, const Chain& chain, IKChainStats& stats) noexcept;
+
+			bool isAncestor(std::size_t ancestor, std::size_t bone) const noexcept;
+
+		private:
+			IKSolver(const IKSolver&) = delete;
+			IKSolver& operator=(const IKSolver&) = delete;
+
+		private:
+			bool _parallel;
+			float _tolerance;
+
+			std::vector<std::int16_t> _parents;
+			InverseKinematics _iks;
+
+			std::vector<Chain> _chains;
+			std::vector<std::vector<std::size_t>> _stages;
+			std::vector<IKChainStats> _stats;
+
+			std::vector<math::float3> _worldPosition;
+			std::vector<math::Quaternion> _worldRotation;
+		};
+	}
+}
+
+#endif
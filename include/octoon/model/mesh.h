@@ -92,6 +92,9 @@ namespace octoon
 			void computeTangentQuats(math::float4s& tangentQuat) const noexcept;
 			void computeBoundingBox() noexcept;
 
+			// Moves texcoords of the unit square into the area u0, v0, u1, v1, such as an entry of a texture atlas.
+			void remapTexcoordArray(const math::float4& rect, std::uint8_t n = 0) noexcept;
+
 			const math::BoundingBox& getBoundingBox() const noexcept;
 
 			void clear() noexcept;
@@ -3,6 +3,7 @@
 
 #include <octoon/model/moddef.h>
 #include <octoon/model/pmx_loader.h>
+#include <octoon/model/vmd_loader.h>
 #include <octoon/model/model.h>
 
 namespace octoon
@@ -2,5 +2,6 @@
 #define OCTOON_MODDEF_H_
 
 #define OCTOON_BUILD_PMX_MODEL 1
+#define OCTOON_BUILD_VMD_MODEL 1
 
 #endif // !OCTOON_MODDEF_H_
@@ -26,6 +26,7 @@ namespace octoon
 			typedef std::vector<AnimationPropertyPtr> AnimList;
 			typedef std::vector<LightPropertyPtr>     LightList;
 			typedef std::vector<CameraPropertyPtr>    CameraList;
+			typedef std::vector<MorphPtr>             MorphList;
 
 		public:
 			Model() noexcept;
@@ -41,6 +42,7 @@ namespace octoon
 			void addAnimtion(AnimationPropertyPtr& anim)   noexcept;
 			void addLight(LightPropertyPtr& light)         noexcept;
 			void addCamera(CameraPropertyPtr& camera)      noexcept;
+			void addMorph(MorphPtr& morph)                 noexcept;
 
 			void addMesh(MeshPtr&& mesh)           noexcept;
 			void addBone(BonePtr&& bone)				   noexcept;
@@ -52,6 +54,7 @@ namespace octoon
 			void addAnimtion(AnimationPropertyPtr&& anim)  noexcept;
 			void addLight(LightPropertyPtr&& light)        noexcept;
 			void addCamera(CameraPropertyPtr&& camera)     noexcept;
+			void addMorph(MorphPtr&& morph)                noexcept;
 
 			MeshList&      getMeshsList()     noexcept;
 			BoneList&      getBonesList()     noexcept;
@@ -63,6 +66,7 @@ namespace octoon
 			AnimList&      getAnimationList() noexcept;
 			LightList&     getLightList()     noexcept;
 			CameraList&    getCameraList()    noexcept;
+			MorphList&     getMorphList()     noexcept;
 
 			void setDirectory(const std::string& name) noexcept;
 			const std::string&  getDirectory() const noexcept;
@@ -78,6 +82,7 @@ namespace octoon
 			const AnimList&      getAnimationList() const noexcept;
 			const LightList&     getLightList()     const noexcept;
 			const CameraList&    getCameraList()    const noexcept;
+			const MorphList&     getMorphList()     const noexcept;
 
 			bool hasMeshes()     const noexcept;
 			bool hasBones()      const noexcept;
@@ -87,12 +92,13 @@ namespace octoon
 			bool hasTextures()   const noexcept;
 			bool hasCameras()    const noexcept;
 			bool hasAnimations() const noexcept;
+			bool hasMorphs()     const noexcept;
 
 			void applyProcess(int flags) noexcept;
 
 			void clear() noexcept;
 
-			bool load(io::fstream& file, const char* type = nullptr) noexcept;
+			bool load(io::istream& file, const char* type = nullptr) noexcept;
 			bool save(io::fstream& file, const char* type = "pmx") noexcept;
 
 			bool emptyLoader() const noexcept;
@@ -119,6 +125,7 @@ namespace octoon
 			AnimList _animations;
 			LightList _lights;
 			CameraList _cameras;
+			MorphList _morphs;
 			std::vector<MyLoader> _loaders;
 		};
 	}
@@ -60,6 +60,7 @@ namespace octoon
 		class JointProperty;
 		class VertexWeight;
 		class CombineMesh;
+		class Morph;
 
 		typedef std::shared_ptr<AnimationProperty> AnimationPropertyPtr;
 		typedef std::shared_ptr<TextureProperty> TexturePropertyPtr;
@@ -78,12 +79,14 @@ namespace octoon
 		typedef std::shared_ptr<RigidbodyProperty> RigidbodyPropertyPtr;
 		typedef std::shared_ptr<JointProperty> JointPropertyPtr;
 		typedef std::shared_ptr<VertexWeight> VertexWeightPtr;
+		typedef std::shared_ptr<Morph> MorphPtr;
 
 		typedef std::vector<VertexWeight> VertexWeights;
 		typedef std::vector<MeshPtr> Meshes;
 		typedef std::vector<Bone> Bones;
 		typedef std::vector<IKAttr> InverseKinematics;
 		typedef std::vector<CombineMesh> CombineMeshes;
+		typedef std::vector<MorphPtr> Morphs;
 		typedef std::vector<TextFilePtr> TextFiles;
 		typedef std::vector<ContourPtr> Contours;
 		typedef std::vector<ContourGroupPtr> ContourGroups;
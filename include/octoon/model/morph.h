@@ -0,0 +1,74 @@
+#ifndef OCTOON_MODEL_MORPH_H_
+#define OCTOON_MODEL_MORPH_H_
+
+#include <octoon/model/modtypes.h>
+
+#include <octoon/math/vector2.h>
+#include <octoon/math/vector3.h>
+
+#include <string>
+#include <cstdint>
+
+namespace octoon
+{
+	namespace model
+	{
+		enum class MorphType : std::uint8_t
+		{
+			Group,
+			Vertex,
+			Texcoord
+		};
+
+		class MorphGroup
+		{
+		public:
+			std::uint32_t morph;
+			float weight;
+		};
+
+		// Sparse deltas of one morph for one mesh, indices are sorted in ascending order and
+		// refer to the vertices of that mesh. Normals and texcoords are optional.
+		class MorphTarget
+		{
+		public:
+			std::uint32_t mesh;
+
+			math::Uint1Array indices;
+			math::float3s offsets;
+			math::float3s normals;
+			math::float2s texcoords;
+		};
+
+		class OCTOON_EXPORT Morph final
+		{
+		public:
+			Morph() noexcept;
+			Morph(const std::string& name, MorphType type) noexcept;
+			~Morph() noexcept;
+
+			void setName(const std::string& name) noexcept;
+			const std::string& getName() const noexcept;
+
+			void setType(MorphType type) noexcept;
+			MorphType getType() const noexcept;
+
+			void setTargetArray(const std::vector<MorphTarget>& targets) noexcept;
+			void setTargetArray(std::vector<MorphTarget>&& targets) noexcept;
+			const std::vector<MorphTarget>& getTargetArray() const noexcept;
+
+			void setGroupArray(const std::vector<MorphGroup>& groups) noexcept;
+			void setGroupArray(std::vector<MorphGroup>&& groups) noexcept;
+			const std::vector<MorphGroup>& getGroupArray() const noexcept;
+
+		private:
+			std::string _name;
+			MorphType _type;
+
+			std::vector<MorphTarget> _targets;
+			std::vector<MorphGroup> _groups;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef OCTOON_MODEL_MORPH_ENGINE_H_
+#define OCTOON_MODEL_MORPH_ENGINE_H_
+
+#include <octoon/model/morph.h>
+
+#include <unordered_map>
+
+namespace octoon
+{
+	namespace model
+	{
+		// Evaluates morph targets on the CPU. Group morphs are flattened into lists of
+		// vertex/texcoord morphs once in setMorphArray, update() turns the user weights into
+		// per mesh lists of active targets and evaluate() accumulates them into a copy of the
+		// base streams, ready for skinning or upload.
+		class OCTOON_EXPORT MorphEngine final
+		{
+		public:
+			MorphEngine() noexcept;
+			~MorphEngine() noexcept;
+
+			void setMorphArray(const Morphs& morphs) noexcept;
+			std::size_t getNumMorphs() const noexcept;
+
+			std::size_t findMorph(const std::string& name) const noexcept;
+
+			void setWeight(std::size_t index, float weight) noexcept;
+			float getWeight(std::size_t index) const noexcept;
+			void clearWeights() noexcept;
+
+			void setParallelEnable(bool enable) noexcept;
+			bool getParallelEnable() const noexcept;
+
+			void update() noexcept;
+
+			std::size_t getNumActive() const noexcept;
+			std::size_t getNumActive(std::size_t mesh) const noexcept;
+
+			void evaluate(std::size_t mesh, const math::float3s& vertices, const math::float3s& normals, math::float3s& outVertices, math::float3s& outNormals) noexcept;
+			void evaluate(std::size_t mesh, const math::float2s& texcoords, math::float2s& outTexcoords) noexcept;
+
+		private:
+			struct Active
+			{
+				const MorphTarget* target;
+				float weight;
+			};
+
+			void flatten(std::size_t index, float weight, std::vector<bool>& visited, std::vector<std::pair<std::size_t, float>>& out) const noexcept;
+
+		private:
+			MorphEngine(const MorphEngine&) = delete;
+			MorphEngine& operator=(const MorphEngine&) = delete;
+
+		private:
+			bool _parallel;
+
+			Morphs _morphs;
+
+			std::vector<float> _weights;
+			std::vector<float> _leafWeights;
+			std::vector<std::vector<std::pair<std::size_t, float>>> _flatten;
+			std::unordered_map<std::string, std::size_t> _names;
+
+			std::vector<std::vector<std::pair<std::size_t, const MorphTarget*>>> _meshTargets;
+			std::vector<std::vector<Active>> _active;
+		};
+	}
+}
+
+#endif
@@ -20,8 +20,10 @@
 #define PMX_BONE_ROOT     1 << 4
 #define PMX_BONE_IK       1 << 5
 #define PMX_BONE_PARENT   1 << 8
+#define PMX_BONE_MOVE_PARENT 1 << 9
 #define PMX_BONE_AXIS     1 << 10
 #define PMX_BONE_ROTATE   1 << 11
+#define PMX_BONE_EXTERNAL_PARENT 1 << 13
 
 namespace octoon
 {
@@ -0,0 +1,91 @@
+#ifndef OCTOON_MODEL_POSE_H_
+#define OCTOON_MODEL_POSE_H_
+
+#include <octoon/model/modtypes.h>
+#include <octoon/math/vector3.h>
+#include <octoon/math/quat.h>
+#include <octoon/runtime/platform.h>
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace octoon
+{
+	namespace model
+	{
+		// Local bone transforms stored as structure of arrays so that blending can
+		// process four bones per SIMD lane. The capacity is always padded to a
+		// multiple of four, padding lanes hold the identity transform.
+		class OCTOON_EXPORT Pose final
+		{
+		public:
+			Pose() noexcept;
+			Pose(std::size_t numBones) noexcept;
+			~Pose() noexcept;
+
+			void resize(std::size_t numBones) noexcept;
+
+			std::size_t size() const noexcept;
+			std::size_t capacity() const noexcept;
+
+			void setIdentity() noexcept;
+
+			void setTranslate(std::size_t index, const math::float3& translate) noexcept;
+			math::float3 getTranslate(std::size_t index) const noexcept;
+
+			void setRotation(std::size_t index, const math::Quaternion& rotate) noexcept;
+			math::Quaternion getRotation(std::size_t index) const noexcept;
+
+			void copy(const Pose& other) noexcept;
+
+		public:
+			float* tx;
+			float* ty;
+			float* tz;
+			float* qx;
+			float* qy;
+			float* qz;
+			float* qw;
+
+		private:
+			Pose(const Pose&) = delete;
+			Pose& operator=(const Pose&) = delete;
+
+		private:
+			std::size_t _size;
+			std::size_t _capacity;
+			std::vector<float> _data;
+		};
+
+		// Poses are handed out from a pool that is sized once when the skeleton
+		// is bound, evaluation never touches the heap afterwards.
+		class OCTOON_EXPORT PosePool final
+		{
+		public:
+			PosePool() noexcept;
+			~PosePool() noexcept;
+
+			void reserve(std::size_t count, std::size_t numBones) noexcept;
+			void clear() noexcept;
+
+			Pose* alloc() noexcept;
+			void free(Pose* pose) noexcept;
+
+			std::size_t getNumBones() const noexcept;
+			std::size_t getNumFree() const noexcept;
+
+		private:
+			PosePool(const PosePool&) = delete;
+			PosePool& operator=(const PosePool&) = delete;
+
+		private:
+			std::size_t _numBones;
+			std::vector<std::unique_ptr<Pose>> _poses;
+			std::vector<Pose*> _free;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef OCTOON_VMD_LOADER_H_
+#define OCTOON_VMD_LOADER_H_
+
+#include <octoon/model/loader.h>
+
+namespace octoon
+{
+	namespace model
+	{
+		// Streams VMD motions into an AnimationProperty, keyframes are read in fixed size blocks
+		// so only the decoded tracks are kept in memory, never the whole file.
+		class VmdLoader : public ModelLoader
+		{
+		public:
+			VmdLoader() = default;
+			~VmdLoader() = default;
+
+			bool doCanLoad(io::istream& stream) noexcept;
+			bool doCanLoad(const std::string& type) noexcept;
+			bool doCanLoad(const char* type) noexcept;
+
+			bool doLoad(io::istream& stream, Model& model) noexcept;
+			bool doSave(io::ostream& stream, const Model& model) noexcept;
+		};
+	}
+}
+#endif // !OCTOON_VMD_LOADER_H_
@@ -0,0 +1,64 @@
+#ifndef OCTOON_THREAD_POOL_H_
+#define OCTOON_THREAD_POOL_H_
+
+#include <octoon/runtime/platform.h>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <future>
+#include <functional>
+#include <condition_variable>
+
+namespace octoon
+{
+	namespace runtime
+	{
+		class OCTOON_EXPORT ThreadPool final
+		{
+		public:
+			ThreadPool() noexcept;
+			ThreadPool(std::size_t num_threads) noexcept;
+			~ThreadPool() noexcept;
+
+			std::size_t size() const noexcept;
+
+			void push(std::function<void()>&& task) noexcept;
+
+			template<typename F, typename R = std::result_of_t<F()>>
+			std::future<R> async(F&& func) noexcept
+			{
+				auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+				auto future = task->get_future();
+				this->push([task]() { (*task)(); });
+				return future;
+			}
+
+			// Splits [begin, end) into chunks of at least grain items and runs them on the
+			// pool, the calling thread takes part in the work and returns once all chunks are done.
+			// Tasks of the pool may call it too, they run the chunks no other thread has taken.
+			void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& func) noexcept;
+
+			static ThreadPool* instance() noexcept;
+
+		private:
+			void run() noexcept;
+
+		private:
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+		private:
+			bool quit_;
+
+			std::mutex mutex_;
+			std::condition_variable cond_;
+			std::deque<std::function<void()>> tasks_;
+			std::vector<std::thread> threads_;
+		};
+	}
+}
+
+#endif
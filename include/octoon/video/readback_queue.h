@@ -0,0 +1,75 @@
+#ifndef OCTOON_VIDEO_READBACK_QUEUE_H_
+#define OCTOON_VIDEO_READBACK_QUEUE_H_
+
+#include <octoon/graphics/graphics_texture.h>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+namespace octoon
+{
+	namespace video
+	{
+		/*
+		* Reads rendered frames back without stalling on the GPU. Every push copies a region into
+		* the next of several rotating read buffers of the texture and fences it. The copy is mapped
+		* on the following push, once another frame has been submitted, and the mapped rows go to a
+		* worker thread as they are. A buffer is unmapped and reused after its consumer returned.
+		*
+		* push(), flush() and the destructor have to run on the thread owning the graphics context.
+		*/
+		class OCTOON_EXPORT ReadbackQueue final
+		{
+		public:
+			// Rows are pitch bytes apart and start with the bottom row of the region, as OpenGL stores it.
+			using Consumer = std::function<void(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t pitch)>;
+
+			struct Buffer;
+
+		public:
+			ReadbackQueue(std::uint32_t count = 3) noexcept;
+			~ReadbackQueue() noexcept;
+
+			// Waits for the oldest consumer when every buffer is in use.
+			void push(const graphics::GraphicsTexturePtr& texture, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, Consumer&& consumer) except;
+
+			// Waits until every frame has been consumed, rethrows the first exception of a consumer.
+			void flush() except;
+
+			// Frames pushed but not consumed yet.
+			std::size_t pending() const noexcept;
+
+			std::uint32_t getBufferCount() const noexcept;
+
+		private:
+			void reclaim() noexcept;
+			void submit() noexcept;
+			void run() noexcept;
+
+		private:
+			ReadbackQueue(const ReadbackQueue&) = delete;
+			ReadbackQueue& operator=(const ReadbackQueue&) = delete;
+
+		private:
+			bool quit_;
+
+			std::vector<Buffer> buffers_;
+			std::deque<std::uint32_t> copying_;
+			std::deque<std::uint32_t> consuming_;
+			std::deque<std::uint32_t> jobs_;
+
+			std::exception_ptr exception_;
+
+			mutable std::mutex mutex_;
+			std::condition_variable jobCondition_;
+			std::condition_variable doneCondition_;
+
+			std::thread thread_;
+		};
+	}
+}
+
+#endif
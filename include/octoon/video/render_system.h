@@ -4,6 +4,7 @@
 #include <octoon/runtime/singleton.h>
 #include <octoon/video/render_types.h>
 #include <octoon/graphics/graphics.h>
+#include <octoon/video/readback_queue.h>
 
 namespace octoon
 {
@@ -38,7 +39,13 @@ namespace octoon
 
 			void render(graphics::GraphicsContext& context) noexcept;
 
-			void saveAsPNG(graphics::GraphicsContext& context, const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height) noexcept(false);
+			// Level 0 stores the pixels, 1 encodes fastest and 9 writes the smallest files.
+			void saveAsPNG(graphics::GraphicsContext& context, const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, int level = 3) noexcept(false);
+
+			// Returns before the frame has been read back, the file is written on the readback worker while
+			// the next frames render. flushReadback() waits for every queued file and reports the first error.
+			void saveAsPNGAsync(graphics::GraphicsContext& context, const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, int level = 3) noexcept(false);
+			void flushReadback() noexcept(false);
 
 		private:
 			void setupFramebuffers(std::uint32_t w, std::uint32_t h) except;
@@ -59,6 +66,8 @@ namespace octoon
 			graphics::GraphicsTexturePtr depthTextureMSAA_;
 
 			graphics::GraphicsDevicePtr device_;
+
+			std::unique_ptr<ReadbackQueue> readbackQueue_;
 		};
 	}
 }
@@ -0,0 +1,48 @@
+#ifndef OCTOON_VIDEO_TEXTURE_ATLAS_H_
+#define OCTOON_VIDEO_TEXTURE_ATLAS_H_
+
+#include <octoon/graphics/graphics_texture.h>
+#include <octoon/image/image_atlas.h>
+
+#include <memory>
+
+namespace octoon
+{
+	namespace video
+	{
+		/*
+		* Keeps an image atlas in a texture, so that glyphs, icons and UI images drawn together bind
+		* one texture and one descriptor set. Uploads write only the dirty rectangles of the atlas,
+		* together with the box filtered texels they change on every further level of the texture.
+		* sRGB colors are averaged in linear space and encoded again, alpha as stored.
+		*
+		* upload() has to run on the thread owning the graphics context.
+		*/
+		class OCTOON_EXPORT TextureAtlas final
+		{
+		public:
+			// The atlas takes the size and format of the texture, R8, R8G8, R8G8B8A8 or B8G8R8A8 in UNorm or SRGB.
+			TextureAtlas(const graphics::GraphicsTexturePtr& texture, std::uint32_t padding = 1, std::uint32_t gutter = 1, image::AtlasPacking packing = image::AtlasPacking::MaxRects) except;
+			~TextureAtlas() noexcept;
+
+			image::ImageAtlas& getAtlas() noexcept;
+			const image::ImageAtlas& getAtlas() const noexcept;
+
+			const graphics::GraphicsTexturePtr& getTexture() const noexcept;
+
+			// Writes the dirty rectangles into the texture and clears them, returns the bytes written.
+			std::size_t upload() except;
+
+		private:
+			TextureAtlas(const TextureAtlas&) = delete;
+			TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		private:
+			graphics::GraphicsTexturePtr texture_;
+			std::unique_ptr<image::ImageAtlas> atlas_;
+			std::vector<std::uint8_t> scratch_;
+		};
+	}
+}
+
+#endif
@@ -16,7 +16,9 @@ namespace octoon
 		void setFramebufferScale(std::uint32_t w, std::uint32_t h) noexcept;
 		void getFramebufferScale(std::uint32_t& w, std::uint32_t& h) noexcept;
 
-		void saveAsPNG(const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height) noexcept(false);
+		void saveAsPNG(const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, int level = 3) noexcept(false);
+		void saveAsPNGAsync(const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, int level = 3) noexcept(false);
+		void flushReadback() noexcept(false);
 
 	private:
 		void onActivate() except override;
@@ -9,6 +9,10 @@
 #include <octoon/video_feature.h>
 #include <octoon/video/text_material.h>
 
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
 const std::string chars[] =
 {
 	R"({"paths":[{"points":[[602.54,436.40,8],[602.54,436.40,3],[602.54,443.41,3],[602.54,443.41,3],[602.54,451.51,3],[600.25,458.11,3],[595.66,463.22,3],[591.07,468.33,3],[585.33,470.88,3],[578.45,470.88,3],[573.38,470.88,3],[569.43,469.51,3],[566.60,466.76,3],[563.76,464.01,3],[562.34,460.51,3],[562.34,456.27,3],[562.34,450.81,3],[563.87,446.89,3],[566.92,444.48,3],[569.97,442.08,3],[575.27,440.34,3],[582.80,439.26,3],[582.80,439.26,3],[602.54,436.40,3],[602.54,436.40,3],[602.54,436.40,9]],"w":0.00,"h":0.00},{"points":[[608.97,475.04,8],[608.97,475.04,3],[608.97,428.35,3],[608.97,428.35,3],[608.97,419.60,3],[606.96,412.93,3],[602.93,408.34,3],[598.90,403.76,3],[593.19,401.46,3],[585.79,401.46,3],[581.76,401.46,3],[577.46,402.21,3],[572.90,403.70,3],[568.33,405.19,3],[564.72,407.00,3],[562.08,409.12,3],[562.08,409.12,3],[562.08,416.92,3],[562.08,416.92,3],[569.57,410.55,3],[577.26,407.37,3],[585.14,407.37,3],[596.74,407.37,3],[602.54,415.08,3],[602.54,430.49,3],[602.54,430.49,3],[580.46,433.80,3],[580.46,433.80,3],[563.84,436.40,3],[555.52,443.97,3],[555.52,456.53,3],[555.52,462.38,3],[557.52,467.21,3],[561.50,471.04,3],[565.48,474.88,3],[570.89,476.79,3],[577.73,476.79,3],[583.06,476.79,3],[587.91,475.33,3],[592.28,472.41,3],[596.65,469.49,3],[599.99,465.58,3],[602.28,460.69,3],[602.28,460.69,3],[602.54,460.69,3],[602.54,460.69,3],[602.54,460.69,3],[602.54,475.04,3],[602.54,475.04,3],[602.54,475.04,3],[608.97,475.04,3],[608.97,475.04,3],[608.97,475.04,9]],"w":0.00,"h":0.00}],"w":0.00,"h":0.00,"x":0.00,"y":0.00,"ft":0})",
@@ -83,6 +87,38 @@ int main(int argc, const char* argv[])
 	object->addComponent<octoon::MeshRendererComponent>(material);
 	object->addComponent<AutoRotation>();
 
-	app->update();
-	app->getFeature<octoon::VideoFeature>()->saveAsPNG("output.png", 0, 0, w, h);
+	auto video = app->getFeature<octoon::VideoFeature>();
+
+	// octoon-offscreen <frames> renders a batch of frames with and without the readback queue and reports the sustained rate.
+	int frames = argc > 1 ? std::atoi(argv[1]) : 0;
+	if (frames > 0)
+	{
+		auto benchmark = [&](bool async)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			for (int i = 0; i < frames; i++)
+			{
+				app->update();
+
+				auto filepath = "output_" + std::to_string(i) + ".png";
+				if (async)
+					video->saveAsPNGAsync(filepath.c_str(), 0, 0, w, h, 1);
+				else
+					video->saveAsPNG(filepath.c_str(), 0, 0, w, h, 1);
+			}
+
+			video->flushReadback();
+
+			return frames / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		std::cout << "saveAsPNG      : " << benchmark(false) << " fps" << std::endl;
+		std::cout << "saveAsPNGAsync : " << benchmark(true) << " fps" << std::endl;
+	}
+	else
+	{
+		app->update();
+		video->saveAsPNG("output.png", 0, 0, w, h);
+	}
 }
\ No newline at end of file
@@ -218,6 +218,16 @@ namespace octoon
 				glDeleteBuffers(1, &_upbo);
 				_upbo = GL_NONE;
 			}
+
+			for (auto& it : _readBuffers)
+			{
+				if (it.fence)
+					glDeleteSync(it.fence);
+				if (it.buffer != GL_NONE)
+					glDeleteBuffers(1, &it.buffer);
+			}
+
+			_readBuffers.clear();
 		}
 
 		bool
@@ -258,7 +268,7 @@ namespace octoon
 				_pboSize = mapSize;
 			}
 
-			glGetTextureSubImage(_texture, mipLevel, x, y, 0, w, h, 0, format, type, mapSize, 0);
+			glGetTextureSubImage(_texture, mipLevel, x, y, 0, w, h, 1, format, type, mapSize, 0);
 
 			*data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, mapSize, GL_MAP_READ_BIT);
 			return *data ? true : false;
@@ -270,6 +280,122 @@ namespace octoon
 			glUnmapNamedBuffer(_pbo);
 		}
 
+		bool
+		OGLCoreTexture::update(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel, const void* data, std::uint32_t pitch) noexcept
+		{
+			assert(data);
+
+			GLenum format = OGLTypes::asTextureFormat(_textureDesc.getTexFormat());
+			GLenum type = OGLTypes::asTextureType(_textureDesc.getTexFormat());
+			if (format == GL_INVALID_ENUM || type == GL_INVALID_ENUM)
+			{
+				this->getDevice()->downcast<OGLDevice>()->message("Invalid texture format");
+				return false;
+			}
+
+			GLsizei num = OGLTypes::getFormatNum(format, type);
+			if (num == 0 || pitch % num != 0)
+				return false;
+
+			GLint oldAlignment = 1;
+			GLint oldRowLength = 0;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlignment);
+			glGetIntegerv(GL_UNPACK_ROW_LENGTH, &oldRowLength);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / num);
+
+			glTextureSubImage2D(_texture, mipLevel, x, y, w, h, format, type, data);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlignment);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, oldRowLength);
+
+			return OGLCheck::checkError();
+		}
+
+		bool
+		OGLCoreTexture::readBack(std::uint32_t slot, std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel) noexcept
+		{
+			GLenum format = OGLTypes::asTextureFormat(_textureDesc.getTexFormat());
+			GLenum type = OGLTypes::asTextureType(_textureDesc.getTexFormat());
+			if (format == GL_INVALID_ENUM || type == GL_INVALID_ENUM)
+			{
+				this->getDevice()->downcast<OGLDevice>()->message("Invalid texture format");
+				return false;
+			}
+
+			if (type == GL_HALF_FLOAT)
+				type = GL_FLOAT;
+
+			GLsizei num = OGLTypes::getFormatNum(format, type);
+			if (num == 0)
+				return false;
+
+			if (_readBuffers.size() <= slot)
+				_readBuffers.resize(slot + 1, ReadBuffer{ GL_NONE, 0, 0, 0, nullptr });
+
+			auto& readBuffer = _readBuffers[slot];
+			if (readBuffer.fence)
+			{
+				glDeleteSync(readBuffer.fence);
+				readBuffer.fence = nullptr;
+			}
+
+			if (readBuffer.buffer == GL_NONE)
+				glCreateBuffers(1, &readBuffer.buffer);
+
+			// Rows are packed with the default GL_PACK_ALIGNMENT of 4.
+			GLuint pitch = (w * num + 3) & ~3u;
+			GLsizeiptr size = (GLsizeiptr)pitch * h;
+			if (readBuffer.size < size)
+			{
+				glNamedBufferData(readBuffer.buffer, size, nullptr, GL_STREAM_READ);
+				readBuffer.size = size;
+			}
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readBuffer.buffer);
+			glGetTextureSubImage(_texture, mipLevel, x, y, 0, w, h, 1, format, type, (GLsizei)size, 0);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+			readBuffer.offset = 0;
+			readBuffer.pitch = pitch;
+			readBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			return readBuffer.fence ? true : false;
+		}
+
+		bool
+		OGLCoreTexture::mapReadBack(std::uint32_t slot, void** data, std::uint32_t* pitch) noexcept
+		{
+			assert(data && pitch);
+
+			if (slot >= _readBuffers.size() || !_readBuffers[slot].fence)
+				return false;
+
+			auto& readBuffer = _readBuffers[slot];
+
+			GLenum result = glClientWaitSync(readBuffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			while (result == GL_TIMEOUT_EXPIRED)
+				result = glClientWaitSync(readBuffer.fence, 0, 1000000);
+
+			glDeleteSync(readBuffer.fence);
+			readBuffer.fence = nullptr;
+
+			if (result == GL_WAIT_FAILED)
+				return false;
+
+			*data = glMapNamedBufferRange(readBuffer.buffer, 0, readBuffer.size, GL_MAP_READ_BIT);
+			*pitch = readBuffer.pitch;
+			return *data ? true : false;
+		}
+
+		void
+		OGLCoreTexture::unmapReadBack(std::uint32_t slot) noexcept
+		{
+			assert(slot < _readBuffers.size());
+			glUnmapNamedBuffer(_readBuffers[slot].buffer);
+		}
+
 		GLenum
 		OGLCoreTexture::getTarget() const noexcept
 		{
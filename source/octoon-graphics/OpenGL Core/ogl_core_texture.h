@@ -20,6 +20,12 @@ namespace octoon
 			bool map(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel, void** data) noexcept;
 			void unmap() noexcept;
 
+			bool update(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel, const void* data, std::uint32_t pitch) noexcept;
+
+			bool readBack(std::uint32_t slot, std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel) noexcept;
+			bool mapReadBack(std::uint32_t slot, void** data, std::uint32_t* pitch) noexcept;
+			void unmapReadBack(std::uint32_t slot) noexcept;
+
 			GLenum getTarget() const noexcept;
 			GLuint getInstanceID() const noexcept;
 
@@ -31,6 +37,16 @@ namespace octoon
 			bool applySamplerFilter(GraphicsSamplerFilter minFilter, GraphicsSamplerFilter magFilter) noexcept;
 			bool applySamplerAnis(GraphicsSamplerAnis anis) noexcept;
 
+		private:
+			struct ReadBuffer
+			{
+				GLuint buffer;
+				GLsizeiptr size;
+				GLsizeiptr offset;
+				GLuint pitch;
+				GLsync fence;
+			};
+
 		private:
 			friend class OGLDevice;
 			void setDevice(const GraphicsDevicePtr& device) noexcept;
@@ -43,6 +59,7 @@ namespace octoon
 			GLuint _texture;
 			GLuint _pboSize;
 			GLuint _upboSize;
+			std::vector<ReadBuffer> _readBuffers;
 			GraphicsTextureDesc _textureDesc;
 			GraphicsDeviceWeakPtr _device;
 		};
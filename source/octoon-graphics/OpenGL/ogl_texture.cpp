@@ -225,6 +225,16 @@ namespace octoon
 				glDeleteBuffers(1, &_upbo);
 				_upbo = GL_NONE;
 			}
+
+			for (auto& it : _readBuffers)
+			{
+				if (it.fence)
+					glDeleteSync(it.fence);
+				if (it.buffer != GL_NONE)
+					glDeleteBuffers(1, &it.buffer);
+			}
+
+			_readBuffers.clear();
 		}
 
 		bool
@@ -278,7 +288,139 @@ namespace octoon
 		OGLTexture::unmap() noexcept
 		{
 			glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbo);
-			glUnmapBuffer(_target);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+
+		bool
+		OGLTexture::update(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel, const void* data, std::uint32_t pitch) noexcept
+		{
+			assert(data);
+
+			GLenum format = OGLTypes::asTextureFormat(_textureDesc.getTexFormat());
+			GLenum type = OGLTypes::asTextureType(_textureDesc.getTexFormat());
+			if (format == GL_INVALID_ENUM || type == GL_INVALID_ENUM)
+			{
+				this->getDevice()->downcast<OGLDevice>()->message("Invalid texture format");
+				return false;
+			}
+
+			GLsizei num = OGLTypes::getFormatNum(format, type);
+			if (num == 0 || pitch % num != 0)
+				return false;
+
+			GLint oldAlignment = 1;
+			GLint oldRowLength = 0;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlignment);
+			glGetIntegerv(GL_UNPACK_ROW_LENGTH, &oldRowLength);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / num);
+
+			glBindTexture(_target, _texture);
+			glTexSubImage2D(_target, mipLevel, x, y, w, h, format, type, data);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlignment);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, oldRowLength);
+
+			return OGLCheck::checkError();
+		}
+
+		bool
+		OGLTexture::readBack(std::uint32_t slot, std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mipLevel) noexcept
+		{
+			GLenum format = OGLTypes::asTextureFormat(_textureDesc.getTexFormat());
+			GLenum type = OGLTypes::asTextureType(_textureDesc.getTexFormat());
+			if (format == GL_INVALID_ENUM || type == GL_INVALID_ENUM)
+			{
+				this->getDevice()->downcast<OGLDevice>()->message("Invalid texture format");
+				return false;
+			}
+
+			if (type == GL_HALF_FLOAT)
+				type = GL_FLOAT;
+
+			GLsizei num = OGLTypes::getFormatNum(format, type);
+			if (num == 0)
+				return false;
+
+			GLuint width = std::max(1u, _textureDesc.getWidth() >> mipLevel);
+			GLuint height = std::max(1u, _textureDesc.getHeight() >> mipLevel);
+			if (x + w > width || y + h > height)
+				return false;
+
+			if (_readBuffers.size() <= slot)
+				_readBuffers.resize(slot + 1, ReadBuffer{ GL_NONE, 0, 0, 0, nullptr });
+
+			auto& readBuffer = _readBuffers[slot];
+			if (readBuffer.fence)
+			{
+				glDeleteSync(readBuffer.fence);
+				readBuffer.fence = nullptr;
+			}
+
+			if (readBuffer.buffer == GL_NONE)
+				glGenBuffers(1, &readBuffer.buffer);
+
+			// glGetTexImage has no region, the whole level is copied and the mapping starts at the region.
+			// Rows are packed with the default GL_PACK_ALIGNMENT of 4.
+			GLuint pitch = (width * num + 3) & ~3u;
+			GLsizeiptr size = (GLsizeiptr)pitch * height;
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readBuffer.buffer);
+
+			if (readBuffer.size < size)
+			{
+				glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+				readBuffer.size = size;
+			}
+
+			glBindTexture(_target, _texture);
+			glGetTexImage(_target, mipLevel, format, type, 0);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+			readBuffer.offset = (GLsizeiptr)pitch * y + x * num;
+			readBuffer.pitch = pitch;
+			readBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			return readBuffer.fence ? true : false;
+		}
+
+		bool
+		OGLTexture::mapReadBack(std::uint32_t slot, void** data, std::uint32_t* pitch) noexcept
+		{
+			assert(data && pitch);
+
+			if (slot >= _readBuffers.size() || !_readBuffers[slot].fence)
+				return false;
+
+			auto& readBuffer = _readBuffers[slot];
+
+			GLenum result = glClientWaitSync(readBuffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			while (result == GL_TIMEOUT_EXPIRED)
+				result = glClientWaitSync(readBuffer.fence, 0, 1000000);
+
+			glDeleteSync(readBuffer.fence);
+			readBuffer.fence = nullptr;
+
+			if (result == GL_WAIT_FAILED)
+				return false;
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readBuffer.buffer);
+			auto mapped = (std::uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readBuffer.size, GL_MAP_READ_BIT);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+			*data = mapped ? mapped + readBuffer.offset : nullptr;
+			*pitch = readBuffer.pitch;
+			return *data ? true : false;
+		}
+
+		void
+		OGLTexture::unmapReadBack(std::uint32_t slot) noexcept
+		{
+			assert(slot < _readBuffers.size());
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, _readBuffers[slot].buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
 		}
 
 		GLenum
@@ -1,5 +1,7 @@
 #include <octoon/image/image.h>
 #include <octoon/image/image_util.h>
+#include <octoon/image/image_converter.h>
+#include <octoon/image/image_compressor.h>
 #include <octoon/runtime/except.h>
 #include <octoon/io/fstream.h>
 
@@ -130,11 +132,15 @@ namespace octoon
 			case value_t::UScaled:
 			case value_t::SRGB:
 			case value_t::Float:
+			case value_t::UNorm5_6_5:
+			case value_t::UNorm5_5_5_1:
+			case value_t::UNorm1_5_5_5:
+			case value_t::UNorm2_10_10_10:
+			case value_t::UFloatB10G11R11Pack32:
+			case value_t::UFloatE5B9G9R9Pack32:
+			case value_t::D24UNormPack32:
 			{
-				auto channel = format.channel();
-				auto type_size = format.type_size();
-
-				std::uint32_t pixelSize = type_size * channel;
+				std::uint32_t pixelSize = format.pixel_size();
 
 				for (std::uint32_t mip = mipBase; mip < (mipBase + mipLevel); mip++)
 				{
@@ -169,15 +175,8 @@ namespace octoon
 				}
 			}
 			break;
-			case value_t::UNorm5_6_5:
-			case value_t::UNorm5_5_5_1:
-			case value_t::UNorm1_5_5_5:
-			case value_t::UNorm2_10_10_10:
-			case value_t::UFloatB10G11R11Pack32:
-			case value_t::UFloatE5B9G9R9Pack32:
 			case value_t::D16UNorm_S8UInt:
 			case value_t::D24UNorm_S8UInt:
-			case value_t::D24UNormPack32:
 			case value_t::D32_SFLOAT_S8UInt:
 			default:
 				throw runtime::not_implemented::create("Not supported yet.");
@@ -206,29 +205,24 @@ namespace octoon
 			assert(format != Format::Undefined);
 			assert(format >= Format::BeginRange && format <= Format::EndRange);
 
-			if (format_ != format)
-			{
-				if (!this->create(format, image.width(), image.height(), image.depth(), image.mipLevel(), image.layerLevel(), image.mipBase(), image.layerBase()))
-					return false;
+			if (this == &image)
+				return this->create(format, Image(image));
 
-				if (format_ == Format::R32G32B32SFloat && format == Format::R8G8B8UInt)
-					rgb32f_to_rgb8uint(image, *this);
-				else if (format_ == Format::R32G32B32A32SFloat && format == Format::R8G8B8A8UInt)
-					rgba32f_to_rgba8uint(image, *this);
-				else if (format_ == Format::R64G64B64A64SFloat && format == Format::R8G8B8UInt)
-					rgb64f_to_rgb8uint(image, *this);
-				else if (format_ == Format::R64G64B64A64SFloat && format == Format::R8G8B8A8UInt)
-					rgba64f_to_rgba8uint(image, *this);
-				else if (format_ == Format::R32G32B32SFloat && format == Format::R8G8B8SInt)
-					rgb32f_to_rgb8sint(image, *this);
-				else if (format_ == Format::R32G32B32A32SFloat && format == Format::R8G8B8A8SInt)
-					rgba32f_to_rgba8sint(image, *this);
-				else if (format_ == Format::R64G64B64A64SFloat && format == Format::R8G8B8SInt)
-					rgb64f_to_rgb8sint(image, *this);
-				else if (format_ == Format::R64G64B64A64SFloat && format == Format::R8G8B8A8SInt)
-					rgba64f_to_rgba8sint(image, *this);
+			if (image.format() != format)
+			{
+				// Block formats go through the CPU codecs, compressing keeps the levels of the source.
+				if (BlockCompressor::isSupported(image.format()) && BlockCompressor::isSupported(format))
+				{
+					Image texels;
+					BlockDecompressor().decompress(image, texels);
+					BlockCompressor().compress(texels, *this, format, texels.mipLevel());
+				}
+				else if (BlockCompressor::isSupported(image.format()))
+					BlockDecompressor().decompress(image, *this, format);
+				else if (BlockCompressor::isSupported(format))
+					BlockCompressor().compress(image, *this, format, image.mipLevel());
 				else
-					throw runtime::not_implemented::create("not supported yet.");
+					FormatConverter(image.format(), format).convert(image, *this);
 
 				return true;
 			}
@@ -0,0 +1,568 @@
+#include <octoon/image/image_atlas.h>
+#include <octoon/runtime/except.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			bool overlaps(const AtlasRect& a, const AtlasRect& b) noexcept
+			{
+				return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+			}
+
+			bool touches(const AtlasRect& a, const AtlasRect& b) noexcept
+			{
+				return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+			}
+
+			bool contains(const AtlasRect& outer, const AtlasRect& inner) noexcept
+			{
+				return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+			}
+
+			AtlasRect unite(const AtlasRect& a, const AtlasRect& b) noexcept
+			{
+				std::uint32_t x = std::min(a.x, b.x);
+				std::uint32_t y = std::min(a.y, b.y);
+				return { x, y, std::max(a.x + a.width, b.x + b.width) - x, std::max(a.y + a.height, b.y + b.height) - y };
+			}
+		}
+
+		AtlasPacker::AtlasPacker(std::uint32_t width, std::uint32_t height, AtlasPacking packing) noexcept
+			: width_(width)
+			, height_(height)
+			, used_(0)
+			, packing_(packing)
+		{
+			this->reset();
+		}
+
+		AtlasPacker::~AtlasPacker() noexcept
+		{
+		}
+
+		void
+		AtlasPacker::reset() noexcept
+		{
+			used_ = 0;
+			skyline_.clear();
+			free_.clear();
+
+			if (packing_ == AtlasPacking::Skyline)
+				skyline_.push_back({ 0, 0, width_ });
+			else
+				free_.push_back({ 0, 0, width_, height_ });
+		}
+
+		bool
+		AtlasPacker::insert(std::uint32_t width, std::uint32_t height, AtlasRect& rect) noexcept
+		{
+			if (width == 0 || height == 0 || width > width_ || height > height_)
+				return false;
+
+			bool placed = packing_ == AtlasPacking::Skyline ? this->insertSkyline(width, height, rect) : this->insertMaxRects(width, height, rect);
+			if (placed)
+				used_ += (std::uint64_t)width * height;
+
+			return placed;
+		}
+
+		void
+		AtlasPacker::remove(const AtlasRect& rect) noexcept
+		{
+			used_ -= std::min(used_, (std::uint64_t)rect.width * rect.height);
+
+			if (packing_ != AtlasPacking::MaxRects)
+				return;
+
+			// Freed space joins free rectangles that share a whole edge with it, the rest waits for a repack.
+			AtlasRect merged = rect;
+			for (bool grown = true; grown;)
+			{
+				grown = false;
+				for (auto it = free_.begin(); it != free_.end(); ++it)
+				{
+					bool column = it->x == merged.x && it->width == merged.width && (it->y + it->height == merged.y || merged.y + merged.height == it->y);
+					bool row = it->y == merged.y && it->height == merged.height && (it->x + it->width == merged.x || merged.x + merged.width == it->x);
+					if (column || row)
+					{
+						merged = unite(merged, *it);
+						free_.erase(it);
+						grown = true;
+						break;
+					}
+				}
+			}
+
+			free_.erase(std::remove_if(free_.begin(), free_.end(), [&](const AtlasRect& it) { return contains(merged, it); }), free_.end());
+			free_.push_back(merged);
+		}
+
+		std::uint32_t
+		AtlasPacker::getWidth() const noexcept
+		{
+			return width_;
+		}
+
+		std::uint32_t
+		AtlasPacker::getHeight() const noexcept
+		{
+			return height_;
+		}
+
+		AtlasPacking
+		AtlasPacker::getPacking() const noexcept
+		{
+			return packing_;
+		}
+
+		std::uint64_t
+		AtlasPacker::getUsedArea() const noexcept
+		{
+			return used_;
+		}
+
+		bool
+		AtlasPacker::insertSkyline(std::uint32_t width, std::uint32_t height, AtlasRect& rect) noexcept
+		{
+			std::size_t best = skyline_.size();
+			std::uint32_t bestTop = height_ + 1;
+			std::uint32_t bestWidth = 0;
+			std::uint32_t bestY = 0;
+
+			for (std::size_t i = 0; i < skyline_.size(); i++)
+			{
+				if (skyline_[i].x + width > width_)
+					break;
+
+				// The rectangle rests on the highest node below its span.
+				std::uint32_t y = 0;
+				std::uint32_t covered = 0;
+				for (std::size_t j = i; covered < width; j++)
+				{
+					y = std::max(y, skyline_[j].y);
+					covered += skyline_[j].width;
+				}
+
+				if (y + height > height_)
+					continue;
+
+				if (y + height < bestTop || (y + height == bestTop && skyline_[i].width < bestWidth))
+				{
+					best = i;
+					bestTop = y + height;
+					bestWidth = skyline_[i].width;
+					bestY = y;
+				}
+			}
+
+			if (best == skyline_.size())
+				return false;
+
+			rect = { skyline_[best].x, bestY, width, height };
+
+			// The new node covers the span, nodes below it are cut back or dropped.
+			skyline_.insert(skyline_.begin() + best, { rect.x, bestTop, width });
+
+			std::uint32_t right = rect.x + width;
+			for (std::size_t i = best + 1; i < skyline_.size();)
+			{
+				auto& node = skyline_[i];
+				if (node.x >= right)
+					break;
+
+				std::uint32_t end = node.x + node.width;
+				if (end <= right)
+				{
+					skyline_.erase(skyline_.begin() + i);
+					continue;
+				}
+
+				node.width = end - right;
+				node.x = right;
+				break;
+			}
+
+			for (std::size_t i = 0; i + 1 < skyline_.size();)
+			{
+				if (skyline_[i].y == skyline_[i + 1].y)
+				{
+					skyline_[i].width += skyline_[i + 1].width;
+					skyline_.erase(skyline_.begin() + i + 1);
+				}
+				else
+				{
+					i++;
+				}
+			}
+
+			return true;
+		}
+
+		bool
+		AtlasPacker::insertMaxRects(std::uint32_t width, std::uint32_t height, AtlasRect& rect) noexcept
+		{
+			// Best short side fit, the long side breaks ties.
+			std::size_t best = free_.size();
+			std::uint32_t bestShort = 0xFFFFFFFF;
+			std::uint32_t bestLong = 0xFFFFFFFF;
+
+			for (std::size_t i = 0; i < free_.size(); i++)
+			{
+				auto& it = free_[i];
+				if (it.width < width || it.height < height)
+					continue;
+
+				std::uint32_t dx = it.width - width;
+				std::uint32_t dy = it.height - height;
+				std::uint32_t shortSide = std::min(dx, dy);
+				std::uint32_t longSide = std::max(dx, dy);
+
+				if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+				{
+					best = i;
+					bestShort = shortSide;
+					bestLong = longSide;
+				}
+			}
+
+			if (best == free_.size())
+				return false;
+
+			rect = { free_[best].x, free_[best].y, width, height };
+
+			// Every free rectangle the new one overlaps is replaced by the up to four parts around it.
+			std::vector<AtlasRect> parts;
+			for (std::size_t i = 0; i < free_.size();)
+			{
+				AtlasRect it = free_[i];
+				if (!overlaps(it, rect))
+				{
+					i++;
+					continue;
+				}
+
+				if (rect.x > it.x)
+					parts.push_back({ it.x, it.y, rect.x - it.x, it.height });
+				if (rect.x + rect.width < it.x + it.width)
+					parts.push_back({ rect.x + rect.width, it.y, it.x + it.width - rect.x - rect.width, it.height });
+				if (rect.y > it.y)
+					parts.push_back({ it.x, it.y, it.width, rect.y - it.y });
+				if (rect.y + rect.height < it.y + it.height)
+					parts.push_back({ it.x, rect.y + rect.height, it.width, it.y + it.height - rect.y - rect.height });
+
+				free_[i] = free_.back();
+				free_.pop_back();
+			}
+
+			// Parts inside another free rectangle are not maximal and are dropped.
+			for (std::size_t i = 0; i < parts.size(); i++)
+			{
+				bool inside = std::any_of(free_.begin(), free_.end(), [&](const AtlasRect& it) { return contains(it, parts[i]); });
+				for (std::size_t j = 0; j < parts.size() && !inside; j++)
+				{
+					if (j != i && contains(parts[j], parts[i]))
+						inside = !contains(parts[i], parts[j]) || j < i;
+				}
+
+				if (!inside)
+					free_.push_back(parts[i]);
+			}
+
+			return true;
+		}
+
+		ImageAtlas::ImageAtlas(const Format& format, std::uint32_t width, std::uint32_t height, std::uint32_t padding, std::uint32_t gutter, AtlasPacking packing) except
+			: image_(format, width, height)
+			, padding_(padding)
+			, gutter_(gutter)
+			, align_(1)
+			, generation_(0)
+			, nextId_(1)
+			, area_(0)
+			, packer_(0, 0, packing)
+		{
+			if (format.value_type() == value_t::Compressed)
+				throw runtime::runtime_error::create("ImageAtlas : block formats cannot be packed");
+
+			while (align_ * 2 <= gutter_)
+				align_ *= 2;
+
+			// Cells are packed in units of the alignment, so every cell starts on a multiple of it.
+			packer_ = AtlasPacker(width / align_, height / align_, packing);
+
+			std::memset((char*)image_.data(), 0, image_.size());
+		}
+
+		ImageAtlas::~ImageAtlas() noexcept
+		{
+		}
+
+		std::uint32_t
+		ImageAtlas::insert(const Image& image) except
+		{
+			if (image.format() != image_.format())
+				throw runtime::runtime_error::create("ImageAtlas : the image has another format than the atlas");
+
+			return this->insert(image.width(), image.height(), image.data(), (std::size_t)image.width() * image.format().pixel_size());
+		}
+
+		std::uint32_t
+		ImageAtlas::insert(std::uint32_t width, std::uint32_t height, const void* pixels, std::size_t pitch) noexcept
+		{
+			assert(pixels);
+
+			if (width == 0 || height == 0)
+				return 0;
+
+			std::uint32_t cellWidth = (width + gutter_ * 2 + padding_ + align_ - 1) / align_;
+			std::uint32_t cellHeight = (height + gutter_ * 2 + padding_ + align_ - 1) / align_;
+
+			AtlasRect cell;
+			if (!packer_.insert(cellWidth, cellHeight, cell))
+				return 0;
+
+			Entry entry;
+			entry.cell = { cell.x * align_, cell.y * align_, cell.width * align_, cell.height * align_ };
+			entry.rect = this->place(entry.cell, width, height);
+
+			this->write(entry.rect, pixels, pitch);
+			this->markDirty(entry.cell);
+
+			area_ += (std::uint64_t)width * height;
+			entries_[nextId_] = entry;
+
+			return nextId_++;
+		}
+
+		bool
+		ImageAtlas::remove(std::uint32_t id) noexcept
+		{
+			auto it = entries_.find(id);
+			if (it == entries_.end())
+				return false;
+
+			auto& cell = it->second.cell;
+			packer_.remove({ cell.x / align_, cell.y / align_, cell.width / align_, cell.height / align_ });
+
+			this->clear(cell);
+			this->markDirty(cell);
+
+			area_ -= (std::uint64_t)it->second.rect.width * it->second.rect.height;
+			entries_.erase(it);
+
+			return true;
+		}
+
+		bool
+		ImageAtlas::contains(std::uint32_t id) const noexcept
+		{
+			return entries_.find(id) != entries_.end();
+		}
+
+		bool
+		ImageAtlas::defragment() noexcept
+		{
+			std::vector<std::pair<std::uint32_t, Entry*>> order;
+			for (auto& it : entries_)
+				order.emplace_back(it.first, &it.second);
+
+			std::sort(order.begin(), order.end(), [](const std::pair<std::uint32_t, Entry*>& a, const std::pair<std::uint32_t, Entry*>& b)
+			{
+				auto& x = a.second->cell;
+				auto& y = b.second->cell;
+				if (std::max(x.width, x.height) != std::max(y.width, y.height))
+					return std::max(x.width, x.height) > std::max(y.width, y.height);
+				if (x.width * x.height != y.width * y.height)
+					return x.width * x.height > y.width * y.height;
+				return a.first < b.first;
+			});
+
+			// Places everything on a fresh packer first, so a failure leaves the atlas as it was.
+			AtlasPacker packer(packer_.getWidth(), packer_.getHeight(), packer_.getPacking());
+			std::vector<AtlasRect> cells(order.size());
+
+			for (std::size_t i = 0; i < order.size(); i++)
+			{
+				auto& cell = order[i].second->cell;
+				if (!packer.insert(cell.width / align_, cell.height / align_, cells[i]))
+					return false;
+			}
+
+			std::size_t pixelSize = image_.format().pixel_size();
+			std::size_t pitch = (std::size_t)image_.width() * pixelSize;
+			std::vector<char> packed(image_.size(), 0);
+
+			for (std::size_t i = 0; i < order.size(); i++)
+			{
+				auto& entry = *order[i].second;
+				AtlasRect cell = { cells[i].x * align_, cells[i].y * align_, entry.cell.width, entry.cell.height };
+
+				for (std::uint32_t y = 0; y < cell.height; y++)
+				{
+					auto src = image_.data() + (entry.cell.y + y) * pitch + entry.cell.x * pixelSize;
+					std::memcpy(packed.data() + (cell.y + y) * pitch + cell.x * pixelSize, src, cell.width * pixelSize);
+				}
+
+				entry.rect = this->place(cell, entry.rect.width, entry.rect.height);
+				entry.cell = cell;
+			}
+
+			std::memcpy((char*)image_.data(), packed.data(), packed.size());
+			packer_ = std::move(packer);
+
+			dirty_.clear();
+			dirty_.push_back({ 0, 0, image_.width(), image_.height() });
+			generation_++;
+
+			return true;
+		}
+
+		AtlasRect
+		ImageAtlas::getRect(std::uint32_t id) const noexcept
+		{
+			auto it = entries_.find(id);
+			return it != entries_.end() ? it->second.rect : AtlasRect{ 0, 0, 0, 0 };
+		}
+
+		math::float4
+		ImageAtlas::getTexcoords(std::uint32_t id) const noexcept
+		{
+			auto rect = this->getRect(id);
+			float w = (float)image_.width();
+			float h = (float)image_.height();
+			return math::float4(rect.x / w, rect.y / h, (rect.x + rect.width) / w, (rect.y + rect.height) / h);
+		}
+
+		const std::vector<AtlasRect>&
+		ImageAtlas::getDirtyRects() const noexcept
+		{
+			return dirty_;
+		}
+
+		void
+		ImageAtlas::clearDirtyRects() noexcept
+		{
+			dirty_.clear();
+		}
+
+		const Image&
+		ImageAtlas::getImage() const noexcept
+		{
+			return image_;
+		}
+
+		const Format&
+		ImageAtlas::format() const noexcept
+		{
+			return image_.format();
+		}
+
+		std::uint32_t
+		ImageAtlas::getPadding() const noexcept
+		{
+			return padding_;
+		}
+
+		std::uint32_t
+		ImageAtlas::getGutter() const noexcept
+		{
+			return gutter_;
+		}
+
+		std::uint32_t
+		ImageAtlas::getGeneration() const noexcept
+		{
+			return generation_;
+		}
+
+		std::size_t
+		ImageAtlas::getCount() const noexcept
+		{
+			return entries_.size();
+		}
+
+		float
+		ImageAtlas::getOccupancy() const noexcept
+		{
+			return (float)((double)area_ / ((double)image_.width() * image_.height()));
+		}
+
+		AtlasRect
+		ImageAtlas::place(const AtlasRect& cell, std::uint32_t width, std::uint32_t height) const noexcept
+		{
+			return { cell.x + gutter_, cell.y + gutter_, width, height };
+		}
+
+		void
+		ImageAtlas::write(const AtlasRect& rect, const void* pixels, std::size_t pitch) noexcept
+		{
+			std::size_t pixelSize = image_.format().pixel_size();
+			std::size_t stride = (std::size_t)image_.width() * pixelSize;
+			std::size_t length = (std::size_t)rect.width * pixelSize;
+
+			auto data = (char*)image_.data();
+
+			for (std::uint32_t y = 0; y < rect.height; y++)
+			{
+				auto row = data + (rect.y + y) * stride + rect.x * pixelSize;
+				std::memcpy(row, (const char*)pixels + y * pitch, length);
+
+				// The gutter repeats the first and last texel of the row.
+				for (std::uint32_t x = 1; x <= gutter_; x++)
+				{
+					std::memcpy(row - x * pixelSize, row, pixelSize);
+					std::memcpy(row + length + (x - 1) * pixelSize, row + length - pixelSize, pixelSize);
+				}
+			}
+
+			// And the first and last row with their gutters.
+			std::size_t span = length + gutter_ * 2 * pixelSize;
+			auto top = data + rect.y * stride + (rect.x - gutter_) * pixelSize;
+			auto bottom = top + (rect.height - 1) * stride;
+
+			for (std::uint32_t y = 1; y <= gutter_; y++)
+			{
+				std::memcpy(top - y * stride, top, span);
+				std::memcpy(bottom + y * stride, bottom, span);
+			}
+		}
+
+		void
+		ImageAtlas::clear(const AtlasRect& cell) noexcept
+		{
+			std::size_t pixelSize = image_.format().pixel_size();
+			std::size_t stride = (std::size_t)image_.width() * pixelSize;
+
+			for (std::uint32_t y = 0; y < cell.height; y++)
+				std::memset((char*)image_.data() + (cell.y + y) * stride + cell.x * pixelSize, 0, cell.width * pixelSize);
+		}
+
+		void
+		ImageAtlas::markDirty(AtlasRect rect) noexcept
+		{
+			// Rectangles that touch are joined, so neighbouring entries go up in one upload.
+			for (auto it = dirty_.begin(); it != dirty_.end();)
+			{
+				if (touches(*it, rect))
+				{
+					rect = unite(rect, *it);
+					dirty_.erase(it);
+					it = dirty_.begin();
+				}
+				else
+				{
+					++it;
+				}
+			}
+
+			dirty_.push_back(rect);
+		}
+	}
+}
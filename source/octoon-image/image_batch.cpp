@@ -0,0 +1,174 @@
+#include <octoon/image/image_batch.h>
+#include <octoon/io/fstream.h>
+#include <octoon/io/mapbuf.h>
+#include <octoon/io/vstream.h>
+#include <octoon/runtime/thread_pool.h>
+
+#include "image_all.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			class MappedStream final : public io::istream
+			{
+			public:
+				MappedStream() noexcept
+					: io::istream(&buf_)
+				{
+				}
+
+				bool open(const std::string& path) noexcept
+				{
+					if (!buf_.open(path, io::mapbuf::advice::sequential))
+						return false;
+
+					this->clear(io::ios_base::goodbit, io::ios_base::in);
+					return true;
+				}
+
+				void close() noexcept
+				{
+					buf_.close();
+				}
+
+			private:
+				io::mapbuf buf_;
+			};
+
+			// Streams a worker opens one file after another, so every file only costs the open.
+			struct Worker
+			{
+				MappedStream mapped;
+				io::ifstream file;
+				io::ivstream virtual_;
+
+				istream* open(const std::string& path) noexcept
+				{
+					if (mapped.open(path))
+						return &mapped;
+
+					file.close();
+					if (file.open(path.c_str()).good())
+						return &file;
+
+					return nullptr;
+				}
+
+				istream* open(const io::Orl& orl) noexcept
+				{
+					virtual_.close();
+					if (virtual_.open(orl).good())
+						return &virtual_;
+
+					return nullptr;
+				}
+
+				void close() noexcept
+				{
+					mapped.close();
+					file.close();
+					virtual_.close();
+				}
+			};
+
+			std::string
+			extension(const std::string& path) noexcept
+			{
+				auto dot = path.find_last_of('.');
+				if (dot == std::string::npos || path.find_first_of("/\\", dot) != std::string::npos)
+					return std::string();
+
+				std::string type = path.substr(dot + 1);
+				for (auto& ch : type)
+					ch = (char)std::tolower((unsigned char)ch);
+
+				return type;
+			}
+
+			template<typename Source>
+			ImagePtr
+			loadImage(Worker& worker, const Source& source, const std::string& path) noexcept
+			{
+				auto type = extension(path);
+				auto handler = type.empty() ? nullptr : findHandler(type.c_str());
+				if (handler)
+				{
+					auto image = std::make_shared<Image>();
+					auto stream = worker.open(source);
+					if (stream && handler->doLoad(*stream, *image))
+						return image;
+				}
+
+				// A file named after another format is found by its contents.
+				auto stream = worker.open(source);
+				if (stream)
+				{
+					auto image = std::make_shared<Image>();
+					auto detected = findHandler(*stream);
+					if (detected && detected != handler && detected->doLoad(*stream, *image))
+						return image;
+				}
+
+				return nullptr;
+			}
+
+			template<typename Source, typename Path>
+			std::vector<ImagePtr>
+			loadAll(runtime::ThreadPool& pool, const std::vector<Source>& sources, Path&& path) noexcept
+			{
+				std::vector<ImagePtr> images(sources.size());
+				std::atomic<std::size_t> next(0);
+
+				std::size_t workers = std::min(sources.size(), pool.size() + 1);
+
+				pool.parallel_for(0, workers, 1, [&](std::size_t, std::size_t)
+				{
+					Worker worker;
+
+					for (std::size_t i = next++; i < sources.size(); i = next++)
+						images[i] = loadImage(worker, sources[i], path(sources[i]));
+
+					worker.close();
+				});
+
+				return images;
+			}
+		}
+
+		BatchLoader::BatchLoader(std::size_t threads) noexcept
+			: pool_(threads ? std::make_unique<runtime::ThreadPool>(threads - 1) : nullptr)
+		{
+		}
+
+		BatchLoader::~BatchLoader() noexcept
+		{
+		}
+
+		std::size_t
+		BatchLoader::getThreads() const noexcept
+		{
+			return (pool_ ? pool_->size() : runtime::ThreadPool::instance()->size()) + 1;
+		}
+
+		std::vector<ImagePtr>
+		BatchLoader::load(const std::vector<std::string>& paths) const noexcept
+		{
+			auto pool = pool_ ? pool_.get() : runtime::ThreadPool::instance();
+			return loadAll(*pool, paths, [](const std::string& path) -> const std::string& { return path; });
+		}
+
+		std::vector<ImagePtr>
+		BatchLoader::load(const std::vector<io::Orl>& orls) const noexcept
+		{
+			auto pool = pool_ ? pool_.get() : runtime::ThreadPool::instance();
+			return loadAll(*pool, orls, [](const io::Orl& orl) -> const std::string& { return orl.path(); });
+		}
+	}
+}
@@ -0,0 +1,1995 @@
+#include "image_bcn.h"
+#include "image_codec.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#	include <tmmintrin.h>
+#endif
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			constexpr std::uint8_t Weights2[4] = { 0, 21, 43, 64 };
+			constexpr std::uint8_t Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+			constexpr std::uint8_t Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			// Subset of every texel of the BC6H and BC7 partitions, one bit per texel for two subsets.
+			constexpr std::uint16_t Partitions2[64] =
+			{
+				0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+				0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+				0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+				0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+				0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+				0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+				0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+				0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+			};
+
+			// Two bits per texel for three subsets.
+			constexpr std::uint32_t Partitions3[64] =
+			{
+				0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+				0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+				0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+				0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+				0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+				0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+				0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+				0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+			};
+
+			// Texels whose index drops its top bit, besides texel 0 of the first subset.
+			constexpr std::uint8_t Anchors2[64] =
+			{
+				15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+				15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+				15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+				 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+			};
+
+			constexpr std::uint8_t Anchors3[2][64] =
+			{
+				{
+					 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+					 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+					 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+					 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+				},
+				{
+					15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+					15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+					15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+					15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+				},
+			};
+
+			struct BC7Mode
+			{
+				std::uint8_t subsets;
+				std::uint8_t partitionBits;
+				std::uint8_t rotationBits;
+				std::uint8_t selectionBits;
+				std::uint8_t colorBits;
+				std::uint8_t alphaBits;
+				std::uint8_t endpointPBits;
+				std::uint8_t sharedPBits;
+				std::uint8_t indexBits;
+				std::uint8_t indexBits2;
+			};
+
+			constexpr BC7Mode BC7Modes[8] =
+			{
+				{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+				{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+				{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+				{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+				{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+				{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+				{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+				{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+			};
+
+			// Endpoint fields of the BC6H header, W and X belong to the first region, Y and Z to the second.
+			enum BC6Field : std::uint8_t
+			{
+				RW, GW, BW, RX, GX, BX, RY, GY, BY, RZ, GZ, BZ, D,
+			};
+
+			// Bits first to last of a field in the order they are stored, some modes store them backwards.
+			struct BC6Run
+			{
+				std::uint8_t field;
+				std::uint8_t first;
+				std::uint8_t last;
+			};
+
+			struct BC6Mode
+			{
+				std::uint8_t value;
+				std::uint8_t modeBits;
+				std::uint8_t regions;
+				bool transformed;
+				std::uint8_t endpointBits;
+				std::uint8_t deltaBits[3];
+				BC6Run runs[24];
+			};
+
+			constexpr BC6Mode BC6Modes[14] =
+			{
+				{ 0x00, 2, 2, true, 10, { 5, 5, 5 }, { { GY, 4, 4 }, { BY, 4, 4 }, { BZ, 4, 4 }, { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { D, 0, 4 } } },
+				{ 0x01, 2, 2, true, 7, { 6, 6, 6 }, { { GY, 5, 5 }, { GZ, 4, 5 }, { RW, 0, 6 }, { BZ, 0, 1 }, { BY, 4, 4 }, { GW, 0, 6 }, { BY, 5, 5 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 0, 6 }, { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 5 }, { GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 5 }, { RZ, 0, 5 }, { D, 0, 4 } } },
+				{ 0x02, 5, 2, true, 11, { 5, 4, 4 }, { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 4 }, { RW, 10, 10 }, { GY, 0, 3 }, { GX, 0, 3 }, { GW, 10, 10 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 3 }, { BW, 10, 10 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { D, 0, 4 } } },
+				{ 0x06, 5, 2, true, 11, { 4, 5, 4 }, { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 10, 10 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { GW, 10, 10 }, { GZ, 0, 3 }, { BX, 0, 3 }, { BW, 10, 10 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 3 }, { BZ, 0, 0 }, { BZ, 2, 2 }, { RZ, 0, 3 }, { GY, 4, 4 }, { BZ, 3, 3 }, { D, 0, 4 } } },
+				{ 0x0A, 5, 2, true, 11, { 4, 4, 5 }, { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 10, 10 }, { BY, 4, 4 }, { GY, 0, 3 }, { GX, 0, 3 }, { GW, 10, 10 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BW, 10, 10 }, { BY, 0, 3 }, { RY, 0, 3 }, { BZ, 1, 2 }, { RZ, 0, 3 }, { BZ, 4, 4 }, { BZ, 3, 3 }, { D, 0, 4 } } },
+				{ 0x0E, 5, 2, true, 9, { 5, 5, 5 }, { { RW, 0, 8 }, { BY, 4, 4 }, { GW, 0, 8 }, { GY, 4, 4 }, { BW, 0, 8 }, { BZ, 4, 4 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { D, 0, 4 } } },
+				{ 0x12, 5, 2, true, 8, { 6, 5, 5 }, { { RW, 0, 7 }, { GZ, 4, 4 }, { BY, 4, 4 }, { GW, 0, 7 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 0, 7 }, { BZ, 3, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 5 }, { RZ, 0, 5 }, { D, 0, 4 } } },
+				{ 0x16, 5, 2, true, 8, { 5, 6, 5 }, { { RW, 0, 7 }, { BZ, 0, 0 }, { BY, 4, 4 }, { GW, 0, 7 }, { GY, 5, 5 }, { GY, 4, 4 }, { BW, 0, 7 }, { GZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 5 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { D, 0, 4 } } },
+				{ 0x1A, 5, 2, true, 8, { 5, 5, 6 }, { { RW, 0, 7 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 0, 7 }, { BY, 5, 5 }, { GY, 4, 4 }, { BW, 0, 7 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { D, 0, 4 } } },
+				{ 0x1E, 5, 2, false, 6, { 6, 6, 6 }, { { RW, 0, 5 }, { GZ, 4, 4 }, { BZ, 0, 1 }, { BY, 4, 4 }, { GW, 0, 5 }, { GY, 5, 5 }, { BY, 5, 5 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 0, 5 }, { GZ, 5, 5 }, { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 5 }, { GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 5 }, { RZ, 0, 5 }, { D, 0, 4 } } },
+				{ 0x03, 5, 1, false, 10, { 10, 10, 10 }, { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 9 }, { GX, 0, 9 }, { BX, 0, 9 } } },
+				{ 0x07, 5, 1, true, 11, { 9, 9, 9 }, { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 8 }, { RW, 10, 10 }, { GX, 0, 8 }, { GW, 10, 10 }, { BX, 0, 8 }, { BW, 10, 10 } } },
+				{ 0x0B, 5, 1, true, 12, { 8, 8, 8 }, { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 7 }, { RW, 11, 10 }, { GX, 0, 7 }, { GW, 11, 10 }, { BX, 0, 7 }, { BW, 11, 10 } } },
+				{ 0x0F, 5, 1, true, 16, { 4, 4, 4 }, { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 15, 10 }, { GX, 0, 3 }, { GW, 15, 10 }, { BX, 0, 3 }, { BW, 15, 10 } } },
+			};
+
+			class BitWriter
+			{
+			public:
+				BitWriter(std::uint8_t* data, std::size_t size) noexcept
+					: data_(data)
+					, offset_(0)
+				{
+					std::memset(data, 0, size);
+				}
+
+				void write(std::uint32_t value, std::uint32_t bits) noexcept
+				{
+					for (std::uint32_t i = 0; i < bits; i++, offset_++)
+						data_[offset_ >> 3] |= ((value >> i) & 1) << (offset_ & 7);
+				}
+
+			private:
+				std::uint8_t* data_;
+				std::uint32_t offset_;
+			};
+
+			// Reads the 128 bits of a block from two words, lowest bit first.
+			class BitReader
+			{
+			public:
+				BitReader(const std::uint8_t* data) noexcept
+				{
+					lo_ = hi_ = 0;
+					for (std::uint8_t i = 0; i < 8; i++)
+					{
+						lo_ |= (std::uint64_t)data[i] << (i * 8);
+						hi_ |= (std::uint64_t)data[8 + i] << (i * 8);
+					}
+				}
+
+				std::uint32_t read(std::uint32_t bits) noexcept
+				{
+					if (bits == 0)
+						return 0;
+
+					std::uint32_t value = (std::uint32_t)(lo_ & ((1ull << bits) - 1));
+					lo_ = (lo_ >> bits) | (hi_ << (64 - bits));
+					hi_ >>= bits;
+					return value;
+				}
+
+			private:
+				std::uint64_t lo_;
+				std::uint64_t hi_;
+			};
+
+			int interpolate(int a, int b, int weight) noexcept
+			{
+				return ((64 - weight) * a + weight * b + 32) >> 6;
+			}
+
+			int signExtend(int value, int bits) noexcept
+			{
+				return (value ^ (1 << (bits - 1))) - (1 << (bits - 1));
+			}
+
+			// Ends of the line through the texels in mask that covers all of their projections. Falls back
+			// to the mean when the texels do not spread out.
+			void fitLine(const float texels[16][4], std::uint8_t channels, std::uint16_t mask, float lo[4], float hi[4]) noexcept
+			{
+				float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				float count = 0.0f;
+
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					if (mask & (1 << i))
+					{
+						for (std::uint8_t c = 0; c < channels; c++)
+							mean[c] += texels[i][c];
+						count += 1.0f;
+					}
+				}
+
+				for (std::uint8_t c = 0; c < channels; c++)
+				{
+					mean[c] = count > 0.0f ? mean[c] / count : 0.0f;
+					lo[c] = hi[c] = mean[c];
+				}
+
+				float covariance[4][4] = {};
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					if (mask & (1 << i))
+					{
+						for (std::uint8_t a = 0; a < channels; a++)
+						{
+							for (std::uint8_t b = a; b < channels; b++)
+								covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+						}
+					}
+				}
+
+				std::uint8_t largest = 0;
+				for (std::uint8_t a = 0; a < channels; a++)
+				{
+					for (std::uint8_t b = 0; b < a; b++)
+						covariance[a][b] = covariance[b][a];
+					if (covariance[a][a] > covariance[largest][largest])
+						largest = a;
+				}
+
+				if (covariance[largest][largest] < 1e-8f)
+					return;
+
+				// Power iteration from the row of the widest channel, which is never orthogonal to the axis.
+				float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (std::uint8_t c = 0; c < channels; c++)
+					axis[c] = covariance[largest][c];
+
+				for (int iteration = 0; iteration < 8; iteration++)
+				{
+					float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					float length = 0.0f;
+					for (std::uint8_t a = 0; a < channels; a++)
+					{
+						for (std::uint8_t b = 0; b < channels; b++)
+							next[a] += covariance[a][b] * axis[b];
+						length = std::max(length, std::abs(next[a]));
+					}
+
+					if (length < 1e-12f)
+						break;
+
+					for (std::uint8_t c = 0; c < channels; c++)
+						axis[c] = next[c] / length;
+				}
+
+				float length = 0.0f;
+				for (std::uint8_t c = 0; c < channels; c++)
+					length += axis[c] * axis[c];
+
+				if (length < 1e-12f)
+					return;
+
+				for (std::uint8_t c = 0; c < channels; c++)
+					axis[c] /= std::sqrt(length);
+
+				float minimum = 0.0f;
+				float maximum = 0.0f;
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					if (mask & (1 << i))
+					{
+						float t = 0.0f;
+						for (std::uint8_t c = 0; c < channels; c++)
+							t += (texels[i][c] - mean[c]) * axis[c];
+						minimum = std::min(minimum, t);
+						maximum = std::max(maximum, t);
+					}
+				}
+
+				for (std::uint8_t c = 0; c < channels; c++)
+				{
+					lo[c] = mean[c] + axis[c] * minimum;
+					hi[c] = mean[c] + axis[c] * maximum;
+				}
+			}
+
+			// Least squares endpoints for fixed indices, weight[index] is the share of the second endpoint.
+			bool solveEndpoints(const float texels[16][4], std::uint8_t channels, std::uint16_t mask, const std::uint8_t indices[16], const float* weight, float e0[4], float e1[4]) noexcept
+			{
+				float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+				float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					if (mask & (1 << i))
+					{
+						float b = weight[indices[i]];
+						float a = 1.0f - b;
+
+						aa += a * a;
+						bb += b * b;
+						ab += a * b;
+
+						for (std::uint8_t c = 0; c < channels; c++)
+						{
+							ax[c] += a * texels[i][c];
+							bx[c] += b * texels[i][c];
+						}
+					}
+				}
+
+				float det = aa * bb - ab * ab;
+				if (std::abs(det) < 1e-6f)
+					return false;
+
+				for (std::uint8_t c = 0; c < channels; c++)
+				{
+					e0[c] = (ax[c] * bb - bx[c] * ab) / det;
+					e1[c] = (bx[c] * aa - ax[c] * ab) / det;
+				}
+
+				return true;
+			}
+
+			void toFloats(const std::uint8_t texels[64], float out[16][4]) noexcept
+			{
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					for (std::uint8_t c = 0; c < 4; c++)
+						out[i][c] = texels[i * 4 + c];
+				}
+			}
+
+			// BC1 color endpoints, 565 packed.
+			struct ColorEndpoints
+			{
+				std::uint16_t c0;
+				std::uint16_t c1;
+			};
+
+			void unpack565(std::uint16_t color, int rgb[3]) noexcept
+			{
+				int r = (color >> 11) & 31;
+				int g = (color >> 5) & 63;
+				int b = color & 31;
+
+				rgb[0] = (r << 3) | (r >> 2);
+				rgb[1] = (g << 2) | (g >> 4);
+				rgb[2] = (b << 3) | (b >> 2);
+			}
+
+			std::uint16_t pack565(const float rgb[3]) noexcept
+			{
+				int r = (int)std::lround(std::min(std::max(rgb[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+				int g = (int)std::lround(std::min(std::max(rgb[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+				int b = (int)std::lround(std::min(std::max(rgb[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+
+				return (std::uint16_t)((r << 11) | (g << 5) | b);
+			}
+
+			void colorPalette(std::uint16_t c0, std::uint16_t c1, bool three, int palette[4][3]) noexcept
+			{
+				unpack565(c0, palette[0]);
+				unpack565(c1, palette[1]);
+
+				for (std::uint8_t c = 0; c < 3; c++)
+				{
+					if (three)
+					{
+						palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+						palette[3][c] = 0;
+					}
+					else
+					{
+						palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+						palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+					}
+				}
+			}
+
+			// Palette entries in the order of their share of c1, the last entry of the three color mode is left out.
+			constexpr std::uint8_t ColorOrder4[4] = { 0, 2, 3, 1 };
+			constexpr std::uint8_t ColorOrder3[3] = { 0, 2, 1 };
+			constexpr float ColorWeight4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			constexpr float ColorWeight3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+			int fitColors(const float texels[16][4], std::uint16_t mask, const ColorEndpoints& endpoints, bool three, std::uint8_t indices[16]) noexcept
+			{
+				int palette[4][3];
+				colorPalette(endpoints.c0, endpoints.c1, three, palette);
+
+				int error = 0;
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					if (!(mask & (1 << i)))
+					{
+						indices[i] = 3;
+						continue;
+					}
+
+					int best = 0x7fffffff;
+					for (std::uint8_t k = 0; k < (three ? 3 : 4); k++)
+					{
+						int dr = palette[k][0] - (int)texels[i][0];
+						int dg = palette[k][1] - (int)texels[i][1];
+						int db = palette[k][2] - (int)texels[i][2];
+						int d = dr * dr + dg * dg + db * db;
+						if (d < best)
+						{
+							best = d;
+							indices[i] = k;
+						}
+					}
+
+					error += best;
+				}
+
+				return error;
+			}
+
+			// Endpoints that reproduce one color best through the first interpolated entry.
+			struct SingleColorTables
+			{
+				std::uint8_t match5[256][2];
+				std::uint8_t match6[256][2];
+
+				SingleColorTables() noexcept
+				{
+					build(match5, 5);
+					build(match6, 6);
+				}
+
+				static void build(std::uint8_t table[256][2], int bits) noexcept
+				{
+					int levels = 1 << bits;
+					for (int v = 0; v < 256; v++)
+					{
+						int best = 256;
+						for (int a = 0; a < levels; a++)
+						{
+							int ea = bits == 5 ? (a << 3) | (a >> 2) : (a << 2) | (a >> 4);
+							for (int b = 0; b < levels; b++)
+							{
+								int eb = bits == 5 ? (b << 3) | (b >> 2) : (b << 2) | (b >> 4);
+								int error = std::abs((2 * ea + eb) / 3 - v);
+								if (error < best)
+								{
+									best = error;
+									table[v][0] = (std::uint8_t)a;
+									table[v][1] = (std::uint8_t)b;
+								}
+							}
+						}
+					}
+				}
+			};
+
+			const SingleColorTables& singleColorTables() noexcept
+			{
+				static const SingleColorTables tables;
+				return tables;
+			}
+
+			void writeColor(std::uint8_t block[8], ColorEndpoints endpoints, std::uint8_t indices[16], bool three) noexcept
+			{
+				if (three)
+				{
+					if (endpoints.c0 > endpoints.c1)
+					{
+						std::swap(endpoints.c0, endpoints.c1);
+						for (std::uint8_t i = 0; i < 16; i++)
+						{
+							if (indices[i] < 2)
+								indices[i] ^= 1;
+						}
+					}
+				}
+				else
+				{
+					if (endpoints.c0 < endpoints.c1)
+					{
+						std::swap(endpoints.c0, endpoints.c1);
+						for (std::uint8_t i = 0; i < 16; i++)
+							indices[i] ^= 1;
+					}
+					else if (endpoints.c0 == endpoints.c1)
+					{
+						// Equal endpoints read as the three color mode, whose last entry is black.
+						std::memset(indices, 0, 16);
+					}
+				}
+
+				std::uint32_t bits = 0;
+				for (std::uint8_t i = 0; i < 16; i++)
+					bits |= (std::uint32_t)indices[i] << (i * 2);
+
+				block[0] = (std::uint8_t)(endpoints.c0);
+				block[1] = (std::uint8_t)(endpoints.c0 >> 8);
+				block[2] = (std::uint8_t)(endpoints.c1);
+				block[3] = (std::uint8_t)(endpoints.c1 >> 8);
+				block[4] = (std::uint8_t)(bits);
+				block[5] = (std::uint8_t)(bits >> 8);
+				block[6] = (std::uint8_t)(bits >> 16);
+				block[7] = (std::uint8_t)(bits >> 24);
+			}
+
+			// Texels outside mask are transparent and only exist in the three color mode.
+			void encodeColor(const float texels[16][4], std::uint16_t mask, std::uint8_t block[8], bool three, bool high) noexcept
+			{
+				std::uint8_t indices[16];
+
+				if (mask == 0)
+				{
+					ColorEndpoints endpoints = { 0, 0 };
+					std::memset(indices, 3, sizeof(indices));
+					writeColor(block, endpoints, indices, true);
+					return;
+				}
+
+				std::uint8_t first = 0;
+				while (!(mask & (1 << first)))
+					first++;
+
+				bool solid = true;
+				for (std::uint8_t i = first + 1; i < 16 && solid; i++)
+				{
+					if (mask & (1 << i))
+						solid = texels[i][0] == texels[first][0] && texels[i][1] == texels[first][1] && texels[i][2] == texels[first][2];
+				}
+
+				if (solid && !three)
+				{
+					auto& tables = singleColorTables();
+					int r = (int)texels[first][0];
+					int g = (int)texels[first][1];
+					int b = (int)texels[first][2];
+
+					ColorEndpoints endpoints;
+					endpoints.c0 = (std::uint16_t)((tables.match5[r][0] << 11) | (tables.match6[g][0] << 5) | tables.match5[b][0]);
+					endpoints.c1 = (std::uint16_t)((tables.match5[r][1] << 11) | (tables.match6[g][1] << 5) | tables.match5[b][1]);
+
+					std::memset(indices, 2, sizeof(indices));
+					writeColor(block, endpoints, indices, false);
+					return;
+				}
+
+				float lo[4], hi[4];
+				fitLine(texels, 3, mask, lo, hi);
+
+				ColorEndpoints best = { pack565(hi), pack565(lo) };
+				std::uint8_t bestIndices[16];
+				int bestError = fitColors(texels, mask, best, three, bestIndices);
+
+				const float* weight = three ? ColorWeight3 : ColorWeight4;
+
+				for (int iteration = 0; iteration < (high ? 8 : 1); iteration++)
+				{
+					float e0[4], e1[4];
+					std::uint16_t solveMask = mask;
+					if (three)
+					{
+						// Entry 3 is black in the three color mode and does not depend on the endpoints.
+						for (std::uint8_t i = 0; i < 16; i++)
+						{
+							if (bestIndices[i] == 3)
+								solveMask &= ~(1 << i);
+						}
+					}
+
+					if (!solveEndpoints(texels, 3, solveMask, bestIndices, weight, e0, e1))
+						break;
+
+					ColorEndpoints candidate = { pack565(e0), pack565(e1) };
+					if (candidate.c0 == best.c0 && candidate.c1 == best.c1)
+						break;
+
+					int error = fitColors(texels, mask, candidate, three, indices);
+					if (error >= bestError)
+						break;
+
+					best = candidate;
+					bestError = error;
+					std::memcpy(bestIndices, indices, sizeof(indices));
+				}
+
+				if (high)
+				{
+					// Steps every channel of both endpoints by one level while that lowers the error.
+					static const std::uint16_t steps[3] = { 1 << 11, 1 << 5, 1 };
+					static const std::uint16_t limits[3] = { 31 << 11, 63 << 5, 31 };
+
+					bool improved = true;
+					for (int pass = 0; pass < 4 && improved; pass++)
+					{
+						improved = false;
+						for (std::uint8_t endpoint = 0; endpoint < 2; endpoint++)
+						{
+							for (std::uint8_t c = 0; c < 3; c++)
+							{
+								for (int direction = -1; direction <= 1; direction += 2)
+								{
+									ColorEndpoints candidate = best;
+									std::uint16_t& value = endpoint ? candidate.c1 : candidate.c0;
+									std::uint16_t field = value & limits[c];
+
+									if (direction < 0 && field == 0) continue;
+									if (direction > 0 && field == limits[c]) continue;
+
+									value = (std::uint16_t)(direction < 0 ? value - steps[c] : value + steps[c]);
+
+									int error = fitColors(texels, mask, candidate, three, indices);
+									if (error < bestError)
+									{
+										best = candidate;
+										bestError = error;
+										std::memcpy(bestIndices, indices, sizeof(indices));
+										improved = true;
+									}
+								}
+							}
+						}
+					}
+				}
+
+				writeColor(block, best, bestIndices, three);
+			}
+
+			// Single channel blocks of BC3 alpha, BC4 and BC5, codes are 8 bit unsigned or signed.
+			float alphaValue(int code, bool snorm) noexcept
+			{
+				return snorm ? std::max(code, -127) / 127.0f : code / 255.0f;
+			}
+
+			void alphaPalette(int e0, int e1, bool snorm, float palette[8]) noexcept
+			{
+				float a = alphaValue(e0, snorm);
+				float b = alphaValue(e1, snorm);
+
+				palette[0] = a;
+				palette[1] = b;
+
+				if (e0 > e1)
+				{
+					for (int i = 1; i < 7; i++)
+						palette[i + 1] = (a * (7 - i) + b * i) / 7.0f;
+				}
+				else
+				{
+					for (int i = 1; i < 5; i++)
+						palette[i + 1] = (a * (5 - i) + b * i) / 5.0f;
+					palette[6] = snorm ? -1.0f : 0.0f;
+					palette[7] = 1.0f;
+				}
+			}
+
+			float fitAlpha(const float values[16], int e0, int e1, bool snorm, std::uint64_t& indices) noexcept
+			{
+				float palette[8];
+				alphaPalette(e0, e1, snorm, palette);
+
+				float error = 0.0f;
+				indices = 0;
+
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					float best = 1e30f;
+					std::uint64_t index = 0;
+					for (std::uint8_t k = 0; k < 8; k++)
+					{
+						float d = (palette[k] - values[i]) * (palette[k] - values[i]);
+						if (d < best)
+						{
+							best = d;
+							index = k;
+						}
+					}
+
+					indices |= index << (i * 3);
+					error += best;
+				}
+
+				return error;
+			}
+
+			void encodeAlpha(const float input[16], std::uint8_t block[8], bool snorm, bool high) noexcept
+			{
+				float lower = snorm ? -1.0f : 0.0f;
+				float scale = snorm ? 127.0f : 255.0f;
+				int minCode = snorm ? -127 : 0;
+				int maxCode = snorm ? 127 : 255;
+
+				float values[16];
+				float minimum = 1.0f;
+				float maximum = lower;
+
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					float v = input[i];
+					v = v > lower ? v : lower;
+					v = v < 1.0f ? v : 1.0f;
+					values[i] = v;
+					minimum = std::min(minimum, v);
+					maximum = std::max(maximum, v);
+				}
+
+				int e0 = std::min((int)std::ceil(maximum * scale - 1e-4f), maxCode);
+				int e1 = std::max((int)std::floor(minimum * scale + 1e-4f), minCode);
+
+				std::uint64_t indices;
+				float error = fitAlpha(values, e0, e1, snorm, indices);
+
+				if (high)
+				{
+					// The eight value mode with the ends pulled inwards or pushed outwards.
+					int base0 = e0, base1 = e1;
+					for (int d0 = -2; d0 <= 2; d0++)
+					{
+						for (int d1 = -2; d1 <= 2; d1++)
+						{
+							int c0 = std::min(std::max(base0 + d0, minCode), maxCode);
+							int c1 = std::min(std::max(base1 + d1, minCode), maxCode);
+							if (c0 <= c1 || (c0 == e0 && c1 == e1))
+								continue;
+
+							std::uint64_t candidate;
+							float candidateError = fitAlpha(values, c0, c1, snorm, candidate);
+							if (candidateError < error)
+							{
+								error = candidateError;
+								indices = candidate;
+								e0 = c0;
+								e1 = c1;
+							}
+						}
+					}
+
+					// The six value mode spans the texels between the extremes, which it stores exactly.
+					float innerMin = 1.0f;
+					float innerMax = lower;
+					for (std::uint8_t i = 0; i < 16; i++)
+					{
+						if (values[i] > lower && values[i] < 1.0f)
+						{
+							innerMin = std::min(innerMin, values[i]);
+							innerMax = std::max(innerMax, values[i]);
+						}
+					}
+
+					if (innerMin <= innerMax)
+					{
+						int base0 = (int)std::floor(innerMin * scale + 1e-4f);
+						int base1 = (int)std::ceil(innerMax * scale - 1e-4f);
+
+						for (int d0 = -1; d0 <= 1; d0++)
+						{
+							for (int d1 = -1; d1 <= 1; d1++)
+							{
+								int c0 = std::min(std::max(base0 + d0, minCode), maxCode);
+								int c1 = std::min(std::max(base1 + d1, minCode), maxCode);
+								if (c0 > c1)
+									continue;
+
+								std::uint64_t candidate;
+								float candidateError = fitAlpha(values, c0, c1, snorm, candidate);
+								if (candidateError < error)
+								{
+									error = candidateError;
+									indices = candidate;
+									e0 = c0;
+									e1 = c1;
+								}
+							}
+						}
+					}
+				}
+
+				block[0] = (std::uint8_t)e0;
+				block[1] = (std::uint8_t)e1;
+				for (std::uint8_t i = 0; i < 6; i++)
+					block[2 + i] = (std::uint8_t)(indices >> (i * 8));
+			}
+
+			void decodeAlpha(const std::uint8_t block[8], float values[16], bool snorm) noexcept
+			{
+				int e0 = snorm ? (int)(std::int8_t)block[0] : block[0];
+				int e1 = snorm ? (int)(std::int8_t)block[1] : block[1];
+
+				float palette[8];
+				alphaPalette(e0, e1, snorm, palette);
+
+				std::uint64_t indices = 0;
+				for (std::uint8_t i = 0; i < 6; i++)
+					indices |= (std::uint64_t)block[2 + i] << (i * 8);
+
+				for (std::uint8_t i = 0; i < 16; i++)
+					values[i] = palette[(indices >> (i * 3)) & 7];
+			}
+
+			// RGBA8 palette of a BC1 to BC3 color block, four bytes per entry. Only BC1 knows the three
+			// color mode, whose last entry is transparent black with alpha.
+			void colorBytes(const std::uint8_t block[8], bool bc1, bool alpha, std::uint8_t palette[16]) noexcept
+			{
+				std::uint16_t c0 = (std::uint16_t)(block[0] | (block[1] << 8));
+				std::uint16_t c1 = (std::uint16_t)(block[2] | (block[3] << 8));
+
+				bool three = bc1 && c0 <= c1;
+
+				int colors[4][3];
+				colorPalette(c0, c1, three, colors);
+
+				for (std::uint8_t k = 0; k < 4; k++)
+				{
+					for (std::uint8_t c = 0; c < 3; c++)
+						palette[k * 4 + c] = (std::uint8_t)colors[k][c];
+					palette[k * 4 + 3] = 255;
+				}
+
+				if (three && alpha)
+					palette[15] = 0;
+			}
+
+			void alphaBytes(const std::uint8_t block[8], std::uint8_t values[16]) noexcept
+			{
+				float palette[8];
+				alphaPalette(block[0], block[1], false, palette);
+
+				std::uint8_t bytes[8];
+				for (std::uint8_t k = 0; k < 8; k++)
+					bytes[k] = (std::uint8_t)std::lround(palette[k] * 255.0f);
+
+				std::uint64_t indices = 0;
+				for (std::uint8_t i = 0; i < 6; i++)
+					indices |= (std::uint64_t)block[2 + i] << (i * 8);
+
+				for (std::uint8_t i = 0; i < 16; i++)
+					values[i] = bytes[(indices >> (i * 3)) & 7];
+			}
+
+#if defined(__SSSE3__)
+			// Byte shuffles that turn a row of 2 bit indices into four palette entries, and that move
+			// the four alpha values of a row into the alpha bytes.
+			struct ShuffleTables
+			{
+				alignas(16) std::uint8_t colors[256][16];
+				alignas(16) std::uint8_t alphas[4][16];
+
+				ShuffleTables() noexcept
+				{
+					for (std::uint32_t row = 0; row < 256; row++)
+					{
+						for (std::uint8_t x = 0; x < 4; x++)
+						{
+							std::uint8_t index = (row >> (x * 2)) & 3;
+							for (std::uint8_t c = 0; c < 4; c++)
+								colors[row][x * 4 + c] = (std::uint8_t)(index * 4 + c);
+						}
+					}
+
+					std::memset(alphas, 0x80, sizeof(alphas));
+					for (std::uint8_t y = 0; y < 4; y++)
+					{
+						for (std::uint8_t x = 0; x < 4; x++)
+							alphas[y][x * 4 + 3] = (std::uint8_t)(y * 4 + x);
+					}
+				}
+			};
+
+			const ShuffleTables& shuffleTables() noexcept
+			{
+				static const ShuffleTables tables;
+				return tables;
+			}
+#endif
+
+			void writeColors(const std::uint8_t indices[4], const std::uint8_t palette[16], std::uint8_t texels[64], bool simd) noexcept
+			{
+#if defined(__SSSE3__)
+				if (simd)
+				{
+					auto& tables = shuffleTables();
+					__m128i entries = _mm_loadu_si128((const __m128i*)palette);
+
+					for (std::uint8_t y = 0; y < 4; y++)
+					{
+						__m128i mask = _mm_load_si128((const __m128i*)tables.colors[indices[y]]);
+						_mm_storeu_si128((__m128i*)(texels + y * 16), _mm_shuffle_epi8(entries, mask));
+					}
+					return;
+				}
+#else
+				(void)simd;
+#endif
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					std::uint8_t index = (indices[i / 4] >> ((i % 4) * 2)) & 3;
+					std::memcpy(texels + i * 4, palette + index * 4, 4);
+				}
+			}
+
+			void writeAlphas(const std::uint8_t alphas[16], std::uint8_t texels[64], bool simd) noexcept
+			{
+#if defined(__SSSE3__)
+				if (simd)
+				{
+					auto& tables = shuffleTables();
+					__m128i values = _mm_loadu_si128((const __m128i*)alphas);
+					__m128i colors = _mm_set1_epi32(0x00FFFFFF);
+
+					for (std::uint8_t y = 0; y < 4; y++)
+					{
+						__m128i row = _mm_and_si128(_mm_loadu_si128((const __m128i*)(texels + y * 16)), colors);
+						__m128i alpha = _mm_shuffle_epi8(values, _mm_load_si128((const __m128i*)tables.alphas[y]));
+						_mm_storeu_si128((__m128i*)(texels + y * 16), _mm_or_si128(row, alpha));
+					}
+					return;
+				}
+#else
+				(void)simd;
+#endif
+				for (std::uint8_t i = 0; i < 16; i++)
+					texels[i * 4 + 3] = alphas[i];
+			}
+
+			// Blends the endpoints of the subset of every texel by its color and alpha weight.
+			void interpolateBC7(const int endpoints[6][4], const std::uint8_t subsets[16], const std::uint8_t colorWeights[16], const std::uint8_t alphaWeights[16], std::uint8_t texels[64], bool simd) noexcept
+			{
+#if defined(__SSE2__)
+				if (simd)
+				{
+					alignas(16) std::int16_t ends[6][4];
+					for (std::uint8_t e = 0; e < 6; e++)
+					{
+						for (std::uint8_t c = 0; c < 4; c++)
+							ends[e][c] = (std::int16_t)endpoints[e][c];
+					}
+
+					const __m128i full = _mm_set1_epi16(64);
+					const __m128i half = _mm_set1_epi16(32);
+
+					// Two texels per register, the sums stay below 2^14.
+					for (std::uint8_t i = 0; i < 16; i += 2)
+					{
+						__m128i a = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)ends[subsets[i] * 2]), _mm_loadl_epi64((const __m128i*)ends[subsets[i + 1] * 2]));
+						__m128i b = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)ends[subsets[i] * 2 + 1]), _mm_loadl_epi64((const __m128i*)ends[subsets[i + 1] * 2 + 1]));
+						__m128i w = _mm_set_epi16(alphaWeights[i + 1], colorWeights[i + 1], colorWeights[i + 1], colorWeights[i + 1], alphaWeights[i], colorWeights[i], colorWeights[i], colorWeights[i]);
+
+						__m128i v = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(full, w), a), _mm_mullo_epi16(w, b));
+						v = _mm_srli_epi16(_mm_add_epi16(v, half), 6);
+
+						_mm_storel_epi64((__m128i*)(texels + i * 4), _mm_packus_epi16(v, v));
+					}
+					return;
+				}
+#else
+				(void)simd;
+#endif
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					const int* e0 = endpoints[subsets[i] * 2];
+					const int* e1 = endpoints[subsets[i] * 2 + 1];
+
+					for (std::uint8_t c = 0; c < 3; c++)
+						texels[i * 4 + c] = (std::uint8_t)interpolate(e0[c], e1[c], colorWeights[i]);
+					texels[i * 4 + 3] = (std::uint8_t)interpolate(e0[3], e1[3], alphaWeights[i]);
+				}
+			}
+
+			// BC6H works on the bits of halves, which grow about logarithmically with the value.
+			int halfBits(float value, bool sfloat) noexcept
+			{
+				if (!(value == value))
+					return 0;
+
+				value = std::min(std::max(value, sfloat ? -65504.0f : 0.0f), 65504.0f);
+
+				std::uint16_t bits = PixelCodec::floatToHalf(value);
+				return (bits & 0x8000) ? -(int)(bits & 0x7fff) : (int)bits;
+			}
+
+			int unquantizeBC6(int value, int bits, bool sfloat) noexcept
+			{
+				if (sfloat)
+				{
+					if (bits >= 16)
+						return value;
+
+					bool negative = value < 0;
+					value = std::abs(value);
+
+					int result;
+					if (value == 0)
+						result = 0;
+					else if (value >= (1 << (bits - 1)) - 1)
+						result = 0x7fff;
+					else
+						result = ((value << 15) + 0x4000) >> (bits - 1);
+
+					return negative ? -result : result;
+				}
+				else
+				{
+					if (bits >= 15)
+						return value;
+					if (value == 0)
+						return 0;
+					if (value == (1 << bits) - 1)
+						return 0xffff;
+					return ((value << 16) + 0x8000) >> bits;
+				}
+			}
+
+			int finishBC6(int value, bool sfloat) noexcept
+			{
+				if (sfloat)
+					return value < 0 ? -(((-value) * 31) >> 5) : (value * 31) >> 5;
+				return (value * 31) >> 6;
+			}
+
+			// Endpoints of BC6H mode 11, ten bits per channel without deltas.
+			struct BC6Endpoints
+			{
+				int q[2][3];
+			};
+
+			float fitBC6(const int targets[16][3], const BC6Endpoints& endpoints, bool sfloat, std::uint8_t indices[16]) noexcept
+			{
+				int palette[16][3];
+				for (std::uint8_t c = 0; c < 3; c++)
+				{
+					int a = unquantizeBC6(endpoints.q[0][c], 10, sfloat);
+					int b = unquantizeBC6(endpoints.q[1][c], 10, sfloat);
+					for (std::uint8_t k = 0; k < 16; k++)
+						palette[k][c] = finishBC6(interpolate(a, b, Weights4[k]), sfloat);
+				}
+
+				float error = 0.0f;
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					float best = 1e30f;
+					for (std::uint8_t k = 0; k < 16; k++)
+					{
+						float dr = (float)(palette[k][0] - targets[i][0]);
+						float dg = (float)(palette[k][1] - targets[i][1]);
+						float db = (float)(palette[k][2] - targets[i][2]);
+						float d = dr * dr + dg * dg + db * db;
+						if (d < best)
+						{
+							best = d;
+							indices[i] = k;
+						}
+					}
+
+					error += best;
+				}
+
+				return error;
+			}
+
+			// Ten bit endpoint whose unquantized value is closest to the interpolation space value.
+			int quantizeBC6(float value, bool sfloat) noexcept
+			{
+				int limit = sfloat ? 511 : 1023;
+				int guess = (int)std::lround((value - (value < 0.0f ? -32.0f : 32.0f)) / 64.0f);
+
+				int best = 0;
+				float bestError = 1e30f;
+				for (int q = guess - 1; q <= guess + 1; q++)
+				{
+					int clamped = std::min(std::max(q, sfloat ? -limit : 0), limit);
+					float error = std::abs(unquantizeBC6(clamped, 10, sfloat) - value);
+					if (error < bestError)
+					{
+						bestError = error;
+						best = clamped;
+					}
+				}
+
+				return best;
+			}
+
+			int expandBits(int value, int bits) noexcept
+			{
+				value <<= 8 - bits;
+				return value | (value >> bits);
+			}
+
+			// Mode 6 stores seven bits and a p-bit per endpoint and channel, 8 bits in total.
+			void quantizeMode6(const float endpoint[4], int p, int q[4]) noexcept
+			{
+				for (std::uint8_t c = 0; c < 4; c++)
+					q[c] = std::min(std::max((int)std::lround((endpoint[c] - p) / 2.0f), 0), 127);
+			}
+
+			float endpointError6(const float endpoint[4], const int q[4], int p) noexcept
+			{
+				float error = 0.0f;
+				for (std::uint8_t c = 0; c < 4; c++)
+				{
+					float d = (q[c] * 2 + p) - endpoint[c];
+					error += d * d;
+				}
+				return error;
+			}
+
+			float fitMode6(const float texels[16][4], const int q[2][4], const int p[2], std::uint8_t indices[16]) noexcept
+			{
+				int palette[16][4];
+				for (std::uint8_t c = 0; c < 4; c++)
+				{
+					int a = q[0][c] * 2 + p[0];
+					int b = q[1][c] * 2 + p[1];
+					for (std::uint8_t k = 0; k < 16; k++)
+						palette[k][c] = interpolate(a, b, Weights4[k]);
+				}
+
+				float error = 0.0f;
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					float best = 1e30f;
+					for (std::uint8_t k = 0; k < 16; k++)
+					{
+						float d = 0.0f;
+						for (std::uint8_t c = 0; c < 4; c++)
+							d += (palette[k][c] - texels[i][c]) * (palette[k][c] - texels[i][c]);
+						if (d < best)
+						{
+							best = d;
+							indices[i] = k;
+						}
+					}
+
+					error += best;
+				}
+
+				return error;
+			}
+
+			float encodeMode6(const float texels[16][4], std::uint8_t block[16], bool high) noexcept
+			{
+				static const float weight[16] =
+				{
+					0 / 64.0f, 4 / 64.0f, 9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f, 26 / 64.0f, 30 / 64.0f,
+					34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 64 / 64.0f,
+				};
+
+				float e[2][4];
+				fitLine(texels, 4, 0xffff, e[0], e[1]);
+
+				int q[2][4];
+				int p[2];
+
+				// Each endpoint takes the p-bit that lands closer.
+				auto quantize = [&](const float endpoints[2][4], int outQ[2][4], int outP[2])
+				{
+					for (std::uint8_t i = 0; i < 2; i++)
+					{
+						int q0[4], q1[4];
+						quantizeMode6(endpoints[i], 0, q0);
+						quantizeMode6(endpoints[i], 1, q1);
+						outP[i] = endpointError6(endpoints[i], q1, 1) < endpointError6(endpoints[i], q0, 0) ? 1 : 0;
+						std::memcpy(outQ[i], outP[i] ? q1 : q0, sizeof(q0));
+					}
+				};
+
+				quantize(e, q, p);
+
+				std::uint8_t indices[16];
+				std::uint8_t bestIndices[16];
+				float bestError = fitMode6(texels, q, p, bestIndices);
+
+				for (int iteration = 0; iteration < (high ? 4 : 1); iteration++)
+				{
+					float solved[2][4];
+					if (!solveEndpoints(texels, 4, 0xffff, bestIndices, weight, solved[0], solved[1]))
+						break;
+
+					int candidateQ[2][4];
+					int candidateP[2];
+					quantize(solved, candidateQ, candidateP);
+
+					float error = fitMode6(texels, candidateQ, candidateP, indices);
+					if (error >= bestError)
+						break;
+
+					bestError = error;
+					std::memcpy(q, candidateQ, sizeof(q));
+					std::memcpy(p, candidateP, sizeof(p));
+					std::memcpy(bestIndices, indices, sizeof(indices));
+				}
+
+				if (high)
+				{
+					// Every channel of both endpoints one step either way, p-bits included.
+					bool improved = true;
+					for (int pass = 0; pass < 3 && improved; pass++)
+					{
+						improved = false;
+						for (std::uint8_t endpoint = 0; endpoint < 2; endpoint++)
+						{
+							for (std::uint8_t c = 0; c < 5; c++)
+							{
+								for (int direction = -1; direction <= 1; direction += 2)
+								{
+									int candidateQ[2][4];
+									int candidateP[2];
+									std::memcpy(candidateQ, q, sizeof(q));
+									std::memcpy(candidateP, p, sizeof(p));
+
+									if (c == 4)
+									{
+										if (direction > 0)
+											continue;
+										candidateP[endpoint] ^= 1;
+									}
+									else
+									{
+										int value = candidateQ[endpoint][c] + direction;
+										if (value < 0 || value > 127)
+											continue;
+										candidateQ[endpoint][c] = value;
+									}
+
+									float error = fitMode6(texels, candidateQ, candidateP, indices);
+									if (error < bestError)
+									{
+										bestError = error;
+										std::memcpy(q, candidateQ, sizeof(q));
+										std::memcpy(p, candidateP, sizeof(p));
+										std::memcpy(bestIndices, indices, sizeof(indices));
+										improved = true;
+									}
+								}
+							}
+						}
+					}
+				}
+
+				if (bestIndices[0] & 8)
+				{
+					std::swap(q[0], q[1]);
+					std::swap(p[0], p[1]);
+					for (std::uint8_t i = 0; i < 16; i++)
+						bestIndices[i] = 15 - bestIndices[i];
+				}
+
+				BitWriter writer(block, 16);
+				writer.write(1 << 6, 7);
+				for (std::uint8_t c = 0; c < 4; c++)
+				{
+					writer.write(q[0][c], 7);
+					writer.write(q[1][c], 7);
+				}
+				writer.write(p[0], 1);
+				writer.write(p[1], 1);
+				for (std::uint8_t i = 0; i < 16; i++)
+					writer.write(bestIndices[i], i == 0 ? 3 : 4);
+
+				return bestError;
+			}
+
+			// Mode 1 stores six bits per channel and one p-bit per subset, alpha is always opaque.
+			struct Mode1Subset
+			{
+				int q[2][3];
+				int p;
+			};
+
+			void quantizeMode1(const float endpoints[2][4], Mode1Subset& subset) noexcept
+			{
+				float bestError = 1e30f;
+				for (int p = 0; p < 2; p++)
+				{
+					int q[2][3];
+					float error = 0.0f;
+					for (std::uint8_t i = 0; i < 2; i++)
+					{
+						for (std::uint8_t c = 0; c < 3; c++)
+						{
+							q[i][c] = std::min(std::max((int)std::lround((endpoints[i][c] / 255.0f * 127.0f - p) / 2.0f), 0), 63);
+							float d = expandBits(q[i][c] * 2 + p, 7) - endpoints[i][c];
+							error += d * d;
+						}
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						subset.p = p;
+						std::memcpy(subset.q, q, sizeof(q));
+					}
+				}
+			}
+
+			float fitMode1(const float texels[16][4], std::uint16_t mask, const Mode1Subset& subset, std::uint8_t indices[16]) noexcept
+			{
+				int palette[8][3];
+				for (std::uint8_t c = 0; c < 3; c++)
+				{
+					int a = expandBits(subset.q[0][c] * 2 + subset.p, 7);
+					int b = expandBits(subset.q[1][c] * 2 + subset.p, 7);
+					for (std::uint8_t k = 0; k < 8; k++)
+						palette[k][c] = interpolate(a, b, Weights3[k]);
+				}
+
+				float error = 0.0f;
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					if (!(mask & (1 << i)))
+						continue;
+
+					float best = 1e30f;
+					for (std::uint8_t k = 0; k < 8; k++)
+					{
+						float d = 0.0f;
+						for (std::uint8_t c = 0; c < 3; c++)
+							d += (palette[k][c] - texels[i][c]) * (palette[k][c] - texels[i][c]);
+						if (d < best)
+						{
+							best = d;
+							indices[i] = k;
+						}
+					}
+
+					error += best;
+				}
+
+				return error;
+			}
+
+			float encodeMode1Subset(const float texels[16][4], std::uint16_t mask, Mode1Subset& subset, std::uint8_t indices[16]) noexcept
+			{
+				static const float weight[8] = { 0 / 64.0f, 9 / 64.0f, 18 / 64.0f, 27 / 64.0f, 37 / 64.0f, 46 / 64.0f, 55 / 64.0f, 64 / 64.0f };
+
+				float e[2][4];
+				fitLine(texels, 3, mask, e[0], e[1]);
+				quantizeMode1(e, subset);
+
+				float error = fitMode1(texels, mask, subset, indices);
+
+				for (int iteration = 0; iteration < 2; iteration++)
+				{
+					float solved[2][4];
+					if (!solveEndpoints(texels, 3, mask, indices, weight, solved[0], solved[1]))
+						break;
+
+					Mode1Subset candidate;
+					quantizeMode1(solved, candidate);
+
+					std::uint8_t candidateIndices[16];
+					std::memcpy(candidateIndices, indices, sizeof(candidateIndices));
+
+					float candidateError = fitMode1(texels, mask, candidate, candidateIndices);
+					if (candidateError >= error)
+						break;
+
+					error = candidateError;
+					subset = candidate;
+					std::memcpy(indices, candidateIndices, sizeof(candidateIndices));
+				}
+
+				return error;
+			}
+
+			// Squared distance of the texels in mask from their principal line, a cheap partition score.
+			float lineError(const float texels[16][4], std::uint16_t mask) noexcept
+			{
+				float lo[4], hi[4];
+				fitLine(texels, 3, mask, lo, hi);
+
+				float axis[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+				float length = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+				float error = 0.0f;
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					if (!(mask & (1 << i)))
+						continue;
+
+					float d[3] = { texels[i][0] - lo[0], texels[i][1] - lo[1], texels[i][2] - lo[2] };
+					float t = length > 0.0f ? (d[0] * axis[0] + d[1] * axis[1] + d[2] * axis[2]) / length : 0.0f;
+					for (std::uint8_t c = 0; c < 3; c++)
+					{
+						float r = d[c] - axis[c] * t;
+						error += r * r;
+					}
+				}
+
+				return error;
+			}
+
+			float encodeMode1(const float texels[16][4], std::uint8_t block[16]) noexcept
+			{
+				constexpr int candidates = 4;
+
+				int partitions[candidates];
+				float scores[candidates];
+				for (int i = 0; i < candidates; i++)
+				{
+					partitions[i] = -1;
+					scores[i] = 1e30f;
+				}
+
+				for (int partition = 0; partition < 64; partition++)
+				{
+					std::uint16_t mask = Partitions2[partition];
+					float score = lineError(texels, (std::uint16_t)~mask) + lineError(texels, mask);
+
+					for (int i = 0; i < candidates; i++)
+					{
+						if (score < scores[i])
+						{
+							for (int j = candidates - 1; j > i; j--)
+							{
+								scores[j] = scores[j - 1];
+								partitions[j] = partitions[j - 1];
+							}
+
+							scores[i] = score;
+							partitions[i] = partition;
+							break;
+						}
+					}
+				}
+
+				float bestError = 1e30f;
+				int bestPartition = 0;
+				Mode1Subset bestSubsets[2];
+				std::uint8_t bestIndices[16];
+
+				for (int i = 0; i < candidates; i++)
+				{
+					std::uint16_t mask = Partitions2[partitions[i]];
+
+					Mode1Subset subsets[2];
+					std::uint8_t indices[16];
+					float error = encodeMode1Subset(texels, (std::uint16_t)~mask, subsets[0], indices);
+					error += encodeMode1Subset(texels, mask, subsets[1], indices);
+
+					if (error < bestError)
+					{
+						bestError = error;
+						bestPartition = partitions[i];
+						bestSubsets[0] = subsets[0];
+						bestSubsets[1] = subsets[1];
+						std::memcpy(bestIndices, indices, sizeof(indices));
+					}
+				}
+
+				std::uint16_t mask = Partitions2[bestPartition];
+				std::uint8_t anchors[2] = { 0, Anchors2[bestPartition] };
+
+				for (std::uint8_t s = 0; s < 2; s++)
+				{
+					if (bestIndices[anchors[s]] & 4)
+					{
+						std::swap(bestSubsets[s].q[0], bestSubsets[s].q[1]);
+						for (std::uint8_t i = 0; i < 16; i++)
+						{
+							if (((mask >> i) & 1) == s)
+								bestIndices[i] = 7 - bestIndices[i];
+						}
+					}
+				}
+
+				BitWriter writer(block, 16);
+				writer.write(1 << 1, 2);
+				writer.write(bestPartition, 6);
+				for (std::uint8_t c = 0; c < 3; c++)
+				{
+					for (std::uint8_t s = 0; s < 2; s++)
+					{
+						writer.write(bestSubsets[s].q[0][c], 6);
+						writer.write(bestSubsets[s].q[1][c], 6);
+					}
+				}
+				writer.write(bestSubsets[0].p, 1);
+				writer.write(bestSubsets[1].p, 1);
+				for (std::uint8_t i = 0; i < 16; i++)
+					writer.write(bestIndices[i], (i == anchors[0] || i == anchors[1]) ? 2 : 3);
+
+				return bestError;
+			}
+		}
+
+		void
+		encodeBC1(const std::uint8_t texels[64], std::uint8_t block[8], bool alpha, bool high) noexcept
+		{
+			float values[16][4];
+			toFloats(texels, values);
+
+			std::uint16_t mask = 0;
+			for (std::uint8_t i = 0; i < 16; i++)
+			{
+				if (!alpha || texels[i * 4 + 3] >= 128)
+					mask |= 1 << i;
+			}
+
+			encodeColor(values, mask, block, mask != 0xffff, high);
+		}
+
+		void
+		encodeBC2(const std::uint8_t texels[64], std::uint8_t block[16], bool high) noexcept
+		{
+			std::uint64_t alpha = 0;
+			for (std::uint8_t i = 0; i < 16; i++)
+				alpha |= (std::uint64_t)((texels[i * 4 + 3] + 8) / 17) << (i * 4);
+
+			for (std::uint8_t i = 0; i < 8; i++)
+				block[i] = (std::uint8_t)(alpha >> (i * 8));
+
+			float values[16][4];
+			toFloats(texels, values);
+			encodeColor(values, 0xffff, block + 8, false, high);
+		}
+
+		void
+		encodeBC3(const std::uint8_t texels[64], std::uint8_t block[16], bool high) noexcept
+		{
+			float alpha[16];
+			for (std::uint8_t i = 0; i < 16; i++)
+				alpha[i] = texels[i * 4 + 3] / 255.0f;
+
+			encodeAlpha(alpha, block, false, high);
+
+			float values[16][4];
+			toFloats(texels, values);
+			encodeColor(values, 0xffff, block + 8, false, high);
+		}
+
+		void
+		encodeBC4(const float texels[64], std::uint8_t block[8], bool snorm, bool high) noexcept
+		{
+			float red[16];
+			for (std::uint8_t i = 0; i < 16; i++)
+				red[i] = texels[i * 4];
+
+			encodeAlpha(red, block, snorm, high);
+		}
+
+		void
+		encodeBC5(const float texels[64], std::uint8_t block[16], bool snorm, bool high) noexcept
+		{
+			float red[16];
+			float green[16];
+			for (std::uint8_t i = 0; i < 16; i++)
+			{
+				red[i] = texels[i * 4];
+				green[i] = texels[i * 4 + 1];
+			}
+
+			encodeAlpha(red, block, snorm, high);
+			encodeAlpha(green, block + 8, snorm, high);
+		}
+
+		void
+		encodeBC6H(const float texels[64], std::uint8_t block[16], bool sfloat, bool high) noexcept
+		{
+			static const float weight[16] =
+			{
+				0 / 64.0f, 4 / 64.0f, 9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f, 26 / 64.0f, 30 / 64.0f,
+				34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 64 / 64.0f,
+			};
+
+			// Targets are the finished half bits, the fit runs on the unquantized values they come from.
+			int targets[16][3];
+			float values[16][4];
+			float unfinish = sfloat ? 32.0f / 31.0f : 64.0f / 31.0f;
+
+			for (std::uint8_t i = 0; i < 16; i++)
+			{
+				for (std::uint8_t c = 0; c < 3; c++)
+				{
+					targets[i][c] = halfBits(texels[i * 4 + c], sfloat);
+					values[i][c] = targets[i][c] * unfinish;
+				}
+				values[i][3] = 0.0f;
+			}
+
+			float e[2][4];
+			fitLine(values, 3, 0xffff, e[0], e[1]);
+
+			auto quantize = [&](const float endpoints[2][4], BC6Endpoints& out)
+			{
+				for (std::uint8_t i = 0; i < 2; i++)
+				{
+					for (std::uint8_t c = 0; c < 3; c++)
+						out.q[i][c] = quantizeBC6(endpoints[i][c], sfloat);
+				}
+			};
+
+			BC6Endpoints best;
+			quantize(e, best);
+
+			std::uint8_t indices[16];
+			std::uint8_t bestIndices[16];
+			float bestError = fitBC6(targets, best, sfloat, bestIndices);
+
+			for (int iteration = 0; iteration < (high ? 4 : 1); iteration++)
+			{
+				float solved[2][4];
+				if (!solveEndpoints(values, 3, 0xffff, bestIndices, weight, solved[0], solved[1]))
+					break;
+
+				BC6Endpoints candidate;
+				quantize(solved, candidate);
+
+				float error = fitBC6(targets, candidate, sfloat, indices);
+				if (error >= bestError)
+					break;
+
+				best = candidate;
+				bestError = error;
+				std::memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (high)
+			{
+				int lower = sfloat ? -511 : 0;
+				int upper = sfloat ? 511 : 1023;
+
+				bool improved = true;
+				for (int pass = 0; pass < 3 && improved; pass++)
+				{
+					improved = false;
+					for (std::uint8_t endpoint = 0; endpoint < 2; endpoint++)
+					{
+						for (std::uint8_t c = 0; c < 3; c++)
+						{
+							for (int direction = -1; direction <= 1; direction += 2)
+							{
+								BC6Endpoints candidate = best;
+								int value = candidate.q[endpoint][c] + direction;
+								if (value < lower || value > upper)
+									continue;
+
+								candidate.q[endpoint][c] = value;
+
+								float error = fitBC6(targets, candidate, sfloat, indices);
+								if (error < bestError)
+								{
+									best = candidate;
+									bestError = error;
+									std::memcpy(bestIndices, indices, sizeof(indices));
+									improved = true;
+								}
+							}
+						}
+					}
+				}
+			}
+
+			if (bestIndices[0] & 8)
+			{
+				std::swap(best.q[0], best.q[1]);
+				for (std::uint8_t i = 0; i < 16; i++)
+					bestIndices[i] = 15 - bestIndices[i];
+			}
+
+			BitWriter writer(block, 16);
+			writer.write(0x03, 5);
+			for (std::uint8_t i = 0; i < 2; i++)
+			{
+				for (std::uint8_t c = 0; c < 3; c++)
+					writer.write(best.q[i][c] & 0x3ff, 10);
+			}
+			for (std::uint8_t i = 0; i < 16; i++)
+				writer.write(bestIndices[i], i == 0 ? 3 : 4);
+		}
+
+		void
+		encodeBC7(const std::uint8_t texels[64], std::uint8_t block[16], bool high) noexcept
+		{
+			float values[16][4];
+			toFloats(texels, values);
+
+			float error = encodeMode6(values, block, high);
+
+			bool opaque = true;
+			for (std::uint8_t i = 0; i < 16; i++)
+				opaque &= texels[i * 4 + 3] == 255;
+
+			if (high && opaque && error > 0.0f)
+			{
+				std::uint8_t candidate[16];
+				if (encodeMode1(values, candidate) < error)
+					std::memcpy(block, candidate, sizeof(candidate));
+			}
+		}
+
+		void
+		decodeBC1(const std::uint8_t block[8], std::uint8_t texels[64], bool alpha, bool simd) noexcept
+		{
+			std::uint8_t palette[16];
+			colorBytes(block, true, alpha, palette);
+			writeColors(block + 4, palette, texels, simd);
+		}
+
+		void
+		decodeBC2(const std::uint8_t block[16], std::uint8_t texels[64], bool simd) noexcept
+		{
+			std::uint8_t palette[16];
+			colorBytes(block + 8, false, false, palette);
+			writeColors(block + 12, palette, texels, simd);
+
+			std::uint8_t alphas[16];
+			for (std::uint8_t i = 0; i < 16; i++)
+				alphas[i] = (std::uint8_t)(((block[i / 2] >> ((i % 2) * 4)) & 15) * 17);
+
+			writeAlphas(alphas, texels, simd);
+		}
+
+		void
+		decodeBC3(const std::uint8_t block[16], std::uint8_t texels[64], bool simd) noexcept
+		{
+			std::uint8_t palette[16];
+			colorBytes(block + 8, false, false, palette);
+			writeColors(block + 12, palette, texels, simd);
+
+			std::uint8_t alphas[16];
+			alphaBytes(block, alphas);
+			writeAlphas(alphas, texels, simd);
+		}
+
+		void
+		decodeBC4(const std::uint8_t block[8], float texels[64], bool snorm) noexcept
+		{
+			float red[16];
+			decodeAlpha(block, red, snorm);
+
+			for (std::uint8_t i = 0; i < 16; i++)
+				texels[i * 4] = red[i];
+		}
+
+		void
+		decodeBC5(const std::uint8_t block[16], float texels[64], bool snorm) noexcept
+		{
+			float red[16];
+			float green[16];
+			decodeAlpha(block, red, snorm);
+			decodeAlpha(block + 8, green, snorm);
+
+			for (std::uint8_t i = 0; i < 16; i++)
+			{
+				texels[i * 4] = red[i];
+				texels[i * 4 + 1] = green[i];
+			}
+		}
+
+		void
+		decodeBC6H(const std::uint8_t block[16], std::uint16_t texels[64], bool sfloat) noexcept
+		{
+			BitReader reader(block);
+
+			std::uint32_t value = reader.read(2);
+			if (value >= 2)
+				value |= reader.read(3) << 2;
+
+			const BC6Mode* mode = nullptr;
+			for (auto& it : BC6Modes)
+			{
+				if (it.value == value)
+					mode = &it;
+			}
+
+			if (!mode)
+			{
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					texels[i * 4] = texels[i * 4 + 1] = texels[i * 4 + 2] = 0;
+					texels[i * 4 + 3] = 0x3C00;
+				}
+				return;
+			}
+
+			int fields[13] = {};
+			for (auto& run : mode->runs)
+			{
+				// Unused runs are zero, which no mode stores.
+				if (run.field == RW && run.last == 0)
+					break;
+
+				int step = run.first <= run.last ? 1 : -1;
+				for (int bit = run.first; ; bit += step)
+				{
+					fields[run.field] |= reader.read(1) << bit;
+					if (bit == run.last)
+						break;
+				}
+			}
+
+			int bits = mode->endpointBits;
+			int endpoints[4][3];
+
+			for (std::uint8_t c = 0; c < 3; c++)
+			{
+				endpoints[0][c] = fields[RW + c];
+				endpoints[1][c] = fields[RX + c];
+				endpoints[2][c] = fields[RY + c];
+				endpoints[3][c] = fields[RZ + c];
+
+				if (sfloat)
+					endpoints[0][c] = signExtend(endpoints[0][c], bits);
+
+				for (std::uint8_t e = 1; e < mode->regions * 2; e++)
+				{
+					if (mode->transformed)
+					{
+						int delta = signExtend(endpoints[e][c], mode->deltaBits[c]);
+						endpoints[e][c] = (endpoints[0][c] + delta) & ((1 << bits) - 1);
+					}
+
+					if (sfloat)
+						endpoints[e][c] = signExtend(endpoints[e][c], bits);
+				}
+
+				for (std::uint8_t e = 0; e < mode->regions * 2; e++)
+					endpoints[e][c] = unquantizeBC6(endpoints[e][c], bits, sfloat);
+			}
+
+			int partition = fields[D];
+			const std::uint8_t* weights = mode->regions == 1 ? Weights4 : Weights3;
+			std::uint8_t indexBits = mode->regions == 1 ? 4 : 3;
+
+			for (std::uint8_t i = 0; i < 16; i++)
+			{
+				int subset = mode->regions == 1 ? 0 : (Partitions2[partition] >> i) & 1;
+				bool anchor = i == 0 || (mode->regions == 2 && i == Anchors2[partition]);
+				int index = reader.read(anchor ? indexBits - 1 : indexBits);
+
+				for (std::uint8_t c = 0; c < 3; c++)
+				{
+					int v = finishBC6(interpolate(endpoints[subset * 2][c], endpoints[subset * 2 + 1][c], weights[index]), sfloat);
+					texels[i * 4 + c] = (std::uint16_t)(v < 0 ? 0x8000 | -v : v);
+				}
+				texels[i * 4 + 3] = 0x3C00;
+			}
+		}
+
+		void
+		decodeBC7(const std::uint8_t block[16], std::uint8_t texels[64], bool simd) noexcept
+		{
+			int modeIndex = 0;
+			while (modeIndex < 8 && !(block[0] & (1 << modeIndex)))
+				modeIndex++;
+
+			if (modeIndex == 8)
+			{
+				std::memset(texels, 0, 64);
+				return;
+			}
+
+			auto& mode = BC7Modes[modeIndex];
+
+			BitReader reader(block);
+			reader.read(modeIndex + 1);
+
+			int partition = reader.read(mode.partitionBits);
+			int rotation = reader.read(mode.rotationBits);
+			int selection = reader.read(mode.selectionBits);
+
+			int endpoints[6][4] = {};
+			std::uint8_t count = mode.subsets * 2;
+
+			for (std::uint8_t c = 0; c < 3; c++)
+			{
+				for (std::uint8_t e = 0; e < count; e++)
+					endpoints[e][c] = reader.read(mode.colorBits);
+			}
+
+			for (std::uint8_t e = 0; e < count; e++)
+				endpoints[e][3] = mode.alphaBits ? reader.read(mode.alphaBits) : 255;
+
+			int pbits[6] = {};
+			if (mode.endpointPBits)
+			{
+				for (std::uint8_t e = 0; e < count; e++)
+					pbits[e] = reader.read(1);
+			}
+			else if (mode.sharedPBits)
+			{
+				for (std::uint8_t s = 0; s < mode.subsets; s++)
+					pbits[s * 2] = pbits[s * 2 + 1] = reader.read(1);
+			}
+
+			bool hasPBits = mode.endpointPBits || mode.sharedPBits;
+			for (std::uint8_t e = 0; e < count; e++)
+			{
+				for (std::uint8_t c = 0; c < 4; c++)
+				{
+					int bits = c < 3 ? mode.colorBits : mode.alphaBits;
+					if (bits == 0)
+						continue;
+
+					int v = endpoints[e][c];
+					if (hasPBits)
+					{
+						v = (v << 1) | pbits[e];
+						bits++;
+					}
+
+					endpoints[e][c] = expandBits(v, bits);
+				}
+			}
+
+			std::uint8_t subsets[16];
+			bool anchors[16] = {};
+			anchors[0] = true;
+
+			for (std::uint8_t i = 0; i < 16; i++)
+			{
+				if (mode.subsets == 1)
+					subsets[i] = 0;
+				else if (mode.subsets == 2)
+					subsets[i] = (Partitions2[partition] >> i) & 1;
+				else
+					subsets[i] = (Partitions3[partition] >> (i * 2)) & 3;
+			}
+
+			if (mode.subsets == 2)
+				anchors[Anchors2[partition]] = true;
+			else if (mode.subsets == 3)
+				anchors[Anchors3[0][partition]] = anchors[Anchors3[1][partition]] = true;
+
+			std::uint8_t primary[16];
+			std::uint8_t secondary[16] = {};
+
+			for (std::uint8_t i = 0; i < 16; i++)
+				primary[i] = (std::uint8_t)reader.read(anchors[i] ? mode.indexBits - 1 : mode.indexBits);
+
+			if (mode.indexBits2)
+			{
+				for (std::uint8_t i = 0; i < 16; i++)
+					secondary[i] = (std::uint8_t)reader.read(i == 0 ? mode.indexBits2 - 1 : mode.indexBits2);
+			}
+
+			auto weights = [](std::uint8_t bits) { return bits == 2 ? Weights2 : bits == 3 ? Weights3 : Weights4; };
+
+			const std::uint8_t* colorWeights = weights(mode.indexBits);
+			const std::uint8_t* alphaWeights = weights(mode.indexBits);
+			const std::uint8_t* colorIndices = primary;
+			const std::uint8_t* alphaIndices = primary;
+
+			if (mode.indexBits2)
+			{
+				alphaWeights = weights(mode.indexBits2);
+				alphaIndices = secondary;
+
+				if (selection)
+				{
+					std::swap(colorWeights, alphaWeights);
+					std::swap(colorIndices, alphaIndices);
+				}
+			}
+
+			std::uint8_t colorWeight[16];
+			std::uint8_t alphaWeight[16];
+
+			for (std::uint8_t i = 0; i < 16; i++)
+			{
+				colorWeight[i] = colorWeights[colorIndices[i]];
+				alphaWeight[i] = alphaWeights[alphaIndices[i]];
+			}
+
+			interpolateBC7(endpoints, subsets, colorWeight, alphaWeight, texels, simd);
+
+			if (rotation)
+			{
+				for (std::uint8_t i = 0; i < 16; i++)
+					std::swap(texels[i * 4 + 3], texels[i * 4 + rotation - 1]);
+			}
+		}
+	}
+}
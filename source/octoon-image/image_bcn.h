@@ -0,0 +1,38 @@
+#ifndef OCTOON_IMAGE_BCN_H_
+#define OCTOON_IMAGE_BCN_H_
+
+#include <cstdint>
+
+namespace octoon
+{
+	namespace image
+	{
+		// Encoders and decoders of single BC1 to BC7 blocks. A block covers 16 texels in row order with
+		// four channels each, 8 bit RGBA for the color formats and floats for BC4, BC5 and BC6H so that
+		// signed and HDR values fit. BC4 and BC5 read and write red and green only.
+		//
+		// The fast encoders fit one line through the colors and refine it once. The slow ones iterate
+		// the fit, search the neighbouring endpoints, pick the better BC4 mode and try the two subset
+		// BC7 partitions. BC6H blocks are written in its single region mode, BC7 blocks in modes 1 and 6.
+		void encodeBC1(const std::uint8_t texels[64], std::uint8_t block[8], bool alpha, bool high) noexcept;
+		void encodeBC2(const std::uint8_t texels[64], std::uint8_t block[16], bool high) noexcept;
+		void encodeBC3(const std::uint8_t texels[64], std::uint8_t block[16], bool high) noexcept;
+		void encodeBC4(const float texels[64], std::uint8_t block[8], bool snorm, bool high) noexcept;
+		void encodeBC5(const float texels[64], std::uint8_t block[16], bool snorm, bool high) noexcept;
+		void encodeBC6H(const float texels[64], std::uint8_t block[16], bool sfloat, bool high) noexcept;
+		void encodeBC7(const std::uint8_t texels[64], std::uint8_t block[16], bool high) noexcept;
+
+		// Decoders accept every mode of every format, reserved BC6H and BC7 modes decode to zero. BC6H
+		// decodes to the bits of halves. The simd flag picks the SSSE3 shuffles of BC1 to BC3 and the
+		// SSE2 blends of BC7 where they are built in, both give the same texels.
+		void decodeBC1(const std::uint8_t block[8], std::uint8_t texels[64], bool alpha, bool simd) noexcept;
+		void decodeBC2(const std::uint8_t block[16], std::uint8_t texels[64], bool simd) noexcept;
+		void decodeBC3(const std::uint8_t block[16], std::uint8_t texels[64], bool simd) noexcept;
+		void decodeBC4(const std::uint8_t block[8], float texels[64], bool snorm) noexcept;
+		void decodeBC5(const std::uint8_t block[16], float texels[64], bool snorm) noexcept;
+		void decodeBC6H(const std::uint8_t block[16], std::uint16_t texels[64], bool sfloat) noexcept;
+		void decodeBC7(const std::uint8_t block[16], std::uint8_t texels[64], bool simd) noexcept;
+	}
+}
+
+#endif
@@ -0,0 +1,858 @@
+#include "image_codec.h"
+
+#include <octoon/runtime/except.h>
+
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+#if defined(__AVX2__) || defined(__F16C__)
+#	include <immintrin.h>
+#endif
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			struct SRGBTables
+			{
+				// Linear value of every 8 bit code.
+				float decode[256];
+
+				// Linear value halfway between two codes, the code of v is the number of entries <= v.
+				float encode[255];
+
+				// First code of every float in [2^-13, 1) sharing the top 8 mantissa bits, the search
+				// from there takes a step or two at most. Below 2^-13 every value encodes to 0.
+				std::uint8_t start[13 << 8];
+
+				SRGBTables() noexcept
+				{
+					for (int i = 0; i < 256; i++)
+						decode[i] = PixelCodec::srgbToLinear(i / 255.0f);
+					for (int i = 0; i < 255; i++)
+						encode[i] = PixelCodec::srgbToLinear((i + 0.5f) / 255.0f);
+
+					for (std::uint32_t i = 0; i < (13 << 8); i++)
+					{
+						float v;
+						std::uint32_t bits = (114u << 23) + (i << 15);
+						std::memcpy(&v, &bits, sizeof(float));
+						start[i] = (std::uint8_t)(std::upper_bound(encode, encode + 255, v) - encode);
+					}
+				}
+
+				std::uint8_t toSRGB8(float v) const noexcept
+				{
+					if (!(v >= 1.220703125e-4f))
+						return 0;
+					if (v >= 1.0f)
+						return 255;
+
+					std::uint32_t bits;
+					std::memcpy(&bits, &v, sizeof(float));
+
+					std::uint32_t code = start[(bits - (114u << 23)) >> 15];
+					while (code < 255 && encode[code] <= v)
+						code++;
+
+					return (std::uint8_t)code;
+				}
+			};
+
+			const SRGBTables& srgbTables() noexcept
+			{
+				static const SRGBTables tables;
+				return tables;
+			}
+
+			inline float saturate(float v) noexcept
+			{
+				v = v > 0.0f ? v : 0.0f;
+				return v < 1.0f ? v : 1.0f;
+			}
+
+			inline float clampSigned(float v) noexcept
+			{
+				v = v > -1.0f ? v : -1.0f;
+				return v < 1.0f ? v : 1.0f;
+			}
+
+			template<typename T>
+			void decodeNorm(const T* src, float* dst, std::size_t count, bool) noexcept
+			{
+				// Signed normalized formats have two codes for -1.
+				constexpr float scale = 1.0f / std::numeric_limits<T>::max();
+				for (std::size_t i = 0; i < count; i++)
+					dst[i] = std::is_signed<T>::value ? std::max(src[i] * scale, -1.0f) : src[i] * scale;
+			}
+
+			template<>
+			void decodeNorm(const std::uint8_t* src, float* dst, std::size_t count, bool simd) noexcept
+			{
+				std::size_t i = 0;
+#if defined(__AVX2__)
+				if (simd)
+				{
+					const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+					for (; i + 8 <= count; i += 8)
+						_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)))), scale));
+				}
+#elif defined(__SSE2__)
+				if (simd)
+				{
+					const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+					const __m128i zero = _mm_setzero_si128();
+					for (; i + 16 <= count; i += 16)
+					{
+						__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+						__m128i lo = _mm_unpacklo_epi8(v, zero);
+						__m128i hi = _mm_unpackhi_epi8(v, zero);
+						_mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+						_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+						_mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+						_mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+					}
+				}
+#else
+				(void)simd;
+#endif
+				for (; i < count; i++)
+					dst[i] = src[i] * (1.0f / 255.0f);
+			}
+
+			template<typename T>
+			void encodeNorm(const float* src, T* dst, std::size_t count, bool) noexcept
+			{
+				constexpr float scale = std::numeric_limits<T>::max();
+				for (std::size_t i = 0; i < count; i++)
+					dst[i] = (T)std::lrint((std::is_signed<T>::value ? clampSigned(src[i]) : saturate(src[i])) * scale);
+			}
+
+			template<>
+			void encodeNorm(const float* src, std::uint8_t* dst, std::size_t count, bool simd) noexcept
+			{
+				std::size_t i = 0;
+#if defined(__AVX2__)
+				if (simd)
+				{
+					// The packs interleave the 128 bit lanes, the permute puts the dwords back in order.
+					const __m256 scale = _mm256_set1_ps(255.0f);
+					const __m256 zero = _mm256_setzero_ps();
+					const __m256 one = _mm256_set1_ps(1.0f);
+					const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+					for (; i + 32 <= count; i += 32)
+					{
+						__m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 0), zero), one), scale));
+						__m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 8), zero), one), scale));
+						__m256i c = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 16), zero), one), scale));
+						__m256i d = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 24), zero), one), scale));
+						__m256i v = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+						_mm256_storeu_si256((__m256i*)(dst + i), _mm256_permutevar8x32_epi32(v, order));
+					}
+				}
+#endif
+#if defined(__SSE2__)
+				if (simd)
+				{
+					const __m128 scale = _mm_set1_ps(255.0f);
+					const __m128 zero = _mm_setzero_ps();
+					const __m128 one = _mm_set1_ps(1.0f);
+					for (; i + 16 <= count; i += 16)
+					{
+						__m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 0), zero), one), scale));
+						__m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), zero), one), scale));
+						__m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 8), zero), one), scale));
+						__m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 12), zero), one), scale));
+						_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+					}
+				}
+#elif !defined(__AVX2__)
+				(void)simd;
+#endif
+				for (; i < count; i++)
+					dst[i] = (std::uint8_t)std::lrint(saturate(src[i]) * 255.0f);
+			}
+
+			void decodeHalf(const std::uint16_t* src, float* dst, std::size_t count, bool simd) noexcept
+			{
+				std::size_t i = 0;
+#if defined(__F16C__)
+				if (simd)
+				{
+					for (; i + 4 <= count; i += 4)
+						_mm_storeu_ps(dst + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(src + i))));
+				}
+#elif defined(__SSE2__)
+				if (simd)
+				{
+					// Shifts exponent and mantissa into place and rebiases with a multiply, which also
+					// renormalizes subnormals. Infinities and NaNs get their exponent forced to all ones.
+					const __m128i zero = _mm_setzero_si128();
+					const __m128i noSign = _mm_set1_epi32(0x7fff);
+					const __m128i maxFinite = _mm_set1_epi32(0x7bff);
+					const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+					const __m128 infNaN = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+
+					for (; i + 4 <= count; i += 4)
+					{
+						__m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(src + i)), zero);
+						__m128i bits = _mm_and_si128(h, noSign);
+						__m128i sign = _mm_slli_epi32(_mm_xor_si128(h, bits), 16);
+						__m128 value = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(bits, 13)), magic);
+						__m128 special = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(bits, maxFinite)), infNaN);
+						_mm_storeu_ps(dst + i, _mm_or_ps(value, _mm_or_ps(_mm_castsi128_ps(sign), special)));
+					}
+				}
+#else
+				(void)simd;
+#endif
+				for (; i < count; i++)
+					dst[i] = PixelCodec::halfToFloat(src[i]);
+			}
+
+			void encodeHalf(const float* src, std::uint16_t* dst, std::size_t count, bool simd) noexcept
+			{
+				std::size_t i = 0;
+#if defined(__F16C__)
+				if (simd)
+				{
+					for (; i + 4 <= count; i += 4)
+					{
+						// Only NaNs differ from the scalar loop, which does not keep their payload.
+						_mm_storel_epi64((__m128i*)(dst + i), _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+					}
+				}
+#else
+				(void)simd;
+#endif
+				for (; i < count; i++)
+					dst[i] = PixelCodec::floatToHalf(src[i]);
+			}
+
+			template<typename T>
+			void decodeInt(const T* src, float* dst, std::size_t count) noexcept
+			{
+				for (std::size_t i = 0; i < count; i++)
+					dst[i] = (float)src[i];
+			}
+
+			template<typename T>
+			void encodeInt(const float* src, T* dst, std::size_t count) noexcept
+			{
+				// The largest doubles that still convert back into range.
+				constexpr double lo = (double)std::numeric_limits<T>::min();
+				constexpr double hi = sizeof(T) < 8 ? (double)std::numeric_limits<T>::max() : std::is_signed<T>::value ? 9223372036854774784.0 : 18446744073709549568.0;
+
+				for (std::size_t i = 0; i < count; i++)
+				{
+					double v = std::nearbyint((double)src[i]);
+					v = v > lo ? v : lo;
+					v = v < hi ? v : hi;
+					dst[i] = (T)v;
+				}
+			}
+
+			// Unsigned floats with a 5 bit exponent, as in B10G11R11.
+			float fromUFloat(std::uint32_t value, int mantissa) noexcept
+			{
+				std::uint32_t exponent = value >> mantissa;
+				std::uint32_t fraction = value & ((1u << mantissa) - 1);
+
+				if (exponent == 0)
+					return std::ldexp((float)fraction, -14 - mantissa);
+				if (exponent == 31)
+					return fraction ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+
+				return std::ldexp((float)((1u << mantissa) + fraction), (int)exponent - 15 - mantissa);
+			}
+
+			std::uint32_t toUFloat(float value, int mantissa) noexcept
+			{
+				std::uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(float));
+
+				if ((bits & 0x7fffffff) > 0x7f800000)
+					return (31u << mantissa) | (1u << (mantissa - 1));
+				if ((bits & 0x80000000) || bits == 0)
+					return 0;
+				if (bits >= (143u << 23))
+					return 31u << mantissa;
+
+				if (bits < (113u << 23))
+				{
+					// Adding a power of two whose ulp is the smallest subnormal rounds to nearest even.
+					std::uint32_t magicBits = ((127 - 15) + (23 - mantissa) + 1) << 23;
+
+					float magic;
+					std::memcpy(&magic, &magicBits, sizeof(float));
+
+					value += magic;
+					std::memcpy(&bits, &value, sizeof(float));
+					return bits - magicBits;
+				}
+
+				int shift = 23 - mantissa;
+				bits += ((std::uint32_t)(15 - 127) << 23) + ((1u << (shift - 1)) - 1) + ((bits >> shift) & 1);
+				return bits >> shift;
+			}
+
+			void fromSharedExponent(std::uint32_t value, float rgb[3]) noexcept
+			{
+				int exponent = (int)(value >> 27) - 15 - 9;
+				rgb[0] = std::ldexp((float)(value & 511), exponent);
+				rgb[1] = std::ldexp((float)((value >> 9) & 511), exponent);
+				rgb[2] = std::ldexp((float)((value >> 18) & 511), exponent);
+			}
+
+			std::uint32_t toSharedExponent(const float rgb[3]) noexcept
+			{
+				constexpr float maxValue = 511.0f / 512.0f * 65536.0f;
+
+				float c[3];
+				for (int i = 0; i < 3; i++)
+				{
+					c[i] = rgb[i] > 0.0f ? rgb[i] : 0.0f;
+					c[i] = c[i] < maxValue ? c[i] : maxValue;
+				}
+
+				float maxChannel = std::max(c[0], std::max(c[1], c[2]));
+
+				int exponent = -16;
+				if (maxChannel > 0.0f)
+				{
+					std::frexp(maxChannel, &exponent);
+					exponent = std::max(exponent - 1, -16);
+				}
+
+				exponent += 1 + 15;
+
+				float scale = std::ldexp(1.0f, 15 + 9 - exponent);
+				if (std::floor(maxChannel * scale + 0.5f) >= 512.0f)
+				{
+					scale *= 0.5f;
+					exponent++;
+				}
+
+				std::uint32_t r = (std::uint32_t)std::floor(c[0] * scale + 0.5f);
+				std::uint32_t g = (std::uint32_t)std::floor(c[1] * scale + 0.5f);
+				std::uint32_t b = (std::uint32_t)std::floor(c[2] * scale + 0.5f);
+
+				return ((std::uint32_t)exponent << 27) | (b << 18) | (g << 9) | r;
+			}
+		}
+
+		PixelCodec::PixelCodec(const Format& format) except
+			: packed_(false)
+			, luminance_(false)
+			, accelerated_(true)
+			, swizzle_{ -1, -1, -1, -1 }
+			, fields_{}
+		{
+			struct Packing
+			{
+				Format::Type format;
+				Kind kind;
+				std::uint8_t channel;
+				Field fields[4];
+			};
+
+			// Fields in RGBA order, E5B9G9R9 keeps its exponent in the fourth.
+			static const Packing packings[] =
+			{
+				{ Format::R4G4UNormPack8, Kind::UNorm, 2, { { 4, 4 }, { 0, 4 } } },
+				{ Format::R4G4B4A4UNormPack16, Kind::UNorm, 4, { { 12, 4 }, { 8, 4 }, { 4, 4 }, { 0, 4 } } },
+				{ Format::B4G4R4A4UNormPack16, Kind::UNorm, 4, { { 4, 4 }, { 8, 4 }, { 12, 4 }, { 0, 4 } } },
+				{ Format::R5G6B5UNormPack16, Kind::UNorm, 3, { { 11, 5 }, { 5, 6 }, { 0, 5 } } },
+				{ Format::B5G6R5UNormPack16, Kind::UNorm, 3, { { 0, 5 }, { 5, 6 }, { 11, 5 } } },
+				{ Format::R5G5B5A1UNormPack16, Kind::UNorm, 4, { { 11, 5 }, { 6, 5 }, { 1, 5 }, { 0, 1 } } },
+				{ Format::B5G5R5A1UNormPack16, Kind::UNorm, 4, { { 1, 5 }, { 6, 5 }, { 11, 5 }, { 0, 1 } } },
+				{ Format::A1R5G5B5UNormPack16, Kind::UNorm, 4, { { 10, 5 }, { 5, 5 }, { 0, 5 }, { 15, 1 } } },
+				{ Format::A2R10G10B10UNormPack32, Kind::UNorm, 4, { { 20, 10 }, { 10, 10 }, { 0, 10 }, { 30, 2 } } },
+				{ Format::A2R10G10B10SNormPack32, Kind::SNorm, 4, { { 20, 10 }, { 10, 10 }, { 0, 10 }, { 30, 2 } } },
+				{ Format::A2R10G10B10UScaledPack32, Kind::UInt, 4, { { 20, 10 }, { 10, 10 }, { 0, 10 }, { 30, 2 } } },
+				{ Format::A2R10G10B10SScaledPack32, Kind::SInt, 4, { { 20, 10 }, { 10, 10 }, { 0, 10 }, { 30, 2 } } },
+				{ Format::A2R10G10B10UIntPack32, Kind::UInt, 4, { { 20, 10 }, { 10, 10 }, { 0, 10 }, { 30, 2 } } },
+				{ Format::A2R10G10B10SIntPack32, Kind::SInt, 4, { { 20, 10 }, { 10, 10 }, { 0, 10 }, { 30, 2 } } },
+				{ Format::A2B10G10R10UNormPack32, Kind::UNorm, 4, { { 0, 10 }, { 10, 10 }, { 20, 10 }, { 30, 2 } } },
+				{ Format::A2B10G10R10SNormPack32, Kind::SNorm, 4, { { 0, 10 }, { 10, 10 }, { 20, 10 }, { 30, 2 } } },
+				{ Format::A2B10G10R10UScaledPack32, Kind::UInt, 4, { { 0, 10 }, { 10, 10 }, { 20, 10 }, { 30, 2 } } },
+				{ Format::A2B10G10R10SScaledPack32, Kind::SInt, 4, { { 0, 10 }, { 10, 10 }, { 20, 10 }, { 30, 2 } } },
+				{ Format::A2B10G10R10UIntPack32, Kind::UInt, 4, { { 0, 10 }, { 10, 10 }, { 20, 10 }, { 30, 2 } } },
+				{ Format::A2B10G10R10SIntPack32, Kind::SInt, 4, { { 0, 10 }, { 10, 10 }, { 20, 10 }, { 30, 2 } } },
+				{ Format::B10G11R11UFloatPack32, Kind::UFloat11_11_10, 3, { { 0, 11 }, { 11, 11 }, { 22, 10 } } },
+				{ Format::E5B9G9R9UFloatPack32, Kind::SharedExponent, 3, { { 0, 9 }, { 9, 9 }, { 18, 9 }, { 27, 5 } } },
+				{ Format::X8_D24UNormPack32, Kind::UNorm, 1, { { 0, 24 } } },
+			};
+
+			for (auto& packing : packings)
+			{
+				if (format == packing.format)
+				{
+					kind_ = packing.kind;
+					packed_ = true;
+					channel_ = packing.channel;
+					pixelSize_ = format.pixel_size();
+					typeSize_ = pixelSize_;
+
+					for (std::uint8_t c = 0; c < 4; c++)
+					{
+						fields_[c] = packing.fields[c];
+						if (c < channel_)
+							swizzle_[c] = c;
+					}
+
+					return;
+				}
+			}
+
+			switch (format.value_type())
+			{
+			case value_t::UNorm: kind_ = Kind::UNorm; break;
+			case value_t::SNorm: kind_ = Kind::SNorm; break;
+			case value_t::UInt: kind_ = Kind::UInt; break;
+			case value_t::UScaled: kind_ = Kind::UInt; break;
+			case value_t::SInt: kind_ = Kind::SInt; break;
+			case value_t::SScaled: kind_ = Kind::SInt; break;
+			case value_t::SRGB: kind_ = Kind::SRGB; break;
+			case value_t::Float: kind_ = Kind::Float; break;
+			default:
+				throw runtime::not_implemented::create("PixelCodec : compressed and depth stencil formats are not supported");
+			}
+
+			channel_ = format.channel();
+			pixelSize_ = format.pixel_size();
+			typeSize_ = pixelSize_ / channel_;
+
+			if ((format >= Format::L8UNorm && format <= Format::L8SRGB) || (format >= Format::L16UNorm && format <= Format::L16SFloat))
+			{
+				luminance_ = true;
+				swizzle_[0] = swizzle_[1] = swizzle_[2] = 0;
+			}
+			else if ((format >= Format::L8A8UNorm && format <= Format::L8A8SRGB) || (format >= Format::L16A16UNorm && format <= Format::L16A16SRGB))
+			{
+				luminance_ = true;
+				swizzle_[0] = swizzle_[1] = swizzle_[2] = 0;
+				swizzle_[3] = 1;
+			}
+			else if ((format >= Format::A8UNorm && format <= Format::A8SRGB) || (format >= Format::A16UNorm && format <= Format::A16SFloat))
+			{
+				swizzle_[3] = 0;
+			}
+			else
+			{
+				static const std::int8_t swizzles[][4] =
+				{
+					{ 0, -1, -1, -1 },
+					{ 0, 1, -1, -1 },
+					{ 0, 1, 2, -1 },
+					{ 2, 1, 0, -1 },
+					{ 0, 1, 2, 3 },
+					{ 2, 1, 0, 3 },
+				};
+
+				// A8B8G8R8 keeps red in the low byte, which puts it first in memory.
+				std::size_t index;
+				switch (format.swizzle_type())
+				{
+				case swizzle_t::R: index = 0; break;
+				case swizzle_t::RG: index = 1; break;
+				case swizzle_t::RGB: index = 2; break;
+				case swizzle_t::BGR: index = 3; break;
+				case swizzle_t::RGBA: index = 4; break;
+				case swizzle_t::ABGR: index = 4; break;
+				case swizzle_t::BGRA: index = 5; break;
+				case swizzle_t::Depth: index = 0; break;
+				case swizzle_t::Stencil: index = 0; break;
+				default:
+					throw runtime::not_implemented::create("PixelCodec : unsupported format");
+				}
+
+				std::memcpy(swizzle_, swizzles[index], sizeof(swizzle_));
+			}
+		}
+
+		std::uint8_t
+		PixelCodec::channel() const noexcept
+		{
+			return channel_;
+		}
+
+		std::uint32_t
+		PixelCodec::pixelSize() const noexcept
+		{
+			return pixelSize_;
+		}
+
+		std::int8_t
+		PixelCodec::alpha() const noexcept
+		{
+			return swizzle_[3];
+		}
+
+		const std::int8_t*
+		PixelCodec::swizzle() const noexcept
+		{
+			return swizzle_;
+		}
+
+		bool
+		PixelCodec::srgb() const noexcept
+		{
+			return kind_ == Kind::SRGB;
+		}
+
+		bool
+		PixelCodec::unorm() const noexcept
+		{
+			return kind_ == Kind::UNorm || kind_ == Kind::SRGB;
+		}
+
+		bool
+		PixelCodec::luminance() const noexcept
+		{
+			return luminance_;
+		}
+
+		bool
+		PixelCodec::compatible(const PixelCodec& other) const noexcept
+		{
+			// 16 bit sRGB does not survive a round trip through floats bit for bit, keep it on the float path.
+			if (packed_ || other.packed_ || kind_ != other.kind_ || typeSize_ != other.typeSize_)
+				return false;
+
+			return kind_ != Kind::SRGB || typeSize_ == 1;
+		}
+
+		void
+		PixelCodec::setAccelerated(bool enable) noexcept
+		{
+			accelerated_ = enable;
+		}
+
+		bool
+		PixelCodec::getAccelerated() const noexcept
+		{
+			return accelerated_;
+		}
+
+		void
+		PixelCodec::decode(const void* src, float* dst, std::size_t pixels) const noexcept
+		{
+			if (packed_)
+			{
+				this->decodePacked(src, dst, pixels);
+				return;
+			}
+
+			std::size_t count = pixels * channel_;
+			std::int8_t alpha = swizzle_[3];
+
+			switch (kind_)
+			{
+			case Kind::UNorm:
+				if (typeSize_ == 1) decodeNorm((const std::uint8_t*)src, dst, count, accelerated_);
+				else if (typeSize_ == 2) decodeNorm((const std::uint16_t*)src, dst, count, accelerated_);
+				else if (typeSize_ == 4) decodeNorm((const std::uint32_t*)src, dst, count, accelerated_);
+				break;
+			case Kind::SNorm:
+				if (typeSize_ == 1) decodeNorm((const std::int8_t*)src, dst, count, accelerated_);
+				else if (typeSize_ == 2) decodeNorm((const std::int16_t*)src, dst, count, accelerated_);
+				else if (typeSize_ == 4) decodeNorm((const std::int32_t*)src, dst, count, accelerated_);
+				break;
+			case Kind::UInt:
+				if (typeSize_ == 1) decodeInt((const std::uint8_t*)src, dst, count);
+				else if (typeSize_ == 2) decodeInt((const std::uint16_t*)src, dst, count);
+				else if (typeSize_ == 4) decodeInt((const std::uint32_t*)src, dst, count);
+				else decodeInt((const std::uint64_t*)src, dst, count);
+				break;
+			case Kind::SInt:
+				if (typeSize_ == 1) decodeInt((const std::int8_t*)src, dst, count);
+				else if (typeSize_ == 2) decodeInt((const std::int16_t*)src, dst, count);
+				else if (typeSize_ == 4) decodeInt((const std::int32_t*)src, dst, count);
+				else decodeInt((const std::int64_t*)src, dst, count);
+				break;
+			case Kind::SRGB:
+				if (typeSize_ == 1)
+				{
+					auto& table = srgbTables().decode;
+					auto data = (const std::uint8_t*)src;
+					for (std::size_t i = 0; i < count; i += channel_)
+					{
+						for (std::uint8_t c = 0; c < channel_; c++)
+							dst[i + c] = c == alpha ? data[i + c] * (1.0f / 255.0f) : table[data[i + c]];
+					}
+				}
+				else
+				{
+					decodeNorm((const std::uint16_t*)src, dst, count, accelerated_);
+					for (std::size_t i = 0; i < count; i += channel_)
+					{
+						for (std::uint8_t c = 0; c < channel_; c++)
+						{
+							if (c != alpha)
+								dst[i + c] = srgbToLinear(dst[i + c]);
+						}
+					}
+				}
+				break;
+			case Kind::Float:
+				if (typeSize_ == 2)
+				{
+					decodeHalf((const std::uint16_t*)src, dst, count, accelerated_);
+				}
+				else if (typeSize_ == 4)
+				{
+					std::memcpy(dst, src, count * sizeof(float));
+				}
+				else
+				{
+					auto data = (const double*)src;
+					for (std::size_t i = 0; i < count; i++)
+						dst[i] = (float)data[i];
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		void
+		PixelCodec::encode(const float* src, void* dst, std::size_t pixels) const noexcept
+		{
+			if (packed_)
+			{
+				this->encodePacked(src, dst, pixels);
+				return;
+			}
+
+			std::size_t count = pixels * channel_;
+			std::int8_t alpha = swizzle_[3];
+
+			switch (kind_)
+			{
+			case Kind::UNorm:
+				if (typeSize_ == 1) encodeNorm(src, (std::uint8_t*)dst, count, accelerated_);
+				else if (typeSize_ == 2) encodeNorm(src, (std::uint16_t*)dst, count, accelerated_);
+				else if (typeSize_ == 4) encodeNorm(src, (std::uint32_t*)dst, count, accelerated_);
+				break;
+			case Kind::SNorm:
+				if (typeSize_ == 1) encodeNorm(src, (std::int8_t*)dst, count, accelerated_);
+				else if (typeSize_ == 2) encodeNorm(src, (std::int16_t*)dst, count, accelerated_);
+				else if (typeSize_ == 4) encodeNorm(src, (std::int32_t*)dst, count, accelerated_);
+				break;
+			case Kind::UInt:
+				if (typeSize_ == 1) encodeInt(src, (std::uint8_t*)dst, count);
+				else if (typeSize_ == 2) encodeInt(src, (std::uint16_t*)dst, count);
+				else if (typeSize_ == 4) encodeInt(src, (std::uint32_t*)dst, count);
+				else encodeInt(src, (std::uint64_t*)dst, count);
+				break;
+			case Kind::SInt:
+				if (typeSize_ == 1) encodeInt(src, (std::int8_t*)dst, count);
+				else if (typeSize_ == 2) encodeInt(src, (std::int16_t*)dst, count);
+				else if (typeSize_ == 4) encodeInt(src, (std::int32_t*)dst, count);
+				else encodeInt(src, (std::int64_t*)dst, count);
+				break;
+			case Kind::SRGB:
+				if (typeSize_ == 1)
+				{
+					auto& tables = srgbTables();
+					auto data = (std::uint8_t*)dst;
+					for (std::size_t i = 0; i < count; i += channel_)
+					{
+						for (std::uint8_t c = 0; c < channel_; c++)
+						{
+							float v = src[i + c];
+							if (c == alpha)
+								data[i + c] = (std::uint8_t)std::lrint(saturate(v) * 255.0f);
+							else
+								data[i + c] = tables.toSRGB8(v);
+						}
+					}
+				}
+				else
+				{
+					auto data = (std::uint16_t*)dst;
+					for (std::size_t i = 0; i < count; i += channel_)
+					{
+						for (std::uint8_t c = 0; c < channel_; c++)
+						{
+							float v = saturate(src[i + c]);
+							data[i + c] = (std::uint16_t)std::lrint((c == alpha ? v : linearToSRGB(v)) * 65535.0f);
+						}
+					}
+				}
+				break;
+			case Kind::Float:
+				if (typeSize_ == 2)
+				{
+					encodeHalf(src, (std::uint16_t*)dst, count, accelerated_);
+				}
+				else if (typeSize_ == 4)
+				{
+					std::memcpy(dst, src, count * sizeof(float));
+				}
+				else
+				{
+					auto data = (double*)dst;
+					for (std::size_t i = 0; i < count; i++)
+						data[i] = src[i];
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		void
+		PixelCodec::decodePacked(const void* src, float* dst, std::size_t pixels) const noexcept
+		{
+			auto data = (const std::uint8_t*)src;
+
+			for (std::size_t i = 0; i < pixels; i++, data += pixelSize_, dst += channel_)
+			{
+				std::uint32_t value = 0;
+				std::memcpy(&value, data, pixelSize_);
+
+				if (kind_ == Kind::SharedExponent)
+				{
+					fromSharedExponent(value, dst);
+					continue;
+				}
+
+				for (std::uint8_t c = 0; c < channel_; c++)
+				{
+					const Field& field = fields_[c];
+
+					std::uint32_t bits = (value >> field.shift) & ((1u << field.bits) - 1);
+					std::int32_t sbits = (std::int32_t)(bits << (32 - field.bits)) >> (32 - field.bits);
+
+					switch (kind_)
+					{
+					case Kind::UNorm: dst[c] = bits / (float)((1u << field.bits) - 1); break;
+					case Kind::SNorm: dst[c] = std::max(sbits / (float)((1u << (field.bits - 1)) - 1), -1.0f); break;
+					case Kind::UInt: dst[c] = (float)bits; break;
+					case Kind::SInt: dst[c] = (float)sbits; break;
+					case Kind::UFloat11_11_10: dst[c] = fromUFloat(bits, field.bits - 5); break;
+					default: break;
+					}
+				}
+			}
+		}
+
+		void
+		PixelCodec::encodePacked(const float* src, void* dst, std::size_t pixels) const noexcept
+		{
+			auto data = (std::uint8_t*)dst;
+
+			for (std::size_t i = 0; i < pixels; i++, data += pixelSize_, src += channel_)
+			{
+				std::uint32_t value = 0;
+
+				if (kind_ == Kind::SharedExponent)
+				{
+					value = toSharedExponent(src);
+				}
+				else
+				{
+					for (std::uint8_t c = 0; c < channel_; c++)
+					{
+						const Field& field = fields_[c];
+
+						float v = src[c];
+						float max = (float)((1u << field.bits) - 1);
+						float smax = (float)((1u << (field.bits - 1)) - 1);
+
+						std::int32_t bits = 0;
+						switch (kind_)
+						{
+						case Kind::UNorm: bits = (std::int32_t)std::lrint(saturate(v) * max); break;
+						case Kind::SNorm: bits = (std::int32_t)std::lrint(clampSigned(v) * smax); break;
+						case Kind::UInt: v = std::nearbyint(v); bits = (std::int32_t)(v > 0.0f ? (v < max ? v : max) : 0.0f); break;
+						case Kind::SInt: v = std::nearbyint(v); bits = (std::int32_t)(v > -smax - 1.0f ? (v < smax ? v : smax) : -smax - 1.0f); break;
+						case Kind::UFloat11_11_10: bits = (std::int32_t)toUFloat(v, field.bits - 5); break;
+						default: break;
+						}
+
+						value |= ((std::uint32_t)bits & ((1u << field.bits) - 1)) << field.shift;
+					}
+				}
+
+				std::memcpy(data, &value, pixelSize_);
+			}
+		}
+
+		float
+		PixelCodec::srgbToLinear(float value) noexcept
+		{
+			return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float
+		PixelCodec::linearToSRGB(float value) noexcept
+		{
+			return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		}
+
+		float
+		PixelCodec::halfToFloat(std::uint16_t value) noexcept
+		{
+			std::uint32_t bits = (std::uint32_t)(value & 0x7fff) << 13;
+			std::uint32_t exponent = bits & (0x7c00 << 13);
+
+			bits += (127 - 15) << 23;
+
+			float result;
+			if (exponent == (0x7c00 << 13))
+			{
+				bits += (128 - 16) << 23;
+				std::memcpy(&result, &bits, sizeof(float));
+			}
+			else if (exponent == 0)
+			{
+				// Subnormals, renormalized by the float unit.
+				bits += 1 << 23;
+				std::memcpy(&result, &bits, sizeof(float));
+				result -= 6.10351562e-05f;
+			}
+			else
+			{
+				std::memcpy(&result, &bits, sizeof(float));
+			}
+
+			return (value & 0x8000) ? -result : result;
+		}
+
+		std::uint16_t
+		PixelCodec::floatToHalf(float value) noexcept
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(float));
+
+			std::uint16_t sign = (bits >> 16) & 0x8000;
+			bits &= 0x7fffffff;
+
+			if (bits >= 0x47800000)
+				return sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+			if (bits < 0x38800000)
+			{
+				// Adding 0.5 lines the subnormal up with the float mantissa and rounds it to nearest even.
+				float f;
+				std::memcpy(&f, &bits, sizeof(float));
+				f += 0.5f;
+				std::memcpy(&bits, &f, sizeof(float));
+				return sign | (std::uint16_t)(bits - 0x3f000000);
+			}
+
+			bits += ((std::uint32_t)(15 - 127) << 23) + 0xfff + ((bits >> 13) & 1);
+			return sign | (std::uint16_t)(bits >> 13);
+		}
+	}
+}
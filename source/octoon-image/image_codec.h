@@ -0,0 +1,89 @@
+#ifndef OCTOON_IMAGE_CODEC_H_
+#define OCTOON_IMAGE_CODEC_H_
+
+#include <octoon/image/image_format.h>
+
+namespace octoon
+{
+	namespace image
+	{
+		// Converts rows of any uncompressed format to floats and back. Normalized formats map
+		// to [0, 1] or [-1, 1], integer formats keep their values and the color channels of sRGB
+		// formats come out linear. Packed formats are split into RGBA order.
+		class PixelCodec final
+		{
+		public:
+			PixelCodec(const Format& format) except;
+
+			std::uint8_t channel() const noexcept;
+			std::uint32_t pixelSize() const noexcept;
+
+			// Index of the alpha channel, -1 for formats without one.
+			std::int8_t alpha() const noexcept;
+
+			// Channel holding red, green, blue and alpha, -1 where the format has none.
+			// Luminance formats store all three colors in channel 0.
+			const std::int8_t* swizzle() const noexcept;
+
+			bool srgb() const noexcept;
+			bool unorm() const noexcept;
+			bool luminance() const noexcept;
+
+			// True when channels can be copied bytewise between both formats without changing their value.
+			bool compatible(const PixelCodec& other) const noexcept;
+
+			// Falls back to the scalar loops, which give the same results.
+			void setAccelerated(bool enable) noexcept;
+			bool getAccelerated() const noexcept;
+
+			void decode(const void* src, float* dst, std::size_t pixels) const noexcept;
+			void encode(const float* src, void* dst, std::size_t pixels) const noexcept;
+
+		public:
+			static float srgbToLinear(float value) noexcept;
+			static float linearToSRGB(float value) noexcept;
+
+			static float halfToFloat(std::uint16_t value) noexcept;
+			static std::uint16_t floatToHalf(float value) noexcept;
+
+		private:
+			enum class Kind : std::uint8_t
+			{
+				UNorm,
+				SNorm,
+				UInt,
+				SInt,
+				SRGB,
+				Float,
+				UFloat11_11_10,
+				SharedExponent,
+			};
+
+			struct Field
+			{
+				std::uint8_t shift;
+				std::uint8_t bits;
+			};
+
+			void decodePacked(const void* src, float* dst, std::size_t pixels) const noexcept;
+			void encodePacked(const float* src, void* dst, std::size_t pixels) const noexcept;
+
+		private:
+			Kind kind_;
+			bool packed_;
+			bool luminance_;
+			bool accelerated_;
+
+			std::uint8_t channel_;
+			std::uint8_t typeSize_;
+			std::uint8_t pixelSize_;
+
+			std::int8_t swizzle_[4];
+
+			// Bit fields of packed formats in RGBA order.
+			Field fields_[4];
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,400 @@
+#include <octoon/image/image_compressor.h>
+#include <octoon/image/image_converter.h>
+#include <octoon/runtime/except.h>
+#include <octoon/runtime/thread_pool.h>
+
+#include "image_bcn.h"
+
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			enum class BlockKind : std::uint8_t
+			{
+				BC1,
+				BC1Alpha,
+				BC2,
+				BC3,
+				BC4,
+				BC5,
+				BC6H,
+				BC7,
+			};
+
+			struct BlockFormat
+			{
+				Format::Type type;
+				BlockKind kind;
+				bool sign;
+				Format::Type texels;
+				Format::Type decoded;
+			};
+
+			constexpr BlockFormat BlockFormats[] =
+			{
+				{ Format::BC1RGBUNormBlock, BlockKind::BC1, false, Format::R8G8B8A8UNorm, Format::R8G8B8A8UNorm },
+				{ Format::BC1RGBSRGBBlock, BlockKind::BC1, false, Format::R8G8B8A8SRGB, Format::R8G8B8A8SRGB },
+				{ Format::BC1RGBAUNormBlock, BlockKind::BC1Alpha, false, Format::R8G8B8A8UNorm, Format::R8G8B8A8UNorm },
+				{ Format::BC1RGBASRGBBlock, BlockKind::BC1Alpha, false, Format::R8G8B8A8SRGB, Format::R8G8B8A8SRGB },
+				{ Format::BC2UNormBlock, BlockKind::BC2, false, Format::R8G8B8A8UNorm, Format::R8G8B8A8UNorm },
+				{ Format::BC2SRGBBlock, BlockKind::BC2, false, Format::R8G8B8A8SRGB, Format::R8G8B8A8SRGB },
+				{ Format::BC3UNormBlock, BlockKind::BC3, false, Format::R8G8B8A8UNorm, Format::R8G8B8A8UNorm },
+				{ Format::BC3SRGBBlock, BlockKind::BC3, false, Format::R8G8B8A8SRGB, Format::R8G8B8A8SRGB },
+				{ Format::BC4UNormBlock, BlockKind::BC4, false, Format::R32G32B32A32SFloat, Format::R32G32B32A32SFloat },
+				{ Format::BC4SNormBlock, BlockKind::BC4, true, Format::R32G32B32A32SFloat, Format::R32G32B32A32SFloat },
+				{ Format::BC5UNormBlock, BlockKind::BC5, false, Format::R32G32B32A32SFloat, Format::R32G32B32A32SFloat },
+				{ Format::BC5SNormBlock, BlockKind::BC5, true, Format::R32G32B32A32SFloat, Format::R32G32B32A32SFloat },
+				{ Format::BC6HUFloatBlock, BlockKind::BC6H, false, Format::R32G32B32A32SFloat, Format::R16G16B16A16SFloat },
+				{ Format::BC6HSFloatBlock, BlockKind::BC6H, true, Format::R32G32B32A32SFloat, Format::R16G16B16A16SFloat },
+				{ Format::BC7UNormBlock, BlockKind::BC7, false, Format::R8G8B8A8UNorm, Format::R8G8B8A8UNorm },
+				{ Format::BC7SRGBBlock, BlockKind::BC7, false, Format::R8G8B8A8SRGB, Format::R8G8B8A8SRGB },
+			};
+
+			const BlockFormat* findBlockFormat(const Format& format) noexcept
+			{
+				for (auto& it : BlockFormats)
+				{
+					if (format == it.type)
+						return &it;
+				}
+
+				return nullptr;
+			}
+
+			std::uint32_t blockSize(BlockKind kind) noexcept
+			{
+				return (kind == BlockKind::BC1 || kind == BlockKind::BC1Alpha || kind == BlockKind::BC4) ? 8 : 16;
+			}
+
+			// One depth slice of one layer of one level, in both images.
+			struct Surface
+			{
+				std::size_t texelOffset;
+				std::size_t blockOffset;
+				std::uint32_t width;
+				std::uint32_t height;
+			};
+
+			std::vector<Surface> surfaces(const Image& image, std::uint32_t levels, std::uint32_t texelSize, std::uint32_t blockSize) noexcept
+			{
+				std::vector<Surface> result;
+
+				std::size_t texelOffset = 0;
+				std::size_t blockOffset = 0;
+
+				for (std::uint32_t mip = 0; mip < levels; mip++)
+				{
+					std::uint32_t w = std::max(image.width() >> mip, 1u);
+					std::uint32_t h = std::max(image.height() >> mip, 1u);
+
+					for (std::uint32_t slice = 0; slice < image.layerLevel() * image.depth(); slice++)
+					{
+						result.push_back(Surface{ texelOffset, blockOffset, w, h });
+
+						texelOffset += (std::size_t)w * h * texelSize;
+						blockOffset += (std::size_t)((w + 3) / 4) * ((h + 3) / 4) * blockSize;
+					}
+				}
+
+				return result;
+			}
+
+			// Every row of blocks of every surface is one job.
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> blockRows(const std::vector<Surface>& list) noexcept
+			{
+				std::vector<std::pair<std::uint32_t, std::uint32_t>> rows;
+				for (std::uint32_t i = 0; i < list.size(); i++)
+				{
+					for (std::uint32_t row = 0; row < (list[i].height + 3) / 4; row++)
+						rows.emplace_back(i, row);
+				}
+
+				return rows;
+			}
+		}
+
+		BlockCompressor::BlockCompressor(CompressQuality quality) noexcept
+			: quality_(quality)
+			, filter_(MipmapFilter::Box)
+		{
+		}
+
+		BlockCompressor::~BlockCompressor() noexcept
+		{
+		}
+
+		void
+		BlockCompressor::setQuality(CompressQuality quality) noexcept
+		{
+			quality_ = quality;
+		}
+
+		CompressQuality
+		BlockCompressor::getQuality() const noexcept
+		{
+			return quality_;
+		}
+
+		void
+		BlockCompressor::setMipmapFilter(MipmapFilter filter) noexcept
+		{
+			filter_ = filter;
+		}
+
+		MipmapFilter
+		BlockCompressor::getMipmapFilter() const noexcept
+		{
+			return filter_;
+		}
+
+		void
+		BlockCompressor::compress(const Image& src, Image& dst, const Format& format, std::uint32_t levels) const except
+		{
+			auto info = findBlockFormat(format);
+			if (!info)
+				throw runtime::runtime_error::create("BlockCompressor : the destination is not a BC format");
+
+			if (src.empty())
+				throw runtime::runtime_error::create("BlockCompressor : the source image is empty");
+
+			if (!FormatConverter::isSupported(src.format()))
+				throw runtime::runtime_error::create("BlockCompressor : the source format cannot be read");
+
+			if (&src == &dst)
+				throw runtime::runtime_error::create("BlockCompressor : cannot compress an image into itself");
+
+			std::uint32_t full = 1;
+			while ((std::max(src.width(), src.height()) >> full) > 0)
+				full++;
+
+			levels = levels == 0 ? full : std::min(levels, full);
+
+			Image converted;
+			Image chain;
+
+			const Image* texels = &src;
+			if (src.format() != info->texels)
+			{
+				FormatConverter(src.format(), info->texels).convert(src, converted);
+				texels = &converted;
+			}
+
+			if (texels->mipLevel() < levels)
+			{
+				MipmapGenerator generator(filter_);
+				generator.generate(*texels, chain, levels);
+				texels = &chain;
+			}
+
+			dst.create(format, texels->width(), texels->height(), texels->depth(), levels, texels->layerLevel(), texels->mipBase(), texels->layerBase());
+
+			std::uint32_t texelSize = Format(info->texels).pixel_size();
+			std::uint32_t size = blockSize(info->kind);
+			auto list = surfaces(*texels, levels, texelSize, size);
+			auto rows = blockRows(list);
+
+			auto texelData = (const std::uint8_t*)texels->data();
+			auto blockData = (std::uint8_t*)dst.data();
+			bool high = quality_ == CompressQuality::High;
+
+			runtime::ThreadPool::instance()->parallel_for(0, rows.size(), 4, [&](std::size_t begin, std::size_t end)
+			{
+				std::uint8_t bytes[64];
+				float floats[64];
+
+				for (std::size_t job = begin; job < end; job++)
+				{
+					auto& surface = list[rows[job].first];
+					std::uint32_t row = rows[job].second;
+					std::uint32_t columns = (surface.width + 3) / 4;
+
+					auto source = texelData + surface.texelOffset;
+					auto block = blockData + surface.blockOffset + (std::size_t)row * columns * size;
+
+					for (std::uint32_t column = 0; column < columns; column++, block += size)
+					{
+						for (std::uint32_t y = 0; y < 4; y++)
+						{
+							std::uint32_t sy = std::min(row * 4 + y, surface.height - 1);
+							for (std::uint32_t x = 0; x < 4; x++)
+							{
+								std::uint32_t sx = std::min(column * 4 + x, surface.width - 1);
+								auto texel = source + ((std::size_t)sy * surface.width + sx) * texelSize;
+
+								if (texelSize == 4)
+									std::memcpy(bytes + (y * 4 + x) * 4, texel, 4);
+								else
+									std::memcpy(floats + (y * 4 + x) * 4, texel, 16);
+							}
+						}
+
+						switch (info->kind)
+						{
+						case BlockKind::BC1: encodeBC1(bytes, block, false, high); break;
+						case BlockKind::BC1Alpha: encodeBC1(bytes, block, true, high); break;
+						case BlockKind::BC2: encodeBC2(bytes, block, high); break;
+						case BlockKind::BC3: encodeBC3(bytes, block, high); break;
+						case BlockKind::BC4: encodeBC4(floats, block, info->sign, high); break;
+						case BlockKind::BC5: encodeBC5(floats, block, info->sign, high); break;
+						case BlockKind::BC6H: encodeBC6H(floats, block, info->sign, high); break;
+						case BlockKind::BC7: encodeBC7(bytes, block, high); break;
+						}
+					}
+				}
+			});
+		}
+
+		bool
+		BlockCompressor::isSupported(const Format& format) noexcept
+		{
+			return findBlockFormat(format) != nullptr;
+		}
+
+		BlockDecompressor::BlockDecompressor() noexcept
+			: accelerated_(true)
+		{
+		}
+
+		BlockDecompressor::~BlockDecompressor() noexcept
+		{
+		}
+
+		void
+		BlockDecompressor::setAccelerated(bool enable) noexcept
+		{
+			accelerated_ = enable;
+		}
+
+		bool
+		BlockDecompressor::getAccelerated() const noexcept
+		{
+			return accelerated_;
+		}
+
+		Format
+		BlockDecompressor::getDestFormat(const Format& format) noexcept
+		{
+			auto info = findBlockFormat(format);
+			return info ? info->decoded : Format::Undefined;
+		}
+
+		void
+		BlockDecompressor::decompress(const Image& src, Image& dst) const except
+		{
+			this->decompress(src, dst, getDestFormat(src.format()));
+		}
+
+		void
+		BlockDecompressor::decompress(const Image& src, Image& dst, const Format& format) const except
+		{
+			auto info = findBlockFormat(src.format());
+			if (!info)
+				throw runtime::runtime_error::create("BlockDecompressor : the source is not a BC format");
+
+			if (!FormatConverter::isSupported(format))
+				throw runtime::runtime_error::create("BlockDecompressor : the destination format cannot be written");
+
+			if (&src == &dst)
+				throw runtime::runtime_error::create("BlockDecompressor : cannot decompress an image into itself");
+
+			// Blocks decode to their own format, which goes through a converter a row at a time when
+			// another one is asked for.
+			std::unique_ptr<FormatConverter> converter;
+			if (format != info->decoded)
+			{
+				converter = std::make_unique<FormatConverter>(info->decoded, format);
+				converter->setAccelerated(accelerated_);
+			}
+
+			if (!dst.create(format, src.width(), src.height(), src.depth(), src.mipLevel(), src.layerLevel(), src.mipBase(), src.layerBase()))
+				throw runtime::runtime_error::create("BlockDecompressor : failed to create the image");
+
+			std::uint32_t decodedSize = Format(info->decoded).pixel_size();
+			std::uint32_t texelSize = format.pixel_size();
+			std::uint32_t size = blockSize(info->kind);
+
+			auto list = surfaces(src, src.mipLevel(), texelSize, size);
+			auto rows = blockRows(list);
+
+			auto blockData = (const std::uint8_t*)src.data();
+			auto texelData = (std::uint8_t*)dst.data();
+			bool simd = accelerated_;
+
+			runtime::ThreadPool::instance()->parallel_for(0, rows.size(), 4, [&](std::size_t begin, std::size_t end)
+			{
+				std::uint8_t bytes[64];
+				std::uint16_t halves[64];
+				float floats[64];
+
+				// BC4 and BC5 leave the channels they lack alone.
+				for (std::uint8_t i = 0; i < 16; i++)
+				{
+					floats[i * 4] = floats[i * 4 + 1] = floats[i * 4 + 2] = 0.0f;
+					floats[i * 4 + 3] = 1.0f;
+				}
+
+				const std::uint8_t* decoded = bytes;
+				if (info->kind == BlockKind::BC6H)
+					decoded = (const std::uint8_t*)halves;
+				else if (info->kind == BlockKind::BC4 || info->kind == BlockKind::BC5)
+					decoded = (const std::uint8_t*)floats;
+
+				std::vector<std::uint8_t> scratch;
+
+				for (std::size_t job = begin; job < end; job++)
+				{
+					auto& surface = list[rows[job].first];
+					std::uint32_t row = rows[job].second;
+					std::uint32_t columns = (surface.width + 3) / 4;
+					std::uint32_t height = std::min(surface.height - row * 4, 4u);
+
+					auto block = blockData + surface.blockOffset + (std::size_t)row * columns * size;
+					auto texels = texelData + surface.texelOffset + (std::size_t)row * 4 * surface.width * texelSize;
+
+					// Four rows of whole blocks when converting, the destination rows otherwise.
+					std::uint8_t* target = texels;
+					std::size_t pitch = (std::size_t)surface.width * texelSize;
+
+					if (converter)
+					{
+						pitch = (std::size_t)columns * 4 * decodedSize;
+						scratch.resize(pitch * 4);
+						target = scratch.data();
+					}
+
+					for (std::uint32_t column = 0; column < columns; column++, block += size)
+					{
+						switch (info->kind)
+						{
+						case BlockKind::BC1: decodeBC1(block, bytes, false, simd); break;
+						case BlockKind::BC1Alpha: decodeBC1(block, bytes, true, simd); break;
+						case BlockKind::BC2: decodeBC2(block, bytes, simd); break;
+						case BlockKind::BC3: decodeBC3(block, bytes, simd); break;
+						case BlockKind::BC4: decodeBC4(block, floats, info->sign); break;
+						case BlockKind::BC5: decodeBC5(block, floats, info->sign); break;
+						case BlockKind::BC6H: decodeBC6H(block, halves, info->sign); break;
+						case BlockKind::BC7: decodeBC7(block, bytes, simd); break;
+						}
+
+						std::uint32_t width = converter ? 4 : std::min(surface.width - column * 4, 4u);
+						for (std::uint32_t y = 0; y < height; y++)
+							std::memcpy(target + y * pitch + (std::size_t)column * 4 * decodedSize, decoded + y * 4 * decodedSize, width * decodedSize);
+					}
+
+					if (converter)
+					{
+						for (std::uint32_t y = 0; y < height; y++)
+							converter->convert(target + y * pitch, texels + (std::size_t)y * surface.width * texelSize, surface.width);
+					}
+				}
+			});
+		}
+	}
+}
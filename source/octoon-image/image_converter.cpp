@@ -0,0 +1,313 @@
+#include <octoon/image/image_converter.h>
+#include <octoon/runtime/except.h>
+#include <octoon/runtime/thread_pool.h>
+
+#include "image_codec.h"
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSSE3__)
+#	include <tmmintrin.h>
+#elif defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			constexpr std::int8_t Zero = -1;
+			constexpr std::int8_t One = -2;
+			constexpr std::int8_t Luma = -3;
+
+			// Pixels per block of the float path, two blocks of floats fit in 8KB of stack.
+			constexpr std::size_t BlockSize = 256;
+
+			template<typename T>
+			void shuffleChannels(const std::uint8_t* src, std::uint8_t* dst, std::size_t pixels, std::uint8_t srcChannel, std::uint8_t dstChannel, const std::int8_t* select, const std::uint8_t* constant) noexcept
+			{
+				T value[4];
+				std::memcpy(value, constant, dstChannel * sizeof(T));
+
+				auto s = (const T*)src;
+				auto d = (T*)dst;
+
+				for (std::size_t i = 0; i < pixels; i++, s += srcChannel, d += dstChannel)
+				{
+					for (std::uint8_t c = 0; c < dstChannel; c++)
+						d[c] = select[c] >= 0 ? s[select[c]] : value[c];
+				}
+			}
+		}
+
+		FormatConverter::FormatConverter(const Format& src, const Format& dst, AlphaMode alpha) except
+			: src_(src)
+			, dst_(dst)
+			, alpha_(alpha)
+			, accelerated_(true)
+			, compatible_(false)
+			, select_{ Zero, Zero, Zero, Zero }
+			, constant_{}
+		{
+			decoder_ = std::make_unique<PixelCodec>(src);
+			encoder_ = std::make_unique<PixelCodec>(dst);
+
+			auto from = decoder_->swizzle();
+			auto to = encoder_->swizzle();
+
+			bool luma = encoder_->luminance() && !decoder_->luminance() && from[0] >= 0 && from[1] >= 0 && from[2] >= 0;
+
+			float constant[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (std::uint8_t c = 0; c < encoder_->channel(); c++)
+			{
+				std::uint8_t component = 0;
+				while (to[component] != c)
+					component++;
+
+				if (component == 3)
+					select_[c] = from[3] >= 0 ? from[3] : One;
+				else if (luma)
+					select_[c] = Luma;
+				else
+					select_[c] = from[component] >= 0 ? from[component] : Zero;
+
+				constant[c] = select_[c] == One ? 1.0f : 0.0f;
+			}
+
+			encoder_->encode(constant, constant_, 1);
+
+			compatible_ = decoder_->compatible(*encoder_) && (alpha_ == AlphaMode::Straight || from[3] < 0) && !luma;
+		}
+
+		FormatConverter::~FormatConverter() noexcept
+		{
+		}
+
+		const Format&
+		FormatConverter::getSourceFormat() const noexcept
+		{
+			return src_;
+		}
+
+		const Format&
+		FormatConverter::getDestFormat() const noexcept
+		{
+			return dst_;
+		}
+
+		AlphaMode
+		FormatConverter::getAlphaMode() const noexcept
+		{
+			return alpha_;
+		}
+
+		void
+		FormatConverter::setAccelerated(bool enable) noexcept
+		{
+			accelerated_ = enable;
+			decoder_->setAccelerated(enable);
+			encoder_->setAccelerated(enable);
+		}
+
+		bool
+		FormatConverter::getAccelerated() const noexcept
+		{
+			return accelerated_;
+		}
+
+		void
+		FormatConverter::convert(const void* src, void* dst, std::size_t pixels) const noexcept
+		{
+			assert(src && dst);
+
+			if (src_ == dst_ && (alpha_ == AlphaMode::Straight || decoder_->alpha() < 0))
+				std::memcpy(dst, src, pixels * decoder_->pixelSize());
+			else if (compatible_ && accelerated_)
+				this->shuffle((const std::uint8_t*)src, (std::uint8_t*)dst, pixels);
+			else
+				this->transform((const std::uint8_t*)src, (std::uint8_t*)dst, pixels);
+		}
+
+		void
+		FormatConverter::convert(const Image& src, Image& dst) const except
+		{
+			if (src.format() != src_)
+				throw runtime::runtime_error::create("FormatConverter : the image does not have the source format");
+
+			if (&src == &dst)
+				throw runtime::runtime_error::create("FormatConverter : cannot convert an image into itself");
+
+			if (!dst.create(dst_, src.width(), src.height(), src.depth(), src.mipLevel(), src.layerLevel(), src.mipBase(), src.layerBase()))
+				throw runtime::runtime_error::create("FormatConverter : failed to create the image");
+
+			auto srcData = (const std::uint8_t*)src.data();
+			auto dstData = (std::uint8_t*)dst.data();
+
+			std::size_t srcSize = decoder_->pixelSize();
+			std::size_t dstSize = encoder_->pixelSize();
+
+			// Pixels are independent, so every mip and layer is one flat run.
+			runtime::ThreadPool::instance()->parallel_for(0, src.size() / srcSize, 16384, [&](std::size_t begin, std::size_t end)
+			{
+				this->convert(srcData + begin * srcSize, dstData + begin * dstSize, end - begin);
+			});
+		}
+
+		bool
+		FormatConverter::isSupported(const Format& format) noexcept
+		{
+			try
+			{
+				PixelCodec codec(format);
+				return true;
+			}
+			catch (...)
+			{
+				return false;
+			}
+		}
+
+		void
+		FormatConverter::shuffle(const std::uint8_t* src, std::uint8_t* dst, std::size_t pixels) const noexcept
+		{
+			std::uint8_t srcChannel = decoder_->channel();
+			std::uint8_t dstChannel = encoder_->channel();
+			std::uint32_t typeSize = decoder_->pixelSize() / srcChannel;
+
+#if defined(__SSSE3__)
+			// As many whole pixels as fit into 16 bytes on both sides go through one byte shuffle.
+			std::size_t group = 16 / (std::max(srcChannel, dstChannel) * typeSize);
+			if (group > 0)
+			{
+				alignas(16) std::uint8_t mask[16];
+				alignas(16) std::uint8_t fill[16];
+				std::memset(mask, 0x80, sizeof(mask));
+				std::memset(fill, 0, sizeof(fill));
+
+				for (std::size_t p = 0; p < group; p++)
+				{
+					for (std::uint8_t c = 0; c < dstChannel; c++)
+					{
+						for (std::uint32_t b = 0; b < typeSize; b++)
+						{
+							std::size_t index = (p * dstChannel + c) * typeSize + b;
+							if (select_[c] >= 0)
+								mask[index] = (std::uint8_t)((p * srcChannel + select_[c]) * typeSize + b);
+							else
+								fill[index] = constant_[c * typeSize + b];
+						}
+					}
+				}
+
+				__m128i shuffle = _mm_load_si128((const __m128i*)mask);
+				__m128i constant = _mm_load_si128((const __m128i*)fill);
+
+				// Loads and stores are 16 bytes wide, the bytes past the group are rewritten by the next one.
+				std::size_t srcStride = group * srcChannel * typeSize;
+				std::size_t dstStride = group * dstChannel * typeSize;
+				std::size_t minimum = (16 + std::min(srcChannel, dstChannel) * typeSize - 1) / (std::min(srcChannel, dstChannel) * typeSize);
+
+				while (pixels >= minimum)
+				{
+					__m128i v = _mm_loadu_si128((const __m128i*)src);
+					_mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_shuffle_epi8(v, shuffle), constant));
+
+					src += srcStride;
+					dst += dstStride;
+					pixels -= group;
+				}
+			}
+#elif defined(__SSE2__)
+			// Without a byte shuffle only the red and blue swap between RGBA8 and BGRA8 is vectorized.
+			if (typeSize == 1 && srcChannel == 4 && dstChannel == 4 && select_[0] == 2 && select_[1] == 1 && select_[2] == 0 && select_[3] == 3)
+			{
+				const __m128i green = _mm_set1_epi32(0xff00ff00);
+				const __m128i low = _mm_set1_epi32(0x000000ff);
+
+				for (; pixels >= 4; pixels -= 4, src += 16, dst += 16)
+				{
+					__m128i v = _mm_loadu_si128((const __m128i*)src);
+					__m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+					__m128i b = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+					_mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_and_si128(v, green), _mm_or_si128(r, b)));
+				}
+			}
+#endif
+			switch (typeSize)
+			{
+			case 1: shuffleChannels<std::uint8_t>(src, dst, pixels, srcChannel, dstChannel, select_, constant_); break;
+			case 2: shuffleChannels<std::uint16_t>(src, dst, pixels, srcChannel, dstChannel, select_, constant_); break;
+			case 4: shuffleChannels<std::uint32_t>(src, dst, pixels, srcChannel, dstChannel, select_, constant_); break;
+			case 8: shuffleChannels<std::uint64_t>(src, dst, pixels, srcChannel, dstChannel, select_, constant_); break;
+			default:
+				break;
+			}
+		}
+
+		void
+		FormatConverter::transform(const std::uint8_t* src, std::uint8_t* dst, std::size_t pixels) const noexcept
+		{
+			float in[BlockSize * 4];
+			float out[BlockSize * 4];
+
+			std::uint8_t srcChannel = decoder_->channel();
+			std::uint8_t dstChannel = encoder_->channel();
+			std::int8_t alpha = decoder_->alpha();
+
+			bool identity = srcChannel == dstChannel;
+			for (std::uint8_t c = 0; c < dstChannel; c++)
+				identity &= select_[c] == c;
+
+			auto from = decoder_->swizzle();
+
+			for (std::size_t offset = 0; offset < pixels; offset += BlockSize)
+			{
+				std::size_t count = std::min(BlockSize, pixels - offset);
+
+				decoder_->decode(src + offset * decoder_->pixelSize(), in, count);
+
+				if (alpha >= 0 && alpha_ != AlphaMode::Straight)
+				{
+					for (std::size_t i = 0; i < count; i++)
+					{
+						float* pixel = in + i * srcChannel;
+						float a = pixel[alpha];
+						float scale = alpha_ == AlphaMode::Premultiply ? a : (a > 0.0f ? 1.0f / a : 0.0f);
+
+						for (std::uint8_t c = 0; c < srcChannel; c++)
+						{
+							if (c != alpha)
+								pixel[c] *= scale;
+						}
+					}
+				}
+
+				if (!identity)
+				{
+					for (std::size_t i = 0; i < count; i++)
+					{
+						const float* s = in + i * srcChannel;
+						float* d = out + i * dstChannel;
+
+						for (std::uint8_t c = 0; c < dstChannel; c++)
+						{
+							switch (select_[c])
+							{
+							case Zero: d[c] = 0.0f; break;
+							case One: d[c] = 1.0f; break;
+							case Luma: d[c] = s[from[0]] * 0.2126f + s[from[1]] * 0.7152f + s[from[2]] * 0.0722f; break;
+							default: d[c] = s[select_[c]]; break;
+							}
+						}
+					}
+				}
+
+				encoder_->encode(identity ? in : out, dst + offset * encoder_->pixelSize(), count);
+			}
+		}
+	}
+}
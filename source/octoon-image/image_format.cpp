@@ -17,6 +17,12 @@ namespace octoon
 			return type_size(format_);
 		}
 
+		std::uint8_t
+		Format::pixel_size() const except
+		{
+			return pixel_size(format_);
+		}
+
 		value_t
 		Format::value_type() const except
 		{
@@ -267,6 +273,7 @@ namespace octoon
 			case Format::Type::R16G16UScaled:
 			case Format::Type::R16G16B16UScaled:
 			case Format::Type::R16G16B16A16UScaled:
+				return value_t::UScaled;
 			case Format::Type::L8SScaled:
 			case Format::Type::A8SScaled:
 			case Format::Type::R8SScaled:
@@ -286,7 +293,7 @@ namespace octoon
 			case Format::Type::R16G16SScaled:
 			case Format::Type::R16G16B16SScaled:
 			case Format::Type::R16G16B16A16SScaled:
-				return value_t::UScaled;
+				return value_t::SScaled;
 			case Format::Type::L8UInt:
 			case Format::Type::A8UInt:
 			case Format::Type::R8UInt:
@@ -672,6 +679,50 @@ namespace octoon
 			}
 		}
 
+		std::uint8_t
+		Format::pixel_size(Format::Type format) except
+		{
+			switch (format)
+			{
+			case Format::Type::R4G4UNormPack8:
+				return 1;
+			case Format::Type::R4G4B4A4UNormPack16:
+			case Format::Type::B4G4R4A4UNormPack16:
+			case Format::Type::R5G6B5UNormPack16:
+			case Format::Type::B5G6R5UNormPack16:
+			case Format::Type::R5G5B5A1UNormPack16:
+			case Format::Type::B5G5R5A1UNormPack16:
+			case Format::Type::A1R5G5B5UNormPack16:
+				return 2;
+			case Format::Type::A8B8G8R8UNormPack32:
+			case Format::Type::A8B8G8R8SNormPack32:
+			case Format::Type::A8B8G8R8UScaledPack32:
+			case Format::Type::A8B8G8R8SScaledPack32:
+			case Format::Type::A8B8G8R8UIntPack32:
+			case Format::Type::A8B8G8R8SIntPack32:
+			case Format::Type::A8B8G8R8SRGBPack32:
+			case Format::Type::A2R10G10B10UNormPack32:
+			case Format::Type::A2R10G10B10SNormPack32:
+			case Format::Type::A2R10G10B10UScaledPack32:
+			case Format::Type::A2R10G10B10SScaledPack32:
+			case Format::Type::A2R10G10B10UIntPack32:
+			case Format::Type::A2R10G10B10SIntPack32:
+			case Format::Type::A2B10G10R10UNormPack32:
+			case Format::Type::A2B10G10R10SNormPack32:
+			case Format::Type::A2B10G10R10UScaledPack32:
+			case Format::Type::A2B10G10R10SScaledPack32:
+			case Format::Type::A2B10G10R10UIntPack32:
+			case Format::Type::A2B10G10R10SIntPack32:
+			case Format::Type::B10G11R11UFloatPack32:
+			case Format::Type::E5B9G9R9UFloatPack32:
+			case Format::Type::X8_D24UNormPack32:
+			case Format::Type::D32_SFLOAT:
+				return 4;
+			default:
+				return channel(format) * type_size(format);
+			}
+		}
+
 		std::uint8_t
 		Format::channel(Format::Type format) except
 		{
@@ -1,7 +1,10 @@
 #include "image_hdr.h"
 #include <octoon/image/image_util.h>
+#include <octoon/image/image_reader.h>
+#include <octoon/runtime/except.h>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 
 #define RGBE_RETURN_SUCCESS 0
 #define RGBE_RETURN_FAILURE -1
@@ -39,7 +42,7 @@ namespace octoon
 			rgbe_memory_error,
 		};
 
-		static int rgbe_error(int rgbe_error_code, char* msg)
+		static int rgbe_error(int rgbe_error_code, const char* msg)
 		{
 			switch (rgbe_error_code)
 			{
@@ -161,91 +164,78 @@ namespace octoon
 
 			for (std::size_t i = 0; i < numpixels; i++)
 			{
-				RGBE_decode(&rgbe[i], &data[RGBE_DATA_RED], &data[RGBE_DATA_GREEN], &data[RGBE_DATA_BLUE]);
+				RGBE_decode(&rgbe[i * 4], &data[RGBE_DATA_RED], &data[RGBE_DATA_GREEN], &data[RGBE_DATA_BLUE]);
 				data += RGBE_DATA_SIZE;
 			}
 
 			return RGBE_RETURN_SUCCESS;
 		}
 
-		int RGBE_ReadPixels_RLE(istream& stream, float *data, std::uint32_t wdith, std::uint32_t height)
+		// Scanlines are stored flat or as four run length encoded channels each, which is told apart
+		// by their first four bytes. buffer holds one encoded scanline.
+		int RGBE_ReadScanline(istream& stream, float* data, std::uint32_t width, std::uint8_t* buffer)
 		{
 			std::uint8_t rgbe[4];
 
 			if (!stream.read((char*)rgbe, sizeof(rgbe)))
 				return rgbe_error(rgbe_read_error, NULL);
 
-			if ((((unsigned)rgbe[2]) << 8 | rgbe[3]) != wdith)
-				return rgbe_error(rgbe_format_error, "wrong scanline width");
-
-			if ((wdith < 8) || (wdith > 0x7fff) || (rgbe[0] != 2) || (rgbe[1] != 2) || (rgbe[2] & 0x80))
+			if ((width < 8) || (width > 0x7fff) || (rgbe[0] != 2) || (rgbe[1] != 2) || (rgbe[2] & 0x80))
 			{
 				RGBE_decode(rgbe, &data[0], &data[1], &data[2]);
-				data += RGBE_DATA_SIZE;
-
-				return RGBE_ReadPixels(stream, data, wdith*height - 1);
+				return RGBE_ReadPixels(stream, data + RGBE_DATA_SIZE, width - 1);
 			}
-			else
-			{
-				std::unique_ptr<std::uint8_t[]> scanline_buffer = std::make_unique<std::uint8_t[]>(sizeof(std::uint8_t) * 4 * wdith);
 
-				for (std::uint32_t y = 0; y < height; y++)
+			if ((((unsigned)rgbe[2]) << 8 | rgbe[3]) != width)
+				return rgbe_error(rgbe_format_error, "wrong scanline width");
+
+			auto ptr = buffer;
+
+			for (std::uint8_t i = 0; i < 4; i++)
+			{
+				auto ptr_end = &buffer[(i + 1) * width];
+				while (ptr < ptr_end)
 				{
-					if ((((unsigned)rgbe[2]) << 8 | rgbe[3]) != wdith)
-						return rgbe_error(rgbe_format_error, "wrong scanline width");
+					std::uint8_t buf[2];
+					if (!stream.read((char*)buf, sizeof(buf)))
+						return rgbe_error(rgbe_read_error, NULL);
 
-					auto ptr = scanline_buffer.get();
+					if (buf[0] > 128)
+					{
+						std::uint8_t count = buf[0] - 128;
+						if ((count == 0) || (count > ptr_end - ptr))
+							return rgbe_error(rgbe_format_error, "bad scanline data");
 
-					for (std::uint8_t i = 0; i < 4; i++)
+						while (count-- > 0)
+							*ptr++ = buf[1];
+					}
+					else
 					{
-						auto ptr_end = &scanline_buffer[(i + 1)*wdith];
-						while (ptr < ptr_end)
+						std::uint8_t count = buf[0];
+						if ((count == 0) || (count > ptr_end - ptr))
+							return rgbe_error(rgbe_format_error, "bad scanline data");
+
+						*ptr++ = buf[1];
+						if (--count > 0)
 						{
-							std::uint8_t buf[2];
-							if (!stream.read((char*)buf, sizeof(buf)))
+							if (!stream.read((char*)ptr, sizeof(*ptr) * count))
 								return rgbe_error(rgbe_read_error, NULL);
 
-							if (buf[0] > 128)
-							{
-								std::uint8_t count = buf[0] - 128;
-								if ((count == 0) || (count > ptr_end - ptr))
-									return rgbe_error(rgbe_format_error, "bad scanline data");
-
-								while (count-- > 0)
-									*ptr++ = buf[1];
-							}
-							else
-							{
-								std::uint8_t count = buf[0];
-								if ((count == 0) || (count > ptr_end - ptr))
-									return rgbe_error(rgbe_format_error, "bad scanline data");
-
-								*ptr++ = buf[1];
-								if (--count > 0)
-								{
-									if (!stream.read((char*)ptr, sizeof(*ptr) * count))
-										return rgbe_error(rgbe_read_error, NULL);
-
-									ptr += count;
-								}
-							}
+							ptr += count;
 						}
 					}
+				}
+			}
 
-					for (std::uint32_t i = 0; i < wdith; i++)
-					{
-						rgbe[0] = scanline_buffer[i];
-						rgbe[1] = scanline_buffer[i + wdith];
-						rgbe[2] = scanline_buffer[i + 2 * wdith];
-						rgbe[3] = scanline_buffer[i + 3 * wdith];
-						RGBE_decode(rgbe, &data[RGBE_DATA_RED], &data[RGBE_DATA_GREEN], &data[RGBE_DATA_BLUE]);
-
-						data += RGBE_DATA_SIZE;
-					}
+			for (std::uint32_t i = 0; i < width; i++)
+			{
+				rgbe[0] = buffer[i];
+				rgbe[1] = buffer[i + width];
+				rgbe[2] = buffer[i + 2 * width];
+				rgbe[3] = buffer[i + 3 * width];
+				RGBE_decode(rgbe, &data[RGBE_DATA_RED], &data[RGBE_DATA_GREEN], &data[RGBE_DATA_BLUE]);
 
-					if (!stream.read((char*)rgbe, sizeof(rgbe)))
-						return rgbe_error(rgbe_read_error, NULL);
-				}
+				data += RGBE_DATA_SIZE;
 			}
 
 			return RGBE_RETURN_SUCCESS;
@@ -419,23 +409,112 @@ namespace octoon
 			return std::strncmp(type_name, "hdr", 3) == 0;
 		}
 
+		class HDRReader final : public ImageReader
+		{
+		public:
+			HDRReader() noexcept
+				: stream_(nullptr)
+				, format_(Format::R32G32B32SFloat)
+				, width_(0)
+				, height_(0)
+				, row_(0)
+			{
+			}
+
+			void open(istream& stream) except
+			{
+				rgbe_header_info hdr;
+				if (RGBE_ReadHeader(stream, &hdr) != RGBE_RETURN_SUCCESS)
+					throw runtime::runtime_error::create("HDRReader : failed to read the header");
+
+				if (hdr.width == 0 || hdr.height == 0)
+					throw runtime::runtime_error::create("HDRReader : the image is empty");
+
+				stream_ = &stream;
+				width_ = hdr.width;
+				height_ = hdr.height;
+				scanline_ = std::make_unique<std::uint8_t[]>((std::size_t)width_ * 4);
+			}
+
+			const Format& format() const noexcept override
+			{
+				return format_;
+			}
+
+			std::uint32_t width() const noexcept override
+			{
+				return width_;
+			}
+
+			std::uint32_t height() const noexcept override
+			{
+				return height_;
+			}
+
+			std::uint32_t row() const noexcept override
+			{
+				return row_;
+			}
+
+			std::uint32_t read(void* data, std::size_t pitch, std::uint32_t count) except override
+			{
+				count = std::min(count, height_ - row_);
+
+				for (std::uint32_t i = 0; i < count; i++, row_++)
+				{
+					if (RGBE_ReadScanline(*stream_, (float*)((std::uint8_t*)data + i * pitch), width_, scanline_.get()) != RGBE_RETURN_SUCCESS)
+						throw runtime::runtime_error::create("HDRReader : failed to decode the image");
+				}
+
+				return count;
+			}
+
+		private:
+			istream* stream_;
+
+			Format format_;
+
+			std::uint32_t width_;
+			std::uint32_t height_;
+			std::uint32_t row_;
+
+			std::unique_ptr<std::uint8_t[]> scanline_;
+		};
+
 		bool
 		HDRHandler::doLoad(istream& stream, Image& image) noexcept
 		{
-			rgbe_header_info hdr;
-			if (RGBE_ReadHeader(stream, &hdr) != RGBE_RETURN_SUCCESS)
-				return false;
-
-			if (hdr.width == 0 || hdr.height == 0)
-				return false;
+			try
+			{
+				auto reader = this->doOpen(stream);
+				if (!reader)
+					return false;
 
-			if (!image.create(Format::R32G32B32SFloat, hdr.width, hdr.height))
-				return false;
+				if (!image.create(reader->format(), reader->width(), reader->height()))
+					return false;
 
-			if (RGBE_ReadPixels_RLE(stream, (float*)image.data(), hdr.width, hdr.height) != RGBE_RETURN_SUCCESS)
+				reader->read((char*)image.data(), (std::size_t)image.width() * 12, image.height());
+				return true;
+			}
+			catch (...)
+			{
 				return false;
+			}
+		}
 
-			return true;
+		ImageReaderPtr
+		HDRHandler::doOpen(istream& stream) noexcept
+		{
+			try
+			{
+				auto reader = std::make_shared<HDRReader>();
+				reader->open(stream);
+				return reader;
+			}
+			catch (...)
+			{
+				return nullptr;
+			}
 		}
 
 		bool
@@ -1,9 +1,14 @@
 #include "image_jpeg.h"
+#include <octoon/image/image_reader.h>
+#include <octoon/image/image_jpeg_codec.h>
 #include <octoon/runtime/except.h>
 
 #include <setjmp.h>
 #include <jpeglib.h>
+#include <vector>
+#include <cassert>
 #include <cstring>
+#include <algorithm>
 
 namespace octoon
 {
@@ -73,6 +78,16 @@ namespace octoon
 			return TRUE;
 		}
 
+		extern "C" boolean jpeg_memory_input_buffer(j_decompress_ptr cinfo)
+		{
+			static const JOCTET eoi[] = { 0xFF, JPEG_EOI };
+
+			cinfo->src->next_input_byte = eoi;
+			cinfo->src->bytes_in_buffer = sizeof(eoi);
+
+			return TRUE;
+		}
+
 		extern "C" void jpeg_skip_input_data(j_decompress_ptr cinfo, long num_bytes)
 		{
 			if (num_bytes > 0)
@@ -112,6 +127,11 @@ namespace octoon
 
 		extern "C" void term_destination(j_compress_ptr cinfo)
 		{
+			jpeg_dest_manager* dest = (jpeg_dest_manager*)cinfo->dest;
+
+			std::size_t count = JPEG_IO_BUFFER_SIZE - dest->pub.free_in_buffer;
+			if (count > 0)
+				dest->stream->write((char*)dest->buffer, count);
 		}
 
 		void cmyk_to_rgb(std::uint8_t* rgb, const std::uint8_t* cmyk) noexcept
@@ -149,28 +169,41 @@ namespace octoon
 			return (std::strncmp(type_name, "jpg", 3) == 0) || (std::strncmp(type_name, "jpeg", 4) == 0);
 		}
 
-		bool
-		JPEGHandler::doLoad(istream& stream, Image& image) noexcept
+		class JPEGReader final : public ImageReader
 		{
-			jpeg_error_manager jerrmgr;
-			jerrmgr.error_exit = jpeg_error_exit;
-			jerrmgr.output_message = jpeg_output_message;
+		public:
+			JPEGReader(std::uint32_t scale, bool fastDCT, bool alpha) noexcept
+				: format_(alpha ? Format::R8G8B8A8SRGB : Format::R8G8B8SRGB)
+				, scale_(scale)
+				, fastDCT_(fastDCT)
+				, created_(false)
+			{
+			}
 
-			jpeg_decompress_struct cinfo;
-			cinfo.err = ::jpeg_std_error(&jerrmgr);
+			~JPEGReader() noexcept
+			{
+				if (created_)
+					::jpeg_destroy_decompress(&cinfo_);
+			}
 
-			try
+			void open(istream& stream) except
 			{
-				::jpeg_create_decompress(&cinfo);
+				// jpeg_std_error resets the handlers, so they are replaced after it.
+				cinfo_.err = ::jpeg_std_error(&error_);
+				error_.error_exit = jpeg_error_exit;
+				error_.output_message = jpeg_output_message;
+
+				::jpeg_create_decompress(&cinfo_);
+				created_ = true;
 
-				if (::setjmp(jerrmgr.setjmp_buffer))
-					throw runtime::runtime_error::create("::setjmp() failed.");
+				if (::setjmp(error_.setjmp_buffer))
+					throw runtime::runtime_error::create("JPEGReader : failed to read the header");
 
-				if (cinfo.src == nullptr)
-					cinfo.src = (jpeg_source_mgr *)(cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_PERMANENT, sizeof(jpeg_source_manager));
+				if (cinfo_.src == nullptr)
+					cinfo_.src = (jpeg_source_mgr *)(cinfo_.mem->alloc_small)((j_common_ptr)&cinfo_, JPOOL_PERMANENT, sizeof(jpeg_source_manager));
 
-				jpeg_source_manager* src = (jpeg_source_manager*)cinfo.src;
-				src->buffer = (JOCTET*)(cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_PERMANENT, JPEG_IO_BUFFER_SIZE * sizeof(JOCTET));
+				jpeg_source_manager* src = (jpeg_source_manager*)cinfo_.src;
+				src->buffer = (JOCTET*)(cinfo_.mem->alloc_small)((j_common_ptr)&cinfo_, JPOOL_PERMANENT, JPEG_IO_BUFFER_SIZE * sizeof(JOCTET));
 				src->stream = &stream;
 				src->pub.init_source = jpeg_init_source;
 				src->pub.fill_input_buffer = &jpeg_reader_input_buffer;
@@ -180,141 +213,380 @@ namespace octoon
 				src->pub.bytes_in_buffer = 0;
 				src->pub.next_input_byte = 0;
 
-				::jpeg_read_header(&cinfo, TRUE);
+				// Decode in place when the stream can expose the rest of the file.
+				auto offset = stream.tellg();
+				auto length = stream.size() - offset;
+				auto view = (offset >= 0 && length > 0) ? stream.view(length) : nullptr;
+				if (view)
+				{
+					src->pub.fill_input_buffer = &jpeg_memory_input_buffer;
+					src->pub.next_input_byte = (const JOCTET*)view;
+					src->pub.bytes_in_buffer = (std::size_t)length;
+				}
 
-				if (!image.create(image::Format::R8G8B8SRGB, cinfo.image_width, cinfo.image_height))
-					throw runtime::runtime_error::create("Image::create() failed.");
+				::jpeg_read_header(&cinfo_, TRUE);
 
-				JSAMPARRAY data = (JSAMPARRAY)image.data();
-				JDIMENSION stride = cinfo.image_width * cinfo.num_components;
+				if (cinfo_.jpeg_color_space == JCS_YCCK)
+					cinfo_.out_color_space = JCS_CMYK;
 
-				if (cinfo.out_color_space == JCS_RGB)
-				{
-					::jpeg_start_decompress(&cinfo);
+				if (cinfo_.out_color_space != JCS_RGB && cinfo_.out_color_space != JCS_CMYK && cinfo_.out_color_space != JCS_GRAYSCALE)
+					throw runtime::runtime_error::create("JPEGReader : unsupported color space");
 
-					while (cinfo.output_scanline < cinfo.image_height)
-					{
-						::jpeg_read_scanlines(&cinfo, (JSAMPARRAY)&data, 1);
-						(std::uint8_t*&)data += stride;
-					}
-				}
-				else
+#if defined(JCS_EXTENSIONS)
+				// libjpeg-turbo writes RGBA itself.
+				if (cinfo_.out_color_space == JCS_RGB && format_.channel() == 4)
+					cinfo_.out_color_space = JCS_EXT_RGBA;
+#endif
+
+				cinfo_.scale_num = 1;
+				cinfo_.scale_denom = scale_;
+				cinfo_.dct_method = fastDCT_ ? JDCT_IFAST : JDCT_ISLOW;
+
+				::jpeg_start_decompress(&cinfo_);
+			}
+
+			const Format& format() const noexcept override
+			{
+				return format_;
+			}
+
+			std::uint32_t width() const noexcept override
+			{
+				return cinfo_.output_width;
+			}
+
+			std::uint32_t height() const noexcept override
+			{
+				return cinfo_.output_height;
+			}
+
+			std::uint32_t row() const noexcept override
+			{
+				return cinfo_.output_scanline;
+			}
+
+			std::uint32_t read(void* data, std::size_t pitch, std::uint32_t count) except override
+			{
+				count = std::min(count, cinfo_.output_height - cinfo_.output_scanline);
+				if (count == 0)
+					return 0;
+
+				if (::setjmp(error_.setjmp_buffer))
+					throw runtime::runtime_error::create("JPEGReader : failed to decode the image");
+
+				// RGB and RGBA scanlines land in the band directly, the others are expanded from a batch.
+				bool direct = cinfo_.out_color_space != JCS_CMYK && cinfo_.out_color_space != JCS_GRAYSCALE;
+				std::size_t channels = format_.channel();
+				std::size_t stride = (std::size_t)cinfo_.output_width * cinfo_.output_components;
+
+				if (!direct)
+					scanlines_.resize(stride * count);
+
+				rows_.resize(count);
+				for (std::uint32_t i = 0; i < count; i++)
+					rows_[i] = direct ? (std::uint8_t*)data + i * pitch : scanlines_.data() + i * stride;
+
+				std::uint32_t done = 0;
+				while (done < count)
 				{
-					JSAMPARRAY row_pointer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, stride, 1);
+					JDIMENSION lines = ::jpeg_read_scanlines(&cinfo_, rows_.data() + done, count - done);
+					if (lines == 0)
+						throw runtime::runtime_error::create("JPEGReader : the stream ended early");
 
-					::jpeg_start_decompress(&cinfo);
+					done += lines;
+				}
 
-					while (cinfo.output_scanline < cinfo.image_height)
+				if (direct && channels > (std::size_t)cinfo_.output_components)
+				{
+					// Spreads RGB rows to RGBA from the right, where no texel is overwritten before it is read.
+					for (std::uint32_t i = 0; i < count; i++)
 					{
-						::jpeg_read_scanlines(&cinfo, row_pointer, 1);
+						auto ptr = rows_[i];
 
-						switch (cinfo.out_color_space)
-						{
-						case JCS_RGB:
+						for (std::size_t x = cinfo_.output_width; x-- > 0;)
 						{
-							std::memcpy(data, row_pointer[0], stride);
-							(std::uint8_t*&)data += stride;
+							std::uint8_t r = ptr[x * 3], g = ptr[x * 3 + 1], b = ptr[x * 3 + 2];
+							ptr[x * 4] = r;
+							ptr[x * 4 + 1] = g;
+							ptr[x * 4 + 2] = b;
+							ptr[x * 4 + 3] = 0xFF;
 						}
-						break;
-						case JCS_CMYK:
+					}
+				}
+				else if (!direct)
+				{
+					for (std::uint32_t i = 0; i < count; i++)
+					{
+						auto inptr = rows_[i];
+						auto outptr = (std::uint8_t*)data + i * pitch;
+
+						for (std::size_t x = 0; x < cinfo_.output_width; x++, outptr += channels)
 						{
-							std::uint8_t* inptr = (std::uint8_t*)row_pointer[0];
-							for (size_t i = 0; i < cinfo.output_width; i++)
-							{
-								cmyk_to_rgb((std::uint8_t*)data, inptr);
-								(std::uint8_t*&)data += 3;
-								inptr += 4;
-							}
-						}
-						break;
-						case JCS_GRAYSCALE:
-						case JCS_UNKNOWN:
-						case JCS_YCbCr:
-						case JCS_YCCK:
-						default:
-							assert(false);
+							if (cinfo_.out_color_space == JCS_CMYK)
+								cmyk_to_rgb(outptr, inptr + x * 4);
+							else
+								outptr[0] = outptr[1] = outptr[2] = inptr[x];
+
+							if (channels == 4)
+								outptr[3] = 0xFF;
 						}
 					}
 				}
 
-				::jpeg_finish_decompress(&cinfo);
-				::jpeg_destroy_decompress(&cinfo);
+				if (cinfo_.output_scanline == cinfo_.output_height)
+					::jpeg_finish_decompress(&cinfo_);
 
-				return true;
+				return count;
 			}
-			catch (...)
-			{
-				::jpeg_finish_decompress(&cinfo);
-				::jpeg_destroy_decompress(&cinfo);
 
-				return false;
-			}
+		private:
+			jpeg_error_manager error_;
+			jpeg_decompress_struct cinfo_;
+
+			Format format_;
+			std::uint32_t scale_;
+			bool fastDCT_;
+			bool created_;
+
+			std::vector<JSAMPROW> rows_;
+			std::vector<std::uint8_t> scanlines_;
+		};
+
+		JPEGDecoder::JPEGDecoder() noexcept
+			: scale_(1)
+			, fastDCT_(false)
+			, alpha_(false)
+		{
+		}
+
+		JPEGDecoder::~JPEGDecoder() noexcept
+		{
+		}
+
+		void
+		JPEGDecoder::setScale(std::uint32_t denom) noexcept
+		{
+			scale_ = denom >= 8 ? 8 : denom >= 4 ? 4 : denom >= 2 ? 2 : 1;
+		}
+
+		std::uint32_t
+		JPEGDecoder::getScale() const noexcept
+		{
+			return scale_;
+		}
+
+		void
+		JPEGDecoder::setFastDCT(bool enable) noexcept
+		{
+			fastDCT_ = enable;
 		}
 
 		bool
-		JPEGHandler::doSave(ostream& stream, const Image& image) noexcept
+		JPEGDecoder::getFastDCT() const noexcept
 		{
-			jpeg_error_manager jerrmgr;
-			jerrmgr.error_exit = jpeg_error_exit;
-			jerrmgr.output_message = jpeg_output_message;
+			return fastDCT_;
+		}
 
-			jpeg_compress_struct cinfo;
-			cinfo.err = ::jpeg_std_error(&jerrmgr);
+		void
+		JPEGDecoder::setAlpha(bool enable) noexcept
+		{
+			alpha_ = enable;
+		}
+
+		bool
+		JPEGDecoder::getAlpha() const noexcept
+		{
+			return alpha_;
+		}
+
+		ImageReaderPtr
+		JPEGDecoder::open(istream& stream) const except
+		{
+			auto reader = std::make_shared<JPEGReader>(scale_, fastDCT_, alpha_);
+			reader->open(stream);
+			return reader;
+		}
+
+		void
+		JPEGDecoder::decode(istream& stream, Image& image) const except
+		{
+			auto reader = this->open(stream);
+
+			if (!image.create(reader->format(), reader->width(), reader->height()))
+				throw runtime::runtime_error::create("JPEGDecoder : Image::create() failed");
+
+			reader->read((char*)image.data(), (std::size_t)image.width() * image.format().pixel_size(), image.height());
+		}
+
+		JPEGEncoder::JPEGEncoder(int quality) noexcept
+			: quality_(std::min(std::max(quality, 1), 100))
+			, optimize_(false)
+		{
+		}
+
+		JPEGEncoder::~JPEGEncoder() noexcept
+		{
+		}
+
+		void
+		JPEGEncoder::setQuality(int quality) noexcept
+		{
+			quality_ = std::min(std::max(quality, 1), 100);
+		}
+
+		int
+		JPEGEncoder::getQuality() const noexcept
+		{
+			return quality_;
+		}
 
-			if (image.format() != Format::R8G8B8UNorm &&
-				image.format() != Format::R8G8B8SRGB)
+		void
+		JPEGEncoder::setOptimizeCoding(bool enable) noexcept
+		{
+			optimize_ = enable;
+		}
+
+		bool
+		JPEGEncoder::getOptimizeCoding() const noexcept
+		{
+			return optimize_;
+		}
+
+		void
+		JPEGEncoder::encode(ostream& stream, const Image& image) const except
+		{
+			auto& format = image.format();
+			if (format != Format::R8UNorm && format != Format::R8SRGB &&
+				format != Format::R8G8B8UNorm && format != Format::R8G8B8SRGB &&
+				format != Format::R8G8B8A8UNorm && format != Format::R8G8B8A8SRGB)
 			{
-				return false;
+				throw runtime::runtime_error::create("JPEGEncoder : unsupported image format");
 			}
 
-			try
-			{
-				::jpeg_create_compress(&cinfo);
+			auto channels = format.channel();
+			this->encode(stream, (const std::uint8_t*)image.data(), image.width(), image.height(), channels, (std::ptrdiff_t)image.width() * channels);
+		}
+
+		void
+		JPEGEncoder::encode(ostream& stream, const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint8_t channels, std::ptrdiff_t stride) const except
+		{
+			assert(pixels);
+
+			if (width == 0 || height == 0 || (channels != 1 && channels != 3 && channels != 4))
+				throw runtime::runtime_error::create("JPEGEncoder : invalid image size or channel count");
+
+			// Rows are handed over a batch at a time, RGBA rows are packed to RGB first.
+			const std::uint32_t batch = 16;
+			std::vector<std::uint8_t> packed(channels == 4 ? (std::size_t)width * 3 * batch : 0);
+			JSAMPROW rows[batch];
 
-				if (::setjmp(jerrmgr.setjmp_buffer))
-					throw runtime::runtime_error::create("::setjmp() failed.");
+			jpeg_error_manager error;
+			jpeg_compress_struct cinfo;
+
+			// jpeg_std_error resets the handlers, so they are replaced after it.
+			cinfo.err = ::jpeg_std_error(&error);
+			error.error_exit = jpeg_error_exit;
+			error.output_message = jpeg_output_message;
+
+			::jpeg_create_compress(&cinfo);
+
+			if (::setjmp(error.setjmp_buffer))
+			{
+				::jpeg_destroy_compress(&cinfo);
+				throw runtime::runtime_error::create("JPEGEncoder : failed to write the image");
+			}
 
-				cinfo.image_width = image.width();
-				cinfo.image_height = image.height();
-				cinfo.input_components = image.format().channel();
-				cinfo.in_color_space = JCS_RGB;
+			cinfo.image_width = width;
+			cinfo.image_height = height;
+			cinfo.input_components = channels == 1 ? 1 : 3;
+			cinfo.in_color_space = channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
 
-				if (cinfo.dest == nullptr)
-					cinfo.dest = (jpeg_destination_mgr *)(cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_PERMANENT, sizeof(jpeg_dest_manager));
+			cinfo.dest = (jpeg_destination_mgr *)(cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_PERMANENT, sizeof(jpeg_dest_manager));
 
-				jpeg_dest_manager* dest = (jpeg_dest_manager*)cinfo.dest;
-				dest->buffer = (JOCTET*)(cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_PERMANENT, JPEG_IO_BUFFER_SIZE * sizeof(JOCTET));
-				dest->stream = &stream;
-				dest->pub.init_destination = jpeg_init_dest;
-				dest->pub.empty_output_buffer = &empty_output_buffer;
-				dest->pub.term_destination = &term_destination;
+			jpeg_dest_manager* dest = (jpeg_dest_manager*)cinfo.dest;
+			dest->buffer = (JOCTET*)(cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_PERMANENT, JPEG_IO_BUFFER_SIZE * sizeof(JOCTET));
+			dest->stream = &stream;
+			dest->pub.init_destination = jpeg_init_dest;
+			dest->pub.empty_output_buffer = &empty_output_buffer;
+			dest->pub.term_destination = &term_destination;
 
-				::jpeg_set_defaults(&cinfo);
-				::jpeg_set_quality(&cinfo, 10, TRUE);
+			::jpeg_set_defaults(&cinfo);
+			::jpeg_set_quality(&cinfo, quality_, TRUE);
+			cinfo.optimize_coding = optimize_ ? TRUE : FALSE;
 
-				::jpeg_start_compress(&cinfo, TRUE);
+			::jpeg_start_compress(&cinfo, TRUE);
 
-				JSAMPARRAY data = (JSAMPARRAY)image.data();
-				JDIMENSION stride = cinfo.image_width * cinfo.num_components;
-				JSAMPROW row_pointer;
+			while (cinfo.next_scanline < height)
+			{
+				std::uint32_t count = std::min(batch, height - cinfo.next_scanline);
 
-				while (cinfo.next_scanline < cinfo.image_height)
+				for (std::uint32_t i = 0; i < count; i++)
 				{
-					row_pointer = ((std::uint8_t*)data) + stride * cinfo.next_scanline;
-					::jpeg_write_scanlines(&cinfo, &row_pointer, 1);
+					auto row = pixels + (std::ptrdiff_t)(cinfo.next_scanline + i) * stride;
+					if (channels == 4)
+					{
+						auto rgb = packed.data() + (std::size_t)width * 3 * i;
+						for (std::size_t x = 0; x < width; x++)
+						{
+							rgb[x * 3] = row[x * 4];
+							rgb[x * 3 + 1] = row[x * 4 + 1];
+							rgb[x * 3 + 2] = row[x * 4 + 2];
+						}
+
+						rows[i] = rgb;
+					}
+					else
+					{
+						rows[i] = (JSAMPROW)row;
+					}
 				}
 
-				::jpeg_finish_compress(&cinfo);
-				::jpeg_destroy_compress(&cinfo);
+				::jpeg_write_scanlines(&cinfo, rows, count);
+			}
+
+			::jpeg_finish_compress(&cinfo);
+			::jpeg_destroy_compress(&cinfo);
+		}
 
+		bool
+		JPEGHandler::doLoad(istream& stream, Image& image) noexcept
+		{
+			try
+			{
+				JPEGDecoder().decode(stream, image);
+				return true;
+			}
+			catch (...)
+			{
+				return false;
+			}
+		}
+
+		ImageReaderPtr
+		JPEGHandler::doOpen(istream& stream) noexcept
+		{
+			try
+			{
+				return JPEGDecoder().open(stream);
+			}
+			catch (...)
+			{
+				return nullptr;
+			}
+		}
+
+		bool
+		JPEGHandler::doSave(ostream& stream, const Image& image) noexcept
+		{
+			try
+			{
+				JPEGEncoder().encode(stream, image);
 				return true;
 			}
 			catch (...)
 			{
-				::jpeg_finish_compress(&cinfo);
-				::jpeg_destroy_compress(&cinfo);
 				return false;
 			}
 		}
 	}
-}
\ No newline at end of file
+}
@@ -19,6 +19,8 @@ namespace octoon
 			bool doLoad(istream& stream, Image& image) noexcept override;
 			bool doSave(ostream& stream, const Image& image) noexcept override;
 
+			ImageReaderPtr doOpen(istream& stream) noexcept override;
+
 		private:
 			JPEGHandler(const JPEGHandler&) noexcept = delete;
 			JPEGHandler& operator=(const JPEGHandler&) noexcept = delete;
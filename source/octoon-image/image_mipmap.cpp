@@ -0,0 +1,505 @@
+#include <octoon/image/image_mipmap.h>
+#include <octoon/runtime/except.h>
+#include <octoon/runtime/thread_pool.h>
+
+#include "image_codec.h"
+
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			constexpr float PI = 3.14159265358979323846f;
+
+			// Every destination texel reads taps source texels, indices are clamped to the edge.
+			struct Kernel
+			{
+				std::uint32_t taps;
+				std::vector<std::uint32_t> index;
+				std::vector<float> weight;
+			};
+
+			float sinc(float x) noexcept
+			{
+				return std::abs(x) < 1e-6f ? 1.0f : std::sin(PI * x) / (PI * x);
+			}
+
+			float bessel0(float x) noexcept
+			{
+				float sum = 1.0f;
+				float term = 1.0f;
+				for (int i = 1; i < 32 && term > sum * 1e-8f; i++)
+				{
+					term *= (x * x * 0.25f) / (i * i);
+					sum += term;
+				}
+
+				return sum;
+			}
+
+			float radius(MipmapFilter filter) noexcept
+			{
+				return filter == MipmapFilter::Box ? 0.5f : 3.0f;
+			}
+
+			float evaluate(MipmapFilter filter, float x) noexcept
+			{
+				constexpr float alpha = 4.0f;
+
+				float r = radius(filter);
+				if (std::abs(x) >= r)
+					return 0.0f;
+
+				if (filter == MipmapFilter::Kaiser)
+				{
+					float t = x / r;
+					return sinc(x) * bessel0(alpha * std::sqrt(1.0f - t * t)) / bessel0(alpha);
+				}
+
+				return sinc(x) * sinc(x / r);
+			}
+
+			Kernel makeKernel(MipmapFilter filter, std::uint32_t src, std::uint32_t dst) noexcept
+			{
+				Kernel kernel;
+
+				if (src == dst)
+				{
+					kernel.taps = 1;
+					kernel.index.resize(dst);
+					kernel.weight.assign(dst, 1.0f);
+					for (std::uint32_t i = 0; i < dst; i++)
+						kernel.index[i] = i;
+					return kernel;
+				}
+
+				float scale = (float)src / dst;
+				float support = radius(filter) * scale;
+
+				kernel.taps = (std::uint32_t)std::ceil(support * 2.0f) + 1;
+				kernel.index.resize(dst * kernel.taps);
+				kernel.weight.resize(dst * kernel.taps);
+
+				for (std::uint32_t i = 0; i < dst; i++)
+				{
+					float center = (i + 0.5f) * scale;
+					int first = (int)std::floor(center - support);
+
+					auto index = kernel.index.data() + i * kernel.taps;
+					auto weight = kernel.weight.data() + i * kernel.taps;
+
+					float sum = 0.0f;
+					for (std::uint32_t k = 0; k < kernel.taps; k++)
+					{
+						int j = first + (int)k;
+
+						float w;
+						if (filter == MipmapFilter::Box)
+						{
+							float lo = std::max((float)j, center - support);
+							float hi = std::min((float)j + 1.0f, center + support);
+							w = std::max(hi - lo, 0.0f);
+						}
+						else
+						{
+							w = evaluate(filter, (j + 0.5f - center) / scale);
+						}
+
+						index[k] = (std::uint32_t)std::min(std::max(j, 0), (int)src - 1);
+						weight[k] = w;
+						sum += w;
+					}
+
+					for (std::uint32_t k = 0; k < kernel.taps; k++)
+						weight[k] /= sum;
+				}
+
+				// Drop the last tap when no texel lands on it, as for a box at exactly half size.
+				bool unused = true;
+				for (std::uint32_t i = 0; i < dst && unused; i++)
+					unused = kernel.weight[i * kernel.taps + kernel.taps - 1] == 0.0f;
+
+				if (unused && kernel.taps > 1)
+				{
+					std::uint32_t taps = kernel.taps - 1;
+					for (std::uint32_t i = 0; i < dst; i++)
+					{
+						for (std::uint32_t k = 0; k < taps; k++)
+						{
+							kernel.index[i * taps + k] = kernel.index[i * kernel.taps + k];
+							kernel.weight[i * taps + k] = kernel.weight[i * kernel.taps + k];
+						}
+					}
+
+					kernel.taps = taps;
+					kernel.index.resize(dst * taps);
+					kernel.weight.resize(dst * taps);
+				}
+
+				return kernel;
+			}
+
+			void accumulate(float* dst, const float* src, float weight, std::size_t count) noexcept
+			{
+				std::size_t i = 0;
+#if defined(__SSE2__)
+				__m128 w = _mm_set1_ps(weight);
+				for (; i + 4 <= count; i += 4)
+					_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), w)));
+#endif
+				for (; i < count; i++)
+					dst[i] += src[i] * weight;
+			}
+
+			void filterRow(const float* src, float* dst, const Kernel& kernel, std::uint32_t width, std::uint8_t channel) noexcept
+			{
+#if defined(__SSE2__)
+				if (channel == 4)
+				{
+					for (std::uint32_t x = 0; x < width; x++)
+					{
+						auto index = kernel.index.data() + x * kernel.taps;
+						auto weight = kernel.weight.data() + x * kernel.taps;
+
+						__m128 sum = _mm_setzero_ps();
+						for (std::uint32_t k = 0; k < kernel.taps; k++)
+							sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + index[k] * 4), _mm_set1_ps(weight[k])));
+
+						_mm_storeu_ps(dst + x * 4, sum);
+					}
+
+					return;
+				}
+#endif
+				for (std::uint32_t x = 0; x < width; x++)
+				{
+					auto index = kernel.index.data() + x * kernel.taps;
+					auto weight = kernel.weight.data() + x * kernel.taps;
+
+					for (std::uint8_t c = 0; c < channel; c++)
+					{
+						float sum = 0.0f;
+						for (std::uint32_t k = 0; k < kernel.taps; k++)
+							sum += src[index[k] * channel + c] * weight[k];
+						dst[x * channel + c] = sum;
+					}
+				}
+			}
+
+			void normalize(float* pixels, std::uint32_t width, std::uint8_t channel, bool unorm) noexcept
+			{
+				for (std::uint32_t x = 0; x < width; x++)
+				{
+					float* n = pixels + x * channel;
+
+					float v[3];
+					for (int c = 0; c < 3; c++)
+						v[c] = unorm ? n[c] * 2.0f - 1.0f : n[c];
+
+					float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+					if (length < 1e-6f)
+						continue;
+
+					for (int c = 0; c < 3; c++)
+						n[c] = unorm ? v[c] / length * 0.5f + 0.5f : v[c] / length;
+				}
+			}
+
+			struct Level
+			{
+				char* data;
+				std::uint32_t width;
+				std::uint32_t height;
+			};
+
+			// Share of texels with an alpha above the cutoff.
+			float coverage(const PixelCodec& codec, const Level& level, std::uint32_t slice, float cutoff, std::vector<float>& alphas) noexcept
+			{
+				std::size_t pixels = (std::size_t)level.width * level.height;
+				std::vector<float> row(level.width * codec.channel());
+
+				auto data = level.data + slice * pixels * codec.pixelSize();
+
+				alphas.resize(pixels);
+				for (std::uint32_t y = 0; y < level.height; y++)
+				{
+					codec.decode(data + (std::size_t)y * level.width * codec.pixelSize(), row.data(), level.width);
+					for (std::uint32_t x = 0; x < level.width; x++)
+						alphas[(std::size_t)y * level.width + x] = row[x * codec.channel() + codec.alpha()];
+				}
+
+				std::size_t count = 0;
+				for (auto alpha : alphas)
+				{
+					if (alpha > cutoff)
+						count++;
+				}
+
+				return (float)count / pixels;
+			}
+
+			void scaleAlpha(const PixelCodec& codec, const Level& level, std::uint32_t slice, float cutoff, float target) noexcept
+			{
+				std::vector<float> alphas;
+				if (coverage(codec, level, slice, cutoff, alphas) == target)
+					return;
+
+				// Scale alpha so that the cutoff falls between two distinct values, picking the pair whose
+				// coverage comes closest to the target when several texels share the same alpha.
+				std::size_t pixels = alphas.size();
+				std::size_t k = std::min((std::size_t)std::lround(target * pixels), pixels);
+
+				float value = k == 0 ? *std::max_element(alphas.begin(), alphas.end()) : k == pixels ? *std::min_element(alphas.begin(), alphas.end()) : 0.0f;
+				if (k > 0 && k < pixels)
+				{
+					std::nth_element(alphas.begin(), alphas.begin() + k - 1, alphas.end(), std::greater<float>());
+					value = alphas[k - 1];
+				}
+
+				std::size_t above = 0;
+				std::size_t equal = 0;
+				float higher = 2.0f;
+				float lower = 0.0f;
+
+				for (auto alpha : alphas)
+				{
+					if (alpha > value)
+					{
+						above++;
+						higher = std::min(higher, alpha);
+					}
+					else if (alpha == value)
+					{
+						equal++;
+					}
+					else
+					{
+						lower = std::max(lower, alpha);
+					}
+				}
+
+				float threshold;
+				if (k == 0 || (k < above + equal && k - above < above + equal - k))
+					threshold = (value + std::min(higher, 1.0f)) * 0.5f;
+				else
+					threshold = (value + lower) * 0.5f;
+
+				if (threshold <= 0.0f)
+					return;
+
+				float scale = cutoff / threshold;
+
+				std::vector<float> row(level.width * codec.channel());
+				auto data = level.data + slice * pixels * codec.pixelSize();
+
+				for (std::uint32_t y = 0; y < level.height; y++)
+				{
+					auto pixel = data + (std::size_t)y * level.width * codec.pixelSize();
+					codec.decode(pixel, row.data(), level.width);
+
+					for (std::uint32_t x = 0; x < level.width; x++)
+					{
+						float& alpha = row[x * codec.channel() + codec.alpha()];
+						alpha = std::min(alpha * scale, 1.0f);
+					}
+
+					codec.encode(row.data(), pixel, level.width);
+				}
+			}
+		}
+
+		MipmapGenerator::MipmapGenerator(MipmapFilter filter) noexcept
+			: filter_(filter)
+			, alphaCutoff_(0.0f)
+			, normalMap_(false)
+		{
+		}
+
+		MipmapGenerator::~MipmapGenerator() noexcept
+		{
+		}
+
+		void
+		MipmapGenerator::setFilter(MipmapFilter filter) noexcept
+		{
+			filter_ = filter;
+		}
+
+		MipmapFilter
+		MipmapGenerator::getFilter() const noexcept
+		{
+			return filter_;
+		}
+
+		void
+		MipmapGenerator::setAlphaCutoff(float cutoff) noexcept
+		{
+			alphaCutoff_ = cutoff;
+		}
+
+		float
+		MipmapGenerator::getAlphaCutoff() const noexcept
+		{
+			return alphaCutoff_;
+		}
+
+		void
+		MipmapGenerator::setNormalMap(bool enable) noexcept
+		{
+			normalMap_ = enable;
+		}
+
+		bool
+		MipmapGenerator::getNormalMap() const noexcept
+		{
+			return normalMap_;
+		}
+
+		void
+		MipmapGenerator::generate(Image& image) const except
+		{
+			if (image.empty() || image.mipLevel() <= 1)
+				return;
+
+			PixelCodec codec(image.format());
+
+			std::uint8_t channel = codec.channel();
+			std::uint32_t slices = image.depth() * image.layerLevel();
+
+			bool normalMap = normalMap_ && channel >= 3;
+			bool alphaTest = alphaCutoff_ > 0.0f && codec.alpha() >= 0;
+
+			std::vector<Level> levels(image.mipLevel());
+
+			char* data = (char*)image.data();
+			std::uint32_t width = image.width();
+			std::uint32_t height = image.height();
+
+			for (auto& level : levels)
+			{
+				level.data = data;
+				level.width = width;
+				level.height = height;
+
+				data += (std::size_t)width * height * slices * codec.pixelSize();
+
+				width = std::max(width >> 1, 1u);
+				height = std::max(height >> 1, 1u);
+			}
+
+			std::vector<float> targets;
+			if (alphaTest)
+			{
+				targets.resize(slices);
+
+				runtime::ThreadPool::instance()->parallel_for(0, slices, 1, [&](std::size_t begin, std::size_t end)
+				{
+					std::vector<float> alphas;
+					for (std::size_t slice = begin; slice < end; slice++)
+						targets[slice] = coverage(codec, levels[0], (std::uint32_t)slice, alphaCutoff_, alphas);
+				});
+			}
+
+			for (std::size_t mip = 1; mip < levels.size(); mip++)
+			{
+				const Level& src = levels[mip - 1];
+				const Level& dst = levels[mip];
+
+				Kernel horizontal = makeKernel(filter_, src.width, dst.width);
+				Kernel vertical = makeKernel(filter_, src.height, dst.height);
+
+				std::size_t srcPitch = (std::size_t)src.width * codec.pixelSize();
+				std::size_t dstPitch = (std::size_t)dst.width * codec.pixelSize();
+				std::size_t srcCount = (std::size_t)src.width * channel;
+
+				std::size_t rows = (std::size_t)slices * dst.height;
+				std::size_t grain = std::max<std::size_t>(1, 65536 / dst.width);
+
+				runtime::ThreadPool::instance()->parallel_for(0, rows, grain, [&](std::size_t begin, std::size_t end)
+				{
+					// Consecutive rows share most of their source rows, a source row is decoded once per chunk.
+					std::vector<std::vector<float>> cache(vertical.taps, std::vector<float>(srcCount));
+					std::vector<std::size_t> tags(vertical.taps, (std::size_t)-1);
+
+					std::vector<float> column(srcCount);
+					std::vector<float> row((std::size_t)dst.width * channel);
+
+					for (std::size_t r = begin; r < end; r++)
+					{
+						std::size_t slice = r / dst.height;
+						std::uint32_t y = (std::uint32_t)(r % dst.height);
+
+						auto index = vertical.index.data() + y * vertical.taps;
+						auto weight = vertical.weight.data() + y * vertical.taps;
+
+						std::fill(column.begin(), column.end(), 0.0f);
+
+						for (std::uint32_t k = 0; k < vertical.taps; k++)
+						{
+							if (weight[k] == 0.0f)
+								continue;
+
+							std::size_t tag = slice * src.height + index[k];
+							auto& line = cache[index[k] % vertical.taps];
+
+							if (tags[index[k] % vertical.taps] != tag)
+							{
+								codec.decode(src.data + tag * srcPitch, line.data(), src.width);
+								tags[index[k] % vertical.taps] = tag;
+							}
+
+							accumulate(column.data(), line.data(), weight[k], srcCount);
+						}
+
+						filterRow(column.data(), row.data(), horizontal, dst.width, channel);
+
+						if (normalMap)
+							normalize(row.data(), dst.width, channel, codec.unorm());
+
+						codec.encode(row.data(), dst.data + r * dstPitch, dst.width);
+					}
+				});
+
+				if (alphaTest)
+				{
+					runtime::ThreadPool::instance()->parallel_for(0, slices, 1, [&](std::size_t begin, std::size_t end)
+					{
+						for (std::size_t slice = begin; slice < end; slice++)
+							scaleAlpha(codec, dst, (std::uint32_t)slice, alphaCutoff_, targets[slice]);
+					});
+				}
+			}
+		}
+
+		void
+		MipmapGenerator::generate(const Image& src, Image& dst, std::uint32_t levels) const except
+		{
+			if (src.empty())
+				throw runtime::runtime_error::create("MipmapGenerator : the source image is empty");
+
+			std::uint32_t full = 1;
+			while ((std::max(src.width(), src.height()) >> full) > 0)
+				full++;
+
+			levels = levels == 0 ? full : std::min(levels, full);
+
+			PixelCodec codec(src.format());
+
+			dst.create(src.format(), src.width(), src.height(), src.depth(), levels, src.layerLevel(), 0, src.layerBase());
+			std::memcpy((char*)dst.data(), src.data(), (std::size_t)src.width() * src.height() * src.depth() * src.layerLevel() * codec.pixelSize());
+
+			this->generate(dst);
+		}
+	}
+}
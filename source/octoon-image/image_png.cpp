@@ -1,9 +1,12 @@
 #include "image_png.h"
+#include <octoon/image/image_png_encoder.h>
+#include <octoon/image/image_reader.h>
 #include <octoon/runtime/except.h>
 
 #include <png.h>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 namespace octoon
 {
@@ -14,6 +17,10 @@ namespace octoon
 			jmp_buf jmpbuf;
 			bool verbose;
 
+			const char* view;
+			std::size_t viewSize;
+			std::size_t viewOffset;
+
 			union
 			{
 				istream* in;
@@ -33,22 +40,21 @@ namespace octoon
 			longjmp(info->jmpbuf, 1);
 		}
 
-		void PNGAPI png_flush_ptr(png_structp png_ptr)
-		{
-			PNGInfoStruct* info = (PNGInfoStruct*)png_get_io_ptr(png_ptr);
-			info->stream.out->flush();
-		}
-
 		void PNGAPI PNG_stream_reader(png_structp png_ptr, png_bytep data, png_size_t length)
 		{
 			PNGInfoStruct* info = (PNGInfoStruct*)png_get_io_ptr(png_ptr);
-			info->stream.in->read((char*)data, (std::streamsize)length);
-		}
+			if (info->view)
+			{
+				if (info->viewSize - info->viewOffset < length)
+					png_error(png_ptr, "read past the end of the stream");
 
-		void PNGAPI PNG_stream_write(png_structp png_ptr, png_bytep data, png_size_t length)
-		{
-			PNGInfoStruct* info = (PNGInfoStruct*)png_get_io_ptr(png_ptr);
-			info->stream.out->write((char*)data, (std::streamsize)length);
+				std::memcpy(data, info->view + info->viewOffset, length);
+				info->viewOffset += length;
+			}
+			else
+			{
+				info->stream.in->read((char*)data, (std::streamsize)length);
+			}
 		}
 
 		bool
@@ -70,106 +76,209 @@ namespace octoon
 			return std::strncmp(type_name, "png", 3) == 0;
 		}
 
-		bool
-		PNGHandler::doLoad(istream& stream, Image& image) noexcept
+		class PNGReader final : public ImageReader
 		{
-			png_structp png_ptr = nullptr;
-			png_infop info_ptr = nullptr;
+		public:
+			PNGReader() noexcept
+				: png_(nullptr)
+				, info_(nullptr)
+				, format_(Format::R8G8B8A8SRGB)
+				, width_(0)
+				, height_(0)
+				, row_(0)
+				, interlaced_(false)
+			{
+			}
 
-			try
+			~PNGReader() noexcept
 			{
-				PNGInfoStruct info;
-				info.stream.in = &stream;
+				if (png_)
+					::png_destroy_read_struct(&png_, info_ ? &info_ : nullptr, nullptr);
+			}
 
-				if (::setjmp(info.jmpbuf))
-					throw runtime::runtime_error::create("setjmp() failed");
+			void open(istream& stream) except
+			{
+				io_.stream.in = &stream;
+
+				// Chunks are copied straight out of the stream buffer when it can expose the rest of the file.
+				auto offset = stream.tellg();
+				auto length = stream.size() - offset;
+				io_.view = (offset >= 0 && length > 0) ? stream.view(length) : nullptr;
+				io_.viewSize = io_.view ? (std::size_t)length : 0;
+				io_.viewOffset = 0;
 
-				png_ptr = ::png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, &png_err, &png_warn);
-				if (!png_ptr)
+				png_ = ::png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, &png_err, &png_warn);
+				if (!png_)
 					throw runtime::runtime_error::create("png_create_read_struct() failed.");
 
-				info_ptr = ::png_create_info_struct(png_ptr);
-				if (!info_ptr)
+				info_ = ::png_create_info_struct(png_);
+				if (!info_)
 					throw runtime::runtime_error::create("png_create_info_struct() failed.");
 
-				::png_set_strip_16(png_ptr);
-				::png_set_packing(png_ptr);
-				::png_set_read_fn(png_ptr, &info, &PNG_stream_reader);
-				::png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
-				::png_set_benign_errors(png_ptr, 1);
-				::png_read_info(png_ptr, info_ptr);
+				if (::setjmp(io_.jmpbuf))
+					throw runtime::runtime_error::create("PNGReader : failed to read the header");
+
+				::png_set_strip_16(png_);
+				::png_set_packing(png_);
+				::png_set_read_fn(png_, &io_, &PNG_stream_reader);
+				::png_set_benign_errors(png_, 1);
+				::png_read_info(png_, info_);
 
 				png_uint_32 width, height;
 				int bit_depth, color_type, interlace_type;
 
-				if (!::png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, &interlace_type, 0, 0))
+				if (!::png_get_IHDR(png_, info_, &width, &height, &bit_depth, &color_type, &interlace_type, 0, 0))
 					throw runtime::runtime_error::create("png_get_IHDR() failed.");
 
 				if (color_type == PNG_COLOR_TYPE_PALETTE)
-					::png_set_expand(png_ptr);
+					::png_set_expand(png_);
 
 				if (bit_depth < 8)
-					::png_set_expand(png_ptr);
+					::png_set_expand(png_);
+
+				if (png_get_valid(png_, info_, PNG_INFO_tRNS))
+					::png_set_expand(png_);
+
+				if (!(color_type & PNG_COLOR_MASK_COLOR))
+					::png_set_gray_to_rgb(png_);
 
-				if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
-					::png_set_expand(png_ptr);
+				// Every file comes out as RGBA, opaque ones with a filled in alpha.
+				::png_set_filler(png_, 0xff, PNG_FILLER_AFTER);
 
 				int intent;
-				if (png_get_sRGB(png_ptr, info_ptr, &intent))
-					png_set_sRGB(png_ptr, info_ptr, intent);
+				if (png_get_sRGB(png_, info_, &intent))
+					png_set_sRGB(png_, info_, intent);
 
-				if (color_type & PNG_COLOR_TYPE_RGBA ||
-					color_type & PNG_COLOR_TYPE_RGB)
+				interlaced_ = ::png_set_interlace_handling(png_) > 1;
+
+				::png_read_update_info(png_, info_);
+
+				if (::png_get_rowbytes(png_, info_) != (png_size_t)width * 4)
+					throw runtime::runtime_error::create("PNGReader : unsupported pixel layout");
+
+				width_ = width;
+				height_ = height;
+			}
+
+			const Format& format() const noexcept override
+			{
+				return format_;
+			}
+
+			std::uint32_t width() const noexcept override
+			{
+				return width_;
+			}
+
+			std::uint32_t height() const noexcept override
+			{
+				return height_;
+			}
+
+			std::uint32_t row() const noexcept override
+			{
+				return row_;
+			}
+
+			std::uint32_t read(void* data, std::size_t pitch, std::uint32_t count) except override
+			{
+				count = std::min(count, height_ - row_);
+				if (count == 0)
+					return 0;
+
+				if (::setjmp(io_.jmpbuf))
+					throw runtime::runtime_error::create("PNGReader : failed to decode the image");
+
+				std::size_t rowSize = (std::size_t)width_ * 4;
+
+				if (interlaced_)
 				{
-					png_uint_32 pixelSize;
-					image::Format format;
-					if (color_type & PNG_COLOR_TYPE_RGBA)
-					{
-						format = image::Format::R8G8B8A8SRGB;
-						pixelSize = 4;
-					}
-					else if (color_type & PNG_COLOR_TYPE_RGB)
+					// Rows are complete after the last pass only.
+					if (image_.empty())
 					{
-						format = image::Format::R8G8B8SRGB;
-						pixelSize = 3;
-					}
+						image_.resize(rowSize * height_);
+
+						std::vector<png_bytep> pointers(height_);
+						for (std::uint32_t i = 0; i < height_; i++)
+							pointers[i] = image_.data() + i * rowSize;
 
-					if (!image.create(format, width, height))
-						throw runtime::runtime_error::create("Image::create() failed.");
+						::png_read_image(png_, pointers.data());
+					}
 
-					std::size_t columnLength = width * pixelSize;
-					std::uint8_t* pixel = (std::uint8_t*)image.data();
+					for (std::uint32_t i = 0; i < count; i++)
+						std::memcpy((std::uint8_t*)data + i * pitch, image_.data() + (row_ + i) * rowSize, rowSize);
+				}
+				else
+				{
+					for (std::uint32_t i = 0; i < count; i++)
+						::png_read_row(png_, (std::uint8_t*)data + i * pitch, nullptr);
+				}
 
-					std::vector<png_bytep> pointers(height, 0);
-					for (std::size_t i = 0; i < height; i++)
-						pointers[i] = pixel + i * columnLength;
+				row_ += count;
 
-					::png_start_read_image(png_ptr);
-					::png_read_image(png_ptr, pointers.data());
-					::png_read_end(png_ptr, info_ptr);
+				if (row_ == height_)
+				{
+					image_ = std::vector<std::uint8_t>();
+					::png_read_end(png_, nullptr);
 				}
 
-				::png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+				return count;
+			}
+
+		private:
+			png_structp png_;
+			png_infop info_;
+			PNGInfoStruct io_;
+
+			Format format_;
+
+			std::uint32_t width_;
+			std::uint32_t height_;
+			std::uint32_t row_;
 
+			bool interlaced_;
+			std::vector<std::uint8_t> image_;
+		};
+
+		bool
+		PNGHandler::doLoad(istream& stream, Image& image) noexcept
+		{
+			try
+			{
+				auto reader = this->doOpen(stream);
+				if (!reader)
+					return false;
+
+				if (!image.create(reader->format(), reader->width(), reader->height()))
+					throw runtime::runtime_error::create("Image::create() failed.");
+
+				reader->read((char*)image.data(), (std::size_t)image.width() * 4, image.height());
 				return true;
 			}
 			catch (...)
 			{
-				if (info_ptr)
-					::png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
-				else
-					::png_destroy_read_struct(&png_ptr, nullptr, nullptr);
-
 				return false;
 			}
 		}
 
+		ImageReaderPtr
+		PNGHandler::doOpen(istream& stream) noexcept
+		{
+			try
+			{
+				auto reader = std::make_shared<PNGReader>();
+				reader->open(stream);
+				return reader;
+			}
+			catch (...)
+			{
+				return nullptr;
+			}
+		}
+
 		bool
 		PNGHandler::doSave(ostream& stream, const Image& image) noexcept
 		{
-			png_infop info_ptr = nullptr;
-			png_structp png_ptr = nullptr;
-
 			try
 			{
 				auto& format = image.format();
@@ -179,54 +288,14 @@ namespace octoon
 					return false;
 				}
 
-				PNGInfoStruct info;
-				info.stream.out = &stream;
-
-				if (::setjmp(info.jmpbuf))
-					throw runtime::runtime_error::create("setjmp() failed");
-
-				png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
-				if (!png_ptr)
-					throw runtime::runtime_error::create(std::string("png_create_write_struct() failed"));
-
-				info_ptr = png_create_info_struct(png_ptr);
-				if (!info_ptr)
-					throw runtime::runtime_error::create(std::string("png_create_info_struct() failed"));
-
-				auto palette = std::make_unique<png_color[]>(PNG_MAX_PALETTE_LENGTH);
-				if (!palette)
-					throw runtime::runtime_error::create(std::string("png_malloc() failed"));
-
-				::png_set_strip_16(png_ptr);
-				::png_set_packing(png_ptr);
-				::png_set_write_fn(png_ptr, &info, &PNG_stream_write, &png_flush_ptr);
-				::png_set_benign_errors(png_ptr, 1);
-				::png_set_PLTE(png_ptr, info_ptr, palette.get(), PNG_MAX_PALETTE_LENGTH);
-				::png_set_IHDR(png_ptr, info_ptr, image.width(), image.height(), 8, format.channel() == 3 ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
-
-				::png_write_info(png_ptr, info_ptr);
-
-				auto stride = image.width() * format.channel();
-				auto rows = std::make_unique<png_bytep[]>(image.height());
-				for (std::uint32_t i = 0; i < image.height(); ++i)
-					rows[i] = (png_bytep)(image.data() + stride * i);
-
-				::png_write_image(png_ptr, rows.get());
-				::png_write_end(png_ptr, info_ptr);
-
-				::png_destroy_write_struct(&png_ptr, &info_ptr);
-
+				// The zlib level libpng writes with by default.
+				PNGEncoder(6).encode(stream, image);
 				return true;
 			}
 			catch (...)
 			{
-				if (info_ptr)
-					png_destroy_write_struct(&png_ptr, nullptr);
-				else
-					png_destroy_write_struct(&png_ptr, &info_ptr);
-
 				return false;
 			}
 		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,418 @@
+#include <octoon/image/image_png_encoder.h>
+#include <octoon/runtime/except.h>
+#include <octoon/runtime/thread_pool.h>
+
+#include <zlib.h>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+namespace octoon
+{
+	namespace image
+	{
+		namespace
+		{
+			enum FilterType : std::uint8_t
+			{
+				FilterNone,
+				FilterSub,
+				FilterUp,
+				FilterAverage,
+				FilterPaeth
+			};
+
+			void writeUInt32(std::uint8_t* out, std::uint32_t value) noexcept
+			{
+				out[0] = (std::uint8_t)(value >> 24);
+				out[1] = (std::uint8_t)(value >> 16);
+				out[2] = (std::uint8_t)(value >> 8);
+				out[3] = (std::uint8_t)(value);
+			}
+
+			// Chunks are built with room for their length and type in front and the CRC behind.
+			void beginChunk(std::vector<std::uint8_t>& chunk, const char type[4]) noexcept
+			{
+				chunk.resize(8);
+				std::memcpy(chunk.data() + 4, type, 4);
+			}
+
+			void endChunk(std::vector<std::uint8_t>& chunk) noexcept
+			{
+				auto length = (std::uint32_t)(chunk.size() - 8);
+				writeUInt32(chunk.data(), length);
+
+				auto crc = ::crc32(0, chunk.data() + 4, length + 4);
+				chunk.resize(chunk.size() + 4);
+				writeUInt32(chunk.data() + chunk.size() - 4, (std::uint32_t)crc);
+			}
+
+			std::uint8_t paeth(std::uint8_t a, std::uint8_t b, std::uint8_t c) noexcept
+			{
+				int p = a + b - c;
+				int pa = std::abs(p - a);
+				int pb = std::abs(p - b);
+				int pc = std::abs(p - c);
+
+				if (pa <= pb && pa <= pc)
+					return a;
+				return pb <= pc ? b : c;
+			}
+
+			// The filters read the unfiltered rows only, so every strip can start anywhere.
+			// prev is a row of zeros for the first row of the image.
+			void filterRow(FilterType type, const std::uint8_t* row, const std::uint8_t* prev, std::uint8_t* out, std::size_t size, std::size_t bpp) noexcept
+			{
+				std::size_t i = 0;
+
+				switch (type)
+				{
+				case FilterNone:
+					std::memcpy(out, row, size);
+					return;
+				case FilterSub:
+					for (; i < bpp; i++)
+						out[i] = row[i];
+#if defined(__SSE2__)
+					for (; i + 16 <= size; i += 16)
+					{
+						auto x = _mm_loadu_si128((const __m128i*)(row + i));
+						auto a = _mm_loadu_si128((const __m128i*)(row + i - bpp));
+						_mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi8(x, a));
+					}
+#endif
+					for (; i < size; i++)
+						out[i] = row[i] - row[i - bpp];
+					return;
+				case FilterUp:
+#if defined(__SSE2__)
+					for (; i + 16 <= size; i += 16)
+					{
+						auto x = _mm_loadu_si128((const __m128i*)(row + i));
+						auto b = _mm_loadu_si128((const __m128i*)(prev + i));
+						_mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi8(x, b));
+					}
+#endif
+					for (; i < size; i++)
+						out[i] = row[i] - prev[i];
+					return;
+				case FilterAverage:
+					for (; i < bpp; i++)
+						out[i] = row[i] - (prev[i] >> 1);
+#if defined(__SSE2__)
+					for (; i + 16 <= size; i += 16)
+					{
+						auto x = _mm_loadu_si128((const __m128i*)(row + i));
+						auto a = _mm_loadu_si128((const __m128i*)(row + i - bpp));
+						auto b = _mm_loadu_si128((const __m128i*)(prev + i));
+
+						// pavgb rounds up, the filter rounds down.
+						auto avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+						_mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi8(x, avg));
+					}
+#endif
+					for (; i < size; i++)
+						out[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+					return;
+				case FilterPaeth:
+					for (; i < bpp; i++)
+						out[i] = row[i] - prev[i];
+#if defined(__SSE2__)
+					for (; i + 8 <= size; i += 8)
+					{
+						auto zero = _mm_setzero_si128();
+						auto x = _mm_loadl_epi64((const __m128i*)(row + i));
+						auto a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + i - bpp)), zero);
+						auto b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(prev + i)), zero);
+						auto c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(prev + i - bpp)), zero);
+
+						auto pa = _mm_sub_epi16(b, c);
+						auto pb = _mm_sub_epi16(a, c);
+						auto pc = _mm_add_epi16(pa, pb);
+
+						pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+						pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+						pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+						auto useA = _mm_and_si128(_mm_cmpgt_epi16(_mm_add_epi16(pb, _mm_set1_epi16(1)), pa), _mm_cmpgt_epi16(_mm_add_epi16(pc, _mm_set1_epi16(1)), pa));
+						auto useB = _mm_andnot_si128(useA, _mm_cmpgt_epi16(_mm_add_epi16(pc, _mm_set1_epi16(1)), pb));
+						auto useC = _mm_andnot_si128(_mm_or_si128(useA, useB), _mm_set1_epi16(-1));
+
+						auto predictor = _mm_or_si128(_mm_or_si128(_mm_and_si128(useA, a), _mm_and_si128(useB, b)), _mm_and_si128(useC, c));
+						_mm_storel_epi64((__m128i*)(out + i), _mm_sub_epi8(x, _mm_packus_epi16(predictor, zero)));
+					}
+#endif
+					for (; i < size; i++)
+						out[i] = row[i] - paeth(row[i - bpp], prev[i], prev[i - bpp]);
+					return;
+				}
+			}
+
+			// The heuristic of libpng, bytes are taken as signed and the row with the smallest sum wins.
+			std::uint64_t filterCost(const std::uint8_t* data, std::size_t size) noexcept
+			{
+				std::uint64_t sum = 0;
+				std::size_t i = 0;
+
+#if defined(__SSE2__)
+				auto zero = _mm_setzero_si128();
+				auto acc = _mm_setzero_si128();
+
+				for (; i + 16 <= size; i += 16)
+				{
+					auto v = _mm_loadu_si128((const __m128i*)(data + i));
+					auto abs = _mm_min_epu8(v, _mm_sub_epi8(zero, v));
+					acc = _mm_add_epi64(acc, _mm_sad_epu8(abs, zero));
+				}
+
+				std::uint64_t lanes[2];
+				_mm_storeu_si128((__m128i*)lanes, acc);
+				sum = lanes[0] + lanes[1];
+#endif
+				for (; i < size; i++)
+					sum += data[i] < 128 ? data[i] : 256 - data[i];
+
+				return sum;
+			}
+
+			struct Strip
+			{
+				std::uint32_t first;
+				std::uint32_t last;
+
+				std::uint32_t adler;
+				std::size_t length;
+
+				std::vector<std::uint8_t> chunk;
+			};
+		}
+
+		PNGEncoder::PNGEncoder(int level) noexcept
+			: level_(std::min(std::max(level, 0), 9))
+			, stripHeight_(0)
+		{
+		}
+
+		PNGEncoder::~PNGEncoder() noexcept
+		{
+		}
+
+		void
+		PNGEncoder::setLevel(int level) noexcept
+		{
+			level_ = std::min(std::max(level, 0), 9);
+		}
+
+		int
+		PNGEncoder::getLevel() const noexcept
+		{
+			return level_;
+		}
+
+		void
+		PNGEncoder::setStripHeight(std::uint32_t rows) noexcept
+		{
+			stripHeight_ = rows;
+		}
+
+		std::uint32_t
+		PNGEncoder::getStripHeight() const noexcept
+		{
+			return stripHeight_;
+		}
+
+		void
+		PNGEncoder::encode(ostream& stream, const Image& image) const except
+		{
+			auto& format = image.format();
+			if (format != Format::R8UNorm && format != Format::R8SRGB &&
+				format != Format::R8G8UNorm && format != Format::R8G8SRGB &&
+				format != Format::R8G8B8UNorm && format != Format::R8G8B8SRGB &&
+				format != Format::R8G8B8A8UNorm && format != Format::R8G8B8A8SRGB)
+			{
+				throw runtime::runtime_error::create("PNGEncoder : unsupported image format");
+			}
+
+			auto channels = format.channel();
+			this->encode(stream, (const std::uint8_t*)image.data(), image.width(), image.height(), channels, (std::ptrdiff_t)image.width() * channels);
+		}
+
+		void
+		PNGEncoder::encode(ostream& stream, const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint8_t channels, std::ptrdiff_t stride) const except
+		{
+			assert(pixels);
+
+			static const std::uint8_t colorTypes[] = { 0, 0, 4, 2, 6 };
+
+			if (width == 0 || height == 0 || channels == 0 || channels > 4)
+				throw runtime::runtime_error::create("PNGEncoder : invalid image size or channel count");
+
+			std::size_t bpp = channels;
+			std::size_t rowSize = (std::size_t)width * bpp;
+
+			std::uint32_t stripHeight = stripHeight_;
+			if (stripHeight == 0)
+				stripHeight = (std::uint32_t)std::max<std::size_t>(1, (256 << 10) / rowSize);
+
+			std::vector<Strip> strips((height + stripHeight - 1) / stripHeight);
+			for (std::size_t i = 0; i < strips.size(); i++)
+			{
+				strips[i].first = (std::uint32_t)(i * stripHeight);
+				strips[i].last = std::min(strips[i].first + stripHeight, height);
+			}
+
+			// 78 01, 78 5E, 78 9C and 78 DA are the headers zlib itself writes for these levels.
+			static const std::uint8_t zlibLevels[] = { 0x01, 0x01, 0x5E, 0x5E, 0x5E, 0x5E, 0x9C, 0xDA, 0xDA, 0xDA };
+
+			auto level = level_;
+			std::vector<std::uint8_t> zeros(rowSize + bpp);
+
+			std::atomic<bool> failed(false);
+
+			runtime::ThreadPool::instance()->parallel_for(0, strips.size(), 1, [&](std::size_t begin, std::size_t end)
+			{
+				std::vector<std::uint8_t> filtered;
+				std::vector<std::uint8_t> candidate;
+
+				z_stream zstream;
+				std::memset(&zstream, 0, sizeof(zstream));
+
+				// Raw deflate, the zlib header and checksum of the whole stream are written around the strips.
+				if (::deflateInit2(&zstream, level, Z_DEFLATED, -15, 8, level >= 4 ? Z_FILTERED : Z_DEFAULT_STRATEGY) != Z_OK)
+				{
+					failed = true;
+					return;
+				}
+
+				for (std::size_t s = begin; s < end; s++)
+				{
+					auto& strip = strips[s];
+
+					filtered.resize((strip.last - strip.first) * (rowSize + 1));
+					candidate.resize(rowSize);
+
+					auto out = filtered.data();
+
+					for (std::uint32_t y = strip.first; y < strip.last; y++, out += rowSize + 1)
+					{
+						auto row = pixels + (std::ptrdiff_t)y * stride;
+						auto prev = y > 0 ? row - stride : zeros.data() + bpp;
+
+						if (level == 0)
+						{
+							out[0] = FilterNone;
+							std::memcpy(out + 1, row, rowSize);
+						}
+						else if (level <= 3)
+						{
+							out[0] = FilterUp;
+							filterRow(FilterUp, row, prev, out + 1, rowSize, bpp);
+						}
+						else
+						{
+							out[0] = FilterNone;
+							std::memcpy(out + 1, row, rowSize);
+
+							auto best = filterCost(out + 1, rowSize);
+
+							for (auto type : { FilterSub, FilterUp, FilterAverage, FilterPaeth })
+							{
+								filterRow(type, row, prev, candidate.data(), rowSize, bpp);
+
+								auto cost = filterCost(candidate.data(), rowSize);
+								if (cost < best)
+								{
+									best = cost;
+									out[0] = type;
+									std::memcpy(out + 1, candidate.data(), rowSize);
+								}
+							}
+						}
+					}
+
+					strip.length = filtered.size();
+					strip.adler = (std::uint32_t)::adler32(::adler32(0, nullptr, 0), filtered.data(), (uInt)filtered.size());
+
+					beginChunk(strip.chunk, "IDAT");
+
+					if (s == 0)
+					{
+						strip.chunk.push_back(0x78);
+						strip.chunk.push_back(zlibLevels[level]);
+					}
+
+					auto offset = strip.chunk.size();
+					strip.chunk.resize(offset + ::deflateBound(&zstream, (uLong)filtered.size()) + 16);
+
+					// Every strip but the last ends on a byte boundary without closing the stream.
+					zstream.next_in = filtered.data();
+					zstream.avail_in = (uInt)filtered.size();
+					zstream.next_out = strip.chunk.data() + offset;
+					zstream.avail_out = (uInt)(strip.chunk.size() - offset);
+
+					auto result = ::deflate(&zstream, s + 1 == strips.size() ? Z_FINISH : Z_SYNC_FLUSH);
+					if (result == Z_STREAM_ERROR || zstream.avail_in != 0 || zstream.avail_out == 0 || (s + 1 == strips.size() && result != Z_STREAM_END))
+					{
+						failed = true;
+						break;
+					}
+
+					strip.chunk.resize(strip.chunk.size() - zstream.avail_out);
+					endChunk(strip.chunk);
+
+					::deflateReset(&zstream);
+				}
+
+				::deflateEnd(&zstream);
+			});
+
+			if (failed)
+				throw runtime::runtime_error::create("PNGEncoder : deflate() failed");
+
+			static const std::uint8_t signature[] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+			std::vector<std::uint8_t> header;
+			beginChunk(header, "IHDR");
+			header.resize(header.size() + 13);
+			writeUInt32(header.data() + 8, width);
+			writeUInt32(header.data() + 12, height);
+			header[16] = 8;
+			header[17] = colorTypes[channels];
+			header[18] = 0;
+			header[19] = 0;
+			header[20] = 0;
+			endChunk(header);
+
+			auto adler = strips.front().adler;
+			for (std::size_t i = 1; i < strips.size(); i++)
+				adler = (std::uint32_t)::adler32_combine(adler, strips[i].adler, (z_off_t)strips[i].length);
+
+			std::vector<std::uint8_t> trailer;
+			beginChunk(trailer, "IDAT");
+			trailer.resize(trailer.size() + 4);
+			writeUInt32(trailer.data() + 8, adler);
+			endChunk(trailer);
+
+			std::vector<std::uint8_t> end;
+			beginChunk(end, "IEND");
+			endChunk(end);
+
+			stream.write((const char*)signature, sizeof(signature));
+			stream.write((const char*)header.data(), header.size());
+
+			for (auto& strip : strips)
+				stream.write((const char*)strip.chunk.data(), strip.chunk.size());
+
+			stream.write((const char*)trailer.data(), trailer.size());
+			stream.write((const char*)end.data(), end.size());
+
+			if (!stream)
+				throw runtime::runtime_error::create("PNGEncoder : failed to write the image");
+		}
+	}
+}
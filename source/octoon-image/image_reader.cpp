@@ -0,0 +1,23 @@
+#include <octoon/image/image_reader.h>
+#include <octoon/image/image_loader.h>
+
+#include "image_all.h"
+
+namespace octoon
+{
+	namespace image
+	{
+		ImageReaderPtr
+		ImageReader::open(istream& stream, const char* type) noexcept
+		{
+			if (stream.good())
+			{
+				ImageLoaderPtr impl = image::findHandler(stream, type);
+				if (impl)
+					return impl->doOpen(stream);
+			}
+
+			return nullptr;
+		}
+	}
+}
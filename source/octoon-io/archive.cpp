@@ -4,5 +4,12 @@ namespace octoon
 {
 	namespace io
 	{
+		void
+		archive::exists(const std::vector<Orl>& orls, std::vector<ItemType>& types)
+		{
+			types.resize(orls.size());
+			for (std::size_t i = 0; i < orls.size(); i++)
+				types[i] = this->exists(orls[i]);
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,456 @@
+#include <octoon/io/async_loader.h>
+#include <octoon/io/ioserver.h>
+#include <octoon/io/membuf.h>
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include <condition_variable>
+
+namespace octoon
+{
+	namespace io
+	{
+		namespace
+		{
+			using QueueKey = std::pair<int, std::uint64_t>;
+
+			enum class Stage
+			{
+				Reading,
+				Decoding,
+				Running,
+				Finished
+			};
+		}
+
+		struct AsyncLoader::Job
+		{
+			std::string key;
+			Orl orl;
+			Decoder decoder;
+
+			LoadPriority priority;
+			std::uint64_t sequence;
+
+			Stage stage;
+			std::atomic<LoadStatus> status;
+
+			std::unique_ptr<stream_buf> data;
+			std::shared_ptr<void> result;
+
+			std::promise<std::shared_ptr<void>> promise;
+			std::shared_future<std::shared_ptr<void>> future;
+
+			std::vector<std::shared_ptr<Waiter>> waiters;
+		};
+
+		struct AsyncLoader::Waiter
+		{
+			std::shared_ptr<Job> job;
+			std::weak_ptr<Context> context;
+
+			Callback callback;
+			bool cancelled;
+		};
+
+		struct AsyncLoader::Context
+		{
+			mutable std::mutex mutex;
+			std::condition_variable io_cond;
+			std::condition_variable decode_cond;
+
+			bool quit = false;
+			std::uint64_t sequence = 0;
+
+			std::map<QueueKey, std::shared_ptr<Job>> io_queue;
+			std::map<QueueKey, std::shared_ptr<Job>> decode_queue;
+			std::unordered_map<std::string, std::shared_ptr<Job>> inflight;
+			std::vector<std::shared_ptr<Job>> finished;
+
+			std::map<QueueKey, std::shared_ptr<Job>>* queue(Job& job) noexcept
+			{
+				switch (job.stage)
+				{
+				case Stage::Reading: return &io_queue;
+				case Stage::Decoding: return &decode_queue;
+				default:
+					return nullptr;
+				}
+			}
+
+			void push(const std::shared_ptr<Job>& job, Stage stage) noexcept
+			{
+				job->stage = stage;
+				this->queue(*job)->emplace(QueueKey((int)job->priority, job->sequence), job);
+				(stage == Stage::Reading ? io_cond : decode_cond).notify_one();
+			}
+
+			std::shared_ptr<Job> pop(std::map<QueueKey, std::shared_ptr<Job>>& queue) noexcept
+			{
+				auto job = std::move(queue.begin()->second);
+				queue.erase(queue.begin());
+				job->stage = Stage::Running;
+				return job;
+			}
+
+			void finish(const std::shared_ptr<Job>& job, std::shared_ptr<void>&& result) noexcept
+			{
+				job->stage = Stage::Finished;
+				job->data.reset();
+
+				// Cancelled jobs were resolved and forgotten when their last ticket left.
+				if (job->status == LoadStatus::Cancelled)
+					return;
+
+				job->status = result ? LoadStatus::Done : LoadStatus::Failed;
+				job->result = result;
+				job->promise.set_value(std::move(result));
+
+				inflight.erase(job->key);
+				finished.push_back(job);
+			}
+
+			void cancel(const std::shared_ptr<Job>& job) noexcept
+			{
+				if (job->status != LoadStatus::Pending)
+					return;
+
+				auto queue = this->queue(*job);
+				if (queue)
+					queue->erase(QueueKey((int)job->priority, job->sequence));
+
+				job->status = LoadStatus::Cancelled;
+				job->promise.set_value(nullptr);
+
+				// Tickets point at their job, the job lets go of them once they can't be called anymore.
+				job->waiters.clear();
+
+				inflight.erase(job->key);
+			}
+		};
+
+		AsyncLoader::Ticket::Ticket() noexcept
+		{
+		}
+
+		AsyncLoader::Ticket::Ticket(std::shared_ptr<Waiter>&& waiter) noexcept
+			: waiter_(std::move(waiter))
+		{
+		}
+
+		bool
+		AsyncLoader::Ticket::valid() const noexcept
+		{
+			return waiter_ != nullptr;
+		}
+
+		LoadStatus
+		AsyncLoader::Ticket::status() const noexcept
+		{
+			if (!waiter_)
+				return LoadStatus::Failed;
+
+			auto context = waiter_->context.lock();
+			if (context)
+			{
+				std::lock_guard<std::mutex> lock(context->mutex);
+				if (waiter_->cancelled)
+					return LoadStatus::Cancelled;
+			}
+
+			return waiter_->job->status;
+		}
+
+		void
+		AsyncLoader::Ticket::cancel() noexcept
+		{
+			if (!waiter_)
+				return;
+
+			auto context = waiter_->context.lock();
+			if (!context)
+				return;
+
+			std::lock_guard<std::mutex> lock(context->mutex);
+			if (waiter_->cancelled)
+				return;
+
+			waiter_->cancelled = true;
+			waiter_->callback = nullptr;
+
+			auto& waiters = waiter_->job->waiters;
+			if (std::all_of(waiters.begin(), waiters.end(), [](const std::shared_ptr<Waiter>& it) { return it->cancelled; }))
+				context->cancel(waiter_->job);
+		}
+
+		std::shared_future<std::shared_ptr<void>>
+		AsyncLoader::Ticket::future() const noexcept
+		{
+			return waiter_ ? waiter_->job->future : std::shared_future<std::shared_ptr<void>>();
+		}
+
+		AsyncLoader::AsyncLoader(std::size_t io_threads, std::size_t decode_threads) noexcept
+			: context_(std::make_shared<Context>())
+		{
+			if (decode_threads == 0)
+				decode_threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+			for (std::size_t i = 0; i < std::max<std::size_t>(io_threads, 1); i++)
+				io_threads_.emplace_back(&AsyncLoader::io_run, this);
+
+			for (std::size_t i = 0; i < decode_threads; i++)
+				decode_threads_.emplace_back(&AsyncLoader::decode_run, this);
+		}
+
+		AsyncLoader::~AsyncLoader() noexcept
+		{
+			{
+				std::lock_guard<std::mutex> lock(context_->mutex);
+				context_->quit = true;
+			}
+
+			context_->io_cond.notify_all();
+			context_->decode_cond.notify_all();
+
+			for (auto& it : io_threads_)
+				it.join();
+
+			for (auto& it : decode_threads_)
+				it.join();
+
+			// Whatever is left never runs, futures still waiting on it resolve to nullptr.
+			std::lock_guard<std::mutex> lock(context_->mutex);
+			while (!context_->inflight.empty())
+				context_->cancel(context_->inflight.begin()->second);
+
+			for (auto& job : context_->finished)
+				job->waiters.clear();
+		}
+
+		AsyncLoader::Ticket
+		AsyncLoader::load(const Orl& orl, const char* tag, Decoder&& decoder, Callback&& callback, LoadPriority priority) noexcept
+		{
+			auto key = std::string(tag ? tag : "") + '|' + orl.to_string();
+
+			auto waiter = std::make_shared<Waiter>();
+			waiter->context = context_;
+			waiter->callback = std::move(callback);
+			waiter->cancelled = false;
+
+			std::lock_guard<std::mutex> lock(context_->mutex);
+
+			auto it = context_->inflight.find(key);
+			if (it != context_->inflight.end())
+			{
+				auto& job = it->second;
+
+				// A more urgent request moves the shared job ahead in whichever queue it waits in.
+				auto queue = context_->queue(*job);
+				if (queue && priority < job->priority)
+				{
+					queue->erase(QueueKey((int)job->priority, job->sequence));
+					job->priority = priority;
+					queue->emplace(QueueKey((int)job->priority, job->sequence), job);
+				}
+
+				waiter->job = job;
+				job->waiters.push_back(waiter);
+
+				return Ticket(std::move(waiter));
+			}
+
+			auto job = std::make_shared<Job>();
+			job->key = std::move(key);
+			job->orl = orl;
+			job->decoder = std::move(decoder);
+			job->priority = priority;
+			job->sequence = context_->sequence++;
+			job->status = LoadStatus::Pending;
+			job->future = job->promise.get_future().share();
+			job->waiters.push_back(waiter);
+
+			waiter->job = job;
+
+			context_->inflight.emplace(job->key, job);
+			context_->push(job, Stage::Reading);
+
+			return Ticket(std::move(waiter));
+		}
+
+		AsyncLoader::Ticket
+		AsyncLoader::load_bytes(const Orl& orl, Callback&& callback, LoadPriority priority) noexcept
+		{
+			return this->load(orl, nullptr, nullptr, std::move(callback), priority);
+		}
+
+		AsyncLoader::Ticket
+		AsyncLoader::resolve(std::shared_ptr<void>&& result, Callback&& callback) noexcept
+		{
+			auto waiter = std::make_shared<Waiter>();
+			waiter->context = context_;
+			waiter->callback = std::move(callback);
+			waiter->cancelled = false;
+
+			auto job = std::make_shared<Job>();
+			job->priority = LoadPriority::Normal;
+			job->sequence = 0;
+			job->status = LoadStatus::Pending;
+			job->future = job->promise.get_future().share();
+			job->waiters.push_back(waiter);
+
+			waiter->job = job;
+
+			std::lock_guard<std::mutex> lock(context_->mutex);
+			context_->finish(job, std::move(result));
+
+			return Ticket(std::move(waiter));
+		}
+
+		std::size_t
+		AsyncLoader::dispatch() noexcept
+		{
+			std::vector<std::shared_ptr<Job>> finished;
+
+			{
+				std::lock_guard<std::mutex> lock(context_->mutex);
+				finished.swap(context_->finished);
+			}
+
+			std::size_t count = 0;
+
+			for (auto& job : finished)
+			{
+				for (auto& waiter : job->waiters)
+				{
+					Callback callback;
+
+					{
+						std::lock_guard<std::mutex> lock(context_->mutex);
+						if (waiter->cancelled)
+							continue;
+						callback = std::move(waiter->callback);
+					}
+
+					if (callback)
+					{
+						callback(job->result);
+						count++;
+					}
+				}
+
+				std::lock_guard<std::mutex> lock(context_->mutex);
+				job->waiters.clear();
+			}
+
+			return count;
+		}
+
+		std::size_t
+		AsyncLoader::pending() const noexcept
+		{
+			std::lock_guard<std::mutex> lock(context_->mutex);
+			return context_->inflight.size();
+		}
+
+		void
+		AsyncLoader::io_run() noexcept
+		{
+			auto& context = *context_;
+
+			for (;;)
+			{
+				std::shared_ptr<Job> job;
+
+				{
+					std::unique_lock<std::mutex> lock(context.mutex);
+					context.io_cond.wait(lock, [&]() { return context.quit || !context.io_queue.empty(); });
+
+					if (context.quit)
+						return;
+
+					job = context.pop(context.io_queue);
+				}
+
+				std::unique_ptr<stream_buf> data;
+				std::shared_ptr<Bytes> bytes;
+
+				auto archive = IoServer::instance()->get_archive(job->orl);
+				auto buf = archive ? archive->open(job->orl, ios_base::in) : nullptr;
+
+				if (buf)
+				{
+					auto size = buf->size();
+
+					if (!job->decoder)
+					{
+						bytes = std::make_shared<Bytes>(size);
+						if (buf->read_at(0, (char*)bytes->data(), size) != size)
+							bytes = nullptr;
+					}
+					else if (buf->peek(size))
+					{
+						// Mapped files are decoded in place, the I/O thread only settles the request.
+						data = std::move(buf);
+					}
+					else
+					{
+						Bytes content(size);
+						if (buf->read_at(0, (char*)content.data(), size) == size)
+							data = std::make_unique<membuf>(std::move(content));
+					}
+				}
+
+				std::lock_guard<std::mutex> lock(context.mutex);
+
+				if (data && job->status == LoadStatus::Pending)
+				{
+					job->data = std::move(data);
+					context.push(job, Stage::Decoding);
+				}
+				else
+				{
+					context.finish(job, std::move(bytes));
+				}
+			}
+		}
+
+		void
+		AsyncLoader::decode_run() noexcept
+		{
+			auto& context = *context_;
+
+			for (;;)
+			{
+				std::shared_ptr<Job> job;
+
+				{
+					std::unique_lock<std::mutex> lock(context.mutex);
+					context.decode_cond.wait(lock, [&]() { return context.quit || !context.decode_queue.empty(); });
+
+					if (context.quit)
+						return;
+
+					job = context.pop(context.decode_queue);
+				}
+
+				std::shared_ptr<void> result;
+
+				try
+				{
+					istream stream(job->data.get());
+					result = job->decoder(stream);
+				}
+				catch (...)
+				{
+					result = nullptr;
+				}
+
+				std::lock_guard<std::mutex> lock(context.mutex);
+				context.finish(job, std::move(result));
+			}
+		}
+	}
+}
@@ -6,6 +6,7 @@
 #include <octoon/io/farchive.h>
 #include <octoon/io/mstream.h>
 #include <octoon/io/fstream.h>
+#include <octoon/io/mapbuf.h>
 
 #ifndef __linux
 #include <filesystem>
@@ -16,31 +17,387 @@ namespace std
 		using namespace std::experimental::filesystem;
 	}
 }
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
 #endif
 
 namespace octoon
 {
 	namespace io
 	{
+#ifdef __linux
+		namespace
+		{
+			const std::uint32_t notify_mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+			// Path of the item relative to the archive root, "." names the root itself.
+			std::string
+			relative_path(const Orl& orl)
+			{
+				auto& path = orl.path();
+
+				std::size_t first = path.find_first_not_of('/');
+				std::size_t last = path.find_last_not_of('/');
+				if (first == std::string::npos)
+					return ".";
+
+				return path.substr(first, last - first + 1);
+			}
+
+			std::string
+			parent_path(const std::string& path)
+			{
+				auto pos = path.rfind('/');
+				return pos == std::string::npos ? "." : path.substr(0, pos);
+			}
+
+			std::string
+			child_path(const std::string& dir, const char* name)
+			{
+				return dir == "." ? std::string(name) : dir + '/' + name;
+			}
+
+			ItemType
+			item_type(mode_t mode) noexcept
+			{
+				if (S_ISREG(mode))
+					return ItemType::File;
+				if (S_ISDIR(mode))
+					return ItemType::Directory;
+				return ItemType::NA;
+			}
+
+			bool
+			make_dirs(int dirfd, const std::string& path) noexcept
+			{
+				if (path == ".")
+					return true;
+
+				for (std::size_t pos = path.find('/'); ; pos = path.find('/', pos + 1))
+				{
+					auto segment = path.substr(0, pos);
+					if (::mkdirat(dirfd, segment.c_str(), 0755) != 0 && errno != EEXIST)
+						return false;
+
+					if (pos == std::string::npos)
+						return true;
+				}
+			}
+
+			bool
+			remove_tree(int dirfd, const char* name) noexcept
+			{
+				int fd = ::openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+				if (fd < 0)
+					return false;
+
+				DIR* dir = ::fdopendir(fd);
+				if (!dir)
+				{
+					::close(fd);
+					return false;
+				}
+
+				bool result = true;
+
+				while (auto entry = ::readdir(dir))
+				{
+					if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0)
+						continue;
+
+					bool is_dir = entry->d_type == DT_DIR;
+					if (entry->d_type == DT_UNKNOWN)
+					{
+						struct stat st;
+						is_dir = ::fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+					}
+
+					if (is_dir)
+						result &= remove_tree(fd, entry->d_name);
+					else
+						result &= ::unlinkat(fd, entry->d_name, 0) == 0;
+				}
+
+				::closedir(dir);
+
+				return result && ::unlinkat(dirfd, name, AT_REMOVEDIR) == 0;
+			}
+		}
+
 		farchive::farchive(const char* base_dir) noexcept
 			: base_dir_(base_dir)
 		{
+			this->on_open();
 		}
 
 		farchive::farchive(std::string&& base_dir) noexcept
 			: base_dir_(std::move(base_dir))
 		{
+			this->on_open();
 		}
 
 		farchive::farchive(const std::string& base_dir) noexcept
 			: base_dir_(base_dir)
 		{
+			this->on_open();
+		}
+
+		farchive::~farchive() noexcept
+		{
+			if (notify_fd_ >= 0)
+				::close(notify_fd_);
+			if (dir_fd_ >= 0)
+				::close(dir_fd_);
+		}
+
+		void
+		farchive::on_open() noexcept
+		{
+			dir_fd_ = ::open(base_dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			notify_fd_ = dir_fd_ >= 0 ? ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC) : -1;
 		}
 
 		std::unique_ptr<stream_buf>
 		farchive::open(const Orl& orl, const ios_base::open_mode opts)
 		{
-#ifndef __linux
+			if (dir_fd_ < 0)
+				return nullptr;
+
+			auto path = relative_path(orl);
+
+			// Read-only opens are mapped when possible, non-regular or empty files use filebuf.
+			if (!(opts & ios_base::out))
+			{
+				auto map = std::make_unique<mapbuf>();
+				if (map->open(dir_fd_, path.c_str()))
+					return map;
+			}
+			else if (this->exists(orl) == ItemType::NA)
+			{
+				// Create missing segments, the file itself is created by filebuf if the mode allows it.
+				if (!make_dirs(dir_fd_, parent_path(path)))
+					return nullptr;
+			}
+
+			auto file = std::make_unique<filebuf>();
+			if (!file->open(make_path(orl), opts))
+				return nullptr;
+
+			if (opts & ios_base::out)
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				this->invalidate(path);
+			}
+
+			return file;
+		}
+
+		bool
+		farchive::remove(const Orl& orl, ItemType type)
+		{
+			auto path = relative_path(orl);
+			if (dir_fd_ < 0 || path == ".")
+				return false;
+
+			struct stat st;
+			if (::fstatat(dir_fd_, path.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0)
+				return false;
+
+			bool result = false;
+			if (type == ItemType::File && S_ISREG(st.st_mode))
+				result = ::unlinkat(dir_fd_, path.c_str(), 0) == 0;
+			else if (type == ItemType::Directory && S_ISDIR(st.st_mode))
+				result = remove_tree(dir_fd_, path.c_str());
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			this->invalidate(path, type == ItemType::Directory);
+
+			return result;
+		}
+
+		ItemType
+		farchive::exists(const Orl& orl)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			this->drain();
+			return this->lookup(relative_path(orl));
+		}
+
+		void
+		farchive::exists(const std::vector<Orl>& orls, std::vector<ItemType>& types)
+		{
+			types.resize(orls.size());
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			this->drain();
+
+			for (std::size_t i = 0; i < orls.size(); i++)
+				types[i] = this->lookup(relative_path(orls[i]));
+		}
+
+		ItemType
+		farchive::lookup(const std::string& path)
+		{
+			if (dir_fd_ < 0)
+				return ItemType::NA;
+
+			auto it = cache_.find(path);
+			if (it != cache_.end())
+				return it->second;
+
+			// The parent is watched before the item is tested, so a change racing the
+			// fstatat() is always seen by the next drain().
+			auto parent = parent_path(path);
+			bool cacheable = path != "." && this->watch(parent);
+
+			ItemType type = ItemType::NA;
+
+			struct stat st;
+			if (::fstatat(dir_fd_, path.c_str(), &st, 0) == 0)
+				type = item_type(st.st_mode);
+			else if (errno != ENOENT && errno != ENOTDIR)
+				return ItemType::NA;
+			else if (!cacheable && path != ".")
+			{
+				// A missing parent is cached in turn, its own parent watch covers this entry
+				// as invalidating a directory drops everything beneath it.
+				cacheable = this->lookup(parent) == ItemType::NA && cache_.count(parent) > 0;
+			}
+
+			if (cacheable)
+				cache_[path] = type;
+
+			return type;
+		}
+
+		bool
+		farchive::watch(const std::string& dir) noexcept
+		{
+			if (notify_fd_ < 0)
+				return false;
+
+			if (watched_.count(dir))
+				return true;
+
+			auto full_path = dir == "." ? base_dir_ : base_dir_ + '/' + dir;
+
+			int wd = ::inotify_add_watch(notify_fd_, full_path.c_str(), notify_mask);
+			if (wd < 0)
+				return false;
+
+			watches_[wd] = dir;
+			watched_[dir] = wd;
+
+			return true;
+		}
+
+		void
+		farchive::invalidate(const std::string& path, bool recursive) noexcept
+		{
+			auto it = cache_.find(path);
+			if (it != cache_.end())
+			{
+				recursive |= it->second != ItemType::File;
+				cache_.erase(it);
+			}
+
+			if (recursive)
+			{
+				for (auto entry = cache_.begin(); entry != cache_.end();)
+				{
+					auto& key = entry->first;
+					if (path == "." || (key.size() > path.size() && key[path.size()] == '/' && key.compare(0, path.size(), path) == 0))
+						entry = cache_.erase(entry);
+					else
+						++entry;
+				}
+			}
+		}
+
+		void
+		farchive::drain() noexcept
+		{
+			if (notify_fd_ < 0)
+				return;
+
+			alignas(struct inotify_event) char buffer[4096];
+
+			for (;;)
+			{
+				auto length = ::read(notify_fd_, buffer, sizeof(buffer));
+				if (length <= 0)
+					break;
+
+				for (char* ptr = buffer; ptr < buffer + length;)
+				{
+					auto event = reinterpret_cast<const struct inotify_event*>(ptr);
+					ptr += sizeof(struct inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW)
+					{
+						cache_.clear();
+						continue;
+					}
+
+					auto it = watches_.find(event->wd);
+					if (it == watches_.end())
+						continue;
+
+					auto dir = it->second;
+
+					if (event->len > 0)
+						this->invalidate(child_path(dir, event->name), (event->mask & IN_ISDIR) != 0);
+
+					if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+					{
+						this->invalidate(dir, true);
+
+						if (!(event->mask & IN_IGNORED))
+							::inotify_rm_watch(notify_fd_, event->wd);
+
+						watched_.erase(dir);
+						watches_.erase(it);
+					}
+				}
+			}
+		}
+#else
+		farchive::farchive(const char* base_dir) noexcept
+			: base_dir_(base_dir)
+		{
+		}
+
+		farchive::farchive(std::string&& base_dir) noexcept
+			: base_dir_(std::move(base_dir))
+		{
+		}
+
+		farchive::farchive(const std::string& base_dir) noexcept
+			: base_dir_(base_dir)
+		{
+		}
+
+		farchive::~farchive() noexcept
+		{
+		}
+
+		std::unique_ptr<stream_buf>
+		farchive::open(const Orl& orl, const ios_base::open_mode opts)
+		{
+			// Read-only opens are mapped when possible, non-regular or empty files use filebuf.
+			if (!(opts & ios_base::out))
+			{
+				auto map = std::make_unique<mapbuf>();
+				if (map->open(make_path(orl)))
+					return map;
+			}
+
 			auto file = std::make_unique<filebuf>();
 			auto file_path = make_path(orl);
 			auto parent = orl.parent();
@@ -64,15 +421,11 @@ namespace octoon
 				return file;
 			else
 				return nullptr;
-#else
-			return nullptr;
-#endif
 		}
 
 		bool
 		farchive::remove(const Orl& orl, ItemType type)
 		{
-#ifndef __linux
 			auto path = make_path(orl);
 			auto status = std::filesystem::status(path).type();
 			if (status == std::filesystem::file_type::not_found) {
@@ -87,15 +440,11 @@ namespace octoon
 				return std::filesystem::remove_all(path);
 			}
 			return false;
-#else
-			return false;
-#endif
 		}
 
 		ItemType
 		farchive::exists(const Orl& orl)
 		{
-#ifndef __linux
 			auto status = std::filesystem::status(make_path(orl));
 			switch (status.type())
 			{
@@ -106,11 +455,15 @@ namespace octoon
 			default:
 				return ItemType::NA;
 			}
-#else
-			return ItemType::NA;
-#endif
 		}
 
+		void
+		farchive::exists(const std::vector<Orl>& orls, std::vector<ItemType>& types)
+		{
+			archive::exists(orls, types);
+		}
+#endif
+
 		std::string
 		farchive::make_path(const Orl& orl) const
 		{
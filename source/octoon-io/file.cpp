@@ -3,6 +3,10 @@
 
 #include <limits>
 
+#if !defined(__WINDOWS__)
+#	include <unistd.h>
+#endif
+
 #ifndef _IOMYBUF
 #    define _IOMYBUF 0x0008
 #endif
@@ -510,6 +514,24 @@ namespace octoon
 			return fwrite(buf, size, stream_);
 		}
 
+		streamsize
+		File::read_at(streamoff pos, void* buf, streamsize size) noexcept
+		{
+			if (!stream_ || size <= 0 || pos < 0)
+				return 0;
+
+#if defined(__WINDOWS__)
+			streamoff off = this->tell();
+			fseek(stream_, pos, ios_base::beg);
+			streamsize count = fread(buf, size, stream_);
+			fseek(stream_, off, ios_base::beg);
+			return count;
+#else
+			auto count = ::pread(stream_->_file, buf, size, pos);
+			return count < 0 ? 0 : count;
+#endif
+		}
+
 		int
 		File::flag() noexcept
 		{
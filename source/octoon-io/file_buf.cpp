@@ -1,15 +1,26 @@
 #include <octoon/io/file_buf.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace octoon
 {
 	namespace io
 	{
 		filebuf::filebuf() noexcept
+			: _state(state::none)
+			, _readonly(false)
+			, _block_size(default_block_size)
+			, _base(0)
+			, _length(0)
+			, _cursor(0)
+			, _size(-1)
 		{
 		}
 
 		filebuf::~filebuf() noexcept
 		{
+			this->close();
 		}
 
 		bool
@@ -21,67 +32,357 @@ namespace octoon
 		bool
 		filebuf::open(const char* filename, ios_base::openmode mode) noexcept
 		{
-			return _file.open(filename, mode) ? true : false;
+			this->close();
+			this->on_open(_file.open(filename, mode) ? true : false, mode);
+			return _file.is_open();
 		}
 
 		bool
 		filebuf::open(const wchar_t* filename, ios_base::openmode mode) noexcept
 		{
-			return _file.open(filename, mode) ? true : false;
+			this->close();
+			this->on_open(_file.open(filename, mode) ? true : false, mode);
+			return _file.is_open();
 		}
 
 		bool
 		filebuf::open(const std::string& filename, ios_base::openmode mode) noexcept
 		{
-			return _file.open(filename, mode) ? true : false;
+			return this->open(filename.c_str(), mode);
 		}
 
 		bool
 		filebuf::open(const std::wstring& filename, ios_base::openmode mode) noexcept
 		{
-			return _file.open(filename, mode) ? true : false;
+			return this->open(filename.c_str(), mode);
+		}
+
+		void
+		filebuf::on_open(bool success, ios_base::openmode mode) noexcept
+		{
+			_state = state::none;
+			_base = 0;
+			_length = 0;
+			_cursor = 0;
+			_size = -1;
+			_readonly = success && !(mode & ios_base::out);
+
+			if (success && (mode & ios_base::app))
+				_base = _file.seek(0, ios_base::end);
+		}
+
+		void
+		filebuf::set_block_size(std::size_t size) noexcept
+		{
+			this->flush_write();
+			this->discard_read();
+
+			_block_size = size;
+			_buffer.clear();
+			_buffer.shrink_to_fit();
+		}
+
+		std::size_t
+		filebuf::get_block_size() const noexcept
+		{
+			return _block_size;
+		}
+
+		bool
+		filebuf::flush_write() noexcept
+		{
+			if (_state != state::writing)
+				return true;
+
+			std::size_t written = _length > 0 ? _file.write(_buffer.data(), _length) : 0;
+			bool success = written == _length;
+
+			_base += written;
+			_length = 0;
+			_cursor = 0;
+			_state = state::none;
+
+			return success;
+		}
+
+		void
+		filebuf::discard_read() noexcept
+		{
+			if (_state != state::reading)
+				return;
+
+			// The descriptor is ahead of the logical position by the unread part of the block.
+			if (_cursor != _length)
+				_file.seek(_base + _cursor, ios_base::beg);
+
+			_base += _cursor;
+			_length = 0;
+			_cursor = 0;
+			_state = state::none;
 		}
 
 		streamsize
 		filebuf::read(char* str, std::streamsize cnt) noexcept
 		{
-			return _file.read(str, cnt);
+			if (!_file.is_open() || cnt <= 0)
+				return 0;
+
+			if (!this->flush_write())
+				return 0;
+
+			if (_block_size == 0)
+			{
+				auto count = _file.read(str, cnt);
+				_base += std::max<streamsize>(count, 0);
+				return count;
+			}
+
+			_state = state::reading;
+
+			streamsize total = 0;
+
+			while (cnt > 0)
+			{
+				std::size_t avail = _length - _cursor;
+				if (avail > 0)
+				{
+					std::size_t count = std::min<std::size_t>(avail, (std::size_t)cnt);
+					std::memcpy(str, _buffer.data() + _cursor, count);
+
+					_cursor += count;
+					str += count;
+					cnt -= count;
+					total += count;
+					continue;
+				}
+
+				_base += _length;
+				_length = 0;
+				_cursor = 0;
+
+				// Large requests bypass the buffer instead of being copied twice.
+				if ((std::size_t)cnt >= _block_size)
+				{
+					auto count = _file.read(str, cnt);
+					if (count > 0)
+					{
+						_base += count;
+						total += count;
+					}
+
+					break;
+				}
+
+				if (_buffer.size() < _block_size)
+					_buffer.resize(_block_size);
+
+				auto count = _file.read(_buffer.data(), _block_size);
+				if (count <= 0)
+					break;
+
+				_length = count;
+			}
+
+			return total;
 		}
 
 		streamsize
 		filebuf::write(const char* str, std::streamsize cnt) noexcept
 		{
-			return _file.write(str, cnt);
+			if (!_file.is_open() || cnt <= 0)
+				return 0;
+
+			this->discard_read();
+
+			_size = -1;
+
+			if (_block_size == 0 || (std::size_t)cnt >= _block_size)
+			{
+				if (!this->flush_write())
+					return 0;
+
+				auto count = _file.write(str, cnt);
+				_base += std::max<streamsize>(count, 0);
+				return count;
+			}
+
+			if (_length + cnt > _block_size)
+			{
+				if (!this->flush_write())
+					return 0;
+			}
+
+			if (_buffer.size() < _block_size)
+				_buffer.resize(_block_size);
+
+			std::memcpy(_buffer.data() + _length, str, cnt);
+
+			_length += cnt;
+			_state = state::writing;
+
+			return cnt;
 		}
 
 		streamoff
 		filebuf::seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept
 		{
-			return _file.seek(pos, dir);
+			if (!_file.is_open())
+				return ios_base::_BADOFF;
+
+			streamoff target;
+			switch (dir)
+			{
+			case ios_base::beg:
+				target = pos;
+				break;
+			case ios_base::cur:
+				target = this->tellg() + pos;
+				break;
+			case ios_base::end:
+				if (!this->flush_write())
+					return ios_base::_BADOFF;
+				target = this->size() + pos;
+				break;
+			default:
+				return ios_base::_BADOFF;
+			}
+
+			if (target < 0)
+				return ios_base::_BADOFF;
+
+			if (_state == state::reading && target >= _base && target <= _base + (streamoff)_length)
+			{
+				_cursor = static_cast<std::size_t>(target - _base);
+				return target;
+			}
+
+			if (!this->flush_write())
+				return ios_base::_BADOFF;
+
+			_state = state::none;
+			_length = 0;
+			_cursor = 0;
+
+			_base = _file.seek(target, ios_base::beg);
+			return _base;
 		}
 
 		streamoff
 		filebuf::tellg() noexcept
 		{
-			return _file.tell();
+			if (!_file.is_open())
+				return ios_base::_BADOFF;
+
+			if (_state == state::writing)
+				return _base + _length;
+
+			return _base + _cursor;
 		}
 
 		streamsize
 		filebuf::size() const noexcept
 		{
-			return _file.size();
+			if (!_file.is_open())
+				return 0;
+
+			// The size of a read-only file can't change through us, so it is queried once.
+			if (_readonly && _size >= 0)
+				return _size;
+
+			streamsize size = _file.size();
+			if (_state == state::writing)
+				size = std::max<streamsize>(size, _base + _length);
+
+			if (_readonly)
+				_size = size;
+
+			return size;
+		}
+
+		const char*
+		filebuf::peek(std::streamsize cnt) noexcept
+		{
+			if (!_file.is_open() || cnt < 0 || (std::size_t)cnt > _block_size)
+				return nullptr;
+
+			if (!this->flush_write())
+				return nullptr;
+
+			if (_state != state::reading)
+			{
+				_state = state::reading;
+				_length = 0;
+				_cursor = 0;
+			}
+
+			std::size_t avail = _length - _cursor;
+			if (avail < (std::size_t)cnt)
+			{
+				if (_buffer.size() < _block_size)
+					_buffer.resize(_block_size);
+
+				// Move the unread tail to the front and fill the rest of the block behind it.
+				std::memmove(_buffer.data(), _buffer.data() + _cursor, avail);
+
+				_base += _cursor;
+				_length = avail;
+				_cursor = 0;
+
+				while (_length < (std::size_t)cnt)
+				{
+					auto count = _file.read(_buffer.data() + _length, _block_size - _length);
+					if (count <= 0)
+						return nullptr;
+					_length += count;
+				}
+			}
+
+			return _buffer.data() + _cursor;
+		}
+
+		const char*
+		filebuf::view(std::streamsize cnt) noexcept
+		{
+			auto data = this->peek(cnt);
+			if (data)
+				_cursor += cnt;
+			return data;
+		}
+
+		streamsize
+		filebuf::read_at(streamoff pos, char* str, std::streamsize cnt) noexcept
+		{
+			if (!_file.is_open() || cnt <= 0)
+				return 0;
+
+			// Writable files may have bytes waiting in the block, only read-only files skip the cursor.
+			if (!_readonly)
+				return stream_buf::read_at(pos, str, cnt);
+
+			return _file.read_at(pos, str, cnt);
 		}
 
 		int
 		filebuf::flush() noexcept
 		{
-			return 0;
+			return this->flush_write() ? 0 : -1;
 		}
 
 		bool
 		filebuf::close() noexcept
 		{
+			if (!_file.is_open())
+				return false;
+
+			this->flush_write();
+
+			_state = state::none;
+			_length = 0;
+			_cursor = 0;
+			_base = 0;
+			_size = -1;
+
 			return _file.close();
 		}
 	}
-}
\ No newline at end of file
+}
@@ -13,35 +13,88 @@ namespace octoon
 		void
 		IoServer::mount_archive(const std::string& vpath, const archive_pointer& vdir)
 		{
-			registry_.insert(std::make_pair(vpath, vdir));
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				registry_.insert(std::make_pair(vpath, vdir));
+			}
+
+			this->notify(vpath);
 		}
 
 		void
 		IoServer::mount_archive(const std::string& vpath, archive_pointer&& vdir)
 		{
-			registry_.insert(std::make_pair(vpath, std::move(vdir)));
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				registry_.insert(std::make_pair(vpath, std::move(vdir)));
+			}
+
+			this->notify(vpath);
 		}
 
 		void
 		IoServer::mount_archive(std::string&& vpath, archive_pointer&& vdir)
 		{
-			registry_.insert(std::make_pair(std::move(vpath), std::move(vdir)));
+			auto name = vpath;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				registry_.insert(std::make_pair(std::move(vpath), std::move(vdir)));
+			}
+
+			this->notify(name);
 		}
 
 		archive_pointer
 		IoServer::unmount_archive(const std::string& vdir)
 		{
-			auto it = registry_.find(vdir);
-			auto ptr = std::move(it->second);
-			registry_.erase(it);
+			archive_pointer ptr;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+
+				auto it = registry_.find(vdir);
+				if (it == registry_.end())
+					return nullptr;
+
+				ptr = std::move(it->second);
+				registry_.erase(it);
+			}
+
+			this->notify(vdir);
 			return ptr;
 		}
 
 		archive_pointer
 		IoServer::get_archive(const Orl& orl) const
 		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
 			auto it = registry_.find(orl.virtual_dir());
 			return it != registry_.end() ?  it->second : nullptr;
 		}
+
+		std::size_t
+		IoServer::add_listener(listener&& callback)
+		{
+			std::lock_guard<std::mutex> lock(listener_mutex_);
+			listeners_.emplace(++listener_id_, std::move(callback));
+			return listener_id_;
+		}
+
+		void
+		IoServer::remove_listener(std::size_t id)
+		{
+			std::lock_guard<std::mutex> lock(listener_mutex_);
+			listeners_.erase(id);
+		}
+
+		void
+		IoServer::notify(const std::string& vpath)
+		{
+			std::lock_guard<std::mutex> lock(listener_mutex_);
+			for (auto& it : listeners_)
+				it.second(vpath);
+		}
 	}
 }
\ No newline at end of file
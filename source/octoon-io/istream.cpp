@@ -69,6 +69,30 @@ namespace octoon
 			return this->read(str, size * cnt);
 		}
 
+		const char*
+		istream::peek(std::streamsize cnt) noexcept
+		{
+			const isentry ok(this);
+			if (ok && !this->fail())
+				return this->rdbuf()->peek(cnt);
+
+			return nullptr;
+		}
+
+		const char*
+		istream::view(std::streamsize cnt) noexcept
+		{
+			const isentry ok(this);
+			if (ok && !this->fail())
+			{
+				auto data = this->rdbuf()->view(cnt);
+				_count = data ? cnt : 0;
+				return data;
+			}
+
+			return nullptr;
+		}
+
 		istream&
 		istream::flush() noexcept
 		{
@@ -90,7 +114,7 @@ namespace octoon
 			const isentry ok(this);
 			if (ok)
 			{
-				if (!this->fail() && (ios_base::off_type)this->rdbuf()->seekg(pos, ios_base::out) == ios_base::_BADOFF)
+				if (!this->fail() && (ios_base::off_type)this->rdbuf()->seekg(pos, ios_base::beg) == ios_base::_BADOFF)
 					this->setstate(ios_base::failbit);
 			}
 
@@ -1,9 +1,667 @@
 #include <octoon/io/json_reader.h>
+#include <octoon/runtime/except.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
 
 namespace octoon
 {
     namespace io
     {
+        namespace
+        {
+            constexpr std::size_t CHUNK_SIZE = 64 << 10;
+            constexpr std::size_t NUMBER_WINDOW = 1024;
+            constexpr std::size_t FLOAT3_BATCH = 4096;
+
+            const double POW10[] =
+            {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
+            inline std::uint32_t countTrailingZeros(std::uint32_t mask) noexcept
+            {
+#if defined(_MSC_VER)
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                return index;
+#else
+                return __builtin_ctz(mask);
+#endif
+            }
+
+            // Length of the run of decimal digits at str, 16 bytes at a time when they are there.
+            inline std::size_t countDigits(const char* str, const char* end) noexcept
+            {
+                auto it = str;
+
+#if defined(__SSE2__)
+                const __m128i zero = _mm_set1_epi8('0');
+                const __m128i bias = _mm_set1_epi8(char(0x80));
+                const __m128i limit = _mm_set1_epi8(char(10 ^ 0x80));
+
+                for (; end - it >= 16; it += 16)
+                {
+                    // (c - '0') < 10 as unsigned bytes, by flipping the sign bits for a signed compare.
+                    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+                    __m128i digits = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(chunk, zero), bias), limit);
+
+                    auto mask = ~static_cast<std::uint32_t>(_mm_movemask_epi8(digits)) & 0xFFFF;
+                    if (mask)
+                        return it - str + countTrailingZeros(mask);
+                }
+#endif
+
+                while (it < end && static_cast<unsigned char>(*it - '0') < 10)
+                    it++;
+
+                return it - str;
+            }
+
+            // Eight ASCII digits into their value with three multiplications, little endian only.
+            inline std::uint64_t parseEightDigits(const char* str) noexcept
+            {
+                std::uint64_t value;
+                std::memcpy(&value, str, sizeof(value));
+                value = (value & 0x0F0F0F0F0F0F0F0F) * 2561 >> 8;
+                value = (value & 0x00FF00FF00FF00FF) * 6553601 >> 16;
+                return (value & 0x0000FFFF0000FFFF) * 42949672960001 >> 32;
+            }
+
+            inline bool isLittleEndian() noexcept
+            {
+                const std::uint16_t value = 1;
+                return *reinterpret_cast<const std::uint8_t*>(&value) == 1;
+            }
+
+            class JsonSaxParser
+            {
+            public:
+                JsonSaxParser(istream& stream)
+                    : stream_(&stream)
+                    , buffer_(CHUNK_SIZE)
+                    , base_(buffer_.data())
+                    , cur_(buffer_.data())
+                    , end_(buffer_.data())
+                    , consumed_(0)
+                    , eof_(false)
+                {
+                }
+
+                JsonSaxParser(const char* data, std::size_t length)
+                    : stream_(nullptr)
+                    , base_(data)
+                    , cur_(data)
+                    , end_(data + length)
+                    , consumed_(0)
+                    , eof_(true)
+                {
+                }
+
+                bool parse(JsonHandler& handler)
+                {
+                    enum class State
+                    {
+                        Value,
+                        Key,
+                        Next
+                    };
+
+                    // Containers are kept on an explicit stack, nesting depth doesn't touch the call stack.
+                    std::vector<char> stack;
+                    auto state = State::Value;
+
+                    for (;;)
+                    {
+                        switch (state)
+                        {
+                        case State::Value:
+                        {
+                            auto c = this->peekToken();
+                            if (c == '{')
+                            {
+                                cur_++;
+                                if (!handler.onStartObject())
+                                    return false;
+
+                                if (this->peekToken() == '}')
+                                {
+                                    cur_++;
+                                    if (!handler.onEndObject())
+                                        return false;
+                                    state = State::Next;
+                                }
+                                else
+                                {
+                                    stack.push_back('{');
+                                    state = State::Key;
+                                }
+                            }
+                            else if (c == '[')
+                            {
+                                cur_++;
+                                if (!handler.onStartArray())
+                                    return false;
+
+                                if (handler.wantFloat3Array())
+                                {
+                                    if (!this->parseFloat3Array(handler) || !handler.onEndArray())
+                                        return false;
+                                    state = State::Next;
+                                }
+                                else if (this->peekToken() == ']')
+                                {
+                                    cur_++;
+                                    if (!handler.onEndArray())
+                                        return false;
+                                    state = State::Next;
+                                }
+                                else
+                                {
+                                    stack.push_back('[');
+                                }
+                            }
+                            else
+                            {
+                                if (!this->parseScalar(handler))
+                                    return false;
+                                state = State::Next;
+                            }
+                        }
+                        break;
+                        case State::Key:
+                        {
+                            if (this->peekToken() != '"')
+                                this->error("expected a key");
+
+                            cur_++;
+
+                            const char* key;
+                            auto length = this->parseString(key);
+                            if (!handler.onKey(key, length))
+                                return false;
+
+                            this->expect(':');
+                            state = State::Value;
+                        }
+                        break;
+                        case State::Next:
+                        {
+                            if (stack.empty())
+                            {
+                                if (this->peekToken() != 0)
+                                    this->error("unexpected trailing characters");
+                                return true;
+                            }
+
+                            auto c = this->peekToken();
+                            cur_++;
+
+                            if (c == ',')
+                            {
+                                state = stack.back() == '{' ? State::Key : State::Value;
+                            }
+                            else if (c == '}' && stack.back() == '{')
+                            {
+                                stack.pop_back();
+                                if (!handler.onEndObject())
+                                    return false;
+                            }
+                            else if (c == ']' && stack.back() == '[')
+                            {
+                                stack.pop_back();
+                                if (!handler.onEndArray())
+                                    return false;
+                            }
+                            else
+                            {
+                                cur_--;
+                                this->error(stack.back() == '{' ? "expected ',' or '}'" : "expected ',' or ']'");
+                            }
+                        }
+                        break;
+                        }
+                    }
+                }
+
+            private:
+                // Makes sure that at least count bytes are buffered unless the input ends first.
+                std::size_t fill(std::size_t count)
+                {
+                    auto available = static_cast<std::size_t>(end_ - cur_);
+                    if (available >= count || eof_)
+                        return available;
+
+                    consumed_ += cur_ - base_;
+                    std::memmove(buffer_.data(), cur_, available);
+
+                    // Only a number longer than a chunk asks for more than the buffer holds.
+                    if (count > buffer_.size())
+                        buffer_.resize(std::max(count, buffer_.size() * 2));
+
+                    auto data = buffer_.data();
+
+                    base_ = data;
+                    cur_ = data;
+                    end_ = data + available;
+
+                    while (!eof_ && end_ < data + buffer_.size())
+                    {
+                        stream_->read(const_cast<char*>(end_), data + buffer_.size() - end_);
+
+                        auto length = stream_->gcount();
+                        if (length <= 0)
+                            eof_ = true;
+                        else
+                            end_ += length;
+                    }
+
+                    return end_ - cur_;
+                }
+
+                // Skips whitespace and returns the next character without consuming it, zero at the end.
+                char peekToken()
+                {
+                    for (;;)
+                    {
+                        while (cur_ < end_)
+                        {
+                            auto c = *cur_;
+                            if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+                                return c;
+                            cur_++;
+                        }
+
+                        if (!this->fill(1))
+                            return 0;
+                    }
+                }
+
+                void expect(char c)
+                {
+                    if (this->peekToken() != c)
+                        this->error(std::string("expected '") + c + "'");
+                    cur_++;
+                }
+
+                bool consume(const char* literal)
+                {
+                    auto length = std::strlen(literal);
+                    if (this->fill(length) < length || std::memcmp(cur_, literal, length) != 0)
+                        return false;
+
+                    cur_ += length;
+                    return true;
+                }
+
+                bool parseScalar(JsonHandler& handler)
+                {
+                    switch (this->peekToken())
+                    {
+                    case '"':
+                    {
+                        cur_++;
+
+                        const char* value;
+                        auto length = this->parseString(value);
+                        return handler.onString(value, length);
+                    }
+                    case 't':
+                        if (!this->consume("true"))
+                            this->error("invalid literal");
+                        return handler.onBoolean(true);
+                    case 'f':
+                        if (!this->consume("false"))
+                            this->error("invalid literal");
+                        return handler.onBoolean(false);
+                    case 'n':
+                        if (!this->consume("null"))
+                            this->error("invalid literal");
+                        return handler.onNull();
+                    case 0:
+                        this->error("unexpected end of input");
+                    default:
+                        return handler.onNumber(this->parseNumber());
+                    }
+                }
+
+                // Returns the length, the characters stay valid until the next call into the parser.
+                std::size_t parseString(const char*& value)
+                {
+                    // Strings without escapes that are fully buffered are handed out in place.
+                    for (auto it = cur_; it < end_; it++)
+                    {
+                        if (*it == '"')
+                        {
+                            value = cur_;
+                            cur_ = it + 1;
+                            return it - value;
+                        }
+
+                        if (*it == '\\' || static_cast<unsigned char>(*it) < 0x20)
+                            break;
+                    }
+
+                    string_.clear();
+
+                    for (;;)
+                    {
+                        if (cur_ == end_ && !this->fill(1))
+                            this->error("unterminated string");
+
+                        auto c = *cur_++;
+                        if (c == '"')
+                        {
+                            value = string_.data();
+                            return string_.size();
+                        }
+
+                        if (static_cast<unsigned char>(c) < 0x20)
+                            this->error("control character in string");
+
+                        if (c != '\\')
+                        {
+                            string_.push_back(c);
+                            continue;
+                        }
+
+                        if (!this->fill(1))
+                            this->error("unterminated string");
+
+                        switch (c = *cur_++)
+                        {
+                        case '"': string_.push_back('"'); break;
+                        case '\\': string_.push_back('\\'); break;
+                        case '/': string_.push_back('/'); break;
+                        case 'b': string_.push_back('\b'); break;
+                        case 'f': string_.push_back('\f'); break;
+                        case 'n': string_.push_back('\n'); break;
+                        case 'r': string_.push_back('\r'); break;
+                        case 't': string_.push_back('\t'); break;
+                        case 'u': this->parseUnicode(); break;
+                        default:
+                            this->error("invalid escape");
+                        }
+                    }
+                }
+
+                std::uint32_t parseHex4()
+                {
+                    if (this->fill(4) < 4)
+                        this->error("invalid unicode escape");
+
+                    std::uint32_t value = 0;
+                    for (int i = 0; i < 4; i++)
+                    {
+                        auto c = *cur_++;
+                        value <<= 4;
+
+                        if (c >= '0' && c <= '9')
+                            value |= c - '0';
+                        else if (c >= 'a' && c <= 'f')
+                            value |= c - 'a' + 10;
+                        else if (c >= 'A' && c <= 'F')
+                            value |= c - 'A' + 10;
+                        else
+                            this->error("invalid unicode escape");
+                    }
+
+                    return value;
+                }
+
+                void parseUnicode()
+                {
+                    auto code = this->parseHex4();
+
+                    if (code >= 0xD800 && code <= 0xDBFF)
+                    {
+                        if (!this->consume("\\u"))
+                            this->error("unpaired surrogate");
+
+                        auto low = this->parseHex4();
+                        if (low < 0xDC00 || low > 0xDFFF)
+                            this->error("unpaired surrogate");
+
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+
+                    if (code < 0x80)
+                    {
+                        string_.push_back(static_cast<char>(code));
+                    }
+                    else if (code < 0x800)
+                    {
+                        string_.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                        string_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    else if (code < 0x10000)
+                    {
+                        string_.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                        string_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        string_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    else
+                    {
+                        string_.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                        string_.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                        string_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        string_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                }
+
+                double parseNumber()
+                {
+                    this->fill(NUMBER_WINDOW);
+
+                    auto begin = cur_;
+                    auto it = cur_;
+
+                    bool negative = it < end_ && *it == '-';
+                    if (negative)
+                        it++;
+
+                    std::uint64_t mantissa = 0;
+                    std::int32_t exponent = 0;
+                    std::size_t significant = 0;
+
+                    auto accumulate = [&](const char* digits, std::size_t count)
+                    {
+                        // Leading zeros aren't significant, nineteen digits always fit into 64 bits.
+                        while (count && significant == 0 && *digits == '0')
+                        {
+                            digits++;
+                            count--;
+                        }
+
+                        auto used = std::min<std::size_t>(count, significant < 19 ? 19 - significant : 0);
+                        auto i = std::size_t(0);
+
+                        if (isLittleEndian())
+                        {
+                            for (; i + 8 <= used; i += 8)
+                                mantissa = mantissa * 100000000 + parseEightDigits(digits + i);
+                        }
+
+                        for (; i < used; i++)
+                            mantissa = mantissa * 10 + (digits[i] - '0');
+
+                        significant += count;
+                        return static_cast<std::int32_t>(count - used);
+                    };
+
+                    // Running into the end of the window isn't an error yet, the number is parsed
+                    // again from a larger one below.
+                    auto windowEnd = [&]() { return it == end_ && !eof_; };
+
+                    auto integer = countDigits(it, end_);
+                    if ((integer == 0 && !windowEnd()) || (integer > 1 && *it == '0'))
+                        this->error("invalid number");
+
+                    exponent += accumulate(it, integer);
+                    it += integer;
+
+                    if (it < end_ && *it == '.')
+                    {
+                        it++;
+
+                        auto fraction = countDigits(it, end_);
+                        if (fraction == 0 && !windowEnd())
+                            this->error("invalid number");
+
+                        auto dropped = accumulate(it, fraction);
+                        exponent -= static_cast<std::int32_t>(fraction) - dropped;
+                        it += fraction;
+                    }
+
+                    if (it < end_ && (*it == 'e' || *it == 'E'))
+                    {
+                        it++;
+
+                        bool negativeExponent = false;
+                        if (it < end_ && (*it == '+' || *it == '-'))
+                            negativeExponent = *it++ == '-';
+
+                        auto digits = countDigits(it, end_);
+                        if (digits == 0 && !windowEnd())
+                            this->error("invalid number");
+
+                        std::int32_t value = 0;
+                        for (std::size_t i = 0; i < digits && value < 100000; i++)
+                            value = value * 10 + (it[i] - '0');
+
+                        exponent += negativeExponent ? -value : value;
+                        it += digits;
+                    }
+
+                    if (windowEnd())
+                    {
+                        this->fill((end_ - cur_) * 2);
+                        return this->parseNumber();
+                    }
+
+                    cur_ = it;
+
+                    // Exact when both the mantissa and the power of ten are representable,
+                    // everything else goes through the C library.
+                    double value;
+                    if (significant <= 19 && mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22)
+                    {
+                        value = static_cast<double>(mantissa);
+                        value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+                    }
+                    else
+                    {
+                        std::string token(begin, it);
+                        value = std::strtod(token.c_str(), nullptr);
+                        return value;
+                    }
+
+                    return negative ? -value : value;
+                }
+
+                bool parseFloat3Array(JsonHandler& handler)
+                {
+                    float3s_.clear();
+
+                    if (this->peekToken() == ']')
+                    {
+                        cur_++;
+                        return true;
+                    }
+
+                    for (;;)
+                    {
+                        this->expect('[');
+
+                        math::float3 value(0.0f, 0.0f, 0.0f);
+
+                        for (std::size_t i = 0;; i++)
+                        {
+                            if (i == 3)
+                                this->error("expected an array of two or three numbers");
+
+                            this->peekToken();
+                            value[i] = static_cast<float>(this->parseNumber());
+
+                            auto c = this->peekToken();
+                            cur_++;
+
+                            if (c == ']')
+                            {
+                                if (i == 0)
+                                    this->error("expected an array of two or three numbers");
+                                break;
+                            }
+
+                            if (c != ',')
+                            {
+                                cur_--;
+                                this->error("expected ',' or ']'");
+                            }
+                        }
+
+                        float3s_.push_back(value);
+
+                        if (float3s_.size() == FLOAT3_BATCH)
+                        {
+                            if (!handler.onFloat3Array(float3s_.data(), float3s_.size()))
+                                return false;
+                            float3s_.clear();
+                        }
+
+                        auto c = this->peekToken();
+                        cur_++;
+
+                        if (c == ']')
+                            break;
+
+                        if (c != ',')
+                        {
+                            cur_--;
+                            this->error("expected ',' or ']'");
+                        }
+                    }
+
+                    if (!float3s_.empty())
+                        return handler.onFloat3Array(float3s_.data(), float3s_.size());
+
+                    return true;
+                }
+
+                [[noreturn]] void error(const std::string& message)
+                {
+                    auto offset = consumed_ + (cur_ - base_);
+                    throw runtime::runtime_error::create("json: " + message + " at offset " + std::to_string(offset));
+                }
+
+            private:
+                istream* stream_;
+                std::vector<char> buffer_;
+
+                const char* base_;
+                const char* cur_;
+                const char* end_;
+
+                std::uint64_t consumed_;
+                bool eof_;
+
+                std::string string_;
+                std::vector<math::float3> float3s_;
+            };
+        }
+
         JsonReader::JsonReader(istream &stream) noexcept
             :StreamReader(stream)
         {
@@ -12,9 +670,33 @@ namespace octoon
         JsonReader::JsonObject
         JsonReader::readJson() except
         {
+            // Parse straight out of the stream buffer when it can expose the remaining bytes.
+            auto offset = base_stream.tellg();
+            auto length = base_stream.size() - offset;
+            if (offset >= 0 && length > 0)
+            {
+                auto view = base_stream.view(length);
+                if (view)
+                    return nlohmann::json::parse(view, view + length);
+            }
+
             std::string data = this->readToEnd();
             JsonObject json = nlohmann::json::parse(data.begin(), data.end());
             return json;
         }
+
+        bool
+        JsonReader::parse(JsonHandler& handler) except
+        {
+            JsonSaxParser parser(base_stream);
+            return parser.parse(handler);
+        }
+
+        bool
+        JsonReader::parse(const char* data, std::size_t length, JsonHandler& handler) except
+        {
+            JsonSaxParser parser(data, length);
+            return parser.parse(handler);
+        }
     }
-}
\ No newline at end of file
+}
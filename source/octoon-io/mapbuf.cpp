@@ -0,0 +1,329 @@
+#include <octoon/io/mapbuf.h>
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__WINDOWS__)
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+namespace octoon
+{
+	namespace io
+	{
+		mapbuf::mapbuf() noexcept
+			: data_(nullptr)
+			, size_(0)
+			, pos_(0)
+#if defined(__WINDOWS__)
+			, mapping_(nullptr)
+#endif
+		{
+		}
+
+		mapbuf::~mapbuf() noexcept
+		{
+			this->close();
+		}
+
+		bool
+		mapbuf::is_open() const noexcept
+		{
+			return data_ != nullptr;
+		}
+
+#if defined(__WINDOWS__)
+		bool
+		mapbuf::map(void* handle, advice hint) noexcept
+		{
+			if (handle == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER size;
+			if (::GetFileType(handle) != FILE_TYPE_DISK || !::GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+			{
+				::CloseHandle(handle);
+				return false;
+			}
+
+			mapping_ = ::CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			::CloseHandle(handle);
+
+			if (!mapping_)
+				return false;
+
+			data_ = (const char*)::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+			if (!data_)
+			{
+				::CloseHandle(mapping_);
+				mapping_ = nullptr;
+				return false;
+			}
+
+			size_ = static_cast<std::size_t>(size.QuadPart);
+			pos_ = 0;
+
+			this->advise(hint);
+			return true;
+		}
+
+		bool
+		mapbuf::open(const char* filename, advice hint) noexcept
+		{
+			this->close();
+
+			DWORD flags = hint == advice::sequential ? FILE_FLAG_SEQUENTIAL_SCAN : hint == advice::random ? FILE_FLAG_RANDOM_ACCESS : 0;
+			return this->map(::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr), hint);
+		}
+
+		bool
+		mapbuf::open(const wchar_t* filename, advice hint) noexcept
+		{
+			this->close();
+
+			DWORD flags = hint == advice::sequential ? FILE_FLAG_SEQUENTIAL_SCAN : hint == advice::random ? FILE_FLAG_RANDOM_ACCESS : 0;
+			return this->map(::CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr), hint);
+		}
+
+		void
+		mapbuf::advise(advice hint) noexcept
+		{
+			// Windows only takes access hints when the file is opened, willneed maps to a prefetch.
+#if _WIN32_WINNT >= 0x0602
+			if (data_ && hint == advice::willneed)
+			{
+				WIN32_MEMORY_RANGE_ENTRY range;
+				range.VirtualAddress = (PVOID)data_;
+				range.NumberOfBytes = size_;
+				::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+			}
+#endif
+		}
+
+		bool
+		mapbuf::close() noexcept
+		{
+			if (!data_)
+				return false;
+
+			::UnmapViewOfFile(data_);
+			::CloseHandle(mapping_);
+
+			data_ = nullptr;
+			mapping_ = nullptr;
+			size_ = 0;
+			pos_ = 0;
+
+			return true;
+		}
+#else
+		bool
+		mapbuf::map(void* handle, advice hint) noexcept
+		{
+			int fd = static_cast<int>(reinterpret_cast<std::intptr_t>(handle));
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+			if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+			{
+				::close(fd);
+				return false;
+			}
+
+			void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+
+			if (data == MAP_FAILED)
+				return false;
+
+			data_ = (const char*)data;
+			size_ = static_cast<std::size_t>(st.st_size);
+			pos_ = 0;
+
+			this->advise(hint);
+			return true;
+		}
+
+		bool
+		mapbuf::open(const char* filename, advice hint) noexcept
+		{
+			this->close();
+
+			int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+			return this->map(reinterpret_cast<void*>(static_cast<std::intptr_t>(fd)), hint);
+		}
+
+		bool
+		mapbuf::open(int dirfd, const char* filename, advice hint) noexcept
+		{
+			this->close();
+
+			int fd = ::openat(dirfd, filename, O_RDONLY | O_CLOEXEC);
+			return this->map(reinterpret_cast<void*>(static_cast<std::intptr_t>(fd)), hint);
+		}
+
+		bool
+		mapbuf::open(const wchar_t* filename, advice hint) noexcept
+		{
+			std::size_t length = std::wcstombs(nullptr, filename, 0);
+			if (length == static_cast<std::size_t>(-1))
+				return false;
+
+			std::string path(length, '\0');
+			std::wcstombs(&path[0], filename, length);
+
+			return this->open(path.c_str(), hint);
+		}
+
+		void
+		mapbuf::advise(advice hint) noexcept
+		{
+			if (!data_)
+				return;
+
+			int flags = MADV_NORMAL;
+			switch (hint)
+			{
+			case advice::sequential: flags = MADV_SEQUENTIAL; break;
+			case advice::random: flags = MADV_RANDOM; break;
+			case advice::willneed: flags = MADV_WILLNEED; break;
+			default:
+				break;
+			}
+
+			::madvise((void*)data_, size_, flags);
+		}
+
+		bool
+		mapbuf::close() noexcept
+		{
+			if (!data_)
+				return false;
+
+			::munmap((void*)data_, size_);
+
+			data_ = nullptr;
+			size_ = 0;
+			pos_ = 0;
+
+			return true;
+		}
+#endif
+
+		bool
+		mapbuf::open(const std::string& filename, advice hint) noexcept
+		{
+			return this->open(filename.c_str(), hint);
+		}
+
+		bool
+		mapbuf::open(const std::wstring& filename, advice hint) noexcept
+		{
+			return this->open(filename.c_str(), hint);
+		}
+
+		const char*
+		mapbuf::data() const noexcept
+		{
+			return data_;
+		}
+
+		streamsize
+		mapbuf::read(char* str, std::streamsize cnt) noexcept
+		{
+			if (!data_ || cnt <= 0)
+				return 0;
+
+			std::size_t count = std::min<std::size_t>(cnt, size_ - pos_);
+			std::memcpy(str, data_ + pos_, count);
+			pos_ += count;
+
+			return count;
+		}
+
+		streamsize
+		mapbuf::read_at(streamoff pos, char* str, std::streamsize cnt) noexcept
+		{
+			if (!data_ || cnt <= 0 || pos < 0 || (std::size_t)pos >= size_)
+				return 0;
+
+			std::size_t count = std::min<std::size_t>(cnt, size_ - pos);
+			std::memcpy(str, data_ + pos, count);
+
+			return count;
+		}
+
+		streamsize
+		mapbuf::write(const char*, std::streamsize) noexcept
+		{
+			return 0;
+		}
+
+		streamoff
+		mapbuf::seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept
+		{
+			streamoff target;
+			switch (dir)
+			{
+			case ios_base::beg:
+				target = pos;
+				break;
+			case ios_base::cur:
+				target = pos_ + pos;
+				break;
+			case ios_base::end:
+				target = size_ + pos;
+				break;
+			default:
+				return ios_base::_BADOFF;
+			}
+
+			if (target < 0 || target > (streamoff)size_)
+				return ios_base::_BADOFF;
+
+			pos_ = static_cast<std::size_t>(target);
+			return target;
+		}
+
+		streamoff
+		mapbuf::tellg() noexcept
+		{
+			return data_ ? (streamoff)pos_ : ios_base::_BADOFF;
+		}
+
+		streamsize
+		mapbuf::size() const noexcept
+		{
+			return size_;
+		}
+
+		const char*
+		mapbuf::peek(std::streamsize cnt) noexcept
+		{
+			if (!data_ || cnt < 0 || size_ - pos_ < (std::size_t)cnt)
+				return nullptr;
+			return data_ + pos_;
+		}
+
+		const char*
+		mapbuf::view(std::streamsize cnt) noexcept
+		{
+			auto data = this->peek(cnt);
+			if (data)
+				pos_ += cnt;
+			return data;
+		}
+
+		int
+		mapbuf::flush() noexcept
+		{
+			return 0;
+		}
+	}
+}
@@ -1,5 +1,6 @@
 #include <octoon/io/membuf.h>
 #include <cstring>
+#include <algorithm>
 
 namespace octoon
 {
@@ -47,77 +48,78 @@ namespace octoon
 		void
 		membuf::open(std::vector<std::uint8_t>&& buffer) noexcept
 		{
-			buffer_ = std::move(buffer_);
+			buffer_ = std::move(buffer);
+			pos_ = 0;
 		}
 
 		void
 		membuf::open(const std::vector<std::uint8_t>& buffer) noexcept
 		{
 			buffer_ = buffer;
+			pos_ = 0;
 		}
 
 		streamsize
 		membuf::read(char* str, std::streamsize cnt) noexcept
 		{
-			std::lock_guard<std::mutex> guard(lock_);
-			auto buf_size = buffer_.size();
-			std::size_t actual_copyable;
-
-			// There is enough bytes to write.
-			if (buf_size - pos_ > cnt)
-			{
-				actual_copyable = cnt;
-				std::memcpy(str, buffer_.data() + pos_, actual_copyable);
-				pos_ += cnt;
-
-				// Bytes not enough, write all we can have.
-			}
-			else
-			{
-				actual_copyable = buf_size - pos_;
-				std::memcpy(str, buffer_.data() + pos_, actual_copyable);
-				pos_ = buf_size;
-			}
-
-			return actual_copyable;
+			auto count = this->read_at(pos_, str, cnt);
+			pos_ += count;
+			return count;
 		}
 
 		streamsize
 		membuf::write(const char* str, std::streamsize cnt) noexcept
 		{
-			std::lock_guard<std::mutex> guard(lock_);
+			if (cnt <= 0)
+				return 0;
 
 			// Re-allocation is required to store incoming data.
-			buffer_.reserve(pos_ + cnt);
+			if (buffer_.size() < pos_ + cnt)
+				buffer_.resize(pos_ + cnt);
+
 			std::memcpy(buffer_.data() + pos_, str, cnt);
+			pos_ += cnt;
+
 			return cnt;
 		}
 
+		streamsize
+		membuf::read_at(streamoff pos, char* str, std::streamsize cnt) noexcept
+		{
+			if (cnt <= 0 || pos < 0 || (std::size_t)pos >= buffer_.size())
+				return 0;
+
+			std::size_t count = std::min<std::size_t>(cnt, buffer_.size() - pos);
+			std::memcpy(str, buffer_.data() + pos, count);
+
+			return count;
+		}
+
 		streamoff
 		membuf::seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept
 		{
-			size_t base = 0;
+			streamoff base = 0;
 			switch (dir)
 			{
 			case ios_base::beg:
 				base = 0;
 				break;
-			case ios_base::end:
+			case ios_base::cur:
 				base = pos_;
 				break;
-			case ios_base::cur:
+			case ios_base::end:
 				base = buffer_.size();
 				break;
+			default:
+				return ios_base::_BADOFF;
 			}
 
-			std::size_t resultant = base + pos;
-			if (resultant >= 0 && resultant <= buffer_.size())
-			{
-				pos_ = resultant;
-				return true;
-			}
+			streamoff resultant = base + pos;
+			if (resultant < 0 || (std::size_t)resultant > buffer_.size())
+				return ios_base::_BADOFF;
 
-			return false;
+			pos_ = static_cast<std::size_t>(resultant);
+			return resultant;
 		}
 
 		streamoff
@@ -132,6 +134,24 @@ namespace octoon
 			return buffer_.size();
 		}
 
+		const char*
+		membuf::peek(std::streamsize cnt) noexcept
+		{
+			if (cnt < 0 || pos_ > buffer_.size() || buffer_.size() - pos_ < (std::size_t)cnt)
+				return nullptr;
+			return (const char*)buffer_.data() + pos_;
+		}
+
+		const char*
+		membuf::view(std::streamsize cnt) noexcept
+		{
+			if (cnt < 0 || pos_ > buffer_.size() || buffer_.size() - pos_ < (std::size_t)cnt)
+				return nullptr;
+			auto data = (const char*)buffer_.data() + pos_;
+			pos_ += cnt;
+			return data;
+		}
+
 		int
 		membuf::flush() noexcept
 		{
@@ -142,6 +162,7 @@ namespace octoon
 		membuf::close() noexcept
 		{
 			buffer_.clear();
+			pos_ = 0;
 			return true;
 		}
 	}
@@ -93,7 +93,7 @@ namespace octoon
 			const osentry ok(this);
 			if (ok)
 			{
-				if (!this->fail() && (ios_base::off_type)this->rdbuf()->seekg(pos, ios_base::out) == ios_base::_BADOFF)
+				if (!this->fail() && (ios_base::off_type)this->rdbuf()->seekg(pos, ios_base::beg) == ios_base::_BADOFF)
 					this->setstate(ios_base::failbit);
 			}
 
@@ -0,0 +1,231 @@
+#include <octoon/io/resource_cache.h>
+#include <octoon/io/ioserver.h>
+
+namespace octoon
+{
+	namespace io
+	{
+		ResourceCache::ResourceCache(std::size_t budget) noexcept
+			: budget_(budget)
+			, bytes_(0)
+			, stats_()
+		{
+			listener_ = IoServer::instance()->add_listener([this](const std::string& vpath) { this->invalidate(vpath); });
+		}
+
+		ResourceCache::~ResourceCache() noexcept
+		{
+			IoServer::instance()->remove_listener(listener_);
+		}
+
+		void
+		ResourceCache::set_budget(std::size_t bytes) noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			budget_ = bytes;
+			this->trim_unlocked();
+		}
+
+		std::size_t
+		ResourceCache::get_budget() const noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return budget_;
+		}
+
+		std::shared_ptr<void>
+		ResourceCache::get(const std::type_info& type, const Orl& orl, const char* params) noexcept
+		{
+			auto key = make_key(type, orl, params);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = entries_.find(key);
+			if (it == entries_.end())
+			{
+				stats_.misses++;
+				return nullptr;
+			}
+
+			stats_.hits++;
+			lru_.splice(lru_.begin(), lru_, it->second);
+			return it->second->value;
+		}
+
+		std::shared_ptr<void>
+		ResourceCache::load(const std::type_info& type, const Orl& orl, const char* params, const Loader& loader)
+		{
+			auto value = this->get(type, orl, params);
+			if (value)
+				return value;
+
+			// Loaded without holding the lock, if two threads race the first one inserted wins.
+			std::size_t bytes = 0;
+			value = loader(orl, bytes);
+			if (!value)
+				return nullptr;
+
+			auto key = make_key(type, orl, params);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = entries_.find(key);
+			if (it != entries_.end())
+				return it->second->value;
+
+			lru_.push_front(Entry{ key, orl.virtual_dir(), type, value, bytes });
+			entries_.emplace(std::move(key), lru_.begin());
+
+			bytes_ += bytes;
+			memory_[type] += bytes;
+
+			this->trim_unlocked();
+
+			return value;
+		}
+
+		void
+		ResourceCache::insert(const std::type_info& type, const Orl& orl, const char* params, const std::shared_ptr<void>& value, std::size_t bytes) noexcept
+		{
+			if (!value)
+				return;
+
+			auto key = make_key(type, orl, params);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = entries_.find(key);
+			if (it != entries_.end())
+				this->unlink(it->second);
+
+			lru_.push_front(Entry{ key, orl.virtual_dir(), type, value, bytes });
+			entries_[std::move(key)] = lru_.begin();
+
+			bytes_ += bytes;
+			memory_[type] += bytes;
+
+			this->trim_unlocked();
+		}
+
+		void
+		ResourceCache::erase(const std::type_info& type, const Orl& orl, const char* params) noexcept
+		{
+			auto key = make_key(type, orl, params);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = entries_.find(key);
+			if (it != entries_.end())
+			{
+				this->unlink(it->second);
+				entries_.erase(it);
+			}
+		}
+
+		void
+		ResourceCache::invalidate(const std::string& vpath) noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			for (auto it = lru_.begin(); it != lru_.end();)
+			{
+				auto entry = it++;
+				if (entry->vdir != vpath)
+					continue;
+
+				stats_.invalidations++;
+				entries_.erase(entry->key);
+				this->unlink(entry);
+			}
+		}
+
+		void
+		ResourceCache::clear() noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			stats_.invalidations += lru_.size();
+
+			lru_.clear();
+			entries_.clear();
+			memory_.clear();
+
+			bytes_ = 0;
+		}
+
+		void
+		ResourceCache::trim() noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			this->trim_unlocked();
+		}
+
+		std::size_t
+		ResourceCache::memory(const std::type_info& type) const noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto it = memory_.find(type);
+			return it != memory_.end() ? it->second : 0;
+		}
+
+		ResourceCache::Stats
+		ResourceCache::stats() const noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto stats = stats_;
+			stats.count = lru_.size();
+			stats.bytes = bytes_;
+			return stats;
+		}
+
+		void
+		ResourceCache::reset_stats() noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stats_ = Stats();
+		}
+
+		std::string
+		ResourceCache::make_key(const std::type_info& type, const Orl& orl, const char* params) noexcept
+		{
+			std::string key(type.name());
+			key += '\n';
+			key += params ? params : "";
+			key += '\n';
+			key += orl.to_string();
+			return key;
+		}
+
+		void
+		ResourceCache::unlink(Entries::iterator it) noexcept
+		{
+			bytes_ -= it->bytes;
+			memory_[it->type] -= it->bytes;
+
+			lru_.erase(it);
+		}
+
+		void
+		ResourceCache::trim_unlocked() noexcept
+		{
+			auto it = lru_.end();
+
+			while (bytes_ > budget_ && it != lru_.begin())
+			{
+				auto entry = --it;
+
+				// Only the cache holds it, no new handle can appear without the lock.
+				if (entry->value.use_count() > 1)
+					continue;
+
+				it = std::next(entry);
+
+				stats_.evictions++;
+				entries_.erase(entry->key);
+				this->unlink(entry);
+			}
+		}
+	}
+}
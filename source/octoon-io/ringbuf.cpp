@@ -0,0 +1,195 @@
+#include <octoon/io/ringbuf.h>
+
+#include <cstring>
+#include <algorithm>
+
+namespace octoon
+{
+	namespace io
+	{
+		ringbuf::ringbuf() noexcept
+			: mask_(0)
+			, finished_(false)
+			, head_(0)
+			, tail_cache_(0)
+			, viewed_(0)
+			, tail_(0)
+			, head_cache_(0)
+		{
+		}
+
+		ringbuf::ringbuf(std::size_t capacity) noexcept
+			: ringbuf()
+		{
+			this->open(capacity);
+		}
+
+		ringbuf::~ringbuf() noexcept
+		{
+		}
+
+		bool
+		ringbuf::is_open() const noexcept
+		{
+			return buffer_ != nullptr;
+		}
+
+		void
+		ringbuf::open(std::size_t capacity) noexcept
+		{
+			std::size_t size = 1;
+			while (size < capacity)
+				size <<= 1;
+
+			buffer_ = std::make_unique<char[]>(size);
+			mask_ = size - 1;
+
+			finished_ = false;
+			head_ = 0;
+			tail_ = 0;
+			tail_cache_ = 0;
+			head_cache_ = 0;
+			viewed_ = 0;
+		}
+
+		bool
+		ringbuf::close() noexcept
+		{
+			if (!buffer_)
+				return false;
+
+			buffer_.reset();
+			mask_ = 0;
+
+			return true;
+		}
+
+		std::size_t
+		ringbuf::capacity() const noexcept
+		{
+			return buffer_ ? mask_ + 1 : 0;
+		}
+
+		void
+		ringbuf::finish() noexcept
+		{
+			finished_.store(true, std::memory_order_release);
+		}
+
+		bool
+		ringbuf::eof() const noexcept
+		{
+			return finished_.load(std::memory_order_acquire) && this->size() == 0;
+		}
+
+		void
+		ringbuf::release() noexcept
+		{
+			// Room of the last view is handed back to the producer only once the consumer moves on.
+			if (viewed_ > 0)
+			{
+				head_.store(head_.load(std::memory_order_relaxed) + viewed_, std::memory_order_release);
+				viewed_ = 0;
+			}
+		}
+
+		streamsize
+		ringbuf::read(char* str, std::streamsize cnt) noexcept
+		{
+			if (!buffer_ || cnt <= 0)
+				return 0;
+
+			this->release();
+
+			auto head = head_.load(std::memory_order_relaxed);
+			if (tail_cache_ - head < (std::uint64_t)cnt)
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+
+			std::size_t count = std::min<std::uint64_t>(cnt, tail_cache_ - head);
+			std::size_t offset = head & mask_;
+			std::size_t first = std::min(count, mask_ + 1 - offset);
+
+			std::memcpy(str, buffer_.get() + offset, first);
+			std::memcpy(str + first, buffer_.get(), count - first);
+
+			head_.store(head + count, std::memory_order_release);
+			return count;
+		}
+
+		streamsize
+		ringbuf::write(const char* str, std::streamsize cnt) noexcept
+		{
+			if (!buffer_ || cnt <= 0)
+				return 0;
+
+			auto tail = tail_.load(std::memory_order_relaxed);
+			if (mask_ + 1 - (tail - head_cache_) < (std::uint64_t)cnt)
+				head_cache_ = head_.load(std::memory_order_acquire);
+
+			std::size_t count = std::min<std::uint64_t>(cnt, mask_ + 1 - (tail - head_cache_));
+			std::size_t offset = tail & mask_;
+			std::size_t first = std::min(count, mask_ + 1 - offset);
+
+			std::memcpy(buffer_.get() + offset, str, first);
+			std::memcpy(buffer_.get(), str + first, count - first);
+
+			tail_.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		streamoff
+		ringbuf::seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept
+		{
+			if (pos == 0 && dir == ios_base::cur)
+				return this->tellg();
+			return ios_base::_BADOFF;
+		}
+
+		streamoff
+		ringbuf::tellg() noexcept
+		{
+			return static_cast<streamoff>(head_.load(std::memory_order_relaxed) + viewed_);
+		}
+
+		streamsize
+		ringbuf::size() const noexcept
+		{
+			return static_cast<streamsize>(tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed) - viewed_);
+		}
+
+		const char*
+		ringbuf::peek(std::streamsize cnt) noexcept
+		{
+			if (!buffer_ || cnt < 0)
+				return nullptr;
+
+			this->release();
+
+			auto head = head_.load(std::memory_order_relaxed);
+			if (tail_cache_ - head < (std::uint64_t)cnt)
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+
+			std::size_t offset = head & mask_;
+			if (tail_cache_ - head < (std::uint64_t)cnt || offset + cnt > mask_ + 1)
+				return nullptr;
+
+			return buffer_.get() + offset;
+		}
+
+		const char*
+		ringbuf::view(std::streamsize cnt) noexcept
+		{
+			// The bytes stay valid until the next read, peek or view.
+			auto data = this->peek(cnt);
+			if (data)
+				viewed_ = static_cast<std::size_t>(cnt);
+			return data;
+		}
+
+		int
+		ringbuf::flush() noexcept
+		{
+			return 0;
+		}
+	}
+}
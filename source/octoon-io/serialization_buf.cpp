@@ -1,85 +1,323 @@
 #include <octoon/io/serialization_buf.h>
 
+#include <cstring>
+
 namespace octoon
 {
 	namespace io
 	{
+		namespace
+		{
+			// Documents start small, most objects of a scene have a handful of members, and
+			// double their blocks up to the largest size.
+			constexpr std::size_t first_block_size = 512;
+			constexpr std::size_t block_size = 64 << 10;
+
+			inline std::size_t hash_key(const serialization_key& key, std::size_t mask) noexcept
+			{
+				return serialization_key::hash()(key) & mask;
+			}
+		}
+
+		serialization_document::serialization_document() noexcept
+			: head_(nullptr)
+			, left_(0)
+			, usage_(0)
+			, next_block_(first_block_size)
+			, count_(0)
+		{
+		}
+
+		serialization_document::~serialization_document() noexcept
+		{
+		}
+
+		void*
+		serialization_document::allocate(std::size_t size, std::size_t align)
+		{
+			auto padding = (align - reinterpret_cast<std::uintptr_t>(head_) % align) % align;
+
+			if (padding + size > left_)
+			{
+				// Whatever is left of the current block is given up, large requests get their own.
+				auto capacity = std::max(next_block_, size + align);
+				next_block_ = std::min(next_block_ * 2, block_size);
+				blocks_.push_back(std::make_unique<char[]>(capacity));
+
+				head_ = blocks_.back().get();
+				left_ = capacity;
+				usage_ += capacity;
+
+				padding = (align - reinterpret_cast<std::uintptr_t>(head_) % align) % align;
+			}
+
+			auto ptr = head_ + padding;
+			head_ += padding + size;
+			left_ -= padding + size;
+
+			return ptr;
+		}
+
+		serialization_key
+		serialization_document::intern(const serialization_key& key)
+		{
+			if (keys_.size() < (count_ + 1) * 2)
+			{
+				std::vector<serialization_key> keys(std::max<std::size_t>(keys_.size() * 2, 16));
+				for (auto& it : keys_)
+				{
+					if (!it.data())
+						continue;
+
+					auto i = hash_key(it, keys.size() - 1);
+					while (keys[i].data())
+						i = (i + 1) & (keys.size() - 1);
+					keys[i] = it;
+				}
+
+				keys_.swap(keys);
+			}
+
+			auto mask = keys_.size() - 1;
+			auto i = hash_key(key, mask);
+			for (; keys_[i].data(); i = (i + 1) & mask)
+			{
+				if (keys_[i] == key)
+					return keys_[i];
+			}
+
+			auto str = static_cast<char*>(this->allocate(key.size() + 1, 1));
+			std::memcpy(str, key.data(), key.size());
+			str[key.size()] = 0;
+
+			count_++;
+			keys_[i] = serialization_key(str, key.size());
+
+			return keys_[i];
+		}
+
+		serialization_key
+		serialization_document::find(const serialization_key& key) const noexcept
+		{
+			if (keys_.empty())
+				return serialization_key();
+
+			auto mask = keys_.size() - 1;
+			for (auto i = hash_key(key, mask); keys_[i].data(); i = (i + 1) & mask)
+			{
+				if (keys_[i] == key)
+					return keys_[i];
+			}
+
+			return serialization_key();
+		}
+
+		std::size_t
+		serialization_document::memory_usage() const noexcept
+		{
+			return usage_;
+		}
+
+		serialization_object::serialization_object(std::shared_ptr<serialization_document>&& document)
+			: document_(std::move(document))
+			, members_(document_.get())
+			, indexed_(0)
+			, index_(document_.get())
+		{
+		}
+
+		serialization_object::~serialization_object() noexcept
+		{
+		}
+
+		serialization_object::member_t*
+		serialization_object::find(const serialization_key& key) noexcept
+		{
+			return const_cast<member_t*>(static_cast<const serialization_object*>(this)->find(key));
+		}
+
+		const serialization_object::member_t*
+		serialization_object::find(const serialization_key& key) const noexcept
+		{
+			if (members_.size() < index_threshold)
+			{
+				for (auto& it : members_)
+				{
+					if (it.first == key)
+						return &it;
+				}
+
+				return nullptr;
+			}
+
+			if (indexed_ != members_.size())
+				this->reindex();
+
+			// The index hashes key contents, so a lookup costs one hash whether or not the caller's
+			// key is the interned one, interned keys then compare by pointer.
+			auto mask = index_.size() - 1;
+
+			for (auto i = hash_key(key, mask); index_[i]; i = (i + 1) & mask)
+			{
+				auto& it = members_[index_[i] - 1];
+				if (it.first == key)
+					return &it;
+			}
+
+			return nullptr;
+		}
+
+		serialization_object::member_t&
+		serialization_object::append(const serialization_key& key, serialization_buf&& value)
+		{
+			auto interned = document_->intern(key);
+			auto data = members_.data();
+
+			members_.emplace_back(interned, std::move(value));
+
+			// Moving the members around forgot which document their null values belong to.
+			if (data != members_.data())
+			{
+				for (auto& it : members_)
+					it.second._adopt(document_.get());
+			}
+			else
+			{
+				members_.back().second._adopt(document_.get());
+			}
+
+			return members_.back();
+		}
+
+		serialization_buf&
+		serialization_object::operator[](const serialization_key& key)
+		{
+			auto it = this->find(key);
+			if (it)
+				return it->second;
+
+			return this->append(key, serialization_buf()).second;
+		}
+
+		void
+		serialization_object::reindex() const
+		{
+			if (index_.size() < members_.size() * 2)
+			{
+				std::size_t capacity = 16;
+				while (capacity < members_.size() * 2)
+					capacity <<= 1;
+
+				index_.assign(capacity, 0);
+				indexed_ = 0;
+			}
+
+			for (; indexed_ < members_.size(); indexed_++)
+				this->insert_index(static_cast<std::uint32_t>(indexed_));
+		}
+
+		void
+		serialization_object::insert_index(std::uint32_t n) const noexcept
+		{
+			auto& key = members_[n].first;
+			auto mask = index_.size() - 1;
+			auto i = hash_key(key, mask);
+
+			for (; index_[i]; i = (i + 1) & mask)
+			{
+				if (members_[index_[i] - 1].first.data() == key.data())
+					return;
+			}
+
+			index_[i] = n + 1;
+		}
+
 		const serialization_buf& serialization_buf::nil = serialization_buf();
 		const serialization_buf& serialization_buf::nilRef = serialization_buf();
 
 		serialization_buf::serialization_buf() noexcept
+			: _type(type_t::null)
 		{
+			_value.document = nullptr;
 		}
 
 		serialization_buf::serialization_buf(type_t value)
+			: serialization_buf()
 		{
 			this->emplace(value);
 		}
 
 		serialization_buf::serialization_buf(boolean_t value)
-			: _data(value)
+			: _type(type_t::boolean)
 		{
+			_value.boolean_value = value;
 		}
 
 		serialization_buf::serialization_buf(number_integer_t value)
-			: _data(value)
+			: _type(type_t::number_integer)
 		{
+			_value.integer_value = value;
 		}
 
 		serialization_buf::serialization_buf(number_unsigned_t value)
-			: _data(value)
+			: _type(type_t::number_unsigned)
 		{
+			_value.unsigned_value = value;
 		}
 
 		serialization_buf::serialization_buf(number_float_t value)
-			: _data(value)
+			: _type(type_t::number_float)
 		{
+			_value.float_value = value;
 		}
 
 		serialization_buf::serialization_buf(string_t&& value)
-			: _data(std::make_unique<string_t>(std::move(value)))
+			: _type(type_t::string)
 		{
+			_value.string_value = new string_t(std::move(value));
 		}
 
 		serialization_buf::serialization_buf(const string_t& value)
-			: _data(std::make_unique<string_t>(value))
+			: _type(type_t::string)
 		{
+			_value.string_value = new string_t(value);
 		}
 
 		serialization_buf::serialization_buf(const string_t::value_type* value)
-			: _data(std::make_unique<string_t>(value))
+			: _type(type_t::string)
 		{
+			_value.string_value = new string_t(value);
 		}
 
-		serialization_buf::serialization_buf(serialization_buf&& node)
-			: _data(std::move(node._data))
+		serialization_buf::serialization_buf(serialization_buf&& node) noexcept
+			: _type(node._type)
+			, _value(node._value)
 		{
+			if (this->is_null())
+				_value.document = nullptr;
+
+			node._type = type_t::null;
+			node._value.document = nullptr;
 		}
 
 		serialization_buf::~serialization_buf() noexcept
 		{
+			this->_destroy();
 		}
 
 		serialization_buf&
 		serialization_buf::at(const string_t& key)
 		{
 			if (this->is_null())
-				_data.emplace<std::unique_ptr<map_t>>(std::make_unique<map_t>());
+				this->_object();
 
 			if (this->is_object())
 			{
-				auto& data = std::get<serialization_buf::type_t::object>(_data);
-
-				for (auto& it : *data)
-					if (it.first == key)
-						return it.second;
-
-				data->push_back(std::make_pair(key, serialization_buf::null));
-				return data->back().second;
+				return (*_value.object_value)[key];
 			}
 			else
 			{
-				throw failure(std::string("cannot use function:at with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use function:at with ") + this->type_name());
 			}
 		}
 
@@ -87,22 +325,15 @@ namespace octoon
 		serialization_buf::at(const string_t::value_type* key)
 		{
 			if (this->is_null())
-				_data.emplace<std::unique_ptr<map_t>>(std::make_unique<map_t>());
+				this->_object();
 
 			if (this->is_object())
 			{
-				auto& data = std::get<serialization_buf::type_t::object>(_data);
-
-				for (auto& it : *data)
-					if (it.first == key)
-						return it.second;
-
-				data->push_back(std::make_pair(key, serialization_buf::null));
-				return data->back().second;
+				return (*_value.object_value)[key];
 			}
 			else
 			{
-				throw failure(std::string("cannot use function:at with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use function:at with ") + this->type_name());
 			}
 		}
 
@@ -111,14 +342,14 @@ namespace octoon
 		{
 			if (this->is_array())
 			{
-				auto& data = std::get<serialization_buf::type_t::array>(_data);
+				auto data = _value.array_value;
 				assert(data->size() > n);
 
 				return (*data)[n];
 			}
 			else
 			{
-				throw failure(std::string("cannot use function:at with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use function:at with ") + this->type_name());
 			}
 		}
 
@@ -127,17 +358,12 @@ namespace octoon
 		{
 			if (this->is_object())
 			{
-				auto& data = std::get<serialization_buf::type_t::object>(_data);
-
-				for (auto& it : *data)
-					if (it.first == key)
-						return it.second;
-
-				return serialization_buf::nil;
+				auto it = _value.object_value->find(key);
+				return it ? it->second : serialization_buf::nil;
 			}
 			else
 			{
-				throw failure(std::string("cannot use function:at with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use function:at with ") + this->type_name());
 			}
 		}
 
@@ -146,17 +372,12 @@ namespace octoon
 		{
 			if (this->is_object())
 			{
-				auto& data = std::get<serialization_buf::type_t::object>(_data);
-
-				for (auto& it : *data)
-					if (it.first == key)
-						return it.second;
-
-				return serialization_buf::nil;
+				auto it = _value.object_value->find(key);
+				return it ? it->second : serialization_buf::nil;
 			}
 			else
 			{
-				throw failure(std::string("cannot use function:at with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use function:at with ") + this->type_name());
 			}
 		}
 
@@ -165,14 +386,14 @@ namespace octoon
 		{
 			if (this->is_array())
 			{
-				auto& data = std::get<serialization_buf::type_t::array>(_data);
+				auto data = _value.array_value;
 				assert(data->size() > n);
 
 				return (*data)[n];
 			}
 			else
 			{
-				throw failure(std::string("cannot use function:at with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use function:at with ") + this->type_name());
 			}
 		}
 
@@ -180,70 +401,63 @@ namespace octoon
 		serialization_buf::push_back(const string_t& key, boolean_t value)
 		{
 			if (this->is_null())
-				this->emplace(serialization_buf::type_t::object);
+				this->_object();
 
-			auto& data = std::get<serialization_buf::type_t::object>(_data);
-			data->push_back(std::make_pair(key, value));
+			_value.object_value->append(key, serialization_buf(value));
 		}
 
 		void
 		serialization_buf::push_back(const string_t& key, const number_integer_t& value)
 		{
 			if (this->is_null())
-				this->emplace(serialization_buf::type_t::object);
+				this->_object();
 
-			auto& data = std::get<serialization_buf::type_t::object>(_data);
-			data->push_back(std::make_pair(key, value));
+			_value.object_value->append(key, serialization_buf(value));
 		}
 
 		void
 		serialization_buf::push_back(const string_t& key, const number_unsigned_t& value)
 		{
 			if (this->is_null())
-				this->emplace(serialization_buf::type_t::object);
+				this->_object();
 
-			auto& data = std::get<serialization_buf::type_t::object>(_data);
-			data->push_back(std::make_pair(key, value));
+			_value.object_value->append(key, serialization_buf(value));
 		}
 
 		void
 		serialization_buf::push_back(const string_t& key, const number_float_t& value)
 		{
 			if (this->is_null())
-				this->emplace(serialization_buf::type_t::object);
+				this->_object();
 
-			auto& data = std::get<serialization_buf::type_t::object>(_data);
-			data->push_back(std::make_pair(key, value));
+			_value.object_value->append(key, serialization_buf(value));
 		}
 
 		void
 		serialization_buf::push_back(const string_t& key, const string_t& value)
 		{
 			if (this->is_null())
-				this->emplace(serialization_buf::type_t::object);
+				this->_object();
 
-			auto& data = std::get<serialization_buf::type_t::object>(_data);
-			data->push_back(std::make_pair(key, value));
+			_value.object_value->append(key, serialization_buf(value));
 		}
 
 		void
 		serialization_buf::push_back(const string_t& key, const string_t::value_type* value)
 		{
 			if (this->is_null())
-				this->emplace(serialization_buf::type_t::object);
+				this->_object();
 
-			auto& data = std::get<serialization_buf::type_t::object>(_data);
-			data->push_back(std::make_pair(key, value));
+			_value.object_value->append(key, serialization_buf(value));
 		}
 
 		void
 		serialization_buf::push_back(const string_t& key, serialization_buf&& value)
 		{
 			if (this->is_null())
-				this->emplace(serialization_buf::type_t::object);
+				this->_object();
 
-			auto& data = std::get<serialization_buf::type_t::object>(_data);
-			data->push_back(std::make_pair(key, std::move(value)));
+			_value.object_value->append(key, std::move(value));
 		}
 
 		serialization_buf::iterator
@@ -252,8 +466,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->begin();
+				if (_value.object_value)
+					return _value.object_value->begin();
 				break;
 			default:
 				break;
@@ -268,8 +482,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->end();
+				if (_value.object_value)
+					return _value.object_value->end();
 				break;
 			default:
 				break;
@@ -284,8 +498,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->begin();
+				if (_value.object_value)
+					return _value.object_value->begin();
 				break;
 			default:
 				break;
@@ -300,8 +514,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->end();
+				if (_value.object_value)
+					return _value.object_value->end();
 				break;
 			default:
 				break;
@@ -316,8 +530,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->rbegin();
+				if (_value.object_value)
+					return serialization_buf::reverse_iterator(_value.object_value->end());
 				break;
 			default:
 				break;
@@ -332,8 +546,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->rend();
+				if (_value.object_value)
+					return serialization_buf::reverse_iterator(_value.object_value->begin());
 				break;
 			default:
 				break;
@@ -348,8 +562,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->rbegin();
+				if (_value.object_value)
+					return serialization_buf::reverse_iterator(_value.object_value->end());
 				break;
 			default:
 				break;
@@ -364,8 +578,8 @@ namespace octoon
 			switch (this->type())
 			{
 			case serialization_buf::type_t::object:
-				if (std::get<serialization_buf::type_t::object>(_data))
-					return std::get<serialization_buf::type_t::object>(_data)->rend();
+				if (_value.object_value)
+					return serialization_buf::reverse_iterator(_value.object_value->begin());
 				break;
 			default:
 				break;
@@ -378,34 +592,34 @@ namespace octoon
 		serialization_buf::front() noexcept
 		{
 			assert(this->type() == serialization_buf::type_t::object);
-			return std::get<serialization_buf::type_t::object>(_data)->front().second;
+			return _value.object_value->front().second;
 		}
 
 		const serialization_buf&
 		serialization_buf::front() const noexcept
 		{
 			assert(this->type() == serialization_buf::type_t::object);
-			return std::get<serialization_buf::type_t::object>(_data)->front().second;
+			return _value.object_value->front().second;
 		}
 
 		serialization_buf&
 		serialization_buf::back() noexcept
 		{
 			assert(this->type() == serialization_buf::type_t::object);
-			return std::get<serialization_buf::type_t::object>(_data)->back().second;
+			return _value.object_value->back().second;
 		}
 
 		const serialization_buf&
 		serialization_buf::back() const noexcept
 		{
 			assert(this->type() == serialization_buf::type_t::object);
-			return std::get<serialization_buf::type_t::object>(_data)->back().second;
+			return _value.object_value->back().second;
 		}
 
 		serialization_buf::type_t
 		serialization_buf::type() const noexcept
 		{
-			return (type_t)_data.index();
+			return _type;
 		}
 
 		char*
@@ -491,41 +705,49 @@ namespace octoon
 		void
 		serialization_buf::emplace(type_t type) noexcept
 		{
+			auto document = this->is_null() ? static_cast<serialization_document*>(_value.document) : nullptr;
+
+			if (type != serialization_buf::type_t::object)
+				this->_destroy();
+
 			switch (type)
 			{
-			case serialization_buf::type_t::null:
-				_data.emplace<void*>();
-				break;
 			case serialization_buf::type_t::boolean:
-				_data.emplace<bool>(false);
+				_value.boolean_value = false;
 				break;
 			case serialization_buf::type_t::number_integer:
-				_data.emplace<number_integer_t>(0);
+				_value.integer_value = 0;
 				break;
 			case serialization_buf::type_t::number_unsigned:
-				_data.emplace<number_unsigned_t>(0);
+				_value.unsigned_value = 0;
 				break;
 			case serialization_buf::type_t::number_float:
-				_data.emplace<number_float_t>(number_float_t(0.0f));
+				_value.float_value = number_float_t(0.0f);
 				break;
 			case serialization_buf::type_t::string:
-				_data.emplace<std::unique_ptr<string_t>>(std::make_unique<string_t>());
+				_value.string_value = new string_t();
 				break;
 			case serialization_buf::type_t::array:
-				_data.emplace<std::unique_ptr<array_t>>(std::make_unique<array_t>());
+				_value.array_value = new array_t();
+				if (document)
+					_value.array_value->document = document->shared_from_this();
 				break;
 			case serialization_buf::type_t::object:
-				_data.emplace<std::unique_ptr<map_t>>(std::make_unique<map_t>());
-				break;
+				if (!this->is_null())
+					this->_destroy();
+				this->_object();
+				return;
 			default:
-				break;
+				return;
 			}
+
+			_type = type;
 		}
 
 		void
 		serialization_buf::clear() noexcept
 		{
-			_data.emplace<void*>();
+			this->_destroy();
 		}
 
 		std::size_t
@@ -543,49 +765,83 @@ namespace octoon
 		serialization_buf&
 		serialization_buf::operator=(boolean_t value)
 		{
-			_data = value;
+			this->_destroy();
+			_type = type_t::boolean;
+			_value.boolean_value = value;
 			return *this;
 		}
 
 		serialization_buf&
 		serialization_buf::operator=(number_integer_t value)
 		{
-			_data = value;
+			this->_destroy();
+			_type = type_t::number_integer;
+			_value.integer_value = value;
 			return *this;
 		}
 
 		serialization_buf&
 		serialization_buf::operator=(number_unsigned_t value)
 		{
-			_data = value;
+			this->_destroy();
+			_type = type_t::number_unsigned;
+			_value.unsigned_value = value;
 			return *this;
 		}
 
 		serialization_buf&
 		serialization_buf::operator=(number_float_t value)
 		{
-			_data = value;
+			this->_destroy();
+			_type = type_t::number_float;
+			_value.float_value = value;
 			return *this;
 		}
 
 		serialization_buf&
 		serialization_buf::operator=(string_t&& value)
 		{
-			_data = std::make_unique<string_t>(std::move(value));
+			auto str = new string_t(std::move(value));
+			this->_destroy();
+			_type = type_t::string;
+			_value.string_value = str;
 			return *this;
 		}
 
 		serialization_buf&
 		serialization_buf::operator=(const string_t& value)
 		{
-			_data = std::make_unique<string_t>(value);
+			// The value may live inside this node, copy it before letting go of the old one.
+			auto str = new string_t(value);
+			this->_destroy();
+			_type = type_t::string;
+			_value.string_value = str;
 			return *this;
 		}
 
 		serialization_buf&
-		serialization_buf::operator=(serialization_buf&& value)
+		serialization_buf::operator=(serialization_buf&& value) noexcept
 		{
-			_data = std::move(value._data);
+			if (value.is_null())
+			{
+				if (!this->is_null())
+					this->_destroy();
+			}
+			else if (this != &value)
+			{
+				// The value may be a member of this node, take it over before destroying the old one.
+				auto type = value._type;
+				auto data = value._value;
+
+				value._type = type_t::null;
+				value._value.document = nullptr;
+
+				this->_destroy();
+
+				_type = type;
+				_value = data;
+			}
+
 			return *this;
 		}
 
@@ -593,22 +849,15 @@ namespace octoon
 		serialization_buf::operator[](const char* key)
 		{
 			if (this->is_null())
-				_data.emplace<std::unique_ptr<map_t>>(std::make_unique<map_t>());
+				this->_object();
 
 			if (this->is_object())
 			{
-				auto& data = std::get<serialization_buf::type_t::object>(_data);
-
-				for (auto& it : *data)
-					if (it.first == key)
-						return it.second;
-
-				data->push_back(std::make_pair(key, serialization_buf::null));
-				return data->back().second;
+				return (*_value.object_value)[key];
 			}
 			else
 			{
-				throw failure(std::string("cannot use operator[] with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use operator[] with ") + this->type_name());
 			}
 		}
 
@@ -616,22 +865,15 @@ namespace octoon
 		serialization_buf::operator[](const string_t& key)
 		{
 			if (this->is_null())
-				_data.emplace<std::unique_ptr<map_t>>(std::make_unique<map_t>());
+				this->_object();
 
 			if (this->is_object())
 			{
-				auto& data = std::get<serialization_buf::type_t::object>(_data);
-
-				for (auto& it : *data)
-					if (it.first == key)
-						return it.second;
-
-				data->push_back(std::make_pair(key, null));
-				return data->back().second;
+				return (*_value.object_value)[key];
 			}
 			else
 			{
-				throw failure(std::string("cannot use operator[] with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use operator[] with ") + this->type_name());
 			}
 		}
 
@@ -639,22 +881,28 @@ namespace octoon
 		serialization_buf::operator[](std::size_t n)
 		{
 			if (this->is_null())
-				_data.emplace<std::unique_ptr<array_t>>(std::make_unique<array_t>());
+				this->emplace(serialization_buf::type_t::array);
 
 			if (this->is_array())
 			{
-				if (n >= std::get<serialization_buf::type_t::array>(_data)->size())
+				auto& array = *_value.array_value;
+				if (n >= array.size())
 				{
-					auto end = std::get<serialization_buf::type_t::array>(_data)->end();
-					auto size = std::get<serialization_buf::type_t::array>(_data)->size();
-					std::get<serialization_buf::type_t::array>(_data)->resize(n + 1);
+					auto data = array.data();
+					auto size = array.size();
+
+					array.resize(n + 1);
+
+					// As in serialization_object::append, moved nulls forgot their document.
+					for (auto i = data != array.data() ? 0 : size; i < array.size(); i++)
+						array[i]._adopt(array.document.get());
 				}
 
-				return std::get<serialization_buf::type_t::array>(_data)->operator[](n);
+				return array[n];
 			}
 			else
 			{
-				throw failure(std::string("cannot use operator[] with ") + this->type_name());
+				throw runtime::type_error::create(std::string("cannot use operator[] with ") + this->type_name());
 			}
 		}
 
@@ -676,6 +924,55 @@ namespace octoon
 			return this->at(n);
 		}
 
+		serialization_buf::object_t&
+		serialization_buf::_front() const
+		{
+			return _value.object_value->front().second;
+		}
+
+		serialization_object&
+		serialization_buf::_object()
+		{
+			if (this->is_null())
+			{
+				auto document = static_cast<serialization_document*>(_value.document);
+				auto shared = document ? document->shared_from_this() : std::make_shared<serialization_document>();
+				_value.object_value = new map_t(std::move(shared));
+				_type = type_t::object;
+			}
+
+			return *_value.object_value;
+		}
+
+		void
+		serialization_buf::_adopt(serialization_document* document) noexcept
+		{
+			if (this->is_null())
+				_value.document = document;
+		}
+
+		void
+		serialization_buf::_destroy() noexcept
+		{
+			switch (_type)
+			{
+			case type_t::string:
+				delete _value.string_value;
+				break;
+			case type_t::array:
+				delete _value.array_value;
+				break;
+			case type_t::object:
+				delete _value.object_value;
+				break;
+			default:
+				break;
+			}
+
+			_type = type_t::null;
+			_value.document = nullptr;
+		}
+
 		void
 		serialization_buf::lock() noexcept
 		{
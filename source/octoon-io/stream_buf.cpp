@@ -4,6 +4,34 @@ namespace octoon
 {
 	namespace io
 	{
+		const char*
+		stream_buf::peek(std::streamsize) noexcept
+		{
+			return nullptr;
+		}
+
+		const char*
+		stream_buf::view(std::streamsize) noexcept
+		{
+			return nullptr;
+		}
+
+		streamsize
+		stream_buf::read_at(streamoff pos, char* str, std::streamsize cnt) noexcept
+		{
+			this->lock();
+
+			streamsize count = 0;
+			streamoff cur = this->tellg();
+			if (this->seekg(pos, ios_base::beg) != ios_base::_BADOFF)
+				count = this->read(str, cnt);
+			this->seekg(cur, ios_base::beg);
+
+			this->unlock();
+
+			return count;
+		}
+
 		void
 		stream_buf::lock() noexcept
 		{
@@ -68,6 +68,24 @@ namespace octoon
 			return buf_ ? buf_->size() : 0;
 		}
 
+		const char*
+		virtual_buf::peek(std::streamsize cnt) noexcept
+		{
+			return buf_ ? buf_->peek(cnt) : nullptr;
+		}
+
+		const char*
+		virtual_buf::view(std::streamsize cnt) noexcept
+		{
+			return buf_ ? buf_->view(cnt) : nullptr;
+		}
+
+		streamsize
+		virtual_buf::read_at(streamoff pos, char* str, std::streamsize cnt) noexcept
+		{
+			return buf_ ? buf_->read_at(pos, str, cnt) : 0;
+		}
+
 		int
 		virtual_buf::flush() noexcept
 		{
@@ -1,61 +1,540 @@
 // File: virtual_dirs.h
 // Author: PENGUINLIONG
 #include <cassert>
-#include <zipper/unzipper.h>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
 
 #include <octoon/io/zarchive.h>
-#include <octoon/io/membuf.h>
+#include <octoon/io/mapbuf.h>
 
 namespace octoon
 {
 	namespace io
 	{
+		namespace
+		{
+			const std::uint32_t ZIP_LOCAL_HEADER = 0x04034b50;
+			const std::uint32_t ZIP_CENTRAL_HEADER = 0x02014b50;
+			const std::uint32_t ZIP_END_OF_CENTRAL = 0x06054b50;
+			const std::uint32_t ZIP64_END_OF_CENTRAL = 0x06064b50;
+			const std::uint32_t ZIP64_END_OF_CENTRAL_LOCATOR = 0x07064b50;
+
+			const std::uint16_t ZIP_METHOD_STORED = 0;
+			const std::uint16_t ZIP_METHOD_DEFLATED = 8;
+			const std::uint16_t ZIP_FLAG_ENCRYPTED = 1 << 0;
+
+			// Distance in uncompressed bytes between two restart points of a deflated entry.
+			const std::uint64_t INFLATE_SPAN = 1 << 20;
+			const std::size_t INFLATE_WINDOW = 1 << 15;
+
+			std::uint16_t read16(const char* ptr) noexcept
+			{
+				auto p = (const std::uint8_t*)ptr;
+				return std::uint16_t(p[0] | (p[1] << 8));
+			}
+
+			std::uint32_t read32(const char* ptr) noexcept
+			{
+				auto p = (const std::uint8_t*)ptr;
+				return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+			}
+
+			std::uint64_t read64(const char* ptr) noexcept
+			{
+				return std::uint64_t(read32(ptr)) | (std::uint64_t(read32(ptr + 4)) << 32);
+			}
+
+			ios_base::off_type seek_target(ios_base::off_type pos, ios_base::seekdir dir, std::uint64_t cur, std::uint64_t size) noexcept
+			{
+				switch (dir)
+				{
+				case ios_base::beg:
+					return pos;
+				case ios_base::cur:
+					return (ios_base::off_type)cur + pos;
+				case ios_base::end:
+					return (ios_base::off_type)size + pos;
+				default:
+					return ios_base::_BADOFF;
+				}
+			}
+
+			/*
+			* Stored entry, a window into the mapped archive.
+			*/
+			class storedbuf final : public stream_buf
+			{
+			public:
+				storedbuf(const std::shared_ptr<mapbuf>& file, const char* data, std::size_t size) noexcept
+					: file_(file)
+					, data_(data)
+					, size_(size)
+					, pos_(0)
+				{
+				}
+
+				bool is_open() const noexcept override
+				{
+					return true;
+				}
+
+				streamsize read(char* str, std::streamsize cnt) noexcept override
+				{
+					if (cnt <= 0)
+						return 0;
+
+					std::size_t count = std::min<std::size_t>(cnt, size_ - pos_);
+					std::memcpy(str, data_ + pos_, count);
+					pos_ += count;
+
+					return count;
+				}
+
+				streamsize write(const char*, std::streamsize) noexcept override
+				{
+					return 0;
+				}
+
+				streamoff seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept override
+				{
+					auto target = seek_target(pos, dir, pos_, size_);
+					if (target < 0 || target > (streamoff)size_)
+						return ios_base::_BADOFF;
+
+					pos_ = static_cast<std::size_t>(target);
+					return target;
+				}
+
+				streamoff tellg() noexcept override
+				{
+					return pos_;
+				}
+
+				streamsize size() const noexcept override
+				{
+					return size_;
+				}
+
+				const char* peek(std::streamsize cnt) noexcept override
+				{
+					if (cnt < 0 || size_ - pos_ < (std::size_t)cnt)
+						return nullptr;
+					return data_ + pos_;
+				}
+
+				const char* view(std::streamsize cnt) noexcept override
+				{
+					auto data = this->peek(cnt);
+					if (data)
+						pos_ += cnt;
+					return data;
+				}
+
+				streamsize read_at(streamoff pos, char* str, std::streamsize cnt) noexcept override
+				{
+					if (cnt <= 0 || pos < 0 || (std::size_t)pos >= size_)
+						return 0;
+
+					std::size_t count = std::min<std::size_t>(cnt, size_ - pos);
+					std::memcpy(str, data_ + pos, count);
+
+					return count;
+				}
+
+				int flush() noexcept override
+				{
+					return 0;
+				}
+
+			private:
+				std::shared_ptr<mapbuf> file_;
+
+				const char* data_;
+				std::size_t size_;
+				std::size_t pos_;
+			};
+
+			/*
+			* Deflated entry, inflated on demand through a 32K window. Every INFLATE_SPAN bytes
+			* of output a restart point (input offset, bit offset and window) is recorded at a
+			* deflate block boundary, so seeking backwards restarts from the nearest point instead
+			* of from the beginning of the entry.
+			*/
+			class inflatebuf final : public stream_buf
+			{
+			public:
+				inflatebuf(const std::shared_ptr<mapbuf>& file, const char* data, std::size_t compressed_size, std::uint64_t size) noexcept
+					: file_(file)
+					, src_((const Bytef*)data)
+					, src_size_(compressed_size)
+					, size_(size)
+					, ready_(false)
+					, window_(std::make_unique<std::uint8_t[]>(INFLATE_WINDOW))
+				{
+					std::memset(&strm_, 0, sizeof(strm_));
+					this->restart(nullptr);
+				}
+
+				~inflatebuf() noexcept
+				{
+					if (ready_)
+						::inflateEnd(&strm_);
+				}
+
+				bool is_open() const noexcept override
+				{
+					return ready_;
+				}
+
+				streamsize read(char* str, std::streamsize cnt) noexcept override
+				{
+					streamsize copied = 0;
+
+					while (copied < cnt)
+					{
+						if (head_ < have_)
+						{
+							std::size_t count = std::min<std::size_t>(have_ - head_, cnt - copied);
+							std::memcpy(str + copied, window_.get() + head_, count);
+							head_ += count;
+							copied += count;
+						}
+						else if (!this->inflate())
+						{
+							break;
+						}
+					}
+
+					return copied;
+				}
+
+				streamsize write(const char*, std::streamsize) noexcept override
+				{
+					return 0;
+				}
+
+				streamoff seekg(ios_base::off_type pos, ios_base::seekdir dir) noexcept override
+				{
+					auto target = seek_target(pos, dir, this->tellg(), size_);
+					if (target < 0 || (std::uint64_t)target > size_)
+						return ios_base::_BADOFF;
+
+					// Restart from the nearest point before the target unless the target is in the
+					// window or can be reached by inflating less than a span ahead.
+					auto it = std::upper_bound(points_.begin(), points_.end(), (std::uint64_t)target, [](std::uint64_t value, const point& p) { return value < p.out; });
+					auto from = it == points_.begin() ? nullptr : &*(it - 1);
+
+					if ((std::uint64_t)target < out_ - have_ || (from && from->out > out_))
+					{
+						if (!this->restart(from))
+							return ios_base::_BADOFF;
+					}
+
+					while ((std::uint64_t)target > out_)
+					{
+						head_ = have_;
+						if (!this->inflate())
+							return ios_base::_BADOFF;
+					}
+
+					head_ = static_cast<std::size_t>(target - (out_ - have_));
+					return target;
+				}
+
+				streamoff tellg() noexcept override
+				{
+					return out_ - (have_ - head_);
+				}
+
+				streamsize size() const noexcept override
+				{
+					return size_;
+				}
+
+				int flush() noexcept override
+				{
+					return 0;
+				}
+
+			private:
+				struct point
+				{
+					std::uint64_t out;
+					std::size_t in;
+					int bits;
+					std::vector<std::uint8_t> dictionary;
+				};
+
+				bool restart(const point* from) noexcept
+				{
+					if (ready_)
+						::inflateEnd(&strm_);
+
+					std::memset(&strm_, 0, sizeof(strm_));
+					ready_ = ::inflateInit2(&strm_, -MAX_WBITS) == Z_OK;
+					if (!ready_)
+						return false;
+
+					std::size_t in = from ? from->in : 0;
+					strm_.next_in = (Bytef*)src_ + in;
+					strm_.avail_in = static_cast<uInt>(src_size_ - in);
+
+					if (from)
+					{
+						if (from->bits)
+							::inflatePrime(&strm_, from->bits, src_[from->in - 1] >> (8 - from->bits));
+						::inflateSetDictionary(&strm_, from->dictionary.data(), static_cast<uInt>(from->dictionary.size()));
+					}
+
+					out_ = from ? from->out : 0;
+					base_ = out_;
+					have_ = 0;
+					head_ = 0;
+					done_ = false;
+
+					return true;
+				}
+
+				bool inflate() noexcept
+				{
+					if (!ready_ || done_ || out_ >= size_)
+						return false;
+
+					if (have_ == INFLATE_WINDOW)
+						have_ = head_ = 0;
+
+					strm_.next_out = window_.get() + have_;
+					strm_.avail_out = static_cast<uInt>(INFLATE_WINDOW - have_);
+
+					int ret = ::inflate(&strm_, Z_BLOCK);
+					if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+						return false;
+
+					std::size_t produced = (INFLATE_WINDOW - have_) - strm_.avail_out;
+					have_ += produced;
+					out_ += produced;
+
+					if (ret == Z_STREAM_END)
+						done_ = true;
+					else if ((strm_.data_type & 128) && !(strm_.data_type & 64))
+					{
+						std::uint64_t last = points_.empty() ? 0 : points_.back().out;
+						if (out_ >= last + INFLATE_SPAN && out_ - base_ >= INFLATE_WINDOW)
+							this->mark();
+					}
+
+					return produced > 0 || ret == Z_OK;
+				}
+
+				void mark() noexcept
+				{
+					// The dictionary is the last 32K of output, oldest byte first.
+					point p;
+					p.out = out_;
+					p.in = static_cast<std::size_t>(strm_.next_in - src_);
+					p.bits = strm_.data_type & 7;
+					p.dictionary.resize(INFLATE_WINDOW);
+					std::memcpy(p.dictionary.data(), window_.get() + have_, INFLATE_WINDOW - have_);
+					std::memcpy(p.dictionary.data() + INFLATE_WINDOW - have_, window_.get(), have_);
+
+					points_.push_back(std::move(p));
+				}
+
+			private:
+				std::shared_ptr<mapbuf> file_;
+
+				const Bytef* src_;
+				std::size_t src_size_;
+				std::uint64_t size_;
+
+				z_stream strm_;
+				bool ready_;
+				bool done_;
+
+				std::unique_ptr<std::uint8_t[]> window_;
+				std::size_t have_;
+				std::size_t head_;
+				std::uint64_t out_;
+				std::uint64_t base_;
+
+				std::vector<point> points_;
+			};
+		}
+
 		zarchive::zarchive(const char* zip_file) except
-			: unzipper_(nullptr)
-			, entries_(nullptr)
 		{
-			unzipper_ = new zipper::Unzipper(zip_file);
-			entries_ = new std::vector<zipper::ZipEntry>(std::move(((zipper::Unzipper*)unzipper_)->entries()));
+			this->load(zip_file);
 		}
 
 		zarchive::zarchive(std::string&& zip_file) except
-			: unzipper_(nullptr)
-			, entries_(nullptr)
 		{
-			unzipper_ = new zipper::Unzipper(zip_file);
-			entries_ = new std::vector<zipper::ZipEntry>(std::move(((zipper::Unzipper*)unzipper_)->entries()));
+			this->load(zip_file);
 		}
 
 		zarchive::zarchive(const std::string& zip_file) except
-			: unzipper_(nullptr)
-			, entries_(nullptr)
 		{
-			unzipper_ = new zipper::Unzipper(zip_file);
-			entries_ = new std::vector<zipper::ZipEntry>(std::move(((zipper::Unzipper*)unzipper_)->entries()));
+			this->load(zip_file);
+		}
+
+		zarchive::~zarchive() noexcept
+		{
 		}
 
-		zarchive::~zarchive()
+		void
+		zarchive::load(const std::string& zip_file) except
 		{
-			delete ((zipper::Unzipper*)unzipper_);
-			delete ((std::vector<zipper::ZipEntry>*)entries_);
+			file_ = std::make_shared<mapbuf>();
+			if (!file_->open(zip_file, mapbuf::advice::random))
+				throw std::runtime_error("Cannot open zip archive '" + zip_file + "'");
+
+			auto data = file_->data();
+			auto size = static_cast<std::size_t>(file_->size());
+
+			// The end of central directory record is followed by a comment of up to 64K.
+			std::size_t eocd = std::string::npos;
+			if (size >= 22)
+			{
+				std::size_t lower = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+				for (std::size_t i = size - 22 + 1; i-- > lower;)
+				{
+					if (read32(data + i) == ZIP_END_OF_CENTRAL)
+					{
+						eocd = i;
+						break;
+					}
+				}
+			}
+
+			if (eocd == std::string::npos)
+				throw std::runtime_error("Invalid zip archive '" + zip_file + "'");
+
+			std::uint64_t count = read16(data + eocd + 10);
+			std::uint64_t central_size = read32(data + eocd + 12);
+			std::uint64_t central_offset = read32(data + eocd + 16);
+
+			if (eocd >= 20 && read32(data + eocd - 20) == ZIP64_END_OF_CENTRAL_LOCATOR)
+			{
+				std::uint64_t zip64 = read64(data + eocd - 20 + 8);
+				if (zip64 + 56 <= size && read32(data + zip64) == ZIP64_END_OF_CENTRAL)
+				{
+					count = read64(data + zip64 + 32);
+					central_size = read64(data + zip64 + 40);
+					central_offset = read64(data + zip64 + 48);
+				}
+			}
+
+			if (central_offset + central_size > size)
+				throw std::runtime_error("Invalid zip archive '" + zip_file + "'");
+
+			entries_.reserve(static_cast<std::size_t>(count));
+
+			auto ptr = data + central_offset;
+			auto end = ptr + central_size;
+
+			for (std::uint64_t i = 0; i < count && ptr + 46 <= end && read32(ptr) == ZIP_CENTRAL_HEADER; i++)
+			{
+				entry it;
+				it.flags = read16(ptr + 8);
+				it.method = read16(ptr + 10);
+				it.compressed_size = read32(ptr + 20);
+				it.size = read32(ptr + 24);
+				it.offset = read32(ptr + 42);
+
+				std::uint16_t name_length = read16(ptr + 28);
+				std::uint16_t extra_length = read16(ptr + 30);
+				std::uint16_t comment_length = read16(ptr + 32);
+
+				auto name = ptr + 46;
+				auto extra = name + name_length;
+				auto next = extra + extra_length + comment_length;
+				if (next > end)
+					break;
+
+				// Fields saturated in the header are stored in the zip64 extra field, in this order.
+				for (auto field = extra; field + 4 <= extra + extra_length;)
+				{
+					std::uint16_t id = read16(field);
+					std::uint16_t length = read16(field + 2);
+					auto value = field + 4;
+					auto last = value + length;
+
+					if (id == 0x0001)
+					{
+						if (it.size == 0xFFFFFFFF && value + 8 <= last) { it.size = read64(value); value += 8; }
+						if (it.compressed_size == 0xFFFFFFFF && value + 8 <= last) { it.compressed_size = read64(value); value += 8; }
+						if (it.offset == 0xFFFFFFFF && value + 8 <= last) { it.offset = read64(value); value += 8; }
+						break;
+					}
+
+					field = last;
+				}
+
+				std::string path(name, name_length);
+				std::replace(path.begin(), path.end(), '\\', '/');
+
+				bool directory = !path.empty() && path.back() == '/';
+				if (directory)
+					path.pop_back();
+				else if (!path.empty())
+					entries_.emplace(path, it);
+
+				// Archives are not required to list directories, every parent of an entry counts as one.
+				for (auto pos = directory ? path.size() : path.rfind('/'); pos != std::string::npos && pos > 0; pos = path.rfind('/', pos - 1))
+				{
+					if (!dirs_.emplace(path.substr(0, pos)).second)
+						break;
+				}
+
+				ptr = next;
+			}
+
+			dirs_.emplace();
 		}
 
 		std::unique_ptr<stream_buf>
 		zarchive::open(const Orl& orl, const ios_base::open_mode opts)
 		{
-			std::vector<uint8_t> buf;
-
 			// Zip archives are read-only.
 			if (opts & ios_base::out)
 				return nullptr;
 
-			if (unzipper_ == nullptr)
+			auto it = entries_.find(orl.path());
+			if (it == entries_.end())
 				return nullptr;
 
-			if (!reinterpret_cast<zipper::Unzipper*>(unzipper_)->extractEntryToMemory(orl.path(), buf))
+			auto& entry = it->second;
+			if (entry.flags & ZIP_FLAG_ENCRYPTED)
 				return nullptr;
 
-			return std::make_unique<membuf>(buf);
+			// The local header repeats name and extra field with lengths of its own.
+			auto data = file_->data();
+			auto size = static_cast<std::uint64_t>(file_->size());
+			if (entry.offset + 30 > size || read32(data + entry.offset) != ZIP_LOCAL_HEADER)
+				return nullptr;
+
+			std::uint64_t offset = entry.offset + 30 + read16(data + entry.offset + 26) + read16(data + entry.offset + 28);
+			if (offset + entry.compressed_size > size)
+				return nullptr;
+
+			switch (entry.method)
+			{
+			case ZIP_METHOD_STORED:
+				// Stored data is its own compressed form, the bounds above only hold if both sizes agree.
+				if (entry.size != entry.compressed_size)
+					return nullptr;
+				return std::make_unique<storedbuf>(file_, data + offset, static_cast<std::size_t>(entry.size));
+			case ZIP_METHOD_DEFLATED:
+			{
+				auto stream = std::make_unique<inflatebuf>(file_, data + offset, static_cast<std::size_t>(entry.compressed_size), entry.size);
+				if (stream->is_open())
+					return stream;
+				return nullptr;
+			}
+			default:
+				return nullptr;
+			}
 		}
 
 		bool
@@ -67,25 +546,15 @@ namespace octoon
 		ItemType
 		zarchive::exists(const Orl& orl)
 		{
-			if (entries_ == nullptr)
-				return ItemType::NA;
+			auto& path = orl.path();
 
-			auto size = orl.path().size();
-			for (auto entry : *(std::vector<zipper::ZipEntry>*)entries_)
-			{
-				if (entry.name.size() == size)
-				{
-					if (entry.name == orl.path())
-						return ItemType::File;
-				}
-				else if (entry.name.size() == size + 1)
-				{
-					if (orl.path().compare(entry.name) == 0 && entry.name.back() == '/')
-						return ItemType::Directory;
-				}
-			}
+			if (entries_.count(path))
+				return ItemType::File;
+
+			if (!path.empty() && path.back() == '/')
+				return dirs_.count(path.substr(0, path.size() - 1)) ? ItemType::Directory : ItemType::NA;
 
-			return ItemType::NA;
+			return dirs_.count(path) ? ItemType::Directory : ItemType::NA;
 		}
 	}
-}
\ No newline at end of file
+}
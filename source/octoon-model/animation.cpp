@@ -1,7 +1,8 @@
 #include <octoon/model/animation.h>
 #include <octoon/math/mathutil.h>
 
-#include <map>
+#include <algorithm>
+#include <unordered_map>
 
 using namespace octoon::math;
 
@@ -79,6 +80,46 @@ namespace octoon
 			return _interpolation;
 		}
 
+		MorphAnimation::MorphAnimation() noexcept
+			: _frame(-1)
+			, _weight(0.0f)
+		{
+		}
+
+		MorphAnimation::~MorphAnimation() noexcept
+		{
+		}
+
+		void MorphAnimation::setName(const std::string& name) noexcept
+		{
+			_name = name;
+		}
+
+		const std::string& MorphAnimation::getName() const noexcept
+		{
+			return _name;
+		}
+
+		void MorphAnimation::setFrameNo(std::int32_t frame) noexcept
+		{
+			_frame = frame;
+		}
+
+		std::int32_t MorphAnimation::getFrameNo() const noexcept
+		{
+			return _frame;
+		}
+
+		void MorphAnimation::setWeight(float weight) noexcept
+		{
+			_weight = weight;
+		}
+
+		float MorphAnimation::getWeight() const noexcept
+		{
+			return _weight;
+		}
+
 		AnimationProperty::AnimationProperty() noexcept
 			: _frame(0)
 			, _fps(30)
@@ -115,6 +156,12 @@ namespace octoon
 			_boneAnimation.push_back(anim);
 		}
 
+		void AnimationProperty::setBoneAnimationArray(std::vector<BoneAnimation>&& anims) noexcept
+		{
+			_boneAnimation = std::move(anims);
+			this->bindAnimation();
+		}
+
 		BoneAnimation& AnimationProperty::getBoneAnimation(std::size_t index) noexcept
 		{
 			return _boneAnimation[index];
@@ -135,6 +182,11 @@ namespace octoon
 			_morphAnimation.push_back(anim);
 		}
 
+		void AnimationProperty::setMorphAnimationArray(std::vector<MorphAnimation>&& anims) noexcept
+		{
+			_morphAnimation = std::move(anims);
+		}
+
 		MorphAnimation& AnimationProperty::getMorphAnimation(std::size_t index) noexcept
 		{
 			return _morphAnimation[index];
@@ -170,11 +222,13 @@ namespace octoon
 		void AnimationProperty::setIKArray(const InverseKinematics& ik) noexcept
 		{
 			_iks = ik;
+			_solver.setIKArray(_iks);
 		}
 
 		void AnimationProperty::setIKArray(InverseKinematics&& ik) noexcept
 		{
 			_iks = std::move(ik);
+			_solver.setIKArray(_iks);
 		}
 
 		const InverseKinematics& AnimationProperty::getIKArray() const noexcept
@@ -205,84 +259,96 @@ namespace octoon
 
 		void AnimationProperty::updateMotion() noexcept
 		{
-			this->updateBoneMotion();
-			this->updateBoneMatrix();
-			this->updateIK();
+			this->samplePose(_pose);
+			this->applyPose(_pose);
 		}
 
 		void AnimationProperty::updateBones(const Bones& bones) noexcept
 		{
-			if (bones.empty())
-			{
-				_bindAnimation.clear();
-				return;
-			}
+			_pose.resize(bones.size());
+			_solver.setBoneArray(bones);
 
-			std::map<std::string, std::size_t> bindBoneMaps;
+			_boneIndices.clear();
 			for (std::size_t i = 0; i < bones.size(); i++)
-			{
-				bindBoneMaps[bones[i].getName()] = i + 1;
-			}
+				_boneIndices[bones[i].getName()] = i;
 
-			std::size_t numFrame = 0;
-			std::size_t numAnimation = this->getNumBoneAnimation();
+			this->bindAnimation();
+		}
 
-			for (std::size_t i = 0; i < numAnimation; i++)
-			{
-				numFrame = std::max((std::int32_t)numFrame, _boneAnimation[i].getFrameNo());
-			}
+		void AnimationProperty::bindAnimation() noexcept
+		{
+			_bindAnimation.clear();
+			_bindAnimation.resize(_bones.size());
 
-			_bindAnimation.resize(bones.size());
+			// Keys of one bone are usually stored next to each other (the VMD loader sorts them
+			// by bone and frame), so the name is only looked up when it changes. Keys take the
+			// index of their bone in the skeleton, -1 when it has none.
+			std::int32_t bone = -1;
 
-			for (std::size_t i = 0; i < numAnimation; i++)
+			for (std::size_t i = 0; i < _boneAnimation.size(); i++)
 			{
-				auto& name = _boneAnimation[i].getName();
-				auto& bone = bindBoneMaps[name];
-				if (bone > 0)
+				auto& anim = _boneAnimation[i];
+				if (i == 0 || anim.getName() != _boneAnimation[i - 1].getName())
 				{
-					_bindAnimation[bone - 1].push_back(i);
+					auto it = _boneIndices.find(anim.getName());
+					bone = it != _boneIndices.end() ? static_cast<std::int32_t>(it->second) : -1;
 				}
+
+				anim.setBoneIndex(bone);
+				if (bone >= 0)
+					_bindAnimation[bone].push_back(i);
+			}
+
+			for (auto& motions : _bindAnimation)
+			{
+				auto compare = [this](std::size_t a, std::size_t b) { return _boneAnimation[a].getFrameNo() < _boneAnimation[b].getFrameNo(); };
+				if (!std::is_sorted(motions.begin(), motions.end(), compare))
+					std::stable_sort(motions.begin(), motions.end(), compare);
 			}
 		}
 
-		bool AnimationProperty::updateBoneMotion(std::size_t index) noexcept
+		bool AnimationProperty::sampleBoneMotion(std::size_t index, std::size_t frame, float3& translate, Quaternion& rotate) noexcept
 		{
 			auto& bone = _bones[index];
 			const auto& motion = _bindAnimation[index];
-			if (motion.empty())
-			{
-				bone.setRotation(Quaternion::Zero);
 
-				if (bone.getParent() != (-1))
-				{
-					auto& parent = _bones[bone.getParent()];
-					auto position = (bone.getPosition() - parent.getPosition());
-					float4x4 m;
-					m.make_translate(position);
-					bone.setLocalTransform(m);
-				}
-				else
-				{
-					float4x4 m;
-					m.make_translate(bone.getPosition());
-					bone.setLocalTransform(m);
-				}
+			translate = bone.getPosition();
+			if (bone.getParent() != (-1))
+				translate -= _bones[bone.getParent()].getPosition();
 
+			if (motion.empty())
+			{
+				rotate = Quaternion::Zero;
 				return false;
 			}
 			else
 			{
 				Vector3 position;
-				Quaternion rotate;
-				this->interpolateMotion(rotate, position, motion, _frame);
+				this->interpolateMotion(rotate, position, motion, frame);
+				translate += position;
+				return true;
+			}
+		}
 
-				if (bone.getParent() == (-1))
-					updateTransform(bone, bone.getPosition() + position, rotate);
-				else
-					updateTransform(bone, bone.getPosition() + position - _bones[bone.getParent()].getPosition(), rotate);
+		bool AnimationProperty::updateBoneMotion(std::size_t index) noexcept
+		{
+			float3 translate;
+			Quaternion rotate;
 
+			if (this->sampleBoneMotion(index, _frame, translate, rotate))
+			{
+				updateTransform(_bones[index], translate, rotate);
 				return true;
 			}
+			else
+			{
+				float4x4 m;
+				m.make_translate(translate);
+
+				_bones[index].setRotation(rotate);
+				_bones[index].setLocalTransform(m);
+				return false;
+			}
 		}
 
 		void AnimationProperty::updateBoneMotion() noexcept
@@ -291,6 +357,51 @@ namespace octoon
 				this->updateBoneMotion(i);
 		}
 
+		void AnimationProperty::samplePose(Pose& pose) noexcept
+		{
+			this->samplePose(pose, _frame);
+		}
+
+		void AnimationProperty::samplePose(Pose& pose, std::size_t frame) noexcept
+		{
+			assert(pose.size() == _bones.size());
+
+			float3 translate;
+			Quaternion rotate;
+
+			for (std::size_t i = 0; i < _bones.size(); i++)
+			{
+				this->sampleBoneMotion(i, frame, translate, rotate);
+				pose.setTranslate(i, translate);
+				pose.setRotation(i, rotate);
+			}
+		}
+
+		void AnimationProperty::applyPose(const Pose& pose) noexcept
+		{
+			assert(pose.size() == _bones.size());
+
+			if (&pose != &_pose)
+				_pose.copy(pose);
+
+			_solver.solve(_pose);
+
+			for (std::size_t i = 0; i < _bones.size(); i++)
+				this->updateTransform(_bones[i], _pose.getTranslate(i), _pose.getRotation(i));
+
+			this->updateBoneMatrix();
+		}
+
+		IKSolver& AnimationProperty::getIKSolver() noexcept
+		{
+			return _solver;
+		}
+
+		const IKSolver& AnimationProperty::getIKSolver() const noexcept
+		{
+			return _solver;
+		}
+
 		void AnimationProperty::updateBoneMatrix() noexcept
 		{
 			std::size_t size = _bones.size();
@@ -320,63 +431,24 @@ namespace octoon
 
 		void AnimationProperty::updateIK() noexcept
 		{
-			for (auto& ik : _iks)
-				this->updateIK(_bones, ik);
-		}
-
-		void AnimationProperty::updateIK(Bones& bones, const IKAttr& ik) noexcept
-		{
-			auto& effector = bones.at(ik.boneIndex);
-			auto& target = bones.at(ik.targetBoneIndex);
-
-			const Vector3& effectPos = effector.getTransform().get_translate();
+			if (_iks.empty())
+				return;
 
-			for (std::uint32_t i = 0; i < ik.iterations; i++)
+			for (std::size_t i = 0; i < _bones.size(); i++)
 			{
-				for (std::uint32_t j = 0; j < ik.chainLength; j++)
-				{
-					auto& bone = bones[ik.child[j].boneIndex];
-
-					Vector3 targetPos = target.getTransform().get_translate();
-					if (math::distance(effectPos, targetPos) < EPSILON)
-						return;
-
-					Vector3 dstLocal = math::inv_translate_vector3(bone.getTransform(), targetPos);
-					Vector3 srcLocal = math::inv_translate_vector3(bone.getTransform(), effectPos);
-
-					srcLocal = math::normalize(srcLocal);
-					dstLocal = math::normalize(dstLocal);
-
-					float rotationDotProduct = math::dot(dstLocal, srcLocal);
-					float rotationAngle = math::safe_acos(rotationDotProduct) * ik.child[j].angleWeight;
-
-					if (rotationAngle < EPSILON_E5)
-						continue;
-
-					Vector3 rotationAxis = math::cross(dstLocal, srcLocal);
-					rotationAxis = math::normalize(rotationAxis);
-
-					Quaternion q0(rotationAxis, degress(rotationAngle));
-
-					if (ik.child[j].rotateLimited)
-					{
-						float3 euler(math::euler_angles(q0));
-						euler.x = std::min(ik.child[j].minimumDegrees.x, euler.x);
-						euler.y = std::min(ik.child[j].minimumDegrees.y, euler.y);
-						euler.z = std::min(ik.child[j].minimumDegrees.z, euler.z);
-						euler.x = std::max(ik.child[j].maximumDegrees.x, euler.x);
-						euler.y = std::max(ik.child[j].maximumDegrees.y, euler.y);
-						euler.z = std::max(ik.child[j].maximumDegrees.z, euler.z);
-
-						q0.make_rotation(euler);
-					}
+				_pose.setTranslate(i, _bones[i].getLocalTransform().get_translate());
+				_pose.setRotation(i, _bones[i].getRotation());
+			}
 
-					Quaternion qq = math::cross(bone.getRotation(), q0);
-					updateTransform(bone, bone.getLocalTransform().get_translate(), qq);
+			_solver.solve(_pose);
 
-					this->updateBoneMatrix(target);
-				}
+			for (std::size_t i = 0; i < _bones.size(); i++)
+			{
+				if (_pose.getRotation(i) != _bones[i].getRotation())
+					this->updateTransform(_bones[i], _pose.getTranslate(i), _pose.getRotation(i));
 			}
+
+			this->updateBoneMatrix();
 		}
 
 		void AnimationProperty::updateTransform(Bone& bone, const float3& translate, const Quaternion& rotate) noexcept
@@ -0,0 +1,336 @@
+#include <octoon/model/animation_blender.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+using namespace octoon::math;
+
+namespace octoon
+{
+	namespace model
+	{
+		namespace
+		{
+			void blendOverride(Pose& out, const Pose& in, const float* mask, float weight) noexcept
+			{
+				std::size_t i = 0;
+				std::size_t size = out.capacity();
+
+#if defined(__SSE2__)
+				const __m128 w = _mm_set1_ps(weight);
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 sign = _mm_set1_ps(-0.0f);
+
+				for (; i < size; i += 4)
+				{
+					__m128 t = _mm_mul_ps(w, _mm_loadu_ps(mask + i));
+
+					__m128 ax = _mm_loadu_ps(out.tx + i);
+					__m128 ay = _mm_loadu_ps(out.ty + i);
+					__m128 az = _mm_loadu_ps(out.tz + i);
+					_mm_storeu_ps(out.tx + i, _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in.tx + i), ax), t)));
+					_mm_storeu_ps(out.ty + i, _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in.ty + i), ay), t)));
+					_mm_storeu_ps(out.tz + i, _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in.tz + i), az), t)));
+
+					__m128 qx0 = _mm_loadu_ps(out.qx + i);
+					__m128 qy0 = _mm_loadu_ps(out.qy + i);
+					__m128 qz0 = _mm_loadu_ps(out.qz + i);
+					__m128 qw0 = _mm_loadu_ps(out.qw + i);
+					__m128 qx1 = _mm_loadu_ps(in.qx + i);
+					__m128 qy1 = _mm_loadu_ps(in.qy + i);
+					__m128 qz1 = _mm_loadu_ps(in.qz + i);
+					__m128 qw1 = _mm_loadu_ps(in.qw + i);
+
+					__m128 cosine = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx0, qx1), _mm_mul_ps(qy0, qy1)), _mm_add_ps(_mm_mul_ps(qz0, qz1), _mm_mul_ps(qw0, qw1)));
+					__m128 t0 = _mm_sub_ps(one, t);
+					__m128 t1 = _mm_xor_ps(t, _mm_and_ps(cosine, sign));
+
+					__m128 x = _mm_add_ps(_mm_mul_ps(qx0, t0), _mm_mul_ps(qx1, t1));
+					__m128 y = _mm_add_ps(_mm_mul_ps(qy0, t0), _mm_mul_ps(qy1, t1));
+					__m128 z = _mm_add_ps(_mm_mul_ps(qz0, t0), _mm_mul_ps(qz1, t1));
+					__m128 ww = _mm_add_ps(_mm_mul_ps(qw0, t0), _mm_mul_ps(qw1, t1));
+
+					__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(ww, ww))));
+					__m128 inv = _mm_div_ps(one, len);
+
+					_mm_storeu_ps(out.qx + i, _mm_mul_ps(x, inv));
+					_mm_storeu_ps(out.qy + i, _mm_mul_ps(y, inv));
+					_mm_storeu_ps(out.qz + i, _mm_mul_ps(z, inv));
+					_mm_storeu_ps(out.qw + i, _mm_mul_ps(ww, inv));
+				}
+#endif
+				for (; i < size; i++)
+				{
+					float t = weight * mask[i];
+
+					out.tx[i] += (in.tx[i] - out.tx[i]) * t;
+					out.ty[i] += (in.ty[i] - out.ty[i]) * t;
+					out.tz[i] += (in.tz[i] - out.tz[i]) * t;
+
+					float cosine = out.qx[i] * in.qx[i] + out.qy[i] * in.qy[i] + out.qz[i] * in.qz[i] + out.qw[i] * in.qw[i];
+					float t0 = 1.0f - t;
+					float t1 = cosine < 0.0f ? -t : t;
+
+					float x = out.qx[i] * t0 + in.qx[i] * t1;
+					float y = out.qy[i] * t0 + in.qy[i] * t1;
+					float z = out.qz[i] * t0 + in.qz[i] * t1;
+					float w = out.qw[i] * t0 + in.qw[i] * t1;
+					float inv = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+
+					out.qx[i] = x * inv;
+					out.qy[i] = y * inv;
+					out.qz[i] = z * inv;
+					out.qw[i] = w * inv;
+				}
+			}
+
+			void blendAdditive(Pose& out, const Pose& in, const Pose& reference, const float* mask, float weight) noexcept
+			{
+				std::size_t i = 0;
+				std::size_t size = out.capacity();
+
+#if defined(__SSE2__)
+				const __m128 w = _mm_set1_ps(weight);
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 sign = _mm_set1_ps(-0.0f);
+
+				for (; i < size; i += 4)
+				{
+					__m128 t = _mm_mul_ps(w, _mm_loadu_ps(mask + i));
+
+					_mm_storeu_ps(out.tx + i, _mm_add_ps(_mm_loadu_ps(out.tx + i), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in.tx + i), _mm_loadu_ps(reference.tx + i)), t)));
+					_mm_storeu_ps(out.ty + i, _mm_add_ps(_mm_loadu_ps(out.ty + i), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in.ty + i), _mm_loadu_ps(reference.ty + i)), t)));
+					_mm_storeu_ps(out.tz + i, _mm_add_ps(_mm_loadu_ps(out.tz + i), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in.tz + i), _mm_loadu_ps(reference.tz + i)), t)));
+
+					// delta = conjugate(reference) * in
+					__m128 rx = _mm_xor_ps(_mm_loadu_ps(reference.qx + i), sign);
+					__m128 ry = _mm_xor_ps(_mm_loadu_ps(reference.qy + i), sign);
+					__m128 rz = _mm_xor_ps(_mm_loadu_ps(reference.qz + i), sign);
+					__m128 rw = _mm_loadu_ps(reference.qw + i);
+					__m128 bx = _mm_loadu_ps(in.qx + i);
+					__m128 by = _mm_loadu_ps(in.qy + i);
+					__m128 bz = _mm_loadu_ps(in.qz + i);
+					__m128 bw = _mm_loadu_ps(in.qw + i);
+
+					__m128 dx = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rw, bx), _mm_mul_ps(rx, bw)), _mm_mul_ps(ry, bz)), _mm_mul_ps(rz, by));
+					__m128 dy = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rw, by), _mm_mul_ps(ry, bw)), _mm_mul_ps(rz, bx)), _mm_mul_ps(rx, bz));
+					__m128 dz = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rw, bz), _mm_mul_ps(rz, bw)), _mm_mul_ps(rx, by)), _mm_mul_ps(ry, bx));
+					__m128 dw = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(rw, bw), _mm_mul_ps(rx, bx)), _mm_mul_ps(ry, by)), _mm_mul_ps(rz, bz));
+
+					// nlerp(identity, delta, t)
+					__m128 t1 = _mm_xor_ps(t, _mm_and_ps(dw, sign));
+					dx = _mm_mul_ps(dx, t1);
+					dy = _mm_mul_ps(dy, t1);
+					dz = _mm_mul_ps(dz, t1);
+					dw = _mm_add_ps(_mm_sub_ps(one, t), _mm_mul_ps(dw, t1));
+
+					__m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_add_ps(_mm_mul_ps(dz, dz), _mm_mul_ps(dw, dw)))));
+					dx = _mm_mul_ps(dx, inv);
+					dy = _mm_mul_ps(dy, inv);
+					dz = _mm_mul_ps(dz, inv);
+					dw = _mm_mul_ps(dw, inv);
+
+					// out = out * delta
+					__m128 ax = _mm_loadu_ps(out.qx + i);
+					__m128 ay = _mm_loadu_ps(out.qy + i);
+					__m128 az = _mm_loadu_ps(out.qz + i);
+					__m128 aw = _mm_loadu_ps(out.qw + i);
+
+					_mm_storeu_ps(out.qx + i, _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, dx), _mm_mul_ps(ax, dw)), _mm_mul_ps(ay, dz)), _mm_mul_ps(az, dy)));
+					_mm_storeu_ps(out.qy + i, _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, dy), _mm_mul_ps(ay, dw)), _mm_mul_ps(az, dx)), _mm_mul_ps(ax, dz)));
+					_mm_storeu_ps(out.qz + i, _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, dz), _mm_mul_ps(az, dw)), _mm_mul_ps(ax, dy)), _mm_mul_ps(ay, dx)));
+					_mm_storeu_ps(out.qw + i, _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(aw, dw), _mm_mul_ps(ax, dx)), _mm_mul_ps(ay, dy)), _mm_mul_ps(az, dz)));
+				}
+#endif
+				for (; i < size; i++)
+				{
+					float t = weight * mask[i];
+
+					out.tx[i] += (in.tx[i] - reference.tx[i]) * t;
+					out.ty[i] += (in.ty[i] - reference.ty[i]) * t;
+					out.tz[i] += (in.tz[i] - reference.tz[i]) * t;
+
+					Quaternion delta = math::cross(conjugate(reference.getRotation(i)), in.getRotation(i));
+					float t1 = delta.w < 0.0f ? -t : t;
+					delta = math::normalize(Quaternion(delta.x * t1, delta.y * t1, delta.z * t1, (1.0f - t) + delta.w * t1));
+
+					out.setRotation(i, math::cross(out.getRotation(i), delta));
+				}
+			}
+		}
+
+		AnimationBlender::AnimationBlender() noexcept
+		{
+		}
+
+		AnimationBlender::~AnimationBlender() noexcept
+		{
+			this->clearLayers();
+		}
+
+		void AnimationBlender::setBoneArray(const Bones& bones) noexcept
+		{
+			this->clearLayers();
+
+			_bones = bones;
+			_pool.clear();
+			_pool.reserve(4, bones.size());
+			_finalPose.resize(bones.size());
+			_restPose.resize(bones.size());
+
+			for (std::size_t i = 0; i < bones.size(); i++)
+			{
+				auto translate = bones[i].getPosition();
+				if (bones[i].getParent() != (-1))
+					translate -= bones[bones[i].getParent()].getPosition();
+
+				_restPose.setTranslate(i, translate);
+			}
+		}
+
+		const Bones& AnimationBlender::getBoneArray() const noexcept
+		{
+			return _bones;
+		}
+
+		std::size_t AnimationBlender::addLayer(const AnimationPropertyPtr& clip, AnimationBlendMode mode, float weight) noexcept
+		{
+			assert(clip);
+
+			if (clip->getBoneArray().size() != _bones.size())
+				clip->setBoneArray(_bones);
+
+			AnimationLayer layer;
+			layer.clip = clip;
+			layer.mode = mode;
+			layer.weight = weight;
+			layer.mask.resize(_finalPose.capacity(), 0.0f);
+			layer.reference = nullptr;
+
+			std::fill(layer.mask.begin(), layer.mask.begin() + _bones.size(), 1.0f);
+
+			if (mode == AnimationBlendMode::Additive)
+			{
+				layer.reference = _pool.alloc();
+				clip->samplePose(*layer.reference, 0);
+			}
+
+			_layers.push_back(std::move(layer));
+
+			_pool.reserve(_layers.size() * 2 + 1, _bones.size());
+
+			return _layers.size() - 1;
+		}
+
+		void AnimationBlender::removeLayer(std::size_t index) noexcept
+		{
+			assert(index < _layers.size());
+
+			if (_layers[index].reference)
+				_pool.free(_layers[index].reference);
+
+			_layers.erase(_layers.begin() + index);
+		}
+
+		void AnimationBlender::clearLayers() noexcept
+		{
+			for (auto& layer : _layers)
+			{
+				if (layer.reference)
+					_pool.free(layer.reference);
+			}
+
+			_layers.clear();
+		}
+
+		AnimationLayer& AnimationBlender::getLayer(std::size_t index) noexcept
+		{
+			return _layers[index];
+		}
+
+		const AnimationLayer& AnimationBlender::getLayer(std::size_t index) const noexcept
+		{
+			return _layers[index];
+		}
+
+		std::size_t AnimationBlender::getNumLayers() const noexcept
+		{
+			return _layers.size();
+		}
+
+		void AnimationBlender::setLayerWeight(std::size_t index, float weight) noexcept
+		{
+			_layers[index].weight = weight;
+		}
+
+		float AnimationBlender::getLayerWeight(std::size_t index) const noexcept
+		{
+			return _layers[index].weight;
+		}
+
+		void AnimationBlender::setLayerMask(std::size_t index, const std::vector<float>& mask) noexcept
+		{
+			auto& layer = _layers[index];
+			std::fill(layer.mask.begin(), layer.mask.end(), 0.0f);
+			std::copy(mask.begin(), mask.begin() + std::min(mask.size(), _bones.size()), layer.mask.begin());
+		}
+
+		void AnimationBlender::setLayerMask(std::size_t index, const std::vector<std::size_t>& bones, float weight) noexcept
+		{
+			auto& layer = _layers[index];
+			std::fill(layer.mask.begin(), layer.mask.end(), 0.0f);
+
+			for (auto bone : bones)
+			{
+				if (bone < _bones.size())
+					layer.mask[bone] = weight;
+			}
+		}
+
+		void AnimationBlender::clearLayerMask(std::size_t index) noexcept
+		{
+			auto& layer = _layers[index];
+			std::fill(layer.mask.begin(), layer.mask.end(), 0.0f);
+			std::fill(layer.mask.begin(), layer.mask.begin() + _bones.size(), 1.0f);
+		}
+
+		void AnimationBlender::updateFrame(float delta) noexcept
+		{
+			for (auto& layer : _layers)
+				layer.clip->updateFrame(delta);
+		}
+
+		const Pose& AnimationBlender::evaluate() noexcept
+		{
+			_finalPose.copy(_restPose);
+
+			Pose* pose = _pool.alloc();
+
+			for (auto& layer : _layers)
+			{
+				if (layer.weight <= 0.0f)
+					continue;
+
+				layer.clip->samplePose(*pose);
+
+				if (layer.mode == AnimationBlendMode::Additive)
+					blendAdditive(_finalPose, *pose, *layer.reference, layer.mask.data(), layer.weight);
+				else
+					blendOverride(_finalPose, *pose, layer.mask.data(), std::min(layer.weight, 1.0f));
+			}
+
+			_pool.free(pose);
+
+			return _finalPose;
+		}
+
+		void AnimationBlender::apply(AnimationProperty& target) noexcept
+		{
+			target.applyPose(this->evaluate());
+		}
+	}
+}
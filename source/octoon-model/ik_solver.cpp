@@ -0,0 +1,331 @@
+#include <octoon/model/ik_solver.h>
+#include <octoon/runtime/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace octoon::math;
+
+namespace octoon
+{
+	namespace model
+	{
+		namespace
+		{
+			Quaternion clampRotation(const Quaternion& rotation, const float3& minimumDegrees, const float3& maximumDegrees) noexcept
+			{
+				Quaternion q = rotation.w < 0.0f ? -rotation : rotation;
+
+				const float3 lower = minimumDegrees;
+				const float3 upper = maximumDegrees;
+
+				q.x = math::clamp(q.x, std::sin(radians(std::min(lower.x, upper.x)) * 0.5f), std::sin(radians(std::max(lower.x, upper.x)) * 0.5f));
+				q.y = math::clamp(q.y, std::sin(radians(std::min(lower.y, upper.y)) * 0.5f), std::sin(radians(std::max(lower.y, upper.y)) * 0.5f));
+				q.z = math::clamp(q.z, std::sin(radians(std::min(lower.z, upper.z)) * 0.5f), std::sin(radians(std::max(lower.z, upper.z)) * 0.5f));
+				q.w = std::sqrt(std::max(0.0f, 1.0f - q.x * q.x - q.y * q.y - q.z * q.z));
+
+				return math::normalize(q);
+			}
+		}
+
+		IKSolver::IKSolver() noexcept
+			: _parallel(true)
+			, _tolerance(EPSILON)
+		{
+		}
+
+		IKSolver::~IKSolver() noexcept
+		{
+		}
+
+		void IKSolver::setBoneArray(const Bones& bones) noexcept
+		{
+			_parents.resize(bones.size());
+			for (std::size_t i = 0; i < bones.size(); i++)
+				_parents[i] = bones[i].getParent();
+
+			_worldPosition.resize(bones.size());
+			_worldRotation.resize(bones.size());
+
+			this->build();
+		}
+
+		void IKSolver::setIKArray(const InverseKinematics& iks) noexcept
+		{
+			_iks = iks;
+			this->build();
+		}
+
+		void IKSolver::setTolerance(float tolerance) noexcept
+		{
+			_tolerance = tolerance;
+		}
+
+		float IKSolver::getTolerance() const noexcept
+		{
+			return _tolerance;
+		}
+
+		void IKSolver::setParallelEnable(bool enable) noexcept
+		{
+			_parallel = enable;
+		}
+
+		bool IKSolver::getParallelEnable() const noexcept
+		{
+			return _parallel;
+		}
+
+		std::size_t IKSolver::getNumStages() const noexcept
+		{
+			return _stages.size();
+		}
+
+		const std::vector<IKChainStats>& IKSolver::getChainStats() const noexcept
+		{
+			return _stats;
+		}
+
+		bool IKSolver::isAncestor(std::size_t ancestor, std::size_t bone) const noexcept
+		{
+			while (bone < _parents.size())
+			{
+				if (bone == ancestor)
+					return true;
+				bone = static_cast<std::size_t>(_parents[bone]);
+			}
+
+			return false;
+		}
+
+		void IKSolver::build() noexcept
+		{
+			_chains.clear();
+			_stages.clear();
+
+			for (auto& ik : _iks)
+			{
+				if (ik.boneIndex >= _parents.size() || ik.targetBoneIndex >= _parents.size() || ik.child.empty())
+					continue;
+
+				Chain chain;
+				chain.attr = ik;
+				chain.stage = 0;
+
+				std::size_t top = ik.child.front().boneIndex;
+				for (auto& link : ik.child)
+				{
+					if (link.boneIndex < _parents.size() && this->isAncestor(link.boneIndex, top))
+						top = link.boneIndex;
+				}
+
+				for (std::size_t bone = ik.targetBoneIndex; bone < _parents.size(); bone = static_cast<std::size_t>(_parents[bone]))
+				{
+					chain.path.push_back(bone);
+					if (bone == top)
+						break;
+				}
+
+				if (chain.path.back() != top)
+					continue;
+
+				std::reverse(chain.path.begin(), chain.path.end());
+
+				bool valid = true;
+				for (auto& link : ik.child)
+				{
+					auto it = std::find(chain.path.begin(), chain.path.end(), link.boneIndex);
+					if (it == chain.path.end() || *it == ik.targetBoneIndex)
+					{
+						valid = false;
+						break;
+					}
+
+					chain.links.push_back(std::distance(chain.path.begin(), it));
+				}
+
+				if (!valid)
+					continue;
+
+				chain.first = top;
+
+				for (auto& it : chain.path)
+					chain.first = std::min(chain.first, it);
+
+				_chains.push_back(std::move(chain));
+			}
+
+			auto dependsOn = [this](const Chain& a, const Chain& b)
+			{
+				for (auto link : a.links)
+				{
+					if (this->isAncestor(a.path[link], b.attr.boneIndex))
+						return true;
+
+					for (auto bone : b.path)
+					{
+						if (this->isAncestor(a.path[link], bone))
+							return true;
+					}
+				}
+
+				return false;
+			};
+
+			for (std::size_t i = 0; i < _chains.size(); i++)
+			{
+				for (std::size_t j = 0; j < i; j++)
+				{
+					if (dependsOn(_chains[j], _chains[i]) || dependsOn(_chains[i], _chains[j]))
+						_chains[i].stage = std::max(_chains[i].stage, _chains[j].stage + 1);
+				}
+
+				if (_stages.size() <= _chains[i].stage)
+					_stages.resize(_chains[i].stage + 1);
+
+				_stages[_chains[i].stage].push_back(i);
+			}
+
+			_stats.resize(_chains.size());
+		}
+
+		void IKSolver::updateWorld(const Pose& pose, std::size_t first) noexcept
+		{
+			for (std::size_t i = first; i < _parents.size(); i++)
+			{
+				Quaternion rotation = pose.getRotation(i);
+				float3 translate = pose.getTranslate(i);
+
+				std::size_t parent = static_cast<std::size_t>(_parents[i]);
+				if (parent < i)
+				{
+					_worldRotation[i] = math::cross(_worldRotation[parent], rotation);
+					_worldPosition[i] = _worldPosition[parent] + math::rotate(_worldRotation[parent], translate);
+				}
+				else
+				{
+					_worldRotation[i] = rotation;
+					_worldPosition[i] = translate;
+				}
+			}
+		}
+
+		void IKSolver::solveChain(Pose& pose, const Chain& chain, IKChainStats& stats) noexcept
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+
+			const auto& ik = chain.attr;
+			const float3 goal = _worldPosition[ik.boneIndex];
+
+			stats.iterations = 0;
+			stats.converged = false;
+
+			for (std::uint32_t i = 0; i < ik.iterations && !stats.converged; i++)
+			{
+				float rotated = 0.0f;
+
+				for (std::size_t j = 0; j < chain.links.size(); j++)
+				{
+					const float3& effector = _worldPosition[ik.targetBoneIndex];
+					if (math::distance(effector, goal) < _tolerance)
+					{
+						stats.converged = true;
+						break;
+					}
+
+					const auto& link = ik.child[j];
+					const std::size_t p = chain.links[j];
+					const std::size_t bone = chain.path[p];
+
+					Quaternion inv = math::conjugate(_worldRotation[bone]);
+					float3 src = math::normalize(math::rotate(inv, effector - _worldPosition[bone]));
+					float3 dst = math::normalize(math::rotate(inv, goal - _worldPosition[bone]));
+
+					// The angle from both sine and cosine stays precise for the small steps close to the goal.
+					float3 axis = math::cross(src, dst);
+					float sine = math::length(axis);
+					if (sine < EPSILON_E6)
+						continue;
+
+					float angle = std::atan2(sine, math::dot(src, dst)) * link.angleWeight;
+					if (angle < EPSILON_E5)
+						continue;
+
+					Quaternion rotation = math::cross(pose.getRotation(bone), Quaternion(axis / sine, angle));
+					if (link.rotateLimited)
+						rotation = clampRotation(rotation, link.minimumDegrees, link.maximumDegrees);
+					else
+						rotation = math::normalize(rotation);
+
+					pose.setRotation(bone, rotation);
+					rotated = std::max(rotated, angle);
+
+					for (std::size_t k = p; k < chain.path.size(); k++)
+					{
+						std::size_t it = chain.path[k];
+						std::size_t parent = static_cast<std::size_t>(_parents[it]);
+
+						if (parent < _parents.size())
+						{
+							_worldRotation[it] = math::cross(_worldRotation[parent], pose.getRotation(it));
+							_worldPosition[it] = _worldPosition[parent] + math::rotate(_worldRotation[parent], pose.getTranslate(it));
+						}
+						else
+						{
+							_worldRotation[it] = pose.getRotation(it);
+							_worldPosition[it] = pose.getTranslate(it);
+						}
+					}
+				}
+
+				stats.iterations++;
+
+				if (rotated < EPSILON_E5)
+					break;
+			}
+
+			if (!stats.converged)
+				stats.converged = math::distance(_worldPosition[ik.targetBoneIndex], goal) < _tolerance;
+
+			auto end = std::chrono::high_resolution_clock::now();
+			stats.time = std::chrono::duration<float, std::milli>(end - start).count();
+		}
+
+		void IKSolver::solve(Pose& pose) noexcept
+		{
+			assert(pose.size() == _parents.size());
+
+			if (_chains.empty())
+				return;
+
+			this->updateWorld(pose, 0);
+
+			for (auto& stage : _stages)
+			{
+				if (_parallel && stage.size() > 1)
+				{
+					runtime::ThreadPool::instance()->parallel_for(0, stage.size(), 1, [&](std::size_t begin, std::size_t end)
+					{
+						for (std::size_t i = begin; i < end; i++)
+							this->solveChain(pose, _chains[stage[i]], _stats[stage[i]]);
+					});
+				}
+				else
+				{
+					for (auto i : stage)
+						this->solveChain(pose, _chains[i], _stats[i]);
+				}
+
+				if (&stage != &_stages.back())
+				{
+					std::size_t dirty = _parents.size();
+					for (auto i : stage)
+						dirty = std::min(dirty, _chains[i].first);
+
+					this->updateWorld(pose, dirty);
+				}
+			}
+		}
+	}
+}
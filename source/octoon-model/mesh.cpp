@@ -1345,5 +1345,17 @@ namespace octoon
 			else
 				_boundingBox.encapsulate(_vertices.data(), _indices.data(), _indices.size());
 		}
+	
+		void
+		Mesh::remapTexcoordArray(const float4& rect, std::uint8_t n) noexcept
+		{
+			assert(n < TEXTURE_ARRAY_COUNT);
+
+			float2 offset(rect.x, rect.y);
+			float2 scale(rect.z - rect.x, rect.w - rect.y);
+
+			for (auto& it : _texcoords[n])
+				it = offset + it * scale;
+		}
 	}
 }
\ No newline at end of file
@@ -7,11 +7,17 @@ namespace octoon
 #if OCTOON_BUILD_PMX_MODEL
 		std::shared_ptr<ModelLoader> pmxLoader = std::make_shared<PmxLoader>();
 #endif
+#if OCTOON_BUILD_VMD_MODEL
+		std::shared_ptr<ModelLoader> vmdLoader = std::make_shared<VmdLoader>();
+#endif
 
 		void addModelLoaderFor(Model& model)
 		{
 #if OCTOON_BUILD_PMX_MODEL
 			model.addLoader(pmxLoader);
+#endif
+#if OCTOON_BUILD_VMD_MODEL
+			model.addLoader(vmdLoader);
 #endif
 		}
 	}
@@ -16,7 +16,7 @@ namespace octoon
 			this->clear();
 		}
 
-		bool Model::load(fstream& file, const char* type) noexcept
+		bool Model::load(istream& file, const char* type) noexcept
 		{
 			if (emptyLoader())
 				addModelLoaderFor(*this);
@@ -49,6 +49,7 @@ namespace octoon
 			_animations.clear();
 			_lights.clear();
 			_cameras.clear();
+			_morphs.clear();
 		}
 
 		void Model::addMesh(MeshPtr& mesh) noexcept
@@ -101,6 +102,11 @@ namespace octoon
 			_cameras.push_back(camera);
 		}
 
+		void Model::addMorph(MorphPtr& morph) noexcept
+		{
+			_morphs.push_back(morph);
+		}
+
 		void Model::addMesh(MeshPtr&& mesh) noexcept
 		{
 			_meshes.push_back(std::move(mesh));
@@ -151,6 +157,11 @@ namespace octoon
 			_cameras.push_back(std::move(camera));
 		}
 
+		void Model::addMorph(MorphPtr&& morph) noexcept
+		{
+			_morphs.push_back(std::move(morph));
+		}
+
 		Model::MeshList& Model::getMeshsList() noexcept
 		{
 			return _meshes;
@@ -201,6 +212,11 @@ namespace octoon
 			return _cameras;
 		}
 
+		Model::MorphList& Model::getMorphList() noexcept
+		{
+			return _morphs;
+		}
+
 		const std::string& Model::getName() const noexcept
 		{
 			return _name;
@@ -266,6 +282,11 @@ namespace octoon
 			return _cameras;
 		}
 
+		const Model::MorphList& Model::getMorphList() const noexcept
+		{
+			return _morphs;
+		}
+
 		bool Model::hasMeshes() const noexcept
 		{
 			return !_meshes.empty();
@@ -306,6 +327,11 @@ namespace octoon
 			return !_animations.empty();
 		}
 
+		bool Model::hasMorphs() const noexcept
+		{
+			return !_morphs.empty();
+		}
+
 		void Model::applyProcess(int) noexcept
 		{
 		}
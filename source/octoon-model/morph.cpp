@@ -0,0 +1,72 @@
+#include <octoon/model/morph.h>
+
+namespace octoon
+{
+	namespace model
+	{
+		Morph::Morph() noexcept
+			: _type(MorphType::Vertex)
+		{
+		}
+
+		Morph::Morph(const std::string& name, MorphType type) noexcept
+			: _name(name)
+			, _type(type)
+		{
+		}
+
+		Morph::~Morph() noexcept
+		{
+		}
+
+		void Morph::setName(const std::string& name) noexcept
+		{
+			_name = name;
+		}
+
+		const std::string& Morph::getName() const noexcept
+		{
+			return _name;
+		}
+
+		void Morph::setType(MorphType type) noexcept
+		{
+			_type = type;
+		}
+
+		MorphType Morph::getType() const noexcept
+		{
+			return _type;
+		}
+
+		void Morph::setTargetArray(const std::vector<MorphTarget>& targets) noexcept
+		{
+			_targets = targets;
+		}
+
+		void Morph::setTargetArray(std::vector<MorphTarget>&& targets) noexcept
+		{
+			_targets = std::move(targets);
+		}
+
+		const std::vector<MorphTarget>& Morph::getTargetArray() const noexcept
+		{
+			return _targets;
+		}
+
+		void Morph::setGroupArray(const std::vector<MorphGroup>& groups) noexcept
+		{
+			_groups = groups;
+		}
+
+		void Morph::setGroupArray(std::vector<MorphGroup>&& groups) noexcept
+		{
+			_groups = std::move(groups);
+		}
+
+		const std::vector<MorphGroup>& Morph::getGroupArray() const noexcept
+		{
+			return _groups;
+		}
+	}
+}
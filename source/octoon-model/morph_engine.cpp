@@ -0,0 +1,262 @@
+#include <octoon/model/morph_engine.h>
+#include <octoon/runtime/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+using namespace octoon::math;
+
+namespace octoon
+{
+	namespace model
+	{
+		namespace
+		{
+			constexpr std::size_t MORPH_GRAIN_SIZE = 4096;
+
+			// Adds weight * offsets[j] to out[indices[j]] for every index inside [first, last).
+			// The SSE path loads four floats starting at x and multiplies the fourth lane by zero,
+			// it is only taken when the next element exists and belongs to the same range so
+			// neither the read past the end nor the write to the neighbour can cross a thread.
+			void accumulate(float3* out, const Uint1Array& indices, const float3s& offsets, float weight, std::size_t first, std::size_t last) noexcept
+			{
+				auto begin = std::lower_bound(indices.begin(), indices.end(), first);
+
+				std::size_t j = std::distance(indices.begin(), begin);
+				std::size_t count = indices.size();
+
+#if defined(__SSE2__)
+				const __m128 w = _mm_set_ps(0.0f, weight, weight, weight);
+
+				for (; j + 1 < count && indices[j + 1] < last; j++)
+				{
+					float* dst = &out[indices[j]].x;
+					__m128 d = _mm_loadu_ps(&offsets[j].x);
+					_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(d, w)));
+				}
+#endif
+				for (; j < count && indices[j] < last; j++)
+					out[indices[j]] += offsets[j] * weight;
+			}
+		}
+
+		MorphEngine::MorphEngine() noexcept
+			: _parallel(true)
+		{
+		}
+
+		MorphEngine::~MorphEngine() noexcept
+		{
+		}
+
+		void MorphEngine::setMorphArray(const Morphs& morphs) noexcept
+		{
+			_morphs = morphs;
+
+			_weights.assign(_morphs.size(), 0.0f);
+			_leafWeights.assign(_morphs.size(), 0.0f);
+			_flatten.resize(_morphs.size());
+			_names.clear();
+			_meshTargets.clear();
+			_active.clear();
+
+			std::vector<bool> visited(_morphs.size(), false);
+
+			for (std::size_t i = 0; i < _morphs.size(); i++)
+			{
+				_names.emplace(_morphs[i]->getName(), i);
+
+				std::vector<std::pair<std::size_t, float>> leaves;
+				this->flatten(i, 1.0f, visited, leaves);
+
+				std::sort(leaves.begin(), leaves.end());
+
+				_flatten[i].clear();
+
+				for (auto& it : leaves)
+				{
+					if (!_flatten[i].empty() && _flatten[i].back().first == it.first)
+						_flatten[i].back().second += it.second;
+					else
+						_flatten[i].push_back(it);
+				}
+
+				for (auto& target : _morphs[i]->getTargetArray())
+				{
+					if (_meshTargets.size() <= target.mesh)
+						_meshTargets.resize(target.mesh + 1);
+
+					_meshTargets[target.mesh].emplace_back(i, &target);
+				}
+			}
+
+			_active.resize(_meshTargets.size());
+		}
+
+		std::size_t MorphEngine::getNumMorphs() const noexcept
+		{
+			return _morphs.size();
+		}
+
+		std::size_t MorphEngine::findMorph(const std::string& name) const noexcept
+		{
+			auto it = _names.find(name);
+			if (it != _names.end())
+				return it->second;
+			return _morphs.size();
+		}
+
+		void MorphEngine::setWeight(std::size_t index, float weight) noexcept
+		{
+			assert(index < _weights.size());
+			_weights[index] = weight;
+		}
+
+		float MorphEngine::getWeight(std::size_t index) const noexcept
+		{
+			assert(index < _weights.size());
+			return _weights[index];
+		}
+
+		void MorphEngine::clearWeights() noexcept
+		{
+			std::fill(_weights.begin(), _weights.end(), 0.0f);
+		}
+
+		void MorphEngine::setParallelEnable(bool enable) noexcept
+		{
+			_parallel = enable;
+		}
+
+		bool MorphEngine::getParallelEnable() const noexcept
+		{
+			return _parallel;
+		}
+
+		void MorphEngine::flatten(std::size_t index, float weight, std::vector<bool>& visited, std::vector<std::pair<std::size_t, float>>& out) const noexcept
+		{
+			auto& morph = _morphs[index];
+			if (morph->getType() != MorphType::Group)
+			{
+				out.emplace_back(index, weight);
+				return;
+			}
+
+			// Groups referencing themselves through other groups are ignored.
+			if (visited[index])
+				return;
+
+			visited[index] = true;
+
+			for (auto& it : morph->getGroupArray())
+			{
+				if (it.morph < _morphs.size())
+					this->flatten(it.morph, weight * it.weight, visited, out);
+			}
+
+			visited[index] = false;
+		}
+
+		void MorphEngine::update() noexcept
+		{
+			std::fill(_leafWeights.begin(), _leafWeights.end(), 0.0f);
+
+			for (std::size_t i = 0; i < _weights.size(); i++)
+			{
+				float weight = _weights[i];
+				if (weight == 0.0f)
+					continue;
+
+				for (auto& it : _flatten[i])
+					_leafWeights[it.first] += it.second * weight;
+			}
+
+			for (std::size_t i = 0; i < _meshTargets.size(); i++)
+			{
+				_active[i].clear();
+
+				for (auto& it : _meshTargets[i])
+				{
+					float weight = _leafWeights[it.first];
+					if (std::abs(weight) > EPSILON_E6)
+						_active[i].push_back(Active{ it.second, weight });
+				}
+			}
+		}
+
+		std::size_t MorphEngine::getNumActive() const noexcept
+		{
+			std::size_t count = 0;
+			for (auto& it : _active)
+				count += it.size();
+			return count;
+		}
+
+		std::size_t MorphEngine::getNumActive(std::size_t mesh) const noexcept
+		{
+			return mesh < _active.size() ? _active[mesh].size() : 0;
+		}
+
+		void MorphEngine::evaluate(std::size_t mesh, const float3s& vertices, const float3s& normals, float3s& outVertices, float3s& outNormals) noexcept
+		{
+			outVertices = vertices;
+			outNormals = normals;
+
+			if (mesh >= _active.size() || _active[mesh].empty())
+				return;
+
+			auto& active = _active[mesh];
+
+			auto func = [&](std::size_t first, std::size_t last)
+			{
+				for (auto& it : active)
+				{
+					auto target = it.target;
+					if (!target->offsets.empty() && !outVertices.empty())
+						accumulate(outVertices.data(), target->indices, target->offsets, it.weight, first, last);
+					if (!target->normals.empty() && !outNormals.empty())
+						accumulate(outNormals.data(), target->indices, target->normals, it.weight, first, last);
+				}
+			};
+
+			if (_parallel)
+				runtime::ThreadPool::instance()->parallel_for(0, vertices.size(), MORPH_GRAIN_SIZE, func);
+			else
+				func(0, vertices.size());
+
+			if (!outNormals.empty())
+			{
+				for (auto& it : active)
+				{
+					if (it.target->normals.empty())
+						continue;
+
+					for (auto index : it.target->indices)
+						outNormals[index] = math::normalize(outNormals[index]);
+				}
+			}
+		}
+
+		void MorphEngine::evaluate(std::size_t mesh, const float2s& texcoords, float2s& outTexcoords) noexcept
+		{
+			outTexcoords = texcoords;
+
+			if (mesh >= _active.size())
+				return;
+
+			for (auto& it : _active[mesh])
+			{
+				auto target = it.target;
+				if (target->texcoords.empty())
+					continue;
+
+				for (std::size_t j = 0; j < target->indices.size(); j++)
+					outTexcoords[target->indices[j]] += target->texcoords[j] * it.weight;
+			}
+		}
+	}
+}
@@ -4,11 +4,15 @@
 #include <octoon/model/mesh.h>
 #include <octoon/model/property.h>
 #include <octoon/model/model.h>
+#include <octoon/model/morph.h>
 
 #include <octoon/math/mathfwd.h>
 #include <octoon/math/mathutil.h>
 
+#include <octoon/runtime/thread_pool.h>
+
 #include <cstring>
+#include <algorithm>
 
 using namespace octoon::io;
 using namespace octoon::math;
@@ -17,6 +21,151 @@ namespace octoon
 {
 	namespace model
 	{
+		namespace
+		{
+			constexpr std::size_t PMX_VERTEX_CHUNK_SIZE = 4096;
+
+			// Bounds checked reader over the whole file kept in memory, it replaces one
+			// istream::read per field with plain memcpy.
+			class PmxReader
+			{
+			public:
+				PmxReader(const std::uint8_t* data, std::size_t size) noexcept
+					: _data(data)
+					, _size(size)
+					, _offset(0)
+				{
+				}
+
+				std::size_t tell() const noexcept
+				{
+					return _offset;
+				}
+
+				void seek(std::size_t offset) noexcept
+				{
+					_offset = offset;
+				}
+
+				bool skip(std::size_t size) noexcept
+				{
+					if (_size - _offset < size)
+						return false;
+					_offset += size;
+					return true;
+				}
+
+				template<typename T>
+				bool read(T& value) noexcept
+				{
+					if (_size - _offset < sizeof(T))
+						return false;
+					std::memcpy(&value, _data + _offset, sizeof(T));
+					_offset += sizeof(T);
+					return true;
+				}
+
+				bool readIndex(std::int32_t& value, std::uint8_t size) noexcept
+				{
+					switch (size)
+					{
+					case 1: { std::int8_t v; if (!this->read(v)) return false; value = v; return true; }
+					case 2: { std::int16_t v; if (!this->read(v)) return false; value = v; return true; }
+					case 4: { std::int32_t v; if (!this->read(v)) return false; value = v; return true; }
+					default:
+						return false;
+					}
+				}
+
+				bool readVertexIndex(std::uint32_t& value, std::uint8_t size) noexcept
+				{
+					switch (size)
+					{
+					case 1: { std::uint8_t v; if (!this->read(v)) return false; value = v; return true; }
+					case 2: { std::uint16_t v; if (!this->read(v)) return false; value = v; return true; }
+					case 4: { std::uint32_t v; if (!this->read(v)) return false; value = v; return true; }
+					default:
+						return false;
+					}
+				}
+
+				bool skipText() noexcept
+				{
+					PmxUInt32 length;
+					if (!this->read(length))
+						return false;
+					return this->skip(length);
+				}
+
+				bool readText(std::string& text, PmxUInt8 encode) noexcept
+				{
+					PmxUInt32 length;
+					if (!this->read(length))
+						return false;
+
+					if (_size - _offset < length)
+						return false;
+
+					const std::uint8_t* data = _data + _offset;
+					_offset += length;
+
+					text.clear();
+
+					if (encode != 0)
+					{
+						text.assign((const char*)data, length);
+						return true;
+					}
+
+					text.reserve(length);
+
+					for (std::size_t i = 0; i + 1 < length; i += 2)
+					{
+						std::uint32_t ch = data[i] | (data[i + 1] << 8);
+						if (ch >= 0xD800 && ch < 0xDC00 && i + 3 < length)
+						{
+							std::uint32_t low = data[i + 2] | (data[i + 3] << 8);
+							if (low >= 0xDC00 && low < 0xE000)
+							{
+								ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+								i += 2;
+							}
+						}
+
+						if (ch < 0x80)
+						{
+							text.push_back((char)ch);
+						}
+						else if (ch < 0x800)
+						{
+							text.push_back((char)(0xC0 | (ch >> 6)));
+							text.push_back((char)(0x80 | (ch & 0x3F)));
+						}
+						else if (ch < 0x10000)
+						{
+							text.push_back((char)(0xE0 | (ch >> 12)));
+							text.push_back((char)(0x80 | ((ch >> 6) & 0x3F)));
+							text.push_back((char)(0x80 | (ch & 0x3F)));
+						}
+						else
+						{
+							text.push_back((char)(0xF0 | (ch >> 18)));
+							text.push_back((char)(0x80 | ((ch >> 12) & 0x3F)));
+							text.push_back((char)(0x80 | ((ch >> 6) & 0x3F)));
+							text.push_back((char)(0x80 | (ch & 0x3F)));
+						}
+					}
+
+					return true;
+				}
+
+			private:
+				const std::uint8_t* _data;
+				std::size_t _size;
+				std::size_t _offset;
+			};
+		}
+
 		bool PmxLoader::doCanLoad(istream& stream) noexcept
 		{
 			PmxHeader header;
@@ -477,245 +626,610 @@ namespace octoon
 
 		bool PmxLoader::doLoad(istream& stream, Model& model) noexcept
 		{
-			Pmx pmx;
-			if (!this->doLoad(stream, pmx))
+			std::vector<std::uint8_t> buffer;
+
+			auto offset = stream.tellg();
+			auto length = stream.size() - offset;
+			if (length <= 0)
+				return false;
+
+			buffer.resize(static_cast<std::size_t>(length));
+			if (!stream.read((char*)buffer.data(), length))
 				return false;
 
-			for (auto& it : pmx.materials)
+			PmxReader reader(buffer.data(), buffer.size());
+
+			PmxUInt8 magic[4];
+			PmxFloat version;
+			PmxUInt8 numGlobals;
+			if (!reader.read(magic)) return false;
+			if (!reader.read(version)) return false;
+			if (!reader.read(numGlobals)) return false;
+			if (numGlobals < 8) return false;
+
+			PmxUInt8 globals[8];
+			if (!reader.read(globals)) return false;
+			if (!reader.skip(numGlobals - 8)) return false;
+
+			const PmxUInt8 encode = globals[0];
+			const PmxUInt8 addUVCount = globals[1];
+			const PmxUInt8 sizeOfIndices = globals[2];
+			const PmxUInt8 sizeOfTexture = globals[3];
+			const PmxUInt8 sizeOfMaterial = globals[4];
+			const PmxUInt8 sizeOfBone = globals[5];
+			const PmxUInt8 sizeOfMorph = globals[6];
+			const PmxUInt8 sizeOfBody = globals[7];
+
+			if (addUVCount > 4)
+				return false;
+
+			std::string name;
+			if (!reader.readText(name, encode)) return false;
+			if (!reader.skipText()) return false;
+			if (!reader.skipText()) return false;
+			if (!reader.skipText()) return false;
+
+			// Vertices are variable length, a prescan records where every chunk starts so the
+			// chunks can be decoded independently.
+			PmxUInt32 numVertices = 0;
+			if (!reader.read(numVertices)) return false;
+
+			const std::size_t fixedSize = sizeof(PmxVector3) * 2 + sizeof(PmxVector2) + sizeof(PmxVector4) * addUVCount;
+			const std::size_t weightSize[] =
 			{
-				auto material = std::make_shared<MaterialProperty>();
+				sizeOfBone,
+				sizeOfBone * 2u + sizeof(PmxFloat),
+				sizeOfBone * 4u + sizeof(PmxFloat) * 4,
+				sizeOfBone * 2u + sizeof(PmxFloat) + sizeof(PmxVector3) * 3,
+				sizeOfBone * 4u + sizeof(PmxFloat) * 4
+			};
+
+			std::vector<std::size_t> chunks;
+			chunks.reserve(numVertices / PMX_VERTEX_CHUNK_SIZE + 2);
+
+			std::size_t vertexOffset = reader.tell();
+
+			for (std::size_t i = 0; i < numVertices; i++)
+			{
+				if (i % PMX_VERTEX_CHUNK_SIZE == 0)
+					chunks.push_back(vertexOffset);
 
-				if ((it.name.length >> 1) < MAX_PATH)
+				if (vertexOffset + fixedSize >= buffer.size())
+					return false;
+
+				auto type = buffer[vertexOffset + fixedSize];
+				if (type > PMX_QDEF)
+					return false;
+
+				vertexOffset += fixedSize + 1 + weightSize[type] + sizeof(PmxFloat);
+			}
+
+			if (vertexOffset > buffer.size())
+				return false;
+
+			chunks.push_back(vertexOffset);
+
+			reader.seek(vertexOffset);
+
+			PmxUInt32 numIndices = 0;
+			if (!reader.read(numIndices)) return false;
+
+			Uint1Array indices(numIndices);
+			for (std::size_t i = 0; i < numIndices; i++)
+			{
+				if (!reader.readVertexIndex(indices[i], sizeOfIndices)) return false;
+				if (indices[i] >= numVertices) return false;
+			}
+
+			PmxUInt32 numTextures = 0;
+			if (!reader.read(numTextures)) return false;
+
+			std::vector<std::string> textures(numTextures);
+			for (auto& texture : textures)
+			{
+				if (!reader.readText(texture, encode)) return false;
+			}
+
+			PmxUInt32 numMaterials = 0;
+			if (!reader.read(numMaterials)) return false;
+
+			std::vector<PmxUInt32> faceCounts(numMaterials);
+
+			for (std::size_t i = 0; i < numMaterials; i++)
+			{
+				PmxColor3 diffuse;
+				PmxFloat opacity;
+				PmxColor3 specular;
+				PmxFloat shininess;
+				PmxColor3 ambient;
+				std::int32_t textureIndex;
+				std::int32_t sphereTextureIndex;
+				PmxUInt8 toonIndex;
+
+				if (!reader.readText(name, encode)) return false;
+				if (!reader.skipText()) return false;
+				if (!reader.read(diffuse)) return false;
+				if (!reader.read(opacity)) return false;
+				if (!reader.read(specular)) return false;
+				if (!reader.read(shininess)) return false;
+				if (!reader.read(ambient)) return false;
+				if (!reader.skip(sizeof(PmxUInt8) + sizeof(PmxVector4) + sizeof(PmxFloat))) return false;
+				if (!reader.readIndex(textureIndex, sizeOfTexture)) return false;
+				if (!reader.readIndex(sphereTextureIndex, sizeOfTexture)) return false;
+				if (!reader.skip(sizeof(PmxUInt8))) return false;
+				if (!reader.read(toonIndex)) return false;
+				if (!reader.skip(toonIndex == 1 ? 1 : sizeOfTexture)) return false;
+				if (!reader.skipText()) return false;
+				if (!reader.read(faceCounts[i])) return false;
+
+				auto material = std::make_shared<MaterialProperty>();
+				material->set(MATKEY_NAME, name);
+				material->set(MATKEY_COLOR_DIFFUSE, math::srgb2linear(diffuse));
+				material->set(MATKEY_COLOR_AMBIENT, math::srgb2linear(ambient));
+				material->set(MATKEY_COLOR_SPECULAR, math::srgb2linear(specular));
+				material->set(MATKEY_OPACITY, opacity);
+				material->set(MATKEY_SHININESS, shininess / 255.0f);
+
+				if (textureIndex >= 0 && (std::size_t)textureIndex < textures.size())
 				{
-					char name[MAX_PATH];
-					auto length = wcstombs(nullptr, it.name.name, 0);
-					if (length < MAX_PATH)
-					{
-						wcstombs(name, it.name.name, MAX_PATH);
+					material->set(MATKEY_TEXTURE_DIFFUSE(0), textures[textureIndex]);
+					material->set(MATKEY_TEXTURE_AMBIENT(0), textures[textureIndex]);
+				}
 
-						material->set(MATKEY_NAME, name);
-					}
+				if (sphereTextureIndex >= 0 && (std::size_t)sphereTextureIndex < textures.size())
+					material->set(MATKEY_COLOR_SPHEREMAP, textures[sphereTextureIndex]);
+
+				model.addMaterial(std::move(material));
+			}
+
+			std::vector<std::size_t> startIndices(numMaterials + 1, 0);
+			for (std::size_t i = 0; i < numMaterials; i++)
+				startIndices[i + 1] = startIndices[i] + faceCounts[i];
+
+			if (startIndices.back() > numIndices)
+				return false;
+
+			// Meshes are split per material and de-indexed, so every PMX vertex maps to one
+			// or more (mesh, vertex) pairs. Morphs use the same table.
+			std::vector<std::uint32_t> cornerOffsets(numVertices + 1, 0);
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> corners(startIndices.back());
+
+			for (std::size_t i = 0; i < startIndices.back(); i++)
+				cornerOffsets[indices[i] + 1]++;
+
+			for (std::size_t i = 0; i < numVertices; i++)
+				cornerOffsets[i + 1] += cornerOffsets[i];
+
+			{
+				std::vector<std::uint32_t> fill(cornerOffsets.begin(), cornerOffsets.end() - 1);
+
+				for (std::size_t i = 0; i < numMaterials; i++)
+				{
+					for (std::size_t j = startIndices[i]; j < startIndices[i + 1]; j++)
+						corners[fill[indices[j]]++] = std::make_pair(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j - startIndices[i]));
 				}
+			}
 
-				material->set(MATKEY_COLOR_DIFFUSE, math::srgb2linear(it.Diffuse));
-				material->set(MATKEY_COLOR_AMBIENT, math::srgb2linear(it.Ambient));
-				material->set(MATKEY_COLOR_SPECULAR, math::srgb2linear(it.Specular));
-				material->set(MATKEY_OPACITY, it.Opacity);
-				material->set(MATKEY_SHININESS, it.Shininess / 255.0f);
-
-				std::uint32_t limits = 0;
-				if (pmx.header.sizeOfTexture == 1)
-					limits = std::numeric_limits<PmxUInt8>::max();
-				else if (pmx.header.sizeOfTexture == 2)
-					limits = std::numeric_limits<PmxUInt16>::max();
-				else if (pmx.header.sizeOfTexture == 4)
-					limits = std::numeric_limits<PmxUInt32>::max();
-
-				if (it.TextureIndex < limits)
+			if (numVertices > 0 && numIndices > 0 && numMaterials > 0)
+			{
+				struct MeshStreams
 				{
-					PmxName& texture = pmx.textures[it.TextureIndex];
-					if ((texture.length >> 1) < MAX_PATH)
+					float3* vertices;
+					float3* normals;
+					float2* texcoords;
+					VertexWeight* weights;
+				};
+
+				Meshes meshes(numMaterials);
+				std::vector<MeshStreams> streams(numMaterials);
+
+				runtime::ThreadPool::instance()->parallel_for(0, numMaterials, 1, [&](std::size_t begin, std::size_t end)
+				{
+					for (std::size_t i = begin; i < end; i++)
 					{
-						char name[MAX_PATH];
-						::wcstombs(name, texture.name, MAX_PATH);
+						std::size_t faceCount = faceCounts[i];
+
+						auto mesh = std::make_shared<Mesh>();
+						mesh->getVertexArray().resize(faceCount);
+						mesh->getNormalArray().resize(faceCount);
+						mesh->getTexcoordArray().resize(faceCount);
+						mesh->getWeightArray().resize(faceCount);
 
-						material->set(MATKEY_TEXTURE_DIFFUSE(0), name);
-						material->set(MATKEY_TEXTURE_AMBIENT(0), name);
+						auto& meshIndices = mesh->getIndicesArray();
+						meshIndices.resize(faceCount);
+						for (std::size_t j = 0; j < faceCount; j++)
+							meshIndices[j] = static_cast<std::uint32_t>(j);
+
+						streams[i].vertices = mesh->getVertexArray().data();
+						streams[i].normals = mesh->getNormalArray().data();
+						streams[i].texcoords = mesh->getTexcoordArray().data();
+						streams[i].weights = mesh->getWeightArray().data();
+
+						meshes[i] = std::move(mesh);
 					}
-				}
+				});
 
-				if (it.SphereTextureIndex < limits)
+				// Every vertex is decoded once and written straight into the streams of the meshes
+				// using it, vertices no face refers to are skipped. Corners are distinct, so no two
+				// chunks write the same slot.
+				runtime::ThreadPool::instance()->parallel_for(0, chunks.size() - 1, 1, [&](std::size_t begin, std::size_t end)
 				{
-					PmxName& texture = pmx.textures[it.SphereTextureIndex];
-					if ((texture.length >> 1) < MAX_PATH)
+					for (std::size_t chunk = begin; chunk < end; chunk++)
 					{
-						char name[MAX_PATH];
+						PmxReader vertexReader(buffer.data(), chunks[chunk + 1]);
+						vertexReader.seek(chunks[chunk]);
 
-						wcstombs(name, texture.name, MAX_PATH);
+						std::size_t first = chunk * PMX_VERTEX_CHUNK_SIZE;
+						std::size_t last = std::min<std::size_t>(first + PMX_VERTEX_CHUNK_SIZE, numVertices);
 
-						material->set(MATKEY_COLOR_SPHEREMAP, name);
-					}
-				}
+						for (std::size_t i = first; i < last; i++)
+						{
+							PmxUInt8 type;
 
-				model.addMaterial(std::move(material));
-			}
+							if (cornerOffsets[i] == cornerOffsets[i + 1])
+							{
+								vertexReader.skip(fixedSize);
+								vertexReader.read(type);
+								vertexReader.skip(weightSize[type] + sizeof(PmxFloat));
+								continue;
+							}
 
-			if (pmx.numVertices > 0 && pmx.numIndices > 0 && pmx.numMaterials > 0)
-			{
-				float3s vertices;
-				float3s normals;
-				float2s texcoords;
-				VertexWeights weights;
+							float3 vertex;
+							float3 normal;
+							float2 texcoord;
+							std::int32_t bones[4] = { 0, 0, 0, 0 };
+							float weight[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
 
-				for (std::uint32_t i = 0; i < pmx.numVertices; i++)
-				{
-					PmxVertex& v = pmx.vertices[i];
+							vertexReader.read(vertex);
+							vertexReader.read(normal);
+							vertexReader.read(texcoord);
+							vertexReader.skip(sizeof(PmxVector4) * addUVCount);
+							vertexReader.read(type);
 
-					vertices.push_back(v.position);
-					normals.push_back(v.normal);
-					texcoords.push_back(v.coord);
+							switch (type)
+							{
+							case PMX_BDEF1:
+								vertexReader.readIndex(bones[0], sizeOfBone);
+								break;
+							case PMX_BDEF2:
+							case PMX_SDEF:
+								vertexReader.readIndex(bones[0], sizeOfBone);
+								vertexReader.readIndex(bones[1], sizeOfBone);
+								vertexReader.read(weight[0]);
+								weight[1] = 1.0f - weight[0];
+								if (type == PMX_SDEF)
+									vertexReader.skip(sizeof(PmxVector3) * 3);
+								break;
+							case PMX_BDEF4:
+							case PMX_QDEF:
+								vertexReader.readIndex(bones[0], sizeOfBone);
+								vertexReader.readIndex(bones[1], sizeOfBone);
+								vertexReader.readIndex(bones[2], sizeOfBone);
+								vertexReader.readIndex(bones[3], sizeOfBone);
+								vertexReader.read(weight);
+								break;
+							}
 
-					if (pmx.numBones > 1)
-					{
-						VertexWeight weight;
-						weight.weight1 = v.weight.weight1;
-						weight.weight2 = v.weight.weight2;
-						weight.weight3 = v.weight.weight3;
-						weight.weight4 = v.weight.weight4;
-						weight.bone1 = static_cast<uint8_t>(v.weight.bone1);
-						weight.bone2 = static_cast<uint8_t>(v.weight.bone2);
-						weight.bone3 = static_cast<uint8_t>(v.weight.bone3);
-						weight.bone4 = static_cast<uint8_t>(v.weight.bone4);
-
-						weights.push_back(weight);
+							vertexReader.skip(sizeof(PmxFloat));
+
+							// Unused slots may hold -1, they carry no weight.
+							VertexWeight w;
+							w.weight1 = weight[0];
+							w.weight2 = weight[1];
+							w.weight3 = weight[2];
+							w.weight4 = weight[3];
+							w.bone1 = std::max(bones[0], 0);
+							w.bone2 = std::max(bones[1], 0);
+							w.bone3 = std::max(bones[2], 0);
+							w.bone4 = std::max(bones[3], 0);
+
+							for (std::size_t k = cornerOffsets[i]; k < cornerOffsets[i + 1]; k++)
+							{
+								auto& stream = streams[corners[k].first];
+								auto slot = corners[k].second;
+
+								stream.vertices[slot] = vertex;
+								stream.normals[slot] = normal;
+								stream.texcoords[slot] = texcoord;
+								stream.weights[slot] = w;
+							}
+						}
 					}
+				});
+
+				for (auto& mesh : meshes)
+					model.addMesh(std::move(mesh));
+			}
+
+			PmxUInt32 numBones = 0;
+			if (!reader.read(numBones)) return false;
+
+			for (std::size_t i = 0; i < numBones; i++)
+			{
+				PmxVector3 position;
+				std::int32_t parent;
+				PmxUInt16 flag;
+
+				if (!reader.readText(name, encode)) return false;
+				if (!reader.skipText()) return false;
+				if (!reader.read(position)) return false;
+				if (!reader.readIndex(parent, sizeOfBone)) return false;
+				if (!reader.skip(sizeof(PmxUInt32))) return false;
+				if (!reader.read(flag)) return false;
+				if (!reader.skip((flag & PMX_BONE_INDEX) ? sizeOfBone : sizeof(PmxVector3))) return false;
+
+				if (flag & (PMX_BONE_PARENT | PMX_BONE_MOVE_PARENT))
+				{
+					if (!reader.skip(sizeOfBone + sizeof(PmxFloat))) return false;
 				}
 
-				Uint1Array indices(pmx.numIndices);
-				PmxIndex* indicesData = pmx.indices.data();
+				if (flag & PMX_BONE_AXIS)
+				{
+					if (!reader.skip(sizeof(PmxVector3))) return false;
+				}
 
-				for (std::uint32_t i = 0; i < pmx.numIndices; i++, indicesData += pmx.header.sizeOfIndices)
+				if (flag & PMX_BONE_ROTATE)
 				{
-					if (pmx.header.sizeOfIndices == 1)
-						indices[i] = *(std::uint8_t*)indicesData;
-					else if (pmx.header.sizeOfIndices == 2)
-						indices[i] = *(std::uint16_t*)indicesData;
-					else if (pmx.header.sizeOfIndices == 4)
-						indices[i] = *(std::uint16_t*)indicesData;
-					else
-						return false;
+					if (!reader.skip(sizeof(PmxVector3) * 2)) return false;
 				}
 
-				PmxUInt32 startIndices = 0;
+				if (flag & PMX_BONE_EXTERNAL_PARENT)
+				{
+					if (!reader.skip(sizeof(PmxUInt32))) return false;
+				}
 
-				for (auto& it : pmx.materials)
+				if (numBones > 1)
 				{
-					MeshPtr mesh = std::make_shared<Mesh>();
+					auto bone = std::make_shared<Bone>();
+					bone->setName(name);
+					bone->setPosition(position);
+					bone->setParent(static_cast<std::int16_t>(parent));
 
-					float3s vertices_(it.FaceCount);
-					float3s normals_(it.FaceCount);
-					float2s texcoords_(it.FaceCount);
-					VertexWeights weights_(it.FaceCount);
-					uint1s indices_(it.FaceCount);
+					model.addBone(std::move(bone));
+				}
 
-					for (auto i = startIndices; i < it.FaceCount; i++)
+				if (flag & PMX_BONE_IK)
+				{
+					std::int32_t target;
+					PmxUInt32 loopCount;
+					PmxFloat limitedRadian;
+					PmxUInt32 linkCount;
+
+					if (!reader.readIndex(target, sizeOfBone)) return false;
+					if (!reader.read(loopCount)) return false;
+					if (!reader.read(limitedRadian)) return false;
+					if (!reader.read(linkCount)) return false;
+
+					auto attr = std::make_shared<IKAttr>();
+					attr->boneIndex = static_cast<std::uint16_t>(i);
+					attr->targetBoneIndex = static_cast<std::uint16_t>(target);
+					attr->chainLength = linkCount;
+					attr->iterations = loopCount;
+					attr->child.resize(linkCount);
+
+					for (auto& child : attr->child)
 					{
-						auto index = indices[i];
-						vertices_[i] = vertices[index];
-						normals_[i] = normals[index];
-						texcoords_[i] = texcoords[index];
-						weights_[i] = weights[index];
-						indices_[i] = i;
-					}
+						std::int32_t boneIndex;
+						PmxVector3 minimumRadian = PmxVector3::Zero;
+						PmxVector3 maximumRadian = PmxVector3::Zero;
 
-					mesh->setVertexArray(std::move(vertices_));
-					mesh->setNormalArray(std::move(normals_));
-					mesh->setTexcoordArray(std::move(texcoords_));
-					mesh->setWeightArray(std::move(weights_));
-					mesh->setIndicesArray(std::move(indices_));
+						if (!reader.readIndex(boneIndex, sizeOfBone)) return false;
+						if (!reader.read(child.rotateLimited)) return false;
 
-					startIndices += it.FaceCount;
+						if (child.rotateLimited)
+						{
+							if (!reader.read(minimumRadian)) return false;
+							if (!reader.read(maximumRadian)) return false;
+						}
 
-					model.addMesh(std::move(mesh));
+						child.boneIndex = static_cast<std::uint16_t>(boneIndex);
+						child.angleWeight = degress(limitedRadian) / 229.1831f;
+						child.minimumDegrees = degress(minimumRadian);
+						child.maximumDegrees = degress(maximumRadian);
+					}
+
+					if (numBones > 1)
+						model.addIK(std::move(attr));
 				}
 			}
 
-			if (pmx.numBones > 1)
+			PmxUInt32 numMorphs = 0;
+			if (!reader.read(numMorphs)) return false;
+
+			for (std::size_t i = 0; i < numMorphs; i++)
 			{
-				std::size_t index = 0;
-				for (auto& it : pmx.bones)
+				PmxUInt8 morphType;
+				PmxUInt32 morphCount;
+
+				if (!reader.readText(name, encode)) return false;
+				if (!reader.skipText()) return false;
+				if (!reader.skip(sizeof(PmxUInt8))) return false;
+				if (!reader.read(morphType)) return false;
+				if (!reader.read(morphCount)) return false;
+
+				auto morph = std::make_shared<Morph>(name, MorphType::Vertex);
+
+				if (morphType == MorphTypeGroup)
 				{
-					char name[MAX_PATH] = { 0 };
-					if ((it.name.length) > MAX_PATH)
-						return false;
+					std::vector<MorphGroup> groups(morphCount);
 
-					if (!wcstombs(name, it.name.name, MAX_PATH))
-						return false;
+					for (auto& group : groups)
+					{
+						std::int32_t index;
+						if (!reader.readIndex(index, sizeOfMorph)) return false;
+						if (!reader.read(group.weight)) return false;
 
-					Bone bone;
+						group.morph = static_cast<std::uint32_t>(index);
+					}
 
-					bone.setName(name);
-					bone.setPosition(it.position);
-					bone.setParent(it.Parent);
+					morph->setType(MorphType::Group);
+					morph->setGroupArray(std::move(groups));
+				}
+				else if (morphType == MorphTypeVertex || morphType == MorphTypeUV)
+				{
+					std::vector<std::vector<std::pair<std::uint32_t, PmxVector4>>> deltas(numMaterials);
 
-					model.addBone(std::make_shared<Bone>(bone));
+					for (std::size_t j = 0; j < morphCount; j++)
+					{
+						std::uint32_t index;
+						PmxVector4 offset = PmxVector4::Zero;
 
-					if (it.Flag & PMX_BONE_IK)
+						if (!reader.readVertexIndex(index, sizeOfIndices)) return false;
+						if (morphType == MorphTypeVertex)
+						{
+							PmxVector3 position;
+							if (!reader.read(position)) return false;
+							offset.set(position.x, position.y, position.z, 0.0f);
+						}
+						else
+						{
+							if (!reader.read(offset)) return false;
+						}
+
+						if (index >= numVertices)
+							continue;
+
+						for (std::size_t k = cornerOffsets[index]; k < cornerOffsets[index + 1]; k++)
+							deltas[corners[k].first].emplace_back(corners[k].second, offset);
+					}
+
+					std::vector<MorphTarget> targets;
+
+					for (std::size_t j = 0; j < numMaterials; j++)
 					{
-						IKAttr attr;
-						attr.boneIndex = static_cast<uint16_t>(index);
-						attr.targetBoneIndex = it.IKTargetBoneIndex;
-						attr.chainLength = it.IKLinkCount;
-						attr.iterations = it.IKLoopCount;
+						auto& delta = deltas[j];
+						if (delta.empty())
+							continue;
+
+						std::sort(delta.begin(), delta.end(), [](const std::pair<std::uint32_t, PmxVector4>& a, const std::pair<std::uint32_t, PmxVector4>& b) { return a.first < b.first; });
 
-						for (auto& ik : it.IKList)
+						MorphTarget target;
+						target.mesh = static_cast<std::uint32_t>(j);
+						target.indices.resize(delta.size());
+
+						if (morphType == MorphTypeVertex)
+							target.offsets.resize(delta.size());
+						else
+							target.texcoords.resize(delta.size());
+
+						for (std::size_t k = 0; k < delta.size(); k++)
 						{
-							IKChild child;
-							child.boneIndex = ik.BoneIndex;
-							child.angleWeight = degress(it.IKLimitedRadian) / 229.1831f;
-							child.minimumDegrees = degress(ik.minimumRadian);
-							child.maximumDegrees = degress(ik.maximumRadian);
-							child.rotateLimited = ik.rotateLimited;
-
-							attr.child.push_back(child);
+							target.indices[k] = delta[k].first;
+
+							if (morphType == MorphTypeVertex)
+								target.offsets[k] = delta[k].second.xyz();
+							else
+								target.texcoords[k] = delta[k].second.xy();
 						}
 
-						model.addIK(std::make_shared<IKAttr>(attr));
+						targets.push_back(std::move(target));
 					}
 
-					index++;
+					morph->setType(morphType == MorphTypeVertex ? MorphType::Vertex : MorphType::Texcoord);
+					morph->setTargetArray(std::move(targets));
 				}
+				else
+				{
+					std::size_t size = 0;
+					switch (morphType)
+					{
+					case MorphTypeBone: size = sizeOfBone + sizeof(PmxVector3) + sizeof(PmxVector4); break;
+					case MorphTypeExtraUV1:
+					case MorphTypeExtraUV2:
+					case MorphTypeExtraUV3:
+					case MorphTypeExtraUV4: size = sizeOfIndices + sizeof(PmxVector4); break;
+					case MorphTypeMaterial: size = sizeOfMaterial + sizeof(PmxUInt8) + sizeof(PmxFloat) * 28; break;
+					default:
+						return false;
+					}
+
+					if (!reader.skip(size * morphCount)) return false;
+				}
+
+				// Bone and material morphs are kept as empty entries so group morphs still index correctly.
+				model.addMorph(std::move(morph));
 			}
 
-			for (auto& it : pmx.rigidbodys)
+			PmxUInt32 numDisplayFrames = 0;
+			if (!reader.read(numDisplayFrames)) return false;
+
+			for (std::size_t i = 0; i < numDisplayFrames; i++)
 			{
-				char name[MAX_PATH] = { 0 };
-				if ((it.name.length) > MAX_PATH)
-					return false;
+				PmxUInt32 numElements;
 
-				if (!wcstombs(name, it.name.name, MAX_PATH))
-					return false;
+				if (!reader.skipText()) return false;
+				if (!reader.skipText()) return false;
+				if (!reader.skip(sizeof(PmxUInt8))) return false;
+				if (!reader.read(numElements)) return false;
+
+				for (std::size_t j = 0; j < numElements; j++)
+				{
+					PmxUInt8 target;
+					if (!reader.read(target)) return false;
+					if (!reader.skip(target == 0 ? sizeOfBone : sizeOfMorph)) return false;
+				}
+			}
+
+			PmxUInt32 numRigidbodys = 0;
+			if (!reader.read(numRigidbodys)) return false;
+
+			for (std::size_t i = 0; i < numRigidbodys; i++)
+			{
+				std::int32_t bone;
+				PmxUInt8 shape;
 
 				auto body = std::make_shared<RigidbodyProperty>();
-				body->name = name;
-				body->bone = it.bone;
-				body->group = it.group;
-				body->groupMask = it.groupMask;
-				body->shape = (ShapeType)it.shape;
-				body->scale = it.scale;
-				body->position = it.position;
-				body->rotation = it.rotate;
-				body->mass = it.mass;
-				body->movementDecay = it.movementDecay;
-				body->rotationDecay = it.rotationDecay;
-				body->elasticity = it.elasticity;
-				body->friction = it.friction;
-				body->physicsOperation = it.physicsOperation;
+
+				if (!reader.readText(body->name, encode)) return false;
+				if (!reader.skipText()) return false;
+				if (!reader.readIndex(bone, sizeOfBone)) return false;
+				if (!reader.read(body->group)) return false;
+				if (!reader.read(body->groupMask)) return false;
+				if (!reader.read(shape)) return false;
+				if (!reader.read(body->scale)) return false;
+				if (!reader.read(body->position)) return false;
+				if (!reader.read(body->rotation)) return false;
+				if (!reader.read(body->mass)) return false;
+				if (!reader.read(body->movementDecay)) return false;
+				if (!reader.read(body->rotationDecay)) return false;
+				if (!reader.read(body->elasticity)) return false;
+				if (!reader.read(body->friction)) return false;
+				if (!reader.read(body->physicsOperation)) return false;
+
+				body->bone = static_cast<std::uint32_t>(bone);
+				body->shape = (ShapeType)shape;
 
 				model.addRigidbody(std::move(body));
 			}
 
-			for (auto& it : pmx.joints)
-			{
-				char name[MAX_PATH] = { 0 };
-				if ((it.name.length) > MAX_PATH)
-					return false;
+			PmxUInt32 numJoints = 0;
+			if (!reader.read(numJoints)) return false;
 
-				if (!wcstombs(name, it.name.name, MAX_PATH))
-					return false;
+			for (std::size_t i = 0; i < numJoints; i++)
+			{
+				PmxUInt8 type;
+				std::int32_t bodyIndexA;
+				std::int32_t bodyIndexB;
 
 				auto joint = std::make_shared<JointProperty>();
-				joint->name = name;
-				joint->bodyIndexA = it.relatedRigidBodyIndexA;
-				joint->bodyIndexB = it.relatedRigidBodyIndexB;
-				joint->position = it.position;
-				joint->rotation = it.rotation;
-				joint->movementLowerLimit = it.movementLowerLimit;
-				joint->movementUpperLimit = it.movementUpperLimit;
-				joint->rotationLowerLimit = it.rotationLowerLimit;
-				joint->rotationUpperLimit = it.rotationUpperLimit;
-				joint->springMovementConstant = it.springMovementConstant;
-				joint->springRotationConstant = it.springRotationConstant;
+
+				if (!reader.readText(joint->name, encode)) return false;
+				if (!reader.skipText()) return false;
+				if (!reader.read(type)) return false;
+				if (type != 0) return false;
+				if (!reader.readIndex(bodyIndexA, sizeOfBody)) return false;
+				if (!reader.readIndex(bodyIndexB, sizeOfBody)) return false;
+				if (!reader.read(joint->position)) return false;
+				if (!reader.read(joint->rotation)) return false;
+				if (!reader.read(joint->movementLowerLimit)) return false;
+				if (!reader.read(joint->movementUpperLimit)) return false;
+				if (!reader.read(joint->rotationLowerLimit)) return false;
+				if (!reader.read(joint->rotationUpperLimit)) return false;
+				if (!reader.read(joint->springMovementConstant)) return false;
+				if (!reader.read(joint->springRotationConstant)) return false;
+
+				joint->bodyIndexA = static_cast<std::uint32_t>(bodyIndexA);
+				joint->bodyIndexB = static_cast<std::uint32_t>(bodyIndexB);
 
 				model.addJoint(std::move(joint));
 			}
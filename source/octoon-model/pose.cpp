@@ -0,0 +1,163 @@
+#include <octoon/model/pose.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace octoon::math;
+
+namespace octoon
+{
+	namespace model
+	{
+		Pose::Pose() noexcept
+			: tx(nullptr)
+			, ty(nullptr)
+			, tz(nullptr)
+			, qx(nullptr)
+			, qy(nullptr)
+			, qz(nullptr)
+			, qw(nullptr)
+			, _size(0)
+			, _capacity(0)
+		{
+		}
+
+		Pose::Pose(std::size_t numBones) noexcept
+			: Pose()
+		{
+			this->resize(numBones);
+		}
+
+		Pose::~Pose() noexcept
+		{
+		}
+
+		void Pose::resize(std::size_t numBones) noexcept
+		{
+			_size = numBones;
+			_capacity = (numBones + 3) & ~std::size_t(3);
+			_data.resize(_capacity * 7);
+
+			float* data = _data.data();
+			tx = data;
+			ty = data + _capacity;
+			tz = data + _capacity * 2;
+			qx = data + _capacity * 3;
+			qy = data + _capacity * 4;
+			qz = data + _capacity * 5;
+			qw = data + _capacity * 6;
+
+			this->setIdentity();
+		}
+
+		std::size_t Pose::size() const noexcept
+		{
+			return _size;
+		}
+
+		std::size_t Pose::capacity() const noexcept
+		{
+			return _capacity;
+		}
+
+		void Pose::setIdentity() noexcept
+		{
+			std::fill(_data.begin(), _data.begin() + _capacity * 6, 0.0f);
+			std::fill(_data.begin() + _capacity * 6, _data.end(), 1.0f);
+		}
+
+		void Pose::setTranslate(std::size_t index, const float3& translate) noexcept
+		{
+			assert(index < _size);
+			tx[index] = translate.x;
+			ty[index] = translate.y;
+			tz[index] = translate.z;
+		}
+
+		float3 Pose::getTranslate(std::size_t index) const noexcept
+		{
+			assert(index < _size);
+			return float3(tx[index], ty[index], tz[index]);
+		}
+
+		void Pose::setRotation(std::size_t index, const Quaternion& rotate) noexcept
+		{
+			assert(index < _size);
+			qx[index] = rotate.x;
+			qy[index] = rotate.y;
+			qz[index] = rotate.z;
+			qw[index] = rotate.w;
+		}
+
+		Quaternion Pose::getRotation(std::size_t index) const noexcept
+		{
+			assert(index < _size);
+			return Quaternion(qx[index], qy[index], qz[index], qw[index]);
+		}
+
+		void Pose::copy(const Pose& other) noexcept
+		{
+			assert(other._capacity == _capacity);
+			std::memcpy(_data.data(), other._data.data(), _data.size() * sizeof(float));
+		}
+
+		PosePool::PosePool() noexcept
+			: _numBones(0)
+		{
+		}
+
+		PosePool::~PosePool() noexcept
+		{
+		}
+
+		void PosePool::reserve(std::size_t count, std::size_t numBones) noexcept
+		{
+			if (_numBones != numBones)
+				this->clear();
+
+			_numBones = numBones;
+
+			while (_poses.size() < count)
+			{
+				_poses.push_back(std::make_unique<Pose>(numBones));
+				_free.push_back(_poses.back().get());
+			}
+		}
+
+		void PosePool::clear() noexcept
+		{
+			_free.clear();
+			_poses.clear();
+			_numBones = 0;
+		}
+
+		Pose* PosePool::alloc() noexcept
+		{
+			if (_free.empty())
+			{
+				_poses.push_back(std::make_unique<Pose>(_numBones));
+				return _poses.back().get();
+			}
+
+			auto pose = _free.back();
+			_free.pop_back();
+			return pose;
+		}
+
+		void PosePool::free(Pose* pose) noexcept
+		{
+			assert(pose && pose->size() == _numBones);
+			_free.push_back(pose);
+		}
+
+		std::size_t PosePool::getNumBones() const noexcept
+		{
+			return _numBones;
+		}
+
+		std::size_t PosePool::getNumFree() const noexcept
+		{
+			return _free.size();
+		}
+	}
+}
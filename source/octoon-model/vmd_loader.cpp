@@ -0,0 +1,325 @@
+#include <octoon/model/vmd_loader.h>
+#include <octoon/model/animation.h>
+#include <octoon/model/model.h>
+
+#include <octoon/runtime/platform.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+#if !defined(__WINDOWS__)
+#	include <iconv.h>
+#endif
+
+using namespace octoon::io;
+using namespace octoon::math;
+
+namespace octoon
+{
+	namespace model
+	{
+		namespace
+		{
+			constexpr std::size_t VMD_BONE_KEY_SIZE = 111;
+			constexpr std::size_t VMD_MORPH_KEY_SIZE = 23;
+			constexpr std::size_t VMD_BLOCK_SIZE = 4096;
+
+			const char VMD_MAGIC[] = "Vocaloid Motion Data";
+
+#if !defined(__WINDOWS__)
+			// One converter per thread, closed when the thread exits.
+			class SjisConverter
+			{
+			public:
+				SjisConverter() noexcept
+					: _cd(::iconv_open("UTF-8", "SHIFT_JIS"))
+				{
+				}
+
+				~SjisConverter() noexcept
+				{
+					if (_cd != (iconv_t)-1)
+						::iconv_close(_cd);
+				}
+
+				SjisConverter(const SjisConverter&) = delete;
+				SjisConverter& operator=(const SjisConverter&) = delete;
+
+				iconv_t get() const noexcept
+				{
+					return _cd;
+				}
+
+			private:
+				iconv_t _cd;
+			};
+#endif
+
+			std::string sjis2utf8(const char* str, std::size_t length) noexcept
+			{
+				length = std::find(str, str + length, '\0') - str;
+
+				bool ascii = true;
+				for (std::size_t i = 0; i < length; i++)
+					ascii &= (str[i] & 0x80) == 0;
+
+				if (ascii)
+					return std::string(str, length);
+
+#if defined(__WINDOWS__)
+				wchar_t wide[64];
+				int count = ::MultiByteToWideChar(932, 0, str, (int)length, wide, 64);
+				if (count <= 0)
+					return std::string(str, length);
+
+				char utf8[256];
+				int size = ::WideCharToMultiByte(CP_UTF8, 0, wide, count, utf8, sizeof(utf8), nullptr, nullptr);
+				if (size <= 0)
+					return std::string(str, length);
+
+				return std::string(utf8, size);
+#else
+				static thread_local SjisConverter converter;
+
+				iconv_t cd = converter.get();
+				if (cd == (iconv_t)-1)
+					return std::string(str, length);
+
+				char utf8[256];
+				char* in = const_cast<char*>(str);
+				char* out = utf8;
+				std::size_t inbytes = length;
+				std::size_t outbytes = sizeof(utf8);
+
+				::iconv(cd, nullptr, nullptr, nullptr, nullptr);
+				if (::iconv(cd, &in, &inbytes, &out, &outbytes) == (std::size_t)-1)
+					return std::string(str, length);
+
+				return std::string(utf8, out - utf8);
+#endif
+			}
+
+			// A short read only sets eofbit, which operator! does not report.
+			bool readExact(istream& stream, void* data, std::size_t size) noexcept
+			{
+				return stream.read((char*)data, size).gcount() == (streamsize)size;
+			}
+
+			// Bytes left after the read position, the largest size when the stream does not know it.
+			std::uint64_t remaining(istream& stream) noexcept
+			{
+				auto size = stream.size();
+				auto pos = stream.tellg();
+				if (size < 0 || pos < 0)
+					return std::numeric_limits<std::uint64_t>::max();
+
+				return pos < size ? static_cast<std::uint64_t>(size - pos) : 0;
+			}
+
+			template<typename T>
+			void readValue(const std::uint8_t* data, T& value) noexcept
+			{
+				std::memcpy(&value, data, sizeof(T));
+			}
+		}
+
+		bool VmdLoader::doCanLoad(istream& stream) noexcept
+		{
+			char magic[30];
+			if (!readExact(stream, magic, sizeof(magic)))
+				return false;
+
+			return std::strncmp(magic, VMD_MAGIC, sizeof(VMD_MAGIC) - 1) == 0;
+		}
+
+		bool VmdLoader::doCanLoad(const std::string& type) noexcept
+		{
+			return type.compare("vmd") == 0;
+		}
+
+		bool VmdLoader::doCanLoad(const char* type) noexcept
+		{
+			return std::strncmp(type, "vmd", 3) == 0;
+		}
+
+		bool VmdLoader::doLoad(istream& stream, Model& model) noexcept
+		{
+			char magic[30];
+			if (!readExact(stream, magic, sizeof(magic)))
+				return false;
+
+			if (std::strncmp(magic, VMD_MAGIC, sizeof(VMD_MAGIC) - 1) != 0)
+				return false;
+
+			// "Vocaloid Motion Data 0002" stores a 20 bytes model name, the older "Vocaloid Motion Data file" only 10.
+			char name[20];
+			std::size_t nameLength = std::strncmp(magic + 21, "0002", 4) == 0 ? 20 : 10;
+			if (!readExact(stream, name, nameLength))
+				return false;
+
+			std::vector<std::uint8_t> block(VMD_BLOCK_SIZE * VMD_BONE_KEY_SIZE);
+
+			std::uint32_t numBoneKeys = 0;
+			if (!readExact(stream, &numBoneKeys, sizeof(numBoneKeys)))
+				return false;
+
+			// Counts are checked against the stream first, so a corrupt header cannot ask for more memory than the file holds.
+			if (numBoneKeys * static_cast<std::uint64_t>(VMD_BONE_KEY_SIZE) > remaining(stream))
+				return false;
+
+			std::vector<BoneAnimation> bones(numBoneKeys);
+			std::vector<std::uint32_t> keyTracks(numBoneKeys);
+			std::vector<std::string> tracks;
+			std::unordered_map<std::string, std::uint32_t> trackMaps;
+
+			for (std::size_t i = 0; i < numBoneKeys; i += VMD_BLOCK_SIZE)
+			{
+				std::size_t count = std::min<std::size_t>(VMD_BLOCK_SIZE, numBoneKeys - i);
+				if (!readExact(stream, block.data(), count * VMD_BONE_KEY_SIZE))
+					return false;
+
+				for (std::size_t j = 0; j < count; j++)
+				{
+					const std::uint8_t* data = block.data() + j * VMD_BONE_KEY_SIZE;
+
+					// The raw name is hashed so every bone is converted to UTF-8 only once.
+					std::string raw((const char*)data, std::find(data, data + 15, '\0') - data);
+
+					auto it = trackMaps.find(raw);
+					if (it == trackMaps.end())
+					{
+						it = trackMaps.emplace(raw, static_cast<std::uint32_t>(tracks.size())).first;
+						tracks.push_back(sjis2utf8(raw.data(), raw.size()));
+					}
+
+					std::uint32_t frame;
+					float3 position;
+					Quaternion rotation;
+					std::uint8_t interp[64];
+
+					readValue(data + 15, frame);
+					readValue(data + 19, position);
+					readValue(data + 31, rotation.x);
+					readValue(data + 35, rotation.y);
+					readValue(data + 39, rotation.z);
+					readValue(data + 43, rotation.w);
+					readValue(data + 47, interp);
+
+					Interpolation interpolation;
+					for (std::size_t k = 0; k < 4; k++)
+					{
+						interpolation.interpX[k] = interp[k * 4 + 0];
+						interpolation.interpY[k] = interp[k * 4 + 1];
+						interpolation.interpZ[k] = interp[k * 4 + 2];
+						interpolation.interpW[k] = interp[k * 4 + 3];
+					}
+
+					keyTracks[i + j] = it->second;
+
+					auto& anim = bones[i + j];
+					anim.setName(tracks[it->second]);
+					anim.setFrameNo(static_cast<std::int32_t>(frame));
+					anim.setPosition(position);
+					anim.setRotation(rotation);
+					anim.setInterpolation(interpolation);
+				}
+			}
+
+			// Keys go by track in order of appearance, then by frame. The order is sorted on its own
+			// and applied in place, one cycle of the permutation at a time.
+			std::vector<std::uint32_t> order(numBoneKeys);
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+			{
+				if (keyTracks[a] != keyTracks[b])
+					return keyTracks[a] < keyTracks[b];
+				return bones[a].getFrameNo() < bones[b].getFrameNo();
+			});
+
+			for (std::size_t i = 0; i < order.size(); i++)
+			{
+				if (order[i] == i)
+					continue;
+
+				BoneAnimation first = std::move(bones[i]);
+				std::size_t j = i;
+				while (order[j] != i)
+				{
+					bones[j] = std::move(bones[order[j]]);
+					std::size_t next = order[j];
+					order[j] = static_cast<std::uint32_t>(j);
+					j = next;
+				}
+
+				bones[j] = std::move(first);
+				order[j] = static_cast<std::uint32_t>(j);
+			}
+
+			std::vector<MorphAnimation> morphs;
+
+			std::uint32_t numMorphKeys = 0;
+			if (readExact(stream, &numMorphKeys, sizeof(numMorphKeys)))
+			{
+				if (numMorphKeys * static_cast<std::uint64_t>(VMD_MORPH_KEY_SIZE) > remaining(stream))
+					return false;
+
+				morphs.resize(numMorphKeys);
+
+				std::unordered_map<std::string, std::string> morphMaps;
+
+				for (std::size_t i = 0; i < numMorphKeys; i += VMD_BLOCK_SIZE)
+				{
+					std::size_t count = std::min<std::size_t>(VMD_BLOCK_SIZE, numMorphKeys - i);
+					if (!readExact(stream, block.data(), count * VMD_MORPH_KEY_SIZE))
+						return false;
+
+					for (std::size_t j = 0; j < count; j++)
+					{
+						const std::uint8_t* data = block.data() + j * VMD_MORPH_KEY_SIZE;
+
+						std::string raw((const char*)data, std::find(data, data + 15, '\0') - data);
+
+						auto it = morphMaps.find(raw);
+						if (it == morphMaps.end())
+							it = morphMaps.emplace(raw, sjis2utf8(raw.data(), raw.size())).first;
+
+						std::uint32_t frame;
+						float weight;
+
+						readValue(data + 15, frame);
+						readValue(data + 19, weight);
+
+						auto& morph = morphs[i + j];
+						morph.setName(it->second);
+						morph.setFrameNo(static_cast<std::int32_t>(frame));
+						morph.setWeight(weight);
+					}
+				}
+
+				std::stable_sort(morphs.begin(), morphs.end(), [](const MorphAnimation& a, const MorphAnimation& b)
+				{
+					if (a.getName() != b.getName())
+						return a.getName() < b.getName();
+					return a.getFrameNo() < b.getFrameNo();
+				});
+			}
+
+			auto animation = std::make_shared<AnimationProperty>();
+			animation->setName(sjis2utf8(name, nameLength));
+			animation->setBoneAnimationArray(std::move(bones));
+			animation->setMorphAnimationArray(std::move(morphs));
+
+			model.addAnimtion(std::move(animation));
+
+			return true;
+		}
+
+		bool VmdLoader::doSave(ostream&, const Model&) noexcept
+		{
+			return false;
+		}
+	}
+}
@@ -0,0 +1,157 @@
+#include <octoon/runtime/thread_pool.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace octoon
+{
+	namespace runtime
+	{
+		ThreadPool::ThreadPool() noexcept
+			: ThreadPool(std::max(1u, std::thread::hardware_concurrency()) - 1)
+		{
+		}
+
+		ThreadPool::ThreadPool(std::size_t num_threads) noexcept
+			: quit_(false)
+		{
+			for (std::size_t i = 0; i < num_threads; i++)
+				threads_.emplace_back(&ThreadPool::run, this);
+		}
+
+		ThreadPool::~ThreadPool() noexcept
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				quit_ = true;
+			}
+
+			cond_.notify_all();
+
+			for (auto& it : threads_)
+				it.join();
+		}
+
+		std::size_t
+		ThreadPool::size() const noexcept
+		{
+			return threads_.size();
+		}
+
+		void
+		ThreadPool::push(std::function<void()>&& task) noexcept
+		{
+			if (threads_.empty())
+			{
+				task();
+				return;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				tasks_.push_back(std::move(task));
+			}
+
+			cond_.notify_one();
+		}
+
+		void
+		ThreadPool::parallel_for(std::size_t begin, std::size_t end, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& func) noexcept
+		{
+			if (begin >= end)
+				return;
+
+			grain = std::max<std::size_t>(grain, 1);
+
+			std::size_t count = end - begin;
+			std::size_t chunks = std::min((count + grain - 1) / grain, threads_.size() + 1);
+			if (chunks <= 1)
+			{
+				func(begin, end);
+				return;
+			}
+
+			// Chunks are claimed from a counter, by the pool and by the caller alike, so a caller
+			// that is itself a pool task runs whatever nobody else picked up instead of waiting
+			// for it. The state is shared with the tasks, which can still be queued or finishing
+			// their notify after the caller returned.
+			struct Range
+			{
+				std::size_t begin;
+				std::size_t end;
+				std::size_t step;
+				std::size_t chunks;
+
+				std::atomic<std::size_t> next;
+				std::atomic<std::size_t> pending;
+
+				std::mutex mutex;
+				std::condition_variable done;
+			};
+
+			auto range = std::make_shared<Range>();
+			range->begin = begin;
+			range->end = end;
+			range->step = (count + chunks - 1) / chunks;
+			range->chunks = chunks;
+			range->next = 0;
+			range->pending = chunks;
+
+			// func is only touched while a chunk is unfinished, and the caller waits for those.
+			auto work = [range, &func]()
+			{
+				for (auto i = range->next++; i < range->chunks; i = range->next++)
+				{
+					std::size_t first = range->begin + range->step * i;
+					std::size_t last = std::min(first + range->step, range->end);
+
+					if (first < last)
+						func(first, last);
+
+					if (--range->pending == 0)
+					{
+						std::unique_lock<std::mutex> lock(range->mutex);
+						range->done.notify_all();
+					}
+				}
+			};
+
+			for (std::size_t i = 1; i < chunks; i++)
+				this->push(work);
+
+			work();
+
+			std::unique_lock<std::mutex> lock(range->mutex);
+			range->done.wait(lock, [&]() { return range->pending == 0; });
+		}
+
+		ThreadPool*
+		ThreadPool::instance() noexcept
+		{
+			static ThreadPool pool;
+			return &pool;
+		}
+
+		void
+		ThreadPool::run() noexcept
+		{
+			for (;;)
+			{
+				std::function<void()> task;
+
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					cond_.wait(lock, [this]() { return quit_ || !tasks_.empty(); });
+
+					if (quit_ && tasks_.empty())
+						return;
+
+					task = std::move(tasks_.front());
+					tasks_.pop_front();
+				}
+
+				task();
+			}
+		}
+	}
+}
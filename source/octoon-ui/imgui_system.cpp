@@ -436,25 +436,36 @@ namespace octoon
 				std::uint32_t vdx_buffer_offset = 0;
 				std::uint32_t idx_buffer_offset = 0;
 
+				context.setRenderPipeline(pipeline_);
+
+				// Images packed into one atlas share a texture id, so runs of them draw without rebinding.
+				bool bound = false;
+				ImTextureID boundTexture = nullptr;
+
 				for (int n = 0; n < drawData->CmdListsCount; n++)
 				{
 					const ImDrawList* cmd_list = drawData->CmdLists[n];
 
 					for (auto cmd = cmd_list->CmdBuffer.begin(); cmd != cmd_list->CmdBuffer.end(); cmd++)
 					{
-						auto texture = (GraphicsTexture*)cmd->TextureId;
-						if (texture)
-							decal_->uniformTexture(texture->downcast_pointer<GraphicsTexture>());
-						else
-							decal_->uniformTexture(nullptr);
+						if (!bound || cmd->TextureId != boundTexture)
+						{
+							auto texture = (GraphicsTexture*)cmd->TextureId;
+							if (texture)
+								decal_->uniformTexture(texture->downcast_pointer<GraphicsTexture>());
+							else
+								decal_->uniformTexture(nullptr);
+
+							context.setDescriptorSet(descriptor_set_);
+
+							bound = true;
+							boundTexture = cmd->TextureId;
+						}
 
 						ImVec4 scissor((int)cmd->ClipRect.x, (int)cmd->ClipRect.y, (int)(cmd->ClipRect.z - cmd->ClipRect.x), (int)(cmd->ClipRect.w - cmd->ClipRect.y));
 
 						context.setScissor(0, uint4(scissor.x, scissor.y, scissor.z, scissor.w));
 
-						context.setRenderPipeline(pipeline_);
-						context.setDescriptorSet(descriptor_set_);
-
 						context.drawIndexed(cmd->ElemCount, 1, idx_buffer_offset, vdx_buffer_offset, 0);
 
 						idx_buffer_offset += cmd->ElemCount;
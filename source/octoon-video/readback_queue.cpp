@@ -0,0 +1,232 @@
+#include <octoon/video/readback_queue.h>
+#include <octoon/runtime/except.h>
+
+#include <algorithm>
+
+namespace octoon
+{
+	namespace video
+	{
+		struct ReadbackQueue::Buffer
+		{
+			graphics::GraphicsTexturePtr texture;
+			Consumer consumer;
+
+			const std::uint8_t* pixels = nullptr;
+			std::uint32_t width = 0;
+			std::uint32_t height = 0;
+			std::uint32_t pitch = 0;
+
+			// Set by the worker, guarded by mutex_.
+			bool done = false;
+		};
+
+		ReadbackQueue::ReadbackQueue(std::uint32_t count) noexcept
+			: quit_(false)
+			, buffers_(std::max(count, 1u))
+		{
+			thread_ = std::thread(&ReadbackQueue::run, this);
+		}
+
+		ReadbackQueue::~ReadbackQueue() noexcept
+		{
+			try
+			{
+				this->flush();
+			}
+			catch (...)
+			{
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				quit_ = true;
+			}
+
+			jobCondition_.notify_one();
+			thread_.join();
+		}
+
+		void
+		ReadbackQueue::push(const graphics::GraphicsTexturePtr& texture, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, Consumer&& consumer) except
+		{
+			assert(texture && consumer);
+
+			this->reclaim();
+			this->submit();
+
+			if (consuming_.size() == buffers_.size())
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				doneCondition_.wait(lock, [this]() { return buffers_[consuming_.front()].done; });
+				lock.unlock();
+
+				this->reclaim();
+			}
+
+			std::uint32_t index = 0;
+			while (buffers_[index].texture)
+				index++;
+
+			if (!texture->readBack(index, x, y, width, height, 0))
+				throw runtime::runtime_error::create("ReadbackQueue : readBack() failed");
+
+			auto& buffer = buffers_[index];
+			buffer.texture = texture;
+			buffer.consumer = std::move(consumer);
+			buffer.pixels = nullptr;
+			buffer.width = width;
+			buffer.height = height;
+			buffer.pitch = 0;
+			buffer.done = false;
+
+			copying_.push_back(index);
+		}
+
+		void
+		ReadbackQueue::flush() except
+		{
+			this->submit();
+
+			if (!consuming_.empty())
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				doneCondition_.wait(lock, [this]() { return buffers_[consuming_.back()].done; });
+			}
+
+			this->reclaim();
+
+			std::exception_ptr exception;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				std::swap(exception, exception_);
+			}
+
+			if (exception)
+				std::rethrow_exception(exception);
+		}
+
+		std::size_t
+		ReadbackQueue::pending() const noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			std::size_t count = copying_.size();
+			for (auto index : consuming_)
+			{
+				if (!buffers_[index].done)
+					count++;
+			}
+
+			return count;
+		}
+
+		std::uint32_t
+		ReadbackQueue::getBufferCount() const noexcept
+		{
+			return (std::uint32_t)buffers_.size();
+		}
+
+		void
+		ReadbackQueue::reclaim() noexcept
+		{
+			// Consumers finish in the order the buffers were submitted.
+			while (!consuming_.empty())
+			{
+				auto& buffer = buffers_[consuming_.front()];
+
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					if (!buffer.done)
+						break;
+				}
+
+				buffer.texture->unmapReadBack(consuming_.front());
+				buffer.texture = nullptr;
+				buffer.consumer = nullptr;
+
+				consuming_.pop_front();
+			}
+		}
+
+		void
+		ReadbackQueue::submit() noexcept
+		{
+			for (auto index : copying_)
+			{
+				auto& buffer = buffers_[index];
+
+				void* data = nullptr;
+				if (buffer.texture->mapReadBack(index, &data, &buffer.pitch))
+				{
+					buffer.pixels = (const std::uint8_t*)data;
+					consuming_.push_back(index);
+
+					std::lock_guard<std::mutex> lock(mutex_);
+					jobs_.push_back(index);
+				}
+				else
+				{
+					buffer.texture = nullptr;
+					buffer.consumer = nullptr;
+
+					try
+					{
+						throw runtime::runtime_error::create("ReadbackQueue : mapReadBack() failed");
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						if (!exception_)
+							exception_ = std::current_exception();
+					}
+				}
+			}
+
+			if (!copying_.empty())
+			{
+				copying_.clear();
+				jobCondition_.notify_one();
+			}
+		}
+
+		void
+		ReadbackQueue::run() noexcept
+		{
+			for (;;)
+			{
+				std::uint32_t index;
+
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					jobCondition_.wait(lock, [this]() { return quit_ || !jobs_.empty(); });
+					if (jobs_.empty())
+						return;
+
+					index = jobs_.front();
+					jobs_.pop_front();
+				}
+
+				auto& buffer = buffers_[index];
+
+				try
+				{
+					buffer.consumer(buffer.pixels, buffer.width, buffer.height, buffer.pitch);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					if (!exception_)
+						exception_ = std::current_exception();
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					buffer.done = true;
+				}
+
+				doneCondition_.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,178 @@
+#include <octoon/video/texture_atlas.h>
+#include <octoon/runtime/except.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace octoon
+{
+	namespace video
+	{
+		namespace
+		{
+			image::Format
+			asImageFormat(graphics::GraphicsFormat format) except
+			{
+				switch (format)
+				{
+				case graphics::GraphicsFormat::R8UNorm: return image::Format::R8UNorm;
+				case graphics::GraphicsFormat::R8SRGB: return image::Format::R8SRGB;
+				case graphics::GraphicsFormat::R8G8UNorm: return image::Format::R8G8UNorm;
+				case graphics::GraphicsFormat::R8G8SRGB: return image::Format::R8G8SRGB;
+				case graphics::GraphicsFormat::R8G8B8A8UNorm: return image::Format::R8G8B8A8UNorm;
+				case graphics::GraphicsFormat::R8G8B8A8SRGB: return image::Format::R8G8B8A8SRGB;
+				case graphics::GraphicsFormat::B8G8R8A8UNorm: return image::Format::B8G8R8A8UNorm;
+				case graphics::GraphicsFormat::B8G8R8A8SRGB: return image::Format::B8G8R8A8SRGB;
+				default:
+					throw runtime::runtime_error::create("TextureAtlas : unsupported texture format");
+				}
+			}
+
+			const float*
+			srgbToLinearTable() noexcept
+			{
+				static const auto table = []
+				{
+					std::vector<float> values(256);
+					for (std::size_t i = 0; i < values.size(); i++)
+					{
+						float value = i / 255.0f;
+						values[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+					}
+					return values;
+				}();
+
+				return table.data();
+			}
+
+			std::uint8_t
+			linearToSRGB(double value) noexcept
+			{
+				value = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+				return (std::uint8_t)std::min(std::max(value * 255.0 + 0.5, 0.0), 255.0);
+			}
+		}
+
+		TextureAtlas::TextureAtlas(const graphics::GraphicsTexturePtr& texture, std::uint32_t padding, std::uint32_t gutter, image::AtlasPacking packing) except
+			: texture_(texture)
+		{
+			assert(texture);
+
+			auto& desc = texture->getGraphicsTextureDesc();
+			atlas_ = std::make_unique<image::ImageAtlas>(asImageFormat(desc.getTexFormat()), desc.getWidth(), desc.getHeight(), padding, gutter, packing);
+		}
+
+		TextureAtlas::~TextureAtlas() noexcept
+		{
+		}
+
+		image::ImageAtlas&
+		TextureAtlas::getAtlas() noexcept
+		{
+			return *atlas_;
+		}
+
+		const image::ImageAtlas&
+		TextureAtlas::getAtlas() const noexcept
+		{
+			return *atlas_;
+		}
+
+		const graphics::GraphicsTexturePtr&
+		TextureAtlas::getTexture() const noexcept
+		{
+			return texture_;
+		}
+
+		std::size_t
+		TextureAtlas::upload() except
+		{
+			auto& image = atlas_->getImage();
+			auto& desc = texture_->getGraphicsTextureDesc();
+
+			std::uint32_t width = image.width();
+			std::uint32_t height = image.height();
+			std::uint32_t pixelSize = image.format().pixel_size();
+			std::uint32_t levels = std::max(desc.getMipNums(), 1u);
+
+			// Alpha of sRGB formats is linear already.
+			bool srgb = image.format().value_type() == image::value_t::SRGB;
+			std::uint32_t colors = srgb ? (pixelSize == 4 ? 3 : pixelSize) : 0;
+			auto linear = srgbToLinearTable();
+
+			auto data = (const std::uint8_t*)image.data();
+			std::size_t bytes = 0;
+
+			for (auto& rect : atlas_->getDirtyRects())
+			{
+				if (!texture_->update(rect.x, rect.y, rect.width, rect.height, 0, data + ((std::size_t)rect.y * width + rect.x) * pixelSize, width * pixelSize))
+					throw runtime::runtime_error::create("TextureAtlas : failed to update the texture");
+
+				bytes += (std::size_t)rect.width * rect.height * pixelSize;
+
+				// Texels of further levels average their whole footprint on the first level.
+				for (std::uint32_t level = 1; level < levels; level++)
+				{
+					std::uint32_t w = std::max(width >> level, 1u);
+					std::uint32_t h = std::max(height >> level, 1u);
+					std::uint32_t x0 = std::min(rect.x >> level, w - 1);
+					std::uint32_t y0 = std::min(rect.y >> level, h - 1);
+					std::uint32_t x1 = std::min(((rect.x + rect.width - 1) >> level) + 1, w);
+					std::uint32_t y1 = std::min(((rect.y + rect.height - 1) >> level) + 1, h);
+					std::uint32_t size = 1u << level;
+
+					scratch_.resize((std::size_t)(x1 - x0) * (y1 - y0) * pixelSize);
+
+					auto out = scratch_.data();
+					for (std::uint32_t y = y0; y < y1; y++)
+					{
+						std::uint32_t top = y * size;
+						std::uint32_t bottom = std::min(top + size, height);
+
+						for (std::uint32_t x = x0; x < x1; x++)
+						{
+							std::uint32_t left = x * size;
+							std::uint32_t right = std::min(left + size, width);
+							std::uint32_t count = (bottom - top) * (right - left);
+
+							for (std::uint32_t c = 0; c < colors; c++)
+							{
+								double sum = 0.0;
+								for (std::uint32_t sy = top; sy < bottom; sy++)
+								{
+									auto row = data + ((std::size_t)sy * width) * pixelSize + c;
+									for (std::uint32_t sx = left; sx < right; sx++)
+										sum += linear[row[sx * pixelSize]];
+								}
+
+								*out++ = linearToSRGB(sum / count);
+							}
+
+							for (std::uint32_t c = colors; c < pixelSize; c++)
+							{
+								std::uint64_t sum = 0;
+								for (std::uint32_t sy = top; sy < bottom; sy++)
+								{
+									auto row = data + ((std::size_t)sy * width) * pixelSize + c;
+									for (std::uint32_t sx = left; sx < right; sx++)
+										sum += row[sx * pixelSize];
+								}
+
+								*out++ = (std::uint8_t)((sum + count / 2) / count);
+							}
+						}
+					}
+
+					if (!texture_->update(x0, y0, x1 - x0, y1 - y0, level, scratch_.data(), (x1 - x0) * pixelSize))
+						throw runtime::runtime_error::create("TextureAtlas : failed to update the texture");
+
+					bytes += scratch_.size();
+				}
+			}
+
+			atlas_->clearDirtyRects();
+			return bytes;
+		}
+	}
+}
@@ -0,0 +1,814 @@
+#include <octoon/game_scene_file.h>
+#include <octoon/game_scene.h>
+#include <octoon/game_component.h>
+#include <octoon/transform_component.h>
+
+#include <octoon/model/mesh.h>
+#include <octoon/runtime/except.h>
+#include <octoon/runtime/rtti_factory.h>
+
+#include <mutex>
+#include <cstring>
+
+#if OCTOON_FEATURE_VIDEO_ENABLE
+#	include <octoon/mesh_filter_component.h>
+#	include <octoon/mesh_renderer_component.h>
+#	include <octoon/video/ggx_material.h>
+#	include <octoon/video/phong_material.h>
+#	include <octoon/video/blinn_material.h>
+#	include <octoon/video/line_material.h>
+#endif
+
+namespace octoon
+{
+	namespace
+	{
+		constexpr std::uint32_t SceneMagic = 0x4E43534F; // "OSCN"
+		constexpr std::uint32_t NullIndex = 0xFFFFFFFF;
+
+		// Every section is an array of the records below, stored in the byte order of the writer.
+		struct FileHeader
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t name;
+			std::uint32_t numStrings;
+			std::uint32_t numObjects;
+			std::uint32_t numComponents;
+			std::uint32_t numBlobs;
+			std::uint32_t stringBytes;
+			std::uint64_t payloadBytes;
+		};
+
+		struct StringRecord
+		{
+			std::uint32_t offset;
+			std::uint32_t length;
+		};
+
+		// Parents always come before their children, so one pass in file order links the hierarchy.
+		struct ObjectRecord
+		{
+			std::uint32_t name;
+			std::uint32_t parent;
+			std::uint32_t firstComponent;
+			std::uint32_t numComponents;
+			std::uint8_t layer;
+			std::uint8_t active;
+			std::uint16_t reserved;
+		};
+
+		struct ComponentRecord
+		{
+			std::uint32_t type;
+			std::uint32_t name;
+			std::uint32_t version;
+			std::uint32_t active;
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+
+		struct BlobRecord
+		{
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+
+		struct Registration
+		{
+			std::uint32_t version;
+			GameSceneFile::Writer writer;
+			GameSceneFile::Reader reader;
+		};
+
+		class StringTable
+		{
+		public:
+			std::uint32_t intern(const std::string& str) noexcept
+			{
+				auto it = indices_.find(str);
+				if (it != indices_.end())
+					return it->second;
+
+				auto index = (std::uint32_t)records_.size();
+				records_.push_back(StringRecord{ (std::uint32_t)chars_.size(), (std::uint32_t)str.size() });
+				chars_.insert(chars_.end(), str.begin(), str.end());
+				indices_.emplace(str, index);
+				return index;
+			}
+
+			const std::vector<StringRecord>& records() const noexcept { return records_; }
+			const std::vector<char>& chars() const noexcept { return chars_; }
+
+		private:
+			std::vector<char> chars_;
+			std::vector<StringRecord> records_;
+			std::unordered_map<std::string, std::uint32_t> indices_;
+		};
+
+		template<typename T>
+		const char* readRecords(const char* it, const char* end, std::size_t count, std::vector<T>& records) except
+		{
+			if ((std::size_t)(end - it) / sizeof(T) < count)
+				throw runtime::runtime_error::create("GameSceneFile : the file is truncated");
+
+			records.resize(count);
+			if (count > 0)
+				std::memcpy(records.data(), it, count * sizeof(T));
+			return it + count * sizeof(T);
+		}
+
+		void registerBuiltins(std::unordered_map<std::string, Registration>& registry) noexcept
+		{
+			registry[TransformComponent::RTTI.type_name()] = Registration{ 1,
+				[](const GameComponent& component, GameSceneWriter& writer)
+				{
+					auto& transform = static_cast<const TransformComponent&>(component);
+					writer.write(transform.getLocalTranslate());
+					writer.write(transform.getLocalQuaternion());
+					writer.write(transform.getLocalScale());
+				},
+				[](GameComponent& component, GameSceneReader& reader)
+				{
+					auto& transform = static_cast<TransformComponent&>(component);
+					transform.setLocalTranslate(reader.read<math::float3>());
+					transform.setLocalQuaternion(reader.read<math::Quaternion>());
+					transform.setLocalScale(reader.read<math::float3>());
+				}
+			};
+
+#if OCTOON_FEATURE_VIDEO_ENABLE
+			registry[MeshFilterComponent::RTTI.type_name()] = Registration{ 1,
+				[](const GameComponent& component, GameSceneWriter& writer)
+				{
+					writer.writeMesh(static_cast<const MeshFilterComponent&>(component).getMesh());
+				},
+				[](GameComponent& component, GameSceneReader& reader)
+				{
+					auto mesh = reader.readMesh();
+					if (mesh)
+						static_cast<MeshFilterComponent&>(component).setMesh(std::move(mesh));
+				}
+			};
+
+			enum class MaterialType : std::uint8_t
+			{
+				None,
+				GGX,
+				Phong,
+				Blinn,
+				Line
+			};
+
+			registry[MeshRendererComponent::RTTI.type_name()] = Registration{ 1,
+				[](const GameComponent& component, GameSceneWriter& writer)
+				{
+					auto& material = static_cast<const MeshRendererComponent&>(component).getMaterial();
+
+					writer.writeShared(material.get(), [&](GameSceneWriter& writer)
+					{
+						if (auto ggx = dynamic_cast<const video::GGXMaterial*>(material.get()))
+						{
+							writer.write(MaterialType::GGX);
+							writer.write(ggx->getBaseColor());
+							writer.write(ggx->getAmbientColor());
+							writer.write(ggx->getSpecularColor());
+							writer.write(ggx->getLightDir());
+							writer.write(ggx->getSmoothness());
+							writer.write(ggx->getMetalness());
+						}
+						else if (auto phong = dynamic_cast<const video::PhongMaterial*>(material.get()))
+						{
+							writer.write(MaterialType::Phong);
+							writer.write(phong->getBaseColor());
+							writer.write(phong->getAmbientColor());
+							writer.write(phong->getLightDir());
+							writer.write(phong->getShininess());
+						}
+						else if (auto blinn = dynamic_cast<const video::BlinnMaterial*>(material.get()))
+						{
+							writer.write(MaterialType::Blinn);
+							writer.write(blinn->getBaseColor());
+							writer.write(blinn->getAmbientColor());
+							writer.write(blinn->getLightDir());
+							writer.write(blinn->getShininess());
+						}
+						else if (auto line = dynamic_cast<const video::LineMaterial*>(material.get()))
+						{
+							writer.write(MaterialType::Line);
+							writer.write(line->getColor());
+						}
+						else
+						{
+							writer.write(MaterialType::None);
+						}
+					});
+				},
+				[](GameComponent& component, GameSceneReader& reader)
+				{
+					auto material = reader.readShared<video::Material>([](GameSceneReader& reader) -> video::MaterialPtr
+					{
+						switch (reader.read<MaterialType>())
+						{
+						case MaterialType::GGX:
+						{
+							auto ggx = std::make_shared<video::GGXMaterial>();
+							ggx->setBaseColor(reader.read<math::float3>());
+							ggx->setAmbientColor(reader.read<math::float3>());
+							ggx->setSpecularColor(reader.read<math::float3>());
+							ggx->setLightDir(reader.read<math::float3>());
+							ggx->setSmoothness(reader.read<float>());
+							ggx->setMetalness(reader.read<float>());
+							return ggx;
+						}
+						case MaterialType::Phong:
+						{
+							auto phong = std::make_shared<video::PhongMaterial>();
+							phong->setBaseColor(reader.read<math::float3>());
+							phong->setAmbientColor(reader.read<math::float3>());
+							phong->setLightDir(reader.read<math::float3>());
+							phong->setShininess(reader.read<float>());
+							return phong;
+						}
+						case MaterialType::Blinn:
+						{
+							auto blinn = std::make_shared<video::BlinnMaterial>();
+							blinn->setBaseColor(reader.read<math::float3>());
+							blinn->setAmbientColor(reader.read<math::float3>());
+							blinn->setLightDir(reader.read<math::float3>());
+							blinn->setShininess(reader.read<float>());
+							return blinn;
+						}
+						case MaterialType::Line:
+						{
+							auto line = std::make_shared<video::LineMaterial>();
+							line->setColor(reader.read<math::float3>());
+							return line;
+						}
+						default:
+							return nullptr;
+						}
+					});
+
+					if (material)
+						static_cast<MeshRendererComponent&>(component).setMaterial(std::move(material));
+				}
+			};
+#endif
+		}
+
+		std::mutex& registryMutex() noexcept
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		std::unordered_map<std::string, Registration>& registry() noexcept
+		{
+			static std::unordered_map<std::string, Registration> registry;
+			static std::once_flag once;
+			std::call_once(once, [&]() { registerBuiltins(registry); });
+			return registry;
+		}
+	}
+
+	struct GameSceneReader::Blobs
+	{
+		const char* data;
+
+		std::vector<BlobRecord> records;
+		std::vector<std::shared_ptr<void>> objects;
+		std::vector<std::uint8_t> decoding;
+	};
+
+	GameSceneWriter::GameSceneWriter() noexcept
+		: out_(nullptr)
+	{
+	}
+
+	GameSceneWriter::~GameSceneWriter() noexcept
+	{
+	}
+
+	void
+	GameSceneWriter::write(const void* data, std::size_t size) noexcept
+	{
+		assert(out_);
+		out_->insert(out_->end(), (const std::uint8_t*)data, (const std::uint8_t*)data + size);
+	}
+
+	void
+	GameSceneWriter::writeString(const std::string& str) noexcept
+	{
+		this->write((std::uint32_t)str.size());
+		this->write(str.data(), str.size());
+	}
+
+	void
+	GameSceneWriter::writeShared(const void* key, const Encoder& encoder) except
+	{
+		if (!key)
+		{
+			this->write(NullIndex);
+			return;
+		}
+
+		auto it = shared_.find(key);
+		if (it != shared_.end())
+		{
+			this->write(it->second);
+			return;
+		}
+
+		auto index = (std::uint32_t)blobs_.size();
+		shared_.emplace(key, index);
+		blobs_.emplace_back();
+
+		// Encoded aside, the encoder may add blobs of its own.
+		std::vector<std::uint8_t> blob;
+
+		auto out = out_;
+		out_ = &blob;
+		encoder(*this);
+		out_ = out;
+
+		blobs_[index] = std::move(blob);
+
+		this->write(index);
+	}
+
+	void
+	GameSceneWriter::writeMesh(const model::MeshPtr& mesh) except
+	{
+		this->writeShared(mesh.get(), [&](GameSceneWriter& writer)
+		{
+			writer.writeString(mesh->getName());
+			writer.writeArray(mesh->getVertexArray());
+			writer.writeArray(mesh->getNormalArray());
+			writer.writeArray(mesh->getTangentArray());
+			writer.writeArray(mesh->getColorArray());
+
+			writer.write((std::uint8_t)TEXTURE_ARRAY_COUNT);
+			for (std::uint8_t i = 0; i < TEXTURE_ARRAY_COUNT; i++)
+				writer.writeArray(mesh->getTexcoordArray(i));
+
+			writer.writeArray(mesh->getWeightArray());
+			writer.writeArray(mesh->getIndicesArray());
+			writer.writeArray(mesh->getBindposes());
+		});
+	}
+
+	GameSceneReader::GameSceneReader(const char* data, std::size_t size, std::uint32_t version, Blobs* blobs) noexcept
+		: data_(data)
+		, end_(data + size)
+		, version_(version)
+		, blobs_(blobs)
+	{
+	}
+
+	GameSceneReader::~GameSceneReader() noexcept
+	{
+	}
+
+	std::uint32_t
+	GameSceneReader::version() const noexcept
+	{
+		return version_;
+	}
+
+	void
+	GameSceneReader::read(void* data, std::size_t size) except
+	{
+		if ((std::size_t)(end_ - data_) < size)
+			throw runtime::runtime_error::create("GameSceneFile : a record is truncated");
+
+		if (size > 0)
+		{
+			std::memcpy(data, data_, size);
+			data_ += size;
+		}
+	}
+
+	std::string
+	GameSceneReader::readString() except
+	{
+		std::string str(this->readCount(1), 0);
+		this->read(&str[0], str.size());
+		return str;
+	}
+
+	std::size_t
+	GameSceneReader::readCount(std::size_t elementSize) except
+	{
+		auto count = this->read<std::uint32_t>();
+		if (count > (std::size_t)(end_ - data_) / elementSize)
+			throw runtime::runtime_error::create("GameSceneFile : a record is truncated");
+
+		return count;
+	}
+
+	std::shared_ptr<void>
+	GameSceneReader::readShared(const Decoder& decoder) except
+	{
+		auto index = this->read<std::uint32_t>();
+		if (index == NullIndex)
+			return nullptr;
+
+		if (!blobs_ || index >= blobs_->records.size())
+			throw runtime::runtime_error::create("GameSceneFile : invalid blob index");
+
+		auto& object = blobs_->objects[index];
+		if (!object)
+		{
+			if (blobs_->decoding[index])
+				throw runtime::runtime_error::create("GameSceneFile : a blob references itself");
+
+			auto& record = blobs_->records[index];
+
+			blobs_->decoding[index] = true;
+			GameSceneReader reader(blobs_->data + record.offset, (std::size_t)record.size, version_, blobs_);
+			auto result = decoder(reader);
+			blobs_->decoding[index] = false;
+
+			blobs_->objects[index] = std::move(result);
+		}
+
+		return blobs_->objects[index];
+	}
+
+	model::MeshPtr
+	GameSceneReader::readMesh() except
+	{
+		return this->readShared<model::Mesh>([](GameSceneReader& reader)
+		{
+			auto mesh = std::make_shared<model::Mesh>();
+			mesh->setName(reader.readString());
+
+			math::float3s float3s;
+			math::float4s float4s;
+
+			reader.readArray(float3s);
+			mesh->setVertexArray(std::move(float3s));
+			reader.readArray(float3s);
+			mesh->setNormalArray(std::move(float3s));
+			reader.readArray(float4s);
+			mesh->setTangentArray(std::move(float4s));
+			reader.readArray(float4s);
+			mesh->setColorArray(std::move(float4s));
+
+			auto texcoords = reader.read<std::uint8_t>();
+			for (std::uint8_t i = 0; i < texcoords; i++)
+			{
+				math::float2s array;
+				reader.readArray(array);
+
+				if (i < TEXTURE_ARRAY_COUNT)
+					mesh->setTexcoordArray(std::move(array), i);
+			}
+
+			model::VertexWeights weights;
+			reader.readArray(weights);
+			mesh->setWeightArray(std::move(weights));
+
+			math::Uint1Array indices;
+			reader.readArray(indices);
+			mesh->setIndicesArray(std::move(indices));
+
+			math::float4x4s bindposes;
+			reader.readArray(bindposes);
+			mesh->setBindposes(std::move(bindposes));
+
+			mesh->computeBoundingBox();
+			return mesh;
+		});
+	}
+
+	void
+	GameSceneFile::registerComponent(const runtime::Rtti& type, std::uint32_t version, Writer&& writer, Reader&& reader) noexcept
+	{
+		auto& components = registry();
+
+		std::lock_guard<std::mutex> lock(registryMutex());
+		components[type.type_name()] = Registration{ version, std::move(writer), std::move(reader) };
+	}
+
+	void
+	GameSceneFile::unregisterComponent(const runtime::Rtti& type) noexcept
+	{
+		auto& components = registry();
+
+		std::lock_guard<std::mutex> lock(registryMutex());
+		components.erase(type.type_name());
+	}
+
+	void
+	GameSceneFile::save(const GameScene& scene, io::ostream& stream) except
+	{
+		StringTable strings;
+
+		std::vector<ObjectRecord> objects;
+		std::vector<ComponentRecord> components;
+		std::vector<std::uint8_t> payload;
+
+		GameSceneWriter writer;
+		writer.out_ = &payload;
+
+		auto name = strings.intern(scene.getName());
+
+		std::vector<std::pair<const GameObject*, std::uint32_t>> stack;
+
+		auto& roots = scene.root()->getChildren();
+		for (auto it = roots.rbegin(); it != roots.rend(); ++it)
+			stack.emplace_back(it->get(), NullIndex);
+
+		{
+			auto& registrations = registry();
+			std::lock_guard<std::mutex> lock(registryMutex());
+
+			while (!stack.empty())
+			{
+				auto object = stack.back().first;
+				auto parent = stack.back().second;
+				stack.pop_back();
+
+				ObjectRecord record;
+				record.name = strings.intern(object->getName());
+				record.parent = parent;
+				record.firstComponent = (std::uint32_t)components.size();
+				record.numComponents = (std::uint32_t)object->getComponents().size();
+				record.layer = object->getLayer();
+				record.active = object->getActive();
+				record.reserved = 0;
+
+				for (auto& component : object->getComponents())
+				{
+					auto& type = component->rtti()->type_name();
+
+					ComponentRecord entry;
+					entry.type = strings.intern(type);
+					entry.name = strings.intern(component->getName());
+					entry.version = 0;
+					entry.active = component->getActive();
+					entry.offset = payload.size();
+
+					auto it = registrations.find(type);
+					if (it != registrations.end())
+					{
+						entry.version = it->second.version;
+						it->second.writer(*component, writer);
+					}
+
+					entry.size = payload.size() - entry.offset;
+					components.push_back(entry);
+				}
+
+				auto index = (std::uint32_t)objects.size();
+				objects.push_back(record);
+
+				auto& children = object->getChildren();
+				for (auto it = children.rbegin(); it != children.rend(); ++it)
+					stack.emplace_back(it->get(), index);
+			}
+		}
+
+		std::vector<BlobRecord> blobs;
+		blobs.reserve(writer.blobs_.size());
+
+		std::uint64_t offset = payload.size();
+		for (auto& it : writer.blobs_)
+		{
+			blobs.push_back(BlobRecord{ offset, it.size() });
+			offset += it.size();
+		}
+
+		FileHeader header;
+		header.magic = SceneMagic;
+		header.version = Version;
+		header.name = name;
+		header.numStrings = (std::uint32_t)strings.records().size();
+		header.numObjects = (std::uint32_t)objects.size();
+		header.numComponents = (std::uint32_t)components.size();
+		header.numBlobs = (std::uint32_t)blobs.size();
+		header.stringBytes = (std::uint32_t)strings.chars().size();
+		header.payloadBytes = offset;
+
+		stream.write((const char*)&header, sizeof(header));
+		stream.write((const char*)strings.records().data(), strings.records().size() * sizeof(StringRecord));
+		stream.write(strings.chars().data(), strings.chars().size());
+		stream.write((const char*)objects.data(), objects.size() * sizeof(ObjectRecord));
+		stream.write((const char*)components.data(), components.size() * sizeof(ComponentRecord));
+		stream.write((const char*)blobs.data(), blobs.size() * sizeof(BlobRecord));
+		stream.write((const char*)payload.data(), payload.size());
+
+		for (auto& it : writer.blobs_)
+			stream.write((const char*)it.data(), it.size());
+
+		if (!stream)
+			throw runtime::runtime_error::create("GameSceneFile : failed to write the scene");
+	}
+
+	GameScenePtr
+	GameSceneFile::load(io::istream& stream) except
+	{
+		auto size = stream.size();
+		if (size < (io::streamsize)sizeof(FileHeader))
+			throw runtime::runtime_error::create("GameSceneFile : not a scene file");
+
+		// Mapped files are parsed in place.
+		auto data = stream.peek(size);
+		if (data)
+			return load(data, (std::size_t)size);
+
+		std::vector<char> buffer((std::size_t)size);
+		if (!stream.read(buffer.data(), size))
+			throw runtime::runtime_error::create("GameSceneFile : failed to read the scene");
+
+		return load(buffer.data(), buffer.size());
+	}
+
+	GameScenePtr
+	GameSceneFile::load(const char* data, std::size_t size) except
+	{
+		assert(data);
+
+		FileHeader header;
+		if (size < sizeof(header))
+			throw runtime::runtime_error::create("GameSceneFile : not a scene file");
+
+		std::memcpy(&header, data, sizeof(header));
+
+		if (header.magic != SceneMagic)
+			throw runtime::runtime_error::create("GameSceneFile : not a scene file");
+		if (header.version == 0 || header.version > Version)
+			throw runtime::runtime_error::create("GameSceneFile : unsupported version " + std::to_string(header.version));
+
+		auto it = data + sizeof(header);
+		auto end = data + size;
+
+		std::vector<StringRecord> stringRecords;
+		it = readRecords(it, end, header.numStrings, stringRecords);
+
+		if ((std::size_t)(end - it) < header.stringBytes)
+			throw runtime::runtime_error::create("GameSceneFile : the file is truncated");
+
+		auto chars = it;
+		it += header.stringBytes;
+
+		for (auto& record : stringRecords)
+		{
+			if ((std::uint64_t)record.offset + record.length > header.stringBytes)
+				throw runtime::runtime_error::create("GameSceneFile : invalid string record");
+		}
+
+		auto stringAt = [&](std::uint32_t index) -> std::string
+		{
+			if (index >= stringRecords.size())
+				throw runtime::runtime_error::create("GameSceneFile : invalid string index");
+			return std::string(chars + stringRecords[index].offset, stringRecords[index].length);
+		};
+
+		std::vector<ObjectRecord> objectRecords;
+		std::vector<ComponentRecord> componentRecords;
+
+		GameSceneReader::Blobs blobs;
+
+		it = readRecords(it, end, header.numObjects, objectRecords);
+		it = readRecords(it, end, header.numComponents, componentRecords);
+		it = readRecords(it, end, header.numBlobs, blobs.records);
+
+		if ((std::uint64_t)(end - it) < header.payloadBytes)
+			throw runtime::runtime_error::create("GameSceneFile : the file is truncated");
+
+		for (auto& record : componentRecords)
+		{
+			if (record.offset > header.payloadBytes || record.size > header.payloadBytes - record.offset)
+				throw runtime::runtime_error::create("GameSceneFile : invalid component record");
+		}
+
+		for (auto& record : blobs.records)
+		{
+			if (record.offset > header.payloadBytes || record.size > header.payloadBytes - record.offset)
+				throw runtime::runtime_error::create("GameSceneFile : invalid blob record");
+		}
+
+		blobs.data = it;
+		blobs.objects.resize(blobs.records.size());
+		blobs.decoding.resize(blobs.records.size());
+
+		// Types are looked up once per distinct name rather than once per record.
+		struct Type
+		{
+			bool resolved = false;
+			bool transform = false;
+			std::string name;
+			std::unique_ptr<Registration> registration;
+		};
+
+		std::vector<Type> types(stringRecords.size());
+
+		{
+			auto& registrations = registry();
+			std::lock_guard<std::mutex> lock(registryMutex());
+
+			for (auto& record : componentRecords)
+			{
+				if (record.type >= types.size())
+					throw runtime::runtime_error::create("GameSceneFile : invalid string index");
+
+				auto& type = types[record.type];
+				if (type.resolved)
+					continue;
+
+				type.resolved = true;
+				type.name = stringAt(record.type);
+				type.transform = type.name == TransformComponent::RTTI.type_name();
+
+				auto registration = registrations.find(type.name);
+				if (registration != registrations.end())
+					type.registration = std::make_unique<Registration>(registration->second);
+			}
+		}
+
+		auto scene = std::make_shared<GameScene>();
+		scene->setName(stringAt(header.name));
+
+		std::vector<std::uint32_t> numChildren(objectRecords.size() + 1);
+		for (std::size_t i = 0; i < objectRecords.size(); i++)
+		{
+			auto parent = objectRecords[i].parent;
+			if (parent != NullIndex && parent >= i)
+				throw runtime::runtime_error::create("GameSceneFile : invalid parent index");
+
+			numChildren[parent == NullIndex ? objectRecords.size() : parent]++;
+		}
+
+		auto& root = scene->root();
+		root->children_.reserve(root->children_.size() + numChildren.back());
+
+		std::vector<GameObjectPtr> objects;
+		objects.reserve(objectRecords.size());
+
+		for (std::size_t i = 0; i < objectRecords.size(); i++)
+		{
+			auto& record = objectRecords[i];
+
+			auto object = std::make_shared<GameObject>();
+			object->name_ = stringAt(record.name);
+			object->layer_ = record.layer;
+			object->children_.reserve(numChildren[i]);
+
+			// Created inactive and linked directly, nothing is notified until the activation pass below.
+			// The transform attached by the constructor has no activation hook to undo.
+			object->active_ = false;
+
+			auto& parent = record.parent == NullIndex ? root : objects[record.parent];
+			object->parent_ = parent;
+			parent->children_.push_back(object);
+
+			if ((std::uint64_t)record.firstComponent + record.numComponents > componentRecords.size())
+				throw runtime::runtime_error::create("GameSceneFile : invalid component range");
+
+			for (std::uint32_t j = record.firstComponent; j < record.firstComponent + record.numComponents; j++)
+			{
+				auto& entry = componentRecords[j];
+				auto& type = types[entry.type];
+
+				GameComponentPtr component;
+				if (type.transform)
+					component = object->getComponent<TransformComponent>();
+				else
+					component = runtime::RttiFactory::instance()->make_shared<GameComponent>(type.name);
+
+				if (!component)
+					continue;
+
+				component->setName(stringAt(entry.name));
+
+				if (type.registration && entry.size > 0)
+				{
+					GameSceneReader reader(blobs.data + entry.offset, (std::size_t)entry.size, entry.version, &blobs);
+					type.registration->reader(*component, reader);
+				}
+
+				if (!type.transform)
+					object->addComponent(component);
+
+				if (!entry.active)
+					component->setActive(false);
+			}
+
+			objects.push_back(std::move(object));
+		}
+
+		for (std::size_t i = 0; i < objects.size(); i++)
+		{
+			if (objectRecords[i].active)
+			{
+				objects[i]->onActivate();
+				objects[i]->active_ = true;
+			}
+		}
+
+		return scene;
+	}
+}
@@ -1,9 +1,13 @@
 #include <octoon/game_server.h>
 #include <octoon/game_scene.h>
+#include <octoon/game_scene_file.h>
 #include <octoon/game_feature.h>
 #include <octoon/game_listener.h>
+#include <octoon/runtime/except.h>
 #include <octoon/runtime/algorithm.h>
 
+#include <octoon/io/vstream.h>
+
 namespace octoon
 {
 	OctoonImplementSubClass(GameServer, runtime::RttiInterface, "GameServer")
@@ -83,7 +87,11 @@ namespace octoon
 
 		try
 		{
-			auto scene = std::make_shared<GameScene>();
+			io::ivstream stream(filename);
+			if (!stream.is_open())
+				throw runtime::runtime_error::create("GameServer : Could not open scene : " + filename);
+
+			auto scene = GameSceneFile::load(stream);
 			scene->setGameListener(game_listener_);
 
 			return this->addScene(scene);
@@ -2,9 +2,34 @@
 #include <octoon/io_feature.h>
 #include <octoon/io/ioserver.h>
 #include <octoon/io/farchive.h>
+#include <octoon/image/image.h>
+#include <octoon/model/model.h>
+#include <octoon/model/mesh.h>
+#include <octoon/model/bone.h>
 
 namespace octoon
 {
+	namespace
+	{
+		std::size_t sizeOf(const model::Model& model) noexcept
+		{
+			std::size_t bytes = sizeof(model::Model);
+
+			for (auto& mesh : model.getMeshsList())
+			{
+				bytes += mesh->getVertexArray().size() * sizeof(math::float3);
+				bytes += mesh->getNormalArray().size() * sizeof(math::float3);
+				bytes += mesh->getTangentArray().size() * sizeof(math::float4);
+				bytes += mesh->getColorArray().size() * sizeof(math::float4);
+				bytes += mesh->getTexcoordArray().size() * sizeof(math::float2);
+				bytes += mesh->getWeightArray().size() * sizeof(model::VertexWeight);
+				bytes += mesh->getIndicesArray().size() * sizeof(std::uint32_t);
+			}
+
+			return bytes;
+		}
+	}
+
 	OctoonImplementSubClass(IOFeature, GameFeature, "IOFeature")
 
 	IOFeature::IOFeature() noexcept
@@ -16,21 +41,111 @@ namespace octoon
 	{
 	}
 
+	IOFeature::Ticket
+	IOFeature::loadBytes(const std::string& path, std::function<void(const std::shared_ptr<Bytes>&)>&& callback, io::LoadPriority priority) noexcept
+	{
+		io::Orl orl;
+		if (!loader_ || !io::Orl::parse(path, orl))
+			return Ticket();
+
+		io::AsyncLoader::Callback done;
+		if (callback)
+			done = [callback = std::move(callback)](const std::shared_ptr<void>& result) { callback(std::static_pointer_cast<Bytes>(result)); };
+
+		return loader_->load_bytes(orl, std::move(done), priority);
+	}
+
+	IOFeature::Ticket
+	IOFeature::loadImage(const std::string& path, std::function<void(const std::shared_ptr<image::Image>&)>&& callback, io::LoadPriority priority) noexcept
+	{
+		io::Orl orl;
+		if (!loader_ || !io::Orl::parse(path, orl))
+			return Ticket();
+
+		auto decoder = [cache = cache_.get(), orl](io::istream& stream) -> std::shared_ptr<void>
+		{
+			auto image = std::make_shared<image::Image>();
+			if (!image->load(stream))
+				return nullptr;
+
+			cache->insert(orl, nullptr, image, image->size());
+			return image;
+		};
+
+		io::AsyncLoader::Callback done;
+		if (callback)
+			done = [callback = std::move(callback)](const std::shared_ptr<void>& result) { callback(std::static_pointer_cast<image::Image>(result)); };
+
+		auto cached = cache_->get<image::Image>(orl);
+		if (cached)
+			return loader_->resolve(std::move(cached), std::move(done));
+
+		return loader_->load(orl, "image", std::move(decoder), std::move(done), priority);
+	}
+
+	IOFeature::Ticket
+	IOFeature::loadModel(const std::string& path, std::function<void(const std::shared_ptr<model::Model>&)>&& callback, io::LoadPriority priority) noexcept
+	{
+		io::Orl orl;
+		if (!loader_ || !io::Orl::parse(path, orl))
+			return Ticket();
+
+		auto decoder = [cache = cache_.get(), orl](io::istream& stream) -> std::shared_ptr<void>
+		{
+			auto model = std::make_shared<model::Model>();
+			if (!model->load(stream))
+				return nullptr;
+
+			cache->insert(orl, nullptr, model, sizeOf(*model));
+			return model;
+		};
+
+		io::AsyncLoader::Callback done;
+		if (callback)
+			done = [callback = std::move(callback)](const std::shared_ptr<void>& result) { callback(std::static_pointer_cast<model::Model>(result)); };
+
+		auto cached = cache_->get<model::Model>(orl);
+		if (cached)
+			return loader_->resolve(std::move(cached), std::move(done));
+
+		return loader_->load(orl, "model", std::move(decoder), std::move(done), priority);
+	}
+
+	io::AsyncLoader*
+	IOFeature::getLoader() const noexcept
+	{
+		return loader_.get();
+	}
+
+	io::ResourceCache*
+	IOFeature::getCache() const noexcept
+	{
+		return cache_.get();
+	}
+
 	void
 	IOFeature::onActivate() except
 	{
 		io::IoServer::instance()->mount_archive("sys", std::make_shared<octoon::io::farchive>(system_path_));
+
+		cache_ = std::make_unique<io::ResourceCache>();
+		loader_ = std::make_unique<io::AsyncLoader>();
 	}
 
 	void
 	IOFeature::onDeactivate() noexcept
 	{
+		loader_.reset();
+		cache_.reset();
+
 		io::IoServer::instance()->unmount_archive("sys");
 	}
 
 	void
 	IOFeature::onFrameBegin() noexcept
 	{
+		if (loader_)
+			loader_->dispatch();
 	}
 
 	void
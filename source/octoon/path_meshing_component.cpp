@@ -4,7 +4,9 @@
 #include <octoon/runtime/except.h>
 #include <octoon/mesh_filter_component.h>
 #include <octoon/transform_component.h>
-#include <octoon/runtime/json.h>
+#include <octoon/io/json_reader.h>
+
+#include <cstring>
 
 #define POD_TT_PRIM_NONE 0
 #define POD_TT_PRIM_LINE 1   	// line to, һx,y]
@@ -16,6 +18,69 @@
 
 namespace octoon
 {
+	namespace
+	{
+		// Collects paths[i].points of a path document, each point being [x, y, type].
+		class PathHandler final : public io::JsonHandler
+		{
+		public:
+			std::vector<std::vector<math::float3>> paths;
+
+			bool onStartObject() override
+			{
+				if (++depth_ == 3 && inPaths_)
+					paths.emplace_back();
+				return true;
+			}
+
+			bool onEndObject() override
+			{
+				depth_--;
+				return true;
+			}
+
+			bool onKey(const char* key, std::size_t length) override
+			{
+				if (depth_ == 1)
+					pathsKey_ = length == 5 && std::memcmp(key, "paths", 5) == 0;
+				else if (depth_ == 3)
+					pointsKey_ = inPaths_ && length == 6 && std::memcmp(key, "points", 6) == 0;
+				return true;
+			}
+
+			bool onStartArray() override
+			{
+				if (++depth_ == 2 && pathsKey_)
+					inPaths_ = true;
+				return true;
+			}
+
+			bool onEndArray() override
+			{
+				if (depth_-- == 2)
+					inPaths_ = false;
+				return true;
+			}
+
+			bool wantFloat3Array() override
+			{
+				return depth_ == 4 && std::exchange(pointsKey_, false);
+			}
+
+			bool onFloat3Array(const math::float3* values, std::size_t count) override
+			{
+				paths.back().insert(paths.back().end(), values, values + count);
+				return true;
+			}
+
+		private:
+			int depth_ = 0;
+			bool inPaths_ = false;
+			bool pathsKey_ = false;
+			bool pointsKey_ = false;
+		};
+	}
+
 	OctoonImplementSubClass(PathMeshingComponent, MeshFilterComponent, "PathMeshingComponent")
 
 	PathMeshingComponent::PathMeshingComponent() noexcept
@@ -152,39 +217,41 @@ namespace octoon
 			return;
 		}
 
-		auto reader = json::parse(data);
+		PathHandler handler;
+		io::JsonReader::parse(data.data(), data.size(), handler);
 
 		model::Contours contours;
 
-		for (auto& path : reader["paths"])
+		for (auto& points : handler.paths)
 		{
-			json::pointer prev = nullptr;
-			json::pointer cur = nullptr;
-			json::reference points = path["points"];
+			const math::float3* prev = nullptr;
 
 			auto contour = std::make_unique<model::Contour>();
 
-			for (int index = 0; index < points.size(); index++)
+			for (std::size_t index = 0; index < points.size(); index++)
 			{
-				cur = &points[index];
+				auto& cur = points[index];
 
-				switch (cur->at(2).get<json::number_unsigned_t>())
+				switch (static_cast<std::uint32_t>(cur.z))
 				{
 				case POD_TT_PRIM_LINE:
 				{
-					contour->addPoints(math::float3(cur->at(0).get<json::number_float_t>(), cur->at(1).get<json::number_float_t>(), 0));
-					prev = cur;
+					contour->addPoints(math::float3(cur.x, cur.y, 0));
+					prev = &cur;
 				}
 				break;
 				case POD_TT_PRIM_QSPLINE:
 				{
+					if (!prev || index + 1 >= points.size())
+						throw runtime::runtime_error::create("invalid bezier path");
+
 					auto& p1 = *prev;
-					auto& p2 = *cur;
+					auto& p2 = cur;
 					auto& p3 = points[index + 1];
 
-					math::float3 A(p1[0].get<json::number_float_t>(), p1[1].get<json::number_float_t>(), 0.0);
-					math::float3 B(p2[0].get<json::number_float_t>(), p2[1].get<json::number_float_t>(), 0.0);
-					math::float3 C(p3[0].get<json::number_float_t>(), p3[1].get<json::number_float_t>(), 0.0);
+					math::float3 A(p1.x, p1.y, 0.0);
+					math::float3 B(p2.x, p2.y, 0.0);
+					math::float3 C(p3.x, p3.y, 0.0);
 
 					contour->addPoints(A, B, C, bezierSteps_);
 
@@ -195,15 +262,18 @@ namespace octoon
 				break;
 				case POD_TT_PRIM_CSPLINE:
 				{
+					if (!prev || index + 2 >= points.size())
+						throw runtime::runtime_error::create("invalid bezier path");
+
 					auto& p1 = *prev;
-					auto& p2 = *cur;
+					auto& p2 = cur;
 					auto& p3 = points[index + 1];
 					auto& p4 = points[index + 2];
 
-					math::float3 A(p1[0].get<json::number_float_t>(), p1[1].get<json::number_float_t>(), 0.0);
-					math::float3 B(p2[0].get<json::number_float_t>(), p2[1].get<json::number_float_t>(), 0.0);
-					math::float3 C(p3[0].get<json::number_float_t>(), p3[1].get<json::number_float_t>(), 0.0);
-					math::float3 D(p4[0].get<json::number_float_t>(), p4[1].get<json::number_float_t>(), 0.0);
+					math::float3 A(p1.x, p1.y, 0.0);
+					math::float3 B(p2.x, p2.y, 0.0);
+					math::float3 C(p3.x, p3.y, 0.0);
+					math::float3 D(p4.x, p4.y, 0.0);
 
 					contour->addPoints(A, B, C, D, bezierSteps_);
 
@@ -214,16 +284,16 @@ namespace octoon
 				break;
 				case POD_TT_PRIM_MOVE:
 				{
-					contour->addPoints(math::float3(cur->at(0).get<json::number_float_t>(), cur->at(1).get<json::number_float_t>(), 0));
-					prev = cur;
+					contour->addPoints(math::float3(cur.x, cur.y, 0));
+					prev = &cur;
 				}
 				break;
 				case POD_TT_PRIM_CLOSE:
 				{
-					contour->addPoints(math::float3(cur->at(0).get<json::number_float_t>(), cur->at(1).get<json::number_float_t>(), 0));
+					contour->addPoints(math::float3(cur.x, cur.y, 0));
 					contour->addPoints(contour->at(0));
 
-					prev = cur;
+					prev = &cur;
 				}
 				break;
 				default:
@@ -96,11 +96,25 @@ namespace octoon
 	}
 
 	void
-	VideoFeature::saveAsPNG(const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height) noexcept(false)
+	VideoFeature::saveAsPNG(const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, int level) noexcept(false)
 	{
 		auto graphics = this->getFeature<GraphicsFeature>();
 		if (graphics)
-			video::RenderSystem::instance()->saveAsPNG(*graphics->getContext(), filepath, x, y, width, height);
+			video::RenderSystem::instance()->saveAsPNG(*graphics->getContext(), filepath, x, y, width, height, level);
+	}
+
+	void
+	VideoFeature::saveAsPNGAsync(const char* filepath, std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, int level) noexcept(false)
+	{
+		auto graphics = this->getFeature<GraphicsFeature>();
+		if (graphics)
+			video::RenderSystem::instance()->saveAsPNGAsync(*graphics->getContext(), filepath, x, y, width, height, level);
+	}
+
+	void
+	VideoFeature::flushReadback() noexcept(false)
+	{
+		video::RenderSystem::instance()->flushReadback();
 	}
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+// File: benchmark.h
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace Benchmark {
+
+// Runs the body until at least `budget` milliseconds have passed, returns milliseconds per run.
+template<typename Body>
+double Measure(Body&& body, double budget = 250.0) {
+  using clock = std::chrono::steady_clock;
+
+  body();
+
+  std::size_t runs = 0;
+  auto start = clock::now();
+  double elapsed = 0.0;
+  do {
+    body();
+    ++runs;
+    elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+  } while (elapsed < budget);
+
+  return elapsed / runs;
+}
+
+inline void Report(const std::string& name, double ms, const std::string& detail = std::string()) {
+  std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << ms << " ms";
+  if (!detail.empty())
+    std::cout << "  " << detail;
+  std::cout << std::endl;
+}
+
+// Peak resident memory in KB since the last reset, 0 where /proc is missing.
+inline std::size_t PeakRss(bool reset) {
+#if defined(__linux__)
+  if (reset)
+    std::ofstream("/proc/self/clear_refs") << "5";
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::stoul(line.substr(6));
+  }
+#endif
+  return 0;
+}
+
+// Read and write system calls of the process so far, 0 where /proc is missing.
+inline std::size_t Syscalls() {
+  std::size_t count = 0;
+#if defined(__linux__)
+  std::ifstream io("/proc/self/io");
+  std::string line;
+  while (std::getline(io, line)) {
+    if (line.compare(0, 6, "syscr:") == 0 || line.compare(0, 6, "syscw:") == 0)
+      count += std::stoul(line.substr(6));
+  }
+#endif
+  return count;
+}
+
+// Megabytes or items per second of a run taking `ms`.
+inline std::string Rate(double amount, double ms, const char* unit) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1) << amount / ms * 1000.0 << ' ' << unit << "/s";
+  return out.str();
+}
+
+}
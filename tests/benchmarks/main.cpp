@@ -0,0 +1,17 @@
+#include <iostream>
+
+void bench_octoon();
+void bench_octoon_io();
+void bench_octoon_image();
+void bench_octoon_model();
+
+int main() {
+  std::cout << "Benchmarking Octoon components..." << std::endl;
+
+  bench_octoon();
+  bench_octoon_io();
+  bench_octoon_image();
+  bench_octoon_model();
+
+  return 0;
+}
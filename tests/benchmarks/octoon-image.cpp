@@ -0,0 +1,402 @@
+// File: octoon-image.cpp
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <csetjmp>
+
+#include <png.h>
+
+#include "octoon/image/image.h"
+#include "octoon/image/image_atlas.h"
+#include "octoon/image/image_batch.h"
+#include "octoon/image/image_compressor.h"
+#include "octoon/image/image_converter.h"
+#include "octoon/image/image_jpeg_codec.h"
+#include "octoon/image/image_mipmap.h"
+#include "octoon/image/image_reader.h"
+#include "octoon/image/image_png_encoder.h"
+#include "octoon/io/file_buf.h"
+#include "octoon/io/istream.h"
+#include "octoon/io/mstream.h"
+
+#include "benchmark.h"
+
+using namespace octoon::image;
+using octoon::io::mstream;
+using octoon::io::ios_base;
+
+namespace {
+
+Image make_noise(Format format, std::uint32_t size) {
+  Image image(Format::R8G8B8A8UNorm, size, size);
+  std::uint32_t seed = 1;
+  for (std::size_t i = 0; i < image.size(); i++) {
+    seed = seed * 1664525 + 1013904223;
+    ((std::uint8_t*)image.data())[i] = (std::uint8_t)(seed >> 24);
+  }
+  return format == image.format() ? image : Image(format, image);
+}
+
+// Smooth ramps with a little noise, which the codecs treat more like a photo than noise.
+Image make_photo(std::uint32_t width, std::uint32_t height) {
+  Image image(Format::R8G8B8A8UNorm, width, height);
+  auto data = (std::uint8_t*)image.data();
+  std::uint32_t seed = 99;
+  for (std::uint32_t y = 0; y < height; ++y) {
+    for (std::uint32_t x = 0; x < width; ++x) {
+      seed = seed * 1664525 + 1013904223;
+      float u = x / float(width), v = y / float(height);
+      float noise = ((seed >> 24) / 255.0f - 0.5f) * 0.06f;
+      float rgba[4] = { u * 0.8f + noise, v * 0.7f + 0.15f * std::sin(u * 9.0f) + noise, 0.5f + 0.4f * std::cos((u + v) * 6.0f) + noise, 1.0f };
+      for (int c = 0; c < 4; ++c)
+        data[(y * width + x) * 4 + c] = (std::uint8_t)std::lround(std::min(std::max(rgba[c], 0.0f), 1.0f) * 255.0f);
+    }
+  }
+  return image;
+}
+
+std::string save_file(Image& image, const char* type, const std::string& name) {
+  mstream stream(1);
+  image.save(stream, type);
+  std::vector<char> bytes((std::size_t)stream.size());
+  stream.seekg(0, ios_base::beg);
+  stream.read(bytes.data(), bytes.size());
+  std::ofstream(name, std::ios::binary).write(bytes.data(), bytes.size());
+  return name;
+}
+
+// Rates count the bytes read and written.
+void bench_conversion() {
+  const struct { const char* name; Format src; Format dst; } pairs[] = {
+    { "rgba8_bgra8", Format::R8G8B8A8UNorm, Format::B8G8R8A8UNorm },
+    { "rgb8_rgba8", Format::R8G8B8UNorm, Format::R8G8B8A8UNorm },
+    { "rgba8_rgba32f", Format::R8G8B8A8UNorm, Format::R32G32B32A32SFloat },
+    { "rgba32f_rgba8", Format::R32G32B32A32SFloat, Format::R8G8B8A8UNorm },
+    { "srgb8_rgba16f", Format::R8G8B8A8SRGB, Format::R16G16B16A16SFloat },
+    { "rgba16f_srgb8", Format::R16G16B16A16SFloat, Format::R8G8B8A8SRGB },
+    { "rgba8_r5g6b5", Format::R8G8B8A8UNorm, Format::R5G6B5UNormPack16 },
+    { "rgb32f_b10g11r11", Format::R32G32B32SFloat, Format::B10G11R11UFloatPack32 },
+  };
+
+  for (auto& pair : pairs) {
+    Image src(pair.src, 2048, 1024);
+    Image dst;
+    FormatConverter converter(pair.src, pair.dst);
+    auto ms = Benchmark::Measure([&] { converter.convert(src, dst); });
+    Benchmark::Report(std::string("convert_2048x1024_") + pair.name, ms, Benchmark::Rate((src.size() + dst.size()) / 1e6, ms, "MB"));
+  }
+}
+
+// 48 photos of 512x512, half PNG and half JPEG, loaded by more and more threads.
+void bench_batch_loading() {
+  std::vector<std::string> photos;
+  {
+    Image rgba = make_photo(512, 512);
+    Image rgb(Format::R8G8B8UNorm, rgba);
+    for (std::size_t i = 0; i < 48; i++) {
+      std::string name = "octoon-batch-bench-" + std::to_string(i) + (i % 2 ? ".jpg" : ".png");
+      photos.push_back(save_file(i % 2 ? rgb : rgba, i % 2 ? "jpg" : "png", name));
+    }
+  }
+
+  std::size_t most = std::max(4u, std::thread::hardware_concurrency());
+  for (std::size_t threads = 1; threads <= most; threads = threads < most && threads * 2 > most ? most : threads * 2) {
+    BatchLoader loader(threads);
+    auto ms = Benchmark::Measure([&] { loader.load(photos); });
+    Benchmark::Report("batch_load_48x512_" + std::to_string(threads) + "_threads", ms, Benchmark::Rate((double)photos.size(), ms, "images"));
+  }
+
+  for (auto& path : photos)
+    std::remove(path.c_str());
+}
+
+// A 1024x1024 photo as PNG and JPEG read from a file without a block and with the default one.
+void bench_file_loading() {
+  Image rgba = make_photo(1024, 1024);
+  Image rgb(Format::R8G8B8UNorm, rgba);
+  const std::string files[] = { save_file(rgba, "png", "octoon-file-bench.png"), save_file(rgb, "jpg", "octoon-file-bench.jpg") };
+
+  for (auto& path : files) {
+    for (auto blockSize : { std::size_t(0), octoon::io::filebuf::default_block_size }) {
+      auto load = [&] {
+        octoon::io::filebuf buf;
+        buf.set_block_size(blockSize);
+        buf.open(path, ios_base::in);
+        octoon::io::istream stream(&buf);
+        Image image;
+        image.load(stream);
+      };
+
+      auto ms = Benchmark::Measure(load);
+      auto before = Benchmark::Syscalls();
+      load();
+      auto syscalls = Benchmark::Syscalls() - before;
+      Benchmark::Report("file_load_1024_" + path.substr(path.size() - 3) + (blockSize ? "_64k" : "_unbuffered"), ms, std::to_string(syscalls) + " syscalls");
+    }
+    std::remove(path.c_str());
+  }
+}
+
+// A 512x512 photo compressed into every block format at both qualities, from the texel
+// format each one decodes to.
+void bench_block_compress() {
+  const std::pair<const char*, Format> formats[] = {
+    { "bc1", Format::BC1RGBUNormBlock }, { "bc2", Format::BC2UNormBlock }, { "bc3", Format::BC3UNormBlock },
+    { "bc4", Format::BC4UNormBlock }, { "bc5s", Format::BC5SNormBlock }, { "bc6h", Format::BC6HUFloatBlock },
+    { "bc7", Format::BC7UNormBlock },
+  };
+
+  Image src = make_photo(512, 512);
+  auto megapixels = 512 * 512 / 1e6;
+  for (auto& format : formats) {
+    Image texels(BlockDecompressor::getDestFormat(format.second), src);
+    for (auto quality : { CompressQuality::Fast, CompressQuality::High }) {
+      BlockCompressor compressor(quality);
+      Image blocks;
+      auto ms = Benchmark::Measure([&] { compressor.compress(texels, blocks, format.second, 1); });
+      Benchmark::Report(std::string("compress_512_") + format.first + (quality == CompressQuality::Fast ? "_fast" : "_high"), ms, Benchmark::Rate(megapixels, ms, "MPixel"));
+    }
+  }
+}
+
+// The same photo at 1024x1024 decoded to 8 bit and to half float texels.
+void bench_block_decompress() {
+  const std::pair<const char*, Format> formats[] = {
+    { "bc1", Format::BC1RGBUNormBlock }, { "bc3", Format::BC3UNormBlock }, { "bc4", Format::BC4UNormBlock },
+    { "bc5", Format::BC5UNormBlock }, { "bc6h", Format::BC6HUFloatBlock }, { "bc7", Format::BC7UNormBlock },
+  };
+
+  Image texels = make_photo(1024, 1024);
+  auto megapixels = 1024 * 1024 / 1e6;
+  for (auto& format : formats) {
+    Image blocks;
+    BlockCompressor().compress(texels, blocks, format.second, 1);
+
+    for (auto target : { Format(Format::R8G8B8A8UNorm), Format(Format::R16G16B16A16SFloat) }) {
+      BlockDecompressor decompressor;
+      Image decoded;
+      auto ms = Benchmark::Measure([&] { decompressor.decompress(blocks, decoded, target); });
+      Benchmark::Report(std::string("decompress_1024_") + format.first + (target == Format::R8G8B8A8UNorm ? "_rgba8" : "_rgba16f"), ms, Benchmark::Rate(megapixels, ms, "MPixel"));
+    }
+  }
+}
+
+// A 4096x4096 PNG loaded whole and read in bands of 64 rows, with the peak resident memory
+// each way takes on top of what the process held before.
+void bench_band_decode() {
+  const std::uint32_t size = 4096;
+  mstream png(1);
+  {
+    Image large = make_photo(size, size);
+    PNGEncoder(1).encode(png, large);
+  }
+
+  auto base = Benchmark::PeakRss(true);
+  auto ms = Benchmark::Measure([&] {
+    png.seekg(0, ios_base::beg);
+    Image whole;
+    whole.load(png, "png");
+  });
+  auto peak = Benchmark::PeakRss(false);
+  Benchmark::Report("png_4096_whole", ms, "peak +" + std::to_string(peak - base) + " KB");
+
+  std::vector<char> band(size * 4 * 64);
+  base = Benchmark::PeakRss(true);
+  ms = Benchmark::Measure([&] {
+    png.seekg(0, ios_base::beg);
+    auto reader = ImageReader::open(png, "png");
+    reader->read(band.data(), size * 4, 64);
+  });
+  Benchmark::Report("png_4096_first_band", ms, "64 rows");
+
+  ms = Benchmark::Measure([&] {
+    png.seekg(0, ios_base::beg);
+    auto reader = ImageReader::open(png, "png");
+    while (reader->read(band.data(), size * 4, 64) > 0)
+      ;
+  });
+  peak = Benchmark::PeakRss(false);
+  Benchmark::Report("png_4096_bands", ms, "peak +" + std::to_string(peak - base) + " KB");
+}
+
+// The libpng path saveAsPNG took before PNGEncoder, every row handed to png_write_image at
+// libpng's default level, written to memory.
+std::size_t libpng_encode(const Image& image, std::vector<std::uint8_t>& out) {
+  out.clear();
+  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  png_infop info = png_create_info_struct(png);
+  if (setjmp(png_jmpbuf(png))) {
+    png_destroy_write_struct(&png, &info);
+    return 0;
+  }
+
+  png_set_write_fn(png, &out, [](png_structp png, png_bytep data, png_size_t length) {
+    auto out = (std::vector<std::uint8_t>*)png_get_io_ptr(png);
+    out->insert(out->end(), data, data + length);
+  }, nullptr);
+  png_set_IHDR(png, info, image.width(), image.height(), 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+  png_write_info(png, info);
+
+  std::vector<png_bytep> rows(image.height());
+  for (std::uint32_t y = 0; y < image.height(); y++)
+    rows[y] = (png_bytep)image.data() + (std::size_t)y * image.width() * 4;
+  png_write_image(png, rows.data());
+  png_write_end(png, info);
+  png_destroy_write_struct(&png, &info);
+  return out.size();
+}
+
+// Screenshot sized photos through libpng and through PNGEncoder at its default and at libpng's level.
+void bench_png_encode() {
+  const struct { std::uint32_t width, height; } sizes[] = { { 640, 360 }, { 1920, 1080 }, { 3840, 2160 } };
+
+  for (auto& size : sizes) {
+    Image image = make_photo(size.width, size.height);
+    auto name = "png_encode_" + std::to_string(size.width) + "x" + std::to_string(size.height);
+    auto megapixels = size.width * size.height / 1e6;
+
+    std::vector<std::uint8_t> file;
+    auto ms = Benchmark::Measure([&] { libpng_encode(image, file); });
+    Benchmark::Report(name + "_libpng", ms, Benchmark::Rate(megapixels, ms, "MPixel") + ", " + std::to_string(file.size() / 1024) + " KB");
+
+    for (int level : { 3, 6 }) {
+      PNGEncoder encoder(level);
+      mstream stream(1);
+      ms = Benchmark::Measure([&] {
+        stream.seekg(0, ios_base::beg);
+        encoder.encode(stream, image);
+      });
+      Benchmark::Report(name + "_level" + std::to_string(level), ms, Benchmark::Rate(megapixels, ms, "MPixel") + ", " + std::to_string(stream.tellg() / 1024) + " KB");
+    }
+  }
+}
+
+// A 2048x2048 photo decoded in every mode and encoded at two qualities.
+void bench_jpeg() {
+  const std::uint32_t size = 2048;
+  Image photo(Format::R8G8B8UNorm, make_photo(size, size));
+
+  mstream encoded(1);
+  JPEGEncoder(90).encode(encoded, photo);
+
+  const struct { const char* name; std::uint32_t scale; bool fast; bool alpha; } modes[] = {
+    { "full", 1, false, false }, { "full_rgba", 1, false, true }, { "fast_dct", 1, true, false },
+    { "half", 2, false, false }, { "quarter", 4, false, false }, { "eighth", 8, false, false },
+  };
+  for (auto& mode : modes) {
+    JPEGDecoder decoder;
+    decoder.setScale(mode.scale);
+    decoder.setFastDCT(mode.fast);
+    decoder.setAlpha(mode.alpha);
+
+    Image image;
+    auto ms = Benchmark::Measure([&] {
+      encoded.seekg(0, ios_base::beg);
+      decoder.decode(encoded, image);
+    });
+    Benchmark::Report(std::string("jpeg_decode_2048_") + mode.name, ms, Benchmark::Rate(size * (double)size / 1e6, ms, "MP of source"));
+  }
+
+  for (auto quality : { 75, 90 }) {
+    for (auto optimize : { false, true }) {
+      JPEGEncoder encoder(quality);
+      encoder.setOptimizeCoding(optimize);
+
+      std::size_t bytes = 0;
+      auto ms = Benchmark::Measure([&] {
+        mstream stream(1);
+        encoder.encode(stream, photo);
+        bytes = (std::size_t)stream.size();
+      });
+      Benchmark::Report("jpeg_encode_2048_q" + std::to_string(quality) + (optimize ? "_optimized" : ""), ms, std::to_string(bytes / 1024) + " KB");
+    }
+  }
+}
+
+// Full chains from 2048x2048, sRGB and half floats go through the float codec.
+void bench_mipmap() {
+  const std::uint32_t size = 2048;
+
+  const struct { const char* name; Format format; } formats[] = {
+    { "rgba8", Format::R8G8B8A8UNorm }, { "srgb8", Format::R8G8B8A8SRGB }, { "rgba16f", Format::R16G16B16A16SFloat },
+  };
+  const struct { const char* name; MipmapFilter filter; } filters[] = {
+    { "box", MipmapFilter::Box }, { "kaiser", MipmapFilter::Kaiser }, { "lanczos", MipmapFilter::Lanczos },
+  };
+
+  for (auto& format : formats) {
+    Image src = make_noise(format.format, size);
+    for (auto& filter : filters) {
+      Image chain;
+      MipmapGenerator generator(filter.filter);
+      auto ms = Benchmark::Measure([&] { generator.generate(src, chain); });
+      Benchmark::Report(std::string("mipmap_2048_") + format.name + "_" + filter.name, ms, Benchmark::Rate(size * (double)size / 1e6, ms, "MP"));
+    }
+  }
+}
+
+// Random glyph sizes into 1024x1024 until a hundred of them no longer fit.
+std::vector<std::uint32_t> fill_atlas(ImageAtlas& atlas, std::uint32_t& seed) {
+  static const std::vector<char> glyph(48 * 48, 1);
+  auto random = [&](std::uint32_t lo, std::uint32_t hi) { seed = seed * 1664525 + 1013904223; return lo + (seed >> 8) % (hi - lo + 1); };
+
+  std::vector<std::uint32_t> ids;
+  for (std::uint32_t misses = 0; misses < 100;) {
+    auto id = atlas.insert(random(6, 40), random(10, 44), glyph.data(), 48);
+    if (id)
+      ids.push_back(id);
+    else
+      misses++;
+  }
+  return ids;
+}
+
+// Filling, then removing every other glyph and filling again, Skyline only gets the space back by defragmenting.
+void bench_atlas() {
+  for (auto packing : { AtlasPacking::Skyline, AtlasPacking::MaxRects }) {
+    std::string name = packing == AtlasPacking::Skyline ? "atlas_skyline" : "atlas_maxrects";
+
+    std::size_t glyphs = 0;
+    float full = 0.0f;
+    auto ms = Benchmark::Measure([&] {
+      ImageAtlas atlas(Format::R8UNorm, 1024, 1024, 1, 1, packing);
+      std::uint32_t seed = 11;
+      glyphs = fill_atlas(atlas, seed).size();
+      full = atlas.getOccupancy();
+    });
+    Benchmark::Report(name + "_fill", ms, std::to_string(glyphs) + " glyphs, " + std::to_string((int)(full * 100.0f)) + "% used, " + Benchmark::Rate(glyphs / 1000.0, ms, "k inserts"));
+
+    ImageAtlas atlas(Format::R8UNorm, 1024, 1024, 1, 1, packing);
+    std::uint32_t seed = 11;
+    auto ids = fill_atlas(atlas, seed);
+    for (std::size_t i = 0; i < ids.size(); i += 2)
+      atlas.remove(ids[i]);
+    auto refilled = fill_atlas(atlas, seed).size();
+    float churned = atlas.getOccupancy();
+
+    // Every call repacks all entries, so the atlas need not be rebuilt between runs.
+    ms = Benchmark::Measure([&] { atlas.defragment(); });
+    fill_atlas(atlas, seed);
+    Benchmark::Report(name + "_defragment", ms, std::to_string(refilled) + " refilled to " + std::to_string((int)(churned * 100.0f)) + "% used, " + std::to_string((int)(atlas.getOccupancy() * 100.0f)) + "% after");
+  }
+}
+
+}
+
+void bench_octoon_image() {
+  bench_conversion();
+  bench_batch_loading();
+  bench_file_loading();
+  bench_jpeg();
+  bench_png_encode();
+  bench_block_compress();
+  bench_block_decompress();
+  bench_band_decode();
+  bench_mipmap();
+  bench_atlas();
+}
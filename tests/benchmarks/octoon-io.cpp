@@ -0,0 +1,432 @@
+// File: octoon-io.cpp
+#include <cstring>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "octoon/io/farchive.h"
+#include "octoon/io/file_buf.h"
+#include "octoon/io/istream.h"
+#include "octoon/io/json_reader.h"
+#include "octoon/io/mapbuf.h"
+#include "octoon/io/membuf.h"
+#include "octoon/io/serialization_buf.h"
+#include "octoon/io/mstream.h"
+
+#include "benchmark.h"
+
+#if defined(__linux__)
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+using namespace octoon::io;
+
+namespace {
+
+struct CountingHandler : public JsonHandler {
+  std::size_t values = 0;
+  std::size_t points = 0;
+  bool float3 = false;
+  bool pointsKey = false;
+  bool onNull() override { ++values; return true; }
+  bool onBoolean(bool) override { ++values; return true; }
+  bool onNumber(double) override { ++values; return true; }
+  bool onString(const char*, std::size_t) override { ++values; return true; }
+  bool onKey(const char* key, std::size_t length) override { pointsKey = length == 6 && std::memcmp(key, "points", 6) == 0; return true; }
+  bool wantFloat3Array() override { auto points = float3 && pointsKey; pointsKey = false; return points; }
+  bool onFloat3Array(const octoon::math::float3*, std::size_t count) override { points += count; return true; }
+};
+
+// A path file the way PathMeshingComponent reads it, mostly arrays of points with some
+// keyed metadata and strings around them.
+std::string make_document(std::size_t numPaths, std::size_t numPoints) {
+  std::string doc = "{\"name\":\"benchmark\",\"paths\":[";
+  for (std::size_t i = 0; i < numPaths; ++i) {
+    if (i) doc += ',';
+    doc += "{\"id\":" + std::to_string(i) + ",\"closed\":true,\"label\":\"path \\\"" + std::to_string(i) + "\\\"\",\"points\":[";
+    for (std::size_t j = 0; j < numPoints; ++j) {
+      if (j) doc += ',';
+      doc += '[' + std::to_string(i * 0.5 + j * 0.125) + ',' + std::to_string(-1.75 * j) + ",0]";
+    }
+    doc += "]}";
+  }
+  return doc + "]}";
+}
+
+void bench_json_sax() {
+  auto doc = make_document(256, 1024);
+  auto megabytes = doc.size() / (1024.0 * 1024.0);
+
+  CountingHandler handler;
+  auto ms = Benchmark::Measure([&] { JsonReader::parse(doc.data(), doc.size(), handler); });
+  Benchmark::Report("json_sax_memory", ms, Benchmark::Rate(megabytes, ms, "MB"));
+
+  imstream stream(std::vector<std::uint8_t>(doc.begin(), doc.end()));
+  JsonReader reader(stream);
+  ms = Benchmark::Measure([&] {
+    stream.seekg(0);
+    reader.parse(handler);
+  });
+  Benchmark::Report("json_sax_stream", ms, Benchmark::Rate(megabytes, ms, "MB"));
+
+  handler.float3 = true;
+  ms = Benchmark::Measure([&] { JsonReader::parse(doc.data(), doc.size(), handler); });
+  Benchmark::Report("json_sax_memory_float3", ms, Benchmark::Rate(megabytes, ms, "MB"));
+
+  // The DOM parser the SAX one replaces for large files.
+  ms = Benchmark::Measure([&] {
+    stream.seekg(0);
+    reader.readJson();
+  });
+  Benchmark::Report("json_dom_stream", ms, Benchmark::Rate(megabytes, ms, "MB"));
+}
+
+// Builds a serialization_buf from SAX events, values are created in place through push_back
+// and operator[] so that every object joins the document of the root.
+struct SerializationHandler : public JsonHandler {
+  serialization_buf root;
+  std::vector<serialization_buf*> stack;
+  std::string key;
+
+  serialization_buf& next() {
+    if (stack.empty())
+      return root;
+    auto& top = *stack.back();
+    if (top.is_array())
+      return top[top.size()];
+    top.push_back(key, serialization_buf());
+    return top.back();
+  }
+
+  bool onNull() override { next(); return true; }
+  bool onBoolean(bool value) override { next() = value; return true; }
+  bool onNumber(double value) override { next() = serialization_buf::number_float_t(value); return true; }
+  bool onString(const char* value, std::size_t length) override { next() = std::string(value, length); return true; }
+  bool onKey(const char* value, std::size_t length) override { key.assign(value, length); return true; }
+  bool onStartObject() override { auto& value = next(); value.emplace(serialization_buf::object); stack.push_back(&value); return true; }
+  bool onEndObject() override { stack.pop_back(); return true; }
+  bool onStartArray() override { auto& value = next(); value.emplace(serialization_buf::array); stack.push_back(&value); return true; }
+  bool onEndArray() override { stack.pop_back(); return true; }
+};
+
+// The layout serialization_buf had before, objects as a list of owned key and value pairs
+// searched front to back.
+struct ListValue {
+  enum { null, boolean, number, string, array, object } type = null;
+  double number_value = 0.0;
+  std::string string_value;
+  std::vector<ListValue> array_value;
+  std::list<std::pair<std::string, ListValue>> object_value;
+
+  const ListValue& operator[](const std::string& key) const {
+    static const ListValue nil;
+    auto it = std::find_if(object_value.begin(), object_value.end(), [&](const std::pair<std::string, ListValue>& member) { return member.first == key; });
+    return it != object_value.end() ? it->second : nil;
+  }
+};
+
+struct ListHandler : public JsonHandler {
+  ListValue root;
+  std::vector<ListValue*> stack;
+  std::string key;
+
+  ListValue& next() {
+    if (stack.empty())
+      return root;
+    auto& top = *stack.back();
+    if (top.type == ListValue::array) {
+      top.array_value.emplace_back();
+      return top.array_value.back();
+    }
+    top.object_value.emplace_back(key, ListValue());
+    return top.object_value.back().second;
+  }
+
+  bool onNull() override { next(); return true; }
+  bool onBoolean(bool value) override { auto& v = next(); v.type = ListValue::boolean; v.number_value = value; return true; }
+  bool onNumber(double value) override { auto& v = next(); v.type = ListValue::number; v.number_value = value; return true; }
+  bool onString(const char* value, std::size_t length) override { auto& v = next(); v.type = ListValue::string; v.string_value.assign(value, length); return true; }
+  bool onKey(const char* value, std::size_t length) override { key.assign(value, length); return true; }
+  bool onStartObject() override { auto& v = next(); v.type = ListValue::object; stack.push_back(&v); return true; }
+  bool onEndObject() override { stack.pop_back(); return true; }
+  bool onStartArray() override { auto& v = next(); v.type = ListValue::array; stack.push_back(&v); return true; }
+  bool onEndArray() override { stack.pop_back(); return true; }
+};
+
+// A scene sized document, 10k entities of 24 properties each with a small transform object.
+std::string make_scene(std::size_t numEntities, std::vector<std::string>& keys) {
+  for (int i = 0; i < 24; i++)
+    keys.push_back("property" + std::to_string(i));
+
+  std::string doc = "{\"entities\":[";
+  for (std::size_t i = 0; i < numEntities; ++i) {
+    if (i) doc += ',';
+    doc += "{\"name\":\"entity" + std::to_string(i) + "\",\"transform\":{\"x\":1,\"y\":2,\"z\":3}";
+    for (auto& key : keys)
+      doc += ",\"" + key + "\":" + std::to_string(i % 97);
+    doc += '}';
+  }
+  return doc + "]}";
+}
+
+void bench_serialization_buf() {
+  std::vector<std::string> keys;
+  auto doc = make_scene(10000, keys);
+  auto megabytes = doc.size() / (1024.0 * 1024.0);
+
+  auto ms = Benchmark::Measure([&] {
+    SerializationHandler handler;
+    JsonReader::parse(doc.data(), doc.size(), handler);
+  });
+  Benchmark::Report("serialization_buf_parse", ms, Benchmark::Rate(megabytes, ms, "MB"));
+
+  ms = Benchmark::Measure([&] {
+    ListHandler handler;
+    JsonReader::parse(doc.data(), doc.size(), handler);
+  });
+  Benchmark::Report("list_layout_parse", ms, Benchmark::Rate(megabytes, ms, "MB"));
+
+  SerializationHandler flat;
+  JsonReader::parse(doc.data(), doc.size(), flat);
+  ListHandler list;
+  JsonReader::parse(doc.data(), doc.size(), list);
+
+  const serialization_buf& root = flat.root;
+  auto& entities = root["entities"].get<serialization_buf::array_t>();
+  auto lookups = entities.size() * (keys.size() + 1) / 1000.0;
+  double sum = 0.0;
+
+  ms = Benchmark::Measure([&] {
+    for (const auto& entity : entities) {
+      sum += entity["transform"]["y"].get<serialization_buf::number_float_t>();
+      for (auto& key : keys)
+        sum += entity[key].get<serialization_buf::number_float_t>();
+    }
+  });
+  Benchmark::Report("serialization_buf_lookup", ms, Benchmark::Rate(lookups, ms, "k lookups"));
+
+  ms = Benchmark::Measure([&] {
+    for (auto& entity : list.root["entities"].array_value) {
+      sum += entity["transform"]["y"].number_value;
+      for (auto& key : keys)
+        sum += entity[key].number_value;
+    }
+  });
+  Benchmark::Report("list_layout_lookup", ms, Benchmark::Rate(lookups, ms, "k lookups"));
+
+  // A material library keyed by name, where the list layout walks half the object per lookup.
+  std::string library = "{";
+  std::vector<std::string> names;
+  for (int i = 0; i < 2000; i++) {
+    names.push_back("material" + std::to_string(i));
+    library += (i ? ",\"" : "\"") + names.back() + "\":{\"roughness\":0.5,\"metalness\":0}";
+  }
+  library += '}';
+
+  SerializationHandler flatLibrary;
+  JsonReader::parse(library.data(), library.size(), flatLibrary);
+  ListHandler listLibrary;
+  JsonReader::parse(library.data(), library.size(), listLibrary);
+
+  const serialization_buf& materials = flatLibrary.root;
+  lookups = names.size() / 1000.0;
+
+  ms = Benchmark::Measure([&] {
+    for (auto& name : names)
+      sum += materials[name]["roughness"].get<serialization_buf::number_float_t>();
+  });
+  Benchmark::Report("serialization_buf_lookup_wide", ms, Benchmark::Rate(lookups, ms, "k lookups"));
+
+  ms = Benchmark::Measure([&] {
+    for (auto& name : names)
+      sum += listLibrary.root[name]["roughness"].number_value;
+  });
+  Benchmark::Report("list_layout_lookup_wide", ms, Benchmark::Rate(lookups, ms, "k lookups") + (sum < 0 ? " " : ""));
+}
+
+// Runs the body once more and returns the system calls it made.
+template<typename Body>
+std::size_t count_syscalls(Body&& body) {
+  auto before = Benchmark::Syscalls();
+  body();
+  return Benchmark::Syscalls() - before;
+}
+
+// 256k records of an int and a float written and read one field at a time, the way the model
+// loaders read, without a block and with the default one.
+void bench_filebuf() {
+  const std::uint32_t numRecords = 256 * 1024;
+  const char* path = "octoon-bench-filebuf.bin";
+  auto megabytes = numRecords * 8 / (1024.0 * 1024.0);
+
+  for (auto blockSize : { std::size_t(0), filebuf::default_block_size }) {
+    std::string name = blockSize ? "filebuf_64k_" : "filebuf_unbuffered_";
+
+    auto write = [&] {
+      filebuf buf;
+      buf.set_block_size(blockSize);
+      buf.open(path, ios_base::in | ios_base::out | ios_base::trunc);
+      for (std::uint32_t i = 0; i < numRecords; i++) {
+        float value = i * 0.5f;
+        buf.write((const char*)&i, sizeof(i));
+        buf.write((const char*)&value, sizeof(value));
+      }
+    };
+    auto ms = Benchmark::Measure(write);
+    Benchmark::Report(name + "write_fields", ms, Benchmark::Rate(megabytes, ms, "MB") + ", " + std::to_string(count_syscalls(write)) + " syscalls");
+
+    auto read = [&] {
+      filebuf buf;
+      buf.set_block_size(blockSize);
+      buf.open(path, ios_base::in);
+      istream stream(&buf);
+      std::uint32_t index = 0;
+      float value = 0.0f;
+      for (std::uint32_t i = 0; i < numRecords; i++) {
+        stream.read((char*)&index, sizeof(index));
+        stream.read((char*)&value, sizeof(value));
+      }
+    };
+    ms = Benchmark::Measure(read);
+    Benchmark::Report(name + "read_fields", ms, Benchmark::Rate(megabytes, ms, "MB") + ", " + std::to_string(count_syscalls(read)) + " syscalls");
+  }
+
+  std::remove(path);
+}
+
+// Every thread reads 64k records of 256 bytes at scattered offsets, through read_at() or through
+// seekg() and read() on the shared cursor under a mutex, the way callers had to before read_at().
+template<typename Buf>
+void bench_concurrent_reads(const std::string& name, Buf& buf) {
+  const std::size_t numReads = 64 * 1024;
+  const std::size_t recordSize = 256;
+  auto numRecords = static_cast<std::size_t>(buf.size()) / recordSize;
+
+  for (unsigned numThreads : { 1u, 2u, 4u, 8u, 16u }) {
+    auto megabytes = numThreads * numReads * recordSize / (1024.0 * 1024.0);
+
+    auto run = [&](bool locked) {
+      std::mutex mutex;
+      std::vector<std::thread> threads;
+      for (unsigned t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t] {
+          char record[recordSize];
+          std::size_t index = t * 7919;
+          for (std::size_t i = 0; i < numReads; i++) {
+            index = (index * 2654435761u + 1) % numRecords;
+            if (locked) {
+              std::lock_guard<std::mutex> guard(mutex);
+              buf.seekg(index * recordSize, ios_base::beg);
+              buf.read(record, recordSize);
+            } else {
+              buf.read_at(index * recordSize, record, recordSize);
+            }
+          }
+        });
+      }
+      for (auto& thread : threads)
+        thread.join();
+    };
+
+    auto threads = std::to_string(numThreads) + "t";
+    auto ms = Benchmark::Measure([&] { run(false); });
+    Benchmark::Report(name + "_read_at_" + threads, ms, Benchmark::Rate(megabytes, ms, "MB"));
+    ms = Benchmark::Measure([&] { run(true); });
+    Benchmark::Report(name + "_locked_read_" + threads, ms, Benchmark::Rate(megabytes, ms, "MB"));
+  }
+}
+
+void bench_read_contention() {
+  std::vector<std::uint8_t> data(16 * 1024 * 1024);
+  for (std::size_t i = 0; i < data.size(); i++)
+    data[i] = std::uint8_t(i * 31);
+
+  membuf memory(data);
+  bench_concurrent_reads("membuf", memory);
+
+  const char* path = "octoon-bench-mapbuf.bin";
+  auto file = std::fopen(path, "wb");
+  std::fwrite(data.data(), 1, data.size(), file);
+  std::fclose(file);
+  mapbuf mapped;
+  if (mapped.open(path))
+    bench_concurrent_reads("mapbuf", mapped);
+  mapped.close();
+  std::remove(path);
+}
+
+#if defined(__linux__)
+// 100k assets in 100 directories looked up through farchive, on a fresh archive that has to
+// stat and watch everything and again once the cache is filled, against a plain stat() per path.
+void bench_farchive_lookup() {
+  const int numDirs = 100;
+  const int numFiles = 1000;
+  const std::string base = "octoon-bench-assets";
+
+  std::vector<Orl> orls;
+  std::vector<std::string> paths;
+  ::mkdir(base.c_str(), 0755);
+  for (int i = 0; i < numDirs; i++) {
+    auto dir = "dir" + std::to_string(i);
+    ::mkdir((base + "/" + dir).c_str(), 0755);
+    for (int j = 0; j < numFiles; j++) {
+      auto path = dir + "/asset" + std::to_string(j) + ".bin";
+      std::fclose(std::fopen((base + "/" + path).c_str(), "wb"));
+      orls.emplace_back("assets", path);
+      paths.push_back(base + "/" + path);
+    }
+  }
+
+  auto lookups = double(orls.size()) / 1000.0;
+
+  auto ms = Benchmark::Measure([&] {
+    struct stat st;
+    for (auto& path : paths)
+      ::stat(path.c_str(), &st);
+  });
+  Benchmark::Report("lookup_100k_stat", ms, Benchmark::Rate(lookups, ms, "k lookups"));
+
+  ms = Benchmark::Measure([&] {
+    farchive archive(base);
+    for (auto& orl : orls)
+      archive.exists(orl);
+  });
+  Benchmark::Report("lookup_100k_farchive_cold", ms, Benchmark::Rate(lookups, ms, "k lookups"));
+
+  farchive archive(base);
+  for (auto& orl : orls)
+    archive.exists(orl);
+  ms = Benchmark::Measure([&] {
+    for (auto& orl : orls)
+      archive.exists(orl);
+  });
+  Benchmark::Report("lookup_100k_farchive_cached", ms, Benchmark::Rate(lookups, ms, "k lookups"));
+
+  std::vector<ItemType> types;
+  ms = Benchmark::Measure([&] { archive.exists(orls, types); });
+  Benchmark::Report("lookup_100k_farchive_batch", ms, Benchmark::Rate(lookups, ms, "k lookups"));
+
+  for (auto& path : paths)
+    std::remove(path.c_str());
+  for (int i = 0; i < numDirs; i++)
+    ::rmdir((base + "/dir" + std::to_string(i)).c_str());
+  ::rmdir(base.c_str());
+}
+#endif
+
+}
+
+void bench_octoon_io() {
+  bench_json_sax();
+  bench_serialization_buf();
+  bench_filebuf();
+  bench_read_contention();
+#if defined(__linux__)
+  bench_farchive_lookup();
+#endif
+}
@@ -0,0 +1,411 @@
+// File: octoon-model.cpp
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "octoon/model/animation_blender.h"
+#include "octoon/model/ik_solver.h"
+#include "octoon/model/mesh.h"
+#include "octoon/model/model.h"
+#include "octoon/model/pmx_loader.h"
+#include "octoon/model/vmd_loader.h"
+#include "octoon/io/file_buf.h"
+#include "octoon/io/fstream.h"
+#include "octoon/io/mstream.h"
+#include "octoon/model/morph_engine.h"
+
+#include "benchmark.h"
+
+using namespace octoon::model;
+using namespace octoon::math;
+
+namespace {
+
+AnimationPropertyPtr make_clip(std::size_t count, float angle) {
+  Interpolation linear;
+  for (int i = 0; i < 4; ++i)
+    linear.interpX[i] = linear.interpY[i] = linear.interpZ[i] = linear.interpW[i] = i < 2 ? 20 : 107;
+
+  auto clip = std::make_shared<AnimationProperty>();
+  for (std::size_t i = 0; i < count; ++i) {
+    for (std::int32_t frame = 0; frame <= 30; frame += 10) {
+      BoneAnimation key;
+      key.setName("bone" + std::to_string(i));
+      key.setFrameNo(frame);
+      key.setRotation(Quaternion(float3::UnitZ, angle * frame / 30.0f));
+      key.setPosition(float3(0.0f, 0.01f * frame, 0.0f));
+      key.setInterpolation(linear);
+      clip->addBoneAnimation(key);
+    }
+  }
+  return clip;
+}
+
+// Four layers over a humanoid sized skeleton: two overrides, one of them masked to half the
+// bones, and one additive layer.
+void bench_pose_blending() {
+  const std::size_t count = 256;
+
+  Bones bones(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    bones[i].setName("bone" + std::to_string(i));
+    bones[i].setParent((std::int16_t)i - 1);
+    bones[i].setPosition(float3(0.0f, (float)i, 0.0f));
+  }
+
+  AnimationBlender blender;
+  blender.setBoneArray(bones);
+  blender.addLayer(make_clip(count, 1.0f));
+  blender.addLayer(make_clip(count, -0.5f), AnimationBlendMode::Override, 0.7f);
+  blender.addLayer(make_clip(count, 0.25f), AnimationBlendMode::Additive, 0.5f);
+
+  std::vector<std::size_t> upper;
+  for (std::size_t i = count / 2; i < count; ++i)
+    upper.push_back(i);
+  blender.setLayerMask(1, upper, 1.0f);
+
+  for (std::size_t i = 0; i < blender.getNumLayers(); ++i)
+    blender.getLayer(i).clip->setCurrentFrame(15);
+
+  // Sampling goes through the keyframe search of every layer, blending is what is left.
+  auto ms = Benchmark::Measure([&] { blender.evaluate(); });
+  Benchmark::Report("pose_blend_evaluate_256x3", ms, Benchmark::Rate((double)count * blender.getNumLayers(), ms, "bone samples"));
+
+  AnimationProperty target;
+  target.setBoneArray(bones);
+  ms = Benchmark::Measure([&] { blender.apply(target); });
+  Benchmark::Report("pose_blend_apply_256x3", ms);
+}
+
+// 300 active morphs over a 20k vertex mesh, each touching about 1/16 of the vertices the way
+// facial morphs do, evaluated on the pool and on the calling thread.
+void bench_morph_evaluate() {
+  const std::size_t numVertices = 20000;
+  const std::size_t count = 300;
+
+  std::uint32_t state = 12345;
+  auto next = [&] { state = state * 1664525u + 1013904223u; return state >> 8; };
+
+  Morphs morphs;
+  std::size_t deltas = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    MorphTarget target;
+    target.mesh = 0;
+    for (std::uint32_t v = next() % 16; v < numVertices; v += 1 + next() % 32) {
+      target.indices.push_back(v);
+      target.offsets.push_back(float3(0.01f, 0.02f, 0.03f));
+      target.normals.push_back(float3(0.0f, 0.01f, 0.0f));
+    }
+    deltas += target.indices.size();
+
+    auto morph = std::make_shared<Morph>("morph" + std::to_string(i), MorphType::Vertex);
+    morph->setTargetArray(std::vector<MorphTarget>{ std::move(target) });
+    morphs.push_back(morph);
+  }
+
+  MorphEngine engine;
+  engine.setMorphArray(morphs);
+  for (std::size_t i = 0; i < count; ++i)
+    engine.setWeight(i, 0.5f);
+
+  auto ms = Benchmark::Measure([&] { engine.update(); });
+  Benchmark::Report("morph_update_300", ms);
+
+  float3s vertices(numVertices, float3::Zero), normals(numVertices, float3::UnitY);
+  float3s outVertices, outNormals;
+
+  engine.setParallelEnable(true);
+  ms = Benchmark::Measure([&] { engine.evaluate(0, vertices, normals, outVertices, outNormals); });
+  Benchmark::Report("morph_evaluate_300x20k_parallel", ms, Benchmark::Rate((double)deltas, ms, "deltas"));
+
+  engine.setParallelEnable(false);
+  ms = Benchmark::Measure([&] { engine.evaluate(0, vertices, normals, outVertices, outNormals); });
+  Benchmark::Report("morph_evaluate_300x20k_serial", ms, Benchmark::Rate((double)deltas, ms, "deltas"));
+}
+
+// Appends little endian PMX fields to a byte buffer, as the model tests do.
+struct PmxBuilder {
+  std::vector<std::uint8_t> data;
+
+  template<typename T>
+  void put(const T& value) {
+    auto bytes = (const std::uint8_t*)&value;
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+  }
+  void text(const std::string& str) {
+    put((std::uint32_t)str.size());
+    data.insert(data.end(), str.begin(), str.end());
+  }
+};
+
+// A vertex grid skinned to 300 bones with BDEF1, BDEF2 and BDEF4 weights, split over eight
+// materials, with 32-bit vertex indices.
+std::vector<std::uint8_t> make_pmx(std::uint32_t columns, std::uint32_t rows) {
+  PmxBuilder pmx;
+  pmx.data.assign({ 'P', 'M', 'X', ' ' });
+  pmx.put(2.0f);
+  pmx.put((std::uint8_t)8);
+  std::uint8_t globals[8] = { 1, 0, 4, 1, 1, 2, 1, 1 };
+  pmx.put(globals);
+  pmx.text("benchmark");
+  pmx.text("");
+  pmx.text("");
+  pmx.text("");
+
+  pmx.put(columns * rows);
+  for (std::uint32_t y = 0; y < rows; ++y) {
+    for (std::uint32_t x = 0; x < columns; ++x) {
+      auto type = (std::uint8_t)((x + y) % 3);
+      pmx.put(float3((float)x, (float)y, 0.0f));
+      pmx.put(float3::UnitZ);
+      pmx.put(float2(x / (float)columns, y / (float)rows));
+      pmx.put(type);
+
+      auto bone = (std::int16_t)((x / 8 + y / 8 * 7) % 300);
+      if (type == 0) {
+        pmx.put(bone);
+      } else if (type == 1) {
+        pmx.put(bone);
+        pmx.put((std::int16_t)((bone + 1) % 300));
+        pmx.put(0.5f);
+      } else {
+        for (int i = 0; i < 4; ++i)
+          pmx.put((std::int16_t)((bone + i) % 300));
+        pmx.put(float4(0.4f, 0.3f, 0.2f, 0.1f));
+      }
+      pmx.put(0.0f);
+    }
+  }
+
+  std::vector<std::uint32_t> indices;
+  for (std::uint32_t y = 0; y + 1 < rows; ++y) {
+    for (std::uint32_t x = 0; x + 1 < columns; ++x) {
+      std::uint32_t i = y * columns + x;
+      indices.insert(indices.end(), { i, i + 1, i + columns, i + 1, i + columns + 1, i + columns });
+    }
+  }
+  pmx.put((std::uint32_t)indices.size());
+  for (auto index : indices)
+    pmx.put(index);
+
+  pmx.put((std::uint32_t)0);
+
+  const std::uint32_t numMaterials = 8;
+  std::uint32_t triangles = (std::uint32_t)indices.size() / 3;
+  pmx.put(numMaterials);
+  for (std::uint32_t i = 0; i < numMaterials; ++i) {
+    pmx.text("material" + std::to_string(i));
+    pmx.text("");
+    pmx.put(float3::One);
+    pmx.put(1.0f);
+    pmx.put(float3::Zero);
+    pmx.put(5.0f);
+    pmx.put(float3::Zero);
+    pmx.put((std::uint8_t)0);
+    pmx.put(float4::Zero);
+    pmx.put(1.0f);
+    pmx.put((std::int8_t)-1);
+    pmx.put((std::int8_t)-1);
+    pmx.put((std::uint8_t)0);
+    pmx.put((std::uint8_t)1);
+    pmx.put((std::uint8_t)0);
+    pmx.text("");
+    std::uint32_t first = triangles * i / numMaterials;
+    std::uint32_t last = triangles * (i + 1) / numMaterials;
+    pmx.put((last - first) * 3);
+  }
+
+  pmx.put((std::uint32_t)300);
+  for (int i = 0; i < 300; ++i) {
+    pmx.text("bone" + std::to_string(i));
+    pmx.text("");
+    pmx.put(float3(0.0f, (float)i, 0.0f));
+    pmx.put((std::int16_t)(i - 1));
+    pmx.put((std::uint32_t)0);
+    pmx.put((std::uint16_t)0);
+    pmx.put(float3::UnitY);
+  }
+
+  for (int i = 0; i < 4; ++i)
+    pmx.put((std::uint32_t)0);
+  return pmx.data;
+}
+
+// The whole load of a 200k vertex model into per-material meshes.
+void bench_pmx_load() {
+  auto data = make_pmx(500, 400);
+  auto megabytes = data.size() / (1024.0 * 1024.0);
+
+  octoon::io::imstream stream(data);
+  PmxLoader loader;
+
+  auto ms = Benchmark::Measure([&] {
+    Model model;
+    stream.seekg(0);
+    loader.doLoad(stream, model);
+  });
+  Benchmark::Report("pmx_load_200k", ms, Benchmark::Rate(megabytes, ms, "MB") + ", " + Benchmark::Rate(200.0, ms, "k vertices"));
+}
+
+// The same model read from a file, field by field without a block and with the default one.
+void bench_pmx_file() {
+  auto data = make_pmx(500, 400);
+  const char* path = "octoon-bench.pmx";
+  std::ofstream(path, std::ios::binary).write((const char*)data.data(), data.size());
+
+  for (auto blockSize : { std::size_t(0), octoon::io::filebuf::default_block_size }) {
+    auto load = [&] {
+      octoon::io::filebuf buf;
+      buf.set_block_size(blockSize);
+      buf.open(path, octoon::io::ios_base::in);
+      octoon::io::istream stream(&buf);
+      Model model;
+      PmxLoader().doLoad(stream, model);
+    };
+
+    auto ms = Benchmark::Measure(load);
+    auto before = Benchmark::Syscalls();
+    load();
+    auto syscalls = Benchmark::Syscalls() - before;
+    Benchmark::Report(std::string("pmx_load_200k_file_") + (blockSize ? "64k" : "unbuffered"), ms, std::to_string(syscalls) + " syscalls");
+  }
+
+  std::remove(path);
+}
+
+// A dance sized motion on disk, 200 bone tracks of 2500 keys each and 60 morph tracks,
+// loaded from a file stream. The peak counts everything resident during the load.
+void bench_vmd_load() {
+  const std::size_t numTracks = 200;
+  const std::size_t numKeys = 2500;
+  const std::size_t numMorphs = 60;
+  const char* path = "octoon-bench.vmd";
+
+  {
+    std::ofstream file(path, std::ios::binary);
+    char magic[30] = "Vocaloid Motion Data 0002";
+    char name[20] = "benchmark";
+    file.write(magic, sizeof(magic));
+    file.write(name, sizeof(name));
+
+    auto count = (std::uint32_t)(numTracks * numKeys);
+    file.write((const char*)&count, sizeof(count));
+
+    char key[111] = {};
+    for (std::size_t i = 0; i < count; ++i) {
+      auto track = "bone" + std::to_string(i % numTracks);
+      auto frame = (std::uint32_t)(i / numTracks * 2);
+      float values[7] = { 0.0f, 0.01f * i, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+      std::memset(key, 0, 15);
+      std::memcpy(key, track.data(), track.size());
+      std::memcpy(key + 15, &frame, sizeof(frame));
+      std::memcpy(key + 19, values, sizeof(values));
+      for (int k = 0; k < 64; ++k)
+        key[47 + k] = (char)(k % 4 < 2 ? 20 : 107);
+      file.write(key, sizeof(key));
+    }
+
+    count = (std::uint32_t)(numMorphs * numKeys);
+    file.write((const char*)&count, sizeof(count));
+
+    char morph[23] = {};
+    for (std::size_t i = 0; i < count; ++i) {
+      auto track = "morph" + std::to_string(i % numMorphs);
+      auto frame = (std::uint32_t)(i / numMorphs * 2);
+      float weight = (i % 7) / 7.0f;
+      std::memset(morph, 0, 15);
+      std::memcpy(morph, track.data(), track.size());
+      std::memcpy(morph + 15, &frame, sizeof(frame));
+      std::memcpy(morph + 19, &weight, sizeof(weight));
+      file.write(morph, sizeof(morph));
+    }
+  }
+
+  auto megabytes = (numTracks * 111 + numMorphs * 23) * numKeys / (1024.0 * 1024.0);
+
+  std::size_t base = Benchmark::PeakRss(true);
+  std::size_t peak = 0;
+  auto ms = Benchmark::Measure([&] {
+    Model model;
+    octoon::io::ifstream stream(path);
+    VmdLoader().doLoad(stream, model);
+    peak = std::max(peak, Benchmark::PeakRss(false));
+  });
+  Benchmark::Report("vmd_load_500k_keys", ms, Benchmark::Rate(megabytes, ms, "MB") + ", peak +" + std::to_string((peak - base) / 1024) + " MB for " + std::to_string((int)megabytes) + " MB of keys");
+
+  std::remove(path);
+}
+
+// 32 independent chains of four links, legs, arms, hair and skirt strands of a character,
+// solved from the rest pose towards goals at different reaches.
+void bench_ik_solve() {
+  const std::size_t numChains = 32;
+  const std::size_t links = 4;
+
+  Bones bones;
+  InverseKinematics iks;
+  std::vector<float3> offsets;
+  for (std::size_t chain = 0; chain < numChains; ++chain) {
+    std::size_t base = bones.size();
+    for (std::size_t i = 0; i <= links; ++i) {
+      bones.emplace_back("bone" + std::to_string(base + i));
+      bones.back().setParent(i ? (std::int16_t)(base + i - 1) : (std::int16_t)-1);
+      offsets.push_back(i ? float3::UnitY : float3(chain * 10.0f, 0.0f, 0.0f));
+    }
+    bones.emplace_back("goal" + std::to_string(chain));
+    bones.back().setParent(-1);
+    offsets.push_back(float3(chain * 10.0f + std::sin(chain * 0.7f) * 2.0f, 1.0f + chain % 3, std::cos(chain * 0.4f)));
+
+    IKAttr ik;
+    ik.boneIndex = (std::uint16_t)(base + links + 1);
+    ik.targetBoneIndex = (std::uint16_t)(base + links);
+    ik.iterations = 40;
+    ik.chainLength = (std::uint32_t)links;
+    for (std::size_t i = links; i-- > 0;)
+      ik.child.push_back(IKChild{ (std::uint16_t)(base + i), 0, 1.0f, float3::Zero, float3::Zero });
+    iks.push_back(ik);
+  }
+
+  IKSolver solver;
+  solver.setBoneArray(bones);
+  solver.setIKArray(iks);
+  solver.setTolerance(1e-4f);
+
+  Pose pose(bones.size());
+  auto solve = [&] {
+    pose.setIdentity();
+    for (std::size_t i = 0; i < bones.size(); ++i)
+      pose.setTranslate(i, offsets[i]);
+    solver.solve(pose);
+  };
+
+  for (auto parallel : { false, true }) {
+    solver.setParallelEnable(parallel);
+    auto ms = Benchmark::Measure(solve);
+
+    std::uint32_t iterations = 0;
+    float chainTime = 0.0f;
+    for (auto& stats : solver.getChainStats()) {
+      iterations += stats.iterations;
+      chainTime += stats.time;
+    }
+
+    std::ostringstream detail;
+    detail << Benchmark::Rate((double)numChains, ms, "chains") << ", " << std::fixed << std::setprecision(1) << chainTime * 1000.0f / numChains << " us and " << iterations / numChains << " iterations per chain";
+    Benchmark::Report(std::string("ik_solve_32x4_") + (parallel ? "parallel" : "serial"), ms, detail.str());
+  }
+}
+
+}
+
+void bench_octoon_model() {
+  bench_pmx_load();
+  bench_pmx_file();
+  bench_vmd_load();
+  bench_pose_blending();
+  bench_morph_evaluate();
+  bench_ik_solve();
+}
@@ -0,0 +1,69 @@
+// File: octoon.cpp
+#include <vector>
+#include <string>
+
+#include "octoon/game_scene.h"
+#include "octoon/game_scene_file.h"
+#include "octoon/transform_component.h"
+#include "octoon/io/mstream.h"
+
+#include "benchmark.h"
+
+using namespace octoon;
+using namespace octoon::math;
+
+namespace {
+
+// Ten thousand objects in shallow trees, a fifth of them inactive.
+GameScenePtr make_scene(std::size_t count) {
+  auto scene = std::make_shared<GameScene>();
+  scene->setName("benchmark");
+
+  std::vector<GameObjectPtr> objects;
+  for (std::size_t i = 0; i < count; ++i) {
+    auto object = std::make_shared<GameObject>();
+    object->setName("object" + std::to_string(i));
+    object->setLayer((std::uint8_t)(i % 7));
+    object->getComponent<TransformComponent>()->setLocalTranslate(float3((float)i, i * 2.0f, i * 3.0f));
+
+    if (i % 10 == 0)
+      scene->root()->addChild(object);
+    else
+      objects[i - 1 - (i % 3 == 0)]->addChild(object);
+
+    if (i % 5 == 0)
+      object->setActive(false);
+
+    objects.push_back(object);
+  }
+
+  return scene;
+}
+
+void bench_scene_file() {
+  const std::size_t count = 10000;
+
+  GameScenePtr scene;
+  auto ms = Benchmark::Measure([&] { scene = make_scene(count); });
+  Benchmark::Report("scene_build_10k", ms, Benchmark::Rate((double)count, ms, "objects"));
+
+  std::vector<char> bytes;
+  ms = Benchmark::Measure([&] {
+    io::mstream stream(std::size_t(0));
+    GameSceneFile::save(*scene, stream);
+
+    bytes.resize((std::size_t)stream.size());
+    stream.seekg(0);
+    stream.read(bytes.data(), bytes.size());
+  });
+  Benchmark::Report("scene_save_10k", ms, Benchmark::Rate(bytes.size() / (1024.0 * 1024.0), ms, "MB"));
+
+  ms = Benchmark::Measure([&] { GameSceneFile::load(bytes.data(), bytes.size()); });
+  Benchmark::Report("scene_load_10k", ms, Benchmark::Rate((double)count, ms, "objects"));
+}
+
+}
+
+void bench_octoon() {
+  bench_scene_file();
+}
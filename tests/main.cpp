@@ -3,12 +3,22 @@
 
 using namespace LiongPlus::Testing;
 
+void test_octoon();
 void test_octoon_io();
+void test_octoon_video();
+void test_octoon_image();
+void test_octoon_model();
+void test_octoon_runtime();
 
 int main() {
   std::cout << "Testing Octoon components..." << std::endl;
 
+  test_octoon();
   test_octoon_io();
+  test_octoon_video();
+  test_octoon_image();
+  test_octoon_model();
+  test_octoon_runtime();
 
   std::cout << UnitTest::Summary() << std::endl;
 
@@ -0,0 +1,1010 @@
+// File: octoon-image.cpp
+#include <vector>
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <cstdio>
+#include <algorithm>
+
+#include "octoon/image/image.h"
+#include "octoon/image/image_converter.h"
+#include "octoon/image/image_compressor.h"
+#include "octoon/image/image_reader.h"
+#include "octoon/image/image_batch.h"
+#include "octoon/image/image_png_encoder.h"
+#include "octoon/image/image_jpeg_codec.h"
+#include "octoon/image/image_atlas.h"
+#include "octoon/image/image_mipmap.h"
+#include "octoon/io/mstream.h"
+#include "octoon/runtime/except.h"
+
+#include <png.h>
+
+#include "LiongPlus/Testing/UnitTest.hpp"
+
+using namespace LiongPlus::Testing;
+using namespace octoon::image;
+using octoon::io::mstream;
+using octoon::io::ios_base;
+
+class OctoonImageTestObject : public TestObject
+{
+  static std::vector<Format> supported_formats() {
+    std::vector<Format> formats;
+    for (int i = Format::BeginRange + 1; i <= Format::EndRange; ++i) {
+      if (FormatConverter::isSupported((Format::Type)i))
+        formats.push_back((Format::Type)i);
+    }
+    return formats;
+  }
+
+  static bool is_integer(const Format& format) {
+    auto type = format.value_type();
+    return type == octoon::image::value_t::UInt || type == octoon::image::value_t::SInt || type == octoon::image::value_t::UScaled || type == octoon::image::value_t::SScaled;
+  }
+
+  static std::vector<std::uint8_t> convert(const Format& src, const Format& dst, const void* pixels, std::size_t count, bool accelerated, AlphaMode alpha = AlphaMode::Straight) {
+    FormatConverter converter(src, dst, alpha);
+    converter.setAccelerated(accelerated);
+    std::vector<std::uint8_t> out(count * dst.pixel_size());
+    converter.convert(pixels, out.data(), count);
+    return out;
+  }
+
+  static void test_every_pair() {
+    auto formats = supported_formats();
+    Logger::Info("Converting between " + std::to_string(formats.size()) + " formats...");
+    ASSERT(formats.size() > 100);
+
+    // An odd count leaves a tail behind every vector loop.
+    const std::size_t count = 67;
+    std::vector<float> rgba(count * 4);
+    std::uint32_t seed = 12345;
+    for (auto& v : rgba) {
+      seed = seed * 1664525 + 1013904223;
+      v = (seed >> 8) / float(1 << 24) * 1.4f - 0.2f;
+    }
+
+    int mismatches = 0;
+    for (auto& src : formats) {
+      std::vector<float> values = rgba;
+      if (is_integer(src)) {
+        for (auto& v : values)
+          v = std::floor(v * 200.0f);
+      }
+
+      auto pixels = convert(Format::R32G32B32A32SFloat, src, values.data(), count, false);
+      for (auto& dst : formats) {
+        for (auto alpha : { AlphaMode::Straight, AlphaMode::Premultiply, AlphaMode::Unpremultiply }) {
+          auto fast = convert(src, dst, pixels.data(), count, true, alpha);
+          auto scalar = convert(src, dst, pixels.data(), count, false, alpha);
+          if (fast != scalar)
+            ++mismatches;
+        }
+      }
+    }
+    ASSERT(mismatches == 0);
+  }
+
+  static void test_round_trips() {
+    Logger::Info("8 bit normalized and sRGB codes survive floats...");
+    std::vector<std::uint8_t> bytes(256 * 4);
+    for (std::size_t i = 0; i < bytes.size(); ++i)
+      bytes[i] = (std::uint8_t)(i / 4);
+    for (auto format : { Format::R8G8B8A8UNorm, Format::R8G8B8A8SRGB, Format::B8G8R8A8SRGB }) {
+      auto floats = convert(format, Format::R32G32B32A32SFloat, bytes.data(), 256, true);
+      ASSERT(convert(Format::R32G32B32A32SFloat, format, floats.data(), 256, true) == bytes);
+    }
+
+    auto linear = convert(Format::R8G8B8A8SRGB, Format::R32G32B32A32SFloat, bytes.data(), 256, true);
+    const float* f = (const float*)linear.data();
+    ASSERT(std::abs(f[128 * 4] - 0.2158605f) < 1e-5f);
+    ASSERT(f[128 * 4 + 3] == 128 / 255.0f);
+
+    Logger::Info("Every half survives floats...");
+    std::vector<std::uint16_t> halves;
+    for (std::uint32_t i = 0; i < 65536; ++i) {
+      if ((i & 0x7c00) != 0x7c00 || (i & 0x3ff) == 0)
+        halves.push_back((std::uint16_t)i);
+    }
+    auto floats = convert(Format::R16SFloat, Format::R32SFloat, halves.data(), halves.size(), true);
+    auto back = convert(Format::R32SFloat, Format::R16SFloat, floats.data(), halves.size(), true);
+    ASSERT(std::memcmp(back.data(), halves.data(), back.size()) == 0);
+
+    Logger::Info("Every 565 and 4444 pixel survives RGBA8...");
+    std::vector<std::uint16_t> packed(65536);
+    for (std::uint32_t i = 0; i < 65536; ++i)
+      packed[i] = (std::uint16_t)i;
+    for (auto format : { Format::R5G6B5UNormPack16, Format::B4G4R4A4UNormPack16, Format::A1R5G5B5UNormPack16 }) {
+      auto rgba8 = convert(format, Format::R8G8B8A8UNorm, packed.data(), packed.size(), true);
+      auto again = convert(Format::R8G8B8A8UNorm, format, rgba8.data(), packed.size(), true);
+      ASSERT(std::memcmp(again.data(), packed.data(), again.size()) == 0);
+    }
+
+    Logger::Info("Packed floats keep their values...");
+    std::vector<std::uint32_t> words;
+    std::uint32_t seed = 7;
+    for (int i = 0; i < 100000; ++i) {
+      seed = seed * 1664525 + 1013904223;
+      words.push_back(seed);
+    }
+    for (auto format : { Format::B10G11R11UFloatPack32, Format::E5B9G9R9UFloatPack32 }) {
+      auto decoded = convert(format, Format::R32G32B32SFloat, words.data(), words.size(), true);
+      auto encoded = convert(Format::R32G32B32SFloat, format, decoded.data(), words.size(), true);
+      auto again = convert(format, Format::R32G32B32SFloat, encoded.data(), words.size(), true);
+      std::size_t differ = 0;
+      const float* a = (const float*)decoded.data();
+      const float* b = (const float*)again.data();
+      for (std::size_t i = 0; i < words.size() * 3; ++i) {
+        if (a[i] != b[i] && !(a[i] != a[i] && b[i] != b[i]))
+          ++differ;
+      }
+      ASSERT(differ == 0);
+    }
+  }
+
+  static void test_channels() {
+    Logger::Info("Swizzles, missing channels and luminance...");
+    std::uint8_t rgba[8] = { 10, 20, 30, 40, 200, 100, 50, 128 };
+
+    auto bgra = convert(Format::R8G8B8A8UNorm, Format::B8G8R8A8UNorm, rgba, 2, true);
+    ASSERT(bgra == std::vector<std::uint8_t>({ 30, 20, 10, 40, 50, 100, 200, 128 }));
+
+    auto rgb = convert(Format::R8G8B8A8UNorm, Format::B8G8R8UNorm, rgba, 2, true);
+    ASSERT(rgb == std::vector<std::uint8_t>({ 30, 20, 10, 50, 100, 200 }));
+
+    auto expanded = convert(Format::B8G8R8UNorm, Format::R8G8B8A8UNorm, rgb.data(), 2, true);
+    ASSERT(expanded == std::vector<std::uint8_t>({ 10, 20, 30, 255, 200, 100, 50, 255 }));
+
+    std::uint8_t gray[2] = { 0, 77 };
+    auto rgbx = convert(Format::L8UNorm, Format::R8G8B8A8UNorm, gray, 2, true);
+    ASSERT(rgbx == std::vector<std::uint8_t>({ 0, 0, 0, 255, 77, 77, 77, 255 }));
+
+    std::uint8_t white[4] = { 255, 255, 255, 9 };
+    auto la = convert(Format::R8G8B8A8UNorm, Format::L8A8UNorm, white, 1, true);
+    ASSERT(la == std::vector<std::uint8_t>({ 255, 9 }));
+
+    Logger::Info("Premultiplied alpha...");
+    auto premultiplied = convert(Format::R8G8B8A8UNorm, Format::R8G8B8A8UNorm, rgba, 2, true, AlphaMode::Premultiply);
+    ASSERT(premultiplied[4] == 100 && premultiplied[5] == 50 && premultiplied[6] == 25 && premultiplied[7] == 128);
+    auto straight = convert(Format::R8G8B8A8UNorm, Format::R8G8B8A8UNorm, premultiplied.data(), 2, true, AlphaMode::Unpremultiply);
+    ASSERT(straight[4] == 199 && straight[5] == 100 && straight[6] == 50);
+
+    Logger::Info("Integer values are kept...");
+    float values[4] = { 3.0f, 300.0f, -5.0f, 1.0f };
+    auto ints = convert(Format::R32G32B32A32SFloat, Format::R16G16B16A16SInt, values, 1, true);
+    const std::int16_t* i16 = (const std::int16_t*)ints.data();
+    ASSERT(i16[0] == 3 && i16[1] == 300 && i16[2] == -5 && i16[3] == 1);
+  }
+
+  static void test_image_create() {
+    Logger::Info("Image::create converts every mip and layer...");
+    Image src(Format::R8G8B8A8UNorm, 33, 17, 1, 3, 2);
+    std::vector<std::uint8_t> pattern(src.size());
+    for (std::size_t i = 0; i < pattern.size(); ++i)
+      pattern[i] = (std::uint8_t)(i * 7);
+    std::memcpy((char*)src.data(), pattern.data(), pattern.size());
+
+    Image half(Format::R16G16B16A16SFloat, src);
+    ASSERT(half.width() == 33 && half.height() == 17 && half.mipLevel() == 3 && half.layerLevel() == 2);
+    ASSERT(half.size() == src.size() * 2);
+
+    Image back(Format::R8G8B8A8UNorm, half);
+    ASSERT(std::memcmp(back.data(), src.data(), src.size()) == 0);
+
+    Image packed(Format::R5G6B5UNormPack16, src);
+    ASSERT(packed.size() == src.size() / 2);
+
+    Image self(src);
+    self.create(Format::B8G8R8A8UNorm, self);
+    ASSERT(self.format() == Format::B8G8R8A8UNorm && (std::uint8_t)self.data()[0] == pattern[2]);
+  }
+
+  // Smooth ramps with a few hard edges and some noise, alpha fades out radially.
+  static Image make_test_image(std::uint32_t width, std::uint32_t height) {
+    Image image(Format::R8G8B8A8UNorm, width, height);
+    auto data = (std::uint8_t*)image.data();
+    std::uint32_t seed = 99;
+    for (std::uint32_t y = 0; y < height; ++y) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        seed = seed * 1664525 + 1013904223;
+        float u = x / float(width), v = y / float(height);
+        float noise = ((seed >> 24) / 255.0f - 0.5f) * 0.06f;
+        float stripe = ((x / 37 + y / 53) % 2) ? 0.2f : 0.0f;
+        float r = u * 0.8f + stripe + noise;
+        float g = v * 0.7f + 0.5f * std::sin(u * 9.0f) * 0.3f + noise;
+        float b = 0.5f + 0.4f * std::cos((u + v) * 6.0f) + noise;
+        float a = 1.0f - std::min(std::sqrt((u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f)) * 1.6f, 1.0f);
+        float rgba[4] = { r, g, b, a };
+        for (int c = 0; c < 4; ++c)
+          data[(y * width + x) * 4 + c] = (std::uint8_t)std::lround(std::min(std::max(rgba[c], 0.0f), 1.0f) * 255.0f);
+      }
+    }
+    return image;
+  }
+
+  // Over the top level of two images in the same uncompressed format, floats are taken as is.
+  static double psnr(const Image& a, const Image& b, int channels, double peak) {
+    std::size_t count = (std::size_t)a.width() * a.height();
+    double error = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+      for (int c = 0; c < channels; ++c) {
+        double x, y;
+        if (a.format().pixel_size() == 4) {
+          x = (std::uint8_t)a.data()[i * 4 + c];
+          y = (std::uint8_t)b.data()[i * 4 + c];
+        } else {
+          x = ((const float*)a.data())[i * 4 + c];
+          y = ((const float*)b.data())[i * 4 + c];
+        }
+        error += (x - y) * (x - y);
+      }
+    }
+    error /= count * channels;
+    return error > 0.0 ? 10.0 * std::log10(peak * peak / error) : 99.0;
+  }
+
+  // Levels follow each other, a level holds all of its layers.
+  static const float* mip_floats(const Image& image, std::uint32_t mip) {
+    std::size_t offset = 0;
+    std::uint32_t w = image.width(), h = image.height();
+    for (std::uint32_t i = 0; i < mip; i++) {
+      offset += (std::size_t)w * h * image.depth() * image.layerLevel() * image.format().pixel_size();
+      w = std::max(w >> 1, 1u);
+      h = std::max(h >> 1, 1u);
+    }
+    return (const float*)(image.data() + offset);
+  }
+
+  static const std::uint8_t* mip_bytes(const Image& image, std::uint32_t mip) {
+    return (const std::uint8_t*)mip_floats(image, mip);
+  }
+
+  // Share of the texels of a RGBA8 level with an alpha above the cutoff.
+  static float alpha_coverage(const Image& image, std::uint32_t mip, float cutoff) {
+    auto texels = mip_bytes(image, mip);
+    std::size_t count = (std::size_t)std::max(image.width() >> mip, 1u) * std::max(image.height() >> mip, 1u);
+    std::size_t above = 0;
+    for (std::size_t i = 0; i < count; i++)
+      above += texels[i * 4 + 3] / 255.0f > cutoff;
+    return (float)above / count;
+  }
+
+  static void test_mipmap() {
+    std::uint32_t seed = 5;
+    auto random = [&]() { seed = seed * 1664525 + 1013904223; return (seed >> 8) / 16777216.0f; };
+
+    const MipmapFilter filters[] = { MipmapFilter::Box, MipmapFilter::Kaiser, MipmapFilter::Lanczos };
+
+    Logger::Info("Chains keep the top level and halve down to one texel...");
+    Image noise(Format::R32G32B32A32SFloat, 32, 32);
+    for (std::size_t i = 0; i < 32 * 32 * 4; i++)
+      ((float*)noise.data())[i] = random();
+
+    for (auto filter : filters) {
+      Image chain;
+      MipmapGenerator(filter).generate(noise, chain);
+      ASSERT(chain.mipLevel() == 6 && chain.format() == noise.format());
+      ASSERT(std::memcmp(chain.data(), noise.data(), noise.size()) == 0);
+
+      Image partial;
+      MipmapGenerator(filter).generate(noise, partial, 3);
+      ASSERT(partial.mipLevel() == 3 && std::memcmp(partial.data(), chain.data(), partial.size()) == 0);
+    }
+
+    Logger::Info("A box halving is the mean of every 2x2 block...");
+    {
+      Image chain;
+      MipmapGenerator(MipmapFilter::Box).generate(noise, chain);
+      auto top = mip_floats(chain, 0);
+      auto next = mip_floats(chain, 1);
+      float error = 0.0f;
+      for (std::uint32_t y = 0; y < 16; y++) {
+        for (std::uint32_t x = 0; x < 16; x++) {
+          for (int c = 0; c < 4; c++) {
+            float mean = (top[((y * 2) * 32 + x * 2) * 4 + c] + top[((y * 2) * 32 + x * 2 + 1) * 4 + c] +
+              top[((y * 2 + 1) * 32 + x * 2) * 4 + c] + top[((y * 2 + 1) * 32 + x * 2 + 1) * 4 + c]) * 0.25f;
+            error = std::max(error, std::abs(next[(y * 16 + x) * 4 + c] - mean));
+          }
+        }
+      }
+      ASSERT(error < 1e-6f);
+    }
+
+    Logger::Info("Every kernel keeps flat areas and linear ramps...");
+    Image ramp(Format::R32G32B32A32SFloat, 64, 8);
+    for (std::uint32_t y = 0; y < 8; y++) {
+      for (std::uint32_t x = 0; x < 64; x++) {
+        float* texel = (float*)ramp.data() + (y * 64 + x) * 4;
+        texel[0] = x + 0.5f;
+        texel[1] = 0.25f;
+        texel[2] = y + 0.5f;
+        texel[3] = 1.0f;
+      }
+    }
+
+    for (auto filter : filters) {
+      Image chain;
+      MipmapGenerator(filter).generate(ramp, chain, 2);
+      auto next = mip_floats(chain, 1);
+
+      // Away from the clamped edges, where the wider kernels read six source texels either side.
+      float error = 0.0f;
+      for (std::uint32_t x = 4; x < 28; x++) {
+        auto texel = next + (2 * 32 + x) * 4;
+        error = std::max(error, std::abs(texel[0] - (x + 0.5f) * 2.0f));
+      }
+      for (std::uint32_t i = 0; i < 32 * 4; i++) {
+        error = std::max(error, std::abs(next[i * 4 + 1] - 0.25f));
+        error = std::max(error, std::abs(next[i * 4 + 3] - 1.0f));
+      }
+      ASSERT(error < 1e-3f);
+    }
+
+    Logger::Info("Kaiser and Lanczos ring around an impulse, the box doesn't...");
+    Image impulse(Format::R32G32B32A32SFloat, 32, 32);
+    ((float*)impulse.data())[(16 * 32 + 16) * 4] = 1.0f;
+
+    std::vector<std::vector<float>> responses;
+    for (auto filter : filters) {
+      Image chain;
+      MipmapGenerator(filter).generate(impulse, chain, 2);
+      auto next = mip_floats(chain, 1);
+
+      std::vector<float> response(16 * 16);
+      for (std::size_t i = 0; i < response.size(); i++)
+        response[i] = next[i * 4];
+      responses.push_back(response);
+    }
+
+    auto& box = responses[0];
+    ASSERT(box[8 * 16 + 8] == 0.25f && std::count(box.begin(), box.end(), 0.0f) == 255);
+    for (std::size_t i = 1; i < responses.size(); i++) {
+      ASSERT(*std::min_element(responses[i].begin(), responses[i].end()) < -1e-4f);
+      ASSERT(std::count_if(responses[i].begin(), responses[i].end(), [](float v) { return v > 1e-4f; }) > 4);
+    }
+    ASSERT(responses[1] != responses[2]);
+
+    Logger::Info("sRGB colors are averaged in linear space, alpha stays linear...");
+    for (auto format : { Format::R8G8B8A8SRGB, Format::R8G8B8A8UNorm }) {
+      Image checker(format, 2, 2);
+      auto texels = (std::uint8_t*)checker.data();
+      for (int i = 0; i < 4; i++)
+        std::memset(texels + i * 4, i == 0 || i == 3 ? 0xFF : 0x00, 4);
+
+      Image chain;
+      MipmapGenerator().generate(checker, chain);
+      auto mean = mip_bytes(chain, 1);
+
+      // Half of linear white is 188 once encoded back to sRGB.
+      auto color = format == Format::R8G8B8A8SRGB ? 188 : 128;
+      ASSERT(std::abs(mean[0] - color) <= 1 && mean[0] == mean[1] && mean[1] == mean[2]);
+      ASSERT(std::abs(mean[3] - 128) <= 1);
+    }
+
+    Logger::Info("Alpha coverage is kept with a cutoff...");
+    Image foliage(Format::R8G8B8A8UNorm, 64, 64);
+    for (std::size_t i = 0; i < 64 * 64; i++) {
+      auto texel = (std::uint8_t*)foliage.data() + i * 4;
+      float alpha = random();
+      texel[0] = texel[1] = texel[2] = 0x80;
+      texel[3] = (std::uint8_t)std::lround(alpha * alpha * 255.0f);
+    }
+
+    {
+      MipmapGenerator generator(MipmapFilter::Kaiser);
+      generator.setAlphaCutoff(0.5f);
+      ASSERT(generator.getAlphaCutoff() == 0.5f);
+
+      Image kept, thinned;
+      generator.generate(foliage, kept);
+      MipmapGenerator(MipmapFilter::Kaiser).generate(foliage, thinned);
+
+      float target = alpha_coverage(foliage, 0, 0.5f);
+      ASSERT(target > 0.2f && target < 0.4f);
+
+      // Down to 8x8, below that a single texel moves the share by more than the tolerance.
+      for (std::uint32_t mip = 1; mip <= 3; mip++)
+        ASSERT(std::abs(alpha_coverage(kept, mip, 0.5f) - target) < 0.02f);
+      ASSERT(alpha_coverage(thinned, 3, 0.5f) < target * 0.5f);
+    }
+
+    Logger::Info("Normal maps stay unit length...");
+    Image normals8(Format::R8G8B8A8UNorm, 32, 32);
+    Image normals32(Format::R32G32B32A32SFloat, 32, 32);
+    for (std::size_t i = 0; i < 32 * 32; i++) {
+      float n[3] = { random() * 2.0f - 1.0f, random() * 2.0f - 1.0f, random() + 0.2f };
+      float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      for (int c = 0; c < 3; c++) {
+        ((float*)normals32.data())[i * 4 + c] = n[c] / length;
+        ((std::uint8_t*)normals8.data())[i * 4 + c] = (std::uint8_t)std::lround((n[c] / length * 0.5f + 0.5f) * 255.0f);
+      }
+      ((float*)normals32.data())[i * 4 + 3] = 1.0f;
+      ((std::uint8_t*)normals8.data())[i * 4 + 3] = 0xFF;
+    }
+
+    for (auto filter : filters) {
+      MipmapGenerator generator(filter);
+      generator.setNormalMap(true);
+      ASSERT(generator.getNormalMap());
+
+      Image chain8, chain32, plain8;
+      generator.generate(normals8, chain8);
+      generator.generate(normals32, chain32);
+      MipmapGenerator(filter).generate(normals8, plain8);
+
+      float error8 = 0.0f, error32 = 0.0f, shortest = 1.0f;
+      for (std::uint32_t mip = 1; mip < chain8.mipLevel(); mip++) {
+        std::size_t count = (std::size_t)(32 >> mip) * (32 >> mip);
+        for (std::size_t i = 0; i < count; i++) {
+          float n8[3], n32[3], p8[3];
+          for (int c = 0; c < 3; c++) {
+            n8[c] = mip_bytes(chain8, mip)[i * 4 + c] / 255.0f * 2.0f - 1.0f;
+            p8[c] = mip_bytes(plain8, mip)[i * 4 + c] / 255.0f * 2.0f - 1.0f;
+            n32[c] = mip_floats(chain32, mip)[i * 4 + c];
+          }
+          error8 = std::max(error8, std::abs(std::sqrt(n8[0] * n8[0] + n8[1] * n8[1] + n8[2] * n8[2]) - 1.0f));
+          error32 = std::max(error32, std::abs(std::sqrt(n32[0] * n32[0] + n32[1] * n32[1] + n32[2] * n32[2]) - 1.0f));
+          shortest = std::min(shortest, std::sqrt(p8[0] * p8[0] + p8[1] * p8[1] + p8[2] * p8[2]));
+        }
+      }
+      ASSERT(error8 < 0.02f && error32 < 1e-5f && shortest < 0.9f);
+    }
+
+    {
+      // A box renormalizes the mean of every 2x2 block.
+      MipmapGenerator generator(MipmapFilter::Box);
+      generator.setNormalMap(true);
+      Image chain;
+      generator.generate(normals32, chain, 2);
+
+      auto top = mip_floats(chain, 0);
+      auto next = mip_floats(chain, 1);
+      float error = 0.0f;
+      for (std::uint32_t y = 0; y < 16; y++) {
+        for (std::uint32_t x = 0; x < 16; x++) {
+          float mean[3] = { 0.0f, 0.0f, 0.0f };
+          for (std::uint32_t k = 0; k < 4; k++)
+            for (int c = 0; c < 3; c++)
+              mean[c] += top[((y * 2 + k / 2) * 32 + x * 2 + k % 2) * 4 + c];
+          float length = std::sqrt(mean[0] * mean[0] + mean[1] * mean[1] + mean[2] * mean[2]);
+          for (int c = 0; c < 3; c++)
+            error = std::max(error, std::abs(next[(y * 16 + x) * 4 + c] - mean[c] / length));
+        }
+      }
+      ASSERT(error < 1e-5f);
+    }
+
+    Logger::Info("Layers are filtered on their own...");
+    Image layers(Format::R32G32B32A32SFloat, 8, 8, 1, 4, 2);
+    for (std::size_t i = 0; i < 2 * 8 * 8 * 4; i++)
+      ((float*)layers.data())[i] = i < 8 * 8 * 4 ? 0.25f : 0.75f;
+
+    MipmapGenerator(MipmapFilter::Lanczos).generate(layers);
+    for (std::uint32_t mip = 1; mip < 4; mip++) {
+      std::size_t count = (std::size_t)(8 >> mip) * (8 >> mip) * 4;
+      auto texels = mip_floats(layers, mip);
+      bool same = true;
+      for (std::size_t i = 0; i < count * 2; i++)
+        same = same && std::abs(texels[i] - (i < count ? 0.25f : 0.75f)) < 1e-6f;
+      ASSERT(same);
+    }
+
+    auto thrown = false;
+    try { Image dst; MipmapGenerator().generate(Image(), dst); } catch (const std::exception&) { thrown = true; }
+    ASSERT(thrown);
+  }
+
+  static void test_block_compression() {
+    Logger::Info("Mip chains and block sizes...");
+    Image src = make_test_image(100, 60);
+    Image bc1, bc7;
+    BlockCompressor compressor;
+    compressor.compress(src, bc1, Format::BC1RGBUNormBlock);
+    ASSERT(bc1.mipLevel() == 7 && bc1.width() == 100 && bc1.height() == 60);
+    compressor.compress(src, bc7, Format::BC7UNormBlock, 1);
+    ASSERT(bc7.mipLevel() == 1 && bc7.size() == 25 * 15 * 16);
+
+    BlockDecompressor decompressor;
+    Image decoded;
+    decompressor.decompress(bc1, decoded);
+    ASSERT(decoded.format() == Format::R8G8B8A8UNorm && decoded.mipLevel() == 7);
+    auto last = (const std::uint8_t*)decoded.data() + decoded.size() - 4;
+    ASSERT(last[3] == 255);
+
+    Logger::Info("Solid blocks come back exactly...");
+    Image solid(Format::R8G8B8A8UNorm, 8, 8);
+    for (std::size_t i = 0; i < solid.size(); i += 4) {
+      std::uint8_t texel[4] = { 12, 200, 77, 255 };
+      std::memcpy((char*)solid.data() + i, texel, 4);
+    }
+    for (auto format : { Format::BC1RGBUNormBlock, Format::BC3UNormBlock, Format::BC7UNormBlock }) {
+      Image blocks, texels;
+      compressor.compress(solid, blocks, format, 1);
+      decompressor.decompress(blocks, texels);
+      ASSERT(psnr(solid, texels, 3, 255.0) > 40.0);
+    }
+
+    Logger::Info("Transparent texels of BC1 stay transparent...");
+    Image cutout = make_test_image(64, 64);
+    Image bc1a, cutoutDecoded;
+    compressor.compress(cutout, bc1a, Format::BC1RGBAUNormBlock, 1);
+    decompressor.decompress(bc1a, cutoutDecoded);
+    for (std::size_t i = 0; i < 64 * 64; ++i)
+      ASSERT(((std::uint8_t)cutoutDecoded.data()[i * 4 + 3] == 0) == ((std::uint8_t)cutout.data()[i * 4 + 3] < 128));
+  }
+
+  static void test_block_quality() {
+    struct Case { Format format; int channels; double fast; };
+    const Case cases[] = {
+      { Format::BC1RGBUNormBlock, 3, 36.0 },
+      { Format::BC2UNormBlock, 4, 34.0 },
+      { Format::BC3UNormBlock, 4, 37.0 },
+      { Format::BC4UNormBlock, 1, 44.0 },
+      { Format::BC5SNormBlock, 2, 40.0 },
+      { Format::BC6HUFloatBlock, 3, 40.0 },
+      { Format::BC7UNormBlock, 4, 42.0 },
+    };
+
+    Logger::Info("Every format reaches its PSNR, the high quality mode at least as well...");
+    Image src = make_test_image(512, 512);
+    for (auto& test : cases) {
+      // BC6H decodes to halves but is compared in floats.
+      Format texels = BlockDecompressor::getDestFormat(test.format);
+      if (texels == Format::R16G16B16A16SFloat)
+        texels = Format::R32G32B32A32SFloat;
+      Image reference(texels, src);
+      if (test.format == Format::BC5SNormBlock) {
+        auto data = (float*)reference.data();
+        for (std::size_t i = 0; i < reference.size() / 4; ++i)
+          data[i] = data[i] * 2.0f - 1.0f;
+      } else if (test.format == Format::BC6HUFloatBlock) {
+        auto data = (float*)reference.data();
+        for (std::size_t i = 0; i < reference.size() / 4; ++i)
+          data[i] = std::exp2(data[i] * 10.0f) - 1.0f;
+      }
+
+      double previous = 0.0;
+      for (auto quality : { CompressQuality::Fast, CompressQuality::High }) {
+        BlockCompressor compressor(quality);
+        Image blocks, decoded;
+        compressor.compress(reference, blocks, test.format, 1);
+        BlockDecompressor().decompress(blocks, decoded, texels);
+
+        double value;
+        if (test.format == Format::BC6HUFloatBlock) {
+          // HDR error is measured on log2(1 + x), peaking at the brightest texel.
+          Image a(reference), b(decoded);
+          auto pa = (float*)a.data();
+          auto pb = (float*)b.data();
+          for (std::size_t i = 0; i < a.size() / 4; ++i) {
+            pa[i] = std::log2(1.0f + pa[i]);
+            pb[i] = std::log2(1.0f + std::max(pb[i], 0.0f));
+          }
+          value = psnr(a, b, test.channels, 10.0);
+        } else {
+          value = psnr(reference, decoded, test.channels, texels.pixel_size() == 4 ? 255.0 : 1.0);
+        }
+
+        ASSERT(value >= (quality == CompressQuality::Fast ? test.fast : previous - 0.05));
+        previous = value;
+      }
+    }
+  }
+
+  static void test_block_decompression() {
+    const Format formats[] = {
+      Format::BC1RGBUNormBlock, Format::BC1RGBAUNormBlock, Format::BC2UNormBlock, Format::BC3UNormBlock,
+      Format::BC4UNormBlock, Format::BC4SNormBlock, Format::BC5UNormBlock, Format::BC5SNormBlock,
+      Format::BC6HUFloatBlock, Format::BC6HSFloatBlock, Format::BC7UNormBlock, Format::BC7SRGBBlock,
+    };
+
+    Logger::Info("SIMD and scalar decoders agree on random blocks...");
+    for (auto format : formats) {
+      // Every bit pattern is a valid block, reserved modes included.
+      Image blocks;
+      blocks.create(format, 61, 37, 1, 3, 2);
+      std::uint32_t seed = 12345;
+      for (std::size_t i = 0; i < blocks.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        ((char*)blocks.data())[i] = (char)(seed >> 24);
+      }
+
+      for (auto target : { BlockDecompressor::getDestFormat(format), Format(Format::R8G8B8A8UNorm), Format(Format::R16G16B16A16SFloat) }) {
+        BlockDecompressor accelerated, scalar;
+        scalar.setAccelerated(false);
+
+        Image a, b;
+        accelerated.decompress(blocks, a, target);
+        scalar.decompress(blocks, b, target);
+        ASSERT(a.format() == target && a.mipLevel() == 3 && a.layerLevel() == 2 && a.width() == 61);
+        ASSERT(a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()) == 0);
+      }
+    }
+
+    Logger::Info("Images convert out of and into block formats...");
+    Image src = make_test_image(100, 60);
+    Image bc7(Format::BC7UNormBlock, src);
+    ASSERT(bc7.format() == Format::BC7UNormBlock && bc7.mipLevel() == 1);
+    Image rgba8(Format::R8G8B8A8UNorm, bc7);
+    Image expected;
+    BlockDecompressor().decompress(bc7, expected);
+    ASSERT(rgba8.size() == expected.size() && std::memcmp(rgba8.data(), expected.data(), rgba8.size()) == 0);
+    ASSERT(psnr(src, rgba8, 4, 255.0) > 30.0);
+    Image half(Format::R16G16B16A16SFloat, bc7);
+    ASSERT(half.format() == Format::R16G16B16A16SFloat && half.width() == 100);
+    Image bc1(Format::BC1RGBUNormBlock, bc7);
+    ASSERT(bc1.format() == Format::BC1RGBUNormBlock && bc1.size() == 25 * 15 * 8);
+  }
+
+  // Decodes an 8 bit PNG file with libpng itself, which checks every CRC and the zlib stream.
+  static bool png_decode(const std::vector<std::uint8_t>& file, std::vector<std::uint8_t>& pixels, png_uint_32& width, png_uint_32& height, int& channels) {
+    struct Source { const std::uint8_t* data; std::size_t size; std::size_t offset; } source = { file.data(), file.size(), 0 };
+
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png_create_info_struct(png);
+    if (setjmp(png_jmpbuf(png))) {
+      png_destroy_read_struct(&png, &info, nullptr);
+      return false;
+    }
+
+    png_set_read_fn(png, &source, [](png_structp png, png_bytep data, png_size_t length) {
+      auto source = (Source*)png_get_io_ptr(png);
+      if (source->size - source->offset < length)
+        png_error(png, "read past the end of the file");
+      std::memcpy(data, source->data + source->offset, length);
+      source->offset += length;
+    });
+
+    png_read_info(png, info);
+    if (png_get_bit_depth(png, info) != 8 || png_get_interlace_type(png, info) != PNG_INTERLACE_NONE)
+      png_error(png, "unexpected format");
+
+    width = png_get_image_width(png, info);
+    height = png_get_image_height(png, info);
+    channels = png_get_channels(png, info);
+
+    pixels.resize((std::size_t)width * height * channels);
+    for (png_uint_32 y = 0; y < height; y++)
+      png_read_row(png, pixels.data() + (std::size_t)y * width * channels, nullptr);
+    png_read_end(png, nullptr);
+
+    png_destroy_read_struct(&png, &info, nullptr);
+    return source.offset == source.size;
+  }
+
+  static void test_png_encoder() {
+    const std::uint32_t width = 97, height = 71;
+    Image rgba = make_test_image(width, height);
+
+    for (std::uint8_t channels = 1; channels <= 4; channels++) {
+      Logger::Info("Decoding " + std::to_string(channels) + " channel files with libpng...");
+
+      // The first channels of the test image, tightly packed.
+      std::vector<std::uint8_t> pixels((std::size_t)width * height * channels);
+      for (std::size_t i = 0; i < (std::size_t)width * height; i++)
+        std::memcpy(pixels.data() + i * channels, rgba.data() + i * 4, channels);
+
+      std::ptrdiff_t stride = width * channels;
+      std::vector<std::uint8_t> flipped(pixels.size());
+      for (std::uint32_t y = 0; y < height; y++)
+        std::memcpy(flipped.data() + y * stride, pixels.data() + (height - 1 - y) * stride, stride);
+
+      std::size_t stored = 0;
+      for (int level = 0; level <= 9; level++) {
+        for (std::uint32_t strip : { 0u, 1u, 7u, 64u, height }) {
+          PNGEncoder encoder(level);
+          encoder.setStripHeight(strip);
+          ASSERT(encoder.getLevel() == level && encoder.getStripHeight() == strip);
+
+          // Upright rows, and the flipped copy written bottom-up with a negative stride.
+          for (bool bottomUp : { false, true }) {
+            mstream stream(1);
+            if (bottomUp)
+              encoder.encode(stream, flipped.data() + (height - 1) * stride, width, height, channels, -stride);
+            else
+              encoder.encode(stream, pixels.data(), width, height, channels, stride);
+
+            std::vector<std::uint8_t> file((std::size_t)stream.size());
+            stream.seekg(0, ios_base::beg);
+            stream.read((char*)file.data(), file.size());
+
+            std::vector<std::uint8_t> decoded;
+            png_uint_32 w = 0, h = 0;
+            int c = 0;
+            ASSERT(png_decode(file, decoded, w, h, c));
+            ASSERT(w == width && h == height && c == channels && decoded == pixels);
+
+            if (level == 0 && strip == 0)
+              stored = file.size();
+            else if (level > 0 && strip == 0)
+              ASSERT(file.size() < stored);
+          }
+        }
+      }
+    }
+
+    Logger::Info("Out of range levels are clamped...");
+    ASSERT(PNGEncoder(-1).getLevel() == 0 && PNGEncoder(12).getLevel() == 9);
+  }
+
+  static void test_streaming() {
+    Logger::Info("Bands come out like whole loads...");
+    Image rgba = make_test_image(300, 200);
+    Image rgb(Format::R8G8B8UNorm, rgba);
+    Image hdr(Format::R32G32B32SFloat, rgba);
+
+    const std::pair<const char*, Image*> cases[] = { { "png", &rgba }, { "jpg", &rgb }, { "hdr", &hdr } };
+    for (auto& test : cases) {
+      // Memory streams are open once they have a buffer, which grows as it is written.
+      mstream stream(1);
+      ASSERT(test.second->save(stream, test.first));
+
+      Image whole;
+      stream.seekg(0, ios_base::beg);
+      ASSERT(whole.load(stream, test.first));
+
+      stream.seekg(0, ios_base::beg);
+      auto reader = ImageReader::open(stream, test.first);
+      ASSERT(reader && reader->width() == 300 && reader->height() == 200 && reader->format() == whole.format());
+
+      std::size_t pitch = 300 * whole.format().pixel_size();
+      std::vector<char> band(pitch * 16);
+      std::size_t offset = 0;
+      std::uint32_t rows;
+      bool same = true;
+      while ((rows = reader->read(band.data(), pitch, 16)) > 0) {
+        same = same && std::memcmp(band.data(), whole.data() + offset, rows * pitch) == 0;
+        offset += rows * pitch;
+      }
+      ASSERT(same && offset == whole.size() && reader->row() == 200);
+    }
+
+    Logger::Info("Types without bands are refused...");
+    mstream tga(1);
+    ASSERT(rgba.save(tga, "tga"));
+    tga.seekg(0, ios_base::beg);
+    ASSERT(!ImageReader::open(tga, "tga"));
+  }
+
+  // Writes the image into a file of the given type and returns its path.
+  static std::string save_file(const Image& image, const char* type, const std::string& name) {
+    mstream stream(1);
+    ASSERT(const_cast<Image&>(image).save(stream, type));
+    std::vector<char> bytes((std::size_t)stream.size());
+    stream.seekg(0, ios_base::beg);
+    stream.read(bytes.data(), bytes.size());
+    std::ofstream(name, std::ios::binary).write(bytes.data(), bytes.size());
+    return name;
+  }
+
+  static void test_batch_loading() {
+    Logger::Info("Batches come back in order and like single loads...");
+    Image rgba = make_test_image(120, 80);
+    Image rgb(Format::R8G8B8UNorm, rgba);
+    Image hdr(Format::R32G32B32SFloat, rgba);
+
+    std::vector<std::string> paths = {
+      save_file(rgba, "png", "octoon-batch-0.png"),
+      save_file(rgb, "jpg", "octoon-batch-1.JPG"),
+      save_file(hdr, "hdr", "octoon-batch-2.hdr"),
+      save_file(rgba, "tga", "octoon-batch-3.tga"),
+      save_file(rgba, "png", "octoon-batch-4.jpg"),
+      "octoon-batch-missing.png",
+    };
+
+    for (std::size_t threads : { 0, 1, 3 }) {
+      auto images = BatchLoader(threads).load(paths);
+      ASSERT(images.size() == paths.size() && !images.back());
+
+      for (std::size_t i = 0; i + 1 < paths.size(); i++) {
+        Image single(paths[i]);
+        ASSERT(images[i] && images[i]->format() == single.format() && images[i]->size() == single.size());
+        ASSERT(std::memcmp(images[i]->data(), single.data(), single.size()) == 0);
+      }
+    }
+
+    for (auto& path : paths)
+      std::remove(path.c_str());
+  }
+
+  static void test_jpeg_options() {
+    Logger::Info("Quality and optimized coding...");
+    Image rgba = make_test_image(300, 200);
+    Image rgb(Format::R8G8B8UNorm, rgba);
+    Image opaque(Format::R8G8B8A8UNorm, rgb);
+
+    auto encode = [](const Image& image, int quality, bool optimize) {
+      JPEGEncoder encoder(quality);
+      encoder.setOptimizeCoding(optimize);
+      auto stream = std::make_shared<mstream>(1);
+      encoder.encode(*stream, image);
+      stream->seekg(0, ios_base::beg);
+      return stream;
+    };
+    auto decode = [](mstream& stream, std::uint32_t scale, bool fast, bool alpha) {
+      JPEGDecoder decoder;
+      decoder.setScale(scale);
+      decoder.setFastDCT(fast);
+      decoder.setAlpha(alpha);
+      Image image;
+      stream.seekg(0, ios_base::beg);
+      decoder.decode(stream, image);
+      return image;
+    };
+
+    auto low = encode(rgb, 10, false);
+    auto high = encode(rgb, 95, false);
+    auto optimized = encode(rgb, 95, true);
+    ASSERT(low->size() < high->size() && optimized->size() < high->size());
+    ASSERT(psnr(opaque, decode(*low, 1, false, true), 3, 255.0) + 5.0 < psnr(opaque, decode(*high, 1, false, true), 3, 255.0));
+    ASSERT(psnr(decode(*high, 1, false, true), decode(*optimized, 1, false, true), 4, 255.0) == 99.0);
+
+    // RGBA rows lose their alpha, the colors stay.
+    auto fromRGBA = encode(rgba, 95, false);
+    ASSERT(psnr(decode(*high, 1, false, true), decode(*fromRGBA, 1, false, true), 4, 255.0) == 99.0);
+
+    Logger::Info("Alpha, fast DCT and scaled decodes...");
+    Image gray(Format::R8UNorm, 300, 200);
+    for (std::size_t i = 0; i < gray.size(); i++)
+      ((std::uint8_t*)gray.data())[i] = (std::uint8_t)(i * 7 / 300);
+
+    for (auto source : { high, encode(gray, 90, false) }) {
+      Image three = decode(*source, 1, false, false);
+      Image four = decode(*source, 1, false, true);
+      ASSERT(three.format() == Format::R8G8B8SRGB && four.format() == Format::R8G8B8A8SRGB);
+
+      bool same = true;
+      for (std::size_t i = 0; i < 300 * 200; i++)
+        same = same && std::memcmp(three.data() + i * 3, four.data() + i * 4, 3) == 0 && (std::uint8_t)four.data()[i * 4 + 3] == 0xFF;
+      ASSERT(same);
+    }
+
+    ASSERT(psnr(decode(*high, 1, false, true), decode(*high, 1, true, true), 3, 255.0) > 35.0);
+
+    for (std::uint32_t scale : { 1, 2, 4, 8 }) {
+      Image small = decode(*high, scale, false, true);
+      ASSERT(small.width() == (300 + scale - 1) / scale && small.height() == (200 + scale - 1) / scale);
+
+      // Close to the source sampled at the middle of every block of scale x scale texels.
+      Image sampled(Format::R8G8B8A8SRGB, small.width(), small.height());
+      for (std::uint32_t y = 0; y < small.height(); y++)
+        for (std::uint32_t x = 0; x < small.width(); x++)
+          std::memcpy((char*)sampled.data() + (y * small.width() + x) * 4, opaque.data() + (std::min(y * scale + scale / 2, 199u) * 300 + std::min(x * scale + scale / 2, 299u)) * 4, 4);
+      ASSERT(psnr(sampled, small, 3, 255.0) > 20.0);
+    }
+
+    JPEGDecoder rounded;
+    rounded.setScale(5);
+    ASSERT(rounded.getScale() == 4);
+  }
+
+  // Entries keep their texels and gutters and their cells neither overlap nor leave the atlas.
+  static bool check_atlas(const ImageAtlas& atlas, const std::vector<std::pair<std::uint32_t, Image*>>& entries) {
+    const Image& image = atlas.getImage();
+    std::uint32_t g = atlas.getGutter(), p = atlas.getPadding(), align = 1;
+    while (align * 2 <= g)
+      align *= 2;
+
+    auto texel = [&](std::int64_t x, std::int64_t y) { return image.data() + (y * image.width() + x) * 4; };
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+      auto rect = atlas.getRect(entries[i].first);
+      auto& src = *entries[i].second;
+      if (rect.width != src.width() || rect.height != src.height() || (rect.x - g) % align || (rect.y - g) % align)
+        return false;
+      if (rect.x < g || rect.y < g || rect.x + rect.width + g + p > image.width() || rect.y + rect.height + g + p > image.height())
+        return false;
+
+      for (std::int64_t y = -(std::int64_t)g; y < rect.height + g; y++) {
+        for (std::int64_t x = -(std::int64_t)g; x < rect.width + g; x++) {
+          auto sx = std::min<std::int64_t>(std::max<std::int64_t>(x, 0), rect.width - 1);
+          auto sy = std::min<std::int64_t>(std::max<std::int64_t>(y, 0), rect.height - 1);
+          if (std::memcmp(texel(rect.x + x, rect.y + y), src.data() + (sy * src.width() + sx) * 4, 4) != 0)
+            return false;
+        }
+      }
+
+      for (std::size_t j = 0; j < i; j++) {
+        auto other = atlas.getRect(entries[j].first);
+        if (rect.x - g < other.x + other.width + g + p && other.x - g < rect.x + rect.width + g + p &&
+            rect.y - g < other.y + other.height + g + p && other.y - g < rect.y + rect.height + g + p)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  static void test_atlas() {
+    std::uint32_t seed = 7;
+    auto random = [&](std::uint32_t lo, std::uint32_t hi) { seed = seed * 1664525 + 1013904223; return lo + (seed >> 8) % (hi - lo + 1); };
+
+    std::vector<Image> sources;
+    for (std::uint32_t i = 0; i < 60; i++) {
+      sources.emplace_back(Format::R8G8B8A8UNorm, random(3, 30), random(3, 30));
+      for (std::size_t t = 0; t < sources.back().size(); t++)
+        ((std::uint8_t*)sources.back().data())[t] = (std::uint8_t)random(0, 255);
+    }
+
+    for (auto packing : { AtlasPacking::Skyline, AtlasPacking::MaxRects }) {
+      Logger::Info("Entries keep their texels, gutters and alignment...");
+      ImageAtlas atlas(Format::R8G8B8A8UNorm, 256, 256, 1, 2, packing);
+      std::vector<std::pair<std::uint32_t, Image*>> entries;
+      for (auto& source : sources) {
+        auto id = atlas.insert(source);
+        if (id)
+          entries.emplace_back(id, &source);
+      }
+      ASSERT(entries.size() > 40 && atlas.getCount() == entries.size());
+      ASSERT(check_atlas(atlas, entries));
+
+      auto uv = atlas.getTexcoords(entries[3].first);
+      auto rect = atlas.getRect(entries[3].first);
+      ASSERT(uv.x == rect.x / 256.0f && uv.w == (rect.y + rect.height) / 256.0f);
+
+      bool thrown = false;
+      try {
+        atlas.insert(Image(Format::R8UNorm, 4, 4));
+      } catch (const octoon::runtime::exception&) {
+        thrown = true;
+      }
+      ASSERT(thrown && !atlas.insert(Image(Format::R8G8B8A8UNorm, 300, 4)));
+
+      Logger::Info("Dirty rectangles cover changes and join...");
+      atlas.clearDirtyRects();
+      auto removed = atlas.getRect(entries[0].first);
+      ASSERT(atlas.remove(entries[0].first) && !atlas.remove(entries[0].first) && !atlas.contains(entries[0].first));
+      entries.erase(entries.begin());
+      ASSERT(atlas.getDirtyRects().size() == 1);
+      auto dirty = atlas.getDirtyRects()[0];
+      ASSERT(dirty.x + 2 == removed.x && dirty.y + 2 == removed.y && dirty.width >= removed.width + 5);
+
+      bool cleared = true;
+      for (std::uint32_t y = 0; y < dirty.height; y++)
+        for (std::uint32_t x = 0; x < dirty.width * 4; x++)
+          cleared = cleared && atlas.getImage().data()[((dirty.y + y) * 256 + dirty.x) * 4 + x] == 0;
+      ASSERT(cleared);
+
+      Logger::Info("Removal and defragmenting...");
+      float before = atlas.getOccupancy();
+      for (std::size_t i = 0; i < entries.size(); i += 2)
+        ASSERT(atlas.remove(entries[i].first));
+      std::vector<std::pair<std::uint32_t, Image*>> kept;
+      for (std::size_t i = 1; i < entries.size(); i += 2)
+        kept.push_back(entries[i]);
+      ASSERT(atlas.getOccupancy() < before && check_atlas(atlas, kept));
+
+      ASSERT(atlas.defragment());
+      ASSERT(atlas.getGeneration() == 1 && atlas.getDirtyRects().size() == 1 && atlas.getDirtyRects()[0].width == 256);
+      ASSERT(check_atlas(atlas, kept));
+
+      for (auto& source : sources) {
+        auto id = atlas.insert(source);
+        if (id)
+          kept.emplace_back(id, &source);
+      }
+      ASSERT(kept.size() > entries.size() / 2 + 20 && check_atlas(atlas, kept));
+    }
+  }
+
+  void Test() override {
+    Unit("test_every_pair", []{ test_every_pair(); });
+    Unit("test_round_trips", []{ test_round_trips(); });
+    Unit("test_channels", []{ test_channels(); });
+    Unit("test_image_create", []{ test_image_create(); });
+    Unit("test_mipmap", []{ test_mipmap(); });
+    Unit("test_block_compression", []{ test_block_compression(); });
+    Unit("test_block_quality", []{ test_block_quality(); });
+    Unit("test_block_decompression", []{ test_block_decompression(); });
+    Unit("test_png_encoder", []{ test_png_encoder(); });
+    Unit("test_streaming", []{ test_streaming(); });
+    Unit("test_batch_loading", []{ test_batch_loading(); });
+    Unit("test_jpeg_options", []{ test_jpeg_options(); });
+    Unit("test_atlas", []{ test_atlas(); });
+  }
+};
+
+void test_octoon_image() {
+  UnitTest::Test(OctoonImageTestObject());
+}
@@ -2,11 +2,25 @@
 // Author: PENGUINLIONG
 #include <vector>
 #include <string>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <future>
 
 #include "octoon/io/ioserver.h"
 #include "octoon/io/vstream.h"
 #include "octoon/io/zarchive.h"
 #include "octoon/io/farchive.h"
+#include "octoon/io/file_buf.h"
+#include "octoon/io/mapbuf.h"
+#include "octoon/io/membuf.h"
+#include "octoon/io/ringbuf.h"
+#include "octoon/io/async_loader.h"
+#include "octoon/io/resource_cache.h"
+#include "octoon/io/serialization_buf.h"
+#include "octoon/io/json_reader.h"
+#include "octoon/io/mstream.h"
 
 #include "LiongPlus/Testing/UnitTest.hpp"
 
@@ -97,6 +111,450 @@ class OctoonIoTestObject : public TestObject
     file.close();
   }
 
+  static void test_filebuf_buffered() {
+    const char* path = "./testenv/io/octoon-file/buffered.bin";
+
+    Logger::Info("Writing small records through a 64 bytes block...");
+    filebuf buf;
+    buf.set_block_size(64);
+    ASSERT(buf.open(path, octoon::io::ios_base::in | octoon::io::ios_base::out | octoon::io::ios_base::trunc));
+    for (std::uint32_t i = 0; i < 100; i++)
+      ASSERT(buf.write((const char*)&i, sizeof(i)) == sizeof(i));
+    ASSERT(buf.tellg() == 400);
+    ASSERT(buf.size() == 400);
+    ASSERT(buf.close());
+
+    Logger::Info("Reading back with seeks, peek and view...");
+    ASSERT(buf.open(path, octoon::io::ios_base::in));
+    ASSERT(buf.size() == 400);
+
+    std::uint32_t value = 0;
+    ASSERT(buf.read((char*)&value, sizeof(value)) == sizeof(value) && value == 0);
+    ASSERT(buf.seekg(8, octoon::io::ios_base::beg) == 8);
+    ASSERT(buf.read((char*)&value, sizeof(value)) == sizeof(value) && value == 2);
+
+    auto data = buf.view(sizeof(value));
+    ASSERT(data && std::memcmp(data, "\x03\0\0\0", 4) == 0);
+    data = buf.peek(sizeof(value) * 2);
+    ASSERT(data && ((const std::uint32_t*)data)[1] == 5);
+    ASSERT(buf.tellg() == 16);
+    ASSERT(buf.read((char*)&value, sizeof(value)) == sizeof(value) && value == 4);
+
+    ASSERT(buf.seekg(-4, octoon::io::ios_base::end) == 396);
+    ASSERT(buf.read((char*)&value, sizeof(value)) == sizeof(value) && value == 99);
+    ASSERT(buf.read((char*)&value, sizeof(value)) == 0);
+
+    std::vector<std::uint32_t> all(100);
+    ASSERT(buf.seekg(0, octoon::io::ios_base::beg) == 0);
+    ASSERT(buf.read((char*)all.data(), 400) == 400);
+    for (std::uint32_t i = 0; i < 100; i++)
+      ASSERT(all[i] == i);
+    ASSERT(buf.close());
+
+    std::remove(path);
+  }
+
+  static void test_mapbuf_view() {
+    Logger::Info("Mapping file...");
+    mapbuf buf;
+    ASSERT(buf.open("./testenv/io/octoon-file/read.txt", mapbuf::advice::sequential));
+    ASSERT(buf.size() >= 4);
+    ASSERT(std::memcmp(buf.data(), "Test", 4) == 0);
+
+    Logger::Info("Viewing and reading...");
+    auto data = buf.view(2);
+    ASSERT(data && std::memcmp(data, "Te", 2) == 0);
+    ASSERT(buf.tellg() == 2);
+    std::string rest(2, 0);
+    ASSERT(buf.read((char*)rest.data(), 2) == 2 && rest == "st");
+    ASSERT(buf.seekg(0, octoon::io::ios_base::beg) == 0);
+    ASSERT(buf.peek(buf.size()) == buf.data());
+    ASSERT(!buf.view(buf.size() + 1));
+    ASSERT(buf.write("x", 1) == 0);
+    ASSERT(buf.close());
+
+    Logger::Info("Directories can't be mapped...");
+    ASSERT(!buf.open("./testenv/io/octoon-file"));
+  }
+
+  static void test_exists_tracks_changes() {
+    Orl orl;
+    ASSERT(Orl::parse("dir:cached.txt", orl));
+    auto archive = IoServer::instance()->get_archive(orl);
+
+    Logger::Info("Caching a missing item...");
+    ASSERT(archive->exists(orl) == ItemType::NA);
+
+    Logger::Info("Creating it behind the archive's back...");
+    auto file = std::fopen("./testenv/io/octoon-file/cached.txt", "wb");
+    ASSERT(file);
+    std::fclose(file);
+    ASSERT(archive->exists(orl) == ItemType::File);
+
+    Logger::Info("Querying in bulk...");
+    std::vector<ItemType> types;
+    archive->exists({ orl, gen_read_orl(0), gen_dir_orl(0) }, types);
+    ASSERT(types.size() == 3);
+    ASSERT(types[0] == ItemType::File && types[1] == ItemType::File && types[2] == ItemType::Directory);
+
+    std::remove("./testenv/io/octoon-file/cached.txt");
+    ASSERT(archive->exists(orl) == ItemType::NA);
+  }
+
+  static void test_zip_stored_view() {
+    auto orl = gen_read_orl(2);
+    auto entry = IoServer::instance()->get_archive(orl)->open(orl, octoon::io::ios_base::in);
+    ASSERT(entry != nullptr);
+
+    Logger::Info("Stored entries are views into the archive...");
+    ASSERT(entry->size() == 4);
+    auto data = entry->view(4);
+    ASSERT(data && std::memcmp(data, "Test", 4) == 0);
+    ASSERT(entry->tellg() == 4);
+    ASSERT(entry->seekg(1, octoon::io::ios_base::beg) == 1);
+    ASSERT(entry->peek(3) && std::memcmp(entry->peek(3), "est", 3) == 0);
+    ASSERT(!entry->peek(4));
+  }
+
+  // A single stored entry named "a" holding "Test", with the central directory sizes given.
+  static std::string make_stored_zip(std::uint32_t compressed_size, std::uint32_t size) {
+    auto put16 = [](std::string& out, std::uint16_t value) { out += char(value & 0xFF); out += char(value >> 8); };
+    auto put32 = [&](std::string& out, std::uint32_t value) { put16(out, value & 0xFFFF); put16(out, value >> 16); };
+
+    std::string zip;
+    put32(zip, 0x04034b50);
+    put16(zip, 10); put16(zip, 0); put16(zip, 0); put32(zip, 0); put32(zip, 0);
+    put32(zip, 4); put32(zip, 4); put16(zip, 1); put16(zip, 0);
+    zip += "aTest";
+
+    auto central = zip.size();
+    put32(zip, 0x02014b50);
+    put16(zip, 10); put16(zip, 10); put16(zip, 0); put16(zip, 0); put32(zip, 0); put32(zip, 0);
+    put32(zip, compressed_size); put32(zip, size); put16(zip, 1); put16(zip, 0); put16(zip, 0);
+    put16(zip, 0); put16(zip, 0); put32(zip, 0); put32(zip, 0);
+    zip += "a";
+
+    auto central_size = zip.size() - central;
+    put32(zip, 0x06054b50);
+    put16(zip, 0); put16(zip, 0); put16(zip, 1); put16(zip, 1);
+    put32(zip, std::uint32_t(central_size)); put32(zip, std::uint32_t(central)); put16(zip, 0);
+    return zip;
+  }
+
+  static void test_zip_stored_malformed() {
+    const char* path = "./testenv/io/octoon-malformed.zip";
+    Orl orl("zip", "a");
+
+    Logger::Info("Opening a well formed stored entry...");
+    std::ofstream(path, std::ios::binary) << make_stored_zip(4, 4);
+    {
+      zarchive archive(path);
+      auto entry = archive.open(orl, octoon::io::ios_base::in);
+      ASSERT(entry != nullptr && entry->size() == 4);
+    }
+
+    Logger::Info("Rejecting stored entries whose sizes disagree...");
+    std::ofstream(path, std::ios::binary) << make_stored_zip(4, 0x10000000);
+    {
+      zarchive archive(path);
+      ASSERT(archive.exists(orl) == ItemType::File);
+      ASSERT(archive.open(orl, octoon::io::ios_base::in) == nullptr);
+    }
+    std::ofstream(path, std::ios::binary) << make_stored_zip(2, 4);
+    {
+      zarchive archive(path);
+      ASSERT(archive.open(orl, octoon::io::ios_base::in) == nullptr);
+    }
+
+    std::remove(path);
+  }
+
+  static void test_membuf_read_at() {
+    std::vector<std::uint8_t> data(1 << 16);
+    for (size_t i = 0; i < data.size(); ++i)
+      data[i] = (std::uint8_t)(i * 7);
+    membuf buf(data);
+
+    Logger::Info("Reading at offsets from several threads...");
+    std::vector<std::thread> readers;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); ++t) {
+      readers.emplace_back([&, t]{
+        char chunk[100];
+        for (size_t pos = t; pos + sizeof(chunk) <= data.size(); pos += 997) {
+          if (buf.read_at(pos, chunk, sizeof(chunk)) != sizeof(chunk) || std::memcmp(chunk, data.data() + pos, sizeof(chunk)) != 0)
+            ++failures[t];
+        }
+      });
+    }
+    for (auto& it : readers)
+      it.join();
+    for (auto it : failures)
+      ASSERT(it == 0);
+
+    Logger::Info("Cursor is left alone...");
+    ASSERT(buf.tellg() == 0);
+    char tail[8];
+    ASSERT(buf.read_at(data.size() - 4, tail, sizeof(tail)) == 4);
+    ASSERT(buf.read_at(data.size(), tail, sizeof(tail)) == 0);
+
+    Logger::Info("Peek and view stop at the end...");
+    ASSERT(buf.seekg(data.size() - 2, ios_base::beg) == (streamoff)data.size() - 2);
+    ASSERT(buf.peek(2) && !buf.peek(3));
+    ASSERT(buf.view(2) && !buf.view(1));
+    ASSERT(!buf.peek(1) && !buf.peek(-1));
+  }
+
+  static void test_ringbuf_spsc() {
+    ringbuf pipe(1000);
+    ASSERT(pipe.capacity() == 1024);
+
+    const std::uint32_t count = 100000;
+
+    Logger::Info("Streaming through a single producer, single consumer pipe...");
+    std::thread producer([&]{
+      for (std::uint32_t i = 0; i < count;) {
+        if (pipe.write((const char*)&i, sizeof(i)) == sizeof(i))
+          ++i;
+        else
+          std::this_thread::yield();
+      }
+      pipe.finish();
+    });
+
+    std::uint32_t expected = 0;
+    bool ordered = true;
+    while (!pipe.eof()) {
+      std::uint32_t value;
+      if (pipe.size() < (octoon::io::streamsize)sizeof(value)) {
+        std::this_thread::yield();
+        continue;
+      }
+      ASSERT(pipe.read((char*)&value, sizeof(value)) == sizeof(value));
+      ordered &= value == expected++;
+    }
+    producer.join();
+
+    ASSERT(ordered);
+    ASSERT(expected == count);
+    ASSERT(pipe.tellg() == count * sizeof(std::uint32_t));
+  }
+
+  static void test_async_loader() {
+    AsyncLoader loader(1, 1);
+    auto orl = gen_read_orl(0);
+
+    Logger::Info("Coalescing requests for the same file...");
+    std::promise<void> gate;
+    auto opened = gate.get_future().share();
+    auto decoder = [opened](istream& stream) {
+      opened.wait();
+      auto bytes = std::make_shared<std::string>(stream.size(), 0);
+      stream.read(&(*bytes)[0], bytes->size());
+      return bytes;
+    };
+
+    int called = 0;
+    std::string content;
+    auto first = loader.load(orl, "text", decoder, [&](const std::shared_ptr<void>& result) {
+      content = *std::static_pointer_cast<std::string>(result);
+      ++called;
+    });
+    auto second = loader.load(orl, "text", decoder, [&](const std::shared_ptr<void>&) { ++called; });
+    auto cancelled = loader.load(orl, "text", decoder, [&](const std::shared_ptr<void>&) { ++called; }, LoadPriority::High);
+    ASSERT(loader.pending() == 1);
+    cancelled.cancel();
+    ASSERT(cancelled.status() == LoadStatus::Cancelled);
+    gate.set_value();
+
+    ASSERT(first.get<std::string>() != nullptr);
+    ASSERT(first.future().get() == second.future().get());
+
+    Logger::Info("Callbacks run on dispatch...");
+    ASSERT(called == 0);
+    ASSERT(loader.dispatch() == 2);
+    ASSERT(called == 2);
+    ASSERT(content == "Test");
+    ASSERT(first.status() == LoadStatus::Done);
+
+    Logger::Info("Reading raw bytes and failing...");
+    auto bytes = loader.load_bytes(orl).get<AsyncLoader::Bytes>();
+    ASSERT(bytes && bytes->size() == 4 && std::memcmp(bytes->data(), "Test", 4) == 0);
+    Orl missing;
+    ASSERT(Orl::parse("dir:missing.txt", missing));
+    auto failed = loader.load_bytes(missing);
+    ASSERT(failed.future().get() == nullptr);
+    ASSERT(failed.status() == LoadStatus::Failed);
+    loader.dispatch();
+    ASSERT(loader.pending() == 0);
+  }
+
+  static void test_resource_cache() {
+    ResourceCache cache(10);
+    auto loaded = 0;
+    auto load = [&](const Orl& orl, size_t& bytes) {
+      ++loaded;
+      bytes = orl.path().size();
+      return std::make_shared<std::string>(orl.path());
+    };
+
+    Logger::Info("Sharing handles...");
+    Orl orl_a, orl_b;
+    ASSERT(Orl::parse("dir:aaaa", orl_a) && Orl::parse("dir:bbbbbbbb", orl_b));
+    auto a = cache.load<std::string>(orl_a, nullptr, load);
+    ASSERT(cache.load<std::string>(orl_a, nullptr, load) == a);
+    ASSERT(cache.load<std::string>(orl_a, "other", load) != a);
+    ASSERT(loaded == 2);
+    ASSERT(cache.get<std::vector<char>>(orl_a) == nullptr);
+
+    Logger::Info("Evicting unused entries over budget...");
+    cache.erase<std::string>(orl_a, "other");
+    auto b = cache.load<std::string>(orl_b, nullptr, load);
+    ASSERT(cache.memory<std::string>() == 12);
+    b.reset();
+    cache.get<std::string>(orl_a);
+    cache.trim();
+    ASSERT(cache.memory<std::string>() == 4);
+    a.reset();
+    cache.set_budget(0);
+    auto stats = cache.stats();
+    ASSERT(stats.count == 0 && stats.bytes == 0);
+    ASSERT(stats.hits == 2 && stats.misses == 4 && stats.evictions == 2);
+
+    Logger::Info("Invalidating on unmount...");
+    cache.set_budget(1024);
+    auto inst = IoServer::instance();
+    inst->mount_archive("cache", std::make_shared<farchive>("./testenv/io/octoon-file"));
+    Orl orl_c;
+    ASSERT(Orl::parse("cache:cccc", orl_c));
+    cache.load<std::string>(orl_c, nullptr, load);
+    cache.load<std::string>(orl_a, nullptr, load);
+    inst->unmount_archive("cache");
+    ASSERT(cache.get<std::string>(orl_c) == nullptr);
+    ASSERT(cache.get<std::string>(orl_a) != nullptr);
+    ASSERT(cache.stats().invalidations == 1);
+  }
+
+  static void test_serialization_buf() {
+    serialization_buf root;
+
+    Logger::Info("Keeping insertion order past the index threshold...");
+    for (int i = 0; i < 100; ++i)
+      root["key" + std::to_string(99 - i)] = i;
+    ASSERT(root.is_object());
+    int order = 0;
+    for (auto& it : root)
+      ASSERT(it.second.get<serialization_buf::number_integer_t>() == order++);
+    ASSERT(order == 100);
+
+    Logger::Info("Looking up members...");
+    const auto& croot = root;
+    for (int i = 0; i < 100; ++i)
+      ASSERT(croot["key" + std::to_string(i)].get<serialization_buf::number_integer_t>() == 99 - i);
+    ASSERT(croot["missing"].is_null());
+    root.push_back("key0", 1000);
+    ASSERT(croot["key0"].get<serialization_buf::number_integer_t>() == 99);
+
+    Logger::Info("Sharing the document with nested objects...");
+    root["child"]["key0"] = std::string("nested");
+    for (int i = 0; i < 10; ++i)
+      root["pad" + std::to_string(i)] = i;
+    root["child"]["key1"] = std::string("moved");
+    ASSERT(croot["child"]["key0"].get<serialization_buf::string_t>() == "nested");
+    ASSERT(croot["child"]["key1"].get<serialization_buf::string_t>() == "moved");
+    ASSERT(croot["child"].begin()->first.data() == croot.begin()[99].first.data());
+    for (int i = 0; i < 3; ++i)
+      root["list"][i]["key0"] = i;
+    ASSERT(croot["list"].size() == 3 && croot["list"][2]["key0"].get<serialization_buf::number_integer_t>() == 2);
+    ASSERT(croot["list"][2].begin()->first.data() == croot.begin()[99].first.data());
+
+    serialization_buf moved(std::move(root["child"]));
+    ASSERT(moved["key1"].get<serialization_buf::string_t>() == "moved");
+    ASSERT(croot["child"].is_null());
+
+    Logger::Info("Replacing values of another type...");
+    moved["key1"] = moved["key1"].get<serialization_buf::string_t>();
+    ASSERT(moved["key1"].get<serialization_buf::string_t>() == "moved");
+    moved["key1"] = 2.5f;
+    ASSERT(moved["key1"].is_float() && moved["key1"].get<float>() == 2.5f);
+    moved["list"][2] = true;
+    ASSERT(moved["list"].size() == 3 && moved["list"][2].get<bool>() && moved["list"][std::size_t(0)].is_null());
+
+    // A node taking over one of its own members.
+    moved = std::move(moved["list"]);
+    ASSERT(moved.is_array() && moved.size() == 3 && moved[2].get<bool>());
+    moved.clear();
+    ASSERT(moved.is_null() && moved.size() == 0);
+  }
+
+  struct JsonRecorder : public JsonHandler {
+    std::vector<std::string> events;
+    std::vector<octoon::math::float3> points;
+    bool onNull() override { events.push_back("null"); return true; }
+    bool onBoolean(bool value) override { events.push_back(value ? "true" : "false"); return true; }
+    bool onNumber(double value) override { events.push_back(std::to_string(value)); return true; }
+    bool onString(const char* value, std::size_t length) override { events.push_back("\"" + std::string(value, length)); return true; }
+    bool onKey(const char* key, std::size_t length) override { events.push_back(std::string(key, length) + ":"); return true; }
+    bool onStartObject() override { events.push_back("{"); return true; }
+    bool onEndObject() override { events.push_back("}"); return true; }
+    bool onStartArray() override { events.push_back("["); return true; }
+    bool onEndArray() override { events.push_back("]"); return true; }
+    bool wantFloat3Array() override { return events.size() >= 2 && events[events.size() - 2] == "points:"; }
+    bool onFloat3Array(const octoon::math::float3* values, std::size_t count) override {
+      points.insert(points.end(), values, values + count);
+      return true;
+    }
+  };
+
+  static void test_json_sax() {
+    std::string doc = "{\"name\" : \"a\\\"b\\u00e9\\ud83d\\ude00\", \"values\":[0,-1.5,3e2,12345678901234567890,0.1,true,false,null,{},[]],\n\"points\":[";
+    for (int i = 0; i < 10000; ++i)
+      doc += (i ? ",[" : "[") + std::to_string(i) + ".25, -" + std::to_string(i) + (i % 2 ? ",8]" : "]");
+    doc += "]}";
+
+    std::vector<std::string> expected = {
+      "{", "name:", "\"a\"b\xc3\xa9\xf0\x9f\x98\x80", "values:", "[",
+      std::to_string(0.0), std::to_string(-1.5), std::to_string(300.0), std::to_string(12345678901234567890.0), std::to_string(0.1),
+      "true", "false", "null", "{", "}", "[", "]", "]", "points:", "[", "]", "}"
+    };
+
+    Logger::Info("Parsing from memory...");
+    JsonRecorder memory;
+    ASSERT(JsonReader::parse(doc.data(), doc.size(), memory));
+    ASSERT(memory.events == expected);
+    ASSERT(memory.points.size() == 10000);
+    ASSERT(memory.points[9999] == octoon::math::float3(9999.25f, -9999.0f, 8.0f));
+    ASSERT(memory.points[4096] == octoon::math::float3(4096.25f, -4096.0f, 0.0f));
+
+    Logger::Info("Parsing across stream chunks...");
+    imstream stream(std::vector<std::uint8_t>(doc.begin(), doc.end()));
+    JsonReader reader(stream);
+    JsonRecorder streamed;
+    ASSERT(reader.parse(streamed));
+    ASSERT(streamed.events == expected);
+    ASSERT(streamed.points == memory.points);
+
+    Logger::Info("Parsing numbers longer than a chunk...");
+    std::string numbers = "[0." + std::string(3000, '1') + ", 1" + std::string(2000, '0') + "e-2000, 0." + std::string(70000, '5') + ", 12345]";
+    std::vector<std::string> expectedNumbers = { "[", "0.111111", "1.000000", "0.555556", "12345.000000", "]" };
+    JsonRecorder longMemory;
+    ASSERT(JsonReader::parse(numbers.data(), numbers.size(), longMemory));
+    ASSERT(longMemory.events == expectedNumbers);
+    imstream longStream(std::vector<std::uint8_t>(numbers.begin(), numbers.end()));
+    JsonReader longReader(longStream);
+    JsonRecorder longStreamed;
+    ASSERT(longReader.parse(longStreamed));
+    ASSERT(longStreamed.events == expectedNumbers);
+
+    Logger::Info("Rejecting malformed input...");
+    for (auto bad : { "{\"a\":}", "[1,]", "[01]", "{\"a\" 1}", "[\"abc]", "[1] 2", "[-]", "[1.e5]" }) {
+      JsonRecorder recorder;
+      auto thrown = false;
+      try { JsonReader::parse(bad, std::strlen(bad), recorder); } catch (const std::exception&) { thrown = true; }
+      ASSERT(thrown);
+    }
+  }
+
   static Orl gen_dir_orl(size_t index) {
     static std::vector<std::string> orls = {
       "dir:octoon-file",
@@ -176,6 +634,29 @@ class OctoonIoTestObject : public TestObject
     Unit("test_vfstream_write_local_dir_file",        []{ test_vfstream_write(0); });
     Unit("test_vfstream_write_local_dir_file_in_dir", []{ test_vfstream_write(1); });
 
+    // `filebuf` buffering.
+
+    Unit("test_filebuf_buffered", []{ test_filebuf_buffered(); });
+
+    Unit("test_mapbuf_view", []{ test_mapbuf_view(); });
+
+    Unit("test_exists_tracks_changes", []{ test_exists_tracks_changes(); });
+
+    Unit("test_zip_stored_view", []{ test_zip_stored_view(); });
+    Unit("test_zip_stored_malformed", []{ test_zip_stored_malformed(); });
+
+    Unit("test_membuf_read_at", []{ test_membuf_read_at(); });
+
+    Unit("test_ringbuf_spsc", []{ test_ringbuf_spsc(); });
+
+    Unit("test_async_loader", []{ test_async_loader(); });
+
+    Unit("test_resource_cache", []{ test_resource_cache(); });
+
+    Unit("test_serialization_buf", []{ test_serialization_buf(); });
+
+    Unit("test_json_sax", []{ test_json_sax(); });
+
     // Item removal.
 
     Unit("fail_remove_file_wrong_type", []{
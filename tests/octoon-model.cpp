@@ -0,0 +1,758 @@
+// File: octoon-model.cpp
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstring>
+
+#include "octoon/io/mstream.h"
+#include "octoon/model/animation_blender.h"
+#include "octoon/model/ik_solver.h"
+#include "octoon/model/mesh.h"
+#include "octoon/model/model.h"
+#include "octoon/model/morph.h"
+#include "octoon/model/morph_engine.h"
+#include "octoon/model/pmx_loader.h"
+#include "octoon/model/vmd_loader.h"
+
+#include "LiongPlus/Testing/UnitTest.hpp"
+
+using namespace LiongPlus::Testing;
+using namespace octoon::model;
+using namespace octoon::math;
+
+class OctoonModelTestObject : public TestObject
+{
+  static bool near(float a, float b, float eps = 1e-4f) {
+    return std::abs(a - b) <= eps;
+  }
+  static bool near(const Quaternion& a, const Quaternion& b, float eps = 1e-4f) {
+    float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    return near(std::abs(dot), 1.0f, eps);
+  }
+  static bool near(const float3& a, const float3& b, float eps = 1e-4f) {
+    return near(a.x, b.x, eps) && near(a.y, b.y, eps) && near(a.z, b.z, eps);
+  }
+
+  // A chain of bones one unit apart along y.
+  static Bones make_chain(std::size_t count) {
+    Bones bones(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      bones[i].setName("bone" + std::to_string(i));
+      bones[i].setParent((std::int16_t)i - 1);
+      bones[i].setPosition(float3(0.0f, (float)i, 0.0f));
+    }
+    return bones;
+  }
+
+  // Turns every bone of the chain around z by angles[n] at frame n * 10.
+  static AnimationPropertyPtr make_clip(std::size_t count, const std::vector<float>& angles) {
+    Interpolation linear;
+    for (int i = 0; i < 4; ++i)
+      linear.interpX[i] = linear.interpY[i] = linear.interpZ[i] = linear.interpW[i] = i < 2 ? 20 : 107;
+
+    auto clip = std::make_shared<AnimationProperty>();
+    for (std::size_t i = 0; i < count; ++i) {
+      for (std::size_t n = 0; n < angles.size(); ++n) {
+        BoneAnimation key;
+        key.setName("bone" + std::to_string(i));
+        key.setFrameNo((std::int32_t)n * 10);
+        key.setPosition(float3::Zero);
+        key.setRotation(Quaternion(float3::UnitZ, angles[n]));
+        key.setInterpolation(linear);
+        clip->addBoneAnimation(key);
+      }
+    }
+    return clip;
+  }
+
+  // Appends little endian PMX fields to a byte buffer.
+  struct PmxBuilder {
+    std::vector<std::uint8_t> data;
+
+    template<typename T>
+    void put(const T& value) {
+      auto bytes = (const std::uint8_t*)&value;
+      data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+    void text(const std::string& str) {
+      put((std::uint32_t)str.size());
+      data.insert(data.end(), str.begin(), str.end());
+    }
+    void vertex(const float3& position, std::uint8_t type) {
+      put(position);
+      put(float3::UnitY);
+      put(float2(position.x, position.y));
+      put(type);
+    }
+  };
+
+  // 5000 vertices so the loader decodes several chunks, 300 bones so the indices need 16 bits.
+  // Only vertices 0, 1, 2, 4 and 4999 are used by the two materials.
+  static std::vector<std::uint8_t> make_pmx() {
+    PmxBuilder pmx;
+    pmx.data.assign({ 'P', 'M', 'X', ' ' });
+    pmx.put(2.0f);
+    pmx.put((std::uint8_t)8);
+    std::uint8_t globals[8] = { 1, 0, 2, 1, 1, 2, 1, 1 };
+    pmx.put(globals);
+    pmx.text("test");
+    pmx.text("");
+    pmx.text("");
+    pmx.text("");
+
+    pmx.put((std::uint32_t)5000);
+    pmx.vertex(float3(0.0f, 0.0f, 0.0f), 0);
+    pmx.put((std::int16_t)299);
+    pmx.put(0.0f);
+    pmx.vertex(float3(1.0f, 0.0f, 0.0f), 1);
+    pmx.put((std::int16_t)256);
+    pmx.put((std::int16_t)1);
+    pmx.put(0.25f);
+    pmx.put(0.0f);
+    pmx.vertex(float3(2.0f, 0.0f, 0.0f), 2);
+    pmx.put((std::int16_t)10);
+    pmx.put((std::int16_t)270);
+    pmx.put((std::int16_t)-1);
+    pmx.put((std::int16_t)-1);
+    pmx.put(float4(0.5f, 0.5f, 0.0f, 0.0f));
+    pmx.put(0.0f);
+    for (int i = 3; i < 5000; ++i) {
+      if (i == 4) {
+        pmx.vertex(float3(4.0f, 0.0f, 0.0f), 3);
+        pmx.put((std::int16_t)3);
+        pmx.put((std::int16_t)280);
+        pmx.put(0.75f);
+        float3 sdef[3];
+        pmx.put(sdef);
+      } else if (i == 4999) {
+        pmx.vertex(float3(5.0f, 0.0f, 0.0f), 2);
+        pmx.put((std::int16_t)298);
+        pmx.put((std::int16_t)299);
+        pmx.put((std::int16_t)0);
+        pmx.put((std::int16_t)0);
+        pmx.put(float4(0.125f, 0.875f, 0.0f, 0.0f));
+      } else {
+        pmx.vertex(float3((float)i, 1.0f, 0.0f), 0);
+        pmx.put((std::int16_t)7);
+      }
+      pmx.put(0.0f);
+    }
+
+    std::uint16_t indices[6] = { 0, 1, 2, 2, 4, 4999 };
+    pmx.put((std::uint32_t)6);
+    pmx.put(indices);
+
+    pmx.put((std::uint32_t)0);
+
+    pmx.put((std::uint32_t)2);
+    for (int i = 0; i < 2; ++i) {
+      pmx.text("material" + std::to_string(i));
+      pmx.text("");
+      pmx.put(float3::One);
+      pmx.put(1.0f);
+      pmx.put(float3::Zero);
+      pmx.put(5.0f);
+      pmx.put(float3::Zero);
+      pmx.put((std::uint8_t)0);
+      pmx.put(float4::Zero);
+      pmx.put(1.0f);
+      pmx.put((std::int8_t)-1);
+      pmx.put((std::int8_t)-1);
+      pmx.put((std::uint8_t)0);
+      pmx.put((std::uint8_t)1);
+      pmx.put((std::uint8_t)0);
+      pmx.text("");
+      pmx.put((std::uint32_t)3);
+    }
+
+    pmx.put((std::uint32_t)300);
+    for (int i = 0; i < 300; ++i) {
+      pmx.text("bone" + std::to_string(i));
+      pmx.text("");
+      pmx.put(float3(0.0f, (float)i, 0.0f));
+      pmx.put((std::int16_t)(i - 1));
+      pmx.put((std::uint32_t)0);
+      pmx.put((std::uint16_t)0);
+      pmx.put(float3::UnitY);
+    }
+
+    // Vertex 3 is not used by any face, its offset is dropped.
+    pmx.put((std::uint32_t)1);
+    pmx.text("morph");
+    pmx.text("");
+    pmx.put((std::uint8_t)1);
+    pmx.put((std::uint8_t)1);
+    pmx.put((std::uint32_t)2);
+    pmx.put((std::uint16_t)2);
+    pmx.put(float3(1.0f, 2.0f, 3.0f));
+    pmx.put((std::uint16_t)3);
+    pmx.put(float3(4.0f, 5.0f, 6.0f));
+
+    pmx.put((std::uint32_t)0);
+    pmx.put((std::uint32_t)0);
+    pmx.put((std::uint32_t)0);
+    return pmx.data;
+  }
+
+  // Bone keys go round robin over the tracks with falling frame numbers, so the loader has to
+  // sort them. 5000 keys span more than one read block.
+  static std::vector<std::uint8_t> make_vmd(const std::vector<std::string>& tracks, std::size_t numKeys) {
+    PmxBuilder vmd;
+    char magic[30] = "Vocaloid Motion Data 0002";
+    char name[20] = "motion";
+    vmd.put(magic);
+    vmd.put(name);
+
+    vmd.put((std::uint32_t)numKeys);
+    for (std::size_t i = 0; i < numKeys; ++i) {
+      char track[15] = {};
+      std::memcpy(track, tracks[i % tracks.size()].data(), tracks[i % tracks.size()].size());
+      std::uint8_t interp[64];
+      for (int k = 0; k < 64; ++k)
+        interp[k] = (std::uint8_t)k;
+
+      vmd.put(track);
+      vmd.put((std::uint32_t)(numKeys - i));
+      vmd.put(float3((float)i, 0.0f, 0.0f));
+      vmd.put(Quaternion(float3::UnitY, 0.5f));
+      vmd.put(interp);
+    }
+
+    vmd.put((std::uint32_t)3);
+    const char* morphs[3] = { "b", "a", "a" };
+    for (int i = 0; i < 3; ++i) {
+      char morph[15] = {};
+      morph[0] = morphs[i][0];
+      vmd.put(morph);
+      vmd.put((std::uint32_t)(3 - i));
+      vmd.put(0.25f * i);
+    }
+    return vmd.data;
+  }
+
+  // Small deterministic generator, the morph tests compare two evaluations of the same data.
+  struct Random {
+    std::uint32_t state = 12345;
+    std::uint32_t next() { state = state * 1664525u + 1013904223u; return state >> 8; }
+    float uniform() { return (next() & 0xFFFF) / 65535.0f * 2.0f - 1.0f; }
+  };
+
+  // Leaf morphs 0..count-1 touch random sorted vertices of two meshes, every third one also
+  // moves normals and texcoords. The last two morphs are groups, the very last one refers to
+  // itself and must be ignored for that entry.
+  static Morphs make_morphs(std::size_t numVertices, std::size_t count) {
+    Random random;
+    Morphs morphs;
+    for (std::size_t i = 0; i < count; ++i) {
+      std::vector<MorphTarget> targets;
+      for (std::uint32_t mesh = 0; mesh < 2; ++mesh) {
+        MorphTarget target;
+        target.mesh = mesh;
+        for (std::uint32_t v = random.next() % 8; v < numVertices; v += 1 + random.next() % 24) {
+          target.indices.push_back(v);
+          target.offsets.push_back(float3(random.uniform(), random.uniform(), random.uniform()));
+          if (i % 3 == 0) {
+            target.normals.push_back(float3(random.uniform(), random.uniform(), random.uniform()) * 0.1f);
+            target.texcoords.push_back(float2(random.uniform(), random.uniform()));
+          }
+        }
+        targets.push_back(std::move(target));
+      }
+
+      auto morph = std::make_shared<Morph>("morph" + std::to_string(i), MorphType::Vertex);
+      morph->setTargetArray(std::move(targets));
+      morphs.push_back(morph);
+    }
+
+    auto group = std::make_shared<Morph>("group", MorphType::Group);
+    group->setGroupArray({ MorphGroup{ 1, 0.5f }, MorphGroup{ 2, -1.0f }, MorphGroup{ 3, 2.0f } });
+    morphs.push_back(group);
+
+    auto cycle = std::make_shared<Morph>("cycle", MorphType::Group);
+    cycle->setGroupArray({ MorphGroup{ (std::uint32_t)count, 1.0f }, MorphGroup{ (std::uint32_t)count + 1, 1.0f }, MorphGroup{ 4, 0.25f } });
+    morphs.push_back(cycle);
+    return morphs;
+  }
+
+  static void test_pose_pool() {
+    Pose pose(6);
+    ASSERT(pose.size() == 6);
+    ASSERT(pose.capacity() == 8);
+    for (std::size_t i = 0; i < pose.capacity(); ++i)
+      ASSERT(pose.tx[i] == 0.0f && pose.qx[i] == 0.0f && pose.qw[i] == 1.0f);
+
+    pose.setTranslate(5, float3(1.0f, 2.0f, 3.0f));
+    pose.setRotation(5, Quaternion(float3::UnitZ, 1.0f));
+    ASSERT(near(pose.getTranslate(5), float3(1.0f, 2.0f, 3.0f)));
+    ASSERT(near(pose.getRotation(5), Quaternion(float3::UnitZ, 1.0f)));
+
+    Pose other(6);
+    other.copy(pose);
+    ASSERT(near(other.getTranslate(5), float3(1.0f, 2.0f, 3.0f)));
+
+    PosePool pool;
+    pool.reserve(3, 6);
+    ASSERT(pool.getNumBones() == 6);
+    ASSERT(pool.getNumFree() == 3);
+
+    auto a = pool.alloc();
+    auto b = pool.alloc();
+    ASSERT(a && b && a != b);
+    ASSERT(a->size() == 6);
+    ASSERT(pool.getNumFree() == 1);
+
+    pool.free(a);
+    pool.free(b);
+    ASSERT(pool.getNumFree() == 3);
+  }
+
+  static void test_blend_override() {
+    auto bones = make_chain(6);
+
+    AnimationBlender blender;
+    blender.setBoneArray(bones);
+    blender.addLayer(make_clip(6, { 1.0f }), AnimationBlendMode::Override, 0.5f);
+
+    // Halfway from the rest pose towards the clip, translations stay at the rest offsets.
+    auto& pose = blender.evaluate();
+    for (std::size_t i = 0; i < 6; ++i) {
+      ASSERT(near(pose.getRotation(i), Quaternion(float3::UnitZ, 0.5f)));
+      ASSERT(near(pose.getTranslate(i), float3(0.0f, i ? 1.0f : 0.0f, 0.0f)));
+    }
+
+    // Full weight restricted to the first and last bone.
+    blender.setLayerWeight(0, 1.0f);
+    blender.setLayerMask(0, std::vector<std::size_t>{ 0, 5 }, 1.0f);
+
+    auto& masked = blender.evaluate();
+    for (std::size_t i = 0; i < 6; ++i)
+      ASSERT(near(masked.getRotation(i), (i == 0 || i == 5) ? Quaternion(float3::UnitZ, 1.0f) : Quaternion::Zero));
+
+    // A later override layer at full weight replaces the earlier one.
+    blender.clearLayerMask(0);
+    blender.addLayer(make_clip(6, { -0.25f }), AnimationBlendMode::Override, 1.0f);
+
+    auto& replaced = blender.evaluate();
+    for (std::size_t i = 0; i < 6; ++i)
+      ASSERT(near(replaced.getRotation(i), Quaternion(float3::UnitZ, -0.25f)));
+
+    // Layers without weight are skipped.
+    blender.setLayerWeight(1, 0.0f);
+    ASSERT(near(blender.evaluate().getRotation(3), Quaternion(float3::UnitZ, 1.0f)));
+  }
+
+  static void test_blend_additive() {
+    auto bones = make_chain(6);
+
+    AnimationBlender blender;
+    blender.setBoneArray(bones);
+    blender.addLayer(make_clip(6, { 1.0f }), AnimationBlendMode::Override, 1.0f);
+
+    // The additive clip turns by 0.5 between its first frame and frame 10.
+    auto additive = make_clip(6, { 0.25f, 0.75f });
+    blender.addLayer(additive, AnimationBlendMode::Additive, 1.0f);
+
+    additive->setCurrentFrame(0);
+    for (std::size_t i = 0; i < 6; ++i)
+      ASSERT(near(blender.evaluate().getRotation(i), Quaternion(float3::UnitZ, 1.0f)));
+
+    additive->setCurrentFrame(10);
+    auto& pose = blender.evaluate();
+    for (std::size_t i = 0; i < 6; ++i)
+      ASSERT(near(pose.getRotation(i), Quaternion(float3::UnitZ, 1.5f)));
+
+    blender.setLayerWeight(1, 0.5f);
+    ASSERT(near(blender.evaluate().getRotation(2), Quaternion(float3::UnitZ, 1.25f)));
+
+    // Removing the additive layer returns its reference pose to the pool.
+    blender.removeLayer(1);
+    ASSERT(blender.getNumLayers() == 1);
+    ASSERT(near(blender.evaluate().getRotation(2), Quaternion(float3::UnitZ, 1.0f)));
+
+    // Applying pushes the blended pose into the skeleton of the target.
+    AnimationProperty target;
+    target.setBoneArray(bones);
+    blender.apply(target);
+    ASSERT(near(target.getBoneArray()[4].getRotation(), Quaternion(float3::UnitZ, 1.0f)));
+  }
+
+  // Chains of bones one unit apart along y side by side, each ending in an effector and followed
+  // by a goal bone without a parent. Links are listed from the effector down, as PMX stores them.
+  struct IKRig {
+    Bones bones;
+    InverseKinematics iks;
+    std::vector<float3> offsets;
+
+    void rest(Pose& pose) const {
+      pose.resize(bones.size());
+      pose.setIdentity();
+      for (std::size_t i = 0; i < bones.size(); ++i)
+        pose.setTranslate(i, offsets[i]);
+    }
+  };
+
+  static IKRig make_ik_rig(const std::vector<float3>& goals, std::size_t links, std::uint32_t iterations) {
+    IKRig rig;
+    for (std::size_t chain = 0; chain < goals.size(); ++chain) {
+      std::size_t base = rig.bones.size();
+      for (std::size_t i = 0; i <= links; ++i) {
+        rig.bones.emplace_back("bone" + std::to_string(base + i));
+        rig.bones.back().setParent(i ? (std::int16_t)(base + i - 1) : (std::int16_t)-1);
+        rig.offsets.push_back(i ? float3::UnitY : float3(chain * 10.0f, 0.0f, 0.0f));
+      }
+      rig.bones.emplace_back("goal" + std::to_string(chain));
+      rig.bones.back().setParent(-1);
+      rig.offsets.push_back(goals[chain] + float3(chain * 10.0f, 0.0f, 0.0f));
+
+      IKAttr ik;
+      ik.boneIndex = (std::uint16_t)(base + links + 1);
+      ik.targetBoneIndex = (std::uint16_t)(base + links);
+      ik.iterations = iterations;
+      ik.chainLength = (std::uint32_t)links;
+      for (std::size_t i = links; i-- > 0;)
+        ik.child.push_back(IKChild{ (std::uint16_t)(base + i), 0, 1.0f, float3::Zero, float3::Zero });
+      rig.iks.push_back(ik);
+    }
+    return rig;
+  }
+
+  static float3 world_position(const Bones& bones, const Pose& pose, std::size_t bone) {
+    float3 position = pose.getTranslate(bone);
+    for (auto parent = bones[bone].getParent(); parent >= 0; parent = bones[parent].getParent())
+      position = pose.getTranslate(parent) + rotate(pose.getRotation(parent), position);
+    return position;
+  }
+
+  static void test_ik_converge() {
+    auto rig = make_ik_rig({ float3(1.5f, 1.5f, 0.5f) }, 3, 50);
+
+    IKSolver solver;
+    solver.setBoneArray(rig.bones);
+    solver.setIKArray(rig.iks);
+    solver.setTolerance(1e-3f);
+    ASSERT(solver.getNumStages() == 1 && solver.getChainStats().size() == 1);
+
+    Pose pose;
+    rig.rest(pose);
+    solver.solve(pose);
+
+    auto& stats = solver.getChainStats()[0];
+    ASSERT(stats.converged && stats.iterations <= 50);
+    ASSERT(distance(world_position(rig.bones, pose, 3), float3(1.5f, 1.5f, 0.5f)) < 1e-3f);
+
+    // Only the local rotations of the links change.
+    ASSERT(near(pose.getRotation(3), Quaternion::Zero) && near(pose.getTranslate(2), float3::UnitY));
+  }
+
+  static void test_ik_limits() {
+    // The goal needs a quarter turn around z from the single link, which may turn 30 degrees.
+    auto rig = make_ik_rig({ float3(-1.0f, 0.0f, 0.0f) }, 1, 20);
+    rig.iks[0].child[0].rotateLimited = 1;
+    rig.iks[0].child[0].minimumDegrees = float3(0.0f, 0.0f, -30.0f);
+    rig.iks[0].child[0].maximumDegrees = float3(0.0f, 0.0f, 30.0f);
+
+    IKSolver solver;
+    solver.setBoneArray(rig.bones);
+    solver.setIKArray(rig.iks);
+    solver.setTolerance(1e-3f);
+
+    Pose pose;
+    rig.rest(pose);
+    solver.solve(pose);
+
+    auto rotation = pose.getRotation(0);
+    ASSERT(near(rotation.x, 0.0f) && near(rotation.y, 0.0f));
+    ASSERT(near(std::abs(rotation.z), std::sin(radians(15.0f))));
+    ASSERT(!solver.getChainStats()[0].converged);
+
+    // Without the limit the same goal is reached.
+    rig.iks[0].child[0].rotateLimited = 0;
+    solver.setIKArray(rig.iks);
+    rig.rest(pose);
+    solver.solve(pose);
+    ASSERT(solver.getChainStats()[0].converged);
+    ASSERT(near(std::abs(pose.getRotation(0).z), std::sin(radians(45.0f)), 1e-3f));
+  }
+
+  static void test_ik_early_out() {
+    // The first goal sits on the effector, the second lies straight ahead and out of reach.
+    auto rig = make_ik_rig({ float3(0.0f, 3.0f, 0.0f), float3(0.0f, 10.0f, 0.0f) }, 3, 50);
+
+    IKSolver solver;
+    solver.setBoneArray(rig.bones);
+    solver.setIKArray(rig.iks);
+    solver.setTolerance(1e-3f);
+
+    Pose pose;
+    rig.rest(pose);
+    solver.solve(pose);
+
+    auto& reached = solver.getChainStats()[0];
+    ASSERT(reached.converged && reached.iterations == 1);
+
+    // Nothing rotates towards a goal on the line of the chain, so it stops after one iteration.
+    auto& straight = solver.getChainStats()[1];
+    ASSERT(!straight.converged && straight.iterations == 1);
+
+    for (std::size_t i = 0; i < pose.size(); ++i)
+      ASSERT(near(pose.getRotation(i), Quaternion::Zero));
+  }
+
+  static void test_ik_parallel() {
+    std::vector<float3> goals;
+    for (int i = 0; i < 16; ++i)
+      goals.push_back(float3(std::sin(i * 0.7f) * 2.0f, 1.0f + (i % 3), std::cos(i * 0.4f)));
+    auto rig = make_ik_rig(goals, 4, 30);
+
+    IKSolver parallel, serial;
+    for (auto solver : { &parallel, &serial }) {
+      solver->setBoneArray(rig.bones);
+      solver->setIKArray(rig.iks);
+      solver->setTolerance(1e-4f);
+    }
+    serial.setParallelEnable(false);
+    ASSERT(parallel.getNumStages() == 1 && parallel.getChainStats().size() == 16);
+
+    Pose a, b;
+    rig.rest(a);
+    rig.rest(b);
+    for (int frame = 0; frame < 3; ++frame) {
+      parallel.solve(a);
+      serial.solve(b);
+    }
+
+    // Chains of one stage share no bones, the order they run in changes nothing.
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      auto qa = a.getRotation(i), qb = b.getRotation(i);
+      ASSERT(qa.x == qb.x && qa.y == qb.y && qa.z == qb.z && qa.w == qb.w);
+    }
+    for (std::size_t i = 0; i < 16; ++i)
+      ASSERT(parallel.getChainStats()[i].iterations == serial.getChainStats()[i].iterations);
+  }
+
+  static void test_pmx_loader() {
+    auto data = make_pmx();
+
+    Model model;
+    octoon::io::imstream stream(data);
+    ASSERT(PmxLoader().doLoad(stream, model));
+
+    // One de-indexed mesh per material, in face order.
+    auto& meshes = model.getMeshsList();
+    ASSERT(meshes.size() == 2);
+    ASSERT(model.getMaterialsList().size() == 2);
+
+    auto& vertices0 = meshes[0]->getVertexArray();
+    auto& vertices1 = meshes[1]->getVertexArray();
+    ASSERT(vertices0.size() == 3 && vertices1.size() == 3);
+    ASSERT(meshes[0]->getIndicesArray().size() == 3 && meshes[0]->getIndicesArray()[2] == 2);
+    ASSERT(near(vertices0[0], float3(0.0f, 0.0f, 0.0f)) && near(vertices0[1], float3(1.0f, 0.0f, 0.0f)) && near(vertices0[2], float3(2.0f, 0.0f, 0.0f)));
+    ASSERT(near(vertices1[0], float3(2.0f, 0.0f, 0.0f)) && near(vertices1[1], float3(4.0f, 0.0f, 0.0f)) && near(vertices1[2], float3(5.0f, 0.0f, 0.0f)));
+    ASSERT(near(meshes[1]->getNormalArray()[2], float3::UnitY));
+    ASSERT(meshes[1]->getTexcoordArray()[2].x == 5.0f);
+
+    // Bone indices above 255 survive, unused slots read as bone 0.
+    auto& weights0 = meshes[0]->getWeightArray();
+    auto& weights1 = meshes[1]->getWeightArray();
+    ASSERT(weights0[0].bone1 == 299 && weights0[0].weight1 == 1.0f && weights0[0].weight2 == 0.0f);
+    ASSERT(weights0[1].bone1 == 256 && weights0[1].bone2 == 1 && weights0[1].weight1 == 0.25f && weights0[1].weight2 == 0.75f);
+    ASSERT(weights0[2].bone2 == 270 && weights0[2].bone3 == 0 && weights0[2].bone4 == 0 && weights0[2].weight2 == 0.5f);
+    ASSERT(weights1[0].bone2 == 270);
+    ASSERT(weights1[1].bone1 == 3 && weights1[1].bone2 == 280 && weights1[1].weight2 == 0.25f);
+    ASSERT(weights1[2].bone1 == 298 && weights1[2].bone2 == 299 && weights1[2].weight2 == 0.875f);
+
+    auto& bones = model.getBonesList();
+    ASSERT(bones.size() == 300);
+    ASSERT(bones[299]->getName() == "bone299" && bones[299]->getParent() == 298);
+    ASSERT(bones[0]->getParent() == -1);
+
+    // The morph follows vertex 2 into both meshes.
+    auto& morphs = model.getMorphList();
+    ASSERT(morphs.size() == 1);
+    auto& targets = morphs[0]->getTargetArray();
+    ASSERT(targets.size() == 2);
+    ASSERT(targets[0].mesh == 0 && targets[0].indices.size() == 1 && targets[0].indices[0] == 2);
+    ASSERT(targets[1].mesh == 1 && targets[1].indices.size() == 1 && targets[1].indices[0] == 0);
+    ASSERT(near(targets[1].offsets[0], float3(1.0f, 2.0f, 3.0f)));
+
+    // Truncated files fail instead of reading past the end.
+    for (std::size_t size : { std::size_t(20), data.size() / 2, data.size() - 1 }) {
+      Model truncated;
+      octoon::io::imstream part(std::vector<std::uint8_t>(data.begin(), data.begin() + size));
+      ASSERT(!PmxLoader().doLoad(part, truncated));
+    }
+  }
+
+  static void test_vmd_loader() {
+    // "センター" in Shift_JIS comes back as UTF-8.
+    const std::string center = "\x83\x5A\x83\x93\x83\x5E\x81\x5B";
+    auto data = make_vmd({ center, "arm", "leg" }, 5000);
+
+    Model model;
+    octoon::io::imstream stream(data);
+    ASSERT(VmdLoader().doLoad(stream, model));
+    ASSERT(model.getAnimationList().size() == 1);
+
+    auto& motion = *model.getAnimationList()[0];
+    ASSERT(motion.getName() == "motion");
+    ASSERT(motion.getNumBoneAnimation() == 5000);
+
+    // Grouped by track in order of appearance, frames ascending within a track.
+    const std::string names[3] = { "\xE3\x82\xBB\xE3\x83\xB3\xE3\x82\xBF\xE3\x83\xBC", "arm", "leg" };
+    for (std::size_t i = 0; i < 5000; ++i) {
+      auto& key = motion.getBoneAnimation(i);
+      auto& name = names[i < 1667 ? 0 : i < 3334 ? 1 : 2];
+      ASSERT(key.getName() == name);
+      if (i > 0 && motion.getBoneAnimation(i - 1).getName() == name)
+        ASSERT(key.getFrameNo() > motion.getBoneAnimation(i - 1).getFrameNo());
+    }
+
+    // The last key of track 0 was written first, with frame 5000.
+    auto& last = motion.getBoneAnimation(1666);
+    ASSERT(last.getFrameNo() == 5000);
+    ASSERT(near(last.getPosition(), float3(0.0f, 0.0f, 0.0f)));
+    ASSERT(near(last.getRotation(), Quaternion(float3::UnitY, 0.5f)));
+    ASSERT(last.getInterpolation().interpX[1] == 4 && last.getInterpolation().interpW[3] == 15);
+
+    ASSERT(motion.getNumMorphAnimation() == 3);
+    ASSERT(motion.getMorphAnimation(0).getName() == "a" && motion.getMorphAnimation(0).getFrameNo() == 1);
+    ASSERT(motion.getMorphAnimation(1).getName() == "a" && motion.getMorphAnimation(1).getWeight() == 0.25f);
+    ASSERT(motion.getMorphAnimation(2).getName() == "b");
+
+    // Binding to a skeleton gives the keys the indices of their bones, -1 without one.
+    Bones bones(2);
+    bones[0].setName("leg");
+    bones[0].setParent(-1);
+    bones[1].setName("arm");
+    bones[1].setParent(0);
+    motion.setBoneArray(bones);
+    ASSERT(motion.getBoneAnimation(0).getBoneIndex() == -1);
+    ASSERT(motion.getBoneAnimation(1667).getBoneIndex() == 1 && motion.getBoneAnimation(4999).getBoneIndex() == 0);
+
+    // Files cut inside the bone keys fail.
+    Model truncated;
+    octoon::io::imstream part(std::vector<std::uint8_t>(data.begin(), data.begin() + data.size() / 2));
+    ASSERT(!VmdLoader().doLoad(part, truncated));
+
+    // Counts larger than the file are rejected before anything is allocated.
+    auto huge = data;
+    std::uint32_t count = 0xFFFFFFFF;
+    std::memcpy(huge.data() + 50, &count, sizeof(count));
+    octoon::io::imstream bones_stream(huge);
+    ASSERT(!VmdLoader().doLoad(bones_stream, truncated));
+
+    huge = data;
+    std::memcpy(huge.data() + 54 + 5000 * 111, &count, sizeof(count));
+    octoon::io::imstream morphs_stream(huge);
+    ASSERT(!VmdLoader().doLoad(morphs_stream, truncated));
+  }
+
+  static void test_morph_sparse() {
+    const std::size_t numVertices = 20000;
+    const std::size_t count = 12;
+    auto morphs = make_morphs(numVertices, count);
+
+    float3s vertices(numVertices), normals(numVertices);
+    float2s texcoords(numVertices);
+    for (std::size_t v = 0; v < numVertices; ++v) {
+      vertices[v] = float3((float)v, 1.0f, -1.0f);
+      normals[v] = float3::UnitY;
+      texcoords[v] = float2(0.5f, 0.5f);
+    }
+
+    std::vector<float> weights(morphs.size(), 0.0f);
+    weights[0] = 1.0f;
+    weights[1] = 0.3f;
+    weights[5] = -0.75f;
+    weights[6] = 0.5f;
+    weights[count] = 0.5f;
+    weights[count + 1] = 1.0f;
+
+    // The flattened weight of every leaf, by hand: the group adds 0.5 * (0.5, -1, 2) to morphs
+    // 1, 2 and 3, the cycle adds the group once more and 0.25 of morph 4.
+    std::vector<float> leaves(weights.begin(), weights.begin() + count);
+    leaves[1] += (0.5f + 1.0f) * 0.5f;
+    leaves[2] += (0.5f + 1.0f) * -1.0f;
+    leaves[3] += (0.5f + 1.0f) * 2.0f;
+    leaves[4] += 0.25f;
+
+    MorphEngine engine;
+    engine.setMorphArray(morphs);
+    ASSERT(engine.getNumMorphs() == count + 2);
+    ASSERT(engine.findMorph("group") == count);
+    ASSERT(engine.findMorph("missing") == count + 2);
+
+    for (std::size_t i = 0; i < weights.size(); ++i)
+      engine.setWeight(i, weights[i]);
+    engine.update();
+    ASSERT(engine.getNumActive(0) == 7 && engine.getNumActive(1) == 7);
+
+    for (std::size_t mesh = 0; mesh < 2; ++mesh) {
+      // Dense reference: scatter every active target into full size delta arrays.
+      float3s denseVertices(vertices), denseNormals(normals);
+      float2s denseTexcoords(texcoords);
+      std::vector<bool> touched(numVertices, false);
+      for (std::size_t i = 0; i < count; ++i) {
+        auto& target = morphs[i]->getTargetArray()[mesh];
+        for (std::size_t j = 0; j < target.indices.size(); ++j) {
+          auto v = target.indices[j];
+          denseVertices[v] += target.offsets[j] * leaves[i];
+          if (!target.normals.empty() && leaves[i] != 0.0f) {
+            denseNormals[v] += target.normals[j] * leaves[i];
+            denseTexcoords[v] += target.texcoords[j] * leaves[i];
+            touched[v] = true;
+          }
+        }
+      }
+      for (std::size_t v = 0; v < numVertices; ++v) {
+        if (touched[v])
+          denseNormals[v] = normalize(denseNormals[v]);
+      }
+
+      // Serial and parallel evaluation both match it.
+      for (bool parallel : { false, true }) {
+        engine.setParallelEnable(parallel);
+
+        float3s outVertices, outNormals;
+        float2s outTexcoords;
+        engine.evaluate(mesh, vertices, normals, outVertices, outNormals);
+        engine.evaluate(mesh, texcoords, outTexcoords);
+
+        std::size_t mismatches = 0;
+        for (std::size_t v = 0; v < numVertices; ++v) {
+          if (!near(outVertices[v], denseVertices[v], 1e-3f) || !near(outNormals[v], denseNormals[v], 1e-3f))
+            ++mismatches;
+          if (!near(outTexcoords[v].x, denseTexcoords[v].x, 1e-3f) || !near(outTexcoords[v].y, denseTexcoords[v].y, 1e-3f))
+            ++mismatches;
+        }
+        ASSERT(mismatches == 0);
+      }
+    }
+
+    // Without weights the streams come back unchanged.
+    engine.clearWeights();
+    engine.update();
+    ASSERT(engine.getNumActive() == 0);
+
+    float3s outVertices, outNormals;
+    engine.evaluate(0, vertices, normals, outVertices, outNormals);
+    ASSERT(outVertices == vertices && outNormals == normals);
+  }
+
+  void Test() override {
+    Unit("test_pmx_loader", []{ test_pmx_loader(); });
+    Unit("test_vmd_loader", []{ test_vmd_loader(); });
+    Unit("test_morph_sparse", []{ test_morph_sparse(); });
+    Unit("test_pose_pool", []{ test_pose_pool(); });
+    Unit("test_blend_override", []{ test_blend_override(); });
+    Unit("test_blend_additive", []{ test_blend_additive(); });
+    Unit("test_ik_converge", []{ test_ik_converge(); });
+    Unit("test_ik_limits", []{ test_ik_limits(); });
+    Unit("test_ik_early_out", []{ test_ik_early_out(); });
+    Unit("test_ik_parallel", []{ test_ik_parallel(); });
+  }
+};
+
+void test_octoon_model() {
+  UnitTest::Test(OctoonModelTestObject());
+}
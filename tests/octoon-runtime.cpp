@@ -0,0 +1,137 @@
+// File: octoon-runtime.cpp
+#include <vector>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <memory>
+
+#include "octoon/runtime/thread_pool.h"
+
+#include "LiongPlus/Testing/UnitTest.hpp"
+
+using namespace LiongPlus::Testing;
+using namespace octoon::runtime;
+
+class OctoonRuntimeTestObject : public TestObject
+{
+  // Runs a parallel_for over n items and checks that every item was visited once.
+  static void check_cover(ThreadPool& pool, std::size_t n, std::size_t grain) {
+    std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[n]);
+    for (std::size_t i = 0; i < n; ++i)
+      visits[i] = 0;
+
+    // Assertions are not thread safe, bad ranges are counted instead.
+    std::atomic<int> bad(0);
+    pool.parallel_for(0, n, grain, [&](std::size_t first, std::size_t last) {
+      if (first >= last || last > n) {
+        bad++;
+        return;
+      }
+      for (std::size_t i = first; i < last; ++i)
+        visits[i]++;
+    });
+
+    ASSERT(bad == 0);
+    for (std::size_t i = 0; i < n; ++i)
+      ASSERT(visits[i] == 1);
+  }
+
+  static void test_thread_pool_async() {
+    ThreadPool pool(3);
+    ASSERT(pool.size() == 3);
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 64; ++i)
+      results.push_back(pool.async([i] { return i * i; }));
+
+    for (int i = 0; i < 64; ++i)
+      ASSERT(results[i].get() == i * i);
+
+    // Without threads a task runs on the caller before push returns.
+    ThreadPool inline_pool(0);
+    int value = 0;
+    inline_pool.push([&] { value = 1; });
+    ASSERT(value == 1);
+
+    ASSERT(ThreadPool::instance() != nullptr);
+    ASSERT(ThreadPool::instance() == ThreadPool::instance());
+  }
+
+  static void test_parallel_for() {
+    ThreadPool pool(3);
+    check_cover(pool, 1, 1);
+    check_cover(pool, 7, 1);
+    check_cover(pool, 1000, 1);
+    check_cover(pool, 1000, 64);
+    check_cover(pool, 1000, 5000);
+
+    ThreadPool inline_pool(0);
+    check_cover(inline_pool, 100, 1);
+
+    // An empty range never calls the body.
+    bool called = false;
+    pool.parallel_for(5, 5, 1, [&](std::size_t, std::size_t) { called = true; });
+    pool.parallel_for(6, 5, 1, [&](std::size_t, std::size_t) { called = true; });
+    ASSERT(!called);
+
+    // Offsets are kept.
+    std::atomic<std::size_t> sum(0);
+    pool.parallel_for(100, 200, 10, [&](std::size_t first, std::size_t last) {
+      for (auto i = first; i < last; ++i)
+        sum += i;
+    });
+    ASSERT(sum == 14950);
+  }
+
+  static void test_parallel_for_repeated() {
+    // Short runs one after another, where the last chunk of one call finishes while the
+    // caller already returns from it.
+    ThreadPool pool(3);
+    for (int round = 0; round < 2000; ++round) {
+      std::atomic<int> count(0);
+      pool.parallel_for(0, 4, 1, [&](std::size_t first, std::size_t last) { count += (int)(last - first); });
+      ASSERT(count == 4);
+    }
+  }
+
+  static void test_parallel_for_nested() {
+    // Every worker is busy in the outer loop and starts an inner one, the inner chunks
+    // are run by whoever waits for them.
+    ThreadPool pool(2);
+    std::atomic<std::size_t> total(0);
+
+    pool.parallel_for(0, 16, 1, [&](std::size_t first, std::size_t last) {
+      for (auto i = first; i < last; ++i) {
+        pool.parallel_for(0, 100, 1, [&](std::size_t a, std::size_t b) {
+          total += b - a;
+        });
+      }
+    });
+
+    ASSERT(total == 1600);
+
+    // Tasks pushed by hand that block on a parallel_for of the same pool.
+    std::vector<std::future<std::size_t>> results;
+    for (int i = 0; i < 4; ++i) {
+      results.push_back(pool.async([&pool] {
+        std::atomic<std::size_t> count(0);
+        pool.parallel_for(0, 64, 1, [&](std::size_t a, std::size_t b) { count += b - a; });
+        return count.load();
+      }));
+    }
+
+    for (auto& it : results)
+      ASSERT(it.get() == 64);
+  }
+
+  void Test() override {
+    Unit("test_thread_pool_async", []{ test_thread_pool_async(); });
+    Unit("test_parallel_for", []{ test_parallel_for(); });
+    Unit("test_parallel_for_repeated", []{ test_parallel_for_repeated(); });
+    Unit("test_parallel_for_nested", []{ test_parallel_for_nested(); });
+  }
+};
+
+void test_octoon_runtime() {
+  UnitTest::Test(OctoonRuntimeTestObject());
+}
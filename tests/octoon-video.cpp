@@ -0,0 +1,215 @@
+// File: octoon-video.cpp
+#include <vector>
+#include <future>
+#include <cstring>
+#include <algorithm>
+
+#include "octoon/video/readback_queue.h"
+#include "octoon/video/texture_atlas.h"
+#include "octoon/runtime/except.h"
+
+#include "LiongPlus/Testing/UnitTest.hpp"
+
+using namespace LiongPlus::Testing;
+using namespace octoon::video;
+using namespace octoon::graphics;
+
+// Stands in for a GL texture, read buffers are plain memory that holds the current frame number.
+// Updates are written into levels of 4 byte texels.
+class StubTexture : public GraphicsTexture
+{
+public:
+  std::uint8_t frame = 0;
+
+  GraphicsTextureDesc desc;
+  std::vector<std::vector<std::uint8_t>> levels;
+  std::vector<std::uint32_t> updates;
+
+  std::vector<std::vector<std::uint8_t>> buffers;
+  std::vector<std::uint32_t> pitches;
+  std::vector<bool> mapped;
+
+  int copies = 0;
+  int maps = 0;
+  int unmaps = 0;
+  bool overwrote_mapped = false;
+
+  bool map(std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t, void**) noexcept override { return false; }
+  void unmap() noexcept override {}
+
+  bool update(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t mip, const void* data, std::uint32_t pitch) noexcept override {
+    std::uint32_t width = std::max(desc.getWidth() >> mip, 1u);
+    if (levels.size() <= mip)
+      levels.resize(mip + 1);
+    levels[mip].resize(width * std::max(desc.getHeight() >> mip, 1u) * 4);
+    for (std::uint32_t row = 0; row < h; ++row)
+      std::memcpy(levels[mip].data() + ((y + row) * width + x) * 4, (const std::uint8_t*)data + row * pitch, w * 4);
+    updates.push_back(mip);
+    return true;
+  }
+
+  bool readBack(std::uint32_t slot, std::uint32_t, std::uint32_t, std::uint32_t w, std::uint32_t h, std::uint32_t) noexcept override {
+    if (buffers.size() <= slot) {
+      buffers.resize(slot + 1);
+      pitches.resize(slot + 1);
+      mapped.resize(slot + 1, false);
+    }
+    overwrote_mapped |= mapped[slot];
+    pitches[slot] = w * 4;
+    buffers[slot].resize(w * 4 * h);
+    for (std::uint32_t y = 0; y < h; ++y)
+      std::memset(buffers[slot].data() + y * w * 4, frame + y, w * 4);
+    ++copies;
+    return true;
+  }
+  bool mapReadBack(std::uint32_t slot, void** data, std::uint32_t* pitch) noexcept override {
+    mapped[slot] = true;
+    *data = buffers[slot].data();
+    *pitch = pitches[slot];
+    ++maps;
+    return true;
+  }
+  void unmapReadBack(std::uint32_t slot) noexcept override {
+    mapped[slot] = false;
+    ++unmaps;
+  }
+
+  const GraphicsTextureDesc& getGraphicsTextureDesc() const noexcept override { return desc; }
+  GraphicsDevicePtr getDevice() noexcept override { return nullptr; }
+};
+
+class OctoonVideoTestObject : public TestObject
+{
+  static void test_readback_queue() {
+    auto texture = std::make_shared<StubTexture>();
+    ReadbackQueue queue(3);
+
+    std::promise<void> gate;
+    auto released = gate.get_future().share();
+
+    std::vector<int> frames;
+    bool rows_match = true;
+    auto consumer = [&](int frame) {
+      return [&, frame](const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t pitch) {
+        if (frame == 0)
+          released.wait();
+        rows_match &= width == 4 && height == 2 && pitch == 16;
+        rows_match &= pixels[0] == frame && pixels[pitch] == frame + 1;
+        frames.push_back(frame);
+      };
+    };
+
+    Logger::Info("Copies are mapped on the next push...");
+    texture->frame = 0;
+    queue.push(texture, 0, 0, 4, 2, consumer(0));
+    ASSERT(texture->copies == 1 && texture->maps == 0);
+    ASSERT(queue.pending() == 1);
+
+    Logger::Info("Buffers stay in flight while the worker is busy...");
+    for (int i = 1; i < 3; ++i) {
+      texture->frame = (std::uint8_t)(i * 10);
+      queue.push(texture, 0, 0, 4, 2, consumer(i * 10));
+    }
+    ASSERT(texture->copies == 3 && texture->maps == 2);
+    ASSERT(queue.pending() == 3);
+
+    gate.set_value();
+    for (int i = 3; i < 10; ++i) {
+      texture->frame = (std::uint8_t)(i * 10);
+      queue.push(texture, 0, 0, 4, 2, consumer(i * 10));
+    }
+    queue.flush();
+
+    ASSERT(queue.pending() == 0);
+    ASSERT(frames.size() == 10);
+    for (int i = 0; i < 10; ++i)
+      ASSERT(frames[i] == i * 10);
+    ASSERT(rows_match);
+    ASSERT(!texture->overwrote_mapped);
+    ASSERT(texture->maps == 10 && texture->unmaps == 10);
+    ASSERT(texture->buffers.size() == queue.getBufferCount());
+
+    Logger::Info("Consumer errors surface on flush...");
+    queue.push(texture, 0, 0, 4, 2, [](const std::uint8_t*, std::uint32_t, std::uint32_t, std::uint32_t) {
+      throw octoon::runtime::runtime_error::create("encode failed");
+    });
+    bool thrown = false;
+    try {
+      queue.flush();
+    } catch (const octoon::runtime::exception&) {
+      thrown = true;
+    }
+    ASSERT(thrown);
+    queue.flush();
+    ASSERT(texture->unmaps == 11);
+  }
+
+  static void test_texture_atlas() {
+    auto texture = std::make_shared<StubTexture>();
+    texture->desc.setSize(64, 64);
+    texture->desc.setMipNums(3);
+    texture->desc.setTexFormat(GraphicsFormat::R8G8B8A8UNorm);
+
+    TextureAtlas atlas(texture, 1, 2);
+
+    Logger::Info("Uploads write the dirty texels of every level...");
+    std::vector<std::uint8_t> pixels(10 * 7 * 4);
+    for (std::size_t i = 0; i < pixels.size(); ++i)
+      pixels[i] = (std::uint8_t)(i * 37);
+    auto first = atlas.getAtlas().insert(10, 7, pixels.data(), 10 * 4);
+    auto second = atlas.getAtlas().insert(7, 10, pixels.data(), 7 * 4);
+    ASSERT(first && second);
+
+    std::size_t dirty = atlas.getAtlas().getDirtyRects().size();
+    std::size_t bytes = atlas.upload();
+    ASSERT(bytes > 0 && bytes < 64 * 64 * 4);
+    ASSERT(dirty > 0 && texture->updates.size() == dirty * 3);
+    ASSERT(atlas.getAtlas().getDirtyRects().empty());
+
+    auto& image = atlas.getAtlas().getImage();
+    ASSERT(std::memcmp(texture->levels[0].data(), image.data(), image.size()) == 0);
+
+    bool averaged = true;
+    for (std::uint32_t y = 0; y < 16; ++y) {
+      for (std::uint32_t x = 0; x < 16; ++x) {
+        for (std::uint32_t c = 0; c < 4; ++c) {
+          std::uint32_t sum = 0;
+          for (std::uint32_t sy = 0; sy < 4; ++sy)
+            for (std::uint32_t sx = 0; sx < 4; ++sx)
+              sum += (std::uint8_t)image.data()[((y * 4 + sy) * 64 + x * 4 + sx) * 4 + c];
+          averaged &= texture->levels[2][(y * 16 + x) * 4 + c] == (sum + 8) / 16;
+        }
+      }
+    }
+    ASSERT(averaged);
+
+    Logger::Info("Nothing dirty, nothing written...");
+    texture->updates.clear();
+    ASSERT(atlas.upload() == 0 && texture->updates.empty());
+
+    Logger::Info("Removal clears the texels it frees...");
+    ASSERT(atlas.getAtlas().remove(first));
+    ASSERT(atlas.upload() > 0 && texture->updates.size() == 3);
+    ASSERT(std::memcmp(texture->levels[0].data(), image.data(), image.size()) == 0);
+
+    bool thrown = false;
+    try {
+      auto depth = std::make_shared<StubTexture>();
+      depth->desc.setSize(16, 16);
+      depth->desc.setTexFormat(GraphicsFormat::D32_SFLOAT);
+      TextureAtlas invalid(depth);
+    } catch (const octoon::runtime::exception&) {
+      thrown = true;
+    }
+    ASSERT(thrown);
+  }
+
+  void Test() override {
+    Unit("test_readback_queue", []{ test_readback_queue(); });
+    Unit("test_texture_atlas", []{ test_texture_atlas(); });
+  }
+};
+
+void test_octoon_video() {
+  UnitTest::Test(OctoonVideoTestObject());
+}
@@ -0,0 +1,270 @@
+// File: octoon.cpp
+#include <vector>
+#include <string>
+#include <cstring>
+
+#include "octoon/game_scene.h"
+#include "octoon/game_scene_file.h"
+#include "octoon/game_component.h"
+#include "octoon/transform_component.h"
+#include "octoon/io/mstream.h"
+#include "octoon/model/mesh.h"
+#include "octoon/runtime/rtti_factory.h"
+
+#include "LiongPlus/Testing/UnitTest.hpp"
+
+using namespace LiongPlus::Testing;
+using namespace octoon;
+using namespace octoon::math;
+
+// Holds a mesh and a material stand-in, both shared between components through the scene file.
+class SharedDataComponent final : public GameComponent
+{
+  OctoonDeclareSubClass(SharedDataComponent, GameComponent)
+public:
+  model::MeshPtr mesh;
+  std::shared_ptr<std::string> material;
+
+  GameComponentPtr clone() const noexcept override {
+    auto instance = std::make_shared<SharedDataComponent>();
+    instance->mesh = mesh;
+    instance->material = material;
+    return instance;
+  }
+};
+
+OctoonImplementSubClass(SharedDataComponent, GameComponent, "SharedDataComponent")
+
+class OctoonTestObject : public TestObject
+{
+  static void register_shared_data() {
+    // The RTTI of this file may be constructed before the factory is, which then drops it.
+    static bool added = runtime::RttiFactory::instance()->add(&SharedDataComponent::RTTI);
+    (void)added;
+    runtime::RttiFactory::instance()->open();
+
+    GameSceneFile::registerComponent(SharedDataComponent::RTTI, 3,
+      [](const GameComponent& component, GameSceneWriter& writer) {
+        auto& data = static_cast<const SharedDataComponent&>(component);
+        writer.writeMesh(data.mesh);
+        writer.write((std::uint8_t)(data.material != nullptr));
+        if (data.material)
+          writer.writeShared(data.material.get(), [&](GameSceneWriter& writer) { writer.writeString(*data.material); });
+      },
+      [](GameComponent& component, GameSceneReader& reader) {
+        if (reader.version() != 3)
+          throw std::runtime_error("unexpected component version");
+
+        auto& data = static_cast<SharedDataComponent&>(component);
+        data.mesh = reader.readMesh();
+        if (reader.read<std::uint8_t>())
+          data.material = reader.readShared<std::string>([](GameSceneReader& reader) { return std::make_shared<std::string>(reader.readString()); });
+      });
+  }
+
+  static std::vector<char> save(const GameScene& scene) {
+    io::mstream stream(std::size_t(0));
+    GameSceneFile::save(scene, stream);
+
+    std::vector<char> bytes((std::size_t)stream.size());
+    stream.seekg(0);
+    stream.read(bytes.data(), bytes.size());
+    return bytes;
+  }
+
+  // Every tenth object is a root, the others hang below one of the two objects before them.
+  static GameScenePtr make_scene(std::size_t count) {
+    auto scene = std::make_shared<GameScene>();
+    scene->setName("scene");
+
+    std::vector<GameObjectPtr> objects;
+    for (std::size_t i = 0; i < count; ++i) {
+      auto object = std::make_shared<GameObject>();
+      object->setName("object" + std::to_string(i));
+      object->setLayer((std::uint8_t)(i % 7));
+
+      auto transform = object->getComponent<TransformComponent>();
+      transform->setLocalTranslate(float3((float)i, i * 2.0f, i * 3.0f));
+      transform->setLocalScale(float3(1.0f, 2.0f, 0.5f));
+
+      if (i % 10 == 0)
+        scene->root()->addChild(object);
+      else
+        objects[i - 1 - (i % 3 == 0)]->addChild(object);
+
+      if (i % 5 == 0)
+        object->setActive(false);
+
+      objects.push_back(object);
+    }
+
+    return scene;
+  }
+
+  static bool same_hierarchy(const GameObject& a, const GameObject& b) {
+    if (a.getName() != b.getName() || a.getLayer() != b.getLayer() || a.getActive() != b.getActive())
+      return false;
+    if (a.getChildCount() != b.getChildCount() || a.getComponents().size() != b.getComponents().size())
+      return false;
+
+    auto ta = a.getComponent<TransformComponent>();
+    auto tb = b.getComponent<TransformComponent>();
+    if (ta->getLocalTranslate() != tb->getLocalTranslate() || ta->getLocalScale() != tb->getLocalScale())
+      return false;
+
+    for (std::size_t i = 0; i < a.getComponents().size(); ++i) {
+      auto& ca = a.getComponents()[i];
+      auto& cb = b.getComponents()[i];
+      if (ca->rtti() != cb->rtti() || ca->getName() != cb->getName() || ca->getActive() != cb->getActive())
+        return false;
+    }
+
+    for (std::size_t i = 0; i < a.getChildCount(); ++i) {
+      if (!same_hierarchy(*a.getChildren()[i], *b.getChildren()[i]))
+        return false;
+    }
+
+    return true;
+  }
+
+  static void test_scene_round_trip() {
+    auto scene = make_scene(500);
+    auto bytes = save(*scene);
+
+    io::mstream stream(std::vector<std::uint8_t>(bytes.begin(), bytes.end()));
+    auto loaded = GameSceneFile::load(stream);
+    ASSERT(loaded && loaded->getName() == "scene");
+    ASSERT(loaded->root()->getChildCount() == 50);
+    ASSERT(same_hierarchy(*scene->root(), *loaded->root()));
+
+    // World transforms follow the rebuilt parents.
+    auto leaf = loaded->root()->getChildren()[1]->getChildren()[0];
+    ASSERT(leaf->getName() == "object11");
+    ASSERT(leaf->getComponent<TransformComponent>()->getTranslate() == scene->root()->getChildren()[1]->getChildren()[0]->getComponent<TransformComponent>()->getTranslate());
+  }
+
+  static void test_scene_shared_data() {
+    register_shared_data();
+
+    auto cube = std::make_shared<model::Mesh>();
+    cube->makeCube(1.0f, 2.0f, 3.0f);
+    cube->setName("cube");
+
+    auto metal = std::make_shared<std::string>("metal");
+    auto wood = std::make_shared<std::string>("wood");
+
+    auto scene = std::make_shared<GameScene>();
+    scene->setName("shared");
+
+    const char* materials[] = { "metal", "metal", "wood", nullptr };
+    for (std::size_t i = 0; i < 4; ++i) {
+      auto object = std::make_shared<GameObject>();
+      object->setName("object" + std::to_string(i));
+
+      auto data = object->addComponent<SharedDataComponent>();
+      data->setName("data" + std::to_string(i));
+      data->mesh = i < 3 ? cube : nullptr;
+      data->material = materials[i] == nullptr ? nullptr : i < 2 ? metal : wood;
+
+      // An inactive component on an active object keeps its own flag.
+      if (i == 1)
+        data->setActive(false);
+
+      scene->root()->addChild(object);
+    }
+
+    auto bytes = save(*scene);
+    GameSceneFile::unregisterComponent(SharedDataComponent::RTTI);
+
+    // Without a reader the components come back default constructed.
+    auto plain = GameSceneFile::load(bytes.data(), bytes.size());
+    ASSERT(plain->root()->getChildren()[0]->getComponent<SharedDataComponent>()->mesh == nullptr);
+
+    register_shared_data();
+    auto loaded = GameSceneFile::load(bytes.data(), bytes.size());
+    GameSceneFile::unregisterComponent(SharedDataComponent::RTTI);
+
+    ASSERT(same_hierarchy(*scene->root(), *loaded->root()));
+
+    std::vector<std::shared_ptr<SharedDataComponent>> data;
+    for (auto& object : loaded->root()->getChildren())
+      data.push_back(object->getComponent<SharedDataComponent>());
+    ASSERT(data.size() == 4);
+    ASSERT(data[0]->getActive() && !data[1]->getActive() && data[2]->getActive());
+
+    // Shared objects are decoded once and handed to every component referencing them.
+    ASSERT(data[0]->mesh && data[0]->mesh == data[1]->mesh && data[1]->mesh == data[2]->mesh);
+    ASSERT(data[3]->mesh == nullptr);
+    ASSERT(data[0]->mesh->getName() == "cube");
+    ASSERT(data[0]->mesh->getVertexArray() == cube->getVertexArray());
+    ASSERT(data[0]->mesh->getIndicesArray() == cube->getIndicesArray());
+
+    ASSERT(data[0]->material && data[0]->material == data[1]->material && *data[0]->material == "metal");
+    ASSERT(data[2]->material && data[2]->material != data[0]->material && *data[2]->material == "wood");
+    ASSERT(data[3]->material == nullptr);
+  }
+
+  static bool load_fails(const char* data, std::size_t size) {
+    try {
+      GameSceneFile::load(data, size);
+    } catch (const std::exception&) {
+      return true;
+    }
+    return false;
+  }
+
+  static void test_scene_truncated() {
+    auto bytes = save(*make_scene(50));
+
+    // The header records the size of every section, any missing byte is caught.
+    for (std::size_t size = 0; size < bytes.size(); ++size)
+      ASSERT(load_fails(bytes.data(), size));
+
+    io::mstream stream(std::vector<std::uint8_t>(bytes.begin(), bytes.begin() + bytes.size() / 2));
+    auto thrown = false;
+    try { GameSceneFile::load(stream); } catch (const std::exception&) { thrown = true; }
+    ASSERT(thrown);
+  }
+
+  static void test_scene_corrupt() {
+    auto bytes = save(*make_scene(50));
+
+    auto corrupt = [&](std::size_t offset, std::uint32_t value) {
+      auto copy = bytes;
+      std::memcpy(copy.data() + offset, &value, sizeof(value));
+      return load_fails(copy.data(), copy.size());
+    };
+
+    // Magic, version and the counts of the string, object and component sections.
+    ASSERT(corrupt(0, 0x12345678));
+    ASSERT(corrupt(4, 0));
+    ASSERT(corrupt(4, GameSceneFile::Version + 1));
+    ASSERT(corrupt(12, 0x7FFFFFFF));
+    ASSERT(corrupt(16, 0x7FFFFFFF));
+    ASSERT(corrupt(20, 0x7FFFFFFF));
+
+    // Random damage either loads or throws, it never reads out of bounds or crashes.
+    std::uint32_t state = 1;
+    auto next = [&] { state = state * 1664525u + 1013904223u; return state >> 8; };
+    for (int i = 0; i < 500; ++i) {
+      auto copy = bytes;
+      for (int j = 0; j < 4; ++j)
+        copy[next() % copy.size()] = (char)next();
+      try {
+        GameSceneFile::load(copy.data(), copy.size());
+      } catch (const std::exception&) {
+      }
+    }
+  }
+
+  void Test() override {
+    Unit("test_scene_round_trip", []{ test_scene_round_trip(); });
+    Unit("test_scene_shared_data", []{ test_scene_shared_data(); });
+    Unit("test_scene_truncated", []{ test_scene_truncated(); });
+    Unit("test_scene_corrupt", []{ test_scene_corrupt(); });
+  }
+};
+
+void test_octoon() {
+  UnitTest::Test(OctoonTestObject());
+}